@@ -14,6 +14,8 @@
 #include "tjs.h"
 #include "tjsDebug.h"
 #include "tjsArray.h"
+#include "tjsDictionary.h"
+#include "tjsCycleCollector.h"
 #include "ScriptMgnIntf.h"
 #include "StorageIntf.h"
 #include "DebugIntf.h"
@@ -33,9 +35,12 @@
 #include "VideoOvlIntf.h"
 //#include "PadIntf.h"
 #include "TextStream.h"
+#include "UtilStreams.h"
+#include "CharacterSet.h"
 #include "Random.h"
 #include "tjsRandomGenerator.h"
 #include "SysInitIntf.h"
+#include "ThreadIntf.h"
 #include "PhaseVocoderFilter.h"
 #include "BasicDrawDevice.h"
 #include "BinaryStream.h"
@@ -378,6 +383,20 @@ static ttstr TVPScriptTextEncoding(TJS_W("UTF-8"));
 //---------------------------------------------------------------------------
 // Garbage Collection stuff
 //---------------------------------------------------------------------------
+static void TVPCollectCycles()
+{
+	// collect reference cycles incrementally; a part of tracked objects
+	// is examined at a time.
+	tTJSCycleCollectorResult result;
+	TJSCollectCycles(4096, 65536, result);
+	if(result.Collected)
+	{
+		TVPAddLog(ttstr(TJS_W("(info) Cycle collector: ")) +
+			ttstr((tjs_int)result.Collected) + TJS_W(" object(s), about ") +
+			ttstr(tTJSVariant((tjs_int64)result.CollectedBytes)) + TJS_W(" byte(s) reclaimed."));
+	}
+}
+//---------------------------------------------------------------------------
 class tTVPTJSGCCallback : public tTVPCompactEventCallbackIntf
 {
 	void TJS_INTF_METHOD OnCompact(tjs_int level)
@@ -389,6 +408,7 @@ class tTVPTJSGCCallback : public tTVPCompactEventCallbackIntf
 			if(level >= TVP_COMPACT_LEVEL_IDLE)
 			{
 				TVPScriptEngine->DoGarbageCollection();
+				if(TJSCycleCollectorEnabled()) TVPCollectCycles();
 			}
 		}
 	}
@@ -447,6 +467,21 @@ void TVPInitScriptEngine()
 //			}
 		}
 	}
+	// Set VM counters; enabled before the engine is created so that the
+	// native methods of the built-in classes are named
+	if(TVPGetCommandLine(TJS_W("-vmcounters"), &val) )
+	{
+		ttstr str(val);
+		if(str == TJS_W("yes"))
+			TJSSetVMCountersEnabled(true);
+	}
+	// Set cycle collector
+	if(TVPGetCommandLine(TJS_W("-cyclecollect"), &val) )
+	{
+		ttstr str(val);
+		if(str == TJS_W("yes"))
+			TJSStartCycleCollector();
+	}
 	// Set Read text encoding
 	if(TVPGetCommandLine(TJS_W("-readencoding"), &val) )
 	{
@@ -489,6 +524,11 @@ void TVPInitScriptEngine()
 	// set binary stream functions
 	TJSCreateBinaryStreamForRead = TVPCreateBinaryStreamForRead;
 	TJSCreateBinaryStreamForWrite = TVPCreateBinaryStreamForWrite;
+	TJSRenameStorage = TVPRenameStorage;
+
+	// sort large arrays on the thread pool
+	TJSGetParallelTaskNum = TVPGetThreadNum;
+	TJSExecParallelTasks = TVPTryExecThreadTasks;
 
 	// register some TVP classes/objects/functions/propeties
 	iTJSDispatch2 *dsp;
@@ -838,6 +878,35 @@ void TVPCreateMessageMapFile(const ttstr &filename)
 
 
 
+//---------------------------------------------------------------------------
+// TVPSaveScriptProfile
+//---------------------------------------------------------------------------
+void TVPSaveScriptProfile(const ttstr &filename, const ttstr &format)
+{
+	// save the profile taken by the script profiler, in UTF-8.
+	// "collapsed" : collapsed stacks, for flamegraph.pl and compatible tools
+	// "chrome"    : Trace Event Format JSON, for chrome://tracing or Perfetto
+	ttstr text;
+	if(format == TJS_W("collapsed"))
+		text = TJSGetProfileCollapsedStacks();
+	else if(format == TJS_W("chrome"))
+		text = TJSGetProfileChromeTrace();
+	else
+		TVPThrowExceptionMessage(TJS_W("Unknown profile format/%1"), format);
+
+	tjs_int size = TVPWideCharToUtf8String(text.c_str(), NULL);
+	if(size < 0) size = 0;
+	std::vector<char> out(size + 1);
+	if(size) TVPWideCharToUtf8String(text.c_str(), &out[0]);
+
+	tTVPStreamHolder stream(filename, TJS_BS_WRITE);
+	stream->WriteBuffer(&out[0], size);
+}
+//---------------------------------------------------------------------------
+
+
+
+
 
 //---------------------------------------------------------------------------
 // TVPDumpScriptEngine
@@ -1366,6 +1435,138 @@ TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/getTraceString)
 }
 TJS_END_NATIVE_STATIC_METHOD_DECL(/*func. name*/getTraceString)
 //----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/startProfiler)
+{
+	// start the sampling profiler; the parameter is the sampling interval
+	// in ms. samples are added to the current profile.
+	tjs_int interval = 1;
+
+	if(numparams >= 1 && param[0]->Type() != tvtVoid)
+		interval = *param[0];
+	if(interval < 1) interval = 1;
+
+	TJSStartProfiler((tjs_uint)interval);
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_STATIC_METHOD_DECL(/*func. name*/startProfiler)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/stopProfiler)
+{
+	TJSStopProfiler();
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_STATIC_METHOD_DECL(/*func. name*/stopProfiler)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/clearProfile)
+{
+	TJSClearProfile();
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_STATIC_METHOD_DECL(/*func. name*/clearProfile)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/saveProfile)
+{
+	// save the profile; format is "collapsed" (default) or "chrome"
+	if(numparams < 1) return TJS_E_BADPARAMCOUNT;
+
+	ttstr name = *param[0];
+	ttstr format(TJS_W("collapsed"));
+	if(numparams >= 2 && param[1]->Type() != tvtVoid)
+		format = *param[1];
+
+	TVPSaveScriptProfile(name, format);
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_STATIC_METHOD_DECL(/*func. name*/saveProfile)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/resetVMCounters)
+{
+	TJSResetVMCounters();
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_STATIC_METHOD_DECL(/*func. name*/resetVMCounters)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/dumpVMCounters)
+{
+	// dump VM counters to the console; the parameter is the number of
+	// entries to show for each kind (0 = all)
+	tjs_int limit = 20;
+
+	if(numparams >= 1 && param[0]->Type() != tvtVoid)
+		limit = *param[0];
+
+	TJSDumpVMCounters(TVPGetTJS2ConsoleOutputGateway(), limit);
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_STATIC_METHOD_DECL(/*func. name*/dumpVMCounters)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/getVMCounters)
+{
+	// get VM counters as a dictionary
+	if(result)
+	{
+		iTJSDispatch2 *dsp = TJSGetVMCounters();
+		*result = tTJSVariant(dsp, dsp);
+		dsp->Release();
+	}
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_STATIC_METHOD_DECL(/*func. name*/getVMCounters)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/collectCycles)
+{
+	// run the cycle collector ( needs -cyclecollect=yes ); returns a
+	// dictionary of the result
+	tjs_int candidates = 4096;
+	tjs_int maxnodes = 65536;
+
+	if(numparams >= 1 && param[0]->Type() != tvtVoid)
+		candidates = *param[0];
+	if(numparams >= 2 && param[1]->Type() != tvtVoid)
+		maxnodes = *param[1];
+	if(candidates < 1) candidates = 1;
+	if(maxnodes < 1) maxnodes = 1;
+
+	tTJSCycleCollectorResult res;
+	TJSCollectCycles((tjs_uint)candidates, (tjs_uint)maxnodes, res);
+
+	if(result)
+	{
+		iTJSDispatch2 *dic = TJSCreateDictionaryObject();
+		try
+		{
+			tTJSVariant val;
+			val = (tjs_int64)res.Tracked;
+			dic->PropSet(TJS_MEMBERENSURE, TJS_W("tracked"), NULL, &val, dic);
+			val = (tjs_int64)res.Scanned;
+			dic->PropSet(TJS_MEMBERENSURE, TJS_W("scanned"), NULL, &val, dic);
+			val = (tjs_int64)res.Collected;
+			dic->PropSet(TJS_MEMBERENSURE, TJS_W("collected"), NULL, &val, dic);
+			val = (tjs_int64)res.CollectedBytes;
+			dic->PropSet(TJS_MEMBERENSURE, TJS_W("bytes"), NULL, &val, dic);
+			val = (tjs_int)res.Aborted;
+			dic->PropSet(TJS_MEMBERENSURE, TJS_W("aborted"), NULL, &val, dic);
+			*result = tTJSVariant(dic, dic);
+		}
+		catch(...)
+		{
+			dic->Release();
+			throw;
+		}
+		dic->Release();
+	}
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_STATIC_METHOD_DECL(/*func. name*/collectCycles)
+//----------------------------------------------------------------------
 #ifdef TJS_DEBUG_DUMP_STRING
 TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/dumpStringHeap)
 {
@@ -1449,6 +1650,23 @@ TJS_BEGIN_NATIVE_PROP_DECL(textEncoding)
 	TJS_END_NATIVE_PROP_SETTER
 }
 TJS_END_NATIVE_STATIC_PROP_DECL(textEncoding)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_PROP_DECL(vmCounters)
+{
+	TJS_BEGIN_NATIVE_PROP_GETTER
+	{
+		*result = TJSGetVMCountersEnabled();
+		return TJS_S_OK;
+	}
+	TJS_END_NATIVE_PROP_GETTER
+	TJS_BEGIN_NATIVE_PROP_SETTER
+	{
+		TJSSetVMCountersEnabled(param->operator bool());
+		return TJS_S_OK;
+	}
+	TJS_END_NATIVE_PROP_SETTER
+}
+TJS_END_NATIVE_STATIC_PROP_DECL(vmCounters)
 //----------------------------------------------------------------------
 
 	TJS_END_NATIVE_MEMBERS
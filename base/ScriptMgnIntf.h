@@ -45,6 +45,7 @@ TJS_EXP_FUNC_DEF(void, TVPExecuteBytecode, (const tjs_uint8* content, size_t len
 
 extern void TVPExecuteStartupScript();
 TJS_EXP_FUNC_DEF(void, TVPCreateMessageMapFile, (const ttstr &filename));
+extern void TVPSaveScriptProfile(const ttstr &filename, const ttstr &format);
 
 //---------------------------------------------------------------------------
 
@@ -594,6 +594,24 @@ ttstr TVPGetLocallyAccessibleName(const ttstr &name)
 
 
 
+//---------------------------------------------------------------------------
+// TVPRenameStorage
+//---------------------------------------------------------------------------
+bool TVPRenameStorage(const ttstr &from, const ttstr &to)
+{
+	ttstr localfrom = TVPGetLocallyAccessibleName(TVPNormalizeStorageName(from));
+	ttstr localto = TVPGetLocallyAccessibleName(TVPNormalizeStorageName(to));
+	if(localfrom.IsEmpty() || localto.IsEmpty()) return false;
+
+	bool ret = TVPRenameFile(localfrom, localto);
+	TVPClearStorageCaches();
+	return ret;
+}
+//---------------------------------------------------------------------------
+
+
+
+
 
 //---------------------------------------------------------------------------
 // tTVPArchive
@@ -195,6 +195,10 @@ extern bool TVPRemoveFile(const ttstr &name);
 extern bool TVPRemoveFolder(const ttstr &name);
 	// remove local directory ( "name" is a local *native* name )
 	// this must not throw an exception ( return false if error )
+extern bool TVPRenameFile(const ttstr &from, const ttstr &to);
+	// rename local file, replacing "to" if it exists
+	// ( "from" and "to" are local *native* names )
+	// this must not throw an exception ( return false if error )
 bool TVPCreateFolders(const ttstr &folder);
 	// create folder along with the argument recursively (like mkdir -p).
 	// 'folder' must be a local native name.
@@ -271,6 +275,10 @@ TJS_EXP_FUNC_DEF(bool, TVPIsExistentStorage, (const ttstr &name));
 TJS_EXP_FUNC_DEF(void, TVPClearStorageCaches, ());
 	// clear all internal storage related caches.
 
+extern bool TVPRenameStorage(const ttstr &from, const ttstr &to);
+	// replace storage "to" with storage "from". both must be accessible from
+	// local OS filesystem. returns false if not or if failed.
+
 extern tjs_uint TVPSegmentCacheLimit; // XP3 segment cache limit, in bytes.
 
 //---------------------------------------------------------------------------
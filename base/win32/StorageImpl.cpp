@@ -327,6 +327,18 @@ bool TVPRemoveFolder(const ttstr &name)
 
 
 
+//---------------------------------------------------------------------------
+// TVPRenameFile
+//---------------------------------------------------------------------------
+bool TVPRenameFile(const ttstr &from, const ttstr &to)
+{
+	return 0!=::MoveFileEx(from.c_str(), to.c_str(),
+		MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH);
+}
+//---------------------------------------------------------------------------
+
+
+
 
 //---------------------------------------------------------------------------
 // TVPGetAppPath
@@ -1334,6 +1334,26 @@ void TVPAfterSystemInit()
 
 	}
 
+	// check TVPJPEGParallelDecode option
+	if(TVPGetCommandLine(TJS_W("-jpegthread"), &opt))
+	{
+		ttstr str(opt);
+		if(str == TJS_W("serial"))
+			TVPJPEGParallelDecode = false;
+		else if(str == TJS_W("parallel"))
+			TVPJPEGParallelDecode = true;
+	}
+
+	// check TVPTLG6ParallelDecode option
+	if(TVPGetCommandLine(TJS_W("-tlg6dec"), &opt))
+	{
+		ttstr str(opt);
+		if(str == TJS_W("serial"))
+			TVPTLG6ParallelDecode = false;
+		else if(str == TJS_W("parallel"))
+			TVPTLG6ParallelDecode = true;
+	}
+
 	// dump option
 	TVPDumpOptions();
 
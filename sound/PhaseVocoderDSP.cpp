@@ -318,6 +318,9 @@ tRisaPhaseVocoderDSP::tStatus tRisaPhaseVocoderDSP::Process()
 			(TVPCPUType & TVP_CPU_HAS_MMX) &&
 			(TVPCPUType & TVP_CPU_HAS_SSE) &&
 			(TVPCPUType & TVP_CPU_HAS_CMOV);
+	bool use_avx2 = use_sse &&
+			(TVPCPUType & TVP_CPU_HAS_AVX2) &&
+			(FrameSize >= 16);
 
 
 	// パラメータの再計算の必要がある場合は再計算をする
@@ -404,7 +407,8 @@ tRisaPhaseVocoderDSP::tStatus tRisaPhaseVocoderDSP::Process()
 
 		// 演算の根幹部分を実行する
 #if defined(_M_IX86)||defined(_M_X64)
-		if(use_sse) ProcessCore_sse(ch);
+		if(use_avx2) ProcessCore_avx2(ch);
+		else if(use_sse) ProcessCore_sse(ch);
 		else ProcessCore(ch);
 #else
 		ProcessCore(ch);
@@ -160,6 +160,7 @@ public:
 	void ProcessCore(int ch);
 #if defined(_M_IX86)||defined(_M_X64)
 	void ProcessCore_sse(int ch);
+	void ProcessCore_avx2(int ch); //!< PhaseVocoderDSP_AVX2.cpp 内に実装
 #endif
 };
 //---------------------------------------------------------------------------
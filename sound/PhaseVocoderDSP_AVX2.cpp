@@ -0,0 +1,327 @@
+//---------------------------------------------------------------------------
+/*
+	Risa [りさ]      alias 吉里吉里3 [kirikiri-3]
+	 stands for "Risa Is a Stagecraft Architecture"
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+//! @file
+//! @brief Phase Vocoder の演算の根幹部分 (AVX2版)
+//---------------------------------------------------------------------------
+
+/*
+	このソースコードでは詳しいアルゴリズムの説明は行わない。
+	基本的な流れは PhaseVocoderDSP.cpp 内の ProcessCore / ProcessCore_sse
+	と変わりないので、そちらを参照のこと。
+	ここでは 8 複素数 (16実数) ごとに処理を行う。
+*/
+
+#include "tjsCommHead.h"
+
+#include <immintrin.h> // AVX/AVX2
+#include "MathAlgorithms.h"
+#include "PhaseVocoderDSP.h"
+#include "RealFFT.h"
+
+#if defined(_M_IX86)||defined(_M_X64)
+//---------------------------------------------------------------------------
+#define PM256B(addr) _mm256_broadcast_ss((const float *)(addr))
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * atan2 の高速版 (8x float, AVX2版)
+ * @note	VFast_arctan2_F4_SSE と同じ精度
+ */
+static inline __m256 VFast_arctan2_F8_AVX2(__m256 y, __m256 x)
+{
+	__m256 sign   = PM256B(PCS_RRRR);
+	__m256 abs_y  = _mm256_add_ps(_mm256_andnot_ps(sign, y), PM256B(TVP_VFASTATAN2_E));
+	__m256 x_sign = _mm256_and_ps(x, sign); // 0x80000000 if x < 0
+	__m256 x_mask = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LE_OS); // 0xffffffff if x <= 0
+	__m256 abs_y2 = _mm256_xor_ps(abs_y , x_sign);
+	__m256 abs_y1 = _mm256_xor_ps(abs_y2, sign);
+	__m256 r      = _mm256_div_ps(_mm256_add_ps(x, abs_y1), _mm256_add_ps(x, abs_y2));
+	r             = _mm256_xor_ps(r, x_sign);
+	__m256 coeff_1 = PM256B(TVP_VFASTATAN2_C1);
+	__m256 coeff_1_or_2 = _mm256_xor_ps(
+							_mm256_and_ps(x_mask, PM256B(TVP_VFASTATAN2_C1_XOR_C2)),
+							coeff_1); // x<=0?coeff_2:coeff_1
+	__m256 angle  = _mm256_sub_ps(coeff_1_or_2, _mm256_mul_ps(coeff_1, r));
+	return _mm256_xor_ps(angle, _mm256_and_ps(y, sign));
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * Phase Wrapping(radianを-PI～PIにラップする) (8x float, AVX2版)
+ */
+static inline __m256 Wrap_Pi_F8_AVX2(__m256 v)
+{
+	// v を M_PI で割り、小数点以下を切り捨てて整数に変換
+	__m256i q = _mm256_cvttps_epi32(_mm256_mul_ps(v, PM256B(TVP_V_R_PI)));
+	// 正の場合はv_quant&1を足し、負の場合は引く
+	__m256i one = _mm256_set1_epi32(1);
+	q =
+		_mm256_add_epi32(
+			q,
+			_mm256_and_si256(
+				_mm256_sub_epi32(_mm256_setzero_si256(), _mm256_and_si256(q, one)),
+				_mm256_or_si256(_mm256_srai_epi32(q, 31), one)
+			)
+		);
+	// それらを実数に戻し、M_PI をかけて v から引く
+	return _mm256_sub_ps(v, _mm256_mul_ps(_mm256_cvtepi32_ps(q), PM256B(TVP_V_PI)));
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * sincos の高速版 (8x float, AVX2版)
+ * @note	呼び出しに先立って SetRoundingModeToNearest_SSE を呼ぶこと。
+ */
+static inline void VFast_sincos_F8_AVX2(__m256 v, __m256 &sin, __m256 &cos)
+{
+	__m256 two = PM256B(PFV_2);
+
+	/* q1=x/2pi reduced onto (-0.5,0.5), q2=q1**2 */
+	__m256 x1 = _mm256_mul_ps(v, PM256B(TVP_V_R_2PI));
+	__m256 q1 = _mm256_sub_ps(x1, _mm256_cvtepi32_ps(_mm256_cvtps_epi32(x1)));
+	__m256 q2 = _mm256_mul_ps(q1, q1);
+
+	__m256 s1, c1;
+	s1 = _mm256_add_ps(_mm256_mul_ps(q2, PM256B(TVP_VFASTSINCOS_SS4)), PM256B(TVP_VFASTSINCOS_SS3));
+	s1 = _mm256_add_ps(_mm256_mul_ps(s1, q2), PM256B(TVP_VFASTSINCOS_SS2));
+	s1 = _mm256_add_ps(_mm256_mul_ps(s1, q2), PM256B(TVP_VFASTSINCOS_SS1));
+	s1 = _mm256_mul_ps(s1, q1);
+
+	c1 = _mm256_add_ps(_mm256_mul_ps(q2, PM256B(TVP_VFASTSINCOS_CC3)), PM256B(TVP_VFASTSINCOS_CC2));
+	c1 = _mm256_add_ps(_mm256_mul_ps(c1, q2), PM256B(TVP_VFASTSINCOS_CC1));
+	c1 = _mm256_add_ps(_mm256_mul_ps(c1, q2), PM256B(PFV_1));
+
+	/* now, do one out of two angle-doublings to get sin & cos theta/2 */
+	__m256 c2 = _mm256_sub_ps(_mm256_mul_ps(c1, c1), _mm256_mul_ps(s1, s1));
+	__m256 s2 = _mm256_mul_ps(_mm256_mul_ps(s1, c1), two);
+
+	/* correction for magnitude drift; see VFast_sincos_F4_SSE2 */
+	__m256 c2_c2 = _mm256_mul_ps(c2, c2);
+	__m256 s2_s2 = _mm256_mul_ps(s2, s2);
+	__m256 fixmag1 = _mm256_sub_ps(_mm256_sub_ps(two, c2_c2), s2_s2);
+
+	cos = _mm256_mul_ps(_mm256_sub_ps(c2_c2, s2_s2), fixmag1);
+	sin = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(s2, c2), two), fixmag1);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * 8 複素数のインターリーブ解除/インターリーブ
+ * @note	_mm256_shuffle_ps は 128bit レーンごとに働くため、インターリーブ解除した
+ *			結果のフィルタバンドの並びは 0 1 4 5 2 3 6 7 になる。
+ *			インターリーブ (unpacklo/hi) で元の並びに戻るため、
+ *			位相のバッファだけを Permute_F8_AVX2 で同じ並びにして扱う。
+ */
+static inline void Deinterleave_F8_AVX2(const float *src, __m256 &re, __m256 &im)
+{
+	__m256 a = _mm256_loadu_ps(src    );
+	__m256 b = _mm256_loadu_ps(src + 8);
+	re = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+	im = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+}
+static inline void Interleave_F8_AVX2(float *dest, __m256 re, __m256 im)
+{
+	_mm256_storeu_ps(dest    , _mm256_unpacklo_ps(re, im));
+	_mm256_storeu_ps(dest + 8, _mm256_unpackhi_ps(re, im));
+}
+static inline __m256 Permute_F8_AVX2(__m256 v)
+{
+	// 0 1 2 3 4 5 6 7 <-> 0 1 4 5 2 3 6 7
+	return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(v), _MM_SHUFFLE(3,1,2,0)));
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+void tRisaPhaseVocoderDSP::ProcessCore_avx2(int ch)
+{
+	unsigned int framesize_d2 = FrameSize / 2;
+	float * analwork = AnalWork[ch];
+	float * synthwork = SynthWork[ch];
+	float * lastanalphase = LastAnalPhase[ch];
+	float * lastsynthphase = LastSynthPhase[ch];
+
+	// 丸めモードを設定
+	SetRoundingModeToNearest_SSE();
+
+	// FFT を実行する
+	rdft(FrameSize, 1, analwork, FFTWorkIp, FFTWorkW); // Real DFT
+	analwork[1] = 0.0; // analwork[1] = nyquist freq. power (どっちみち使えないので0に)
+
+	__m256 exact_time_scale = _mm256_set1_ps(ExactTimeScale);
+	__m256 over_sampling_radian_v = _mm256_set1_ps(OverSamplingRadian);
+	__m256 i_init = _mm256_set_ps(7.0f, 6.0f, 3.0f, 2.0f, 5.0f, 4.0f, 1.0f, 0.0f);
+		// フィルタバンドの並び (0 1 4 5 2 3 6 7)
+
+	if(FrequencyScale != 1.0)
+	{
+		__m256 over_sampling_radian_recp = _mm256_set1_ps(OverSamplingRadianRecp);
+		__m256 frequency_per_filter_band = _mm256_set1_ps(FrequencyPerFilterBand);
+		__m256 frequency_per_filter_band_recp = _mm256_set1_ps(FrequencyPerFilterBandRecp);
+
+		for(unsigned int i = 0; i < framesize_d2; i += 8)
+		{
+			// インターリーブ解除 +  直交座標系→極座標系
+			__m256 re, im;
+			Deinterleave_F8_AVX2(analwork + i*2, re, im);
+
+			__m256 mag = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(re,re), _mm256_mul_ps(im,im)));
+			__m256 ang = VFast_arctan2_F8_AVX2(im, re);
+
+			// 前回の位相との差をとる
+			__m256 lastp = Permute_F8_AVX2(_mm256_loadu_ps(lastanalphase + i));
+			_mm256_storeu_ps(lastanalphase + i, Permute_F8_AVX2(ang));
+			ang = _mm256_sub_ps(lastp, ang);
+
+			// over sampling の影響を考慮する
+			__m256 i_v = _mm256_add_ps(_mm256_set1_ps((float)i), i_init);
+			ang = _mm256_sub_ps(ang, _mm256_mul_ps(i_v, over_sampling_radian_v));
+
+			// unwrapping をする
+			ang = Wrap_Pi_F8_AVX2(ang);
+
+			// -M_PI～+M_PIを-1.0～+1.0の変位に変換し、
+			// フィルタバンドの中央周波数を加算する
+			ang = _mm256_mul_ps(ang, over_sampling_radian_recp);
+			__m256 freq = _mm256_mul_ps(_mm256_add_ps(ang, i_v), frequency_per_filter_band);
+
+			// analwork に値を格納する
+			Interleave_F8_AVX2(analwork + i*2, mag, freq);
+		}
+
+
+		//------------------------------------------------
+		// 変換
+		//------------------------------------------------
+		// 周波数軸方向のリサンプリングを行う
+		float FrequencyScale_rcp = 1.0f / FrequencyScale;
+		for(unsigned int i = 0; i < framesize_d2; i ++)
+		{
+			// i に対応するインデックスを得る
+			float fi = i * FrequencyScale_rcp;
+
+			// floor(x) と floor(x) + 1 の間でバイリニア補間を行う
+			unsigned int index = static_cast<unsigned int>(fi); // floor
+			float frac = fi - index;
+
+			if(index + 1 < framesize_d2)
+			{
+				synthwork[i*2  ] =
+					analwork[index*2  ] +
+					frac * (analwork[index*2+2]-analwork[index*2  ]);
+				synthwork[i*2+1] =
+					FrequencyScale * (
+					analwork[index*2+1] +
+					frac * (analwork[index*2+3]-analwork[index*2+1]) );
+			}
+			else if(index < framesize_d2)
+			{
+				synthwork[i*2  ] = analwork[index*2  ];
+				synthwork[i*2+1] = analwork[index*2+1] * FrequencyScale;
+			}
+			else
+			{
+				synthwork[i*2  ] = 0.0;
+				synthwork[i*2+1] = 0.0;
+			}
+		}
+
+		//------------------------------------------------
+		// 合成
+		//------------------------------------------------
+		for(unsigned int i = 0; i < framesize_d2; i += 8)
+		{
+			// インターリーブ解除
+			__m256 mag, freq;
+			Deinterleave_F8_AVX2(synthwork + i*2, mag, freq);
+
+			__m256 i_v = _mm256_add_ps(_mm256_set1_ps((float)i), i_init);
+
+			// 周波数をフィルタバンドの中央周波数からの変位に変換し、位相に変換
+			__m256 ang = _mm256_sub_ps(_mm256_mul_ps(freq, frequency_per_filter_band_recp), i_v);
+			ang = _mm256_mul_ps(ang, over_sampling_radian_v);
+
+			// OverSampling による位相の補正
+			ang = _mm256_add_ps(ang, _mm256_mul_ps(i_v, over_sampling_radian_v));
+
+			// TimeScale による位相の補正
+			ang = _mm256_mul_ps(ang, exact_time_scale);
+
+			// 前回の位相と加算する
+			// ここでも虚数部の符号が逆になるので注意
+			ang = _mm256_sub_ps(Permute_F8_AVX2(_mm256_loadu_ps(lastsynthphase + i)), ang);
+			_mm256_storeu_ps(lastsynthphase + i, Permute_F8_AVX2(ang));
+
+			// 極座標系→直交座標系
+			__m256 sin, cos;
+			VFast_sincos_F8_AVX2(ang, sin, cos);
+			Interleave_F8_AVX2(synthwork + i*2, _mm256_mul_ps(mag, cos), _mm256_mul_ps(mag, sin));
+		}
+	}
+	else
+	{
+		// 周波数軸方向にシフトがない場合
+		for(unsigned int i = 0; i < framesize_d2; i += 8)
+		{
+			// インターリーブ解除 +  直交座標系→極座標系
+			__m256 re, im;
+			Deinterleave_F8_AVX2(analwork + i*2, re, im);
+
+			__m256 mag = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(re,re), _mm256_mul_ps(im,im)));
+			__m256 ang = VFast_arctan2_F8_AVX2(im, re);
+
+			// 前回の位相との差をとる
+			__m256 lastp = Permute_F8_AVX2(_mm256_loadu_ps(lastanalphase + i));
+			_mm256_storeu_ps(lastanalphase + i, Permute_F8_AVX2(ang));
+			ang = _mm256_sub_ps(lastp, ang);
+
+			// over sampling の影響を考慮する
+			__m256 i_v = _mm256_add_ps(_mm256_set1_ps((float)i), i_init);
+			__m256 phase_shift = _mm256_mul_ps(i_v, over_sampling_radian_v);
+			ang = _mm256_sub_ps(ang, phase_shift);
+
+			// unwrapping をする
+			ang = Wrap_Pi_F8_AVX2(ang);
+
+			// OverSampling による位相の補正
+			ang = _mm256_add_ps(ang, phase_shift);
+
+			// TimeScale による位相の補正
+			ang = _mm256_mul_ps(ang, exact_time_scale);
+
+			// 前回の位相と加算する
+			// ここでも虚数部の符号が逆になるので注意
+			ang = _mm256_sub_ps(Permute_F8_AVX2(_mm256_loadu_ps(lastsynthphase + i)), ang);
+			_mm256_storeu_ps(lastsynthphase + i, Permute_F8_AVX2(ang));
+
+			// 極座標系→直交座標系
+			__m256 sin, cos;
+			VFast_sincos_F8_AVX2(ang, sin, cos);
+			Interleave_F8_AVX2(synthwork + i*2, _mm256_mul_ps(mag, cos), _mm256_mul_ps(mag, sin));
+		}
+	}
+
+	_mm256_zeroupper();
+
+	// FFT を実行する
+	synthwork[1] = 0.0; // synthwork[1] = nyquist freq. power (どっちみち使えないので0に)
+	rdft_sse(FrameSize, -1, synthwork, FFTWorkIp, FFTWorkW); // Inverse Real DFT
+}
+//---------------------------------------------------------------------------
+#endif
+//---------------------------------------------------------------------------
@@ -14,6 +14,7 @@
 #define RingBufferH
 
 #include <stddef.h>
+#include <atomic>
 /*
 	リングバッファ, ring buffer, circular buffer, 環状バッファ
 */
@@ -205,4 +206,242 @@ public:
 	}
 };
 
+
+
+//---------------------------------------------------------------------------
+//! @brief		キャッシュラインのサイズ (推定値)
+//---------------------------------------------------------------------------
+#define RISA_CACHE_LINE_SIZE 64
+
+
+//---------------------------------------------------------------------------
+//! @brief		単一の書き込みスレッドと単一の読み込みスレッドの間で使う
+//!				ロックフリーな固定長リングバッファ
+//! @note		書き込み側 (producer) と読み込み側 (consumer) はそれぞれ
+//!				同時には一つのスレッドからしかアクセスしてはならない。
+//!				複数のスレッドが書き込み側になりうる場合は、呼び出し側で
+//!				書き込み側同士を排他すること (読み込み側も同様)。
+//!				書き込み位置と読み込み位置はそれぞれ別のキャッシュラインに
+//!				置かれ、相手側の位置はキャッシュしておいて足りなくなったとき
+//!				だけ読み直すので、両者が互いのキャッシュラインを奪い合う
+//!				ことは少ない。
+//!				いずれの操作も待ちを生じない (wait-free)。
+//---------------------------------------------------------------------------
+template <typename T>
+class tRisaSPSCRingBuffer
+{
+	// 位置は 0 ～ Size*2-1 の範囲で回る。
+	// WritePos == ReadPos ならば空、両者の差が Size ならば満杯である。
+
+	T * Buffer; //!< バッファ
+	size_t Size; //!< バッファのサイズ
+	char Padding0[RISA_CACHE_LINE_SIZE];
+
+	std::atomic<size_t> WritePos; //!< 書き込み位置 (書き込み側のみが変更する)
+	size_t ReadPosCache; //!< 書き込み側が最後に見た読み込み位置
+	char Padding1[RISA_CACHE_LINE_SIZE];
+
+	std::atomic<size_t> ReadPos; //!< 読み込み位置 (読み込み側のみが変更する)
+	size_t WritePosCache; //!< 読み込み側が最後に見た書き込み位置
+	char Padding2[RISA_CACHE_LINE_SIZE];
+
+public:
+	//! @brief コンストラクタ
+	//! @param	size	バッファのサイズ (0 の場合は後で Resize を呼ぶこと)
+	tRisaSPSCRingBuffer(size_t size = 0)
+	{
+		Buffer = NULL;
+		Size = 0;
+		Resize(size);
+	}
+
+	//! @brief デストラクタ
+	~tRisaSPSCRingBuffer()
+	{
+		delete [] Buffer;
+	}
+
+	//! @brief	バッファを確保しなおす
+	//! @param	size	バッファのサイズ
+	//! @note	内容は失われる。両側のスレッドがバッファにアクセスしていない
+	//!			ときに呼ぶこと。
+	void Resize(size_t size)
+	{
+		delete [] Buffer;
+		Buffer = size ? new T[size] : NULL;
+		Size = size;
+		Reset();
+	}
+
+	//! @brief	バッファを空にする
+	//! @note	要素の内容はそのまま残る。両側のスレッドがバッファにアクセス
+	//!			していないときに呼ぶこと。
+	void Reset()
+	{
+		WritePos.store(0, std::memory_order_relaxed);
+		ReadPos.store(0, std::memory_order_relaxed);
+		ReadPosCache = WritePosCache = 0;
+	}
+
+	//! @brief	サイズを得る
+	size_t GetSize() const { return Size; }
+
+	//! @brief	バッファに入っているデータのサイズを得る
+	//! @note	どのスレッドからも呼べるが、他方のスレッドが動いている場合は
+	//!			その時点でのおおよその値となる。
+	size_t GetDataSize() const
+	{
+		return Distance(WritePos.load(std::memory_order_acquire),
+			ReadPos.load(std::memory_order_acquire));
+	}
+
+	//! @brief	バッファの空き容量を得る
+	//! @note	GetDataSize と同じく、おおよその値となる
+	size_t GetFreeSize() const { return Size - GetDataSize(); }
+
+	//! @brief	要素を直接得る
+	//! @param	index	バッファ内のインデックス (0 ～ Size-1)
+	//! @note	両側のスレッドがバッファにアクセスしていないときに使うこと
+	T & GetSlot(size_t index) { return Buffer[index]; }
+
+	//-- 書き込み側 (producer) のみが呼べるメソッド
+
+	//! @brief	書き込める要素数を得る
+	size_t GetWritableSize()
+	{
+		size_t w = WritePos.load(std::memory_order_relaxed);
+		size_t free = Size - Distance(w, ReadPosCache);
+		if(free == 0)
+		{
+			// 足りなければ読み込み位置を読み直す
+			ReadPosCache = ReadPos.load(std::memory_order_acquire);
+			free = Size - Distance(w, ReadPosCache);
+		}
+		return free;
+	}
+
+	//! @brief	書き込み位置のバッファ内インデックスを得る
+	size_t GetWriteIndex() const
+	{
+		return ToIndex(WritePos.load(std::memory_order_relaxed));
+	}
+
+	//! @brief	書き込み位置の要素を返す
+	//! @note	事前に GetWritableSize で空きがあることを確認すること
+	T & GetWriteSlot() { return Buffer[GetWriteIndex()]; }
+
+	//! @brief	書き込みポインタを進め、書き込んだ要素を読み込み側に公開する
+	//! @param	advance		進める要素数 (GetWritableSize 以下であること)
+	void AdvanceWritePos(size_t advance = 1)
+	{
+		WritePos.store(Next(WritePos.load(std::memory_order_relaxed), advance),
+			std::memory_order_release);
+	}
+
+	//! @brief	データを書き込む
+	//! @param	data	書き込むデータ
+	//! @param	count	書き込みたい要素数
+	//! @return	実際に書き込んだ要素数 (空きが足りなければ count より小さくなる)
+	size_t Write(const T * data, size_t count)
+	{
+		size_t free = GetWritableSize();
+		if(count > free)
+		{
+			ReadPosCache = ReadPos.load(std::memory_order_acquire);
+			free = Size - Distance(WritePos.load(std::memory_order_relaxed), ReadPosCache);
+			if(count > free) count = free;
+		}
+		size_t pos = GetWriteIndex();
+		for(size_t i = 0; i < count; i++)
+		{
+			Buffer[pos] = data[i];
+			if(++pos == Size) pos = 0;
+		}
+		if(count) AdvanceWritePos(count);
+		return count;
+	}
+
+	//-- 読み込み側 (consumer) のみが呼べるメソッド
+
+	//! @brief	読み込める要素数を得る
+	size_t GetReadableSize()
+	{
+		size_t r = ReadPos.load(std::memory_order_relaxed);
+		size_t avail = Distance(WritePosCache, r);
+		if(avail == 0)
+		{
+			// 足りなければ書き込み位置を読み直す
+			WritePosCache = WritePos.load(std::memory_order_acquire);
+			avail = Distance(WritePosCache, r);
+		}
+		return avail;
+	}
+
+	//! @brief	読み込み位置のバッファ内インデックスを得る
+	size_t GetReadIndex() const
+	{
+		return ToIndex(ReadPos.load(std::memory_order_relaxed));
+	}
+
+	//! @brief	読み込み位置の要素を返す
+	//! @note	事前に GetReadableSize でデータがあることを確認すること
+	T & GetReadSlot() { return Buffer[GetReadIndex()]; }
+
+	//! @brief	読み込みポインタを進め、読み終わった領域を書き込み側に返す
+	//! @param	advance		進める要素数 (GetReadableSize 以下であること)
+	void AdvanceReadPos(size_t advance = 1)
+	{
+		ReadPos.store(Next(ReadPos.load(std::memory_order_relaxed), advance),
+			std::memory_order_release);
+	}
+
+	//! @brief	データを読み込む
+	//! @param	dest	読み込み先
+	//! @param	count	読み込みたい要素数
+	//! @return	実際に読み込んだ要素数 (データが足りなければ count より小さくなる)
+	size_t Read(T * dest, size_t count)
+	{
+		size_t avail = GetReadableSize();
+		if(count > avail)
+		{
+			WritePosCache = WritePos.load(std::memory_order_acquire);
+			avail = Distance(WritePosCache, ReadPos.load(std::memory_order_relaxed));
+			if(count > avail) count = avail;
+		}
+		size_t pos = GetReadIndex();
+		for(size_t i = 0; i < count; i++)
+		{
+			dest[i] = Buffer[pos];
+			if(++pos == Size) pos = 0;
+		}
+		if(count) AdvanceReadPos(count);
+		return count;
+	}
+
+private:
+	//! @brief	位置を進める
+	size_t Next(size_t pos, size_t advance) const
+	{
+		pos += advance;
+		if(pos >= Size * 2) pos -= Size * 2;
+		return pos;
+	}
+
+	//! @brief	書き込み位置と読み込み位置の差 (=データのサイズ) を得る
+	size_t Distance(size_t w, size_t r) const
+	{
+		return w >= r ? w - r : w + Size * 2 - r;
+	}
+
+	//! @brief	位置をバッファ内のインデックスに変換する
+	size_t ToIndex(size_t pos) const
+	{
+		return pos >= Size ? pos - Size : pos;
+	}
+
+	// コピーは禁止
+	tRisaSPSCRingBuffer(const tRisaSPSCRingBuffer &);
+	void operator = (const tRisaSPSCRingBuffer &);
+};
+
 #endif
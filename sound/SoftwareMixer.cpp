@@ -0,0 +1,470 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Portable Software Mixer
+//---------------------------------------------------------------------------
+
+#include "tjsCommHead.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include "SoftwareMixer.h"
+#include "StorageIntf.h"
+#include "DetectCPU.h"
+#include "tvpgl_ia32_intf.h"
+#if defined(_M_IX86)||defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+
+//---------------------------------------------------------------------------
+#define TVP_SM_BLOCK_FRAMES 1024 // mixing block size, in sample granule
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// mixing routines
+//---------------------------------------------------------------------------
+static void TVPMixStereoAdd_c(float *dest, const float *src,
+	float gl, float gr, tjs_uint frames)
+{
+	// dest += src * (gl, gr)
+	for(tjs_uint i = 0; i < frames; i++)
+	{
+		dest[0] += src[0] * gl;
+		dest[1] += src[1] * gr;
+		dest += 2; src += 2;
+	}
+}
+//---------------------------------------------------------------------------
+#if defined(_M_IX86)||defined(_M_X64)
+static void TVPMixStereoAdd_sse(float *dest, const float *src,
+	float gl, float gr, tjs_uint frames)
+{
+	// SSE version; 4 sample granules (8 floats) per one loop
+	__m128 gain = _mm_set_ps(gr, gl, gr, gl);
+	tjs_uint n = frames >> 2;
+	while(n--)
+	{
+		__m128 d0 = _mm_loadu_ps(dest + 0);
+		__m128 d1 = _mm_loadu_ps(dest + 4);
+		__m128 s0 = _mm_loadu_ps(src + 0);
+		__m128 s1 = _mm_loadu_ps(src + 4);
+		_mm_storeu_ps(dest + 0, _mm_add_ps(d0, _mm_mul_ps(s0, gain)));
+		_mm_storeu_ps(dest + 4, _mm_add_ps(d1, _mm_mul_ps(s1, gain)));
+		dest += 8; src += 8;
+	}
+	TVPMixStereoAdd_c(dest, src, gl, gr, frames & 3);
+}
+#endif
+//---------------------------------------------------------------------------
+static void TVPMixStereoAdd(float *dest, const float *src,
+	float gl, float gr, tjs_uint frames)
+{
+#if defined(_M_IX86)||defined(_M_X64)
+	if(TVPCPUType & TVP_CPU_HAS_SSE)
+		TVPMixStereoAdd_sse(dest, src, gl, gr, frames);
+	else
+		TVPMixStereoAdd_c(dest, src, gl, gr, frames);
+#else
+	TVPMixStereoAdd_c(dest, src, gl, gr, frames);
+#endif
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// tTVPWaveFileMixerOutput
+//---------------------------------------------------------------------------
+tTVPWaveFileMixerOutput::tTVPWaveFileMixerOutput(const ttstr & storage,
+	tjs_uint frequency)
+{
+	Frequency = frequency;
+	Written = 0;
+	Stream = TVPCreateStream(storage, TJS_BS_WRITE);
+	try
+	{
+		WriteHeader(); // sizes are filled at destruction
+	}
+	catch(...)
+	{
+		delete Stream;
+		throw;
+	}
+}
+//---------------------------------------------------------------------------
+tTVPWaveFileMixerOutput::~tTVPWaveFileMixerOutput()
+{
+	try
+	{
+		Stream->SetPosition(0);
+		WriteHeader();
+	}
+	catch(...)
+	{
+		// ignore errors
+	}
+	delete Stream;
+}
+//---------------------------------------------------------------------------
+static void TVPWriteLE(tjs_uint8 * &p, tjs_uint32 v, tjs_int bytes)
+{
+	while(bytes--) *(p++) = (tjs_uint8)v, v >>= 8;
+}
+//---------------------------------------------------------------------------
+void tTVPWaveFileMixerOutput::WriteHeader()
+{
+	// 16bit stereo PCM; see RIFF WAVE format
+	tjs_uint32 datasize = (tjs_uint32)(Written * 4);
+	tjs_uint8 header[44];
+	tjs_uint8 *p = header;
+	memcpy(p, "RIFF", 4); p += 4;
+	TVPWriteLE(p, 36 + datasize, 4);
+	memcpy(p, "WAVEfmt ", 8); p += 8;
+	TVPWriteLE(p, 16, 4); // fmt chunk size
+	TVPWriteLE(p, 1, 2); // WAVE_FORMAT_PCM
+	TVPWriteLE(p, 2, 2); // channels
+	TVPWriteLE(p, Frequency, 4);
+	TVPWriteLE(p, Frequency * 4, 4); // bytes per sec
+	TVPWriteLE(p, 4, 2); // block align
+	TVPWriteLE(p, 16, 2); // bits per sample
+	memcpy(p, "data", 4); p += 4;
+	TVPWriteLE(p, datasize, 4);
+	Stream->WriteBuffer(header, sizeof(header));
+}
+//---------------------------------------------------------------------------
+void tTVPWaveFileMixerOutput::Write(const float *samples, tjs_uint frames)
+{
+	tjs_uint count = frames * 2;
+	if(Buffer.size() < count) Buffer.resize(count);
+	for(tjs_uint i = 0; i < count; i++)
+	{
+		float v = samples[i] * 32767.0f;
+		Buffer[i] =
+			v > (float) 32767 ?  32767 :
+			v < (float)-32768 ? -32768 :
+				v < 0 ? (tjs_int16)(v - 0.5) : (tjs_int16)(v + 0.5);
+	}
+	Stream->WriteBuffer(&Buffer[0], count * sizeof(tjs_int16));
+	Written += frames;
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// tTVPSoftwareMixerVoice
+//---------------------------------------------------------------------------
+tTVPSoftwareMixerVoice::tTVPSoftwareMixerVoice(tTJSCriticalSection * cs,
+	tTVPSampleAndLabelSource * source, tjs_uint frequency)
+{
+	CS = cs;
+	Source = source;
+	SourceFormat = source->GetFormat();
+	Volume = 1.0f;
+	Pan = 0.0f;
+	Playing = false;
+	SourceEnded = false;
+	Step = ((tjs_uint64)SourceFormat.SamplesPerSec << 32) / frequency;
+	Phase = 0;
+	InputFrames = 0;
+	InputEndFrames = 0;
+}
+//---------------------------------------------------------------------------
+float tTVPSoftwareMixerVoice::GetVolume() const
+{
+	tTJSCriticalSectionHolder holder(*CS);
+	return Volume;
+}
+//---------------------------------------------------------------------------
+void tTVPSoftwareMixerVoice::SetVolume(float v)
+{
+	tTJSCriticalSectionHolder holder(*CS);
+	Volume = v < 0.0f ? 0.0f : v;
+}
+//---------------------------------------------------------------------------
+float tTVPSoftwareMixerVoice::GetPan() const
+{
+	tTJSCriticalSectionHolder holder(*CS);
+	return Pan;
+}
+//---------------------------------------------------------------------------
+void tTVPSoftwareMixerVoice::SetPan(float v)
+{
+	tTJSCriticalSectionHolder holder(*CS);
+	Pan = v < -1.0f ? -1.0f : v > 1.0f ? 1.0f : v;
+}
+//---------------------------------------------------------------------------
+bool tTVPSoftwareMixerVoice::GetPlaying() const
+{
+	tTJSCriticalSectionHolder holder(*CS);
+	return Playing;
+}
+//---------------------------------------------------------------------------
+void tTVPSoftwareMixerVoice::Play()
+{
+	tTJSCriticalSectionHolder holder(*CS);
+	Playing = true;
+	SourceEnded = false;
+}
+//---------------------------------------------------------------------------
+void tTVPSoftwareMixerVoice::Stop()
+{
+	tTJSCriticalSectionHolder holder(*CS);
+	Playing = false;
+}
+//---------------------------------------------------------------------------
+void tTVPSoftwareMixerVoice::FillInput(tjs_uint frames)
+{
+	// ensure that Input has at least "frames" sample granules.
+	// the source is converted to float stereo here; channels beyond stereo
+	// are folded alternately into left and right.
+	if(Input.size() < frames * 2) Input.resize(frames * 2);
+
+	tjs_uint channels = SourceFormat.Channels;
+	tTVPWaveSegmentQueue segments;
+
+	while(InputFrames < frames && !SourceEnded)
+	{
+		tjs_uint want = frames - InputFrames;
+		tjs_uint bytes = want * SourceFormat.BytesPerSample * channels;
+		if(DecodeBuffer.size() < bytes) DecodeBuffer.resize(bytes);
+		if(ConvertBuffer.size() < want * channels)
+			ConvertBuffer.resize(want * channels);
+
+		tjs_uint written = 0;
+		segments.Clear();
+		Source->Decode(&DecodeBuffer[0], want, written, segments);
+		if(written < want) SourceEnded = true;
+		if(written == 0) break;
+
+		TVPConvertPCMToFloat(&ConvertBuffer[0], &DecodeBuffer[0], SourceFormat,
+			written);
+
+		const float *s = &ConvertBuffer[0];
+		float *d = &Input[InputFrames * 2];
+		if(channels == 1)
+		{
+			for(tjs_uint i = 0; i < written; i++)
+				d[i*2] = d[i*2+1] = s[i];
+		}
+		else if(channels == 2)
+		{
+			memcpy(d, s, written * 2 * sizeof(float));
+		}
+		else
+		{
+			float lscale = 1.0f / (float)((channels + 1) / 2);
+			float rscale = 1.0f / (float)(channels / 2);
+			for(tjs_uint i = 0; i < written; i++)
+			{
+				float l = 0.0f, r = 0.0f;
+				for(tjs_uint ch = 0; ch < channels; ch += 2) l += s[ch];
+				for(tjs_uint ch = 1; ch < channels; ch += 2) r += s[ch];
+				d[i*2] = l * lscale;
+				d[i*2+1] = r * rscale;
+				s += channels;
+			}
+		}
+		InputFrames += written;
+		InputEndFrames = InputFrames; // the silence below is not counted
+	}
+
+	if(InputFrames < frames)
+	{
+		// the source has ended; fill the rest with silence
+		memset(&Input[InputFrames * 2], 0,
+			(frames - InputFrames) * 2 * sizeof(float));
+		InputFrames = frames;
+	}
+}
+//---------------------------------------------------------------------------
+tjs_uint tTVPSoftwareMixerVoice::Render(float *dest, tjs_uint frames)
+{
+	// render "frames" sample granules of float stereo, converting the sample
+	// rate by linear interpolation.
+	// returns the number of sample granules which came from the source.
+	// the input must also hold every source sample granule this call
+	// consumes, which is more than the interpolation reads when the step
+	// is over 2.
+	tjs_uint64 last = Phase + Step * (frames - 1);
+	tjs_uint need = (tjs_uint)(last >> 32) + 2;
+	tjs_uint64 phaseend = Phase + Step * frames;
+	if((tjs_uint)(phaseend >> 32) > need) need = (tjs_uint)(phaseend >> 32);
+	FillInput(need);
+
+	const float *in = &Input[0];
+	if(Step == ((tjs_uint64)1 << 32))
+	{
+		// same frequency; no conversion is needed
+		memcpy(dest, in, frames * 2 * sizeof(float));
+	}
+	else
+	{
+		tjs_uint64 pos = Phase;
+		for(tjs_uint i = 0; i < frames; i++)
+		{
+			const float *s = in + (tjs_uint)(pos >> 32) * 2;
+			float frac = (float)(tjs_uint32)pos * (1.0f / 4294967296.0f);
+			dest[i*2  ] = s[0] + (s[2] - s[0]) * frac;
+			dest[i*2+1] = s[1] + (s[3] - s[1]) * frac;
+			pos += Step;
+		}
+	}
+
+	// discard consumed input
+	tjs_uint consumed = (tjs_uint)(phaseend >> 32);
+
+	tjs_uint rendered = frames;
+	if(SourceEnded && consumed >= InputEndFrames)
+	{
+		// all samples from the source have been played; the output sample
+		// granules before the end position came from the source
+		tjs_uint64 end = (tjs_uint64)InputEndFrames << 32;
+		rendered = end > Phase ?
+			(tjs_uint)((end - Phase + Step - 1) / Step) : 0;
+		if(rendered > frames) rendered = frames;
+		Playing = false;
+	}
+	Phase = phaseend & 0xffffffff;
+
+	if(consumed >= InputFrames)
+	{
+		InputFrames = 0;
+	}
+	else
+	{
+		memmove(&Input[0], &Input[consumed * 2],
+			(InputFrames - consumed) * 2 * sizeof(float));
+		InputFrames -= consumed;
+	}
+	InputEndFrames = consumed >= InputEndFrames ? 0 : InputEndFrames - consumed;
+
+	return rendered;
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// tTVPSoftwareMixer
+//---------------------------------------------------------------------------
+tTVPSoftwareMixer::tTVPSoftwareMixer(tjs_uint frequency,
+	iTVPSoftwareMixerOutput * output)
+{
+	Frequency = frequency;
+	Output = output;
+	MixBuffer.resize(TVP_SM_BLOCK_FRAMES * 2);
+	VoiceBuffer.resize(TVP_SM_BLOCK_FRAMES * 2);
+	LimiterGain = 1.0f;
+	SetLimiter(1.0f, 100);
+}
+//---------------------------------------------------------------------------
+tTVPSoftwareMixer::~tTVPSoftwareMixer()
+{
+	std::vector<tTVPSoftwareMixerVoice *>::iterator i;
+	for(i = Voices.begin(); i != Voices.end(); i++) delete *i;
+}
+//---------------------------------------------------------------------------
+tTVPSoftwareMixerVoice * tTVPSoftwareMixer::AddVoice(
+	tTVPSampleAndLabelSource * source)
+{
+	tTJSCriticalSectionHolder holder(CS);
+	tTVPSoftwareMixerVoice * voice = new tTVPSoftwareMixerVoice(&CS,
+		source, Frequency);
+	try
+	{
+		Voices.push_back(voice);
+	}
+	catch(...)
+	{
+		delete voice;
+		throw;
+	}
+	return voice;
+}
+//---------------------------------------------------------------------------
+void tTVPSoftwareMixer::RemoveVoice(tTVPSoftwareMixerVoice * voice)
+{
+	tTJSCriticalSectionHolder holder(CS);
+	std::vector<tTVPSoftwareMixerVoice *>::iterator i =
+		std::find(Voices.begin(), Voices.end(), voice);
+	if(i != Voices.end())
+	{
+		Voices.erase(i);
+		delete voice;
+	}
+}
+//---------------------------------------------------------------------------
+void tTVPSoftwareMixer::SetLimiter(float threshold, tjs_uint releasems)
+{
+	// "releasems" is the time constant of the gain recovery
+	tTJSCriticalSectionHolder holder(CS);
+	LimiterThreshold = threshold;
+	float releasesamples = (float)releasems * (float)Frequency / 1000.0f;
+	LimiterRelease = releasesamples < 1.0f ?
+		1.0f : 1.0f - (float)exp(-1.0 / releasesamples);
+}
+//---------------------------------------------------------------------------
+void tTVPSoftwareMixer::Limit(float *buf, tjs_uint frames)
+{
+	// peak limiter without look-ahead; the gain drops at once to keep the
+	// peak under the threshold, and recovers exponentially.
+	float gain = LimiterGain;
+	float threshold = LimiterThreshold;
+	float release = LimiterRelease;
+	for(tjs_uint i = 0; i < frames; i++)
+	{
+		float l = buf[i*2], r = buf[i*2+1];
+		float peak = fabs(l) > fabs(r) ? (float)fabs(l) : (float)fabs(r);
+		gain += (1.0f - gain) * release;
+		if(peak * gain > threshold) gain = threshold / peak;
+		buf[i*2] = l * gain;
+		buf[i*2+1] = r * gain;
+	}
+	LimiterGain = gain;
+}
+//---------------------------------------------------------------------------
+void tTVPSoftwareMixer::Render(tjs_uint frames)
+{
+	tTJSCriticalSectionHolder holder(CS);
+
+	while(frames)
+	{
+		tjs_uint n = frames < TVP_SM_BLOCK_FRAMES ? frames : TVP_SM_BLOCK_FRAMES;
+		float *mix = &MixBuffer[0];
+		float *voicebuf = &VoiceBuffer[0];
+		memset(mix, 0, n * 2 * sizeof(float));
+
+		std::vector<tTVPSoftwareMixerVoice *>::iterator i;
+		for(i = Voices.begin(); i != Voices.end(); i++)
+		{
+			tTVPSoftwareMixerVoice * voice = *i;
+			if(!voice->Playing) continue;
+
+			tjs_uint rendered = voice->Render(voicebuf, n);
+
+			float gl = voice->Volume, gr = voice->Volume;
+			if(voice->Pan > 0.0f) gl *= 1.0f - voice->Pan;
+			if(voice->Pan < 0.0f) gr *= 1.0f + voice->Pan;
+			TVPMixStereoAdd(mix, voicebuf, gl, gr, rendered);
+		}
+
+		Limit(mix, n);
+		Output->Write(mix, n);
+		frames -= n;
+	}
+}
+//---------------------------------------------------------------------------
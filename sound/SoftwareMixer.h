@@ -0,0 +1,179 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Portable Software Mixer
+//---------------------------------------------------------------------------
+/*
+	tTVPSoftwareMixer mixes any number of tTVPSampleAndLabelSource (typically
+	tTVPWaveLoopManager, or the output of a wave filter chain) into one
+	32bit float stereo stream, and passes the result to an output backend.
+
+	The mixer does not depend on any platform sound API, so the whole audio
+	pipeline can run without sound hardware, ie. with tTVPNullMixerOutput
+	(discards the output) or tTVPWaveFileMixerOutput (writes a RIFF wave file).
+*/
+#ifndef SoftwareMixerH
+#define SoftwareMixerH
+
+#include "WaveIntf.h"
+#include "WaveLoopManager.h"
+#include <vector>
+
+
+//---------------------------------------------------------------------------
+// iTVPSoftwareMixerOutput : output backend interface
+//---------------------------------------------------------------------------
+class iTVPSoftwareMixerOutput
+{
+public:
+	virtual ~iTVPSoftwareMixerOutput() {};
+
+	virtual void Write(const float *samples, tjs_uint frames) = 0;
+		/*
+			Receive mixed samples. "samples" is 32bit float, interleaved stereo
+			(L, R, L, R ...), in range of -1.0 ... +1.0 . "frames" is the number
+			of sample granules.
+		*/
+};
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// tTVPNullMixerOutput : output backend which discards everything
+//---------------------------------------------------------------------------
+class tTVPNullMixerOutput : public iTVPSoftwareMixerOutput
+{
+	tjs_uint64 Written; // total written sample granules
+
+public:
+	tTVPNullMixerOutput() { Written = 0; }
+
+	void Write(const float *samples, tjs_uint frames) { Written += frames; }
+
+	tjs_uint64 GetWritten() const { return Written; }
+};
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// tTVPWaveFileMixerOutput : output backend which writes 16bit RIFF wave file
+//---------------------------------------------------------------------------
+class tTVPWaveFileMixerOutput : public iTVPSoftwareMixerOutput
+{
+	tTJSBinaryStream * Stream;
+	tjs_uint Frequency;
+	tjs_uint64 Written; // total written sample granules
+	std::vector<tjs_int16> Buffer;
+
+public:
+	tTVPWaveFileMixerOutput(const ttstr & storage, tjs_uint frequency);
+	~tTVPWaveFileMixerOutput();
+
+	void Write(const float *samples, tjs_uint frames);
+
+private:
+	void WriteHeader();
+};
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// tTVPSoftwareMixerVoice : one voice of the software mixer
+//---------------------------------------------------------------------------
+class tTVPSoftwareMixer;
+class tTVPSoftwareMixerVoice
+{
+	friend class tTVPSoftwareMixer;
+
+	tTJSCriticalSection * CS; // CS of the mixer, which Render holds
+	tTVPSampleAndLabelSource * Source; // not owned by the voice
+	tTVPWaveFormat SourceFormat;
+
+	float Volume; // 0.0 ... 1.0
+	float Pan; // -1.0 (left) ... 0 ... +1.0 (right)
+	bool Playing;
+	bool SourceEnded;
+
+	tjs_uint64 Step; // source samples per output sample, in 32.32 fixed point
+	tjs_uint64 Phase; // fraction of the current source position, in 32.32
+
+	std::vector<tjs_uint8> DecodeBuffer; // samples from the source
+	std::vector<float> ConvertBuffer; // samples converted to float
+	std::vector<float> Input; // source samples in float stereo
+	tjs_uint InputFrames; // valid sample granules in Input
+	tjs_uint InputEndFrames; // sample granules in Input which are decoded
+
+	tTVPSoftwareMixerVoice(tTJSCriticalSection * cs,
+		tTVPSampleAndLabelSource * source, tjs_uint frequency);
+
+public:
+	// these may be called from any thread while the mixer is rendering
+	float GetVolume() const;
+	void SetVolume(float v);
+	float GetPan() const;
+	void SetPan(float v);
+		// the pan attenuates the other side linearly; -1.0 silences the
+		// right, +1.0 the left, and the center keeps both at the volume
+
+	bool GetPlaying() const;
+	void Play();
+	void Stop();
+
+private:
+	void FillInput(tjs_uint frames);
+	tjs_uint Render(float *dest, tjs_uint frames);
+};
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// tTVPSoftwareMixer : the software mixer
+//---------------------------------------------------------------------------
+class tTVPSoftwareMixer
+{
+	tTJSCriticalSection CS; // CS to protect voices and the mixing state
+
+	tjs_uint Frequency; // output frequency
+	iTVPSoftwareMixerOutput * Output; // not owned by the mixer
+	std::vector<tTVPSoftwareMixerVoice *> Voices;
+
+	std::vector<float> MixBuffer; // master bus
+	std::vector<float> VoiceBuffer; // one voice after resampling
+
+	float LimiterThreshold; // peak level which the limiter never exceeds
+	float LimiterRelease; // gain recovery coefficient per sample granule
+	float LimiterGain; // current limiter gain
+
+public:
+	tTVPSoftwareMixer(tjs_uint frequency, iTVPSoftwareMixerOutput * output);
+	~tTVPSoftwareMixer();
+
+	tjs_uint GetFrequency() const { return Frequency; }
+
+	tTVPSoftwareMixerVoice * AddVoice(tTVPSampleAndLabelSource * source);
+	void RemoveVoice(tTVPSoftwareMixerVoice * voice);
+	tjs_uint GetVoiceCount() const { return (tjs_uint)Voices.size(); }
+
+	void SetLimiter(float threshold, tjs_uint releasems);
+
+	void Render(tjs_uint frames);
+		/*
+			Mix "frames" sample granules of all playing voices and pass them to
+			the output. Voices whose source is ended stop automatically.
+		*/
+
+private:
+	void Limit(float *buf, tjs_uint frames);
+};
+//---------------------------------------------------------------------------
+
+#endif
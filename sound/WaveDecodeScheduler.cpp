@@ -0,0 +1,249 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Wave decoding scheduler
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <vector>
+#include <algorithm>
+#include "WaveDecodeScheduler.h"
+#include "SysInitIntf.h"
+
+
+//---------------------------------------------------------------------------
+tTVPThreadPriority TVPWaveDecodeThreadHighPriority = ttpHigher;
+tTVPThreadPriority TVPWaveDecodeThreadLowPriority = ttpLowest;
+tjs_int TVPWaveDecodeThreadNum = 0;
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// tTVPWaveDecodeThread : decoding thread
+//---------------------------------------------------------------------------
+class tTVPWaveDecodeThread : public tTVPThread
+{
+	tTVPThreadEvent Event;
+
+public:
+	tTVPWaveDecodeThread();
+	~tTVPWaveDecodeThread();
+
+	void Execute(void);
+
+	void Wake() { Event.Set(); }
+
+private:
+	tTVPWaveDecodeTask * PickTask();
+	void ReleaseTask(tTVPWaveDecodeTask * task, bool decoded);
+};
+//---------------------------------------------------------------------------
+static std::vector<tTVPWaveDecodeTask *> TVPWaveDecodeTaskVector;
+static std::vector<tTVPWaveDecodeThread *> TVPWaveDecodeThreadVector;
+static tTJSCriticalSection TVPWaveDecodeTaskVectorCS;
+	// also protects tTVPWaveDecodeTask::Worker
+//---------------------------------------------------------------------------
+tTVPWaveDecodeTask * tTVPWaveDecodeThread::PickTask()
+{
+	// pick the running task which is nearest to underrun, and lock it.
+	// returns NULL if all tasks are sleeping or their buffers are full.
+	tTJSCriticalSectionHolder holder(TVPWaveDecodeTaskVectorCS);
+
+	tTVPWaveDecodeTask * nearest = NULL;
+	tjs_int nearest_remain = 0;
+
+	std::vector<tTVPWaveDecodeTask *>::iterator i;
+	for(i = TVPWaveDecodeTaskVector.begin();
+		i != TVPWaveDecodeTaskVector.end(); i++)
+	{
+		tTVPWaveDecodeTask * task = *i;
+		if(!task->Running || task->Worker) continue;
+
+		tjs_int remain, units;
+		task->Target->GetDecodeStatus(remain, units);
+		if(remain >= units) continue; // buffer is full
+
+		if(!nearest || remain < nearest_remain)
+			nearest = task, nearest_remain = remain;
+	}
+
+	if(nearest)
+	{
+		nearest->OneLoopCS.Enter();
+		nearest->Worker = this;
+		SetPriority(nearest->Priority);
+			// while the vector CS is held, so that tTVPWaveDecodeTask::
+			// SetPriority is not overwritten by the old priority
+	}
+
+	return nearest;
+}
+//---------------------------------------------------------------------------
+void tTVPWaveDecodeThread::ReleaseTask(tTVPWaveDecodeTask * task, bool decoded)
+{
+	{
+		tTJSCriticalSectionHolder holder(TVPWaveDecodeTaskVectorCS);
+		task->Worker = NULL;
+		if(decoded) task->Priority = TVPWaveDecodeThreadLowPriority;
+			// the buffer got one more unit; the boost has done its work
+	}
+	task->OneLoopCS.Leave();
+}
+//---------------------------------------------------------------------------
+static void TVPWakeWaveDecodeThreads()
+{
+	tTJSCriticalSectionHolder holder(TVPWaveDecodeTaskVectorCS);
+
+	if(TVPWaveDecodeThreadVector.size() == 0)
+	{
+		// create decoding threads
+		tjs_int num = TVPWaveDecodeThreadNum;
+		if(num == 0)
+		{
+			num = TVPGetProcessorNum();
+			if(num > 2) num = 2;
+			if(num < 1) num = 1;
+		}
+		for(tjs_int n = 0; n < num; n++)
+			TVPWaveDecodeThreadVector.push_back(new tTVPWaveDecodeThread());
+	}
+
+	std::vector<tTVPWaveDecodeThread *>::iterator i;
+	for(i = TVPWaveDecodeThreadVector.begin();
+		i != TVPWaveDecodeThreadVector.end(); i++)
+		(*i)->Wake();
+}
+//---------------------------------------------------------------------------
+void TVPShutdownWaveDecodeThreads()
+{
+	std::vector<tTVPWaveDecodeThread *> threads;
+	{
+		tTJSCriticalSectionHolder holder(TVPWaveDecodeTaskVectorCS);
+		threads.swap(TVPWaveDecodeThreadVector);
+	}
+
+	// threads must be deleted outside of the critical section;
+	// they may be waiting for it.
+	std::vector<tTVPWaveDecodeThread *>::iterator i;
+	for(i = threads.begin(); i != threads.end(); i++)
+		delete *i;
+}
+static tTVPAtExit TVPShutdownWaveDecodeThreadsAtExit
+	(TVP_ATEXIT_PRI_SHUTDOWN, TVPShutdownWaveDecodeThreads);
+//---------------------------------------------------------------------------
+tTVPWaveDecodeThread::tTVPWaveDecodeThread()
+	: tTVPThread(true)
+{
+	SetPriority(TVPWaveDecodeThreadHighPriority);
+	Resume();
+}
+//---------------------------------------------------------------------------
+tTVPWaveDecodeThread::~tTVPWaveDecodeThread()
+{
+	SetPriority(TVPWaveDecodeThreadHighPriority);
+	Terminate();
+	Resume();
+	Event.Set();
+	WaitFor();
+}
+//---------------------------------------------------------------------------
+#define TVP_WAVE_DECODE_THREAD_SLEEP_TIME 110
+void tTVPWaveDecodeThread::Execute(void)
+{
+	while(!GetTerminated())
+	{
+		// decoder thread main loop
+		tTVPWaveDecodeTask * task = PickTask();
+		if(!task)
+		{
+			// all buffers are full or sleeping; sleep longer
+			Event.WaitFor(TVP_WAVE_DECODE_THREAD_SLEEP_TIME);
+			continue;
+		}
+
+		bool decoded = false;
+		if(task->Running) decoded = task->Target->DecodeUnit();
+
+		ReleaseTask(task, decoded);
+	}
+}
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// tTVPWaveDecodeTask
+//---------------------------------------------------------------------------
+tTVPWaveDecodeTask::tTVPWaveDecodeTask(iTVPWaveDecodeTarget * target)
+{
+	Target = target;
+	Running = false;
+	Worker = NULL;
+	Priority = TVPWaveDecodeThreadHighPriority;
+
+	tTJSCriticalSectionHolder holder(TVPWaveDecodeTaskVectorCS);
+	TVPWaveDecodeTaskVector.push_back(this);
+}
+//---------------------------------------------------------------------------
+tTVPWaveDecodeTask::~tTVPWaveDecodeTask()
+{
+	{
+		tTJSCriticalSectionHolder holder(TVPWaveDecodeTaskVectorCS);
+		std::vector<tTVPWaveDecodeTask *>::iterator i =
+			std::find(TVPWaveDecodeTaskVector.begin(),
+				TVPWaveDecodeTaskVector.end(), this);
+		if(i != TVPWaveDecodeTaskVector.end())
+			TVPWaveDecodeTaskVector.erase(i);
+	}
+
+	// no thread can pick this task any longer; wait for the one which may be
+	// decoding this task now.
+	BoostWorker(TVPWaveDecodeThreadHighPriority);
+	tTJSCriticalSectionHolder cs_holder(OneLoopCS);
+	Running = false;
+}
+//---------------------------------------------------------------------------
+void tTVPWaveDecodeTask::Interrupt()
+{
+	// interrupt the decoding
+	if(!Running) return;
+	BoostWorker(TVPWaveDecodeThreadHighPriority);
+	tTJSCriticalSectionHolder cs_holder(OneLoopCS);
+		// this ensures that this function stops the decoding
+	Running = false;
+}
+//---------------------------------------------------------------------------
+void tTVPWaveDecodeTask::Continue()
+{
+	{
+		tTJSCriticalSectionHolder holder(TVPWaveDecodeTaskVectorCS);
+		if(Priority < TVPWaveDecodeThreadHighPriority)
+			Priority = TVPWaveDecodeThreadHighPriority; // keep a boost
+	}
+	Running = true;
+	TVPWakeWaveDecodeThreads();
+}
+//---------------------------------------------------------------------------
+void tTVPWaveDecodeTask::SetPriority(tTVPThreadPriority pri)
+{
+	// Worker can not change to another task while the vector CS is held
+	tTJSCriticalSectionHolder holder(TVPWaveDecodeTaskVectorCS);
+	Priority = pri;
+	if(Worker) Worker->SetPriority(pri);
+}
+//---------------------------------------------------------------------------
+void tTVPWaveDecodeTask::BoostWorker(tTVPThreadPriority pri)
+{
+	// set the priority of the thread which is decoding this task, if any,
+	// without changing the priority of the task
+	tTJSCriticalSectionHolder holder(TVPWaveDecodeTaskVectorCS);
+	if(Worker) Worker->SetPriority(pri);
+}
+//---------------------------------------------------------------------------
+
@@ -0,0 +1,90 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Wave decoding scheduler
+//---------------------------------------------------------------------------
+/*
+	The system has a small pool of decoding threads, shared by all sound
+	buffers. Each sound buffer owns one tTVPWaveDecodeTask, and a free
+	decoding thread always decodes one buffer unit of the running task which
+	has the fewest decoded units left, that is, the buffer which is going to
+	underrun first.
+
+	The priority requested for a task belongs to the task, not to the thread
+	which happens to decode it: a thread takes the priority of the task it
+	picks, so a boost never moves to another sound buffer.
+*/
+#ifndef WaveDecodeSchedulerH
+#define WaveDecodeSchedulerH
+
+#include "ThreadIntf.h"
+
+//---------------------------------------------------------------------------
+// iTVPWaveDecodeTarget : a buffer which is filled by the decoding threads
+//---------------------------------------------------------------------------
+class iTVPWaveDecodeTarget
+{
+public:
+	virtual void GetDecodeStatus(tjs_int &remain, tjs_int &units) = 0;
+		// "remain" is the number of decoded units which are not consumed yet,
+		// "units" is the capacity of the buffer. every unit of every target
+		// must hold the same duration, since "remain" is compared between
+		// the targets.
+	virtual bool DecodeUnit() = 0;
+		// decodes one unit; returns false if the buffer was full
+};
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+// tTVPWaveDecodeTask
+//---------------------------------------------------------------------------
+class tTVPWaveDecodeThread;
+class tTVPWaveDecodeTask
+{
+	friend class tTVPWaveDecodeThread;
+
+	iTVPWaveDecodeTarget * Target;
+	tTJSCriticalSection OneLoopCS;
+	volatile bool Running;
+	tTVPWaveDecodeThread * volatile Worker;
+		// the thread which is decoding this task now, or NULL
+	volatile tTVPThreadPriority Priority;
+		// the priority of the thread while it decodes this task
+
+public:
+	tTVPWaveDecodeTask(iTVPWaveDecodeTarget * target);
+	~tTVPWaveDecodeTask(); // waits for the thread which is decoding this task
+
+	void Interrupt(); // stops decoding; returns after the current unit is done
+	void Continue();
+
+	bool GetRunning() const { return Running; }
+
+	tTVPThreadPriority GetPriority() const { return Priority; }
+	void SetPriority(tTVPThreadPriority pri);
+		// the priority is applied to the thread which is decoding this task
+		// now, if any, and to the thread which picks this task next. the
+		// priority goes back to TVPWaveDecodeThreadLowPriority after a
+		// unit is decoded.
+
+private:
+	void BoostWorker(tTVPThreadPriority pri);
+};
+//---------------------------------------------------------------------------
+extern tTVPThreadPriority TVPWaveDecodeThreadHighPriority;
+	// the priority of the task which is waiting for decoding
+extern tTVPThreadPriority TVPWaveDecodeThreadLowPriority;
+	// the priority of the task which has just been decoded
+extern tjs_int TVPWaveDecodeThreadNum; // 0 for auto
+	// these are read when the decoding threads are created
+extern void TVPShutdownWaveDecodeThreads();
+	// deletes the decoding threads; they are created again on demand
+//---------------------------------------------------------------------------
+
+#endif
@@ -58,6 +58,210 @@ void PCMConvertLoopFloat32ToInt16(void * __restrict dest, const void * __restric
 //---------------------------------------------------------------------------
 
 
+//---------------------------------------------------------------------------
+/**
+ * TPDF ディザ用の乱数 (xorshift32)
+ * @return	-0.5 ～ +0.5 の一様乱数
+ */
+static inline float PCMDitherRand(tjs_uint32 & x)
+{
+	x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+	union { tjs_uint32 i; float f; } u;
+	u.i = (x >> 9) | 0x3f800000; // 1.0 ～ 2.0
+	return u.f - 1.5f;
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * float32→int16変換 (TPDF ディザ付き)
+ * @param seed	乱数の種 (0 以外)
+ */
+void PCMConvertLoopFloat32ToInt16Dither(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 seed)
+{
+	tjs_uint16 * d = static_cast<tjs_uint16*>(dest);
+	const float * s = static_cast<const float*>(src);
+	const float * s_lim = s + numsamples;
+
+	while(s < s_lim)
+	{
+		// 振幅 ±1LSB の三角分布ディザを加える
+		float v = *s * 32767.0f + (PCMDitherRand(seed) + PCMDitherRand(seed));
+		*d = 
+			 v > (float) 32767 ?  32767 :
+			 v < (float)-32768 ? -32768 :
+			 	v < 0 ? (tjs_int16)(v - 0.5) : (tjs_int16)(v + 0.5);
+		d += 1; s += 1;
+	}
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * uint8→float32変換
+ */
+void PCMConvertLoopInt8ToFloat32(void * __restrict dest, const void * __restrict src, size_t numsamples)
+{
+	float * d = static_cast<float*>(dest);
+	const tjs_uint8 * s = static_cast<const tjs_uint8*>(src);
+	const tjs_uint8 * s_lim = s + numsamples;
+
+	while(s < s_lim)
+	{
+		*d = ((tjs_int)*s - 0x80) * (1.0f/128.0f);
+		d += 1; s += 1;
+	}
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int24→float32変換
+ * @param mask	有効ビットのマスク (24bit 値に対するもの)
+ */
+void PCMConvertLoopInt24ToFloat32(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask)
+{
+	float * d = static_cast<float*>(dest);
+	const tjs_uint8 * s = static_cast<const tjs_uint8*>(src);
+	const tjs_uint8 * s_lim = s + numsamples * 3;
+
+	while(s < s_lim)
+	{
+		tjs_int32 t = s[0] + (s[1] << 8) + (s[2] << 16);
+		t |= -(t&0x800000); // 符号拡張
+		t &= mask;
+		*d = t * (1.0f/8388608.0f);
+		d += 1; s += 3;
+	}
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int32→float32変換
+ * @param mask	有効ビットのマスク
+ */
+void PCMConvertLoopInt32ToFloat32(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask)
+{
+	float * d = static_cast<float*>(dest);
+	const tjs_int32 * s = static_cast<const tjs_int32*>(src);
+	const tjs_int32 * s_lim = s + numsamples;
+
+	while(s < s_lim)
+	{
+		*d = (float)(*s & (tjs_int32)mask) * (1.0f/2147483648.0f);
+		d += 1; s += 1;
+	}
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * uint8→int16変換
+ */
+void PCMConvertLoopInt8ToInt16(void * __restrict dest, const void * __restrict src, size_t numsamples)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const tjs_uint8 * s = static_cast<const tjs_uint8*>(src);
+	const tjs_uint8 * s_lim = s + numsamples;
+
+	while(s < s_lim)
+	{
+		*d = (tjs_int16)(((tjs_int)*s - 0x80) * 0x100);
+		d += 1; s += 1;
+	}
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int24→int16変換
+ * @param mask	有効ビットのマスク (24bit 値に対するもの)
+ */
+void PCMConvertLoopInt24ToInt16(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const tjs_uint8 * s = static_cast<const tjs_uint8*>(src);
+	const tjs_uint8 * s_lim = s + numsamples * 3;
+
+	while(s < s_lim)
+	{
+		tjs_int32 t = s[0] + (s[1] << 8) + (s[2] << 16);
+		t |= -(t&0x800000); // 符号拡張
+		t &= mask;
+		*d = (tjs_int16)(t >> 8);
+		d += 1; s += 3;
+	}
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int32→int16変換
+ * @param mask	有効ビットのマスク
+ */
+void PCMConvertLoopInt32ToInt16(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const tjs_int32 * s = static_cast<const tjs_int32*>(src);
+	const tjs_int32 * s_lim = s + numsamples;
+
+	while(s < s_lim)
+	{
+		*d = (tjs_int16)((*s & (tjs_int32)mask) >> 16);
+		d += 1; s += 1;
+	}
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int16 ステレオ→モノラル ダウンミックス
+ * @note	dest は src と同じでもよい
+ */
+void PCMDownmixLoopInt16Stereo(void * dest, const void * src, size_t numframes)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const tjs_int16 * s = static_cast<const tjs_int16*>(src);
+	const tjs_int16 * s_lim = s + numframes * 2;
+
+	while(s < s_lim)
+	{
+		*d = (tjs_int16)(((tjs_int)s[0] + s[1]) / 2);
+		d += 1; s += 2;
+	}
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * float32 ステレオ→モノラル ダウンミックス
+ * @note	dest は src と同じでもよい
+ */
+void PCMDownmixLoopFloat32Stereo(void * dest, const void * src, size_t numframes)
+{
+	float * d = static_cast<float*>(dest);
+	const float * s = static_cast<const float*>(src);
+	const float * s_lim = s + numframes * 2;
+
+	while(s < s_lim)
+	{
+		*d = (s[0] + s[1]) * 0.5f;
+		d += 1; s += 2;
+	}
+}
+//---------------------------------------------------------------------------
+
+
 
 //---------------------------------------------------------------------------
 
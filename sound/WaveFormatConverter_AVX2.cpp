@@ -0,0 +1,423 @@
+//---------------------------------------------------------------------------
+/*
+	Risa [りさ]      alias 吉里吉里3 [kirikiri-3]
+	 stands for "Risa Is a Stagecraft Architecture"
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+//! @file
+//! @brief Waveフォーマットコンバータのコア関数 (AVX2版)
+//---------------------------------------------------------------------------
+
+#include "tjsCommHead.h"
+
+#include <immintrin.h> // AVX/AVX2
+#include "MathAlgorithms.h"
+
+#if defined(_M_IX86)||defined(_M_X64)
+//---------------------------------------------------------------------------
+// 端数の処理に使う関数 (WaveFormatConverter.cpp / WaveFormatConverter_SSE.cpp 内)
+//---------------------------------------------------------------------------
+extern void PCMConvertLoopInt16ToFloat32_sse(void * __restrict dest, const void * __restrict src, size_t numsamples);
+extern void PCMConvertLoopFloat32ToInt16_sse(void * __restrict dest, const void * __restrict src, size_t numsamples);
+extern void PCMConvertLoopFloat32ToInt16Dither(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 seed);
+extern void PCMConvertLoopInt8ToFloat32(void * __restrict dest, const void * __restrict src, size_t numsamples);
+extern void PCMConvertLoopInt24ToFloat32(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask);
+extern void PCMConvertLoopInt32ToFloat32(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask);
+extern void PCMConvertLoopInt8ToInt16(void * __restrict dest, const void * __restrict src, size_t numsamples);
+extern void PCMConvertLoopInt24ToInt16(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask);
+extern void PCMConvertLoopInt32ToInt16(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask);
+extern void PCMDownmixLoopInt16Stereo(void * dest, const void * src, size_t numframes);
+extern void PCMDownmixLoopFloat32Stereo(void * dest, const void * src, size_t numframes);
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * 24bit 値を 8 つ (24バイト) 読み込み、それぞれを 8bit 左シフトした int32 として返す
+ * (s から 28 バイトを読み込むので注意)
+ */
+static inline __m256i LoadInt24x8_avx2( const tjs_uint8 * s ) {
+	const __m256i shuffle = _mm256_setr_epi8(
+		-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9,10,11,
+		-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9,10,11);
+	__m256i v = _mm256_inserti128_si256(
+		_mm256_castsi128_si256(_mm_loadu_si128((__m128i const*)(s +  0))),
+		_mm_loadu_si128((__m128i const*)(s + 12)), 1);
+	return _mm256_shuffle_epi8(v, shuffle);
+}
+
+/**
+ * 8 つの int32 を飽和しつつ 8 つの int16 にする
+ */
+static inline __m128i PackInt32x8_avx2( __m256i v ) {
+	return _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+/**
+ * xorshift32 による -0.5 ～ +0.5 の一様乱数 (8並列)
+ */
+static inline __m256 DitherRand_avx2( __m256i & x ) {
+	x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+	x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+	__m256 f = _mm256_castsi256_ps(_mm256_or_si256(_mm256_srli_epi32(x, 9),
+		_mm256_set1_epi32(0x3f800000)));
+	return _mm256_sub_ps(f, _mm256_set1_ps(1.5f));
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int16→float32変換
+ */
+void PCMConvertLoopInt16ToFloat32_avx2(void * __restrict dest, const void * __restrict src, size_t numsamples)
+{
+	float * d = static_cast<float*>(dest);
+	const tjs_int16 * s = static_cast<const tjs_int16*>(src);
+	size_t n = 0;
+
+	if(numsamples >= 16)
+	{
+		// SSE 版と同じく 1/32767 倍する
+		const __m256 reduce = _mm256_set1_ps(1.0f/32767.0f);
+		for(     ; n < numsamples - 15; n += 16)
+		{
+			__m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i const*)(s + n + 0)));
+			__m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i const*)(s + n + 8)));
+			_mm256_storeu_ps(d + n + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), reduce));
+			_mm256_storeu_ps(d + n + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), reduce));
+		}
+		_mm256_zeroupper();
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt16ToFloat32_sse(d + n, s + n, numsamples - n);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * float32→int16変換
+ */
+void PCMConvertLoopFloat32ToInt16_avx2(void * __restrict dest, const void * __restrict src, size_t numsamples)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const float * s = static_cast<const float*>(src);
+	size_t n = 0;
+
+	if(numsamples >= 16)
+	{
+		const __m256 magnify = _mm256_set1_ps(32767.0f);
+		SetRoundingModeToNearest_SSE();
+		for(     ; n < numsamples - 15; n += 16)
+		{
+			__m256i lo = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(s + n + 0), magnify));
+			__m256i hi = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(s + n + 8), magnify));
+			_mm_storeu_si128((__m128i *)(d + n + 0), PackInt32x8_avx2(lo));
+			_mm_storeu_si128((__m128i *)(d + n + 8), PackInt32x8_avx2(hi));
+		}
+		_mm256_zeroupper();
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopFloat32ToInt16_sse(d + n, s + n, numsamples - n);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * float32→int16変換 (TPDF ディザ付き)
+ * @param seed	乱数の種 (0 以外)
+ */
+void PCMConvertLoopFloat32ToInt16Dither_avx2(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 seed)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const float * s = static_cast<const float*>(src);
+	size_t n = 0;
+
+	if(numsamples >= 8)
+	{
+		// 各レーンの乱数の状態は seed から作る (0 にならないように下位ビットを立てる)
+		__m256i x = _mm256_or_si256(_mm256_xor_si256(_mm256_set1_epi32((int)seed),
+			_mm256_setr_epi32(0x9e3779b9, 0x3c6ef372, 0xdaa66d2b, 0x78dde6e4,
+				0x1715609d, 0xb54cda56, 0x5384540f, 0xf1bbcdc8)), _mm256_set1_epi32(1));
+		const __m256 magnify = _mm256_set1_ps(32767.0f);
+		SetRoundingModeToNearest_SSE();
+		for(     ; n < numsamples - 7; n += 8)
+		{
+			__m256 dither = _mm256_add_ps(DitherRand_avx2(x), DitherRand_avx2(x));
+			__m256i v = _mm256_cvtps_epi32(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_loadu_ps(s + n), magnify), dither));
+			_mm_storeu_si128((__m128i *)(d + n), PackInt32x8_avx2(v));
+		}
+		seed = (tjs_uint32)_mm_cvtsi128_si32(_mm256_castsi256_si128(x)) | 1;
+		_mm256_zeroupper();
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopFloat32ToInt16Dither(d + n, s + n, numsamples - n, seed);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * uint8→float32変換
+ */
+void PCMConvertLoopInt8ToFloat32_avx2(void * __restrict dest, const void * __restrict src, size_t numsamples)
+{
+	float * d = static_cast<float*>(dest);
+	const tjs_uint8 * s = static_cast<const tjs_uint8*>(src);
+	size_t n = 0;
+
+	if(numsamples >= 16)
+	{
+		const __m256i bias = _mm256_set1_epi32(0x80);
+		const __m256 reduce = _mm256_set1_ps(1.0f/128.0f);
+		for(     ; n < numsamples - 15; n += 16)
+		{
+			__m256i lo = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const*)(s + n + 0))), bias);
+			__m256i hi = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const*)(s + n + 8))), bias);
+			_mm256_storeu_ps(d + n + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), reduce));
+			_mm256_storeu_ps(d + n + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), reduce));
+		}
+		_mm256_zeroupper();
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt8ToFloat32(d + n, s + n, numsamples - n);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int24→float32変換
+ * @param mask	有効ビットのマスク (24bit 値に対するもの)
+ */
+void PCMConvertLoopInt24ToFloat32_avx2(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask)
+{
+	float * d = static_cast<float*>(dest);
+	const tjs_uint8 * s = static_cast<const tjs_uint8*>(src);
+	size_t n = 0;
+
+	// 最後の 4 バイトを越えて読まないようにする
+	if(numsamples >= 10)
+	{
+		// 8bit 左シフトした値で処理するので、1/2^31 倍すれば良い
+		const __m256i m = _mm256_set1_epi32((int)(mask << 8));
+		const __m256 reduce = _mm256_set1_ps(1.0f/2147483648.0f);
+		for(     ; n < numsamples - 9; n += 8)
+		{
+			__m256i v = _mm256_and_si256(LoadInt24x8_avx2(s + n*3), m);
+			_mm256_storeu_ps(d + n, _mm256_mul_ps(_mm256_cvtepi32_ps(v), reduce));
+		}
+		_mm256_zeroupper();
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt24ToFloat32(d + n, s + n*3, numsamples - n, mask);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int32→float32変換
+ * @param mask	有効ビットのマスク
+ */
+void PCMConvertLoopInt32ToFloat32_avx2(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask)
+{
+	float * d = static_cast<float*>(dest);
+	const tjs_int32 * s = static_cast<const tjs_int32*>(src);
+	size_t n = 0;
+
+	if(numsamples >= 16)
+	{
+		const __m256i m = _mm256_set1_epi32((int)mask);
+		const __m256 reduce = _mm256_set1_ps(1.0f/2147483648.0f);
+		for(     ; n < numsamples - 15; n += 16)
+		{
+			__m256i lo = _mm256_and_si256(_mm256_loadu_si256((__m256i const*)(s + n + 0)), m);
+			__m256i hi = _mm256_and_si256(_mm256_loadu_si256((__m256i const*)(s + n + 8)), m);
+			_mm256_storeu_ps(d + n + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), reduce));
+			_mm256_storeu_ps(d + n + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), reduce));
+		}
+		_mm256_zeroupper();
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt32ToFloat32(d + n, s + n, numsamples - n, mask);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * uint8→int16変換
+ */
+void PCMConvertLoopInt8ToInt16_avx2(void * __restrict dest, const void * __restrict src, size_t numsamples)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const tjs_uint8 * s = static_cast<const tjs_uint8*>(src);
+	size_t n = 0;
+
+	if(numsamples >= 16)
+	{
+		const __m256i bias = _mm256_set1_epi16(0x80);
+		for(     ; n < numsamples - 15; n += 16)
+		{
+			__m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const*)(s + n)));
+			_mm256_storeu_si256((__m256i *)(d + n), _mm256_slli_epi16(_mm256_sub_epi16(v, bias), 8));
+		}
+		_mm256_zeroupper();
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt8ToInt16(d + n, s + n, numsamples - n);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int24→int16変換
+ * @param mask	有効ビットのマスク (24bit 値に対するもの)
+ */
+void PCMConvertLoopInt24ToInt16_avx2(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const tjs_uint8 * s = static_cast<const tjs_uint8*>(src);
+	size_t n = 0;
+
+	// 最後の 4 バイトを越えて読まないようにする
+	if(numsamples >= 10)
+	{
+		const __m256i m = _mm256_set1_epi32((int)(mask << 8));
+		for(     ; n < numsamples - 9; n += 8)
+		{
+			__m256i v = _mm256_srai_epi32(_mm256_and_si256(LoadInt24x8_avx2(s + n*3), m), 16);
+			_mm_storeu_si128((__m128i *)(d + n), PackInt32x8_avx2(v));
+		}
+		_mm256_zeroupper();
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt24ToInt16(d + n, s + n*3, numsamples - n, mask);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int32→int16変換
+ * @param mask	有効ビットのマスク
+ */
+void PCMConvertLoopInt32ToInt16_avx2(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const tjs_int32 * s = static_cast<const tjs_int32*>(src);
+	size_t n = 0;
+
+	if(numsamples >= 16)
+	{
+		const __m256i m = _mm256_set1_epi32((int)mask);
+		for(     ; n < numsamples - 15; n += 16)
+		{
+			__m256i lo = _mm256_srai_epi32(_mm256_and_si256(_mm256_loadu_si256((__m256i const*)(s + n + 0)), m), 16);
+			__m256i hi = _mm256_srai_epi32(_mm256_and_si256(_mm256_loadu_si256((__m256i const*)(s + n + 8)), m), 16);
+			// packs は 128bit レーンごとに働くので、64bit 単位で並べ直す
+			_mm256_storeu_si256((__m256i *)(d + n),
+				_mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3,1,2,0)));
+		}
+		_mm256_zeroupper();
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt32ToInt16(d + n, s + n, numsamples - n, mask);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int16 ステレオ→モノラル ダウンミックス
+ * @note	dest は src と同じでもよい
+ */
+void PCMDownmixLoopInt16Stereo_avx2(void * dest, const void * src, size_t numframes)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const tjs_int16 * s = static_cast<const tjs_int16*>(src);
+	size_t n = 0;
+
+	if(numframes >= 16)
+	{
+		const __m256i one = _mm256_set1_epi16(1);
+		for(     ; n < numframes - 15; n += 16)
+		{
+			// L+R を 32bit で求め、0 方向への切り捨てで 2 で割る
+			__m256i lo = _mm256_madd_epi16(_mm256_loadu_si256((__m256i const*)(s + n*2 +  0)), one);
+			__m256i hi = _mm256_madd_epi16(_mm256_loadu_si256((__m256i const*)(s + n*2 + 16)), one);
+			lo = _mm256_srai_epi32(_mm256_add_epi32(lo, _mm256_srli_epi32(lo, 31)), 1);
+			hi = _mm256_srai_epi32(_mm256_add_epi32(hi, _mm256_srli_epi32(hi, 31)), 1);
+			_mm256_storeu_si256((__m256i *)(d + n),
+				_mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3,1,2,0)));
+		}
+		_mm256_zeroupper();
+	}
+
+	// のこり
+	if(n < numframes)
+		PCMDownmixLoopInt16Stereo(d + n, s + n*2, numframes - n);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * float32 ステレオ→モノラル ダウンミックス
+ * @note	dest は src と同じでもよい
+ */
+void PCMDownmixLoopFloat32Stereo_avx2(void * dest, const void * src, size_t numframes)
+{
+	float * d = static_cast<float*>(dest);
+	const float * s = static_cast<const float*>(src);
+	size_t n = 0;
+
+	if(numframes >= 8)
+	{
+		const __m256 half = _mm256_set1_ps(0.5f);
+		for(     ; n < numframes - 7; n += 8)
+		{
+			__m256 a = _mm256_loadu_ps(s + n*2 + 0); // L0 R0 L1 R1 | L2 R2 L3 R3
+			__m256 b = _mm256_loadu_ps(s + n*2 + 8); // L4 R4 L5 R5 | L6 R6 L7 R7
+			__m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)); // L0 L1 L4 L5 | L2 L3 L6 L7
+			__m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+			__m256 m = _mm256_mul_ps(_mm256_add_ps(l, r), half);
+			_mm256_storeu_ps(d + n, _mm256_castpd_ps(_mm256_permute4x64_pd(
+				_mm256_castps_pd(m), _MM_SHUFFLE(3,1,2,0))));
+		}
+		_mm256_zeroupper();
+	}
+
+	// のこり
+	if(n < numframes)
+		PCMDownmixLoopFloat32Stereo(d + n, s + n*2, numframes - n);
+}
+//---------------------------------------------------------------------------
+#endif
@@ -15,6 +15,19 @@
 #include "MathAlgorithms.h"
 #if defined(_M_IX86)||defined(_M_X64)
 //---------------------------------------------------------------------------
+// 端数の処理に使う C 版の関数 (WaveFormatConverter.cpp 内)
+//---------------------------------------------------------------------------
+extern void PCMConvertLoopFloat32ToInt16Dither(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 seed);
+extern void PCMConvertLoopInt8ToFloat32(void * __restrict dest, const void * __restrict src, size_t numsamples);
+extern void PCMConvertLoopInt24ToFloat32(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask);
+extern void PCMConvertLoopInt32ToFloat32(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask);
+extern void PCMConvertLoopInt8ToInt16(void * __restrict dest, const void * __restrict src, size_t numsamples);
+extern void PCMConvertLoopInt24ToInt16(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask);
+extern void PCMConvertLoopInt32ToInt16(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask);
+extern void PCMDownmixLoopInt16Stereo(void * dest, const void * src, size_t numframes);
+extern void PCMDownmixLoopFloat32Stereo(void * dest, const void * src, size_t numframes);
+//---------------------------------------------------------------------------
+
 
 _ALIGN16(const float) TJS_V_VEC_REDUCE[4] =
 	{ 1.0f/32767.0f, 1.0f/32767.0f, 1.0f/32767.0f, 1.0f/32767.0f };
@@ -38,7 +51,7 @@ static inline void Int16ToFloat32_sse41( float * d, const tjs_int16 * s ) {
 static inline void Float32ToInt16_sse2( tjs_uint16 * d, const float * s ) {
 	__m128i mlo = _mm_cvtps_epi32( _mm_mul_ps( *(__m128*)(s + 0), PM128(TJS_V_VEC_MAGNIFY) ) );
 	__m128i mhi = _mm_cvtps_epi32( _mm_mul_ps( *(__m128*)(s + 4), PM128(TJS_V_VEC_MAGNIFY) ) );
-	_mm_store_si128( (__m128i *)d, _mm_packs_epi32(mlo, mlo) );
+	_mm_storeu_si128( (__m128i *)d, _mm_packs_epi32(mlo, mhi) );
 }
 #ifdef TJS_64BIT_OS
 // 64bit の時は MMX を使わず、SSE2/SSE で処理
@@ -150,4 +163,327 @@ void PCMConvertLoopFloat32ToInt16_sse(void * __restrict dest, const void * __res
 	}
 }
 //---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// 以下は SSE2 を必要とする
+//---------------------------------------------------------------------------
+_ALIGN16(const float) TJS_V_VEC_REDUCE_8BIT[4] =
+	{ 1.0f/128.0f, 1.0f/128.0f, 1.0f/128.0f, 1.0f/128.0f };
+_ALIGN16(const float) TJS_V_VEC_REDUCE_32BIT[4] =
+	{ 1.0f/2147483648.0f, 1.0f/2147483648.0f, 1.0f/2147483648.0f, 1.0f/2147483648.0f };
+_ALIGN16(const float) TJS_V_VEC_HALF[4] =
+	{ 0.5f, 0.5f, 0.5f, 0.5f };
+_ALIGN16(const float) TJS_V_VEC_ONE_HALF[4] =
+	{ 1.5f, 1.5f, 1.5f, 1.5f };
+_ALIGN16(const tjs_uint32) TJS_V_VEC_FLOAT_ONE[4] =
+	{ 0x3f800000, 0x3f800000, 0x3f800000, 0x3f800000 };
+_ALIGN16(const tjs_uint32) TJS_V_VEC_DITHER_SEED[4] =
+	{ 0x9e3779b9, 0x3c6ef372, 0xdaa66d2b, 0x78dde6e4 };
+
+/**
+ * 24bit 値を 4 つ読み込み、それぞれを 8bit 左シフトした int32 として返す
+ * (s から 16 バイトを読み込むので注意)
+ */
+static inline __m128i LoadInt24x4_sse2( const tjs_uint8 * s ) {
+	__m128i v  = _mm_loadu_si128((__m128i const*)s);
+	__m128i v01 = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3)); // s0 s1 ? ?
+	__m128i v23 = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9)); // s2 s3 ? ?
+	return _mm_slli_epi32(_mm_unpacklo_epi64(v01, v23), 8);
+}
+
+/**
+ * xorshift32 による -0.5 ～ +0.5 の一様乱数 (4並列)
+ */
+static inline __m128 DitherRand_sse2( __m128i & x ) {
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+	__m128 f = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(x, 9), PM128I(TJS_V_VEC_FLOAT_ONE)));
+	return _mm_sub_ps(f, PM128(TJS_V_VEC_ONE_HALF));
+}
+
+//---------------------------------------------------------------------------
+/**
+ * float32→int16変換 (TPDF ディザ付き)
+ * @param seed	乱数の種 (0 以外)
+ */
+void PCMConvertLoopFloat32ToInt16Dither_sse2(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 seed)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const float * s = static_cast<const float*>(src);
+	size_t n = 0;
+
+	if(numsamples >= 8)
+	{
+		// 各レーンの乱数の状態は seed から作る (0 にならないように下位ビットを立てる)
+		__m128i x = _mm_or_si128(_mm_xor_si128(_mm_set1_epi32((int)seed),
+			PM128I(TJS_V_VEC_DITHER_SEED)), _mm_set1_epi32(1));
+		SetRoundingModeToNearest_SSE();
+		for(     ; n < numsamples - 7; n += 8)
+		{
+			__m128 dlo = _mm_add_ps(DitherRand_sse2(x), DitherRand_sse2(x));
+			__m128 dhi = _mm_add_ps(DitherRand_sse2(x), DitherRand_sse2(x));
+			__m128i mlo = _mm_cvtps_epi32( _mm_add_ps(
+				_mm_mul_ps( _mm_loadu_ps(s + n + 0), PM128(TJS_V_VEC_MAGNIFY) ), dlo) );
+			__m128i mhi = _mm_cvtps_epi32( _mm_add_ps(
+				_mm_mul_ps( _mm_loadu_ps(s + n + 4), PM128(TJS_V_VEC_MAGNIFY) ), dhi) );
+			_mm_storeu_si128( (__m128i *)(d + n), _mm_packs_epi32(mlo, mhi) );
+		}
+		seed = (tjs_uint32)_mm_cvtsi128_si32(x) | 1;
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopFloat32ToInt16Dither(d + n, s + n, numsamples - n, seed);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * uint8→float32変換
+ */
+void PCMConvertLoopInt8ToFloat32_sse2(void * __restrict dest, const void * __restrict src, size_t numsamples)
+{
+	float * d = static_cast<float*>(dest);
+	const tjs_uint8 * s = static_cast<const tjs_uint8*>(src);
+	size_t n = 0;
+
+	if(numsamples >= 16)
+	{
+		const __m128i bias = _mm_set1_epi8((char)0x80);
+		for(     ; n < numsamples - 15; n += 16)
+		{
+			// 符号反転で signed に直し、上位バイトへ置いてから算術シフトで符号拡張する
+			__m128i v = _mm_xor_si128(_mm_loadu_si128((__m128i const*)(s + n)), bias);
+			__m128i lo = _mm_unpacklo_epi8(_mm_setzero_si128(), v);
+			__m128i hi = _mm_unpackhi_epi8(_mm_setzero_si128(), v);
+			_mm_storeu_ps(d + n +  0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(
+				_mm_unpacklo_epi16(_mm_setzero_si128(), lo), 24)), PM128(TJS_V_VEC_REDUCE_8BIT)));
+			_mm_storeu_ps(d + n +  4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(
+				_mm_unpackhi_epi16(_mm_setzero_si128(), lo), 24)), PM128(TJS_V_VEC_REDUCE_8BIT)));
+			_mm_storeu_ps(d + n +  8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(
+				_mm_unpacklo_epi16(_mm_setzero_si128(), hi), 24)), PM128(TJS_V_VEC_REDUCE_8BIT)));
+			_mm_storeu_ps(d + n + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(
+				_mm_unpackhi_epi16(_mm_setzero_si128(), hi), 24)), PM128(TJS_V_VEC_REDUCE_8BIT)));
+		}
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt8ToFloat32(d + n, s + n, numsamples - n);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int24→float32変換
+ * @param mask	有効ビットのマスク (24bit 値に対するもの)
+ */
+void PCMConvertLoopInt24ToFloat32_sse2(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask)
+{
+	float * d = static_cast<float*>(dest);
+	const tjs_uint8 * s = static_cast<const tjs_uint8*>(src);
+	size_t n = 0;
+
+	// 16 バイト単位で読むので、最後の 4 バイトを越えて読まないようにする
+	if(numsamples >= 10)
+	{
+		// 8bit 左シフトした値で処理するので、1/2^31 倍すれば良い
+		const __m128i m = _mm_set1_epi32((int)(mask << 8));
+		for(     ; n < numsamples - 9; n += 8)
+		{
+			__m128i lo = _mm_and_si128(LoadInt24x4_sse2(s + n*3 +  0), m);
+			__m128i hi = _mm_and_si128(LoadInt24x4_sse2(s + n*3 + 12), m);
+			_mm_storeu_ps(d + n + 0, _mm_mul_ps(_mm_cvtepi32_ps(lo), PM128(TJS_V_VEC_REDUCE_32BIT)));
+			_mm_storeu_ps(d + n + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), PM128(TJS_V_VEC_REDUCE_32BIT)));
+		}
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt24ToFloat32(d + n, s + n*3, numsamples - n, mask);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int32→float32変換
+ * @param mask	有効ビットのマスク
+ */
+void PCMConvertLoopInt32ToFloat32_sse2(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask)
+{
+	float * d = static_cast<float*>(dest);
+	const tjs_int32 * s = static_cast<const tjs_int32*>(src);
+	size_t n = 0;
+
+	if(numsamples >= 8)
+	{
+		const __m128i m = _mm_set1_epi32((int)mask);
+		for(     ; n < numsamples - 7; n += 8)
+		{
+			__m128i lo = _mm_and_si128(_mm_loadu_si128((__m128i const*)(s + n + 0)), m);
+			__m128i hi = _mm_and_si128(_mm_loadu_si128((__m128i const*)(s + n + 4)), m);
+			_mm_storeu_ps(d + n + 0, _mm_mul_ps(_mm_cvtepi32_ps(lo), PM128(TJS_V_VEC_REDUCE_32BIT)));
+			_mm_storeu_ps(d + n + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), PM128(TJS_V_VEC_REDUCE_32BIT)));
+		}
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt32ToFloat32(d + n, s + n, numsamples - n, mask);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * uint8→int16変換
+ */
+void PCMConvertLoopInt8ToInt16_sse2(void * __restrict dest, const void * __restrict src, size_t numsamples)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const tjs_uint8 * s = static_cast<const tjs_uint8*>(src);
+	size_t n = 0;
+
+	if(numsamples >= 16)
+	{
+		const __m128i bias = _mm_set1_epi8((char)0x80);
+		for(     ; n < numsamples - 15; n += 16)
+		{
+			// 符号反転した値を上位バイトに置けば、そのまま 256 倍した int16 になる
+			__m128i v = _mm_xor_si128(_mm_loadu_si128((__m128i const*)(s + n)), bias);
+			_mm_storeu_si128((__m128i *)(d + n + 0), _mm_unpacklo_epi8(_mm_setzero_si128(), v));
+			_mm_storeu_si128((__m128i *)(d + n + 8), _mm_unpackhi_epi8(_mm_setzero_si128(), v));
+		}
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt8ToInt16(d + n, s + n, numsamples - n);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int24→int16変換
+ * @param mask	有効ビットのマスク (24bit 値に対するもの)
+ */
+void PCMConvertLoopInt24ToInt16_sse2(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const tjs_uint8 * s = static_cast<const tjs_uint8*>(src);
+	size_t n = 0;
+
+	// 16 バイト単位で読むので、最後の 4 バイトを越えて読まないようにする
+	if(numsamples >= 10)
+	{
+		const __m128i m = _mm_set1_epi32((int)(mask << 8));
+		for(     ; n < numsamples - 9; n += 8)
+		{
+			__m128i lo = _mm_srai_epi32(_mm_and_si128(LoadInt24x4_sse2(s + n*3 +  0), m), 16);
+			__m128i hi = _mm_srai_epi32(_mm_and_si128(LoadInt24x4_sse2(s + n*3 + 12), m), 16);
+			_mm_storeu_si128((__m128i *)(d + n), _mm_packs_epi32(lo, hi));
+		}
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt24ToInt16(d + n, s + n*3, numsamples - n, mask);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int32→int16変換
+ * @param mask	有効ビットのマスク
+ */
+void PCMConvertLoopInt32ToInt16_sse2(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const tjs_int32 * s = static_cast<const tjs_int32*>(src);
+	size_t n = 0;
+
+	if(numsamples >= 8)
+	{
+		const __m128i m = _mm_set1_epi32((int)mask);
+		for(     ; n < numsamples - 7; n += 8)
+		{
+			__m128i lo = _mm_srai_epi32(_mm_and_si128(_mm_loadu_si128((__m128i const*)(s + n + 0)), m), 16);
+			__m128i hi = _mm_srai_epi32(_mm_and_si128(_mm_loadu_si128((__m128i const*)(s + n + 4)), m), 16);
+			_mm_storeu_si128((__m128i *)(d + n), _mm_packs_epi32(lo, hi));
+		}
+	}
+
+	// のこり
+	if(n < numsamples)
+		PCMConvertLoopInt32ToInt16(d + n, s + n, numsamples - n, mask);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * int16 ステレオ→モノラル ダウンミックス
+ * @note	dest は src と同じでもよい
+ */
+void PCMDownmixLoopInt16Stereo_sse2(void * dest, const void * src, size_t numframes)
+{
+	tjs_int16 * d = static_cast<tjs_int16*>(dest);
+	const tjs_int16 * s = static_cast<const tjs_int16*>(src);
+	size_t n = 0;
+
+	if(numframes >= 8)
+	{
+		const __m128i one = _mm_set1_epi16(1);
+		for(     ; n < numframes - 7; n += 8)
+		{
+			// L+R を 32bit で求め、0 方向への切り捨てで 2 で割る
+			__m128i lo = _mm_madd_epi16(_mm_loadu_si128((__m128i const*)(s + n*2 + 0)), one);
+			__m128i hi = _mm_madd_epi16(_mm_loadu_si128((__m128i const*)(s + n*2 + 8)), one);
+			lo = _mm_srai_epi32(_mm_add_epi32(lo, _mm_srli_epi32(lo, 31)), 1);
+			hi = _mm_srai_epi32(_mm_add_epi32(hi, _mm_srli_epi32(hi, 31)), 1);
+			_mm_storeu_si128((__m128i *)(d + n), _mm_packs_epi32(lo, hi));
+		}
+	}
+
+	// のこり
+	if(n < numframes)
+		PCMDownmixLoopInt16Stereo(d + n, s + n*2, numframes - n);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+/**
+ * float32 ステレオ→モノラル ダウンミックス
+ * @note	dest は src と同じでもよい
+ */
+void PCMDownmixLoopFloat32Stereo_sse2(void * dest, const void * src, size_t numframes)
+{
+	float * d = static_cast<float*>(dest);
+	const float * s = static_cast<const float*>(src);
+	size_t n = 0;
+
+	if(numframes >= 4)
+	{
+		for(     ; n < numframes - 3; n += 4)
+		{
+			__m128 a = _mm_loadu_ps(s + n*2 + 0); // L0 R0 L1 R1
+			__m128 b = _mm_loadu_ps(s + n*2 + 4); // L2 R2 L3 R3
+			__m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+			__m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+			_mm_storeu_ps(d + n, _mm_mul_ps(_mm_add_ps(l, r), PM128(TJS_V_VEC_HALF)));
+		}
+	}
+
+	// のこり
+	if(n < numframes)
+		PCMDownmixLoopFloat32Stereo(d + n, s + n*2, numframes - n);
+}
+//---------------------------------------------------------------------------
 #endif
@@ -18,6 +18,8 @@
 #include "UtilStreams.h"
 #include "WaveLoopManager.h"
 #include "tjsDictionary.h"
+#include "tjsHashSearch.h"
+#include "SysInitIntf.h"
 
 
 //---------------------------------------------------------------------------
@@ -83,17 +85,136 @@ tjs_uint8 TVP_GUID_KSDATAFORMAT_SUBTYPE_IEEE_FLOAT[16] =
 //---------------------------------------------------------------------------
 // CPU specific optimized routine prototypes
 //---------------------------------------------------------------------------
-extern void PCMConvertLoopInt16ToFloat32(void * __restrict dest, const void * __restrict src, size_t numsamples);
-extern void PCMConvertLoopFloat32ToInt16(void * __restrict dest, const void * __restrict src, size_t numsamples);
+#define TVP_PCM_CONVERT_PROTO(suffix) \
+	extern void PCMConvertLoopInt16ToFloat32##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples); \
+	extern void PCMConvertLoopFloat32ToInt16##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples); \
+	extern void PCMConvertLoopFloat32ToInt16Dither##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 seed); \
+	extern void PCMConvertLoopInt8ToFloat32##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples); \
+	extern void PCMConvertLoopInt24ToFloat32##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask); \
+	extern void PCMConvertLoopInt32ToFloat32##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask); \
+	extern void PCMConvertLoopInt8ToInt16##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples); \
+	extern void PCMConvertLoopInt24ToInt16##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask); \
+	extern void PCMConvertLoopInt32ToInt16##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask); \
+	extern void PCMDownmixLoopInt16Stereo##suffix(void * dest, const void * src, size_t numframes); \
+	extern void PCMDownmixLoopFloat32Stereo##suffix(void * dest, const void * src, size_t numframes);
+
+TVP_PCM_CONVERT_PROTO()
 #if defined(_M_IX86)||defined(_M_X64)
 extern void PCMConvertLoopInt16ToFloat32_sse(void * __restrict dest, const void * __restrict src, size_t numsamples);
 extern void PCMConvertLoopFloat32ToInt16_sse(void * __restrict dest, const void * __restrict src, size_t numsamples);
+TVP_PCM_CONVERT_PROTO(_sse2)
+TVP_PCM_CONVERT_PROTO(_avx2)
 #endif
+#undef TVP_PCM_CONVERT_PROTO
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// PCM convertion function table
+//---------------------------------------------------------------------------
+// the table is filled with the C versions first and then overwritten by the
+// fastest versions the CPU supports. every entry is always a valid function,
+// so the table can be read from any thread while it is being initialized.
+struct tTVPPCMConvertFunctions
+{
+	void (*Int16ToFloat32)(void * __restrict dest, const void * __restrict src, size_t numsamples);
+	void (*Float32ToInt16)(void * __restrict dest, const void * __restrict src, size_t numsamples);
+	void (*Float32ToInt16Dither)(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 seed);
+	void (*Int8ToFloat32)(void * __restrict dest, const void * __restrict src, size_t numsamples);
+	void (*Int24ToFloat32)(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask);
+	void (*Int32ToFloat32)(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask);
+	void (*Int8ToInt16)(void * __restrict dest, const void * __restrict src, size_t numsamples);
+	void (*Int24ToInt16)(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask);
+	void (*Int32ToInt16)(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask);
+	void (*DownmixInt16Stereo)(void * dest, const void * src, size_t numframes);
+	void (*DownmixFloat32Stereo)(void * dest, const void * src, size_t numframes);
+};
+static tTVPPCMConvertFunctions TVPPCMConvert;
+static bool TVPPCMConvertInit = false;
+//---------------------------------------------------------------------------
+static void TVPInitPCMConvertFunctions()
+{
+	if(TVPPCMConvertInit) return;
+
+#define TVP_SET_PCM_CONVERT(suffix) \
+	TVPPCMConvert.Float32ToInt16Dither = PCMConvertLoopFloat32ToInt16Dither##suffix; \
+	TVPPCMConvert.Int8ToFloat32 = PCMConvertLoopInt8ToFloat32##suffix; \
+	TVPPCMConvert.Int24ToFloat32 = PCMConvertLoopInt24ToFloat32##suffix; \
+	TVPPCMConvert.Int32ToFloat32 = PCMConvertLoopInt32ToFloat32##suffix; \
+	TVPPCMConvert.Int8ToInt16 = PCMConvertLoopInt8ToInt16##suffix; \
+	TVPPCMConvert.Int24ToInt16 = PCMConvertLoopInt24ToInt16##suffix; \
+	TVPPCMConvert.Int32ToInt16 = PCMConvertLoopInt32ToInt16##suffix; \
+	TVPPCMConvert.DownmixInt16Stereo = PCMDownmixLoopInt16Stereo##suffix; \
+	TVPPCMConvert.DownmixFloat32Stereo = PCMDownmixLoopFloat32Stereo##suffix;
+
+	TVPPCMConvert.Int16ToFloat32 = PCMConvertLoopInt16ToFloat32;
+	TVPPCMConvert.Float32ToInt16 = PCMConvertLoopFloat32ToInt16;
+	TVP_SET_PCM_CONVERT()
+
+#if defined(_M_IX86)||defined(_M_X64)
+	if((TVPCPUType & TVP_CPU_HAS_MMX) &&
+		(TVPCPUType & TVP_CPU_HAS_SSE) &&
+		(TVPCPUType & TVP_CPU_HAS_CMOV))
+	{
+		TVPPCMConvert.Int16ToFloat32 = PCMConvertLoopInt16ToFloat32_sse;
+		TVPPCMConvert.Float32ToInt16 = PCMConvertLoopFloat32ToInt16_sse;
+
+		if(TVPCPUType & TVP_CPU_HAS_SSE2)
+		{
+			TVP_SET_PCM_CONVERT(_sse2)
+
+			if((TVPCPUType & TVP_CPU_HAS_AVX) && (TVPCPUType & TVP_CPU_HAS_AVX2))
+			{
+				TVPPCMConvert.Int16ToFloat32 = PCMConvertLoopInt16ToFloat32_avx2;
+				TVPPCMConvert.Float32ToInt16 = PCMConvertLoopFloat32ToInt16_avx2;
+				TVP_SET_PCM_CONVERT(_avx2)
+			}
+		}
+	}
+#endif
+
+#undef TVP_SET_PCM_CONVERT
+
+	TVPPCMConvertInit = true;
+}
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// dither
+//---------------------------------------------------------------------------
+static bool TVPPCMConvertDither = false;
+static tjs_uint32 TVPPCMDitherSeed = 0x2545f491;
+//---------------------------------------------------------------------------
+void TVPSetPCMConvertDither(bool b)
+{
+	TVPPCMConvertDither = b;
+}
+//---------------------------------------------------------------------------
+bool TVPGetPCMConvertDither()
+{
+	return TVPPCMConvertDither;
+}
+//---------------------------------------------------------------------------
+static tjs_uint32 TVPGetPCMDitherSeed()
+{
+	// the seed is not protected from other threads; a race only yields the
+	// same noise sequence twice, which is harmless.
+	TVPPCMDitherSeed = TVPPCMDitherSeed * 1664525 + 1013904223;
+	return TVPPCMDitherSeed | 1;
+}
+//---------------------------------------------------------------------------
+
 
 
 //---------------------------------------------------------------------------
 // Wave format convertion routines
 //---------------------------------------------------------------------------
+#define TVP_PCM_DOWNMIX_BUFFER_SAMPLES 4096
+	// size of the temporary buffer used by downmixing, in samples
+//---------------------------------------------------------------------------
 static void TVPConvertFloatPCMTo16bits(tjs_int16 *output, const float *input,
 	tjs_int channels, tjs_int count, bool downmix)
 {
@@ -102,189 +223,130 @@ static void TVPConvertFloatPCMTo16bits(tjs_int16 *output, const float *input,
 	// float PCM is in range of +1.0 ... 0 ... -1.0
 	// clip sample which is out of the range.
 
-	if(!downmix)
+	if(!downmix || channels == 1)
 	{
 		tjs_int total = channels * count;
-#if defined(_M_IX86)||defined(_M_X64)
-		bool use_sse =
-				(TVPCPUType & TVP_CPU_HAS_MMX) &&
-				(TVPCPUType & TVP_CPU_HAS_SSE) &&
-				(TVPCPUType & TVP_CPU_HAS_CMOV);
-
-		if(use_sse)
-			PCMConvertLoopFloat32ToInt16_sse(output, input, total);
+		if(TVPPCMConvertDither)
+			TVPPCMConvert.Float32ToInt16Dither(output, input, total, TVPGetPCMDitherSeed());
 		else
-			PCMConvertLoopFloat32ToInt16(output, input, total);
-#else
-		PCMConvertLoopFloat32ToInt16(output, input, total);
-#endif
+			TVPPCMConvert.Float32ToInt16(output, input, total);
 	}
 	else
 	{
-		float nc = 32768.0f / (float)channels;
-		while(count--)
+		// mix all channels down to monaural float, then convert it to 16bit
+		float buf[TVP_PCM_DOWNMIX_BUFFER_SAMPLES];
+		tjs_int unit = TVP_PCM_DOWNMIX_BUFFER_SAMPLES / channels;
+		if(unit > TVP_PCM_DOWNMIX_BUFFER_SAMPLES / 2) unit = TVP_PCM_DOWNMIX_BUFFER_SAMPLES / 2;
+		while(count > 0)
 		{
-			tjs_int n = channels;
-			float t = 0;
-			while(n--) t += *(input++) * nc;
-			if(t > 0)
+			tjs_int one = count < unit ? count : unit;
+			if(channels == 2)
 			{
-				int i = (int)(t + 0.5);
-				if(i > 32767) i = 32767;
-				*(output++) = (tjs_int16)i;
+				TVPPCMConvert.DownmixFloat32Stereo(buf, input, one);
 			}
 			else
 			{
-				int i = (int)(t - 0.5);
-				if(i < -32768) i = -32768;
-				*(output++) = (tjs_int16)i;
+				float nc = 1.0f / (float)channels;
+				const float *p = input;
+				for(tjs_int i = 0; i < one; i++)
+				{
+					tjs_int n = channels;
+					float t = 0;
+					while(n--) t += *(p++);
+					buf[i] = t * nc;
+				}
 			}
+
+			if(TVPPCMConvertDither)
+				TVPPCMConvert.Float32ToInt16Dither(output, buf, one, TVPGetPCMDitherSeed());
+			else
+				TVPPCMConvert.Float32ToInt16(output, buf, one);
+
+			input += one * channels;
+			output += one;
+			count -= one;
 		}
 	}
 }
 //---------------------------------------------------------------------------
-static void TVPConvertIntegerPCMTo16bits(tjs_int16 *output, const void *input,
-	tjs_int bytespersample,
-	tjs_int validbits, tjs_int channels, tjs_int count, bool downmix)
+static void TVPConvertIntegerPCMTo16bitsNoDownmix(tjs_int16 *output,
+	const void *input, tjs_int bytespersample, tjs_int validbits, tjs_int total)
 {
-	// convert integer PCMs to 16bit integer PCM
-#define PROCESS_BY_CHANNELS \
-	switch(channels) \
-	{ \
-	case 2: PROCESS(2); break; \
-	case 4: PROCESS(4); break; \
-	case 8: PROCESS(8); break; \
-	default: PROCESS(channels); break; \
-	}
-
-
-#if TJS_HOST_IS_BIG_ENDIAN
-	#define GET_24BIT(p) (p[2] + (p[1] << 8) + (p[0] << 16))
-#else
-	#define GET_24BIT(p) (p[0] + (p[1] << 8) + (p[2] << 16))
-#endif
-
+	// convert integer PCMs to 16bit integer PCM, without downmixing
 	if(bytespersample == 1)
 	{
 		// here assumes that the input 8bit PCM has always 8bit valid data
-		const tjs_int8 *p = (tjs_int8 *)input;
-		if(!downmix || channels == 1)
-		{
-			tjs_int total = channels * count;
-			while(total--)
-				*(output++) = (tjs_int16)( ((tjs_int)*(p++)-0x80) * 0x100);
-		}
-		else
-		{
-		#define PROCESS(channels) \
-			while(count--) \
-			{ \
-				tjs_int v = 0; \
-				tjs_int n = channels; \
-				while(n--) \
-					v += (tjs_int16)( ((tjs_int)*(p++)-0x80) * 0x100); \
-				v = v / channels; \
-				*(output++) = (tjs_int16)v; \
-			}
-		PROCESS_BY_CHANNELS
-		#undef PROCESS
-		}
+		TVPPCMConvert.Int8ToInt16(output, input, total);
 	}
 	else if(bytespersample == 2)
 	{
-		tjs_uint16 mask =  ~( (1 << (16 - validbits)) - 1);
-		const tjs_int16 *p = (const tjs_int16 *)input;
-		if(!downmix || channels == 1)
+		if(validbits == 16)
 		{
-			tjs_int total = channels * count;
-			while(total--) *(output++) = (tjs_int16)(*(p++) & mask);
+			memcpy(output, input, sizeof(tjs_int16) * total);
 		}
 		else
 		{
-		#define PROCESS(channels) \
-			while(count--) \
-			{ \
-				tjs_int v = 0; \
-				tjs_int n = channels; \
-				while(n--) \
-					v += (tjs_int16)(*(p++) & mask); \
-				v = v / channels; \
-				*(output++) = (tjs_int16)v; \
-			}
-		PROCESS_BY_CHANNELS
-		#undef PROCESS
+			tjs_uint16 mask =  ~( (1 << (16 - validbits)) - 1);
+			const tjs_int16 *p = (const tjs_int16 *)input;
+			while(total--) *(output++) = (tjs_int16)(*(p++) & mask);
 		}
 	}
 	else if(bytespersample == 3)
 	{
 		tjs_uint32 mask = ~( (1 << (24 - validbits)) - 1);
-		const tjs_uint8 *p = (const tjs_uint8 *)input;
-
-		if(!downmix || channels == 1)
-		{
-			tjs_int total = channels * count;
-			while(total--)
-			{
-				tjs_int32 t = GET_24BIT(p);
-				p += 3;
-				t |= -(t&0x800000); // extend sign
-				t &= mask; // apply mask
-				t >>= 8;
-				*(output++) = (tjs_int16)t;
-			}
-		}
-		else
-		{
-		#define PROCESS(channels) \
-			while(count--) \
-			{ \
-				tjs_int v = 0; \
-				tjs_int n = channels; \
-				while(n--) \
-				{ \
-					tjs_int32 t = GET_24BIT(p); \
-					p += 3; \
-					t |= -(t&0x800000); \
-					t &= mask; \
-					t >>= 8; \
-					v += t; \
-				} \
-				v = v / channels; \
-				*(output++) = (tjs_int16)v; \
-			}
-		PROCESS_BY_CHANNELS
-		#undef PROCESS
-		}
+		TVPPCMConvert.Int24ToInt16(output, input, total, mask);
 	}
 	else if(bytespersample == 4)
 	{
-		tjs_int32 mask = ~( (1 << (32 - validbits)) - 1);
-		const tjs_int32 *p = (const tjs_int32 *)input;
-		if(!downmix || channels == 1)
-		{
-			tjs_int total = channels * count;
-			while(total--)
-				*(output++) = (tjs_int16)((*(p++) & mask) >> 16);
-		}
-		else
+		tjs_uint32 mask = ~( (1 << (32 - validbits)) - 1);
+		TVPPCMConvert.Int32ToInt16(output, input, total, mask);
+	}
+}
+//---------------------------------------------------------------------------
+static void TVPConvertIntegerPCMTo16bits(tjs_int16 *output, const void *input,
+	tjs_int bytespersample,
+	tjs_int validbits, tjs_int channels, tjs_int count, bool downmix)
+{
+	// convert integer PCMs to 16bit integer PCM
+
+	if(!downmix || channels == 1)
+	{
+		TVPConvertIntegerPCMTo16bitsNoDownmix(output, input, bytespersample,
+			validbits, channels * count);
+	}
+	else
+	{
+		// convert to 16bit PCM first, then mix all channels down to monaural
+		tjs_int16 buf[TVP_PCM_DOWNMIX_BUFFER_SAMPLES];
+		tjs_int unit = TVP_PCM_DOWNMIX_BUFFER_SAMPLES / channels;
+		const tjs_uint8 *p = (const tjs_uint8 *)input;
+		while(count > 0)
 		{
-		#define PROCESS(channels) \
-			while(count--) \
-			{ \
-				tjs_int v = 0; \
-				tjs_int n = channels; \
-				while(n--) \
-					v += (tjs_int16)((*(p++) & mask) >> 16); \
-				v = v / channels; \
-				*(output++) = (tjs_int16)v; \
+			tjs_int one = count < unit ? count : unit;
+			TVPConvertIntegerPCMTo16bitsNoDownmix(buf, p, bytespersample,
+				validbits, one * channels);
+
+			if(channels == 2)
+			{
+				TVPPCMConvert.DownmixInt16Stereo(output, buf, one);
 			}
-		PROCESS_BY_CHANNELS
-		#undef PROCESS
+			else
+			{
+				const tjs_int16 *b = buf;
+				for(tjs_int i = 0; i < one; i++)
+				{
+					tjs_int v = 0;
+					tjs_int n = channels;
+					while(n--) v += *(b++);
+					output[i] = (tjs_int16)(v / channels);
+				}
+			}
+
+			p += one * channels * bytespersample;
+			output += one;
+			count -= one;
 		}
 	}
-
-#undef PROCESS_BY_CHANNELS
-#undef GET_24BIT
 }
 //---------------------------------------------------------------------------
 void TVPConvertPCMTo16bits(tjs_int16 *output, const void *input,
@@ -293,6 +355,8 @@ void TVPConvertPCMTo16bits(tjs_int16 *output, const void *input,
 {
 	// cconvert specified format to 16bit PCM
 
+	TVPInitPCMConvertFunctions();
+
 	if(isfloat)
 		TVPConvertFloatPCMTo16bits(output, (const float *)input, channels, count, downmix);
 	else
@@ -327,75 +391,38 @@ static void TVPConvertIntegerPCMToFloat(float *output, const void *input,
 {
 	// convert integer PCMs to float PCM
 
-#ifdef TJS_HOST_IS_BIG_ENDIAN
-	#undef TJS_HOST_IS_BIG_ENDIAN
-#endif
-#if TJS_HOST_IS_BIG_ENDIAN
-	#define GET_24BIT(p) (p[2] + (p[1] << 8) + (p[0] << 16))
-#else
-	#define GET_24BIT(p) (p[0] + (p[1] << 8) + (p[2] << 16))
-#endif
+	tjs_int total = channels * count;
 
 	if(bytespersample == 1)
 	{
 		// here assumes that the input 8bit PCM has always 8bit valid data
-		const tjs_int8 *p = (tjs_int8 *)input;
-		tjs_int total = channels * count;
-		while(total--)
-			*(output++) = (float)( ((tjs_int)*(p++)- 0x80) * (1.0 / 128) );
+		TVPPCMConvert.Int8ToFloat32(output, input, total);
 	}
 	else if(bytespersample == 2)
 	{
-		const tjs_int16 *p = (const tjs_int16 *)input;
-		tjs_int total = channels * count;
-
 		if(validbits == 16)
 		{
-#if defined(_M_IX86)||defined(_M_X64)
 			// most popular
-			bool use_sse =
-					(TVPCPUType & TVP_CPU_HAS_MMX) &&
-					(TVPCPUType & TVP_CPU_HAS_SSE) &&
-					(TVPCPUType & TVP_CPU_HAS_CMOV);
-
-			if(use_sse)
-				PCMConvertLoopInt16ToFloat32_sse(output, p, total);
-			else
-				PCMConvertLoopInt16ToFloat32(output, p, total);
-#else
-			PCMConvertLoopInt16ToFloat32(output, p, total);
-#endif
+			TVPPCMConvert.Int16ToFloat32(output, input, total);
 		}
 		else
 		{
 			// generic
 			tjs_uint16 mask =  ~( (1 << (16 - validbits)) - 1);
+			const tjs_int16 *p = (const tjs_int16 *)input;
 
-			while(total--) *(output++) = (float)((*(p++) & mask) * (1.0 / 32768));
+			while(total--) *(output++) = (float)((tjs_int16)(*(p++) & mask) * (1.0 / 32768));
 		}
 	}
 	else if(bytespersample == 3)
 	{
 		tjs_uint32 mask = ~( (1 << (24 - validbits)) - 1);
-		const tjs_uint8 *p = (const tjs_uint8 *)input;
-
-		tjs_int total = channels * count;
-		while(total--)
-		{
-			tjs_int32 t = GET_24BIT(p);
-			p += 3;
-			t |= -(t&0x800000); // extend sign
-			t &= mask; // apply mask
-			*(output++) = (float)(t * (1.0 / (1<<23)));
-		}
+		TVPPCMConvert.Int24ToFloat32(output, input, total, mask);
 	}
 	else if(bytespersample == 4)
 	{
-		tjs_int32 mask = ~( (1 << (32 - validbits)) - 1);
-		const tjs_int32 *p = (const tjs_int32 *)input;
-		tjs_int total = channels * count;
-		while(total--)
-			*(output++) = (float)(((*(p++) & mask) >> 0) * (1.0 / (1<<31)));
+		tjs_uint32 mask = ~( (1 << (32 - validbits)) - 1);
+		TVPPCMConvert.Int32ToFloat32(output, input, total, mask);
 	}
 }
 //---------------------------------------------------------------------------
@@ -405,6 +432,8 @@ void TVPConvertPCMToFloat(float *output, const void *input,
 {
 	// cconvert specified format to 16bit PCM
 
+	TVPInitPCMConvertFunctions();
+
 	if(isfloat)
 		TVPConvertFloatPCMToFloat(output, (const float *)input, channels, count);
 	else
@@ -778,7 +807,7 @@ void TVPUnregisterWaveDecoderCreator(tTVPWaveDecoderCreator *d)
 	}
 }
 //---------------------------------------------------------------------------
-tTVPWaveDecoder *  TVPCreateWaveDecoder(const ttstr & storagename)
+tTVPWaveDecoder * TVPCreateWaveDecoderFromCreators(const ttstr & storagename)
 {
 	// find a decoder and create its instance.
 	// throws an exception when the decodable decoder is not found.
@@ -803,6 +832,288 @@ tTVPWaveDecoder *  TVPCreateWaveDecoder(const ttstr & storagename)
 
 
 
+//---------------------------------------------------------------------------
+// decoded PCM cache
+//---------------------------------------------------------------------------
+/*
+	Short clips are decoded at once at their first open, and the decoded PCM
+	is kept in a byte-limited LRU cache keyed by the normalized storage name
+	and the PCM format its decoder gives. Further opens of the same storage
+	still create a decoder to learn the format (which reads only the header),
+	and are served from memory by tTVPWD_PCMCache without any decoding; the
+	PCM is shared read-only between the decoders. A storage which now gives
+	another format, eg. replaced or decoded by another decoder, is decoded
+	again. Storages which turned out not to be cacheable are remembered in a
+	small negative cache, so that they are not examined (or decoded in vain)
+	again at every open.
+*/
+class tTVPWavePCMCacheData
+{
+	tjs_int RefCount;
+
+public:
+	tTVPWaveFormat Format;
+	tjs_uint8 * Data;
+	tjs_uint Size; // in bytes
+
+	tTVPWavePCMCacheData() { RefCount = 1; Data = NULL; Size = 0; }
+	~tTVPWavePCMCacheData() { if(Data) delete [] Data; }
+
+	void AddRef() { RefCount ++; }
+	void Release()
+	{
+		if(RefCount == 1)
+			delete this;
+		else
+			RefCount--;
+	}
+};
+//---------------------------------------------------------------------------
+typedef tTJSRefHolder<tTVPWavePCMCacheData> tTVPWavePCMCacheHolder;
+typedef tTJSHashTable<ttstr, tTVPWavePCMCacheHolder> tTVPWavePCMCache;
+static tTVPWavePCMCache TVPWavePCMCache;
+static tjs_uint64 TVPWavePCMCacheLimit = 8*1024*1024;
+static tjs_uint TVPWavePCMCacheMaxClipTime = 2000; // in ms
+static tjs_uint64 TVPWavePCMCacheTotalBytes = 0;
+#define TVP_WAVE_PCM_NEGATIVE_CACHE_COUNT 256
+static tTJSHashCache<ttstr, bool> TVPWavePCMNegativeCache(
+	TVP_WAVE_PCM_NEGATIVE_CACHE_COUNT);
+//---------------------------------------------------------------------------
+static ttstr TVPMakeWavePCMCacheKey(const ttstr & name,
+	const tTVPWaveFormat & format)
+{
+	// the storage name, followed by the fields which define the PCM
+	return name + TJS_W("|") +
+		ttstr((tjs_int)format.SamplesPerSec) + TJS_W("/") +
+		ttstr((tjs_int)format.Channels) + TJS_W("/") +
+		ttstr((tjs_int)format.BitsPerSample) + TJS_W("/") +
+		ttstr((tjs_int)format.BytesPerSample) +
+		(format.IsFloat ? TJS_W("f/") : TJS_W("i/")) +
+		ttstr((tjs_int)format.SpeakerConfig) + TJS_W("/") +
+		ttstr(tTJSVariant((tjs_int64)format.TotalSamples));
+}
+//---------------------------------------------------------------------------
+static void TVPCheckWavePCMCacheLimit()
+{
+	while(TVPWavePCMCacheTotalBytes > TVPWavePCMCacheLimit)
+	{
+		// chop last clip
+		tTVPWavePCMCache::tIterator i;
+		i = TVPWavePCMCache.GetLast();
+		if(!i.IsNull())
+		{
+			TVPWavePCMCacheTotalBytes -= i.GetValue().GetObjectNoAddRef()->Size;
+			TVPWavePCMCache.ChopLast(1);
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+//---------------------------------------------------------------------------
+void TVPClearWavePCMCache()
+{
+	TVPWavePCMCache.Clear();
+	TVPWavePCMCacheTotalBytes = 0;
+	TVPWavePCMNegativeCache.Clear();
+}
+static tTVPAtExit
+	TVPUninitWavePCMCache(TVP_ATEXIT_PRI_RELEASE, TVPClearWavePCMCache);
+//---------------------------------------------------------------------------
+struct tTVPClearWavePCMCacheCallback : public tTVPCompactEventCallbackIntf
+{
+	virtual void TJS_INTF_METHOD OnCompact(tjs_int level)
+	{
+		if(level >= TVP_COMPACT_LEVEL_MINIMIZE)
+		{
+			// clear the cache on application minimize
+			TVPClearWavePCMCache();
+		}
+	}
+} static TVPClearWavePCMCacheCallback;
+static bool TVPClearWavePCMCacheCallbackInit = false;
+//---------------------------------------------------------------------------
+void TVPSetWavePCMCacheLimit(tjs_uint64 limit, tjs_uint maxcliptime)
+{
+	// set limit of the cache by total bytes, and the longest clip to be
+	// cached in ms. limit == 0 disables the cache.
+	TVPWavePCMCacheLimit = limit;
+	TVPWavePCMCacheMaxClipTime = maxcliptime;
+	TVPCheckWavePCMCacheLimit();
+	TVPWavePCMNegativeCache.Clear(); // rejected clips may fit the new limits
+}
+//---------------------------------------------------------------------------
+tjs_uint64 TVPGetWavePCMCacheLimit()
+{
+	return TVPWavePCMCacheLimit;
+}
+//---------------------------------------------------------------------------
+tjs_uint TVPGetWavePCMCacheMaxClipTime()
+{
+	return TVPWavePCMCacheMaxClipTime;
+}
+//---------------------------------------------------------------------------
+class tTVPWD_PCMCache : public tTVPWaveDecoder
+{
+	tTVPWavePCMCacheData * Data;
+	tjs_uint64 CurrentPos;
+	tjs_uint SampleSize;
+
+public:
+	tTVPWD_PCMCache(tTVPWavePCMCacheData * data)
+	{
+		Data = data;
+		Data->AddRef();
+		CurrentPos = 0;
+		SampleSize = Data->Format.BytesPerSample * Data->Format.Channels;
+	}
+	~tTVPWD_PCMCache() { Data->Release(); }
+
+	void GetFormat(tTVPWaveFormat & format) { format = Data->Format; }
+
+	bool Render(void *buf, tjs_uint bufsamplelen, tjs_uint& rendered)
+	{
+		tjs_uint64 remain = Data->Format.TotalSamples - CurrentPos;
+		rendered = bufsamplelen < remain ? bufsamplelen : (tjs_uint)remain;
+		memcpy(buf, Data->Data + CurrentPos * SampleSize, rendered * SampleSize);
+		CurrentPos += rendered;
+		return rendered == bufsamplelen && CurrentPos < Data->Format.TotalSamples;
+	}
+
+	bool SetPosition(tjs_uint64 samplepos)
+	{
+		if(Data->Format.TotalSamples <= samplepos) return false;
+		CurrentPos = samplepos;
+		return true;
+	}
+};
+//---------------------------------------------------------------------------
+static tTVPWavePCMCacheData * TVPDecodeWaveToPCMCache(tTVPWaveDecoder * decoder)
+{
+	// decode whole the clip into memory.
+	// returns NULL if the clip is not suitable for the cache; in that case
+	// the decoder is rewound.
+	tTVPWaveFormat format;
+	decoder->GetFormat(format);
+
+	if(!format.Seekable || format.TotalSamples == 0) return NULL;
+	if(format.TotalTime > TVPWavePCMCacheMaxClipTime) return NULL;
+
+	tjs_uint samplesize = format.BytesPerSample * format.Channels;
+	tjs_uint64 size = format.TotalSamples * samplesize;
+	if(size > TVPWavePCMCacheLimit) return NULL;
+
+	tTVPWavePCMCacheData * data = new tTVPWavePCMCacheData();
+	try
+	{
+		data->Format = format;
+		data->Size = (tjs_uint)size;
+		data->Data = new tjs_uint8[data->Size + samplesize];
+			// one more sample to detect decoders which give more samples than
+			// TotalSamples
+
+		tjs_uint64 pos = 0;
+		bool cont = true;
+		while(cont && pos <= format.TotalSamples)
+		{
+			tjs_uint rendered = 0;
+			tjs_uint64 remain = format.TotalSamples + 1 - pos;
+			tjs_uint want = remain < 65536 ? (tjs_uint)remain : 65536;
+			cont = decoder->Render(data->Data + pos * samplesize, want, rendered);
+			pos += rendered;
+			if(rendered == 0) break;
+		}
+
+		if(pos > format.TotalSamples)
+		{
+			// TotalSamples is not reliable
+			data->Release();
+			data = NULL;
+			decoder->SetPosition(0);
+			return NULL;
+		}
+
+		data->Format.TotalSamples = pos;
+		data->Size = (tjs_uint)(pos * samplesize);
+	}
+	catch(...)
+	{
+		if(data) data->Release();
+		throw;
+	}
+
+	return data;
+}
+//---------------------------------------------------------------------------
+tTVPWaveDecoder *  TVPCreateWaveDecoder(const ttstr & storagename)
+{
+	// create a decoder, or serve the clip from the PCM cache.
+	if(TVPWavePCMCacheLimit == 0)
+		return TVPCreateWaveDecoderFromCreators(storagename);
+
+	if(!TVPClearWavePCMCacheCallbackInit)
+	{
+		TVPAddCompactEventHook(&TVPClearWavePCMCacheCallback);
+		TVPClearWavePCMCacheCallbackInit = true;
+	}
+
+	ttstr name(TVPNormalizeStorageName(storagename));
+
+	tTVPWaveDecoder * decoder = TVPCreateWaveDecoderFromCreators(storagename);
+	if(!decoder) return NULL;
+
+	tTVPWavePCMCacheData * data = NULL;
+	try
+	{
+		tTVPWaveFormat format;
+		decoder->GetFormat(format);
+		ttstr key(TVPMakeWavePCMCacheKey(name, format));
+		tjs_uint32 hash = tTVPWavePCMCache::MakeHash(key);
+
+		tTVPWavePCMCacheHolder * ptr =
+			TVPWavePCMCache.FindAndTouchWithHash(key, hash);
+		if(ptr)
+		{
+			delete decoder, decoder = NULL;
+			return new tTVPWD_PCMCache(ptr->GetObjectNoAddRef());
+		}
+
+		if(TVPWavePCMNegativeCache.FindAndTouchWithHash(key, hash))
+			return decoder;
+
+		data = TVPDecodeWaveToPCMCache(decoder);
+		if(!data)
+		{
+			// not to be cached
+			TVPWavePCMNegativeCache.AddWithHash(key, hash, true);
+			return decoder;
+		}
+
+		delete decoder, decoder = NULL;
+
+		TVPWavePCMCacheTotalBytes += data->Size;
+		tTVPWavePCMCacheHolder holder(data);
+		TVPWavePCMCache.AddWithHash(key, hash, holder);
+		TVPCheckWavePCMCacheLimit();
+
+		decoder = new tTVPWD_PCMCache(data);
+	}
+	catch(...)
+	{
+		if(decoder) delete decoder;
+		if(data) data->Release();
+		throw;
+	}
+	data->Release();
+
+	return decoder;
+}
+//---------------------------------------------------------------------------
+
+
+
+
 
 
 //---------------------------------------------------------------------------
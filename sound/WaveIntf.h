@@ -67,6 +67,9 @@ TJS_EXP_FUNC_DEF(void, TVPConvertPCMTo16bits, (tjs_int16 *output, const void *in
 TJS_EXP_FUNC_DEF(void, TVPConvertPCMTo16bits, (tjs_int16 *output, const void *input, tjs_int channels, tjs_int bytespersample, tjs_int bitspersample, bool isfloat, tjs_int count, bool downmix));
 TJS_EXP_FUNC_DEF(void, TVPConvertPCMToFloat, (float *output, const void *input, tjs_int channels, tjs_int bytespersample, tjs_int bitspersample, bool isfloat, tjs_int count));
 TJS_EXP_FUNC_DEF(void, TVPConvertPCMToFloat, (float *output, const void *input, const tTVPWaveFormat &format, tjs_int count));
+extern void TVPSetPCMConvertDither(bool b);
+	// apply TPDF dither when converting float PCM to 16bit
+extern bool TVPGetPCMConvertDither();
 //---------------------------------------------------------------------------
 
 
@@ -120,6 +123,20 @@ public:
 extern void TVPRegisterWaveDecoderCreator(tTVPWaveDecoderCreator *d);
 extern void TVPUnregisterWaveDecoderCreator(tTVPWaveDecoderCreator *d);
 extern tTVPWaveDecoder *  TVPCreateWaveDecoder(const ttstr & storagename);
+extern tTVPWaveDecoder * TVPCreateWaveDecoderFromCreators(const ttstr & storagename);
+	// the same as TVPCreateWaveDecoder but always creates a new decoder,
+	// bypassing the decoded PCM cache
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+// decoded PCM cache management
+//---------------------------------------------------------------------------
+extern void TVPSetWavePCMCacheLimit(tjs_uint64 limit, tjs_uint maxcliptime);
+	// limit is in bytes (0 disables the cache), maxcliptime is in ms
+extern tjs_uint64 TVPGetWavePCMCacheLimit();
+extern tjs_uint TVPGetWavePCMCacheMaxClipTime();
+extern void TVPClearWavePCMCache();
 //---------------------------------------------------------------------------
 
 
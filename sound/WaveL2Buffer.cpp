@@ -0,0 +1,121 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Level 2 buffer of the wave sound buffer
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include "WaveL2Buffer.h"
+
+
+//---------------------------------------------------------------------------
+// tTVPWaveL2Buffer
+//---------------------------------------------------------------------------
+tTVPWaveL2Buffer::tTVPWaveL2Buffer(iTVPWaveL2Source * source)
+{
+	Source = source;
+	Buffer = NULL;
+	UnitCount = 0;
+	UnitSamples = 0;
+	UnitBytes = 0;
+	Ended = false;
+}
+//---------------------------------------------------------------------------
+tTVPWaveL2Buffer::~tTVPWaveL2Buffer()
+{
+	Free();
+}
+//---------------------------------------------------------------------------
+void tTVPWaveL2Buffer::Allocate(tjs_int units, tjs_int unitsamples,
+	tjs_int unitbytes)
+{
+	Free();
+	Units.Resize(units);
+	Buffer = new tjs_uint8[unitbytes * units];
+	UnitCount = units;
+	UnitSamples = unitsamples;
+	UnitBytes = unitbytes;
+	Ended = false;
+}
+//---------------------------------------------------------------------------
+void tTVPWaveL2Buffer::Free()
+{
+	Units.Resize(0);
+	if(Buffer) delete [] Buffer, Buffer = NULL;
+	UnitCount = 0;
+	UnitSamples = 0;
+	UnitBytes = 0;
+}
+//---------------------------------------------------------------------------
+void tTVPWaveL2Buffer::ClearSegments()
+{
+	for(tjs_int i = 0; i < UnitCount; i++)
+		Units.GetSlot(i).Segments.Clear();
+}
+//---------------------------------------------------------------------------
+bool tTVPWaveL2Buffer::Fill(bool firstwrite)
+{
+	tTJSCriticalSectionHolder holder(CS);
+
+	if(!Buffer) return false; // not allocated
+
+	if(firstwrite)
+	{
+		// only the playing thread runs here, before it starts reading
+		Units.Reset();
+		Ended = false;
+	}
+
+	if(Units.GetWritableSize() == 0) return false; // buffer is full
+
+	tUnit & unit = Units.GetWriteSlot();
+	unit.Segments.Clear();
+	if(Ended)
+	{
+		unit.DecodedSamples = 0;
+	}
+	else
+	{
+		tjs_uint decoded = Source->DecodeL2Unit(
+			Buffer + Units.GetWriteIndex() * UnitBytes, UnitSamples,
+			unit.Segments);
+
+		if(decoded < (tjs_uint)UnitSamples) Ended = true;
+
+		unit.DecodedSamples = decoded;
+	}
+
+	Units.AdvanceWritePos(); // publish the unit to the reader
+
+	return true;
+}
+//---------------------------------------------------------------------------
+const tjs_uint8 * tTVPWaveL2Buffer::BeginRead(tjs_uint & decoded,
+	tTVPWaveSegmentQueue & segments)
+{
+	// the reader never reads the unit which is being written, since a unit
+	// is published only after it is written
+	if(Units.GetReadableSize() == 0) return NULL; // underrun
+
+	tUnit & unit = Units.GetReadSlot();
+	decoded = unit.DecodedSamples;
+	segments = unit.Segments;
+	return Buffer + Units.GetReadIndex() * UnitBytes;
+}
+//---------------------------------------------------------------------------
+void tTVPWaveL2Buffer::EndRead()
+{
+	Units.AdvanceReadPos();
+}
+//---------------------------------------------------------------------------
+void tTVPWaveL2Buffer::GetDecodeStatus(tjs_int &remain, tjs_int &units)
+{
+	remain = (tjs_int)Units.GetDataSize();
+	units = UnitCount;
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,110 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Level 2 buffer of the wave sound buffer
+//---------------------------------------------------------------------------
+/*
+	The L2 buffer holds decoded PCM, in the input format, between the decoder
+	and the L1 buffer of the sound device. It is divided into units of the
+	same length as the L1 access unit.
+
+	The decoding threads fill the buffer through iTVPWaveDecodeTarget; the
+	playing thread also fills a unit by itself when it finds the buffer
+	empty. The writers are serialized by the critical section of the buffer,
+	and the reader (the playing thread) never locks it.
+
+	A unit shorter than the unit length is the end of the stream. When the
+	reader finds no unit, the decoder could not keep up; this is an underrun,
+	not the end, and the reader plays silence instead.
+*/
+#ifndef WaveL2BufferH
+#define WaveL2BufferH
+
+#include "WaveSegmentQueue.h"
+#include "RingBuffer.h"
+#include "WaveDecodeScheduler.h"
+
+//---------------------------------------------------------------------------
+// iTVPWaveL2Source : the source which fills the L2 buffer
+//---------------------------------------------------------------------------
+class iTVPWaveL2Source
+{
+public:
+	virtual ~iTVPWaveL2Source() {}
+
+	virtual tjs_uint DecodeL2Unit(void *buffer, tjs_uint bufsamplelen,
+		tTVPWaveSegmentQueue & segments) = 0;
+		// decodes one unit into "buffer"; returns the number of decoded
+		// samples, which is less than "bufsamplelen" only at the end of the
+		// stream. called with the L2 buffer locked, on a decoding thread or
+		// on the playing thread.
+};
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// tTVPWaveL2Buffer
+//---------------------------------------------------------------------------
+class tTVPWaveL2Buffer : public iTVPWaveDecodeTarget
+{
+	iTVPWaveL2Source * Source;
+	tTJSCriticalSection CS; // serializes the writers
+
+	struct tUnit
+	{
+		tjs_int DecodedSamples; // decoded samples in the unit
+		tTVPWaveSegmentQueue Segments;
+	};
+	tRisaSPSCRingBuffer<tUnit> Units;
+		// PCM data of the unit n is at Buffer + n * UnitBytes
+	tjs_uint8 * Buffer;
+	tjs_int UnitCount;
+	tjs_int UnitSamples;
+	tjs_int UnitBytes;
+	bool Ended; // the source reached the end of the stream
+
+public:
+	tTVPWaveL2Buffer(iTVPWaveL2Source * source);
+	virtual ~tTVPWaveL2Buffer();
+
+	void Allocate(tjs_int units, tjs_int unitsamples, tjs_int unitbytes);
+	void Free();
+		// these must be called while no thread accesses the buffer
+
+	tTJSCriticalSection & GetCS() { return CS; }
+		// holding this keeps the decoding threads off the buffer
+
+	tjs_int GetUnitCount() const { return UnitCount; }
+	tjs_int GetUnitSamples() const { return UnitSamples; }
+	tjs_uint8 * GetBuffer() { return Buffer; }
+	tjs_int GetBufferSize() const { return UnitBytes * UnitCount; }
+	void ClearSegments();
+
+	//-- writer
+	bool Fill(bool firstwrite);
+		// decodes one unit; returns false if the buffer is full.
+		// "firstwrite" empties the buffer first; the reader must not be
+		// running then.
+
+	//-- reader
+	tjs_int GetReadableUnits() { return (tjs_int)Units.GetReadableSize(); }
+	const tjs_uint8 * BeginRead(tjs_uint & decoded,
+		tTVPWaveSegmentQueue & segments);
+		// returns the PCM of the oldest unit, and its decoded samples and
+		// segments; returns NULL on underrun. the unit stays valid until
+		// EndRead is called.
+	void EndRead(); // gives the unit back to the writers
+
+	//-- iTVPWaveDecodeTarget; called by the decoding threads
+	void GetDecodeStatus(tjs_int &remain, tjs_int &units);
+	bool DecodeUnit() { return Fill(false); }
+};
+//---------------------------------------------------------------------------
+
+#endif
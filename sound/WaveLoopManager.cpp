@@ -25,7 +25,15 @@
 	#include "WaveReader.h"
 #else
 	#include "WaveIntf.h"
+	#include "WaveDecodeScheduler.h"
+	#include "DetectCPU.h"
+	#include "tvpgl_ia32_intf.h"
+	#if defined(_M_IX86)||defined(_M_X64)
+		#define TVP_WL_USE_SSE2
+		#include <emmintrin.h>
+	#endif
 #endif
+#include <math.h>
 
 
 #ifdef __BORLANDC__
@@ -105,36 +113,236 @@ struct tTVPPCM24
 
 
 //---------------------------------------------------------------------------
-// Crossfade Template function
+// Crossfade functions
+//---------------------------------------------------------------------------
+/*
+	Crossfading is done in batches of float samples; integer samples are
+	converted to float without scaling (so that the conversion is exact),
+	blended with per-sample-granule gains, and converted back.
+*/
+#define TVP_WL_CROSSFADE_BLOCK 2048 // batch size in samples (not granules)
+//---------------------------------------------------------------------------
+static void TVPCrossFadeGains(float *g1, float *g2, tjs_int frames,
+	double ratio, double step, tTVPWaveCrossFadeCurve curve)
+{
+	// compute gains for src1 (g1) and src2 (g2) of each sample granule
+	if(curve == wcfcEqualPower)
+	{
+		const double pi_2 = 1.5707963267948966;
+		for(tjs_int i = 0; i < frames; i++)
+		{
+			double t = (ratio + step * i) * pi_2;
+			g1[i] = (float)cos(t);
+			g2[i] = (float)sin(t);
+		}
+	}
+	else
+	{
+		const float r0 = (float)ratio, s = (float)step;
+		tjs_int i = 0;
+#ifdef TVP_WL_USE_SSE2
+		if(TVPCPUType & TVP_CPU_HAS_SSE2)
+		{
+			__m128 one = _mm_set1_ps(1.0f);
+			__m128 vs = _mm_set1_ps(s);
+			__m128 vi = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+			__m128 v4 = _mm_set1_ps(4.0f);
+			__m128 vr0 = _mm_set1_ps(r0);
+			for(; i + 4 <= frames; i += 4)
+			{
+				__m128 r = _mm_add_ps(vr0, _mm_mul_ps(vs, vi));
+				_mm_storeu_ps(g1 + i, _mm_sub_ps(one, r));
+				_mm_storeu_ps(g2 + i, r);
+				vi = _mm_add_ps(vi, v4);
+			}
+		}
+#endif
+		for(; i < frames; i++)
+		{
+			float r = r0 + s * (float)i;
+			g1[i] = 1.0f - r;
+			g2[i] = r;
+		}
+	}
+}
+//---------------------------------------------------------------------------
+static void TVPCrossFadeBlend_c(float *dest, const float *s1, const float *s2,
+	const float *g1, const float *g2, tjs_int frames, tjs_int channels)
+{
+	for(tjs_int i = 0; i < frames; i++)
+	{
+		float a = g1[i], b = g2[i];
+		for(tjs_int j = 0; j < channels; j++)
+			dest[j] = s1[j] * a + s2[j] * b;
+		dest += channels; s1 += channels; s2 += channels;
+	}
+}
+//---------------------------------------------------------------------------
+#ifdef TVP_WL_USE_SSE2
+static void TVPCrossFadeBlend_sse(float *dest, const float *s1, const float *s2,
+	const float *g1, const float *g2, tjs_int frames, tjs_int channels)
+{
+	// monaural and stereo are vectorized; 4 sample granules per one loop
+	tjs_int i = 0;
+	if(channels == 1)
+	{
+		for(; i + 4 <= frames; i += 4)
+		{
+			__m128 a = _mm_loadu_ps(g1 + i);
+			__m128 b = _mm_loadu_ps(g2 + i);
+			__m128 x = _mm_mul_ps(_mm_loadu_ps(s1 + i), a);
+			__m128 y = _mm_mul_ps(_mm_loadu_ps(s2 + i), b);
+			_mm_storeu_ps(dest + i, _mm_add_ps(x, y));
+		}
+	}
+	else if(channels == 2)
+	{
+		for(; i + 4 <= frames; i += 4)
+		{
+			__m128 a = _mm_loadu_ps(g1 + i);
+			__m128 b = _mm_loadu_ps(g2 + i);
+			__m128 alo = _mm_unpacklo_ps(a, a), ahi = _mm_unpackhi_ps(a, a);
+			__m128 blo = _mm_unpacklo_ps(b, b), bhi = _mm_unpackhi_ps(b, b);
+			const float *p1 = s1 + i * 2, *p2 = s2 + i * 2;
+			_mm_storeu_ps(dest + i * 2, _mm_add_ps(
+				_mm_mul_ps(_mm_loadu_ps(p1    ), alo),
+				_mm_mul_ps(_mm_loadu_ps(p2    ), blo)));
+			_mm_storeu_ps(dest + i * 2 + 4, _mm_add_ps(
+				_mm_mul_ps(_mm_loadu_ps(p1 + 4), ahi),
+				_mm_mul_ps(_mm_loadu_ps(p2 + 4), bhi)));
+		}
+	}
+	TVPCrossFadeBlend_c(dest + i * channels, s1 + i * channels, s2 + i * channels,
+		g1 + i, g2 + i, frames - i, channels);
+}
+#endif
+//---------------------------------------------------------------------------
+static void TVPCrossFadeBlend(float *dest, const float *s1, const float *s2,
+	const float *g1, const float *g2, tjs_int frames, tjs_int channels)
+{
+#ifdef TVP_WL_USE_SSE2
+	if(TVPCPUType & TVP_CPU_HAS_SSE)
+		TVPCrossFadeBlend_sse(dest, s1, s2, g1, g2, frames, channels);
+	else
+		TVPCrossFadeBlend_c(dest, s1, s2, g1, g2, frames, channels);
+#else
+	TVPCrossFadeBlend_c(dest, s1, s2, g1, g2, frames, channels);
+#endif
+}
+//---------------------------------------------------------------------------
+template <typename T>
+static void TVPCrossFadeIntegerToFloat(float *dest, const void *src, tjs_int n)
+{
+	const T *s = (const T *)src;
+	for(tjs_int i = 0; i < n; i++) dest[i] = (float)(tjs_int)s[i];
+}
 //---------------------------------------------------------------------------
 template <typename T>
-static void TVPCrossFadeIntegerBlend(void *dest, void *src1, void *src2,
-	tjs_int ratiostart, tjs_int ratioend,
-	tjs_int samples, tjs_int channels)
+static void TVPCrossFadeFloatToInteger(void *dest, const float *src, tjs_int n,
+	double min, double max)
 {
-	tjs_uint blend_step = (tjs_int)(
-		(
-			(ratioend - ratiostart) * ((tjs_int64)1<<32) / 100
-		) / samples);
-	const T *s1 = (const T *)src1;
-	const T *s2 = (const T *)src2;
-	T *out = (T *)dest;
-	tjs_uint ratio = (tjs_int)(ratiostart * ((tjs_int64)1<<32) / 100);
-	for(tjs_int i = 0; i < samples; i++)
+	T *d = (T *)dest;
+	for(tjs_int i = 0; i < n; i++)
 	{
-		for(tjs_int j = channels - 1; j >= 0; j--)
+		double v = floor((double)src[i] + 0.5);
+		if(v < min) v = min;
+		if(v > max) v = max;
+		d[i] = (tjs_int)v;
+	}
+}
+//---------------------------------------------------------------------------
+static void TVPCrossFadeToFloat(float *dest, const void *src, tjs_int n,
+	tjs_int bytes)
+{
+	switch(bytes)
+	{
+	case 1:
+		TVPCrossFadeIntegerToFloat<tTVPPCM8>(dest, src, n);
+		break;
+	case 2:
+	  {
+		tjs_int i = 0;
+#ifdef TVP_WL_USE_SSE2
+		if(TVPCPUType & TVP_CPU_HAS_SSE2)
+		{
+			const tjs_int16 *s = (const tjs_int16 *)src;
+			for(; i + 8 <= n; i += 8)
+			{
+				__m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+				__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+				__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+				_mm_storeu_ps(dest + i,     _mm_cvtepi32_ps(lo));
+				_mm_storeu_ps(dest + i + 4, _mm_cvtepi32_ps(hi));
+			}
+		}
+#endif
+		TVPCrossFadeIntegerToFloat<tjs_int16>(dest + i,
+			(const tjs_int16 *)src + i, n - i);
+		break;
+	  }
+	case 3:
+		TVPCrossFadeIntegerToFloat<tTVPPCM24>(dest, src, n);
+		break;
+	// 32bit integers do not fit in the float mantissa; they are blended by
+	// TVPCrossFadeBlendInt32 instead
+	}
+}
+//---------------------------------------------------------------------------
+static void TVPCrossFadeFromFloat(void *dest, const float *src, tjs_int n,
+	tjs_int bytes)
+{
+	switch(bytes)
+	{
+	case 1:
+		TVPCrossFadeFloatToInteger<tTVPPCM8>(dest, src, n, -128.0, 127.0);
+		break;
+	case 2:
+	  {
+		tjs_int i = 0;
+#ifdef TVP_WL_USE_SSE2
+		if(TVPCPUType & TVP_CPU_HAS_SSE2)
+		{
+			// cvtps rounds to nearest, and packs saturates
+			tjs_int16 *d = (tjs_int16 *)dest;
+			for(; i + 8 <= n; i += 8)
+			{
+				__m128i lo = _mm_cvtps_epi32(_mm_loadu_ps(src + i));
+				__m128i hi = _mm_cvtps_epi32(_mm_loadu_ps(src + i + 4));
+				_mm_storeu_si128((__m128i *)(d + i), _mm_packs_epi32(lo, hi));
+			}
+		}
+#endif
+		TVPCrossFadeFloatToInteger<tjs_int16>((tjs_int16 *)dest + i, src + i,
+			n - i, -32768.0, 32767.0);
+		break;
+	  }
+	case 3:
+		TVPCrossFadeFloatToInteger<tTVPPCM24>(dest, src, n,
+			-8388608.0, 8388607.0);
+		break;
+	}
+}
+//---------------------------------------------------------------------------
+static void TVPCrossFadeBlendInt32(tjs_int32 *dest, const tjs_int32 *s1,
+	const tjs_int32 *s2, const float *g1, const float *g2, tjs_int frames,
+	tjs_int channels)
+{
+	// blend 32bit integer PCM in double, whose mantissa holds the samples
+	// exactly; the result is exact at the ends of the crossfade (gains of 0
+	// and 1), as with the other sample formats.
+	for(tjs_int f = 0; f < frames; f++)
+	{
+		double a = g1[f], b = g2[f];
+		for(tjs_int c = 0; c < channels; c++)
 		{
-			tjs_int si1 = (tjs_int)*s1;
-			tjs_int si2 = (tjs_int)*s2;
-			tjs_int o = (tjs_int) (
-						(((tjs_int64)si2 * (tjs_uint64)ratio) >> 32) +
-						(((tjs_int64)si1 * (0x100000000ui64 - (tjs_uint64)ratio) ) >> 32) );
-			*out = o;
-			s1 ++;
-			s2 ++;
-			out ++;
+			double v = floor(s1[c] * a + s2[c] * b + 0.5);
+			if(v < -2147483648.0) v = -2147483648.0;
+			if(v > 2147483647.0) v = 2147483647.0;
+			dest[c] = (tjs_int32)v;
 		}
-		ratio += blend_step;
+		dest += channels;
+		s1 += channels;
+		s2 += channels;
 	}
 }
 //---------------------------------------------------------------------------
@@ -143,6 +351,38 @@ static void TVPCrossFadeIntegerBlend(void *dest, void *src1, void *src2,
 
 
 
+#ifndef TVP_IN_LOOP_TUNER
+//---------------------------------------------------------------------------
+// tTVPWaveLoopPrefetcher : decodes jump targets on the decoding threads
+//---------------------------------------------------------------------------
+class tTVPWaveLoopPrefetcher : public iTVPWaveDecodeTarget
+{
+	tTVPWaveLoopManager * Owner;
+	tTVPWaveDecodeTask * Task;
+
+public:
+	tTVPWaveLoopPrefetcher(tTVPWaveLoopManager * owner)
+	{
+		Owner = owner;
+		Task = new tTVPWaveDecodeTask(this);
+	}
+
+	~tTVPWaveLoopPrefetcher()
+	{
+		delete Task; // waits for the thread which is prefetching
+	}
+
+	void Request() { Task->Continue(); }
+
+	void GetDecodeStatus(tjs_int &remain, tjs_int &units)
+		{ Owner->GetPrefetchStatus(remain, units); }
+	bool DecodeUnit() { return Owner->DoPrefetch(); }
+};
+//---------------------------------------------------------------------------
+#endif
+
+
+
 //---------------------------------------------------------------------------
 // tTVPWaveLoopManager
 //---------------------------------------------------------------------------
@@ -157,6 +397,22 @@ tTVPWaveLoopManager::tTVPWaveLoopManager()
 	Decoder = NULL;
 	IgnoreLinks = false;
 	Looping = false;
+	CrossFadeCurve = wcfcLinear;
+
+	Prefetcher = NULL;
+	PrefetchDecoder = NULL;
+	OwnDecoder = NULL;
+	PrefetchLeadSamples = 0;
+	PrefetchUnavailable = false;
+	PrefetchState = psNone;
+	PrefetchSamples = NULL;
+	PrefetchBufferSamples = 0;
+	PrefetchRequestLen = 0;
+	PrefetchLen = 0;
+	PrefetchPosition = 0;
+	PrefetchTarget = -1;
+	PrefetchServing = false;
+	PrefetchedJumpCount = 0;
 
 	Format = new tTVPWaveFormat;
 	memset(Format, 0, sizeof(*Format));
@@ -167,7 +423,12 @@ tTVPWaveLoopManager::tTVPWaveLoopManager()
 //---------------------------------------------------------------------------
 tTVPWaveLoopManager::~tTVPWaveLoopManager()
 {
+#ifndef TVP_IN_LOOP_TUNER
+	if(Prefetcher) delete Prefetcher; // waits for the prefetching thread
+#endif
 	ClearCrossFadeInformation();
+	if(OwnDecoder) delete OwnDecoder;
+	if(PrefetchSamples) delete [] PrefetchSamples;
 	delete Format;
 }
 //---------------------------------------------------------------------------
@@ -175,13 +436,36 @@ void tTVPWaveLoopManager::SetDecoder(tTVPWaveDecoder * decoder)
 {
 	// set decoder and compute ShortCrossFadeHalfSamples
 	Decoder = decoder;
+	PrefetchTarget = -1;
+	PrefetchServing = false;
 	if(decoder)
 		decoder->GetFormat(*Format);
 	else
 		memset(Format, 0, sizeof(*Format));
 	ShortCrossFadeHalfSamples =
 		Format->SamplesPerSec * TVP_WL_SMOOTH_TIME_HALF / 1000;
+	PrefetchLeadSamples =
+		Format->SamplesPerSec * TVP_WL_PREFETCH_LEAD_TIME / 1000;
+}
+//---------------------------------------------------------------------------
+#ifndef TVP_IN_LOOP_TUNER
+void tTVPWaveLoopManager::SetPrefetchStorage(const ttstr & storage)
+{
+	// enable jump target prefetching. SetDecoder must be called before
+	// this, and this can be called only once.
+	volatile tTJSCriticalSectionHolder CS(DataCS);
+
+	if(Prefetcher) return;
+	if(!Decoder || !Format->Seekable) return;
+
+	tjs_int samples = Format->SamplesPerSec * TVP_WL_PREFETCH_TIME / 1000;
+	PrefetchSamples = new tjs_uint8[
+		samples * Format->BytesPerSample * Format->Channels];
+	PrefetchBufferSamples = samples;
+	PrefetchStorage = storage;
+	Prefetcher = new tTVPWaveLoopPrefetcher(this);
 }
+#endif
 //---------------------------------------------------------------------------
 int tTVPWaveLoopManager::GetFlag(tjs_int index)
 {
@@ -281,6 +565,7 @@ void tTVPWaveLoopManager::SetPosition(tjs_int64 pos)
 	volatile tTJSCriticalSectionHolder CS(DataCS);
 	Position = pos;
 	ClearCrossFadeInformation();
+	PrefetchServing = false;
 	Decoder->SetPosition(pos);
 }
 //---------------------------------------------------------------------------
@@ -323,10 +608,19 @@ void tTVPWaveLoopManager::Decode(void *dest, tjs_uint samples, tjs_uint &written
 
 				Position = link.To;
 				if(!CrossFadeSamples)
-					Decoder->SetPosition(Position);
+				{
+					if(!UsePrefetchedJumpTarget(Position))
+						Decoder->SetPosition(Position);
+				}
 				continue;
 			}
 
+			// the link will be followed unless the flags are changed;
+			// decode its target in advance when it comes close (smooth
+			// links decode their target by themselves to crossfade).
+			if(!link.Smooth && link.From - Position <= PrefetchLeadSamples)
+				PrefetchJumpTarget(link.To);
+
 			if(link.Smooth)
 			{
 				// the nearest event is a smooth link
@@ -394,6 +688,13 @@ void tTVPWaveLoopManager::Decode(void *dest, tjs_uint samples, tjs_uint &written
 						// decode samples
 						tjs_uint decoded1 = 0, decoded2 = 0;
 
+						if(PrefetchServing)
+						{
+							// Decoder is ahead of Position
+							PrefetchServing = false;
+							Decoder->SetPosition(Position);
+						}
+
 						Decoder->Render((void*)src1,
 							before_count + after_count, decoded1);
 
@@ -433,6 +734,11 @@ void tTVPWaveLoopManager::Decode(void *dest, tjs_uint samples, tjs_uint &written
 		{
 			// event not found
 			next_not_found = true;
+
+			// the decoding will be rewound at the end of the stream
+			if(Looping && Format->TotalSamples &&
+				(tjs_int64)Format->TotalSamples - Position <= PrefetchLeadSamples)
+				PrefetchJumpTarget(0);
 		}
 
 		tjs_int one_unit;
@@ -447,6 +753,11 @@ void tTVPWaveLoopManager::Decode(void *dest, tjs_uint samples, tjs_uint &written
 			if(one_unit > CrossFadeLen - CrossFadePosition)
 				one_unit = CrossFadeLen - CrossFadePosition;
 		}
+		else if(PrefetchServing)
+		{
+			if(one_unit > PrefetchLen - PrefetchPosition)
+				one_unit = PrefetchLen - PrefetchPosition;
+		}
 
 		if(one_unit > 0) give_up_count = 0; // reset give up count
 
@@ -474,7 +785,25 @@ void tTVPWaveLoopManager::Decode(void *dest, tjs_uint samples, tjs_uint &written
 		segments.Enqueue(tTVPWaveSegment(Position, one_unit));
 
 		// decode or copy
-		if(!CrossFadeSamples)
+		if(!CrossFadeSamples && PrefetchServing)
+		{
+			// copy prefetched samples at the jump target
+			memcpy((void *)d,
+				PrefetchSamples +
+					PrefetchPosition * Format->BytesPerSample * Format->Channels,
+				one_unit * Format->BytesPerSample * Format->Channels);
+			PrefetchPosition += one_unit;
+			Position += one_unit;
+			written += one_unit;
+			d += one_unit * Format->BytesPerSample * Format->Channels;
+			if(PrefetchPosition == PrefetchLen)
+			{
+				// all prefetched samples are consumed;
+				// Decoder is now exactly at Position.
+				PrefetchServing = false;
+			}
+		}
+		else if(!CrossFadeSamples)
 		{
 			// not crossfade
 			// decode direct into destination buffer
@@ -493,7 +822,8 @@ void tTVPWaveLoopManager::Decode(void *dest, tjs_uint samples, tjs_uint &written
 					break;
 				}
 				Position = 0;
-				Decoder->SetPosition(0);
+				if(!UsePrefetchedJumpTarget(0))
+					Decoder->SetPosition(0);
 			}
 			d += decoded * Format->BytesPerSample * Format->Channels;
 		}
@@ -675,55 +1005,217 @@ void tTVPWaveLoopManager::DoCrossFade(void *dest, void *src1,
 	// using src1 (fading out) and src2 (fading in).
 	if(samples == 0) return; // nothing to do
 
-	if(Format->IsFloat)
+	const tjs_int channels = Format->Channels;
+	const tjs_int bytes = Format->BytesPerSample;
+	if(channels == 0 || channels > TVP_WL_CROSSFADE_BLOCK) return;
+
+	float buf1[TVP_WL_CROSSFADE_BLOCK];
+	float buf2[TVP_WL_CROSSFADE_BLOCK];
+	float g1[TVP_WL_CROSSFADE_BLOCK];
+	float g2[TVP_WL_CROSSFADE_BLOCK];
+
+	const tjs_int block_frames = TVP_WL_CROSSFADE_BLOCK / channels;
+	const double ratio = ratiostart / 100.0;
+	const double step = (ratioend - ratiostart) / 100.0 / samples;
+
+	tjs_uint8 *d = (tjs_uint8 *)dest;
+	const tjs_uint8 *s1 = (const tjs_uint8 *)src1;
+	const tjs_uint8 *s2 = (const tjs_uint8 *)src2;
+
+	for(tjs_int done = 0; done < samples; )
 	{
-		float blend_step =
-			(float)((ratioend - ratiostart) / 100.0 / samples);
-		const float *s1 = (const float *)src1;
-		const float *s2 = (const float *)src2;
-		float *out = (float *)dest;
-		float ratio = static_cast<float>(ratiostart / 100.0);
-		for(tjs_int i = 0; i < samples; i++)
+		tjs_int frames = samples - done;
+		if(frames > block_frames) frames = block_frames;
+		tjs_int n = frames * channels;
+
+		TVPCrossFadeGains(g1, g2, frames, ratio + step * done, step,
+			CrossFadeCurve);
+
+		if(Format->IsFloat)
 		{
-			for(tjs_int j = Format->Channels - 1; j >= 0; j--)
-			{
-				*out = *s1 + (*s2 - *s1) * ratio;
-				s1 ++;
-				s2 ++;
-				out ++;
-			}
-			ratio += blend_step;
+			TVPCrossFadeBlend((float *)d, (const float *)s1, (const float *)s2,
+				g1, g2, frames, channels);
 		}
+		else if(bytes == 4)
+		{
+			TVPCrossFadeBlendInt32((tjs_int32 *)d, (const tjs_int32 *)s1,
+				(const tjs_int32 *)s2, g1, g2, frames, channels);
+		}
+		else
+		{
+			TVPCrossFadeToFloat(buf1, s1, n, bytes);
+			TVPCrossFadeToFloat(buf2, s2, n, bytes);
+			TVPCrossFadeBlend(buf1, buf1, buf2, g1, g2, frames, channels);
+			TVPCrossFadeFromFloat(d, buf1, n, bytes);
+		}
+
+		d += n * bytes;
+		s1 += n * bytes;
+		s2 += n * bytes;
+		done += frames;
 	}
-	else
+}
+//---------------------------------------------------------------------------
+void tTVPWaveLoopManager::ClearCrossFadeInformation()
+{
+	if(CrossFadeSamples) delete [] CrossFadeSamples, CrossFadeSamples = NULL;
+}
+//---------------------------------------------------------------------------
+void tTVPWaveLoopManager::PrefetchJumpTarget(tjs_int64 target)
+{
+	// request the prefetcher to seek the spare decoder to 'target' and to
+	// decode the samples there into the side buffer, so that the jump to
+	// 'target' needs neither seeking nor decoding at the time it occurs.
+	// this is called with DataCS held, and does not wait for the prefetcher.
+	if(!Prefetcher) return; // prefetching is not enabled
+	if(PrefetchServing) return; // side buffer is in use; try later
+
+	// the prefetched region must not reach the next event after the
+	// target, since the region is consumed without checking links.
+	tjs_int64 len = PrefetchBufferSamples;
+	tTVPWaveLoopLink next;
+	if(!IgnoreLinks && GetNearestEvent(target, next, true))
+	{
+		tjs_int64 limit = next.From - target;
+		if(next.Smooth) limit -= ShortCrossFadeHalfSamples;
+		if(len > limit) len = limit;
+	}
+
+	{
+		volatile tTJSCriticalSectionHolder CS(PrefetchCS);
+		if(PrefetchUnavailable) return; // the spare decoder can not be opened
+		if(PrefetchState != psNone && PrefetchTarget == target) return;
+			// already requested or prefetched (or tried)
+		if(PrefetchState == psBusy) return; // another target; try later
+
+		// psReady with PrefetchLen == 0 means that the target can not be
+		// prefetched; it is not retried until the target changes.
+		PrefetchTarget = target;
+		PrefetchLen = 0;
+		if(len <= 0)
+		{
+			PrefetchState = psReady;
+			return;
+		}
+		PrefetchRequestLen = (tjs_int)len;
+		PrefetchState = psPending;
+	}
+
+	Prefetcher->Request(); // outside PrefetchCS; the scheduler locks it
+}
+//---------------------------------------------------------------------------
+bool tTVPWaveLoopManager::UsePrefetchedJumpTarget(tjs_int64 target)
+{
+	// jump to 'target' using the prefetched samples if available.
+	// returns false if the caller must seek Decoder by itself; a prefetch
+	// which is not finished yet is not waited for.
+	PrefetchServing = false;
+	if(!Prefetcher) return false;
+
+	volatile tTJSCriticalSectionHolder CS(PrefetchCS);
+	if(PrefetchState != psReady || PrefetchTarget != target || PrefetchLen == 0)
+		return false;
+
+	// swap the decoders; the spare decoder is already positioned just after
+	// the prefetched samples.
+	tTVPWaveDecoder *spare = Decoder;
+	Decoder = PrefetchDecoder;
+	PrefetchDecoder = spare;
+
+	PrefetchState = psNone;
+	PrefetchTarget = -1;
+	PrefetchPosition = 0;
+	PrefetchServing = true;
+	PrefetchedJumpCount++;
+	return true;
+}
+//---------------------------------------------------------------------------
+#ifndef TVP_IN_LOOP_TUNER
+void tTVPWaveLoopManager::GetPrefetchStatus(tjs_int &remain, tjs_int &units)
+{
+	// a pending request is served before the buffers which have more than
+	// one unit decoded; the jump is at most TVP_WL_PREFETCH_LEAD_TIME ahead.
+	volatile tTJSCriticalSectionHolder CS(PrefetchCS);
+	units = 2;
+	remain = PrefetchState == psPending ? 1 : 2;
+}
+//---------------------------------------------------------------------------
+bool tTVPWaveLoopManager::DoPrefetch()
+{
+	// called on a decoding thread. PrefetchDecoder and PrefetchSamples
+	// belong to this thread while PrefetchState is psBusy; nothing guarded
+	// by DataCS is touched here.
+	tjs_int64 target;
+	tjs_int len;
 	{
-		if(Format->BytesPerSample == 1)
+		volatile tTJSCriticalSectionHolder CS(PrefetchCS);
+		if(PrefetchState != psPending) return false;
+		PrefetchState = psBusy;
+		target = PrefetchTarget;
+		len = PrefetchRequestLen;
+	}
+
+	bool unavailable = false;
+	if(!PrefetchDecoder)
+	{
+		// open the spare decoder at the first request. the PCM cache is not
+		// used; it is not thread safe, and a cached clip needs no prefetch.
+		tTVPWaveDecoder *decoder = NULL;
+		try
 		{
-			TVPCrossFadeIntegerBlend<tTVPPCM8>(dest, src1, src2,
-				ratiostart, ratioend, samples, Format->Channels);
+			decoder = TVPCreateWaveDecoderFromCreators(PrefetchStorage);
 		}
-		else if(Format->BytesPerSample == 2)
+		catch(...)
 		{
-			TVPCrossFadeIntegerBlend<tjs_int16>(dest, src1, src2,
-				ratiostart, ratioend, samples, Format->Channels);
+			decoder = NULL;
 		}
-		else if(Format->BytesPerSample == 3)
+
+		if(decoder)
 		{
-			TVPCrossFadeIntegerBlend<tTVPPCM24>(dest, src1, src2,
-				ratiostart, ratioend, samples, Format->Channels);
+			tTVPWaveFormat format;
+			decoder->GetFormat(format);
+			if(format.SamplesPerSec != Format->SamplesPerSec ||
+				format.Channels != Format->Channels ||
+				format.BytesPerSample != Format->BytesPerSample ||
+				format.BitsPerSample != Format->BitsPerSample ||
+				format.IsFloat != Format->IsFloat ||
+				!format.Seekable)
+			{
+				delete decoder;
+				decoder = NULL;
+			}
 		}
-		else if(Format->BytesPerSample == 4)
+
+		if(decoder)
+			PrefetchDecoder = OwnDecoder = decoder;
+		else
+			unavailable = true;
+	}
+
+	tjs_uint rendered = 0;
+	if(PrefetchDecoder)
+	{
+		try
 		{
-			TVPCrossFadeIntegerBlend<tjs_int32>(dest, src1, src2,
-				ratiostart, ratioend, samples, Format->Channels);
+			if(PrefetchDecoder->SetPosition(target))
+				PrefetchDecoder->Render((void *)PrefetchSamples, (tjs_uint)len,
+					rendered);
+		}
+		catch(...)
+		{
+			rendered = 0;
 		}
 	}
+
+	{
+		volatile tTJSCriticalSectionHolder CS(PrefetchCS);
+		PrefetchState = psReady;
+		PrefetchLen = (tjs_int)rendered;
+		if(unavailable) PrefetchUnavailable = true;
+	}
+	return true;
 }
-//---------------------------------------------------------------------------
-void tTVPWaveLoopManager::ClearCrossFadeInformation()
-{
-	if(CrossFadeSamples) delete [] CrossFadeSamples, CrossFadeSamples = NULL;
-}
+#endif
 //---------------------------------------------------------------------------
 bool tTVPWaveLoopManager::GetLabelExpression(const tTVPLabelStringType &label,
 	tTVPWaveLoopManager::tExpressionToken * ope,
@@ -25,6 +25,12 @@
 #define TVP_WL_SMOOTH_TIME 50
 #define TVP_WL_SMOOTH_TIME_HALF (TVP_WL_SMOOTH_TIME/2)
 
+#define TVP_WL_PREFETCH_TIME 250
+	// length of the jump target region decoded ahead, in ms
+#define TVP_WL_PREFETCH_LEAD_TIME 1000
+	// the jump target is decoded ahead when the decoding comes this close
+	// to the jump, in ms
+
 #define TVP_WL_MAX_ID_LEN 16
 
 #ifdef TVP_IN_LOOP_TUNER
@@ -80,6 +86,17 @@
 //---------------------------------------------------------------------------
 
 
+//---------------------------------------------------------------------------
+// tTVPWaveCrossFadeCurve : gain curve of the smooth link crossfade
+//---------------------------------------------------------------------------
+enum tTVPWaveCrossFadeCurve
+{
+	wcfcLinear,			// gains are 1-r and r (for correlated material)
+	wcfcEqualPower		// gains are cos and sin (keeps the power constant)
+};
+//---------------------------------------------------------------------------
+
+
 //---------------------------------------------------------------------------
 // tTVPWaveLoopLink : link structure
 //---------------------------------------------------------------------------
@@ -170,6 +187,7 @@ bool inline operator < (const tTVPWaveLoopLink & lhs, const tTVPWaveLoopLink & r
 //---------------------------------------------------------------------------
 class tTVPWaveDecoder;
 struct tTVPWaveFormat;
+class tTVPWaveLoopPrefetcher;
 class tTVPSampleAndLabelSource
 {
 public:
@@ -188,6 +206,8 @@ public:
 //---------------------------------------------------------------------------
 class tTVPWaveLoopManager : public tTVPSampleAndLabelSource
 {
+	friend class tTVPWaveLoopPrefetcher;
+
 	tTJSCriticalSection FlagsCS; // CS to protect flags/links/labels
 	int Flags[TVP_WL_MAX_FLAGS];
 	bool FlagsModifiedByLabelExpression; // true if the flags are modified by EvalLabelExpression
@@ -207,6 +227,41 @@ class tTVPWaveLoopManager : public tTVPSampleAndLabelSource
 	tjs_uint8 *CrossFadeSamples; // sample buffer for crossfading
 	tjs_int CrossFadeLen;
 	tjs_int CrossFadePosition;
+	tTVPWaveCrossFadeCurve CrossFadeCurve;
+
+	enum tPrefetchState
+	{
+		psNone, // no request
+		psPending, // PrefetchTarget is requested
+		psBusy, // the prefetcher is decoding PrefetchTarget
+		psReady // PrefetchLen samples at PrefetchTarget are ready
+	};
+	tTJSCriticalSection PrefetchCS;
+		// CS to protect the members below which the prefetcher touches
+	tTVPWaveLoopPrefetcher * Prefetcher;
+		// decodes the predicted jump target on a decoding thread;
+		// NULL if prefetching is not enabled
+	tTVPWaveDecoder * PrefetchDecoder;
+		// spare decoder which is seeked to the predicted jump target in
+		// advance; swapped with Decoder when the jump actually occurs.
+		// opened by the prefetcher at the first request.
+	tTVPWaveDecoder * OwnDecoder;
+		// the decoder which this object opened; either Decoder or
+		// PrefetchDecoder after swapping
+#ifndef TVP_IN_LOOP_TUNER
+	ttstr PrefetchStorage; // storage to open PrefetchDecoder from
+#endif
+	tjs_int PrefetchLeadSamples; // TVP_WL_PREFETCH_LEAD_TIME in sample unit
+	bool PrefetchUnavailable; // PrefetchDecoder could not be opened
+	tPrefetchState PrefetchState;
+	tjs_uint8 *PrefetchSamples; // side buffer; decoded samples at PrefetchTarget
+	tjs_int PrefetchBufferSamples; // capacity of PrefetchSamples
+	tjs_int PrefetchRequestLen; // samples to decode at PrefetchTarget
+	tjs_int PrefetchLen; // valid samples in PrefetchSamples
+	tjs_int PrefetchPosition; // samples already consumed from PrefetchSamples
+	tjs_int64 PrefetchTarget; // prefetched jump target (-1 for none)
+	bool PrefetchServing; // true while PrefetchSamples is being consumed
+	tjs_int PrefetchedJumpCount; // jumps served from PrefetchSamples
 
 	bool IsLinksSorted; // false if links are not yet sorted
 	bool IsLabelsSorted; // false if labels are not yet sorted
@@ -218,6 +273,16 @@ public:
 	virtual ~tTVPWaveLoopManager();
 
 	void SetDecoder(tTVPWaveDecoder * decoder);
+#ifndef TVP_IN_LOOP_TUNER
+	void SetPrefetchStorage(const ttstr & storage);
+		// enables prefetching of jump targets; another decoder of
+		// 'storage', which must be the storage of the decoder given to
+		// SetDecoder, is opened when a jump comes close. the decoders may
+		// be swapped internally, but the caller still frees the one it gave
+		// to SetDecoder (after this object is deleted).
+	tjs_int GetPrefetchedJumpCount() const { return PrefetchedJumpCount; }
+		// the number of jumps which were served from the prefetched samples
+#endif
 
 	int GetFlag(tjs_int index);
 	void CopyFlags(tjs_int *dest);
@@ -241,6 +306,9 @@ public:
 	bool GetLooping() const { return Looping; }
 	void SetLooping(bool b) { Looping = b; }
 
+	tTVPWaveCrossFadeCurve GetCrossFadeCurve() const { return CrossFadeCurve; }
+	void SetCrossFadeCurve(tTVPWaveCrossFadeCurve c) { CrossFadeCurve = c; }
+
 	void Decode(void *dest, tjs_uint samples, tjs_uint &written,
 		tTVPWaveSegmentQueue & segments); // from tTVPSampleAndLabelSource
 
@@ -259,6 +327,11 @@ private:
 
 	void ClearCrossFadeInformation();
 
+	void PrefetchJumpTarget(tjs_int64 target);
+	bool UsePrefetchedJumpTarget(tjs_int64 target);
+	void GetPrefetchStatus(tjs_int &remain, tjs_int &units);
+	bool DoPrefetch(); // called by the prefetcher on a decoding thread
+
 //--- flag manupulation by label expression
 	enum tExpressionToken {
 		etUnknown,
@@ -25,6 +25,7 @@
 #include "Random.h"
 #include "UtilStreams.h"
 #include "TickCount.h"
+#include "WaveDecodeScheduler.h"
 
 #ifdef TVP_SUPPORT_OLD_WAVEUNPACKER
 	#include "oldwaveunpacker.h"
@@ -46,8 +47,6 @@
 //---------------------------------------------------------------------------
 // Options management
 //---------------------------------------------------------------------------
-static tTVPThreadPriority TVPDecodeThreadHighPriority = ttpHigher;
-static tTVPThreadPriority TVPDecodeThreadLowPriority = ttpLowest;
 static bool TVPSoundOptionsInit = false;
 static bool TVPControlPrimaryBufferRun = true;
 static bool TVPUseSoftwareBuffer = true;
@@ -65,6 +64,8 @@ static tjs_int TVPL1BufferLength = 1000; // in ms
 static tjs_int TVPL2BufferLength = 1000; // in ms
 static bool TVPDirectSoundUse3D = false;
 static tjs_int TVPVolumeLogFactor = 3322;
+static bool TVPWaveLoopPrefetch = true;
+static tTVPWaveCrossFadeCurve TVPWaveLoopCrossFadeCurve = wcfcLinear;
 //---------------------------------------------------------------------------
 static void TVPInitSoundOptions()
 {
@@ -87,9 +88,15 @@ static void TVPInitSoundOptions()
 		tjs_int v = val;
 		if(v < 0) v = 0;
 		if(v > 5) v = 5; // tpTimeCritical is dangerous...
-		TVPDecodeThreadLowPriority = (tTVPThreadPriority)v;
-		if(TVPDecodeThreadHighPriority<TVPDecodeThreadLowPriority)
-			TVPDecodeThreadHighPriority = TVPDecodeThreadLowPriority;
+		TVPWaveDecodeThreadLowPriority = (tTVPThreadPriority)v;
+		if(TVPWaveDecodeThreadHighPriority<TVPWaveDecodeThreadLowPriority)
+			TVPWaveDecodeThreadHighPriority = TVPWaveDecodeThreadLowPriority;
+	}
+
+	if(TVPGetCommandLine(TJS_W("-wsdecthread"), &val))
+	{
+		tjs_int n = (tjs_int)val;
+		if(n >= 0 && n <= 8) TVPWaveDecodeThreadNum = n;
 	}
 
 	if(TVPGetCommandLine(TJS_W("-wscontrolpri"), &val))
@@ -116,6 +123,34 @@ static void TVPInitSoundOptions()
 			TVPAlwaysRecreateSoundBuffer = false;
 	}
 
+	if(TVPGetCommandLine(TJS_W("-wsloopprefetch"), &val))
+	{
+		// decode loop jump targets in advance with a spare decoder, on the
+		// decoding threads
+		if(ttstr(val) == TJS_W("yes"))
+			TVPWaveLoopPrefetch = true;
+		else
+			TVPWaveLoopPrefetch = false;
+	}
+
+	if(TVPGetCommandLine(TJS_W("-wsloopcurve"), &val))
+	{
+		// gain curve of smooth link crossfades
+		if(ttstr(val) == TJS_W("equalpower"))
+			TVPWaveLoopCrossFadeCurve = wcfcEqualPower;
+		else
+			TVPWaveLoopCrossFadeCurve = wcfcLinear;
+	}
+
+	if(TVPGetCommandLine(TJS_W("-wsdither"), &val))
+	{
+		// TPDF dither on float to 16bit conversion
+		if(ttstr(val) == TJS_W("yes"))
+			TVPSetPCMConvertDither(true);
+		else
+			TVPSetPCMConvertDither(false);
+	}
+
 	if(TVPGetCommandLine(TJS_W("-wsfreq"), &val))
 	{
 		TVPPriamrySBFrequency = val;
@@ -204,6 +239,24 @@ static void TVPInitSoundOptions()
 		if(n > 0 && n < 600000) TVPL2BufferLength = n;
 	}
 
+	{
+		// decoded PCM cache size in KB, and the longest clip to be cached in
+		// ms; each can be given without the other
+		tjs_uint64 limit = TVPGetWavePCMCacheLimit();
+		tjs_uint len = TVPGetWavePCMCacheMaxClipTime();
+		if(TVPGetCommandLine(TJS_W("-wspcmcache"), &val))
+		{
+			tjs_int n = (tjs_int)val;
+			if(n >= 0 && n < 1024*1024) limit = (tjs_uint64)n * 1024;
+		}
+		if(TVPGetCommandLine(TJS_W("-wspcmcachelen"), &val))
+		{
+			tjs_int n = (tjs_int)val;
+			if(n > 0) len = n;
+		}
+		TVPSetWavePCMCacheLimit(limit, len);
+	}
+
 	if(TVPGetCommandLine(TJS_W("-wsvolfactor"), &val))
 	{
 		tjs_int n = (tjs_int)val;
@@ -1447,6 +1500,9 @@ tTJSCriticalSection TVPWaveSoundBufferVectorCS;
 	The playing thread fills each sound buffer's L1 (DirectSound) buffer, and
 	also manages timing for label events.
 	The technique used in this algorithm is similar to Timer claass implementation.
+	Label events are kept by each sound buffer as exact output sample
+	positions; the thread sleeps until the nearest one is due and then asks
+	the main thread to fire them, instead of polling at every wake-up.
 */
 class tTVPWaveSoundBufferThread : public tTVPThread
 {
@@ -1457,6 +1513,7 @@ class tTVPWaveSoundBufferThread : public tTVPThread
 	bool WndProcToBeCalled;
 	DWORD NextLabelEventTick;
 	DWORD LastFilledTick;
+	bool HighTimerPeriod; // timeBeginPeriod(1) is in effect for label timing
 
 	NativeEventQueue<tTVPWaveSoundBufferThread> EventQueue;
 public:
@@ -1488,6 +1545,7 @@ tTVPWaveSoundBufferThread::tTVPWaveSoundBufferThread()
 	NextLabelEventTick = 0;
 	LastFilledTick = 0;
 	WndProcToBeCalled = false;
+	HighTimerPeriod = false;
 	SetPriority(ttpHighest);
 	Resume();
 }
@@ -1513,15 +1571,13 @@ void tTVPWaveSoundBufferThread::UtilWndProc( NativeEvent& ev )
 
 		WndProcToBeCalled = false;
 
-		tjs_int64 tick = TVPGetTickCount();
-
 		int nearest_next = TVP_TIMEOFS_INVALID_VALUE;
 
 		std::vector<tTJSNI_WaveSoundBuffer *>::iterator i;
 		for(i = TVPWaveSoundBufferVector.begin();
 			i != TVPWaveSoundBufferVector.end(); i++)
 		{
-			int next = (*i)->FireLabelEventsAndGetNearestLabelEventStep(tick);
+			int next = (*i)->FireLabelEventsAndGetNearestLabelEventStep();
 				// fire label events and get nearest label event step
 			if(next != TVP_TIMEOFS_INVALID_VALUE)
 			{
@@ -1534,6 +1590,7 @@ void tTVPWaveSoundBufferThread::UtilWndProc( NativeEvent& ev )
 		{
 			PendingLabelEventExists = true;
 			NextLabelEventTick = timeGetTime() + nearest_next;
+			Event.Set(); // let the thread re-calculate its sleep time
 		}
 		else
 		{
@@ -1556,12 +1613,16 @@ void tTVPWaveSoundBufferThread::ReschedulePendingLabelEvent(tjs_int tick)
 	if(PendingLabelEventExists)
 	{
 		if((tjs_int32)NextLabelEventTick - (tjs_int32)eventtick > 0)
+		{
 			NextLabelEventTick = eventtick;
+			Event.Set();
+		}
 	}
 	else
 	{
 		PendingLabelEventExists = true;
 		NextLabelEventTick = eventtick;
+		Event.Set();
 	}
 }
 //---------------------------------------------------------------------------
@@ -1577,8 +1638,9 @@ void tTVPWaveSoundBufferThread::Execute(void)
 		{	// thread-protected
 			tTJSCriticalSectionHolder holder(TVPWaveSoundBufferVectorCS);
 
-			// check PendingLabelEventExists
-			if(PendingLabelEventExists)
+			// check whether the nearest label event is due
+			if(PendingLabelEventExists &&
+				(tjs_int32)(time - NextLabelEventTick) >= 0)
 			{
 				if(!WndProcToBeCalled)
 				{
@@ -1607,13 +1669,28 @@ void tTVPWaveSoundBufferThread::Execute(void)
 		if(time < TVP_WSB_THREAD_SLEEP_TIME)
 		{
 			tjs_int sleep_time = TVP_WSB_THREAD_SLEEP_TIME - time;
-			if(PendingLabelEventExists)
+			bool label_timing = false;
+			if(PendingLabelEventExists && !WndProcToBeCalled)
 			{
+				// wake up exactly when the nearest label event is due.
+				// the main thread re-schedules after firing the events.
 				tjs_int step_to_next = (tjs_int32)NextLabelEventTick - (tjs_int32)time2;
 				if(step_to_next < sleep_time)
+				{
 					sleep_time = step_to_next;
+					label_timing = true;
+				}
 				if(sleep_time < 1) sleep_time = 1;
 			}
+
+			// the default system timer resolution (typically 15.6ms) is too
+			// coarse for label events; raise it only while waiting for one.
+			if(label_timing != HighTimerPeriod)
+			{
+				if(label_timing) timeBeginPeriod(1); else timeEndPeriod(1);
+				HighTimerPeriod = label_timing;
+			}
+
 			Event.WaitFor(sleep_time);
 		}
 		else
@@ -1621,6 +1698,8 @@ void tTVPWaveSoundBufferThread::Execute(void)
 			Event.WaitFor(1);
 		}
 	}
+
+	if(HighTimerPeriod) timeEndPeriod(1), HighTimerPeriod = false;
 }
 //---------------------------------------------------------------------------
 void tTVPWaveSoundBufferThread::Start()
@@ -1670,6 +1749,7 @@ static void TVPShutdownWaveSoundBuffers()
 	// clean up soundbuffers at exit
 	if(TVPWaveSoundBufferThread)
 		delete TVPWaveSoundBufferThread, TVPWaveSoundBufferThread = NULL;
+	TVPShutdownWaveDecodeThreads();
 	TVPReleaseSoundBuffers();
 }
 static tTVPAtExit TVPShutdownWaveSoundBuffersAtExit
@@ -1760,122 +1840,6 @@ bool TVPGetWaveSoundBufferUse3DMode()
 
 
 
-//---------------------------------------------------------------------------
-// tTVPWaveSoundBufferDcodeThread : decoding thread
-//---------------------------------------------------------------------------
-class tTVPWaveSoundBufferDecodeThread : public tTVPThread
-{
-	tTJSNI_WaveSoundBuffer * Owner;
-	tTVPThreadEvent Event;
-	tTJSCriticalSection OneLoopCS;
-	volatile bool Running;
-
-public:
-	tTVPWaveSoundBufferDecodeThread(tTJSNI_WaveSoundBuffer * owner);
-	~tTVPWaveSoundBufferDecodeThread();
-
-	void Execute(void);
-
-	void Interrupt();
-	void Continue();
-
-	bool GetRunning() const { return Running; }
-};
-//---------------------------------------------------------------------------
-tTVPWaveSoundBufferDecodeThread::tTVPWaveSoundBufferDecodeThread(
-	tTJSNI_WaveSoundBuffer * owner)
-	: tTVPThread(true)
-{
-	TVPInitSoundOptions();
-
-	Owner = owner;
-	SetPriority(TVPDecodeThreadHighPriority);
-	Running = false;
-	Resume();
-}
-//---------------------------------------------------------------------------
-tTVPWaveSoundBufferDecodeThread::~tTVPWaveSoundBufferDecodeThread()
-{
-	SetPriority(TVPDecodeThreadHighPriority);
-	Running = false;
-	Terminate();
-	Resume();
-	Event.Set();
-	WaitFor();
-}
-//---------------------------------------------------------------------------
-#define TVP_WSB_DECODE_THREAD_SLEEP_TIME 110
-void tTVPWaveSoundBufferDecodeThread::Execute(void)
-{
-	while(!GetTerminated())
-	{
-		// decoder thread main loop
-		DWORD st = GetTickCount();
-		while(Running)
-		{
-			bool wait;
-			DWORD et;
-
-			if(Running)
-			{
-				volatile tTJSCriticalSectionHolder cs_holder(OneLoopCS);
-				wait = !Owner->FillL2Buffer(false, true); // fill
-			}
-
-			if(GetTerminated()) break;
-
-			if(Running)
-			{
-				et = GetTickCount();
-				TVPPushEnvironNoise(&et, sizeof(et));
-				if(wait)
-				{
-					// buffer is full; sleep longer
-					DWORD elapsed = et -st;
-					if(elapsed < TVP_WSB_DECODE_THREAD_SLEEP_TIME)
-					{
-						Event.WaitFor(
-							TVP_WSB_DECODE_THREAD_SLEEP_TIME - elapsed);
-					}
-				}
-				else
-				{
-					// buffer is not full; sleep shorter
-					Sleep(1);
-					if(!GetTerminated()) SetPriority(TVPDecodeThreadLowPriority);
-				}
-				st = et;
-			}
-		}
-		if(GetTerminated()) break;
-		// sleep while running
-		Event.WaitFor(INFINITE);
-	}
-}
-//---------------------------------------------------------------------------
-void tTVPWaveSoundBufferDecodeThread::Interrupt()
-{
-	// interrupt the thread
-	if(!Running) return;
-	SetPriority(TVPDecodeThreadHighPriority);
-	Event.Set();
-	tTJSCriticalSectionHolder cs_holder(OneLoopCS);
-		// this ensures that this function stops the decoding
-	Running = false;
-}
-//---------------------------------------------------------------------------
-void tTVPWaveSoundBufferDecodeThread::Continue()
-{
-	SetPriority(TVPDecodeThreadHighPriority);
-	Running = true;
-	Event.Set();
-}
-//---------------------------------------------------------------------------
-
-
-
-
-
 //---------------------------------------------------------------------------
 // tTJSNI_WaveSoundBuffer
 //---------------------------------------------------------------------------
@@ -1895,12 +1859,10 @@ tTJSNI_WaveSoundBuffer::tTJSNI_WaveSoundBuffer()
 	TVPInitLogTable();
 	Decoder = NULL;
 	LoopManager = NULL;
-	Thread = NULL;
+	DecodeTask = NULL;
 	UseVisBuffer = false;
 	VisBuffer = NULL;
 	ThreadCallbackEnabled = false;
-	Level2Buffer = NULL;
-	Level2BufferSize = 0;
 	Volume =  100000;
 	Volume2 = 100000;
 	BufferCanControlPan = false;
@@ -1908,15 +1870,13 @@ tTJSNI_WaveSoundBuffer::tTJSNI_WaveSoundBuffer()
 	PosX = PosY = PosZ = (D3DVALUE)0.0;
 	SoundBuffer = NULL;
 	Sound3DBuffer = NULL;
-	L2BufferDecodedSamplesInUnit = NULL;
 	L1BufferSegmentQueues = NULL;
-	L2BufferSegmentQueues = NULL;
 	L1BufferDecodeSamplePos = NULL;
 	DecodePos = 0;
 	L1BufferUnits = 0;
-	L2BufferUnits = 0;
 	TVPAddWaveSoundBuffer(this);
-	Thread = new tTVPWaveSoundBufferDecodeThread(this);
+	L2Buffer = new tTVPWaveL2Buffer(this);
+	DecodeTask = new tTVPWaveDecodeTask(L2Buffer);
 	ZeroMemory(&C_InputFormat, sizeof(C_InputFormat));
 	ZeroMemory(&InputFormat, sizeof(InputFormat));
 	ZeroMemory(&Format, sizeof(Format));
@@ -1927,14 +1887,9 @@ tTJSNI_WaveSoundBuffer::tTJSNI_WaveSoundBuffer()
 	BufferBytes = 0;
 	AccessUnitBytes = 0;
 	AccessUnitSamples = 0;
-	L2AccessUnitBytes = 0;
 	SoundBufferPrevReadPos = 0;
 	SoundBufferWritePos = 0;
 	PlayStopPos = 0;
-	L2BufferReadPos = 0;
-	L2BufferWritePos = 0;
-	L2BufferRemain = 0;
-	L2BufferEnded = false;
 	LastCheckedDecodePos = -1;
 	LastCheckedTick = 0;
 }
@@ -1957,7 +1912,8 @@ void TJS_INTF_METHOD tTJSNI_WaveSoundBuffer::Invalidate()
 
 	DestroySoundBuffer();
 
-	if(Thread) delete Thread, Thread = NULL;
+	if(DecodeTask) delete DecodeTask, DecodeTask = NULL;
+	if(L2Buffer) delete L2Buffer, L2Buffer = NULL;
 
 	TVPRemoveWaveSoundBuffer(this);
 }
@@ -1996,18 +1952,11 @@ void tTJSNI_WaveSoundBuffer::TryCreateSoundBuffer(bool use3d)
 	if(UseVisBuffer) ResetVisBuffer();
 
 	// allocate level2 buffer ( 4sec. buffer )
-	L2BufferUnits = TVPL2BufferLength / (1000 / TVP_WSB_ACCESS_FREQ);
-	if(L2BufferUnits <= 1) L2BufferUnits = 2;
-
-	if(L2BufferDecodedSamplesInUnit) delete [] L2BufferDecodedSamplesInUnit, L2BufferDecodedSamplesInUnit = NULL;
-	if(L2BufferSegmentQueues) delete [] L2BufferSegmentQueues, L2BufferSegmentQueues = NULL;
-	L2BufferDecodedSamplesInUnit = new tjs_int[L2BufferUnits];
-	L2BufferSegmentQueues = new tTVPWaveSegmentQueue[L2BufferUnits];
+	tjs_int l2units = TVPL2BufferLength / (1000 / TVP_WSB_ACCESS_FREQ);
+	if(l2units <= 1) l2units = 2;
 
-	L2AccessUnitBytes = AccessUnitSamples * InputFormat.BytesPerSample * InputFormat.Channels;
-	Level2BufferSize = L2AccessUnitBytes * L2BufferUnits;
-	if(Level2Buffer) delete [] Level2Buffer, Level2Buffer = NULL;
-	Level2Buffer = new tjs_uint8[Level2BufferSize];
+	L2Buffer->Allocate(l2units, AccessUnitSamples,
+		AccessUnitSamples * InputFormat.BytesPerSample * InputFormat.Channels);
 
 	// setup parameters
 	DSBUFFERDESC dsbd;
@@ -2069,8 +2018,7 @@ void tTJSNI_WaveSoundBuffer::TryCreateSoundBuffer(bool use3d)
 	{
 		if(SoundBuffer) SoundBuffer->Release();
 		SoundBuffer = NULL;
-		delete [] Level2Buffer;
-		Level2Buffer = NULL;
+		L2Buffer->Free();
 		ThrowSoundBufferException(
 			ttstr(TJS_W("IDirectSound::CreateSoundBuffer ")
 				TJS_W("(on to create a secondary buffer) failed./HR=") +
@@ -2254,16 +2202,11 @@ void tTJSNI_WaveSoundBuffer::DestroySoundBuffer()
 	if(L1BufferSegmentQueues) delete [] L1BufferSegmentQueues, L1BufferSegmentQueues = NULL;
 	LabelEventQueue.clear();
 	if(L1BufferDecodeSamplePos) delete [] L1BufferDecodeSamplePos, L1BufferDecodeSamplePos = NULL;
-	if(L2BufferDecodedSamplesInUnit) delete [] L2BufferDecodedSamplesInUnit, L2BufferDecodedSamplesInUnit = NULL;
-	if(L2BufferSegmentQueues) delete [] L2BufferSegmentQueues, L2BufferSegmentQueues = NULL;
-	if(Level2Buffer) delete [] Level2Buffer, Level2Buffer = NULL;
+	L2Buffer->Free();
 	L1BufferUnits = 0;
-	L2BufferUnits = 0;
 
 	ZeroMemory(&C_InputFormat, sizeof(C_InputFormat));
 
-	Level2BufferSize = 0;
-
 	DeallocateVisBuffer();
 }
 //---------------------------------------------------------------------------
@@ -2297,7 +2240,8 @@ void tTJSNI_WaveSoundBuffer::ResetSoundBuffer()
 		SoundBuffer->SetCurrentPosition(0);
 
 		// fill level2 buffer with silence
-		TVPMakeSilentWaveBytes(Level2Buffer, Level2BufferSize, &Format);
+		TVPMakeSilentWaveBytes(L2Buffer->GetBuffer(), L2Buffer->GetBufferSize(),
+			&Format);
 	}
 
 	ResetSamplePositions();
@@ -2305,17 +2249,13 @@ void tTJSNI_WaveSoundBuffer::ResetSoundBuffer()
 //---------------------------------------------------------------------------
 void tTJSNI_WaveSoundBuffer::ResetSamplePositions()
 {
-	// reset L1BufferSegmentQueues and L2BufferSegmentQueues, and labels
+	// reset L1BufferSegmentQueues and segment queues in L2Buffer, and labels
 	if(L1BufferSegmentQueues)
 	{
 		for(int i = 0; i < L1BufferUnits; i++)
 			L1BufferSegmentQueues[i].Clear();
 	}
-	if(L2BufferSegmentQueues)
-	{
-		for(int i = 0; i < L2BufferUnits; i++)
-			L2BufferSegmentQueues[i].Clear();
-	}
+	L2Buffer->ClearSegments();
 	if(L1BufferDecodeSamplePos)
 	{
 		for(int i = 0; i < L1BufferUnits; i++)
@@ -2331,7 +2271,7 @@ void tTJSNI_WaveSoundBuffer::Clear()
 	Stop();
 	ThreadCallbackEnabled = false;
 	TVPCheckSoundBufferAllSleep();
-	Thread->Interrupt();
+	DecodeTask->Interrupt();
 	if(LoopManager) delete LoopManager, LoopManager = NULL;
 	ClearFilterChain();
 	if(Decoder) delete Decoder, Decoder = NULL;
@@ -2364,103 +2304,65 @@ tjs_uint tTJSNI_WaveSoundBuffer::Decode(void *buffer, tjs_uint bufsamplelen,
 	return w;
 }
 //---------------------------------------------------------------------------
-bool tTJSNI_WaveSoundBuffer::FillL2Buffer(bool firstwrite, bool fromdecodethread)
+tjs_uint tTJSNI_WaveSoundBuffer::DecodeL2Unit(void *buffer,
+	tjs_uint bufsamplelen, tTVPWaveSegmentQueue & segments)
 {
-	if(!fromdecodethread && Thread->GetRunning())
-		Thread->SetPriority(ttpHighest);
-			// make decoder thread priority high, before entering critical section
-
-	tTJSCriticalSectionHolder holder(L2BufferCS);
+	// called by L2Buffer with its critical section held
+	UpdateFilterChain(); // the buffer is not full; update filter internal state
 
-	if(firstwrite)
-	{
-		// only main thread runs here
-		L2BufferReadPos = L2BufferWritePos = L2BufferRemain = 0;
-		L2BufferEnded = false;
-		for(tjs_int i = 0; i<L2BufferUnits; i++)
-			L2BufferDecodedSamplesInUnit[i] = 0;
-	}
+	tjs_uint decoded = Decode(buffer, bufsamplelen, segments);
 
-	{
-		tTVPThreadPriority ttpbefore = TVPDecodeThreadHighPriority;
-		bool retflag = false;
-		if(Thread->GetRunning())
-		{
-			ttpbefore = Thread->GetPriority();
-			Thread->SetPriority(TVPDecodeThreadHighPriority);
-		}
-		{
-			tTJSCriticalSectionHolder holder(L2BufferRemainCS);
-			if(L2BufferRemain == L2BufferUnits) retflag = true;
-		}
-		if(!retflag) UpdateFilterChain(); // if the buffer is not full, update filter internal state
-		if(Thread->GetRunning()) Thread->SetPriority(ttpbefore);
-		if(retflag) return false; // buffer is full
-	}
+	DWORD et = GetTickCount();
+	TVPPushEnvironNoise(&et, sizeof(et));
 
-	if(L2BufferEnded)
-	{
-		L2BufferSegmentQueues[L2BufferWritePos].Clear();
-		L2BufferDecodedSamplesInUnit[L2BufferWritePos] = 0;
-	}
-	else
-	{
-		L2BufferSegmentQueues[L2BufferWritePos].Clear();
-		tjs_uint decoded = Decode(
-			L2BufferWritePos * L2AccessUnitBytes + Level2Buffer,
-			AccessUnitSamples,
-			L2BufferSegmentQueues[L2BufferWritePos]);
-
-		if(decoded < (tjs_uint) AccessUnitSamples) L2BufferEnded = true;
-
-		L2BufferDecodedSamplesInUnit[L2BufferWritePos] = decoded;
-	}
-
-	L2BufferWritePos++;
-	if(L2BufferWritePos >= L2BufferUnits) L2BufferWritePos = 0;
-
-	{
-		tTVPThreadPriority ttpbefore = TVPDecodeThreadHighPriority;
-		if(Thread->GetRunning())
-		{
-			ttpbefore = Thread->GetPriority();
-			Thread->SetPriority(TVPDecodeThreadHighPriority);
-		}
-		{
-			tTJSCriticalSectionHolder holder(L2BufferRemainCS);
-			L2BufferRemain++;
-		}
-		if(Thread->GetRunning()) Thread->SetPriority(ttpbefore);
-	}
+	return decoded;
+}
+//---------------------------------------------------------------------------
+bool tTJSNI_WaveSoundBuffer::FillL2Buffer(bool firstwrite)
+{
+	// fill one unit on the playing (or main) thread
+	if(DecodeTask->GetRunning())
+		DecodeTask->SetPriority(ttpHighest);
+			// make decoder thread priority high, before entering critical section
 
-	return true;
+	return L2Buffer->Fill(firstwrite);
 }
 //---------------------------------------------------------------------------
 void tTJSNI_WaveSoundBuffer::PrepareToReadL2Buffer(bool firstread)
 {
-	if(L2BufferRemain == 0 && !L2BufferEnded)
-		FillL2Buffer(firstread, false);
+	if(L2Buffer->GetReadableUnits() == 0)
+		FillL2Buffer(firstread);
 
-	if(Thread->GetRunning()) Thread->SetPriority(TVPDecodeThreadHighPriority);
+	if(DecodeTask->GetRunning()) DecodeTask->SetPriority(TVPWaveDecodeThreadHighPriority);
 			// make decoder thread priority higher than usual,
 			// before entering critical section
 }
 //---------------------------------------------------------------------------
 tjs_uint tTJSNI_WaveSoundBuffer::ReadL2Buffer(void *buffer,
-		tTVPWaveSegmentQueue & segments)
+		tTVPWaveSegmentQueue & segments, bool & underrun)
 {
-	// This routine is protected by BufferCS, not L2BufferCS, while
-	// this routine reads L2 buffer.
-	// But It's ok because this function will never read currently writing L2
-	// buffer. L2 buffer having at least one rendered unit is
-	// guaranteed at this point.
+	// This routine is protected by BufferCS, not the critical section of
+	// L2Buffer, while this routine reads L2 buffer.
+	// It's ok because L2Buffer never hands out the unit which is currently
+	// being written.
 
-	tjs_uint decoded = L2BufferDecodedSamplesInUnit[L2BufferReadPos];
+	tjs_uint decoded;
+	const tjs_uint8 * unit = L2Buffer->BeginRead(decoded, segments);
+	if(!unit)
+	{
+		// no decoded unit is available; this happens only if the decoder
+		// could not keep up. fill with silence.
+		// this is not the end of the stream; "underrun" tells the caller
+		// not to take the short unit as the end.
+		segments.Clear();
+		TVPMakeSilentWave(buffer, AccessUnitSamples, &Format);
+		underrun = true;
+		return 0;
+	}
 
-	segments = L2BufferSegmentQueues[L2BufferReadPos];
+	underrun = false;
 
-	TVPConvertWaveFormatToDestinationFormat(buffer,
-		L2BufferReadPos * L2AccessUnitBytes + Level2Buffer, decoded,
+	TVPConvertWaveFormatToDestinationFormat(buffer, unit, decoded,
 		&Format, &InputFormat);
 
 	if(decoded < (tjs_uint)AccessUnitSamples)
@@ -2470,13 +2372,7 @@ tjs_uint tTJSNI_WaveSoundBuffer::ReadL2Buffer(void *buffer,
 			AccessUnitSamples - decoded, &Format);
 	}
 
-	L2BufferReadPos++;
-	if(L2BufferReadPos >= L2BufferUnits) L2BufferReadPos = 0;
-
-	{
-		tTJSCriticalSectionHolder holder(L2BufferRemainCS);
-		L2BufferRemain--;
-	}
+	L2Buffer->EndRead(); // give the unit back to the decoder
 
 	return decoded;
 }
@@ -2503,18 +2399,25 @@ void tTJSNI_WaveSoundBuffer::FillDSBuffer(tjs_int writepos,
 	if(SUCCEEDED(hr))
 	{
 		tjs_uint decoded;
+		bool underrun;
 
 		if(UseVisBuffer)
 		{
-			decoded = ReadL2Buffer(VisBuffer + writepos, segments);
+			decoded = ReadL2Buffer(VisBuffer + writepos, segments, underrun);
 			memcpy(p1, VisBuffer + writepos, AccessUnitBytes);
 		}
 		else
 		{
-			decoded = ReadL2Buffer(p1, segments);
+			decoded = ReadL2Buffer(p1, segments, underrun);
 		}
 
-		if(PlayStopPos == -1 && decoded < (tjs_uint)AccessUnitSamples)
+		if(underrun)
+		{
+			// the unit was filled with silence and playing goes on; the
+			// decoder is boosted to catch up
+			if(DecodeTask->GetRunning()) DecodeTask->SetPriority(ttpHighest);
+		}
+		else if(PlayStopPos == -1 && decoded < (tjs_uint)AccessUnitSamples)
 		{
 			// decoding was finished
 			PlayStopPos = writepos + decoded*Format.Format.nBlockAlign;
@@ -2558,14 +2461,10 @@ bool tTJSNI_WaveSoundBuffer::FillBuffer(bool firstwrite, bool allowpause)
 	}
 
 	// check decoder thread status
-	tjs_int bufferremain;
-	{
-		tTJSCriticalSectionHolder holder(L2BufferRemainCS);
-		bufferremain = L2BufferRemain;
-	}
+	tjs_int bufferremain = L2Buffer->GetReadableUnits();
 
-	if(Thread->GetRunning() && bufferremain < TVP_WSB_ACCESS_FREQ )
-		Thread->SetPriority(ttpNormal); // buffer remains under 1 sec 
+	if(DecodeTask->GetRunning() && bufferremain < TVP_WSB_ACCESS_FREQ )
+		DecodeTask->SetPriority(ttpNormal); // buffer remains under 1 sec 
 
 	// check buffer playing position
 	tjs_int writepos;
@@ -2654,39 +2553,29 @@ bool tTJSNI_WaveSoundBuffer::FillBuffer(bool firstwrite, bool allowpause)
 	SoundBufferPrevReadPos = pp;
 
 	// decode
-	if(bufferremain > 1) // buffer is ready
-	{
-		// with no locking operations
-		FillDSBuffer(writepos, *segment);
-	}
-	else
-	{
+	if(bufferremain == 0)
 		PrepareToReadL2Buffer(false); // complete decoding before reading from L2
 
-		{
-			tTJSCriticalSectionHolder l2holder(L2BufferCS);
-			FillDSBuffer(writepos, *segment);
-		}
-	}
+	// reading from L2 needs no locking operations
+	FillDSBuffer(writepos, *segment);
 
-	// insert labels into LabelEventQueue and sort
+	// insert labels into LabelEventQueue
 	const std::deque<tTVPWaveLabel> & labels = segment->GetLabels();
 	if(labels.size() != 0)
 	{
-		// add DecodePos offset to each item->Offset
-		// and insert into LabelEventQueue
+		// add DecodePos offset to each item->Offset, which gives the exact
+		// output sample position of the label, and insert into
+		// LabelEventQueue keeping the order. labels usually come in
+		// ascending order, so this is an append in most cases.
 		for(std::deque<tTVPWaveLabel>::const_iterator i = labels.begin();
 			i != labels.end(); i++)
 		{
-			LabelEventQueue.push_back(
-				tTVPWaveLabel(i->Position,
-						i->Name, static_cast<tjs_int>(i->Offset + DecodePos)));
+			tLabelEvent ev(DecodePos + i->Offset, i->Name);
+			LabelEventQueue.insert(
+				std::upper_bound(LabelEventQueue.begin(), LabelEventQueue.end(), ev),
+				ev);
 		}
 
-		// sort
-		std::sort(LabelEventQueue.begin(), LabelEventQueue.end(),
-			tTVPWaveLabel::tSortByOffsetFuncObj());
-
 		// re-schedule label events
 		TVPReschedulePendingLabelEvent(GetNearestEventStep());
 	}
@@ -2722,12 +2611,46 @@ void tTJSNI_WaveSoundBuffer::ResetLastCheckedDecodePos(DWORD pp)
 	}
 }
 //---------------------------------------------------------------------------
-tjs_int tTJSNI_WaveSoundBuffer::FireLabelEventsAndGetNearestLabelEventStep(tjs_int64 tick)
+tjs_int64 tTJSNI_WaveSoundBuffer::GetPlayingDecodePos()
+{
+	// return the output sample position which is currently being played.
+	// the position is taken from the DirectSound play cursor each time, so
+	// that it does not drift from the device clock; the tick extrapolation
+	// from the last sured position is used only when the cursor can not
+	// be read (returns -1 if the position is not known at all).
+	tTJSCriticalSectionHolder holder(BufferCS);
+
+	if(SoundBuffer && DSBufferPlaying && L1BufferDecodeSamplePos)
+		ResetLastCheckedDecodePos();
+
+	if(LastCheckedDecodePos == -1) return -1;
+
+	return (TVPGetTickCount() - LastCheckedTick) * Frequency / 1000 +
+		LastCheckedDecodePos;
+}
+//---------------------------------------------------------------------------
+tjs_int tTJSNI_WaveSoundBuffer::GetLabelEventStep(tjs_int64 decodepos)
+{
+	// return the time in ms from decodepos to the nearest label event.
+	// the time is rounded up, so that the event is already due when the
+	// playing thread wakes up.
+	if(LabelEventQueue.size() == 0) return TVP_TIMEOFS_INVALID_VALUE; // no more events
+	if(decodepos == -1) return TVP_WSB_THREAD_SLEEP_TIME; // position is not known yet
+
+	tjs_int64 diff = LabelEventQueue.front().Position - decodepos;
+	if(diff <= 0) return 0;
+
+	tjs_int64 step = (diff * 1000 + Frequency - 1) / Frequency;
+	if(step > 0x3fffffff) step = 0x3fffffff;
+	return (tjs_int)step;
+}
+//---------------------------------------------------------------------------
+tjs_int tTJSNI_WaveSoundBuffer::FireLabelEventsAndGetNearestLabelEventStep()
 {
-	// fire events, event.EventTick <= tick, and return relative time to
-	// next nearest event (return TVP_TIMEOFS_INVALID_VALUE for no events).
+	// fire events whose position has been played, and return relative time
+	// to next nearest event (return TVP_TIMEOFS_INVALID_VALUE for no events).
 
-	// the vector LabelEventQueue must be sorted by the position.
+	// LabelEventQueue must be sorted by the position.
 	tTJSCriticalSectionHolder holder(BufferCS);
 
 	if(!BufferPlaying) return TVP_TIMEOFS_INVALID_VALUE; // buffer is not currently playing
@@ -2736,45 +2659,29 @@ tjs_int tTJSNI_WaveSoundBuffer::FireLabelEventsAndGetNearestLabelEventStep(tjs_i
 	if(LabelEventQueue.size() == 0) return TVP_TIMEOFS_INVALID_VALUE; // no more events
 
 	// calculate current playing decodepos
-	// at this point, LastCheckedDecodePos must not be -1
-	if(LastCheckedDecodePos == -1) ResetLastCheckedDecodePos();
-	tjs_int64 decodepos = (tick - LastCheckedTick) * Frequency / 1000 +
-		LastCheckedDecodePos;
+	tjs_int64 decodepos = GetPlayingDecodePos();
 
-	while(true)
+	if(decodepos != -1)
 	{
-		if(LabelEventQueue.size() == 0) break;
-		std::vector<tTVPWaveLabel>::iterator i = LabelEventQueue.begin();
-		int diff = (tjs_int32)i->Offset - (tjs_int32)decodepos;
-		if(diff <= 0)
-			InvokeLabelEvent(i->Name);
-		else
-			break;
-		LabelEventQueue.erase(i);
+		while(LabelEventQueue.size() != 0 &&
+			LabelEventQueue.front().Position <= decodepos)
+		{
+			InvokeLabelEvent(LabelEventQueue.front().Name);
+			LabelEventQueue.pop_front();
+		}
 	}
 
-	if(LabelEventQueue.size() == 0) return TVP_TIMEOFS_INVALID_VALUE; // no more events
-
-	return (tjs_int)(
-		(LabelEventQueue[0].Offset - (tjs_int32)decodepos) * 1000 / Frequency);
+	return GetLabelEventStep(decodepos);
 }
 //---------------------------------------------------------------------------
 tjs_int tTJSNI_WaveSoundBuffer::GetNearestEventStep()
 {
-	// get nearest event stop from current tick
-	// (current tick is taken from TVPGetTickCount)
+	// get nearest event step from current playing position
 	tTJSCriticalSectionHolder holder(BufferCS);
 
 	if(LabelEventQueue.size() == 0) return TVP_TIMEOFS_INVALID_VALUE; // no more events
 
-	// calculate current playing decodepos
-	// at this point, LastCheckedDecodePos must not be -1
-	if(LastCheckedDecodePos == -1) ResetLastCheckedDecodePos();
-	tjs_int64 decodepos = (TVPGetTickCount() - LastCheckedTick) * Frequency / 1000 +
-		LastCheckedDecodePos;
-
-	return (tjs_int)(
-		(LabelEventQueue[0].Offset - (tjs_int32)decodepos) * 1000 / Frequency);
+	return GetLabelEventStep(GetPlayingDecodePos());
 }
 //---------------------------------------------------------------------------
 void tTJSNI_WaveSoundBuffer::FlushAllLabelEvents()
@@ -2783,7 +2690,7 @@ void tTJSNI_WaveSoundBuffer::FlushAllLabelEvents()
 	// flush all undelivered events.
 	tTJSCriticalSectionHolder holder(BufferCS);
 
-	for(std::vector<tTVPWaveLabel>::iterator i = LabelEventQueue.begin();
+	for(std::deque<tLabelEvent>::iterator i = LabelEventQueue.begin();
 		i != LabelEventQueue.end(); i++)
 		InvokeLabelEvent(i->Name);
 
@@ -2803,9 +2710,9 @@ void tTJSNI_WaveSoundBuffer::StartPlay()
 	// play from first
 
 	{	// thread protected block
-		if(Thread->GetRunning()) { Thread->SetPriority(TVPDecodeThreadHighPriority); }
+		if(DecodeTask->GetRunning()) { DecodeTask->SetPriority(TVPWaveDecodeThreadHighPriority); }
 		tTJSCriticalSectionHolder holder(BufferCS);
-		tTJSCriticalSectionHolder l2holder(L2BufferCS);
+		tTJSCriticalSectionHolder l2holder(L2Buffer->GetCS());
 
 		CreateSoundBuffer();
 
@@ -2814,7 +2721,7 @@ void tTJSNI_WaveSoundBuffer::StartPlay()
 
 		// fill sound buffer with some first samples
 		BufferPlaying = true;
-		FillL2Buffer(true, false);
+		FillL2Buffer(true);
 		FillBuffer(true, false);
 		FillBuffer(false, false);
 		FillBuffer(false, false);
@@ -2835,7 +2742,7 @@ void tTJSNI_WaveSoundBuffer::StartPlay()
 	// ensure thread
 	TVPEnsureWaveSoundBufferWorking(); // wake the playing thread up again
 	ThreadCallbackEnabled = true;
-	Thread->Continue();
+	DecodeTask->Continue();
 
 }
 //---------------------------------------------------------------------------
@@ -2844,9 +2751,9 @@ void tTJSNI_WaveSoundBuffer::StopPlay()
 	if(!Decoder) return;
 	if(!SoundBuffer) return;
 
-	if(Thread->GetRunning()) { Thread->SetPriority(TVPDecodeThreadHighPriority);}
+	if(DecodeTask->GetRunning()) { DecodeTask->SetPriority(TVPWaveDecodeThreadHighPriority);}
 	tTJSCriticalSectionHolder holder(BufferCS);
-	tTJSCriticalSectionHolder l2holder(L2BufferCS);
+	tTJSCriticalSectionHolder l2holder(L2Buffer->GetCS());
 
 	SoundBuffer->Stop();
 	DSBufferPlaying = false;
@@ -2864,9 +2771,9 @@ void tTJSNI_WaveSoundBuffer::Play()
 
 	TVPEnsurePrimaryBufferPlay(); // let primary buffer to start running
 
-	if(Thread->GetRunning()) { Thread->SetPriority(TVPDecodeThreadHighPriority);}
+	if(DecodeTask->GetRunning()) { DecodeTask->SetPriority(TVPWaveDecodeThreadHighPriority);}
 	tTJSCriticalSectionHolder holder(BufferCS);
-	tTJSCriticalSectionHolder l2holder(L2BufferCS);
+	tTJSCriticalSectionHolder l2holder(L2Buffer->GetCS());
 
 	StartPlay();
 	SetStatus(ssPlay);
@@ -2880,7 +2787,7 @@ void tTJSNI_WaveSoundBuffer::Stop()
 	// delete thread
 	ThreadCallbackEnabled = false;
 	TVPCheckSoundBufferAllSleep();
-	Thread->Interrupt();
+	DecodeTask->Interrupt();
 
 	// set status
 	if(Status != ssUnload) SetStatus(ssStop);
@@ -2891,11 +2798,11 @@ void tTJSNI_WaveSoundBuffer::Stop()
 //---------------------------------------------------------------------------
 void tTJSNI_WaveSoundBuffer::SetPaused(bool b)
 {
-	if(Thread->GetRunning())
-		{/*orgpri = Thread->Priority;*/
-			Thread->SetPriority(TVPDecodeThreadHighPriority); }
+	if(DecodeTask->GetRunning())
+		{/*orgpri = DecodeTask->Priority;*/
+			DecodeTask->SetPriority(TVPWaveDecodeThreadHighPriority); }
 	tTJSCriticalSectionHolder holder(BufferCS);
-	tTJSCriticalSectionHolder l2holder(L2BufferCS);
+	tTJSCriticalSectionHolder l2holder(L2Buffer->GetCS());
 
 	Paused = b;
 }
@@ -2910,7 +2817,7 @@ void tTJSNI_WaveSoundBuffer::TimerBeatHandler()
 		// buffer was stopped
 		ThreadCallbackEnabled = false;
 		TVPCheckSoundBufferAllSleep();
-		Thread->Interrupt();
+		DecodeTask->Interrupt();
 		SetStatusAsync(ssStop);
 	}
 }
@@ -2930,6 +2837,7 @@ void tTJSNI_WaveSoundBuffer::Open(const ttstr & storagename)
 		LoopManager = new tTVPWaveLoopManager();
 		LoopManager->SetDecoder(Decoder);
 		LoopManager->SetLooping(Looping);
+		LoopManager->SetCrossFadeCurve(TVPWaveLoopCrossFadeCurve);
 
 		// build filter chain
 		RebuildFilterChain();
@@ -2970,6 +2878,10 @@ void tTJSNI_WaveSoundBuffer::Open(const ttstr & storagename)
 		delete [] buffer;
 	}
 
+	// prepare prefetching of loop jump targets; the loop manager opens the
+	// spare decoder when a jump comes close.
+	if(TVPWaveLoopPrefetch) LoopManager->SetPrefetchStorage(storagename);
+
 	// set status to stop
 	SetStatus(ssStop);
 }
@@ -20,6 +20,8 @@
 
 #include "WaveIntf.h"
 #include "WaveLoopManager.h"
+#include "WaveDecodeScheduler.h"
+#include "WaveL2Buffer.h"
 
 /*[*/
 //---------------------------------------------------------------------------
@@ -61,8 +63,8 @@ extern tjs_int TVPDSAttenuateToPan(tjs_int att);
 // tTJSNI_WaveSoundBuffer : Wave Native Instance
 //---------------------------------------------------------------------------
 class tTVPWaveLoopManager;
-class tTVPWaveSoundBufferDecodeThread;
-class tTJSNI_WaveSoundBuffer : public tTJSNI_BaseWaveSoundBuffer
+class tTJSNI_WaveSoundBuffer : public tTJSNI_BaseWaveSoundBuffer,
+	public iTVPWaveL2Source
 {
 	typedef  tTJSNI_BaseWaveSoundBuffer inherited;
 
@@ -92,13 +94,8 @@ private:
 	tjs_int BufferBytes;
 	tjs_int AccessUnitBytes;
 	tjs_int AccessUnitSamples;
-	tjs_int L2AccessUnitBytes;
 
-	tjs_int L2BufferUnits;
 	tjs_int L1BufferUnits;
-
-	tjs_int Level2BufferSize;
-	tjs_uint8 *Level2Buffer;
 public:
 	void FreeDirectSoundBuffer(bool disableevent = true)
 	{
@@ -115,15 +112,13 @@ public:
 	//-- playing stuff ----------------------------------------------------
 private:
 	tTJSCriticalSection BufferCS;
-	tTJSCriticalSection L2BufferCS;
-	tTJSCriticalSection L2BufferRemainCS;
 
 public:
 	tTJSCriticalSection & GetBufferCS() { return BufferCS; }
 
 private:
 	tTVPWaveDecoder * Decoder;
-	tTVPWaveSoundBufferDecodeThread * Thread;
+	tTVPWaveDecodeTask * DecodeTask;
 public:
 	bool ThreadCallbackEnabled;
 private:
@@ -137,16 +132,24 @@ private:
 	tjs_int SoundBufferWritePos;
 	tjs_int PlayStopPos; // in bytes
 
-	tjs_int L2BufferReadPos; // in unit
-	tjs_int L2BufferWritePos;
-	tjs_int L2BufferRemain;
-	bool L2BufferEnded;
+	tTVPWaveL2Buffer * L2Buffer;
+		// the decoding threads write and the playing thread (under BufferCS)
+		// reads, without locking each other.
 	tjs_uint8 *VisBuffer; // buffer for visualization
-	tjs_int *L2BufferDecodedSamplesInUnit;
 	tTVPWaveSegmentQueue *L1BufferSegmentQueues;
-	std::vector<tTVPWaveLabel> LabelEventQueue;
+	struct tLabelEvent
+	{
+		tjs_int64 Position; // output sample position (in DecodePos unit) of the label
+		ttstr Name;
+		tLabelEvent(tjs_int64 pos, const ttstr &name) : Position(pos), Name(name) {}
+		bool operator < (const tLabelEvent &rhs) const
+			{ return Position < rhs.Position; }
+	};
+	std::deque<tLabelEvent> LabelEventQueue;
+		// label event timeline; sorted by Position.
+		// each label is put here with its exact output sample position at
+		// the time it is written into the L1 buffer.
 	tjs_int64 *L1BufferDecodeSamplePos;
-	tTVPWaveSegmentQueue *L2BufferSegmentQueues;
 
 	tjs_int64 DecodePos; // decoded samples from directsound buffer play
 	tjs_int64 LastCheckedDecodePos; // last sured position (-1 for not checked) and 
@@ -160,12 +163,15 @@ private:
 		tTVPWaveSegmentQueue & segments);
 
 public:
-	bool FillL2Buffer(bool firstwrite, bool fromdecodethread);
+	// iTVPWaveL2Source; called by L2Buffer
+	tjs_uint DecodeL2Unit(void *buffer, tjs_uint bufsamplelen,
+		tTVPWaveSegmentQueue & segments);
 
 private:
+	bool FillL2Buffer(bool firstwrite);
 	void PrepareToReadL2Buffer(bool firstread);
 	tjs_uint ReadL2Buffer(void *buffer,
-		tTVPWaveSegmentQueue & segments);
+		tTVPWaveSegmentQueue & segments, bool & underrun);
 
 	void FillDSBuffer(tjs_int writepos,
 		tTVPWaveSegmentQueue & segments);
@@ -174,9 +180,11 @@ public:
 
 private:
 	void ResetLastCheckedDecodePos(DWORD pp = (DWORD)-1);
+	tjs_int64 GetPlayingDecodePos();
+	tjs_int GetLabelEventStep(tjs_int64 decodepos);
 
 public:
-	tjs_int FireLabelEventsAndGetNearestLabelEventStep(tjs_int64 tick);
+	tjs_int FireLabelEventsAndGetNearestLabelEventStep();
 	tjs_int GetNearestEventStep();
 	void FlushAllLabelEvents();
 
@@ -0,0 +1,161 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// JPEG decoder benchmark
+//---------------------------------------------------------------------------
+/*
+	"jpegdec" decodes the same 4:2:0 JPEG, which has a restart marker at
+	every MCU row, with the serial decoder and with the parallel decoder.
+	The parallel path runs on TVPGetProcessorNum() draw threads (at least
+	2, so that it does run). The suite reports the throughput of each path
+	and the speedup, and fails if the parallel output differs from the
+	serial output.
+*/
+#include "tjsCommHead.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "TVPBench.h"
+#include "GraphicsLoaderIntf.h"
+#include "LayerBitmapIntf.h"
+#include "UtilStreams.h"
+#include "ThreadIntf.h"
+#include "MsgIntf.h"
+
+extern "C"
+{
+#include <jpeglib.h>
+}
+
+
+//---------------------------------------------------------------------------
+static void TVPBenchEncodeJPEG(tTVPMemoryStream & stream, tjs_uint w,
+	tjs_uint h)
+{
+	// a photo-like image: smooth gradients with a little noise
+	jpeg_compress_struct cinfo;
+	jpeg_error_mgr jerr;
+	cinfo.err = jpeg_std_error(&jerr);
+	jpeg_create_compress(&cinfo);
+	unsigned char * out = NULL;
+	unsigned long outsize = 0;
+	jpeg_mem_dest(&cinfo, &out, &outsize);
+
+	cinfo.image_width = w;
+	cinfo.image_height = h;
+	cinfo.input_components = 3;
+	cinfo.in_color_space = JCS_RGB;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, 90, TRUE);
+	cinfo.restart_in_rows = 1;
+	jpeg_start_compress(&cinfo, TRUE);
+
+	std::vector<JSAMPLE> line(w * 3);
+	tjs_uint32 r = 1;
+	for(tjs_uint y = 0; y < h; y++)
+	{
+		for(tjs_uint x = 0; x < w; x++)
+		{
+			r = r * 1103515245 + 12345;
+			tjs_uint32 noise = (r >> 16) & 0x07;
+			line[x * 3 + 0] = (JSAMPLE)(((x + y) / 6 + noise) & 0xff);
+			line[x * 3 + 1] = (JSAMPLE)((y / 3 + noise) & 0xff);
+			line[x * 3 + 2] = (JSAMPLE)((x / 4 + noise) & 0xff);
+		}
+		JSAMPROW row = &line[0];
+		jpeg_write_scanlines(&cinfo, &row, 1);
+	}
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+
+	stream.Clear();
+	stream.WriteBuffer(out, (tjs_uint)outsize);
+	free(out);
+}
+//---------------------------------------------------------------------------
+static void TVPBenchSizeCallback(void *callbackdata, tjs_uint w, tjs_uint h)
+{
+	tTVPBaseBitmap * bmp = (tTVPBaseBitmap *)callbackdata;
+	if(bmp->GetWidth() != w || bmp->GetHeight() != h)
+		TVPThrowExceptionMessage(TJS_W("unexpected image size"));
+}
+//---------------------------------------------------------------------------
+static void * TVPBenchScanLineCallback(void *callbackdata, tjs_int y)
+{
+	if(y < 0) return NULL;
+	tTVPBaseBitmap * bmp = (tTVPBaseBitmap *)callbackdata;
+	return bmp->GetScanLineForWrite(y);
+}
+//---------------------------------------------------------------------------
+static double TVPBenchDecodeJPEG(tTVPMemoryStream & stream,
+	tTVPBaseBitmap & dest, int repeat)
+{
+	// returns seconds per decode
+	tTVPBenchTimer timer;
+	for(int i = 0; i < repeat; i++)
+	{
+		stream.SetPosition(0);
+		TVPLoadJPEG(NULL, &dest, TVPBenchSizeCallback, TVPBenchScanLineCallback,
+			NULL, &stream, -1, glmNormal);
+	}
+	return timer.GetSeconds() / repeat;
+}
+//---------------------------------------------------------------------------
+static bool TVPBenchSameImage(const tTVPBaseBitmap & a, const tTVPBaseBitmap & b)
+{
+	for(tjs_uint y = 0; y < a.GetHeight(); y++)
+		if(memcmp(a.GetScanLine(y), b.GetScanLine(y), a.GetWidth() * 4))
+			return false;
+	return true;
+}
+//---------------------------------------------------------------------------
+TVP_BENCH_SUITE(jpegdec)
+{
+	tjs_uint w = TVPBenchQuick ? 640 : 1920;
+	tjs_uint h = TVPBenchQuick ? 480 : 1080;
+	int repeat = TVPBenchQuick ? 1 : 20;
+
+	tTVPMemoryStream stream;
+	TVPBenchEncodeJPEG(stream, w, h);
+	TVPBenchReport("size", (double)stream.GetSize() / 1024, "KiB");
+
+	tjs_int drawthreads = TVPDrawThreadNum;
+	bool parallel = TVPJPEGParallelDecode;
+	try
+	{
+		tTVPBaseBitmap serial(w, h, 32);
+		TVPDrawThreadNum = 1;
+		double serial_time = TVPBenchDecodeJPEG(stream, serial, repeat);
+
+		tTVPBaseBitmap threaded(w, h, 32);
+		tjs_int threads = TVPGetProcessorNum();
+		if(threads < 2) threads = 2;
+		TVPDrawThreadNum = threads;
+		TVPJPEGParallelDecode = true;
+		double parallel_time = TVPBenchDecodeJPEG(stream, threaded, repeat);
+
+		double mpix = (double)w * h / 1000000;
+		TVPBenchReport("serial", mpix / serial_time, "Mpixel/s");
+		TVPBenchReport("parallel", mpix / parallel_time, "Mpixel/s");
+		TVPBenchReport("threads", threads, "");
+		TVPBenchReport("speedup", serial_time / parallel_time, "x");
+
+		if(!TVPBenchSameImage(threaded, serial))
+			TVPThrowExceptionMessage(TJS_W("decoded images differ"));
+	}
+	catch(...)
+	{
+		TVPDrawThreadNum = drawthreads;
+		TVPJPEGParallelDecode = parallel;
+		throw;
+	}
+	TVPDrawThreadNum = drawthreads;
+	TVPJPEGParallelDecode = parallel;
+}
+//---------------------------------------------------------------------------
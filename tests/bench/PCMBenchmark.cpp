@@ -0,0 +1,189 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// PCM Format Conversion Benchmark
+//---------------------------------------------------------------------------
+/*
+	Measures every PCM conversion kernel (sound/WaveFormatConverter*.cpp) in
+	every instruction set version the CPU supports, one row of the table per
+	kernel and version. The SIMD versions are also checked against their
+	reference version, and must give exactly the same output. The reference
+	is the C version, except for int16 <-> float: those SIMD versions follow
+	the original SSE version, which scales by 32767 instead of 32768. The
+	dithering versions are not checked; their noise is generated in a
+	different order.
+*/
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "TVPBench.h"
+#include "MsgIntf.h"
+#include "DetectCPU.h"
+#include "tvpgl_ia32_intf.h"
+
+
+//---------------------------------------------------------------------------
+// kernel prototypes; see sound/WaveIntf.cpp
+//---------------------------------------------------------------------------
+#define TVP_PCM_CONVERT_PROTO(suffix) \
+	extern void PCMConvertLoopInt16ToFloat32##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples); \
+	extern void PCMConvertLoopFloat32ToInt16##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples); \
+	extern void PCMConvertLoopFloat32ToInt16Dither##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 seed); \
+	extern void PCMConvertLoopInt8ToFloat32##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples); \
+	extern void PCMConvertLoopInt24ToFloat32##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask); \
+	extern void PCMConvertLoopInt32ToFloat32##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask); \
+	extern void PCMConvertLoopInt8ToInt16##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples); \
+	extern void PCMConvertLoopInt24ToInt16##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask); \
+	extern void PCMConvertLoopInt32ToInt16##suffix(void * __restrict dest, const void * __restrict src, size_t numsamples, tjs_uint32 mask); \
+	extern void PCMDownmixLoopInt16Stereo##suffix(void * dest, const void * src, size_t numframes); \
+	extern void PCMDownmixLoopFloat32Stereo##suffix(void * dest, const void * src, size_t numframes);
+
+TVP_PCM_CONVERT_PROTO()
+#if defined(_M_IX86)||defined(_M_X64)
+extern void PCMConvertLoopInt16ToFloat32_sse(void * __restrict dest, const void * __restrict src, size_t numsamples);
+extern void PCMConvertLoopFloat32ToInt16_sse(void * __restrict dest, const void * __restrict src, size_t numsamples);
+TVP_PCM_CONVERT_PROTO(_sse2)
+extern void PCMConvertLoopInt16ToFloat32_avx2(void * __restrict dest, const void * __restrict src, size_t numsamples);
+extern void PCMConvertLoopFloat32ToInt16_avx2(void * __restrict dest, const void * __restrict src, size_t numsamples);
+TVP_PCM_CONVERT_PROTO(_avx2)
+#endif
+#undef TVP_PCM_CONVERT_PROTO
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// the table
+//---------------------------------------------------------------------------
+typedef void (*tTVPBenchPCMProc)(void *, const void *, size_t);
+typedef void (*tTVPBenchPCMProcArg)(void *, const void *, size_t, tjs_uint32);
+	// the last argument is the mask of valid bits, or the dither seed
+enum tTVPBenchPCMInput { bpiInt, bpiFloat };
+struct tTVPBenchPCMPath
+{
+	const char * Name;
+	const char * Version;
+	tjs_uint32 CPUFlags; // required TVPCPUType flags
+	tTVPBenchPCMInput Input;
+	tjs_uint InBytes; // per one call unit (a sample, or a frame for downmix)
+	tjs_uint OutBytes;
+	tTVPBenchPCMProc Proc;
+	tTVPBenchPCMProcArg ProcArg;
+	const char * Reference; // the version which gives the same output, or NULL
+};
+//---------------------------------------------------------------------------
+#define TVP_BENCH_PCM_PATHS(suffix, version, flags) \
+	{ "int8_float", version, flags, bpiInt, 1, 4, PCMConvertLoopInt8ToFloat32##suffix, NULL, "c" }, \
+	{ "int24_float", version, flags, bpiInt, 3, 4, NULL, PCMConvertLoopInt24ToFloat32##suffix, "c" }, \
+	{ "int32_float", version, flags, bpiInt, 4, 4, NULL, PCMConvertLoopInt32ToFloat32##suffix, "c" }, \
+	{ "int8_int16", version, flags, bpiInt, 1, 2, PCMConvertLoopInt8ToInt16##suffix, NULL, "c" }, \
+	{ "int24_int16", version, flags, bpiInt, 3, 2, NULL, PCMConvertLoopInt24ToInt16##suffix, "c" }, \
+	{ "int32_int16", version, flags, bpiInt, 4, 2, NULL, PCMConvertLoopInt32ToInt16##suffix, "c" }, \
+	{ "float_int16_dither", version, flags, bpiFloat, 4, 2, NULL, PCMConvertLoopFloat32ToInt16Dither##suffix, NULL }, \
+	{ "downmix_int16", version, flags, bpiInt, 4, 2, PCMDownmixLoopInt16Stereo##suffix, NULL, "c" }, \
+	{ "downmix_float", version, flags, bpiFloat, 8, 4, PCMDownmixLoopFloat32Stereo##suffix, NULL, "c" },
+#define TVP_BENCH_PCM_16_PATHS(suffix, version, flags, ref) \
+	{ "int16_float", version, flags, bpiInt, 2, 4, PCMConvertLoopInt16ToFloat32##suffix, NULL, ref }, \
+	{ "float_int16", version, flags, bpiFloat, 4, 2, PCMConvertLoopFloat32ToInt16##suffix, NULL, ref },
+//---------------------------------------------------------------------------
+static const tTVPBenchPCMPath TVPBenchPCMPaths[] =
+{
+	// a reference must come before the versions which refer to it
+	TVP_BENCH_PCM_16_PATHS(, "c", 0, NULL)
+	TVP_BENCH_PCM_PATHS(, "c", 0)
+#if defined(_M_IX86)||defined(_M_X64)
+	TVP_BENCH_PCM_16_PATHS(_sse, "sse",
+		TVP_CPU_HAS_MMX|TVP_CPU_HAS_SSE|TVP_CPU_HAS_CMOV, NULL)
+	TVP_BENCH_PCM_PATHS(_sse2, "sse2", TVP_CPU_HAS_SSE2)
+	TVP_BENCH_PCM_16_PATHS(_avx2, "avx2", TVP_CPU_HAS_AVX|TVP_CPU_HAS_AVX2, "sse")
+	TVP_BENCH_PCM_PATHS(_avx2, "avx2", TVP_CPU_HAS_AVX|TVP_CPU_HAS_AVX2)
+#endif
+};
+#undef TVP_BENCH_PCM_PATHS
+#undef TVP_BENCH_PCM_16_PATHS
+//---------------------------------------------------------------------------
+static void TVPBenchCallPCMPath(const tTVPBenchPCMPath & path, void * dest,
+	const void * src, size_t units)
+{
+	if(path.Proc)
+		path.Proc(dest, src, units);
+	else
+		path.ProcArg(dest, src, units, 0xffffffff);
+			// all bits are valid; the seed is fixed
+}
+//---------------------------------------------------------------------------
+static const tTVPBenchPCMPath * TVPBenchFindPCMPath(const char * name,
+	const char * version)
+{
+	for(tjs_uint i = 0; i < sizeof(TVPBenchPCMPaths) / sizeof(TVPBenchPCMPaths[0]); i++)
+	{
+		const tTVPBenchPCMPath & path = TVPBenchPCMPaths[i];
+		if(!strcmp(path.Version, version) && !strcmp(path.Name, name)) return &path;
+	}
+	return NULL;
+}
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// suite
+//---------------------------------------------------------------------------
+TVP_BENCH_SUITE(pcmconv)
+{
+	// "units" are samples (frames for downmix); the block size is that of a
+	// sound buffer L2 unit. an odd count to run the tails of the SIMD loops.
+	const tjs_uint units = 4097;
+	const tjs_uint repeat = TVPBenchQuick ? 20 : 5000;
+
+	// source data; random integers, and floats in -1.2 ... +1.2 which also
+	// exercise the clipping
+	std::vector<tjs_uint8> intsrc(units * 8);
+	std::vector<float> floatsrc(units * 2);
+	tjs_uint32 r = 1;
+	for(tjs_uint i = 0; i < intsrc.size(); i++)
+		r = r * 1103515245 + 12345, intsrc[i] = (tjs_uint8)(r >> 16);
+	for(tjs_uint i = 0; i < floatsrc.size(); i++)
+		r = r * 1103515245 + 12345,
+		floatsrc[i] = (float)((r >> 8) & 0xffff) / 65536.0f * 2.4f - 1.2f;
+
+	std::vector<tjs_uint8> dest(units * 4), reference(units * 4);
+
+	for(tjs_uint i = 0; i < sizeof(TVPBenchPCMPaths) / sizeof(TVPBenchPCMPaths[0]); i++)
+	{
+		const tTVPBenchPCMPath & path = TVPBenchPCMPaths[i];
+		if((TVPCPUType & path.CPUFlags) != path.CPUFlags) continue;
+		const void * src = path.Input == bpiInt ?
+			(const void *)&intsrc[0] : (const void *)&floatsrc[0];
+
+		if(path.Reference)
+		{
+			const tTVPBenchPCMPath * ref =
+				TVPBenchFindPCMPath(path.Name, path.Reference);
+			TVPBenchCallPCMPath(*ref, &reference[0], src, units);
+			TVPBenchCallPCMPath(path, &dest[0], src, units);
+			if(memcmp(&reference[0], &dest[0], units * path.OutBytes))
+				TVPThrowExceptionMessage(TJS_W("%1 differs from the %2 version"),
+					ttstr(path.Name) + TJS_W("_") + ttstr(path.Version),
+					ttstr(path.Reference));
+		}
+
+		tTVPBenchTimer timer;
+		for(tjs_uint n = 0; n < repeat; n++)
+			TVPBenchCallPCMPath(path, &dest[0], src, units);
+		double time = timer.GetSeconds();
+
+		char item[64];
+		sprintf(item, "%s_%s", path.Name, path.Version);
+		TVPBenchReport(item, (double)units * repeat / time / 1000000.0,
+			"Munits/s");
+	}
+}
+//---------------------------------------------------------------------------
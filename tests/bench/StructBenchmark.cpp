@@ -0,0 +1,107 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Structured Data (saveStruct) Benchmark
+//---------------------------------------------------------------------------
+/*
+	Saves and loads a save-data-like dictionary (many records with the same
+	keys and repeated string values) with Dictionary.saveStruct in the binary
+	modes: "b" writes the v1 format, "bs" the v2 format with the shared
+	string table. Reports the file size and the time of one save and one
+	load for each.
+*/
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include "MsgIntf.h"
+#include "TVPBench.h"
+
+
+//---------------------------------------------------------------------------
+static long TVPBenchGetFileSize(const std::string & path)
+{
+	FILE * f = fopen(path.c_str(), "rb");
+	if(!f) return -1;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fclose(f);
+	return size;
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// suite
+//---------------------------------------------------------------------------
+TVP_BENCH_SUITE(savestruct)
+{
+	tjs_int records = TVPBenchQuick ? 100 : 20000;
+	tjs_int repeat = TVPBenchQuick ? 1 : 10;
+	std::string path = TVPBenchTempPath("struct.dat");
+	tTJS * tjs = TVPBenchGetTJS();
+
+	char script[1024];
+	sprintf(script,
+		"global.tvpbench_struct = %%[ version : 3, records : [] ];"
+		"var names = [ 'alice', 'bob', 'carol', 'dave', 'eve' ];"
+		"for(var i = 0; i < %d; i++)"
+		"	tvpbench_struct.records.add(%%["
+		"		name : names[i %% 5], text : 'message ' + (i %% 50),"
+		"		place : 'scene' + (i %% 20) + '.ks', flag : i %% 2,"
+		"		value : i * 0.5 ]);",
+		(int)records);
+	tjs->ExecScript(ttstr(script));
+
+	static const char * const modes[][2] =
+		{ { "v1", "b" }, { "v2", "bs" } };
+	for(tjs_int m = 0; m < 2; m++)
+	{
+		char item[64];
+
+		sprintf(script,
+			"for(var i = 0; i < %d; i++)"
+			"	(Dictionary.saveStruct incontextof tvpbench_struct)('%s', '%s');",
+			(int)repeat, path.c_str(), modes[m][1]);
+		tTVPBenchTimer timer;
+		tjs->ExecScript(ttstr(script));
+		double save = timer.GetSeconds();
+
+		sprintf(item, "%s_size", modes[m][0]);
+		TVPBenchReport(item, (double)TVPBenchGetFileSize(path), "bytes");
+		sprintf(item, "%s_save", modes[m][0]);
+		TVPBenchReport(item, save / repeat * 1000.0, "ms");
+
+		sprintf(script,
+			"for(var i = 0; i < %d; i++)"
+			"	global.tvpbench_loaded = Dictionary.loadStruct('%s');",
+			(int)repeat, path.c_str());
+		timer.Reset();
+		tjs->ExecScript(ttstr(script));
+		double load = timer.GetSeconds();
+
+		sprintf(item, "%s_load", modes[m][0]);
+		TVPBenchReport(item, load / repeat * 1000.0, "ms");
+
+		sprintf(script,
+			"tvpbench_loaded.records.count == %d &&"
+			"tvpbench_loaded.records[%d].text == 'message %d'",
+			(int)records, (int)(records - 1), (int)((records - 1) % 50));
+		tTJSVariant same;
+		tjs->EvalExpression(ttstr(script), &same);
+		if(!same.operator bool())
+			TVPThrowExceptionMessage(TJS_W("%1: loaded data differs"),
+				ttstr(modes[m][0]));
+	}
+
+	tjs->ExecScript(ttstr(
+		"delete global.tvpbench_struct; delete global.tvpbench_loaded;"));
+	remove(path.c_str());
+}
+//---------------------------------------------------------------------------
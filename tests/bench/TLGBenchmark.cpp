@@ -0,0 +1,189 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// TLG5/6 encoder and decoder benchmarks
+//---------------------------------------------------------------------------
+/*
+	"tlg6dec" decodes the same TLG6 image with the serial decoder and with
+	the parallel decoder, and "tlgenc" encodes an image to TLG5 and to TLG6
+	with one draw thread and with the parallel encoder. The parallel paths
+	run on TVPGetProcessorNum() draw threads (at least 2, so that they do
+	run). Both suites report the throughput of each path and fail if the
+	parallel output differs from the serial output.
+*/
+#include "tjsCommHead.h"
+
+#include <string.h>
+#include "TVPBench.h"
+#include "GraphicsLoaderIntf.h"
+#include "LayerBitmapIntf.h"
+#include "UtilStreams.h"
+#include "ThreadIntf.h"
+#include "MsgIntf.h"
+
+
+//---------------------------------------------------------------------------
+static void TVPBenchFillImage(tTVPBaseBitmap & bmp)
+{
+	// a photo-like image: smooth gradients with a little noise
+	tjs_uint32 r = 1;
+	for(tjs_uint y = 0; y < bmp.GetHeight(); y++)
+	{
+		tjs_uint32 * line = (tjs_uint32 *)bmp.GetScanLineForWrite(y);
+		for(tjs_uint x = 0; x < bmp.GetWidth(); x++)
+		{
+			r = r * 1103515245 + 12345;
+			tjs_uint32 noise = (r >> 16) & 0x07;
+			tjs_uint32 b = (x / 4 + noise) & 0xff;
+			tjs_uint32 g = (y / 3 + noise) & 0xff;
+			tjs_uint32 rr = ((x + y) / 6 + noise) & 0xff;
+			tjs_uint32 a = 0xff - ((x / 16) & 0x7f);
+			line[x] = b + (g << 8) + (rr << 16) + (a << 24);
+		}
+	}
+}
+//---------------------------------------------------------------------------
+static void TVPBenchSizeCallback(void *callbackdata, tjs_uint w, tjs_uint h)
+{
+	tTVPBaseBitmap * bmp = (tTVPBaseBitmap *)callbackdata;
+	if(bmp->GetWidth() != w || bmp->GetHeight() != h)
+		TVPThrowExceptionMessage(TJS_W("unexpected image size"));
+}
+//---------------------------------------------------------------------------
+static void * TVPBenchScanLineCallback(void *callbackdata, tjs_int y)
+{
+	if(y < 0) return NULL;
+	tTVPBaseBitmap * bmp = (tTVPBaseBitmap *)callbackdata;
+	return bmp->GetScanLineForWrite(y);
+}
+//---------------------------------------------------------------------------
+static double TVPBenchEncodeTLG(const tTVPBaseBitmap & src,
+	tTVPMemoryStream & stream, const tjs_char * mode, int repeat)
+{
+	// returns seconds per encode
+	tTVPBenchTimer timer;
+	for(int i = 0; i < repeat; i++)
+	{
+		stream.Clear();
+		TVPSaveAsTLG(NULL, &stream, &src, mode, NULL);
+	}
+	return timer.GetSeconds() / repeat;
+}
+//---------------------------------------------------------------------------
+static double TVPBenchDecodeTLG(tTVPMemoryStream & stream,
+	tTVPBaseBitmap & dest, int repeat)
+{
+	// returns seconds per decode
+	tTVPBenchTimer timer;
+	for(int i = 0; i < repeat; i++)
+	{
+		stream.SetPosition(0);
+		TVPLoadTLG(NULL, &dest, TVPBenchSizeCallback, TVPBenchScanLineCallback,
+			NULL, &stream, -1, glmNormal);
+	}
+	return timer.GetSeconds() / repeat;
+}
+//---------------------------------------------------------------------------
+static bool TVPBenchSameImage(const tTVPBaseBitmap & a, const tTVPBaseBitmap & b)
+{
+	for(tjs_uint y = 0; y < a.GetHeight(); y++)
+		if(memcmp(a.GetScanLine(y), b.GetScanLine(y), a.GetWidth() * 4))
+			return false;
+	return true;
+}
+//---------------------------------------------------------------------------
+TVP_BENCH_SUITE(tlg6dec)
+{
+	tjs_uint w = TVPBenchQuick ? 320 : 1920;
+	tjs_uint h = TVPBenchQuick ? 240 : 1080;
+	int repeat = TVPBenchQuick ? 1 : 10;
+
+	tTVPBaseBitmap src(w, h, 32);
+	TVPBenchFillImage(src);
+	tTVPMemoryStream stream;
+	TVPSaveAsTLG(NULL, &stream, &src, TJS_W("tlg6"), NULL);
+	TVPBenchReport("size", (double)stream.GetSize() / 1024, "KiB");
+
+	tjs_int drawthreads = TVPDrawThreadNum;
+	bool parallel = TVPTLG6ParallelDecode;
+	try
+	{
+		tTVPBaseBitmap serial(w, h, 32);
+		TVPDrawThreadNum = 1;
+		double serial_time = TVPBenchDecodeTLG(stream, serial, repeat);
+
+		tTVPBaseBitmap threaded(w, h, 32);
+		tjs_int threads = TVPGetProcessorNum();
+		if(threads < 2) threads = 2;
+		TVPDrawThreadNum = threads;
+		TVPTLG6ParallelDecode = true;
+		double parallel_time = TVPBenchDecodeTLG(stream, threaded, repeat);
+
+		double mpix = (double)w * h / 1000000;
+		TVPBenchReport("serial", mpix / serial_time, "Mpixel/s");
+		TVPBenchReport("parallel", mpix / parallel_time, "Mpixel/s");
+		TVPBenchReport("threads", threads, "");
+		TVPBenchReport("speedup", serial_time / parallel_time, "x");
+
+		if(!TVPBenchSameImage(serial, src) || !TVPBenchSameImage(threaded, serial))
+			TVPThrowExceptionMessage(TJS_W("decoded images differ"));
+	}
+	catch(...)
+	{
+		TVPDrawThreadNum = drawthreads;
+		TVPTLG6ParallelDecode = parallel;
+		throw;
+	}
+	TVPDrawThreadNum = drawthreads;
+	TVPTLG6ParallelDecode = parallel;
+}
+//---------------------------------------------------------------------------
+TVP_BENCH_SUITE(tlgenc)
+{
+	tjs_uint w = TVPBenchQuick ? 320 : 1920;
+	tjs_uint h = TVPBenchQuick ? 240 : 1080;
+	int repeat = TVPBenchQuick ? 1 : 3;
+	double mpix = (double)w * h / 1000000;
+
+	tTVPBaseBitmap src(w, h, 32);
+	TVPBenchFillImage(src);
+
+	tjs_int drawthreads = TVPDrawThreadNum;
+	try
+	{
+		tTVPMemoryStream tlg5, serial, threaded;
+		TVPDrawThreadNum = 1;
+		double tlg5_time = TVPBenchEncodeTLG(src, tlg5, TJS_W("tlg5"), repeat);
+		double serial_time = TVPBenchEncodeTLG(src, serial, TJS_W("tlg6"), repeat);
+
+		tjs_int threads = TVPGetProcessorNum();
+		if(threads < 2) threads = 2;
+		TVPDrawThreadNum = threads;
+		double parallel_time = TVPBenchEncodeTLG(src, threaded, TJS_W("tlg6"), repeat);
+
+		TVPBenchReport("tlg5", mpix / tlg5_time, "Mpixel/s");
+		TVPBenchReport("tlg5_size", (double)tlg5.GetSize() / 1024, "KiB");
+		TVPBenchReport("tlg6_serial", mpix / serial_time, "Mpixel/s");
+		TVPBenchReport("tlg6_parallel", mpix / parallel_time, "Mpixel/s");
+		TVPBenchReport("tlg6_size", (double)serial.GetSize() / 1024, "KiB");
+		TVPBenchReport("threads", threads, "");
+		TVPBenchReport("speedup", serial_time / parallel_time, "x");
+
+		if(serial.GetSize() != threaded.GetSize() ||
+			memcmp(serial.GetInternalBuffer(), threaded.GetInternalBuffer(),
+				(size_t)serial.GetSize()))
+			TVPThrowExceptionMessage(TJS_W("encoded streams differ"));
+	}
+	catch(...)
+	{
+		TVPDrawThreadNum = drawthreads;
+		throw;
+	}
+	TVPDrawThreadNum = drawthreads;
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,116 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Benchmark driver for the headless build
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "tjsError.h"
+#include "TVPBench.h"
+#include "HeadlessHost.h"
+#include "ScriptMgnIntf.h"
+
+
+//---------------------------------------------------------------------------
+static tTVPBenchSuite * TVPBenchSuites = NULL;
+static tTVPBenchSuite * TVPBenchSuitesLast = NULL;
+bool TVPBenchQuick = false;
+const char * TVPBenchCurrentSuite = "";
+//---------------------------------------------------------------------------
+tTVPBenchSuite::tTVPBenchSuite(const char * name, tTVPBenchProc proc)
+{
+	// keep the order of the registration (in the order of the link)
+	Name = name;
+	Proc = proc;
+	Next = NULL;
+	if(TVPBenchSuitesLast) TVPBenchSuitesLast->Next = this;
+	else TVPBenchSuites = this;
+	TVPBenchSuitesLast = this;
+}
+//---------------------------------------------------------------------------
+void TVPBenchReport(const char * item, double value, const char * unit)
+{
+	printf("%s/%s: %.6g %s\n", TVPBenchCurrentSuite, item, value, unit);
+	fflush(stdout);
+}
+//---------------------------------------------------------------------------
+std::string TVPBenchTempPath(const char * name)
+{
+	return TVPHeadlessTempPath(name);
+}
+//---------------------------------------------------------------------------
+tTJS * TVPBenchGetTJS()
+{
+	return TVPGetScriptEngine();
+}
+//---------------------------------------------------------------------------
+static bool TVPBenchIsSelected(const tTVPBenchSuite * suite,
+	int argc, char ** argv)
+{
+	bool any = false;
+	for(int i = 1; i < argc; i++)
+	{
+		if(argv[i][0] == '-') continue;
+		any = true;
+		if(!strcmp(argv[i], suite->Name)) return true;
+	}
+	return !any;
+}
+//---------------------------------------------------------------------------
+int main(int argc, char ** argv)
+{
+	for(int i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "--quick"))
+		{
+			TVPBenchQuick = true;
+		}
+		else if(!strcmp(argv[i], "--list"))
+		{
+			for(tTVPBenchSuite * s = TVPBenchSuites; s; s = s->Next)
+				printf("%s\n", s->Name);
+			return 0;
+		}
+		else if(argv[i][0] == '-')
+		{
+			fprintf(stderr, "usage: %s [--quick] [--list] [suite ...]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	TVPInitHeadlessHost();
+	TVPHeadlessLogQuiet = true;
+
+	int ret = 0;
+	for(tTVPBenchSuite * s = TVPBenchSuites; s; s = s->Next)
+	{
+		if(!TVPBenchIsSelected(s, argc, argv)) continue;
+		TVPBenchCurrentSuite = s->Name;
+		try
+		{
+			s->Proc();
+		}
+		catch(const eTJS & e)
+		{
+			fprintf(stderr, "%s: %s\n", s->Name,
+				e.GetMessage().AsNarrowStdString().c_str());
+			ret = 1;
+		}
+		catch(...)
+		{
+			fprintf(stderr, "%s: unknown exception\n", s->Name);
+			ret = 1;
+		}
+	}
+
+	TVPUninitHeadlessHost();
+	return ret;
+}
+//---------------------------------------------------------------------------
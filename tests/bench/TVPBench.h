@@ -0,0 +1,67 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Benchmark driver for the headless build
+//---------------------------------------------------------------------------
+/*
+	Each benchmark suite is a function registered by TVP_BENCH_SUITE.
+	"tvpbench" runs all suites (or the suites given in the command line) and
+	prints one line per measured item:
+
+		<suite>/<item>: <value> <unit>
+
+	With "--quick" the suites use small inputs; ctest runs them in this mode
+	to check that they still work, not to measure.
+*/
+#ifndef TVPBenchH
+#define TVPBenchH
+
+#include <string>
+#include "tjs.h"
+#include "tjsUtils.h"
+
+//---------------------------------------------------------------------------
+typedef void (*tTVPBenchProc)();
+struct tTVPBenchSuite
+{
+	const char * Name;
+	tTVPBenchProc Proc;
+	tTVPBenchSuite * Next;
+
+	tTVPBenchSuite(const char * name, tTVPBenchProc proc);
+};
+#define TVP_BENCH_SUITE(name) \
+	static void TVPBenchSuite_##name(); \
+	static tTVPBenchSuite TVPBenchSuiteRegister_##name(#name, TVPBenchSuite_##name); \
+	static void TVPBenchSuite_##name()
+//---------------------------------------------------------------------------
+extern bool TVPBenchQuick; // small inputs (--quick)
+extern const char * TVPBenchCurrentSuite;
+//---------------------------------------------------------------------------
+extern void TVPBenchReport(const char * item, double value, const char * unit);
+	// prints "<current suite>/<item>: <value> <unit>"
+extern std::string TVPBenchTempPath(const char * name);
+	// a path for a temporary file; see TVPHeadlessTempPath
+extern tTJS * TVPBenchGetTJS();
+	// the script engine shared by the suites (created at the first call)
+//---------------------------------------------------------------------------
+class tTVPBenchTimer
+{
+	tjs_uint64 Start;
+public:
+	tTVPBenchTimer() { Reset(); }
+	void Reset() { Start = TJS::TJSGetPerformanceCounter(); }
+	double GetSeconds() const
+	{
+		return (double)(TJS::TJSGetPerformanceCounter() - Start) /
+			(double)TJS::TJSGetPerformanceFrequency();
+	}
+};
+//---------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,576 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Wave Pipeline Benchmark
+//---------------------------------------------------------------------------
+
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "WaveBenchmark.h"
+#include "WaveLoopManager.h"
+#include "SoftwareMixer.h"
+#include "PhaseVocoderFilter.h"
+#include "StorageIntf.h"
+#include "UtilStreams.h"
+#include "MsgIntf.h"
+#include "TVPBench.h"
+
+
+//---------------------------------------------------------------------------
+// high resolution clock (the platform layer of TJS2)
+//---------------------------------------------------------------------------
+static tjs_uint64 TVPWaveBenchmarkClockToUS(tjs_uint64 clock)
+{
+	tjs_uint64 freq = TJSGetPerformanceFrequency();
+	return clock / freq * 1000000 + clock % freq * 1000000 / freq;
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// tTVPWaveBenchmarkStage
+//---------------------------------------------------------------------------
+void tTVPWaveBenchmarkStage::Clear()
+{
+	Time = 0;
+	MaxLatency = 0;
+	memset(Histogram, 0, sizeof(Histogram));
+}
+//---------------------------------------------------------------------------
+void tTVPWaveBenchmarkStage::Add(tjs_uint64 us)
+{
+	Time += us;
+	if(MaxLatency < us) MaxLatency = us;
+	tjs_int bucket = 0;
+	while(bucket < TVP_WB_HISTOGRAM_BUCKETS - 1 && us >= ((tjs_uint64)1 << bucket))
+		bucket++;
+	Histogram[bucket]++;
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// probes : measure the time spent in the wrapped object
+//---------------------------------------------------------------------------
+class tTVPWaveBenchmarkDecoderProbe : public tTVPWaveDecoder
+{
+	tTVPWaveDecoder * Decoder; // not owned
+
+public:
+	tjs_uint64 Clock; // total clock spent in the decoder
+
+	tTVPWaveBenchmarkDecoderProbe(tTVPWaveDecoder * decoder)
+		{ Decoder = decoder; Clock = 0; }
+
+	void GetFormat(tTVPWaveFormat & format) { Decoder->GetFormat(format); }
+
+	bool Render(void *buf, tjs_uint bufsamplelen, tjs_uint& rendered)
+	{
+		tjs_uint64 start = TJSGetPerformanceCounter();
+		bool ret = Decoder->Render(buf, bufsamplelen, rendered);
+		Clock += TJSGetPerformanceCounter() - start;
+		return ret;
+	}
+
+	bool SetPosition(tjs_uint64 samplepos)
+	{
+		tjs_uint64 start = TJSGetPerformanceCounter();
+		bool ret = Decoder->SetPosition(samplepos);
+		Clock += TJSGetPerformanceCounter() - start;
+		return ret;
+	}
+};
+//---------------------------------------------------------------------------
+class tTVPWaveBenchmarkSourceProbe : public tTVPSampleAndLabelSource
+{
+	tTVPSampleAndLabelSource * Source; // not owned
+
+public:
+	tjs_uint64 Clock; // total clock spent in the source
+
+	tTVPWaveBenchmarkSourceProbe(tTVPSampleAndLabelSource * source)
+		{ Source = source; Clock = 0; }
+
+	void Decode(void *dest, tjs_uint samples, tjs_uint &written,
+		tTVPWaveSegmentQueue &segments)
+	{
+		tjs_uint64 start = TJSGetPerformanceCounter();
+		Source->Decode(dest, samples, written, segments);
+		Clock += TJSGetPerformanceCounter() - start;
+	}
+
+	const tTVPWaveFormat & GetFormat() const { return Source->GetFormat(); }
+};
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// TVPBenchmarkWavePipeline
+//---------------------------------------------------------------------------
+static void TVPReadWaveBenchmarkLoopInformation(tTVPWaveLoopManager * manager,
+	const ttstr & storage, const ttstr & loopinfo)
+{
+	std::string info;
+	ttstr name;
+	if(!loopinfo.IsEmpty())
+	{
+		info = loopinfo.AsNarrowStdString();
+		name = TJS_W("(loop information)");
+	}
+	else
+	{
+		name = storage + TJS_W(".sli");
+		if(!TVPIsExistentStorage(name)) return;
+		tTVPStreamHolder slistream(name);
+		tjs_uint size = static_cast<tjs_uint>(slistream->GetSize());
+		info.resize(size);
+		if(size) slistream->ReadBuffer(&info[0], size);
+	}
+
+	std::vector<char> buffer(info.begin(), info.end());
+	buffer.push_back(0);
+	if(!manager->ReadInformation(&buffer[0]))
+		TVPThrowExceptionMessage(TVPInvalidLoopInformation, name);
+}
+//---------------------------------------------------------------------------
+void TVPBenchmarkWavePipeline(const ttstr & storage,
+	tjs_uint64 length, const std::vector<iTVPBasicWaveFilter *> & filters,
+	const ttstr & loopinfo, tTVPWaveBenchmarkResult & result)
+{
+	memset(&result.Format, 0, sizeof(result.Format));
+	result.Samples = result.Blocks = result.Time = 0;
+	for(tjs_int i = 0; i < wbsNumStages; i++) result.Stages[i].Clear();
+
+	// TVPCreateWaveDecoder may serve short clips from the decoded PCM cache,
+	// which would measure memcpy instead of the decoder
+	tTVPWaveDecoder * decoder = TVPCreateWaveDecoderFromCreators(storage);
+	tTVPWaveBenchmarkDecoderProbe decoderprobe(decoder);
+	tTVPWaveLoopManager * manager = NULL;
+	tTVPWaveBenchmarkSourceProbe * managerprobe = NULL;
+	tTVPWaveBenchmarkSourceProbe * filterprobe = NULL;
+	tTVPSoftwareMixer * mixer = NULL;
+	tTVPNullMixerOutput output;
+
+	try
+	{
+		// build the pipeline
+		manager = new tTVPWaveLoopManager();
+		manager->SetDecoder(&decoderprobe);
+		TVPReadWaveBenchmarkLoopInformation(manager, storage, loopinfo);
+
+		managerprobe = new tTVPWaveBenchmarkSourceProbe(manager);
+		tTVPSampleAndLabelSource * source = managerprobe;
+		for(std::vector<iTVPBasicWaveFilter *>::const_iterator i = filters.begin();
+			i != filters.end(); i++)
+			source = (*i)->Recreate(source);
+		filterprobe = new tTVPWaveBenchmarkSourceProbe(source);
+		result.Format = filterprobe->GetFormat();
+		tjs_uint64 samples = length * result.Format.SamplesPerSec / 1000;
+
+		mixer = new tTVPSoftwareMixer(result.Format.SamplesPerSec, &output);
+		tTVPSoftwareMixerVoice * voice = mixer->AddVoice(filterprobe);
+		voice->Play();
+
+		// run
+		tjs_uint64 total_start = TJSGetPerformanceCounter();
+		while(result.Samples < samples && voice->GetPlaying())
+		{
+			tjs_uint frames = TVP_WB_BLOCK_FRAMES;
+			if(samples - result.Samples < frames)
+				frames = (tjs_uint)(samples - result.Samples);
+
+			tjs_uint64 decoder_before = decoderprobe.Clock;
+			tjs_uint64 manager_before = managerprobe->Clock;
+			tjs_uint64 filter_before = filterprobe->Clock;
+			tjs_uint64 start = TJSGetPerformanceCounter();
+
+			for(std::vector<iTVPBasicWaveFilter *>::const_iterator i =
+				filters.begin(); i != filters.end(); i++)
+				(*i)->Update();
+			mixer->Render(frames);
+
+			tjs_uint64 block = TJSGetPerformanceCounter() - start;
+			tjs_uint64 dec = decoderprobe.Clock - decoder_before;
+			tjs_uint64 man = managerprobe->Clock - manager_before;
+			tjs_uint64 fil = filterprobe->Clock - filter_before;
+
+			result.Stages[wbsDecoder].Add(TVPWaveBenchmarkClockToUS(dec));
+			result.Stages[wbsLoopManager].Add(TVPWaveBenchmarkClockToUS(man - dec));
+			result.Stages[wbsFilters].Add(TVPWaveBenchmarkClockToUS(fil - man));
+			result.Stages[wbsMixer].Add(TVPWaveBenchmarkClockToUS(block - fil));
+
+			result.Samples += frames;
+			result.Blocks ++;
+		}
+		result.Time = TVPWaveBenchmarkClockToUS(
+			TJSGetPerformanceCounter() - total_start);
+	}
+	catch(...)
+	{
+		if(mixer) delete mixer;
+		for(std::vector<iTVPBasicWaveFilter *>::const_iterator i = filters.begin();
+			i != filters.end(); i++)
+			(*i)->Clear();
+		if(filterprobe) delete filterprobe;
+		if(managerprobe) delete managerprobe;
+		if(manager) delete manager;
+		delete decoder;
+		throw;
+	}
+
+	delete mixer;
+	for(std::vector<iTVPBasicWaveFilter *>::const_iterator i = filters.begin();
+		i != filters.end(); i++)
+		(*i)->Clear();
+	delete filterprobe;
+	delete managerprobe;
+	delete manager;
+	delete decoder;
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// result reporting
+//---------------------------------------------------------------------------
+static const char * const TVPWaveBenchmarkStageNames[wbsNumStages] =
+{
+	"decoder",
+	"loopManager",
+	"filters",
+	"mixer"
+};
+//---------------------------------------------------------------------------
+static double TVPWaveBenchmarkSamplesPerSec(tjs_uint64 samples, tjs_uint64 us)
+{
+	return us ? (double)samples * 1000000.0 / (double)us : 0.0;
+}
+//---------------------------------------------------------------------------
+void TVPReportWaveBenchmarkResult(const char * name,
+	const tTVPWaveBenchmarkResult & result)
+{
+	std::string prefix(name);
+	TVPBenchReport((prefix + "/samplesPerSec").c_str(),
+		TVPWaveBenchmarkSamplesPerSec(result.Samples, result.Time), "samples/s");
+	TVPBenchReport((prefix + "/realtime").c_str(), result.Time ?
+		(double)result.Samples * 1000000.0 / result.Format.SamplesPerSec /
+			(double)result.Time : 0.0, "x");
+
+	for(tjs_int i = 0; i < wbsNumStages; i++)
+	{
+		const tTVPWaveBenchmarkStage & stage = result.Stages[i];
+		std::string item = prefix + "/" + TVPWaveBenchmarkStageNames[i];
+		TVPBenchReport((item + "/samplesPerSec").c_str(),
+			TVPWaveBenchmarkSamplesPerSec(result.Samples, stage.Time), "samples/s");
+		TVPBenchReport((item + "/maxLatency").c_str(),
+			(double)stage.MaxLatency, "us");
+
+		// histogram; "<2^n us:count" for non-empty buckets
+		char buf[64];
+		std::string line;
+		for(tjs_int b = 0; b < TVP_WB_HISTOGRAM_BUCKETS; b++)
+		{
+			if(!stage.Histogram[b]) continue;
+			if(b == TVP_WB_HISTOGRAM_BUCKETS - 1)
+				sprintf(buf, " >=%lldus:%u", (long long)1 << (b - 1),
+					stage.Histogram[b]);
+			else
+				sprintf(buf, " <%lldus:%u", (long long)1 << b, stage.Histogram[b]);
+			line += buf;
+		}
+		printf("%s/%s/latency:%s\n", TVPBenchCurrentSuite, item.c_str(),
+			line.c_str());
+	}
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// TVPBenchWriteWave
+//---------------------------------------------------------------------------
+static void TVPBenchPutLE(std::vector<tjs_uint8> & out, tjs_uint32 v, tjs_int bytes)
+{
+	for(tjs_int i = 0; i < bytes; i++) out.push_back((tjs_uint8)(v >> (i * 8)));
+}
+//---------------------------------------------------------------------------
+void TVPBenchWriteWave(const std::string & path, tjs_uint frequency,
+	tjs_uint channels, tjs_uint samples)
+{
+	tjs_uint datasize = samples * channels * 2;
+	std::vector<tjs_uint8> out;
+	out.reserve(44 + datasize);
+	out.insert(out.end(), "RIFF", "RIFF" + 4);
+	TVPBenchPutLE(out, 36 + datasize, 4);
+	out.insert(out.end(), "WAVEfmt ", "WAVEfmt " + 8);
+	TVPBenchPutLE(out, 16, 4);
+	TVPBenchPutLE(out, 1, 2); // WAVE_FORMAT_PCM
+	TVPBenchPutLE(out, channels, 2);
+	TVPBenchPutLE(out, frequency, 4);
+	TVPBenchPutLE(out, frequency * channels * 2, 4);
+	TVPBenchPutLE(out, channels * 2, 2);
+	TVPBenchPutLE(out, 16, 2);
+	out.insert(out.end(), "data", "data" + 4);
+	TVPBenchPutLE(out, datasize, 4);
+
+	for(tjs_uint s = 0; s < samples; s++)
+	{
+		double t = (double)s / frequency;
+		for(tjs_uint c = 0; c < channels; c++)
+		{
+			double v = 0.3 * sin(2 * M_PI * 440.0 * (c + 1) * t) +
+				0.2 * sin(2 * M_PI * 554.37 * t) + 0.1 * sin(2 * M_PI * 659.26 * t);
+			TVPBenchPutLE(out, (tjs_uint16)(tjs_int16)(v * 32767), 2);
+		}
+	}
+
+	FILE * f = fopen(path.c_str(), "wb");
+	if(!f) TVPThrowExceptionMessage(TVPCannotOpenStorageForWrite, ttstr(path.c_str()));
+	fwrite(&out[0], 1, out.size(), f);
+	fclose(f);
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// suite
+//---------------------------------------------------------------------------
+TVP_BENCH_SUITE(wave)
+{
+	const tjs_uint frequency = 44100;
+	tjs_uint seconds = TVPBenchQuick ? 1 : 20;
+	std::string path = TVPBenchTempPath("wave.wav");
+	TVPBenchWriteWave(path, frequency, 2, frequency * seconds);
+	ttstr storage(path.c_str());
+	tjs_uint64 length = (tjs_uint64)seconds * 1000;
+
+	std::vector<iTVPBasicWaveFilter *> nofilters;
+	tTVPWaveBenchmarkResult result;
+
+	// straight playback
+	TVPBenchmarkWavePipeline(storage, length, nofilters, TJS_W(""), result);
+	TVPReportWaveBenchmarkResult("plain", result);
+
+	// a loop every 1/4 second with labels, played for the same length
+	std::string sli = "#2.00\n";
+	char buf[256];
+	for(tjs_uint i = 1; i < seconds * 4; i++)
+	{
+		tjs_uint pos = frequency * i / 4;
+		sprintf(buf, "Link { From=%u; To=%u; Smooth=True; Condition=no; "
+			"RefValue=0; CondVar=0; }\n", pos + frequency / 8, pos);
+		sli += buf;
+		sprintf(buf, "Label { Position=%u; Name=\"l%u\"; }\n", pos, i);
+		sli += buf;
+	}
+	TVPBenchmarkWavePipeline(storage, length, nofilters,
+		ttstr(sli.c_str()), result);
+	TVPReportWaveBenchmarkResult("loops", result);
+
+	// phase vocoder (time stretch for fast-forward)
+	tTJSNI_PhaseVocoder vocoder;
+	vocoder.SetTime(0.5f);
+	std::vector<iTVPBasicWaveFilter *> filters;
+	filters.push_back(&vocoder);
+	TVPBenchmarkWavePipeline(storage, length / 2, filters, TJS_W(""), result);
+	TVPReportWaveBenchmarkResult("phaseVocoder", result);
+
+	remove(path.c_str());
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// tTVPBenchToneSource : endless 16bit tone, for the mixer benchmark
+//---------------------------------------------------------------------------
+class tTVPBenchToneSource : public tTVPSampleAndLabelSource
+{
+	tTVPWaveFormat Format;
+	std::vector<tjs_int16> Period; // one period of the tone
+	tjs_uint Position; // in sample granules, in Period
+
+public:
+	tTVPBenchToneSource(tjs_uint frequency, tjs_uint channels, tjs_uint period)
+	{
+		memset(&Format, 0, sizeof(Format));
+		Format.SamplesPerSec = frequency;
+		Format.Channels = channels;
+		Format.BitsPerSample = 16;
+		Format.BytesPerSample = 2;
+		Format.Seekable = false;
+
+		Period.resize(period * channels);
+		for(tjs_uint s = 0; s < period; s++)
+			for(tjs_uint c = 0; c < channels; c++)
+				Period[s * channels + c] =
+					(tjs_int16)(8000 * sin(2 * M_PI * s / period));
+		Position = 0;
+	}
+
+	void Decode(void *dest, tjs_uint samples, tjs_uint &written,
+		tTVPWaveSegmentQueue &segments)
+	{
+		// copying from the table is negligible beside the mixing
+		tjs_int16 * d = (tjs_int16 *)dest;
+		tjs_uint period = (tjs_uint)Period.size() / Format.Channels;
+		tjs_uint remain = samples;
+		while(remain)
+		{
+			tjs_uint one = period - Position;
+			if(one > remain) one = remain;
+			memcpy(d, &Period[Position * Format.Channels],
+				one * Format.Channels * sizeof(tjs_int16));
+			d += one * Format.Channels;
+			Position = (Position + one) % period;
+			remain -= one;
+		}
+		written = samples;
+		segments.Clear();
+	}
+
+	const tTVPWaveFormat & GetFormat() const { return Format; }
+};
+//---------------------------------------------------------------------------
+static void TVPBenchmarkMixer(tjs_uint voices, tjs_uint seconds)
+{
+	// voices of mixed formats, as a scene with many sound effects would have:
+	// one third at the output frequency, the others resampled; half mono.
+	const tjs_uint frequency = 44100;
+	static const tjs_uint source_frequencies[3] = { 44100, 22050, 48000 };
+
+	std::vector<tTVPBenchToneSource *> sources;
+	tTVPNullMixerOutput output;
+	tTVPSoftwareMixer * mixer = NULL;
+	double time = 0;
+	try
+	{
+		mixer = new tTVPSoftwareMixer(frequency, &output);
+		for(tjs_uint i = 0; i < voices; i++)
+		{
+			sources.push_back(new tTVPBenchToneSource(
+				source_frequencies[i % 3], 1 + (i / 3) % 2, 100 + i));
+			tTVPSoftwareMixerVoice * voice = mixer->AddVoice(sources.back());
+			voice->SetVolume(1.0f / voices);
+			voice->SetPan((float)i / voices * 2 - 1);
+			voice->Play();
+		}
+
+		tjs_uint64 frames = (tjs_uint64)frequency * seconds;
+		tTVPBenchTimer timer;
+		for(tjs_uint64 done = 0; done < frames; done += TVP_WB_BLOCK_FRAMES)
+			mixer->Render(TVP_WB_BLOCK_FRAMES);
+		time = timer.GetSeconds();
+	}
+	catch(...)
+	{
+		if(mixer) delete mixer;
+		for(tjs_uint i = 0; i < sources.size(); i++) delete sources[i];
+		throw;
+	}
+	delete mixer;
+	for(tjs_uint i = 0; i < sources.size(); i++) delete sources[i];
+
+	char item[64];
+	double audio = (double)output.GetWritten() / frequency;
+	sprintf(item, "voices%u_realtime", voices);
+	TVPBenchReport(item, audio / time, "x");
+	sprintf(item, "voices%u_voice_frame", voices);
+	TVPBenchReport(item, time * 1e9 / ((double)output.GetWritten() * voices), "ns");
+}
+//---------------------------------------------------------------------------
+TVP_BENCH_SUITE(mixer)
+{
+	// the mixer alone, with many voices and no decoder; "realtime" is
+	// seconds of output mixed per second, "voice_frame" is the cost of one
+	// sample granule of one voice.
+	static const tjs_uint voices[] = { 16, 64, 128, 256 };
+	for(tjs_uint i = 0; i < sizeof(voices) / sizeof(voices[0]); i++)
+	{
+		if(TVPBenchQuick && voices[i] != 64) continue;
+		TVPBenchmarkMixer(voices[i], TVPBenchQuick ? 1 : 20);
+	}
+}
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// phase vocoder realtime factor
+//---------------------------------------------------------------------------
+TVP_BENCH_SUITE(phasevocoder)
+{
+	// the phase vocoder filter alone (the filter stage of the pipeline) at
+	// the smallest usual frame size and at the default one; "realtime" is
+	// seconds of output (what the sound buffer plays) made per second.
+	const tjs_uint frequency = 44100;
+	tjs_uint seconds = TVPBenchQuick ? 1 : 20;
+	std::string path = TVPBenchTempPath("phasevocoder.wav");
+	TVPBenchWriteWave(path, frequency, 2, frequency * seconds);
+	ttstr storage(path.c_str());
+
+	static const int windows[] = { 256, 4096 };
+	static const struct { const char * Name; float Time; float Pitch; } modes[] =
+	{
+		{ "stretch", 0.5f, 1.0f }, // fast-forward; output is half the length
+		{ "pitch", 1.0f, 1.5f },
+	};
+
+	try
+	{
+		for(tjs_uint w = 0; w < sizeof(windows) / sizeof(windows[0]); w++)
+		{
+			for(tjs_uint m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+			{
+				tTJSNI_PhaseVocoder vocoder;
+				vocoder.SetWindow(windows[w]);
+				vocoder.SetTime(modes[m].Time);
+				vocoder.SetPitch(modes[m].Pitch);
+				std::vector<iTVPBasicWaveFilter *> filters;
+				filters.push_back(&vocoder);
+
+				tTVPWaveBenchmarkResult result;
+				TVPBenchmarkWavePipeline(storage,
+					(tjs_uint64)(seconds * 1000 * modes[m].Time), filters,
+					TJS_W(""), result);
+
+				double audio = (double)result.Samples /
+					result.Format.SamplesPerSec;
+				double filter = result.Stages[wbsFilters].Time / 1000000.0;
+				char item[64];
+				sprintf(item, "w%d_%s_realtime", windows[w], modes[m].Name);
+				TVPBenchReport(item, filter > 0 ? audio / filter : 0, "x");
+				sprintf(item, "w%d_%s_max_block", windows[w], modes[m].Name);
+				TVPBenchReport(item,
+					(double)result.Stages[wbsFilters].MaxLatency, "us");
+			}
+		}
+	}
+	catch(...)
+	{
+		remove(path.c_str());
+		throw;
+	}
+	remove(path.c_str());
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,83 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Wave Pipeline Benchmark
+//---------------------------------------------------------------------------
+/*
+	Runs the whole audio pipeline (decoder -> loop manager -> filter chain ->
+	software mixer) as fast as possible, without any sound device, and
+	measures each stage.
+
+	The pipeline is driven by blocks of TVP_WB_BLOCK_FRAMES output sample
+	granules; the time each stage spends in one block is its latency for the
+	block, and the latencies are counted in histograms whose bucket n holds
+	the blocks which took less than 2^n microseconds (the last bucket holds
+	everything above).
+*/
+#ifndef WaveBenchmarkH
+#define WaveBenchmarkH
+
+#include <string>
+#include <vector>
+#include "WaveIntf.h"
+
+#define TVP_WB_BLOCK_FRAMES 4096
+#define TVP_WB_HISTOGRAM_BUCKETS 24
+
+//---------------------------------------------------------------------------
+// tTVPWaveBenchmarkStage : measurement of one stage
+//---------------------------------------------------------------------------
+struct tTVPWaveBenchmarkStage
+{
+	tjs_uint64 Time; // total time spent in the stage, in us
+	tjs_uint64 MaxLatency; // the longest block, in us
+	tjs_uint Histogram[TVP_WB_HISTOGRAM_BUCKETS]; // block latency histogram
+
+	void Clear();
+	void Add(tjs_uint64 us);
+};
+//---------------------------------------------------------------------------
+enum tTVPWaveBenchmarkStageIndex
+{
+	wbsDecoder,		// tTVPWaveDecoder::Render and SetPosition
+	wbsLoopManager,	// tTVPWaveLoopManager, excluding the decoder
+	wbsFilters,		// the filter chain, excluding the loop manager
+	wbsMixer,		// tTVPSoftwareMixer, excluding the filter chain
+	wbsNumStages
+};
+//---------------------------------------------------------------------------
+struct tTVPWaveBenchmarkResult
+{
+	tTVPWaveFormat Format; // format of the filter chain output
+	tjs_uint64 Samples; // output sample granules
+	tjs_uint64 Blocks; // processed blocks
+	tjs_uint64 Time; // total time, in us
+	tTVPWaveBenchmarkStage Stages[wbsNumStages];
+};
+//---------------------------------------------------------------------------
+extern void TVPBenchmarkWavePipeline(const ttstr & storage,
+	tjs_uint64 length, const std::vector<iTVPBasicWaveFilter *> & filters,
+	const ttstr & loopinfo, tTVPWaveBenchmarkResult & result);
+	/*
+		"length" is the length of the output to process, in ms (the pipeline
+		also stops when the source ends). "filters" are the filter chain, in
+		the order of WaveSoundBuffer.filters; they must not be used by any
+		sound buffer at the same time. "loopinfo" is the loop information in
+		the .sli format; if empty, storage + ".sli" is read if exists.
+		The decoder is created directly by the registered decoder creators,
+		so the decoded PCM cache does not take the decoder's place.
+	*/
+extern void TVPReportWaveBenchmarkResult(const char * name,
+	const tTVPWaveBenchmarkResult & result);
+	// reports the result through TVPBenchReport, items prefixed by "name"
+extern void TVPBenchWriteWave(const std::string & path, tjs_uint frequency,
+	tjs_uint channels, tjs_uint samples);
+	// writes a 16bit RIFF WAVE file of a chord, for the benchmarks
+//---------------------------------------------------------------------------
+
+#endif
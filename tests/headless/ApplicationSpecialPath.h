@@ -0,0 +1,21 @@
+//---------------------------------------------------------------------------
+// ApplicationSpecialPath (headless; only what msg/MsgIntf.cpp uses)
+//---------------------------------------------------------------------------
+#ifndef __APPLICATION_SPECIAL_PATH_H__
+#define __APPLICATION_SPECIAL_PATH_H__
+
+#include <string>
+
+class ApplicationSpecialPath {
+public:
+	static std::wstring ReplaceStringAll( std::wstring src, const std::wstring& target, const std::wstring& dest ) {
+		std::wstring::size_type nPos = 0;
+		while( (nPos = src.find(target, nPos)) != std::wstring::npos ) {
+			src.replace(nPos, target.length(), dest);
+			nPos += dest.length();
+		}
+		return src;
+	}
+};
+
+#endif
@@ -0,0 +1,46 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Bitmap information (headless; no BITMAPINFO)
+//---------------------------------------------------------------------------
+#ifndef __BITMAP_INFOMATION_H__
+#define __BITMAP_INFOMATION_H__
+
+class BitmapInfomation {
+	tjs_uint Width; // aligned width
+	tjs_uint Height;
+	int BPP;
+	tjs_uint ImageSize;
+public:
+	BitmapInfomation( tjs_uint width, tjs_uint height, int bpp ) {
+		// same pitch as the win32 implementation
+		tjs_int PitchBytes;
+		tjs_uint bitmap_width = width;
+		if( bpp == 8 ) {
+			bitmap_width = (((bitmap_width-1) / 16)+1) *16; // align to a paragraph
+			PitchBytes = (((bitmap_width-1) >> 2)+1) <<2;
+		} else {
+			bitmap_width = (((bitmap_width-1) / 4)+1) *4; // align to a paragraph
+			PitchBytes = bitmap_width * 4;
+		}
+		Width = bitmap_width;
+		Height = height;
+		BPP = bpp;
+		ImageSize = PitchBytes * height;
+	}
+
+	inline unsigned int GetBPP() const { return BPP; }
+	inline bool Is32bit() const { return GetBPP() == 32; }
+	inline bool Is8bit() const { return GetBPP() == 8; }
+	inline int GetWidth() const { return Width; }
+	inline int GetHeight() const { return Height; }
+	inline tjs_uint GetImageSize() const { return ImageSize; }
+	inline int GetPitchBytes() const { return GetImageSize()/GetHeight(); }
+};
+
+#endif // __BITMAP_INFOMATION_H__
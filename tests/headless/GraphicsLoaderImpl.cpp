@@ -0,0 +1,144 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Graphics Loader implementation (headless; no plug-ins)
+//---------------------------------------------------------------------------
+/*
+	The handlers call the built-in loaders directly; there are no Susie or
+	plug-in handlers. The codecs which are not a part of the headless build
+	(PNG and JPEG XR, and JPEG without libjpeg) report the format as
+	unknown.
+*/
+#include "tjsCommHead.h"
+
+#include "GraphicsLoaderIntf.h"
+#include "StorageIntf.h"
+#include "MsgIntf.h"
+
+
+//---------------------------------------------------------------------------
+// tTVPGraphicHandlerType
+//---------------------------------------------------------------------------
+void tTVPGraphicHandlerType::Load(void* formatdata, void *callbackdata,
+	tTVPGraphicSizeCallback sizecallback, tTVPGraphicScanLineCallback scanlinecallback,
+	tTVPMetaInfoPushCallback metainfopushcallback, tTJSBinaryStream *src,
+	tjs_int32 keyidx, tTVPGraphicLoadMode mode)
+{
+	if(LoadHandler == NULL || IsPlugin)
+		TVPThrowExceptionMessage(TVPUnknownGraphicFormat, TJS_W("unknown"));
+	LoadHandler(formatdata, callbackdata, sizecallback, scanlinecallback,
+		metainfopushcallback, src, keyidx, mode);
+}
+//---------------------------------------------------------------------------
+void tTVPGraphicHandlerType::Save(const ttstr & storagename, const ttstr & mode,
+	const tTVPBaseBitmap* image, iTJSDispatch2* meta)
+{
+	if(SaveHandler == NULL || IsPlugin)
+		TVPThrowExceptionMessage(TVPUnknownGraphicFormat, mode);
+
+	tTJSBinaryStream *stream =
+		TVPCreateStream(TVPNormalizeStorageName(storagename), TJS_BS_WRITE);
+	try
+	{
+		SaveHandler(FormatData, stream, image, mode, meta);
+	}
+	catch(...)
+	{
+		delete stream;
+		throw;
+	}
+	delete stream;
+}
+//---------------------------------------------------------------------------
+void tTVPGraphicHandlerType::Header(tTJSBinaryStream *src, iTJSDispatch2** dic)
+{
+	if(HeaderHandler == NULL || IsPlugin)
+		TVPThrowExceptionMessage(TVPUnknownGraphicFormat, TJS_W("unknown"));
+	HeaderHandler(FormatData, src, dic);
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// formats without codec
+//---------------------------------------------------------------------------
+void TVPLoadPNG(void* formatdata, void *callbackdata,
+	tTVPGraphicSizeCallback sizecallback, tTVPGraphicScanLineCallback scanlinecallback,
+	tTVPMetaInfoPushCallback metainfopushcallback, tTJSBinaryStream *src,
+	tjs_int keyidx, tTVPGraphicLoadMode mode)
+{
+	TVPThrowExceptionMessage(TVPUnknownGraphicFormat, TJS_W("png"));
+}
+void TVPLoadHeaderPNG(void* formatdata, tTJSBinaryStream *src, iTJSDispatch2** dic)
+{
+	TVPThrowExceptionMessage(TVPUnknownGraphicFormat, TJS_W("png"));
+}
+void TVPSaveAsPNG(void* formatdata, tTJSBinaryStream* dst, const tTVPBaseBitmap* image,
+	const ttstr & mode, iTJSDispatch2* meta)
+{
+	TVPThrowExceptionMessage(TVPUnknownGraphicFormat, mode);
+}
+bool TVPAcceptSaveAsPNG(void* formatdata, const ttstr & type, iTJSDispatch2** dic)
+{
+	return false;
+}
+//---------------------------------------------------------------------------
+void TVPLoadJXR(void* formatdata, void *callbackdata,
+	tTVPGraphicSizeCallback sizecallback, tTVPGraphicScanLineCallback scanlinecallback,
+	tTVPMetaInfoPushCallback metainfopushcallback, tTJSBinaryStream *src,
+	tjs_int keyidx, tTVPGraphicLoadMode mode)
+{
+	TVPThrowExceptionMessage(TVPUnknownGraphicFormat, TJS_W("jxr"));
+}
+void TVPLoadHeaderJXR(void* formatdata, tTJSBinaryStream *src, iTJSDispatch2** dic)
+{
+	TVPThrowExceptionMessage(TVPUnknownGraphicFormat, TJS_W("jxr"));
+}
+void TVPSaveAsJXR(void* formatdata, tTJSBinaryStream* dst, const tTVPBaseBitmap* image,
+	const ttstr & mode, iTJSDispatch2* meta)
+{
+	TVPThrowExceptionMessage(TVPUnknownGraphicFormat, mode);
+}
+bool TVPAcceptSaveAsJXR(void* formatdata, const ttstr & type, iTJSDispatch2** dic)
+{
+	return false;
+}
+//---------------------------------------------------------------------------
+#ifndef TVP_HEADLESS_JPEG
+void TVPLoadJPEG(void* formatdata, void *callbackdata,
+	tTVPGraphicSizeCallback sizecallback, tTVPGraphicScanLineCallback scanlinecallback,
+	tTVPMetaInfoPushCallback metainfopushcallback, tTJSBinaryStream *src,
+	tjs_int keyidx, tTVPGraphicLoadMode mode)
+{
+	TVPThrowExceptionMessage(TVPUnknownGraphicFormat, TJS_W("jpeg"));
+}
+void TVPLoadHeaderJPG(void* formatdata, tTJSBinaryStream *src, iTJSDispatch2** dic)
+{
+	TVPThrowExceptionMessage(TVPUnknownGraphicFormat, TJS_W("jpeg"));
+}
+void TVPSaveAsJPG(void* formatdata, tTJSBinaryStream* dst, const tTVPBaseBitmap* image,
+	const ttstr & mode, iTJSDispatch2* meta)
+{
+	TVPThrowExceptionMessage(TVPUnknownGraphicFormat, mode);
+}
+bool TVPAcceptSaveAsJPG(void* formatdata, const ttstr & type, iTJSDispatch2** dic)
+{
+	return false;
+}
+//---------------------------------------------------------------------------
+void TVPLoadJPEGReduced(void *callbackdata, tTVPGraphicSizeCallback sizecallback,
+	tTVPGraphicScanLineCallback scanlinecallback, tTJSBinaryStream *src,
+	tTVPGraphicLoadMode mode, tjs_uint regw, tjs_uint regh, tjs_uint dstw, tjs_uint dsth,
+	tjs_int *scalenum, tjs_int *scaledenom)
+{
+	TVPThrowExceptionMessage(TVPUnknownGraphicFormat, TJS_W("jpeg"));
+}
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,504 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Host services for the headless build
+//---------------------------------------------------------------------------
+/*
+	The engine core expects the application to provide logging, storages,
+	events, the compact event and the CPU detection. This file gives the
+	smallest implementation of them on the C runtime, enough to run the
+	platform independent parts in the tests and the benchmarks: storages are
+	plain files named by their path, events are discarded, and the log goes
+	to the standard output. The script engine is created at the first use.
+	Temporary files go to a directory of this process, which is removed with
+	its contents by TVPUninitHeadlessHost.
+*/
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "HeadlessHost.h"
+#include "tjsDictionary.h"
+#include "tjsArray.h"
+#include "DebugIntf.h"
+#include "EventIntf.h"
+#include "StorageIntf.h"
+#include "SysInitIntf.h"
+#include "ScriptMgnIntf.h"
+#include "MsgIntf.h"
+#include "ThreadIntf.h"
+#include "TickCount.h"
+#include "DetectCPU.h"
+#include "tvpgl_ia32_intf.h"
+
+
+//---------------------------------------------------------------------------
+// log
+//---------------------------------------------------------------------------
+bool TVPHeadlessLogQuiet = false;
+//---------------------------------------------------------------------------
+void TVPAddLog(const ttstr &line)
+{
+	if(!TVPHeadlessLogQuiet)
+		printf("%s\n", line.AsNarrowStdString().c_str());
+}
+//---------------------------------------------------------------------------
+void TVPAddImportantLog(const ttstr &line)
+{
+	printf("%s\n", line.AsNarrowStdString().c_str());
+}
+//---------------------------------------------------------------------------
+ttstr TVPGetImportantLog()
+{
+	return ttstr();
+}
+//---------------------------------------------------------------------------
+void TVPGetVersion()
+{
+}
+//---------------------------------------------------------------------------
+ttstr TVPReadAboutStringFromResource()
+{
+	return TJS_W("headless build");
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// tick count
+//---------------------------------------------------------------------------
+tjs_uint64 TVPGetTickCount()
+{
+	return (tjs_uint64)std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// CPU detection
+//---------------------------------------------------------------------------
+extern "C"
+{
+	tjs_uint32 TVPCPUType = 0;
+}
+//---------------------------------------------------------------------------
+void TVPDetectCPU()
+{
+	tjs_uint32 type = TVP_CPU_HAS_FPU;
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("mmx")) type |= TVP_CPU_HAS_MMX;
+	if(__builtin_cpu_supports("cmov")) type |= TVP_CPU_HAS_CMOV;
+	if(__builtin_cpu_supports("sse")) type |= TVP_CPU_HAS_SSE;
+	if(__builtin_cpu_supports("sse2")) type |= TVP_CPU_HAS_SSE2;
+	if(__builtin_cpu_supports("sse3")) type |= TVP_CPU_HAS_SSE3;
+	if(__builtin_cpu_supports("ssse3")) type |= TVP_CPU_HAS_SSSE3;
+	if(__builtin_cpu_supports("sse4.1")) type |= TVP_CPU_HAS_SSE41;
+	if(__builtin_cpu_supports("sse4.2")) type |= TVP_CPU_HAS_SSE42;
+	if(__builtin_cpu_supports("avx")) type |= TVP_CPU_HAS_AVX;
+	if(__builtin_cpu_supports("avx2")) type |= TVP_CPU_HAS_AVX2;
+	if(__builtin_cpu_supports("fma")) type |= TVP_CPU_HAS_FMA3;
+#endif
+	TVPCPUType = type;
+}
+//---------------------------------------------------------------------------
+tjs_uint32 TVPGetCPUType()
+{
+	return TVPCPUType;
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// tTVPHeadlessFileStream : storage on a plain file
+//---------------------------------------------------------------------------
+class tTVPHeadlessFileStream : public tTJSBinaryStream
+{
+	FILE * File;
+
+public:
+	tTVPHeadlessFileStream(const ttstr & name, tjs_uint32 flag)
+	{
+		const char * mode;
+		switch(flag & TJS_BS_ACCESS_MASK)
+		{
+		case TJS_BS_WRITE:	mode = "wb"; break;
+		case TJS_BS_APPEND:	mode = "ab"; break;
+		case TJS_BS_UPDATE:	mode = "r+b"; break;
+		default:			mode = "rb"; break;
+		}
+		File = fopen(name.AsNarrowStdString().c_str(), mode);
+		if(!File) TVPThrowExceptionMessage((flag & TJS_BS_ACCESS_MASK) == TJS_BS_READ ?
+			TVPCannotOpenStorage : TVPCannotOpenStorageForWrite, name);
+	}
+
+	~tTVPHeadlessFileStream() { fclose(File); }
+
+	tjs_uint64 TJS_INTF_METHOD Seek(tjs_int64 offset, tjs_int whence)
+	{
+		int w = whence == TJS_BS_SEEK_CUR ? SEEK_CUR :
+			whence == TJS_BS_SEEK_END ? SEEK_END : SEEK_SET;
+		fseeko(File, (off_t)offset, w);
+		return (tjs_uint64)ftello(File);
+	}
+
+	tjs_uint TJS_INTF_METHOD Read(void *buffer, tjs_uint read_size)
+		{ return (tjs_uint)fread(buffer, 1, read_size, File); }
+
+	tjs_uint TJS_INTF_METHOD Write(const void *buffer, tjs_uint write_size)
+		{ return (tjs_uint)fwrite(buffer, 1, write_size, File); }
+
+	tjs_uint64 TJS_INTF_METHOD GetSize()
+	{
+		off_t pos = ftello(File);
+		fseeko(File, 0, SEEK_END);
+		off_t size = ftello(File);
+		fseeko(File, pos, SEEK_SET);
+		return (tjs_uint64)size;
+	}
+};
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// storage functions
+//---------------------------------------------------------------------------
+tTJSBinaryStream * TVPCreateStream(const ttstr & name, tjs_uint32 flags)
+{
+	return new tTVPHeadlessFileStream(name, flags);
+}
+//---------------------------------------------------------------------------
+static tTJSBinaryStream * TVPHeadlessCreateBinaryStreamForRead(
+	const ttstr & name, const ttstr & modestr)
+{
+	return TVPCreateStream(name, TJS_BS_READ);
+}
+//---------------------------------------------------------------------------
+static tTJSBinaryStream * TVPHeadlessCreateBinaryStreamForWrite(
+	const ttstr & name, const ttstr & modestr)
+{
+	// "o<offset>" updates the storage from the offset, as
+	// TVPCreateBinaryStreamForWrite (base/BinaryStream.cpp)
+	const tjs_char * o_ofs = TJS_strchr(modestr.c_str(), TJS_W('o'));
+	if(!o_ofs) return TVPCreateStream(name, TJS_BS_WRITE);
+
+	tjs_uint64 ofs = 0;
+	for(o_ofs++; *o_ofs >= TJS_W('0') && *o_ofs <= TJS_W('9'); o_ofs++)
+		ofs = ofs * 10 + (*o_ofs - TJS_W('0'));
+	tTJSBinaryStream * stream = TVPCreateStream(name, TJS_BS_UPDATE);
+	stream->SetPosition(ofs);
+	return stream;
+}
+//---------------------------------------------------------------------------
+bool TVPIsExistentStorageNoSearch(const ttstr &name)
+{
+	FILE * f = fopen(name.AsNarrowStdString().c_str(), "rb");
+	if(!f) return false;
+	fclose(f);
+	return true;
+}
+//---------------------------------------------------------------------------
+bool TVPIsExistentStorageNoSearchNoNormalize(const ttstr &name)
+{
+	return TVPIsExistentStorageNoSearch(name);
+}
+//---------------------------------------------------------------------------
+bool TVPIsExistentStorage(const ttstr &name)
+{
+	return TVPIsExistentStorageNoSearch(name);
+}
+//---------------------------------------------------------------------------
+ttstr TVPNormalizeStorageName(const ttstr & name)
+{
+	return name;
+}
+//---------------------------------------------------------------------------
+ttstr TVPGetPlacedPath(const ttstr & name)
+{
+	return TVPIsExistentStorageNoSearch(name) ? name : ttstr();
+}
+//---------------------------------------------------------------------------
+ttstr TVPExtractStorageExt(const ttstr & name)
+{
+	// extract an extension (including the dot) from name
+	const tjs_char * s = name.c_str();
+	tjs_int slen = name.GetLen();
+	const tjs_char * p = s + slen;
+	while(p > s)
+	{
+		p--;
+		if(*p == TJS_W('/') || *p == TJS_W('\\')) break;
+		if(*p == TJS_W('.')) return ttstr(p);
+	}
+	return ttstr();
+}
+//---------------------------------------------------------------------------
+ttstr TVPExtractStorageName(const ttstr & name)
+{
+	// extract a storage name from name (excluding the path)
+	const tjs_char * s = name.c_str();
+	const tjs_char * p = s + name.GetLen();
+	while(p > s && p[-1] != TJS_W('/') && p[-1] != TJS_W('\\')) p--;
+	return ttstr(p);
+}
+//---------------------------------------------------------------------------
+ttstr TVPGetLocallyAccessibleName(const ttstr &name)
+{
+	return name;
+}
+//---------------------------------------------------------------------------
+ttstr TVPGetTemporaryName()
+{
+	static tjs_int count = 0;
+	char buf[64];
+	snprintf(buf, sizeof(buf), "tvptmp_%d", (int)count++);
+	return ttstr(TVPHeadlessTempPath(buf).c_str());
+}
+//---------------------------------------------------------------------------
+bool TVPRemoveFile(const ttstr &name)
+{
+	return 0 == remove(name.AsNarrowStdString().c_str());
+}
+//---------------------------------------------------------------------------
+bool TVPRemoveFolder(const ttstr &name)
+{
+	return 0 == rmdir(name.AsNarrowStdString().c_str());
+}
+//---------------------------------------------------------------------------
+bool TVPRenameFile(const ttstr &from, const ttstr &to)
+{
+	return 0 == rename(from.AsNarrowStdString().c_str(),
+		to.AsNarrowStdString().c_str());
+}
+//---------------------------------------------------------------------------
+bool TVPRenameStorage(const ttstr &from, const ttstr &to)
+{
+	return TVPRenameFile(from, to);
+}
+//---------------------------------------------------------------------------
+bool TVPCreateFolders(const ttstr &folder)
+{
+	// create the folder and its parents
+	std::string path = folder.AsNarrowStdString();
+	for(size_t i = 1; i <= path.size(); i++)
+	{
+		if(i == path.size() || path[i] == '/')
+		{
+			std::string sub = path.substr(0, i);
+			if(mkdir(sub.c_str(), 0777) != 0 && errno != EEXIST) return false;
+		}
+	}
+	return true;
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// events; there is no event loop, so the events are discarded
+//---------------------------------------------------------------------------
+ttstr TVPActionName(TJS_W("action"));
+//---------------------------------------------------------------------------
+void TVPPostEvent(iTJSDispatch2 * source, iTJSDispatch2 *target,
+	ttstr &eventname, tjs_uint32 tag, tjs_uint32 flag,
+	tjs_uint numargs, tTJSVariant *args)
+{
+}
+//---------------------------------------------------------------------------
+void TVPCancelSourceEvents(iTJSDispatch2 * source)
+{
+}
+//---------------------------------------------------------------------------
+iTJSDispatch2 * TVPCreateEventObject(const tjs_char *type,
+	iTJSDispatch2 *targthis, iTJSDispatch2 *targ)
+{
+	return TJSCreateDictionaryObject();
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// compact event
+//---------------------------------------------------------------------------
+static std::vector<tTVPCompactEventCallbackIntf *> TVPCompactEventHooks;
+//---------------------------------------------------------------------------
+void TVPAddCompactEventHook(tTVPCompactEventCallbackIntf *cb)
+{
+	TVPCompactEventHooks.push_back(cb);
+}
+//---------------------------------------------------------------------------
+void TVPRemoveCompactEventHook(tTVPCompactEventCallbackIntf *cb)
+{
+	std::vector<tTVPCompactEventCallbackIntf *>::iterator i =
+		std::find(TVPCompactEventHooks.begin(), TVPCompactEventHooks.end(), cb);
+	if(i != TVPCompactEventHooks.end()) *i = NULL;
+}
+//---------------------------------------------------------------------------
+void TVPDeliverCompactEvent(tjs_int level)
+{
+	for(tjs_uint i = 0; i < TVPCompactEventHooks.size(); i++)
+		if(TVPCompactEventHooks[i]) TVPCompactEventHooks[i]->OnCompact(level);
+	TVPCompactEventHooks.erase(std::remove(TVPCompactEventHooks.begin(),
+		TVPCompactEventHooks.end(), (tTVPCompactEventCallbackIntf *)NULL),
+		TVPCompactEventHooks.end());
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// script engine
+//---------------------------------------------------------------------------
+static tTJS * TVPScriptEngine = NULL;
+//---------------------------------------------------------------------------
+tTJS * TVPGetScriptEngine()
+{
+	if(!TVPScriptEngine) TVPScriptEngine = new tTJS();
+	return TVPScriptEngine;
+}
+//---------------------------------------------------------------------------
+void TVPExecuteExpression(const ttstr &content, iTJSDispatch2 *context,
+	tTJSVariant *result)
+{
+	TVPGetScriptEngine()->EvalExpression(content, result, context);
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// at-exit handlers
+//---------------------------------------------------------------------------
+struct tTVPHeadlessAtExitHandler
+{
+	tjs_int Priority;
+	void (*Handler)();
+	bool operator < (const tTVPHeadlessAtExitHandler & rhs) const
+		{ return Priority < rhs.Priority; }
+};
+static std::vector<tTVPHeadlessAtExitHandler> * TVPAtExitHandlers = NULL;
+//---------------------------------------------------------------------------
+void TVPAddAtExitHandler(tjs_int pri, void (*handler)())
+{
+	// static initializers of other units may come first
+	if(!TVPAtExitHandlers)
+		TVPAtExitHandlers = new std::vector<tTVPHeadlessAtExitHandler>();
+	tTVPHeadlessAtExitHandler h;
+	h.Priority = pri;
+	h.Handler = handler;
+	TVPAtExitHandlers->push_back(h);
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// temporary files
+//---------------------------------------------------------------------------
+static std::string TVPHeadlessTempDir;
+//---------------------------------------------------------------------------
+std::string TVPHeadlessTempPath(const char * name)
+{
+	// the directory is created in $TMPDIR (or /tmp) at the first call
+	if(TVPHeadlessTempDir.empty())
+	{
+		const char * tmp = getenv("TMPDIR");
+		std::string templ(tmp && *tmp ? tmp : "/tmp");
+		templ += "/tvpheadless.XXXXXX";
+		std::vector<char> buf(templ.begin(), templ.end());
+		buf.push_back(0);
+		if(!mkdtemp(&buf[0]))
+			TVPThrowExceptionMessage(TJS_W("cannot create a temporary directory"));
+		TVPHeadlessTempDir = &buf[0];
+	}
+	return TVPHeadlessTempDir + "/" + name;
+}
+//---------------------------------------------------------------------------
+static void TVPRemoveHeadlessTempDir()
+{
+	// the files left by a failed test or benchmark are removed too
+	if(TVPHeadlessTempDir.empty()) return;
+	DIR * dir = opendir(TVPHeadlessTempDir.c_str());
+	if(dir)
+	{
+		while(struct dirent * entry = readdir(dir))
+		{
+			if(!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+				continue;
+			remove((TVPHeadlessTempDir + "/" + entry->d_name).c_str());
+		}
+		closedir(dir);
+	}
+	rmdir(TVPHeadlessTempDir.c_str());
+	TVPHeadlessTempDir.clear();
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// TVPInitHeadlessHost / TVPUninitHeadlessHost
+//---------------------------------------------------------------------------
+extern void TVPGL_C_Init();
+//---------------------------------------------------------------------------
+void TVPInitHeadlessHost()
+{
+	TVPDetectCPU();
+	TVPInitTVPGL();
+	TVPGL_C_Init();
+	TJSCreateBinaryStreamForRead = TVPHeadlessCreateBinaryStreamForRead;
+	TJSCreateBinaryStreamForWrite = TVPHeadlessCreateBinaryStreamForWrite;
+	TJSRenameStorage = TVPRenameStorage;
+	TJSGetParallelTaskNum = TVPGetThreadNum;
+	TJSExecParallelTasks = TVPTryExecThreadTasks;
+}
+//---------------------------------------------------------------------------
+void TVPUninitHeadlessHost()
+{
+	if(TVPScriptEngine)
+	{
+		TVPScriptEngine->Shutdown();
+		TVPScriptEngine->Release();
+		TVPScriptEngine = NULL;
+	}
+	if(TVPAtExitHandlers)
+	{
+		std::stable_sort(TVPAtExitHandlers->begin(), TVPAtExitHandlers->end());
+		for(tjs_uint i = 0; i < TVPAtExitHandlers->size(); i++)
+			(*TVPAtExitHandlers)[i].Handler();
+		delete TVPAtExitHandlers;
+		TVPAtExitHandlers = NULL;
+	}
+	TVPUninitTVPGL();
+	TVPRemoveHeadlessTempDir();
+}
+//---------------------------------------------------------------------------
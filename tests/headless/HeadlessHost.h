@@ -0,0 +1,28 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Host services for the headless build
+//---------------------------------------------------------------------------
+#ifndef HeadlessHostH
+#define HeadlessHostH
+
+#include <string>
+
+//---------------------------------------------------------------------------
+extern bool TVPHeadlessLogQuiet; // suppresses TVPAddLog (not important logs)
+extern void TVPInitHeadlessHost();
+	// detects the CPU, initializes tvpgl and sets the TJS2 binary stream
+	// functions
+extern void TVPUninitHeadlessHost();
+	// shuts down the script engine, calls the at-exit handlers and removes
+	// the temporary directory
+extern std::string TVPHeadlessTempPath(const char * name);
+	// a path for a temporary file, in a directory of this process
+//---------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,188 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Base Layer Bitmap implementation (headless; memory bitmaps only)
+//---------------------------------------------------------------------------
+/*
+	Only the bitmap storage of tTVPNativeBaseBitmap is implemented; enough for
+	the image loaders and savers. There is no font or text drawing.
+*/
+#include "tjsCommHead.h"
+
+#include <stdlib.h>
+#include "LayerBitmapIntf.h"
+#include "GraphicsLoaderIntf.h"
+#include "tjsUtils.h"
+#include "MsgIntf.h"
+
+
+//---------------------------------------------------------------------------
+// tTVPBitmap : internal bitmap object
+//---------------------------------------------------------------------------
+tTVPBitmap::tTVPBitmap(tjs_uint width, tjs_uint height, tjs_uint bpp)
+{
+	RefCount = 1;
+	Allocate(width, height, bpp);
+}
+//---------------------------------------------------------------------------
+tTVPBitmap::tTVPBitmap(const tTVPBitmap & r)
+{
+	RefCount = 1;
+	Allocate(r.GetWidth(), r.GetHeight(), r.GetBPP());
+	memcpy(Bits, r.Bits, r.BitmapInfo->GetImageSize());
+	if(r.Palette)
+	{
+		memcpy(Palette, r.Palette, sizeof(tjs_uint)*DEFAULT_PALETTE_COUNT);
+		ActualPalCount = r.ActualPalCount;
+	}
+}
+//---------------------------------------------------------------------------
+tTVPBitmap::~tTVPBitmap()
+{
+	TJSAlignedDealloc(Bits);
+	delete BitmapInfo;
+	if(Palette) delete [] Palette;
+}
+//---------------------------------------------------------------------------
+void tTVPBitmap::Allocate(tjs_uint width, tjs_uint height, tjs_uint bpp)
+{
+	BitmapInfo = new BitmapInfomation(width, height, bpp);
+
+	Width = width;
+	Height = height;
+	PitchBytes = BitmapInfo->GetPitchBytes();
+	PitchStep = -PitchBytes; // bottom-up, as DIBs
+
+	Bits = TJSAlignedAlloc(BitmapInfo->GetImageSize(), 4);
+	memset(Bits, 0, BitmapInfo->GetImageSize());
+	if(bpp == 8)
+		Palette = new tjs_uint[DEFAULT_PALETTE_COUNT];
+	else
+		Palette = NULL;
+	ActualPalCount = 0;
+}
+//---------------------------------------------------------------------------
+void * tTVPBitmap::GetScanLine(tjs_uint l) const
+{
+	if((tjs_int)l>=BitmapInfo->GetHeight() )
+	{
+		TVPThrowExceptionMessage(TVPScanLineRangeOver, ttstr((tjs_int)l),
+			ttstr((tjs_int)BitmapInfo->GetHeight()-1));
+	}
+
+	return (BitmapInfo->GetHeight() - l -1 ) * PitchBytes + (tjs_uint8*)Bits;
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+// tTVPNativeBaseBitmap
+//---------------------------------------------------------------------------
+tTVPNativeBaseBitmap::tTVPNativeBaseBitmap(tjs_uint w, tjs_uint h, tjs_uint bpp)
+{
+	PrerenderedFont = NULL;
+	FontChanged = true;
+	GlobalFontState = -1;
+	TextWidth = TextHeight = 0;
+	Bitmap = new tTVPBitmap(w, h, bpp);
+}
+//---------------------------------------------------------------------------
+tTVPNativeBaseBitmap::tTVPNativeBaseBitmap(const tTVPNativeBaseBitmap & r)
+{
+	Bitmap = r.Bitmap;
+	Bitmap->AddRef();
+
+	PrerenderedFont = NULL;
+	FontChanged = true;
+	GlobalFontState = -1;
+	TextWidth = TextHeight = 0;
+}
+//---------------------------------------------------------------------------
+tTVPNativeBaseBitmap::~tTVPNativeBaseBitmap()
+{
+	Bitmap->Release();
+}
+//---------------------------------------------------------------------------
+tjs_uint tTVPNativeBaseBitmap::GetWidth() const
+{
+	return Bitmap->GetWidth();
+}
+//---------------------------------------------------------------------------
+tjs_uint tTVPNativeBaseBitmap::GetHeight() const
+{
+	return Bitmap->GetHeight();
+}
+//---------------------------------------------------------------------------
+tjs_uint tTVPNativeBaseBitmap::GetBPP() const
+{
+	return Bitmap->GetBPP();
+}
+//---------------------------------------------------------------------------
+bool tTVPNativeBaseBitmap::Is32BPP() const
+{
+	return Bitmap->Is32bit();
+}
+//---------------------------------------------------------------------------
+bool tTVPNativeBaseBitmap::Is8BPP() const
+{
+	return Bitmap->Is8bit();
+}
+//---------------------------------------------------------------------------
+const void * tTVPNativeBaseBitmap::GetScanLine(tjs_uint l) const
+{
+	return Bitmap->GetScanLine(l);
+}
+//---------------------------------------------------------------------------
+void * tTVPNativeBaseBitmap::GetScanLineForWrite(tjs_uint l)
+{
+	Independ();
+	return Bitmap->GetScanLine(l);
+}
+//---------------------------------------------------------------------------
+tjs_int tTVPNativeBaseBitmap::GetPitchBytes() const
+{
+	return Bitmap->GetPitch();
+}
+//---------------------------------------------------------------------------
+void tTVPNativeBaseBitmap::Independ()
+{
+	if(Bitmap->IsIndependent()) return;
+	tTVPBitmap *newb = new tTVPBitmap(*Bitmap);
+	Bitmap->Release();
+	Bitmap = newb;
+}
+//---------------------------------------------------------------------------
+bool tTVPNativeBaseBitmap::AssignBitmap(const tTVPNativeBaseBitmap &rhs)
+{
+	if(this == &rhs || Bitmap == rhs.Bitmap) return false;
+	Bitmap->Release();
+	Bitmap = rhs.Bitmap;
+	Bitmap->AddRef();
+	return true;
+}
+//---------------------------------------------------------------------------
+void tTVPNativeBaseBitmap::Recreate(tjs_uint w, tjs_uint h, tjs_uint bpp)
+{
+	Bitmap->Release();
+	Bitmap = new tTVPBitmap(w, h, bpp);
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+// tTVPBaseBitmap
+//---------------------------------------------------------------------------
+tTVPBaseBitmap::tTVPBaseBitmap(tjs_uint w, tjs_uint h, tjs_uint bpp) :
+		tTVPNativeBaseBitmap(w, h, bpp)
+{
+}
+//---------------------------------------------------------------------------
+tTVPBaseBitmap::~tTVPBaseBitmap()
+{
+}
+//---------------------------------------------------------------------------
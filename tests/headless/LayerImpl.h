@@ -0,0 +1,20 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Layer Management (headless)
+//---------------------------------------------------------------------------
+/*
+	The headless build has no Layer class; this only lets the units which
+	use the color key constants of LayerIntf.h be compiled.
+*/
+#ifndef LayerImplH
+#define LayerImplH
+
+#include "LayerIntf.h"
+
+#endif
@@ -0,0 +1,30 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Sound Buffer Base implementation (headless; no sound device)
+//---------------------------------------------------------------------------
+
+#ifndef SoundBufferBaseImplH
+#define SoundBufferBaseImplH
+
+#define TVP_SB_BEAT_INTERVAL 60
+
+#include "SoundBufferBaseIntf.h"
+
+
+//---------------------------------------------------------------------------
+class tTJSNI_SoundBuffer : public tTJSNI_BaseSoundBuffer
+{
+	typedef tTJSNI_BaseSoundBuffer inherited;
+
+public:
+	tTJSNI_SoundBuffer() {;}
+	// no timer beats in the headless build; fading is not processed.
+};
+//---------------------------------------------------------------------------
+#endif
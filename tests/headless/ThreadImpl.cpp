@@ -0,0 +1,269 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Thread base class (headless implementation, on the C++11 thread library)
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "ThreadIntf.h"
+#include "ThreadImpl.h"
+#include "MsgIntf.h"
+#include "SysInitIntf.h"
+
+
+
+//---------------------------------------------------------------------------
+// tTVPThread : a wrapper class for thread
+//---------------------------------------------------------------------------
+tTVPThread::tTVPThread(bool suspended)
+{
+	Terminated = false;
+	Priority = ttpNormal;
+	Started = false;
+	if(!suspended) Resume();
+}
+//---------------------------------------------------------------------------
+tTVPThread::~tTVPThread()
+{
+	if(Thread.joinable()) Thread.detach();
+}
+//---------------------------------------------------------------------------
+void tTVPThread::StartProc(tTVPThread * thread)
+{
+	thread->Execute();
+}
+//---------------------------------------------------------------------------
+void tTVPThread::WaitFor()
+{
+	if(Thread.joinable()) Thread.join();
+}
+//---------------------------------------------------------------------------
+tTVPThreadPriority tTVPThread::GetPriority()
+{
+	return Priority;
+}
+//---------------------------------------------------------------------------
+void tTVPThread::SetPriority(tTVPThreadPriority pri)
+{
+	Priority = pri;
+}
+//---------------------------------------------------------------------------
+void tTVPThread::Suspend()
+{
+}
+//---------------------------------------------------------------------------
+void tTVPThread::Resume()
+{
+	if(Started) return;
+	Started = true;
+	Thread = std::thread(StartProc, this);
+}
+//---------------------------------------------------------------------------
+
+
+
+
+
+
+
+//---------------------------------------------------------------------------
+// tTVPThreadEvent
+//---------------------------------------------------------------------------
+tTVPThreadEvent::tTVPThreadEvent(bool manualreset)
+{
+	ManualReset = manualreset;
+	State = false;
+}
+//---------------------------------------------------------------------------
+tTVPThreadEvent::~tTVPThreadEvent()
+{
+}
+//---------------------------------------------------------------------------
+void tTVPThreadEvent::Set()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	State = true;
+	if(ManualReset) Cond.notify_all(); else Cond.notify_one();
+}
+//---------------------------------------------------------------------------
+void tTVPThreadEvent::Reset()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	State = false;
+}
+//---------------------------------------------------------------------------
+bool tTVPThreadEvent::WaitFor(tjs_uint timeout)
+{
+	// wait for event;
+	// returns true if the event is set, otherwise (when timed out) returns false.
+
+	std::unique_lock<std::mutex> lock(Mutex);
+	if(timeout == 0)
+		Cond.wait(lock, [this]{ return State; });
+	else if(!Cond.wait_for(lock, std::chrono::milliseconds(timeout),
+			[this]{ return State; }))
+		return false;
+	if(!ManualReset) State = false;
+	return true;
+}
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+// thread pool for TVPBeginThreadTask .. TVPEndThreadTask
+//---------------------------------------------------------------------------
+tjs_int TVPDrawThreadNum = 1;
+
+struct tTVPPoolThread
+{
+	std::thread Thread;
+	TVP_THREAD_TASK_FUNC Func;
+	TVP_THREAD_PARAM Param;
+	bool HasTask;
+	bool Exit;
+};
+static std::vector<tTVPPoolThread*> TVPThreadList;
+static std::mutex TVPThreadPoolMutex;
+static std::condition_variable TVPThreadPoolTaskCond; // a task is given
+static std::condition_variable TVPThreadPoolDoneCond; // a task has finished
+static tjs_int TVPRunningThreadCount = 0;
+static tjs_int TVPThreadTaskNum, TVPThreadTaskCount;
+
+//---------------------------------------------------------------------------
+// the pool is owned by one thread from TVPBeginThreadTask to TVPEndThreadTask,
+// as the win32 implementation.
+static std::recursive_mutex TVPThreadTaskLock;
+static bool TVPThreadTaskBusy = false;
+
+//---------------------------------------------------------------------------
+tjs_int TVPGetProcessorNum(void)
+{
+	static tjs_int processor_num = 0;
+	if(!processor_num)
+	{
+		processor_num = (tjs_int)std::thread::hardware_concurrency();
+		if(!processor_num) processor_num = 1;
+	}
+	return processor_num;
+}
+//---------------------------------------------------------------------------
+tjs_int TVPGetThreadNum(void)
+{
+	tjs_int threadNum = TVPDrawThreadNum ? TVPDrawThreadNum : TVPGetProcessorNum();
+	threadNum = std::min(threadNum, TVPMaxThreadNum);
+	return threadNum;
+}
+//---------------------------------------------------------------------------
+static void TVPThreadLoop(tTVPPoolThread * info)
+{
+	std::unique_lock<std::mutex> lock(TVPThreadPoolMutex);
+	for(;;)
+	{
+		TVPThreadPoolTaskCond.wait(lock, [info]{ return info->HasTask || info->Exit; });
+		if(info->Exit) break;
+		lock.unlock();
+		info->Func(info->Param);
+		lock.lock();
+		info->HasTask = false;
+		TVPRunningThreadCount--;
+		TVPThreadPoolDoneCond.notify_all();
+	}
+}
+//---------------------------------------------------------------------------
+static void TVPShrinkThreadPool(tjs_int count)
+{
+	while(static_cast<tjs_int>(TVPThreadList.size()) > count)
+	{
+		tTVPPoolThread * info = TVPThreadList.back();
+		{
+			std::lock_guard<std::mutex> lock(TVPThreadPoolMutex);
+			info->Exit = true;
+			TVPThreadPoolTaskCond.notify_all();
+		}
+		info->Thread.join();
+		delete info;
+		TVPThreadList.pop_back();
+	}
+}
+//---------------------------------------------------------------------------
+static void TVPUninitThreadPool()
+{
+	// the threads must end before the static condition variables are
+	// destroyed; destroying them with waiters blocks
+	TVPShrinkThreadPool(0);
+}
+static tTVPAtExit
+	TVPUninitThreadPoolAtExit(TVP_ATEXIT_PRI_CLEANUP, TVPUninitThreadPool);
+//---------------------------------------------------------------------------
+static void TVPInternalBeginThreadTask(tjs_int taskNum)
+{
+	TVPThreadTaskNum = taskNum;
+	TVPThreadTaskCount = 0;
+	tjs_int extraThreadNum = TVPGetThreadNum() - 1;
+	while(static_cast<tjs_int>(TVPThreadList.size()) < extraThreadNum)
+	{
+		tTVPPoolThread * info = new tTVPPoolThread();
+		info->HasTask = false;
+		info->Exit = false;
+		info->Thread = std::thread(TVPThreadLoop, info);
+		TVPThreadList.push_back(info);
+	}
+	TVPShrinkThreadPool(extraThreadNum);
+}
+//---------------------------------------------------------------------------
+void TVPBeginThreadTask(tjs_int taskNum)
+{
+	TVPThreadTaskLock.lock();
+	TVPThreadTaskBusy = true;
+	TVPInternalBeginThreadTask(taskNum);
+}
+//---------------------------------------------------------------------------
+bool TVPTryBeginThreadTask(tjs_int taskNum)
+{
+	if(!TVPThreadTaskLock.try_lock())
+		return false;
+	if(TVPThreadTaskBusy)
+	{
+		TVPThreadTaskLock.unlock();
+		return false;
+	}
+	TVPThreadTaskBusy = true;
+	TVPInternalBeginThreadTask(taskNum);
+	return true;
+}
+//---------------------------------------------------------------------------
+void TVPExecThreadTask(TVP_THREAD_TASK_FUNC func, TVP_THREAD_PARAM param)
+{
+	if(TVPThreadTaskCount >= TVPThreadTaskNum - 1 ||
+		TVPThreadTaskCount >= (tjs_int)TVPThreadList.size())
+	{
+		func(param);
+		return;
+	}
+	tTVPPoolThread * info = TVPThreadList[TVPThreadTaskCount++];
+	std::lock_guard<std::mutex> lock(TVPThreadPoolMutex);
+	info->Func = func;
+	info->Param = param;
+	info->HasTask = true;
+	TVPRunningThreadCount++;
+	TVPThreadPoolTaskCond.notify_all();
+}
+//---------------------------------------------------------------------------
+void TVPEndThreadTask(void)
+{
+	{
+		std::unique_lock<std::mutex> lock(TVPThreadPoolMutex);
+		TVPThreadPoolDoneCond.wait(lock, []{ return TVPRunningThreadCount == 0; });
+	}
+	TVPThreadTaskBusy = false;
+	TVPThreadTaskLock.unlock();
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,80 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Thread base class (headless implementation, on the C++11 thread library)
+//---------------------------------------------------------------------------
+#ifndef ThreadImplH
+#define ThreadImplH
+#include "tjsNative.h"
+#include "ThreadIntf.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+//---------------------------------------------------------------------------
+// tTVPThread
+//---------------------------------------------------------------------------
+class tTVPThread
+{
+	volatile bool Terminated;
+	std::thread Thread;
+	tTVPThreadPriority Priority; // only remembered; the headless build has no priorities
+	bool Started;
+
+	static void StartProc(tTVPThread * thread);
+
+public:
+	tTVPThread(bool suspended);
+	virtual ~tTVPThread();
+
+	bool GetTerminated() const { return Terminated; }
+	void SetTerminated(bool s) { Terminated = s; }
+	void Terminate() { Terminated = true; }
+
+protected:
+	virtual void Execute() = 0;
+
+public:
+	void WaitFor();
+
+	tTVPThreadPriority GetPriority();
+	void SetPriority(tTVPThreadPriority pri);
+
+	void Suspend(); // not supported; threads can be only created suspended
+	void Resume();
+};
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// tTVPThreadEvent
+//---------------------------------------------------------------------------
+class tTVPThreadEvent
+{
+	std::mutex Mutex;
+	std::condition_variable Cond;
+	bool ManualReset;
+	bool State;
+
+public:
+	tTVPThreadEvent(bool manualreset = false);
+	virtual ~tTVPThreadEvent();
+
+	void Set();
+	void Reset();
+	bool WaitFor(tjs_uint timeout);
+};
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+#endif
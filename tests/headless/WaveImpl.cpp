@@ -0,0 +1,124 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Wave Player implementation (headless; no sound device)
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include "WaveImpl.h"
+#include "WaveLoopManager.h"
+#include "StorageIntf.h"
+#include "UtilStreams.h"
+#include "MsgIntf.h"
+
+
+//---------------------------------------------------------------------------
+// tTJSNI_WaveSoundBuffer
+//---------------------------------------------------------------------------
+tjs_int tTJSNI_WaveSoundBuffer::GlobalVolume = 100000;
+tTVPSoundGlobalFocusMode tTJSNI_WaveSoundBuffer::GlobalFocusMode = sgfmNeverMute;
+//---------------------------------------------------------------------------
+tTJSNI_WaveSoundBuffer::tTJSNI_WaveSoundBuffer()
+{
+	Decoder = NULL;
+	memset(&InputFormat, 0, sizeof(InputFormat));
+	Paused = false;
+	Looping = false;
+	Volume = Volume2 = 100000;
+	Pan = 0;
+	Frequency = 0;
+	PosX = PosY = PosZ = 0;
+}
+//---------------------------------------------------------------------------
+tjs_error TJS_INTF_METHOD tTJSNI_WaveSoundBuffer::Construct(tjs_int numparams,
+	tTJSVariant **param, iTJSDispatch2 *tjs_obj)
+{
+	return inherited::Construct(numparams, param, tjs_obj);
+}
+//---------------------------------------------------------------------------
+void TJS_INTF_METHOD tTJSNI_WaveSoundBuffer::Invalidate()
+{
+	Clear();
+	inherited::Invalidate();
+}
+//---------------------------------------------------------------------------
+void tTJSNI_WaveSoundBuffer::Clear()
+{
+	ClearFilterChain();
+	if(LoopManager) delete LoopManager, LoopManager = NULL;
+	if(Decoder) delete Decoder, Decoder = NULL;
+	memset(&InputFormat, 0, sizeof(InputFormat));
+	SetStatus(ssUnload);
+}
+//---------------------------------------------------------------------------
+void tTJSNI_WaveSoundBuffer::Open(const ttstr & storagename)
+{
+	Clear();
+
+	Decoder = TVPCreateWaveDecoder(storagename);
+	try
+	{
+		LoopManager = new tTVPWaveLoopManager();
+		LoopManager->SetDecoder(Decoder);
+		LoopManager->SetLooping(Looping);
+		RebuildFilterChain();
+		InputFormat = FilterOutput->GetFormat();
+		Frequency = InputFormat.SamplesPerSec;
+
+		ttstr sliname = storagename + TJS_W(".sli");
+		if(TVPIsExistentStorage(sliname))
+		{
+			tTVPStreamHolder slistream(sliname);
+			tjs_uint size = static_cast<tjs_uint>(slistream->GetSize());
+			std::vector<char> buffer(size + 1);
+			slistream->ReadBuffer(&buffer[0], size);
+			buffer[size] = 0;
+			if(!LoopManager->ReadInformation(&buffer[0]))
+				TVPThrowExceptionMessage(TVPInvalidLoopInformation, sliname);
+			RecreateWaveLabelsObject();
+		}
+	}
+	catch(...)
+	{
+		Clear();
+		throw;
+	}
+
+	SetStatus(ssStop);
+}
+//---------------------------------------------------------------------------
+void tTJSNI_WaveSoundBuffer::Play()
+{
+	if(!Decoder) return;
+	SetStatus(ssPlay);
+}
+//---------------------------------------------------------------------------
+void tTJSNI_WaveSoundBuffer::Stop()
+{
+	if(!Decoder) return;
+	SetStatus(ssStop);
+}
+//---------------------------------------------------------------------------
+void tTJSNI_WaveSoundBuffer::SetLooping(bool b)
+{
+	Looping = b;
+	if(LoopManager) LoopManager->SetLooping(b);
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// tTJSNC_WaveSoundBuffer::CreateNativeInstance
+//---------------------------------------------------------------------------
+tTJSNativeInstance *tTJSNC_WaveSoundBuffer::CreateNativeInstance()
+{
+	return new tTJSNI_WaveSoundBuffer();
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,96 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Wave Player implementation (headless; no sound device)
+//---------------------------------------------------------------------------
+/*
+	The headless WaveSoundBuffer opens the storage and builds the decoder,
+	the loop manager and the filter chain as the win32 implementation does,
+	but has no device to play on; play and stop only change the status.
+*/
+#ifndef WaveImplH
+#define WaveImplH
+
+#include "WaveIntf.h"
+
+typedef float D3DVALUE;
+
+//---------------------------------------------------------------------------
+// tTJSNI_WaveSoundBuffer : Wave Native Instance
+//---------------------------------------------------------------------------
+class tTVPWaveLoopManager;
+class tTJSNI_WaveSoundBuffer : public tTJSNI_BaseWaveSoundBuffer
+{
+	typedef tTJSNI_BaseWaveSoundBuffer inherited;
+
+public:
+	tTJSNI_WaveSoundBuffer();
+	tjs_error TJS_INTF_METHOD Construct(tjs_int numparams, tTJSVariant **param,
+		iTJSDispatch2 *tjs_obj);
+	void TJS_INTF_METHOD Invalidate();
+
+private:
+	tTVPWaveDecoder * Decoder;
+	tTVPWaveFormat InputFormat;
+	bool Paused;
+	bool Looping;
+	tjs_int Volume;
+	tjs_int Volume2;
+	tjs_int Pan;
+	tjs_int Frequency;
+	D3DVALUE PosX, PosY, PosZ;
+	static tjs_int GlobalVolume;
+	static tTVPSoundGlobalFocusMode GlobalFocusMode;
+
+	void Clear();
+
+public:
+	void Open(const ttstr & storagename);
+	void Play();
+	void Stop();
+
+	bool GetPaused() const { return Paused; }
+	void SetPaused(bool b) { Paused = b; }
+
+	tjs_int GetBitsPerSample() const { return InputFormat.BitsPerSample; }
+	tjs_int GetChannels() const { return InputFormat.Channels; }
+
+	void SetLooping(bool b);
+	bool GetLooping() const { return Looping; }
+
+	tjs_uint64 GetSamplePosition() { return 0; }
+	void SetSamplePosition(tjs_uint64 pos) {;}
+	tjs_uint64 GetPosition() { return 0; }
+	void SetPosition(tjs_uint64 pos) {;}
+	tjs_uint64 GetTotalTime() { return InputFormat.TotalTime; }
+
+	void SetVolume(tjs_int v) { Volume = v; }
+	tjs_int GetVolume() const { return Volume; }
+	void SetVolume2(tjs_int v) { Volume2 = v; }
+	tjs_int GetVolume2() const { return Volume2; }
+	void SetPan(tjs_int v) { Pan = v; }
+	tjs_int GetPan() const { return Pan; }
+	static void SetGlobalVolume(tjs_int v) { GlobalVolume = v; }
+	static tjs_int GetGlobalVolume() { return GlobalVolume; }
+	static void SetGlobalFocusMode(tTVPSoundGlobalFocusMode b) { GlobalFocusMode = b; }
+	static tTVPSoundGlobalFocusMode GetGlobalFocusMode() { return GlobalFocusMode; }
+
+	void SetPos(D3DVALUE x, D3DVALUE y, D3DVALUE z) { PosX = x; PosY = y; PosZ = z; }
+	void SetPosX(D3DVALUE v) { PosX = v; }
+	D3DVALUE GetPosX() const {return PosX;}
+	void SetPosY(D3DVALUE v) { PosY = v; }
+	D3DVALUE GetPosY() const {return PosY;}
+	void SetPosZ(D3DVALUE v) { PosZ = v; }
+	D3DVALUE GetPosZ() const {return PosZ;}
+
+	tjs_int GetFrequency() const { return Frequency; }
+	void SetFrequency(tjs_int freq) { Frequency = freq; }
+};
+//---------------------------------------------------------------------------
+
+#endif
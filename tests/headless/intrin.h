@@ -0,0 +1,20 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// <intrin.h> of MSVC (headless)
+//---------------------------------------------------------------------------
+/*
+	simd_def_x86x64.h includes the MSVC umbrella intrinsics header; gcc and
+	clang have the same in <x86intrin.h>.
+*/
+#ifndef __TVP_HEADLESS_INTRIN_H__
+#define __TVP_HEADLESS_INTRIN_H__
+
+#include <x86intrin.h>
+
+#endif
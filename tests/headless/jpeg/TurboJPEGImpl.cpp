@@ -0,0 +1,232 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// TurboJPEG API for the headless build (on the libjpeg API)
+//---------------------------------------------------------------------------
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C"
+{
+#include <jpeglib.h>
+}
+#include "turbojpeg.h"
+
+
+//---------------------------------------------------------------------------
+struct tTVPTJDecompressor
+{
+	jpeg_decompress_struct Info;
+	jpeg_error_mgr Error;
+	jmp_buf Jump;
+	JSAMPROW *Rows; // freed when an error jumps out of tjDecompress2
+};
+//---------------------------------------------------------------------------
+static void TVPTJErrorExit(j_common_ptr cinfo)
+{
+	// errors of libjpeg return -1 from the API call which is running
+	tTVPTJDecompressor *tj = (tTVPTJDecompressor *)cinfo->client_data;
+	longjmp(tj->Jump, 1);
+}
+//---------------------------------------------------------------------------
+static void TVPTJOutputMessage(j_common_ptr cinfo)
+{
+}
+//---------------------------------------------------------------------------
+static tjscalingfactor TVPTJScalingFactors[] =
+{
+	// in the order of libjpeg-turbo; tjDecompress2 uses the first one
+	// which fits
+	{ 2, 1 }, { 15, 8 }, { 7, 4 }, { 13, 8 }, { 3, 2 }, { 11, 8 },
+	{ 5, 4 }, { 9, 8 }, { 1, 1 }, { 7, 8 }, { 3, 4 }, { 5, 8 },
+	{ 1, 2 }, { 3, 8 }, { 1, 4 }, { 1, 8 }
+};
+static const int TVPTJNumScalingFactors =
+	sizeof(TVPTJScalingFactors) / sizeof(TVPTJScalingFactors[0]);
+//---------------------------------------------------------------------------
+static const J_COLOR_SPACE TVPTJColorSpaces[] =
+{
+	JCS_RGB, JCS_EXT_BGR, JCS_EXT_RGBX, JCS_EXT_BGRX, JCS_EXT_XBGR,
+	JCS_EXT_XRGB, JCS_GRAYSCALE, JCS_EXT_RGBA, JCS_EXT_BGRA, JCS_EXT_ABGR,
+	JCS_EXT_ARGB
+};
+static const int TVPTJPixelSizes[] = { 3, 3, 4, 4, 4, 4, 1, 4, 4, 4, 4 };
+static const int TVPTJNumPixelFormats =
+	sizeof(TVPTJPixelSizes) / sizeof(TVPTJPixelSizes[0]);
+//---------------------------------------------------------------------------
+// the API functions set the jump target and call the functions below, so
+// that no local variable is changed after setjmp
+//---------------------------------------------------------------------------
+static bool TVPTJCreate(tTVPTJDecompressor *tj)
+{
+	if(setjmp(tj->Jump)) return false;
+	jpeg_create_decompress(&tj->Info);
+	return true;
+}
+//---------------------------------------------------------------------------
+extern "C" tjhandle tjInitDecompress(void)
+{
+	tTVPTJDecompressor *tj =
+		(tTVPTJDecompressor *)calloc(1, sizeof(tTVPTJDecompressor));
+	if(!tj) return NULL;
+	tj->Info.err = jpeg_std_error(&tj->Error);
+	tj->Error.error_exit = TVPTJErrorExit;
+	tj->Error.output_message = TVPTJOutputMessage;
+	tj->Info.client_data = tj;
+	if(!TVPTJCreate(tj))
+	{
+		free(tj);
+		return NULL;
+	}
+	return tj;
+}
+//---------------------------------------------------------------------------
+extern "C" int tjDecompressHeader2(tjhandle handle, unsigned char *jpegBuf,
+	unsigned long jpegSize, int *width, int *height, int *jpegSubsamp)
+{
+	tTVPTJDecompressor *tj = (tTVPTJDecompressor *)handle;
+	if(!tj || !jpegBuf || !jpegSize || !width || !height || !jpegSubsamp)
+		return -1;
+	if(setjmp(tj->Jump))
+	{
+		jpeg_abort_decompress(&tj->Info);
+		return -1;
+	}
+	jpeg_abort_decompress(&tj->Info);
+	jpeg_mem_src(&tj->Info, jpegBuf, jpegSize);
+	jpeg_read_header(&tj->Info, TRUE);
+
+	*width = tj->Info.image_width;
+	*height = tj->Info.image_height;
+	*jpegSubsamp = -1;
+	if(tj->Info.num_components == 1)
+	{
+		*jpegSubsamp = TJSAMP_GRAY;
+	}
+	else if(tj->Info.num_components == 3)
+	{
+		int h = tj->Info.comp_info[0].h_samp_factor;
+		int v = tj->Info.comp_info[0].v_samp_factor;
+		if(h == 1 && v == 1) *jpegSubsamp = TJSAMP_444;
+		else if(h == 2 && v == 1) *jpegSubsamp = TJSAMP_422;
+		else if(h == 2 && v == 2) *jpegSubsamp = TJSAMP_420;
+		else if(h == 1 && v == 2) *jpegSubsamp = TJSAMP_440;
+		else if(h == 4 && v == 1) *jpegSubsamp = TJSAMP_411;
+	}
+	jpeg_abort_decompress(&tj->Info);
+	return *jpegSubsamp < 0 ? -1 : 0;
+}
+//---------------------------------------------------------------------------
+static int TVPTJDecompress(tTVPTJDecompressor *tj, const unsigned char *jpegBuf,
+	unsigned long jpegSize, unsigned char *dstBuf, int width, int pitch,
+	int height, int pixelFormat, int flags)
+{
+	// nothing which needs a destructor may live in this frame; libjpeg
+	// errors longjmp out of it
+	jpeg_abort_decompress(&tj->Info);
+	jpeg_mem_src(&tj->Info, (unsigned char *)jpegBuf, jpegSize);
+	jpeg_read_header(&tj->Info, TRUE);
+	tj->Info.out_color_space = TVPTJColorSpaces[pixelFormat];
+	if(flags & TJFLAG_FASTDCT) tj->Info.dct_method = JDCT_FASTEST;
+	if(flags & TJFLAG_FASTUPSAMPLE) tj->Info.do_fancy_upsampling = FALSE;
+
+	int jpegwidth = tj->Info.image_width;
+	int jpegheight = tj->Info.image_height;
+	if(width == 0) width = jpegwidth;
+	if(height == 0) height = jpegheight;
+	int i;
+	for(i = 0; i < TVPTJNumScalingFactors; i++)
+	{
+		if(TJSCALED(jpegwidth, TVPTJScalingFactors[i]) <= width &&
+			TJSCALED(jpegheight, TVPTJScalingFactors[i]) <= height)
+			break;
+	}
+	if(i == TVPTJNumScalingFactors)
+	{
+		jpeg_abort_decompress(&tj->Info);
+		return -1;
+	}
+	tj->Info.scale_num = TVPTJScalingFactors[i].num;
+	tj->Info.scale_denom = TVPTJScalingFactors[i].denom;
+
+	jpeg_start_decompress(&tj->Info);
+	if(pitch == 0) pitch = tj->Info.output_width * TVPTJPixelSizes[pixelFormat];
+	JSAMPROW *rows = (JSAMPROW *)malloc(sizeof(JSAMPROW) * tj->Info.output_height);
+	tj->Rows = rows;
+	if(!rows)
+	{
+		jpeg_abort_decompress(&tj->Info);
+		return -1;
+	}
+	for(JDIMENSION y = 0; y < tj->Info.output_height; y++)
+	{
+		JDIMENSION line = (flags & TJFLAG_BOTTOMUP) ?
+			tj->Info.output_height - y - 1 : y;
+		rows[y] = dstBuf + line * (size_t)pitch;
+	}
+	while(tj->Info.output_scanline < tj->Info.output_height)
+		jpeg_read_scanlines(&tj->Info, rows + tj->Info.output_scanline,
+			tj->Info.output_height - tj->Info.output_scanline);
+	jpeg_finish_decompress(&tj->Info);
+	free(rows);
+	tj->Rows = NULL;
+	return 0;
+}
+//---------------------------------------------------------------------------
+extern "C" int tjDecompress2(tjhandle handle, const unsigned char *jpegBuf,
+	unsigned long jpegSize, unsigned char *dstBuf, int width, int pitch,
+	int height, int pixelFormat, int flags)
+{
+	tTVPTJDecompressor *tj = (tTVPTJDecompressor *)handle;
+	if(!tj || !jpegBuf || !jpegSize || !dstBuf || width < 0 || pitch < 0 ||
+		height < 0 || pixelFormat < 0 || pixelFormat >= TVPTJNumPixelFormats)
+		return -1;
+	if(setjmp(tj->Jump))
+	{
+		free(tj->Rows);
+		tj->Rows = NULL;
+		jpeg_abort_decompress(&tj->Info);
+		return -1;
+	}
+	return TVPTJDecompress(tj, jpegBuf, jpegSize, dstBuf, width, pitch,
+		height, pixelFormat, flags);
+}
+//---------------------------------------------------------------------------
+extern "C" int tjDestroy(tjhandle handle)
+{
+	tTVPTJDecompressor *tj = (tTVPTJDecompressor *)handle;
+	if(!tj) return -1;
+	if(setjmp(tj->Jump))
+	{
+		free(tj);
+		return -1;
+	}
+	jpeg_destroy_decompress(&tj->Info);
+	free(tj);
+	return 0;
+}
+//---------------------------------------------------------------------------
+extern "C" tjscalingfactor *tjGetScalingFactors(int *numscalingfactors)
+{
+	if(!numscalingfactors) return NULL;
+	*numscalingfactors = TVPTJNumScalingFactors;
+	return TVPTJScalingFactors;
+}
+//---------------------------------------------------------------------------
+extern "C" unsigned char *tjAlloc(int bytes)
+{
+	return (unsigned char *)malloc(bytes);
+}
+//---------------------------------------------------------------------------
+extern "C" void tjFree(unsigned char *buffer)
+{
+	free(buffer);
+}
+//---------------------------------------------------------------------------
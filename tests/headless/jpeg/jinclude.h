@@ -0,0 +1,24 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// jinclude.h for the headless build
+//---------------------------------------------------------------------------
+/*
+	LoadJPEG.cpp includes this internal header of the libjpeg-turbo source
+	tree for the system headers jpeglib.h needs; an installed libjpeg does
+	not have it.
+*/
+#ifndef TVP_HEADLESS_JINCLUDE_H
+#define TVP_HEADLESS_JINCLUDE_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#endif
@@ -0,0 +1,84 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// TurboJPEG API for the headless build
+//---------------------------------------------------------------------------
+/*
+	The part of the TurboJPEG API LoadJPEG.cpp uses, implemented in
+	TurboJPEGImpl.cpp on the libjpeg API, for systems where libjpeg-turbo
+	is installed without the TurboJPEG library. The names and the values
+	are the ones of libjpeg-turbo 2.x; the decoding is done by the same
+	libjpeg calls as in tjDecompress2.
+*/
+#ifndef TVP_HEADLESS_TURBOJPEG_H
+#define TVP_HEADLESS_TURBOJPEG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//---------------------------------------------------------------------------
+typedef void * tjhandle;
+
+typedef struct
+{
+	int num;
+	int denom;
+} tjscalingfactor;
+
+#define TJSCALED(dimension, scalingFactor) \
+	(((dimension) * scalingFactor.num + scalingFactor.denom - 1) / \
+		scalingFactor.denom)
+
+enum TJSAMP
+{
+	TJSAMP_444 = 0,
+	TJSAMP_422,
+	TJSAMP_420,
+	TJSAMP_GRAY,
+	TJSAMP_440,
+	TJSAMP_411
+};
+
+enum TJPF
+{
+	TJPF_RGB = 0,
+	TJPF_BGR,
+	TJPF_RGBX,
+	TJPF_BGRX,
+	TJPF_XBGR,
+	TJPF_XRGB,
+	TJPF_GRAY,
+	TJPF_RGBA,
+	TJPF_BGRA,
+	TJPF_ABGR,
+	TJPF_ARGB
+};
+
+#define TJFLAG_BOTTOMUP 2
+#define TJFLAG_FASTUPSAMPLE 256
+#define TJFLAG_FASTDCT 2048
+#define TJFLAG_ACCURATEDCT 4096
+//---------------------------------------------------------------------------
+tjhandle tjInitDecompress(void);
+int tjDecompressHeader2(tjhandle handle, unsigned char *jpegBuf,
+	unsigned long jpegSize, int *width, int *height, int *jpegSubsamp);
+int tjDecompress2(tjhandle handle, const unsigned char *jpegBuf,
+	unsigned long jpegSize, unsigned char *dstBuf, int width, int pitch,
+	int height, int pixelFormat, int flags);
+int tjDestroy(tjhandle handle);
+tjscalingfactor *tjGetScalingFactors(int *numscalingfactors);
+unsigned char *tjAlloc(int bytes);
+void tjFree(unsigned char *buffer);
+//---------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
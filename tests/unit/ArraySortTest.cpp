@@ -0,0 +1,310 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Tests of the keyed sort of Array.sort against the comparator sort
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "TVPTest.h"
+#include "tjsArray.h"
+#include "ScriptMgnIntf.h"
+
+extern tjs_int TVPDrawThreadNum;
+
+
+//---------------------------------------------------------------------------
+struct tTVPTestSortCompare
+{
+	// the comparators which Array.sort uses when it can not sort by the keys
+	tjs_char Method;
+	tTVPTestSortCompare(tjs_char method) : Method(method) {}
+
+	bool operator () (const tTJSVariant &lhs, const tTJSVariant &rhs) const
+	{
+		switch(Method)
+		{
+		case TJS_W('+'):
+			return (lhs < rhs).operator bool();
+		case TJS_W('-'):
+			return (lhs > rhs).operator bool();
+		case TJS_W('0'):
+		case TJS_W('9'):
+		  {
+			tTJSVariant l(lhs), r(rhs);
+			if(l.Type() == tvtString && r.Type() == tvtString)
+				l.tonumber(), r.tonumber();
+			return (Method == TJS_W('0') ? l < r : l > r).operator bool();
+		  }
+		case TJS_W('a'):
+			if(lhs.Type() == tvtString && rhs.Type() == tvtString)
+				return (lhs < rhs).operator bool();
+			return (ttstr)lhs < (ttstr)rhs;
+		case TJS_W('z'):
+			if(lhs.Type() == tvtString && rhs.Type() == tvtString)
+				return (lhs > rhs).operator bool();
+			return (ttstr)lhs > (ttstr)rhs;
+		}
+		return false;
+	}
+};
+//---------------------------------------------------------------------------
+static void TVPTestArraySort(std::vector<tTJSVariant> &items, tjs_char method)
+{
+	// sorts the items by Array.sort(method, true)
+	TVPGetScriptEngine(); // registers the Array class
+	iTJSDispatch2 *array = TJSCreateArrayObject();
+	for(tjs_uint i = 0; i < items.size(); i++)
+		array->PropSetByNum(TJS_MEMBERENSURE, (tjs_int)i, &items[i], array);
+
+	tjs_char m[2] = { method, 0 };
+	tTJSVariant param0(m), param1((tjs_int)1);
+	tTJSVariant *params[] = { &param0, &param1 };
+	array->FuncCall(0, TJS_W("sort"), NULL, NULL, 2, params, array);
+
+	for(tjs_uint i = 0; i < items.size(); i++)
+		array->PropGetByNum(0, (tjs_int)i, &items[i], array);
+	array->Release();
+}
+//---------------------------------------------------------------------------
+static bool TVPTestSortMatches(const std::vector<tTJSVariant> &items,
+	tjs_char method)
+{
+	// the result must be the same as the stable sort by the comparator,
+	// including the types and the order of equal items
+	std::vector<tTJSVariant> expected(items), sorted(items);
+	std::stable_sort(expected.begin(), expected.end(),
+		tTVPTestSortCompare(method));
+	TVPTestArraySort(sorted, method);
+
+	for(tjs_uint i = 0; i < items.size(); i++)
+	{
+		if(sorted[i].Type() != expected[i].Type() ||
+			!sorted[i].DiscernCompareStrictReal(expected[i]))
+		{
+			fprintf(stderr, "method '%c', %u items: item %u is %s (type %d), "
+				"expected %s (type %d)\n",
+				(char)method, (unsigned)items.size(), i,
+				ttstr(sorted[i]).AsNarrowStdString().c_str(), (int)sorted[i].Type(),
+				ttstr(expected[i]).AsNarrowStdString().c_str(), (int)expected[i].Type());
+			return false;
+		}
+	}
+	return true;
+}
+//---------------------------------------------------------------------------
+static bool TVPTestSortMatchesAll(const std::vector<tTJSVariant> &items,
+	const tjs_char *methods)
+{
+	bool result = true;
+	for(; *methods; methods++)
+		if(!TVPTestSortMatches(items, *methods)) result = false;
+	return result;
+}
+//---------------------------------------------------------------------------
+static tjs_uint32 TVPTestRandom(tjs_uint32 &seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+//---------------------------------------------------------------------------
+static void TVPTestMakeNumbers(std::vector<tTJSVariant> &items,
+	tjs_uint count, tjs_uint32 seed)
+{
+	// integers and reals with many equal values, so that the order of the
+	// equal items shows whether the sort is stable
+	items.clear();
+	for(tjs_uint i = 0; i < count; i++)
+	{
+		tjs_int n = (tjs_int)(TVPTestRandom(seed) % 64) - 32;
+		switch(TVPTestRandom(seed) % 4)
+		{
+		case 0: items.push_back(tTJSVariant((tTVInteger)n)); break;
+		case 1: items.push_back(tTJSVariant((tjs_real)n)); break;
+		case 2: items.push_back(tTJSVariant((tjs_real)n + 0.5)); break;
+		case 3: items.push_back(tTJSVariant(n ? (tjs_real)n : -0.0)); break;
+		}
+	}
+}
+//---------------------------------------------------------------------------
+static void TVPTestMakeStrings(std::vector<tTJSVariant> &items,
+	tjs_uint count, tjs_uint32 seed)
+{
+	// strings sharing prefixes longer than the two characters in the key
+	static const tjs_char * const prefixes[] = {
+		TJS_W(""), TJS_W("a"), TJS_W("ab"),
+		TJS_W("abcdefghijklmnopqrstuvwxyz"),
+		TJS_W("abcdefghijklmnopqrstuvwxy"),
+		TJS_W("\x3042\x3044\x3046\x3048\x304a\x304b\x304d"),
+		TJS_W("\xd800\xdc00\xd800"),
+	};
+	const tjs_uint numprefixes = sizeof(prefixes) / sizeof(prefixes[0]);
+	items.clear();
+	for(tjs_uint i = 0; i < count; i++)
+	{
+		ttstr str(prefixes[TVPTestRandom(seed) % numprefixes]);
+		tjs_uint tail = TVPTestRandom(seed) % 4;
+		for(tjs_uint j = 0; j < tail; j++)
+			str += (tjs_char)(TJS_W('0') + TVPTestRandom(seed) % 3);
+		items.push_back(tTJSVariant(str));
+	}
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(sort_nan_falls_back_to_comparators)
+{
+	std::vector<tTJSVariant> items;
+	TVPTestMakeNumbers(items, 200, 1);
+	items[10] = tTJSVariant((tjs_real)NAN);
+	items[150] = tTJSVariant((tjs_real)NAN);
+	TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("+-09")));
+
+	// a NaN among integers only
+	items.clear();
+	for(tjs_int i = 0; i < 100; i++)
+		items.push_back(tTJSVariant((tTVInteger)((i * 37) % 50)));
+	items[50] = tTJSVariant((tjs_real)NAN);
+	TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("+-09")));
+
+	// numeric strings which convert to NaN are left to the comparators too
+	items.clear();
+	for(tjs_int i = 0; i < 100; i++)
+		items.push_back(tTJSVariant(ttstr((tjs_int)((i * 37) % 50))));
+	items[20] = tTJSVariant(TJS_W("NaN"));
+	items[70] = tTJSVariant(TJS_W("x"));
+	TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("+-09az")));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(sort_integers_beyond_2_53)
+{
+	const tTVInteger p53 = TJS_I64_VAL(0x20000000000000);
+	const tTVInteger values[] = {
+		p53 - 1, p53, p53 + 1, p53 + 2, -p53 - 1, -p53, -p53 + 1,
+		TJS_I64_VAL(0x7fffffffffffffff), -TJS_I64_VAL(0x7fffffffffffffff) - 1,
+		0, 1, -1,
+	};
+	const tjs_uint numvalues = sizeof(values) / sizeof(values[0]);
+
+	// all integers; both the short (std::sort) and the long (radix) paths
+	std::vector<tTJSVariant> items;
+	tjs_uint32 seed = 2;
+	for(tjs_uint count = 20; count <= 300; count += 280)
+	{
+		items.clear();
+		for(tjs_uint i = 0; i < count; i++)
+		{
+			tTVInteger n = values[TVPTestRandom(seed) % numvalues];
+			items.push_back(tTJSVariant(n + (tTVInteger)(TVPTestRandom(seed) % 3)));
+		}
+		TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("+-09az")));
+	}
+
+	// integers mixed with reals; those beyond 2^53 can not be reals
+	items.clear();
+	for(tjs_uint i = 0; i < 300; i++)
+	{
+		tTVInteger n = values[TVPTestRandom(seed) % numvalues];
+		if(TVPTestRandom(seed) % 2)
+			items.push_back(tTJSVariant(n));
+		else
+			items.push_back(tTJSVariant((tjs_real)n));
+	}
+	TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("+-09")));
+
+	// integers up to 2^53 mixed with reals are sorted by the keys
+	items.clear();
+	for(tjs_uint i = 0; i < 300; i++)
+	{
+		tTVInteger n = values[TVPTestRandom(seed) % 7] & ~(tTVInteger)1;
+		if(n > p53 || n < -p53) n = p53;
+		if(TVPTestRandom(seed) % 2)
+			items.push_back(tTJSVariant(n));
+		else
+			items.push_back(tTJSVariant((tjs_real)n));
+	}
+	TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("+-09")));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(sort_strings_with_long_prefixes)
+{
+	std::vector<tTJSVariant> items;
+	TVPTestMakeStrings(items, 500, 3);
+	TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("+-az")));
+
+	// void and numbers are sorted as their string forms by 'a' and 'z'
+	items[3] = tTJSVariant();
+	items[4] = tTJSVariant((tTVInteger)10);
+	items[5] = tTJSVariant((tjs_real)1.5);
+	items[6] = tTJSVariant(TJS_W("10"));
+	items[7] = tTJSVariant((tTVInteger)10);
+	TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("az")));
+
+	// numeric strings
+	items.clear();
+	tjs_uint32 seed = 3;
+	for(tjs_uint i = 0; i < 300; i++)
+	{
+		ttstr str((tjs_int)(TVPTestRandom(seed) % 200) - 100);
+		if(TVPTestRandom(seed) % 3 == 0) str += TJS_W(".5");
+		items.push_back(tTJSVariant(str));
+	}
+	TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("+-09az")));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(sort_descending_is_stable)
+{
+	// 1 and 1.0, and 0.0 and -0.0, are equal but distinguishable
+	std::vector<tTJSVariant> items;
+	TVPTestMakeNumbers(items, 500, 4);
+	TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("-9+0")));
+
+	// 1 and "1" are equal as strings
+	items.clear();
+	for(tjs_int i = 0; i < 200; i++)
+	{
+		tjs_int n = (i * 7) % 10;
+		if(i % 2)
+			items.push_back(tTJSVariant((tTVInteger)n));
+		else
+			items.push_back(tTJSVariant(ttstr(n)));
+	}
+	TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("za")));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(sort_parallel)
+{
+	// 65536 items or more are sorted on the thread pool
+	tjs_int drawthreads = TVPDrawThreadNum;
+	static const tjs_int threadnums[] = { 2, 3, 4, 8 };
+	for(tjs_uint t = 0; t < sizeof(threadnums) / sizeof(threadnums[0]); t++)
+	{
+		TVPDrawThreadNum = threadnums[t];
+
+		std::vector<tTJSVariant> items;
+		TVPTestMakeNumbers(items, 70000 + t, 5 + t);
+		TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("+-09")));
+
+		TVPTestMakeStrings(items, 65536 + t, 9 + t);
+		TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("+-az")));
+
+		items.clear();
+		tjs_uint32 seed = 13 + t;
+		for(tjs_uint i = 0; i < 70000; i++)
+			items.push_back(tTJSVariant((tTVInteger)TVPTestRandom(seed) % 1000));
+		TVP_CHECK(TVPTestSortMatchesAll(items, TJS_W("+-")));
+	}
+	TVPDrawThreadNum = drawthreads;
+}
+//---------------------------------------------------------------------------
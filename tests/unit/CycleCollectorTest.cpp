@@ -0,0 +1,142 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Cycle collector tests
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include "TVPTest.h"
+#include "ScriptMgnIntf.h"
+#include "tjsCycleCollector.h"
+
+
+//---------------------------------------------------------------------------
+static void TVPTestExec(const tjs_char * script)
+{
+	TVPGetScriptEngine()->ExecScript(ttstr(script));
+}
+//---------------------------------------------------------------------------
+static tjs_int TVPTestEvalInt(const tjs_char * expression)
+{
+	tTJSVariant result;
+	TVPGetScriptEngine()->EvalExpression(ttstr(expression), &result);
+	return (tjs_int)result;
+}
+//---------------------------------------------------------------------------
+static void TVPTestStartCycleCollector()
+{
+	// the collector tracks the objects created after it is started; the
+	// script engine is created on the first use, after this
+	TJSStartCycleCollector();
+	TVPTestExec(TJS_W(
+		"class CCNode"
+		"{"
+		"	var link;"
+		"	function finalize() { global.cc_finalized++; }"
+		"}"
+		"global.cc_finalized = 0;"));
+}
+//---------------------------------------------------------------------------
+static void TVPTestCollectAll(tTJSCycleCollectorResult & result)
+{
+	// as the compact hook does; the register stack of the finished
+	// functions still refers to the last objects until it is compacted
+	TVPGetScriptEngine()->DoGarbageCollection();
+	TJSCollectCycles((tjs_uint)-1, (tjs_uint)-1, result);
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(cycle_self_reference)
+{
+	TVPTestStartCycleCollector();
+	TVPTestExec(TJS_W(
+		"global.cc_finalized = 0;"
+		"function cc_make() { var n = new CCNode(); n.link = n; }"
+		"cc_make();"));
+	TVP_CHECK(TVPTestEvalInt(TJS_W("cc_finalized")) == 0);
+
+	tTJSCycleCollectorResult result;
+	TVPTestCollectAll(result);
+	TVP_CHECK(!result.Aborted);
+	TVP_CHECK(result.Collected >= 1);
+	TVP_CHECK(TVPTestEvalInt(TJS_W("cc_finalized")) == 1);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(cycle_through_array)
+{
+	TVPTestStartCycleCollector();
+	TVPTestExec(TJS_W(
+		"global.cc_finalized = 0;"
+		"function cc_make()"
+		"{"
+		"	var n = new CCNode();"
+		"	n.link = [ 1, 'a', n ];"
+		"	var a = [];"
+		"	a.add(a);"
+		"}"
+		"cc_make();"));
+
+	tTJSCycleCollectorResult result;
+	TVPTestCollectAll(result);
+	TVP_CHECK(!result.Aborted);
+	TVP_CHECK(result.Collected >= 3); // n, n.link and a
+	TVP_CHECK(TVPTestEvalInt(TJS_W("cc_finalized")) == 1);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(cycle_referred_from_outside_is_alive)
+{
+	TVPTestStartCycleCollector();
+	TVPTestExec(TJS_W(
+		"global.cc_finalized = 0;"
+		"global.cc_keep = new CCNode();"
+		"cc_keep.link = [ cc_keep ];"));
+
+	tTJSCycleCollectorResult result;
+	TVPTestCollectAll(result);
+	TVP_CHECK(TVPTestEvalInt(TJS_W("cc_finalized")) == 0);
+	TVP_CHECK(TVPTestEvalInt(TJS_W("isvalid cc_keep")) != 0);
+	TVP_CHECK(TVPTestEvalInt(TJS_W("cc_keep.link[0] === cc_keep")) != 0);
+
+	TVPTestExec(TJS_W("delete global.cc_keep;"));
+	TVPTestCollectAll(result);
+	TVP_CHECK(TVPTestEvalInt(TJS_W("cc_finalized")) == 1);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(cycle_collect_continues_after_maxnodes)
+{
+	// a large live structure exceeds "maxnodes" every time; the cycles
+	// before and after it must still be collected
+	TVPTestStartCycleCollector();
+	TVPTestExec(TJS_W(
+		"global.cc_finalized = 0;"
+		"function cc_make() { var n = new CCNode(); n.link = n; }"
+		"for(var i = 0; i < 10; i++) cc_make();"
+		"global.cc_large = [];"
+		"for(var i = 0; i < 1000; i++) cc_large.add(%[ value : i ]);"
+		"for(var i = 0; i < 10; i++) cc_make();"));
+
+	TVPGetScriptEngine()->DoGarbageCollection();
+	tTJSCycleCollectorResult result;
+	bool aborted = false;
+	for(tjs_int i = 0; i < 1000 && TVPTestEvalInt(TJS_W("cc_finalized")) < 20; i++)
+	{
+		TJSCollectCycles((tjs_uint)-1, 100, result);
+		if(result.Aborted) aborted = true;
+	}
+	TVP_CHECK(aborted);
+	TVP_CHECK(TVPTestEvalInt(TJS_W("cc_finalized")) == 20);
+	TVP_CHECK(TVPTestEvalInt(TJS_W("cc_large.count")) == 1000);
+	TVP_CHECK(TVPTestEvalInt(TJS_W("cc_large[999].value")) == 999);
+
+	TVPTestExec(TJS_W("delete global.cc_large;"));
+}
+//---------------------------------------------------------------------------
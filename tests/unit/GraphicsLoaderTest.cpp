@@ -0,0 +1,262 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Graphics loader tests ( region and reduced loading )
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include "TVPTest.h"
+#include "HeadlessHost.h"
+#include "GraphicsLoaderIntf.h"
+#include "LayerBitmapIntf.h"
+#include "LayerIntf.h"
+#include "StorageIntf.h"
+#include "ComplexRect.h"
+
+
+//---------------------------------------------------------------------------
+static void TVPTestFillImage(tTVPBaseBitmap & bmp, tjs_uint32 seed, bool opaque)
+{
+	// noise, so that a wrong pixel in a box changes the average
+	tjs_uint32 r = seed;
+	for(tjs_uint y = 0; y < bmp.GetHeight(); y++)
+	{
+		tjs_uint32 * line = (tjs_uint32 *)bmp.GetScanLineForWrite(y);
+		for(tjs_uint x = 0; x < bmp.GetWidth(); x++)
+		{
+			r = r * 1103515245 + 12345;
+			line[x] = (r >> 8) | (opaque ? 0xff000000 : (r << 24));
+		}
+	}
+}
+//---------------------------------------------------------------------------
+static ttstr TVPTestSaveImage(const char * name, const tTVPBaseBitmap & bmp,
+	const tjs_char * mode)
+{
+	// saves the image to a temporary storage by the saver of "mode"
+	ttstr storage(TVPHeadlessTempPath(name).c_str());
+	tTJSBinaryStream * stream = TVPCreateStream(storage, TJS_BS_WRITE);
+	try
+	{
+		if(!TJS_strncmp(mode, TJS_W("bmp"), 3))
+			TVPSaveAsBMP(NULL, stream, &bmp, mode, NULL);
+#ifdef TVP_HEADLESS_JPEG
+		else if(!TJS_strncmp(mode, TJS_W("jpg"), 3))
+			TVPSaveAsJPG(NULL, stream, &bmp, mode, NULL);
+#endif
+		else
+			TVPSaveAsTLG(NULL, stream, &bmp, mode, NULL);
+	}
+	catch(...)
+	{
+		delete stream;
+		throw;
+	}
+	delete stream;
+	return storage;
+}
+//---------------------------------------------------------------------------
+static void TVPTestCropAndReduce(tTVPBaseBitmap & dest,
+	const tTVPBaseBitmap & src, tTVPRect rect, tjs_uint dstw, tjs_uint dsth)
+{
+	// the full image cropped to "rect" clipped at the image edges, then
+	// reduced to dstw x dsth by the box filter; each destination pixel is
+	// the rounded average of the source pixels it covers
+	rect.left = std::max(rect.left, 0);
+	rect.top = std::max(rect.top, 0);
+	rect.right = std::min(rect.right, (tjs_int)src.GetWidth());
+	rect.bottom = std::min(rect.bottom, (tjs_int)src.GetHeight());
+	tjs_uint rw = rect.right - rect.left, rh = rect.bottom - rect.top;
+	if(!dstw || dstw > rw) dstw = rw;
+	if(!dsth || dsth > rh) dsth = rh;
+
+	dest.Recreate(dstw, dsth, 32);
+	for(tjs_uint y = 0; y < dsth; y++)
+	{
+		tjs_uint y0 = y * rh / dsth, y1 = (y + 1) * rh / dsth;
+		tjs_uint32 * line = (tjs_uint32 *)dest.GetScanLineForWrite(y);
+		for(tjs_uint x = 0; x < dstw; x++)
+		{
+			tjs_uint x0 = x * rw / dstw, x1 = (x + 1) * rw / dstw;
+			tjs_uint sum[4] = { 0, 0, 0, 0 };
+			for(tjs_uint sy = y0; sy < y1; sy++)
+			{
+				const tjs_uint8 * p = (const tjs_uint8 *)
+					src.GetScanLine(rect.top + sy) + (rect.left + x0) * 4;
+				for(tjs_uint sx = x0; sx < x1; sx++, p += 4)
+					for(tjs_int c = 0; c < 4; c++) sum[c] += p[c];
+			}
+			tjs_uint n = (x1 - x0) * (y1 - y0);
+			tjs_uint32 pixel = 0;
+			for(tjs_int c = 0; c < 4; c++)
+				pixel |= ((sum[c] + n / 2) / n) << (c * 8);
+			line[x] = pixel;
+		}
+	}
+}
+//---------------------------------------------------------------------------
+static bool TVPTestRegionMatches(const ttstr & storage,
+	const tTVPBaseBitmap & full, const tTVPRect * rect,
+	tjs_uint dstw, tjs_uint dsth, tjs_int tolerance = 0)
+{
+	// the region load must give the same pixels as the full decode
+	// followed by the crop and the box filter; "tolerance" is the largest
+	// difference allowed in each channel
+	tTVPBaseBitmap region(1, 1, 32);
+	TVPLoadGraphicRegion(&region, storage, TVP_clNone, rect, dstw, dsth);
+
+	tTVPBaseBitmap expected(1, 1, 32);
+	TVPTestCropAndReduce(expected, full,
+		rect ? *rect : tTVPRect(0, 0, full.GetWidth(), full.GetHeight()),
+		dstw, dsth);
+
+	if(region.GetWidth() != expected.GetWidth() ||
+		region.GetHeight() != expected.GetHeight())
+	{
+		fprintf(stderr, "%s: %ux%u, expected %ux%u\n",
+			storage.AsNarrowStdString().c_str(),
+			region.GetWidth(), region.GetHeight(),
+			expected.GetWidth(), expected.GetHeight());
+		return false;
+	}
+	for(tjs_uint y = 0; y < region.GetHeight(); y++)
+	{
+		const tjs_uint32 * l1 = (const tjs_uint32 *)region.GetScanLine(y);
+		const tjs_uint32 * l2 = (const tjs_uint32 *)expected.GetScanLine(y);
+		for(tjs_uint x = 0; x < region.GetWidth(); x++)
+		{
+			tjs_int diff = 0;
+			for(tjs_int c = 0; c < 32; c += 8)
+				diff = std::max(diff, std::abs((tjs_int)((l1[x] >> c) & 0xff) -
+					(tjs_int)((l2[x] >> c) & 0xff)));
+			if(diff > tolerance)
+			{
+				fprintf(stderr, "%s: (%u, %u) is %08x, expected %08x\n",
+					storage.AsNarrowStdString().c_str(), x, y, l1[x], l2[x]);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+//---------------------------------------------------------------------------
+static bool TVPTestRegionThrows(const ttstr & storage, const tTVPRect & rect)
+{
+	tTVPBaseBitmap region(1, 1, 32);
+	try
+	{
+		TVPLoadGraphicRegion(&region, storage, TVP_clNone, &rect, 0, 0);
+	}
+	catch(eTJS &)
+	{
+		return true;
+	}
+	return false;
+}
+//---------------------------------------------------------------------------
+static void TVPTestRegions(const char * name, const tjs_char * mode, bool opaque)
+{
+	// 67x45 is not a multiple of any destination size below
+	tTVPBaseBitmap src(67, 45, 32);
+	TVPTestFillImage(src, 1, opaque);
+	ttstr storage = TVPTestSaveImage(name, src, mode);
+
+	tTVPBaseBitmap full(1, 1, 32);
+	TVPLoadGraphic(&full, storage, TVP_clNone, 0, 0, glmNormal);
+
+	// whole image, as is and reduced
+	TVP_CHECK(TVPTestRegionMatches(storage, full, NULL, 0, 0));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, NULL, 16, 11));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, NULL, 1, 1));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, NULL, 66, 44));
+
+	// inner regions
+	tTVPRect inner(10, 7, 40, 27);
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &inner, 0, 0));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &inner, 7, 5));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &inner, 30, 3));
+	tTVPRect line(0, 44, 67, 45);
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &line, 10, 0));
+
+	// a destination larger than the region keeps the region size
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &inner, 100, 100));
+
+	// regions clamped at the image edges
+	tTVPRect topleft(-5, -3, 20, 15);
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &topleft, 0, 0));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &topleft, 6, 4));
+	tTVPRect bottomright(50, 30, 100, 100);
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &bottomright, 0, 0));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &bottomright, 5, 4));
+	tTVPRect around(-10, -10, 200, 200);
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &around, 0, 0));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &around, 13, 9));
+
+	// no pixel in the region
+	TVP_CHECK(TVPTestRegionThrows(storage, tTVPRect(67, 0, 80, 10)));
+	TVP_CHECK(TVPTestRegionThrows(storage, tTVPRect(-20, -20, 0, 0)));
+	TVP_CHECK(TVPTestRegionThrows(storage, tTVPRect(10, 10, 10, 20)));
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(region_bmp)
+{
+	// BMP gives the lines from the bottom
+	TVPTestRegions("region24.bmp", TJS_W("bmp24"), true);
+	TVPTestRegions("region32.bmp", TJS_W("bmp32"), false);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(region_tlg)
+{
+	TVPTestRegions("region.tlg5", TJS_W("tlg5"), false);
+	TVPTestRegions("region.tlg6", TJS_W("tlg6"), false);
+}
+//---------------------------------------------------------------------------
+#ifdef TVP_HEADLESS_JPEG
+TVP_TEST(region_jpeg)
+{
+	// JPEG is reduced in its IDCT first, which is not the box filter, and
+	// the region edges are rounded out to the reduced pixels; the image is
+	// smooth so that both give nearly the same pixels
+	tTVPBaseBitmap src(203, 157, 32);
+	for(tjs_uint y = 0; y < src.GetHeight(); y++)
+	{
+		tjs_uint32 * line = (tjs_uint32 *)src.GetScanLineForWrite(y);
+		for(tjs_uint x = 0; x < src.GetWidth(); x++)
+			line[x] = 0xff000000 + ((x / 2) << 16) + (((x + y) / 4) << 8) +
+				(255 - y / 2);
+	}
+	ttstr storage = TVPTestSaveImage("region.jpg", src, TJS_W("jpg95"));
+
+	tTVPBaseBitmap full(1, 1, 32);
+	TVPLoadGraphic(&full, storage, TVP_clNone, 0, 0, glmNormal);
+
+	// not reduced; decoded as the full image
+	TVP_CHECK(TVPTestRegionMatches(storage, full, NULL, 0, 0));
+	tTVPRect inner(17, 9, 150, 100);
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &inner, 0, 0));
+	tTVPRect clamped(-8, 100, 250, 200);
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &clamped, 0, 0));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &inner, 120, 80));
+
+	// reduced by 1/2, 1/4 and 1/8 in the IDCT, and by the box filter
+	TVP_CHECK(TVPTestRegionMatches(storage, full, NULL, 101, 78, 6));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, NULL, 40, 30, 6));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, NULL, 13, 9, 6));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &inner, 30, 20, 6));
+	TVP_CHECK(TVPTestRegionMatches(storage, full, &clamped, 50, 11, 6));
+}
+#endif
+//---------------------------------------------------------------------------
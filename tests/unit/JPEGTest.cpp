@@ -0,0 +1,245 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// JPEG loader tests
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "TVPTest.h"
+#include "GraphicsLoaderIntf.h"
+#include "LayerBitmapIntf.h"
+#include "UtilStreams.h"
+#include "ThreadIntf.h"
+
+extern "C"
+{
+#include <jpeglib.h>
+}
+
+
+//---------------------------------------------------------------------------
+struct tTVPTestJPEGParams
+{
+	tjs_uint Width;
+	tjs_uint Height;
+	int Components; // 3 or 1
+	int HSamp; // sampling factors of the luminance
+	int VSamp;
+	int RestartRows; // restart interval in MCU rows
+	int RestartMCUs; // restart interval in MCUs; used if RestartRows is 0
+};
+//---------------------------------------------------------------------------
+static void TVPTestEncodeJPEG(tTVPMemoryStream & stream,
+	const tTVPTestJPEGParams & params)
+{
+	// a photo-like image with sharp edges, so that the upsampling across
+	// the band boundaries matters
+	jpeg_compress_struct cinfo;
+	jpeg_error_mgr jerr;
+	cinfo.err = jpeg_std_error(&jerr);
+	jpeg_create_compress(&cinfo);
+	unsigned char * out = NULL;
+	unsigned long outsize = 0;
+	jpeg_mem_dest(&cinfo, &out, &outsize);
+
+	cinfo.image_width = params.Width;
+	cinfo.image_height = params.Height;
+	cinfo.input_components = params.Components;
+	cinfo.in_color_space = params.Components == 3 ? JCS_RGB : JCS_GRAYSCALE;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, 85, TRUE);
+	cinfo.comp_info[0].h_samp_factor = params.HSamp;
+	cinfo.comp_info[0].v_samp_factor = params.VSamp;
+	cinfo.restart_in_rows = params.RestartRows;
+	cinfo.restart_interval = params.RestartMCUs;
+	jpeg_start_compress(&cinfo, TRUE);
+
+	std::vector<JSAMPLE> line(params.Width * params.Components);
+	tjs_uint32 r = params.Width * 31 + params.Height;
+	for(tjs_uint y = 0; y < params.Height; y++)
+	{
+		for(tjs_uint x = 0; x < params.Width; x++)
+		{
+			r = r * 1103515245 + 12345;
+			tjs_uint32 noise = (r >> 16) & 0x0f;
+			tjs_uint32 edge = ((x / 13) ^ (y / 11)) & 1 ? 0x60 : 0;
+			JSAMPLE * p = &line[x * params.Components];
+			p[0] = (JSAMPLE)((x / 3 + edge + noise) & 0xff);
+			if(params.Components == 3)
+			{
+				p[1] = (JSAMPLE)((y / 2 + noise) & 0xff);
+				p[2] = (JSAMPLE)(((x + y) / 5 + edge) & 0xff);
+			}
+		}
+		JSAMPROW row = &line[0];
+		jpeg_write_scanlines(&cinfo, &row, 1);
+	}
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+
+	stream.Clear();
+	stream.WriteBuffer(out, (tjs_uint)outsize);
+	free(out);
+}
+//---------------------------------------------------------------------------
+static tjs_uint TVPTestCountRestartMarkers(tTVPMemoryStream & stream)
+{
+	const tjs_uint8 * p = (const tjs_uint8 *)stream.GetInternalBuffer();
+	tjs_uint count = 0;
+	for(tjs_uint i = 0; i + 1 < (tjs_uint)stream.GetSize(); i++)
+		if(p[i] == 0xff && p[i + 1] >= 0xd0 && p[i + 1] <= 0xd7) count++;
+	return count;
+}
+//---------------------------------------------------------------------------
+static void TVPTestSizeCallback(void *callbackdata, tjs_uint w, tjs_uint h)
+{
+	std::vector<tjs_uint8> * image = (std::vector<tjs_uint8> *)callbackdata;
+	image->assign(w * h * 4 + 8, 0);
+	memcpy(&(*image)[0], &w, 4);
+	memcpy(&(*image)[4], &h, 4);
+}
+//---------------------------------------------------------------------------
+static void * TVPTestScanLineCallback(void *callbackdata, tjs_int y)
+{
+	// the image is kept as 32bpp lines after the width and the height;
+	// 8bpp (grayscale) lines use the first quarter of each line
+	if(y < 0) return NULL;
+	std::vector<tjs_uint8> * image = (std::vector<tjs_uint8> *)callbackdata;
+	tjs_uint w;
+	memcpy(&w, &(*image)[0], 4);
+	return &(*image)[8 + y * w * 4];
+}
+//---------------------------------------------------------------------------
+static void TVPTestLoadJPEG(std::vector<tjs_uint8> & image,
+	tTVPMemoryStream & stream, tjs_int threads, tTVPGraphicLoadMode mode)
+{
+	// threads = 1 decodes serially
+	tjs_int drawthreads = TVPDrawThreadNum;
+	bool parallel = TVPJPEGParallelDecode;
+	try
+	{
+		TVPDrawThreadNum = threads;
+		TVPJPEGParallelDecode = threads > 1;
+		stream.SetPosition(0);
+		TVPLoadJPEG(NULL, &image, TVPTestSizeCallback, TVPTestScanLineCallback,
+			NULL, &stream, -1, mode);
+	}
+	catch(...)
+	{
+		TVPDrawThreadNum = drawthreads;
+		TVPJPEGParallelDecode = parallel;
+		throw;
+	}
+	TVPDrawThreadNum = drawthreads;
+	TVPJPEGParallelDecode = parallel;
+}
+//---------------------------------------------------------------------------
+static void TVPTestParallelMatchesSerial(const tTVPTestJPEGParams & params,
+	tTVPGraphicLoadMode mode = glmNormal)
+{
+	// decodes on 2 to 7 draw threads, so that the bands are odd and even in
+	// number and the intervals do not always divide evenly among them
+	tTVPMemoryStream stream;
+	TVPTestEncodeJPEG(stream, params);
+	if(params.RestartRows || params.RestartMCUs)
+		TVP_CHECK(TVPTestCountRestartMarkers(stream) > 0);
+	else
+		TVP_CHECK(TVPTestCountRestartMarkers(stream) == 0);
+
+	static const tTVPJPEGLoadPrecision precisions[] =
+		{ jlpLow, jlpMedium, jlpHigh };
+	static const tjs_int threads[] = { 2, 3, 5, 7 };
+	tTVPJPEGLoadPrecision precision = TVPJPEGLoadPrecision;
+	try
+	{
+		for(tjs_uint p = 0; p < sizeof(precisions) / sizeof(precisions[0]); p++)
+		{
+			TVPJPEGLoadPrecision = precisions[p];
+			std::vector<tjs_uint8> serial;
+			TVPTestLoadJPEG(serial, stream, 1, mode);
+			TVP_CHECK(serial.size() == params.Width * params.Height * 4 + 8);
+			for(tjs_uint t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+			{
+				std::vector<tjs_uint8> threaded;
+				TVPTestLoadJPEG(threaded, stream, threads[t], mode);
+				bool same = threaded == serial;
+				if(!same)
+					fprintf(stderr, "%ux%u, %d components, %dx%d, restart "
+						"%d rows / %d MCUs, precision %d, %d threads: "
+						"the images differ\n", params.Width, params.Height,
+						params.Components, params.HSamp, params.VSamp,
+						params.RestartRows, params.RestartMCUs,
+						(int)precisions[p], (int)threads[t]);
+				TVP_CHECK(same);
+			}
+		}
+	}
+	catch(...)
+	{
+		TVPJPEGLoadPrecision = precision;
+		throw;
+	}
+	TVPJPEGLoadPrecision = precision;
+}
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(jpeg_parallel_decode_matches_serial)
+{
+	// 4:2:0, 4:2:2 and 4:4:4, with intervals of one or more MCU rows; the
+	// odd size leaves a partial MCU column and a partial last interval
+	static const int samplings[][2] = { { 2, 2 }, { 2, 1 }, { 1, 1 } };
+	static const int restarts[] = { 1, 2, 3 };
+	static const tjs_uint sizes[][2] = { { 640, 480 }, { 641, 497 } };
+	for(tjs_uint s = 0; s < sizeof(samplings) / sizeof(samplings[0]); s++)
+	{
+		for(tjs_uint r = 0; r < sizeof(restarts) / sizeof(restarts[0]); r++)
+		{
+			for(tjs_uint z = 0; z < sizeof(sizes) / sizeof(sizes[0]); z++)
+			{
+				tTVPTestJPEGParams params =
+				{
+					sizes[z][0], sizes[z][1], 3,
+					samplings[s][0], samplings[s][1], restarts[r], 0
+				};
+				TVPTestParallelMatchesSerial(params);
+			}
+		}
+	}
+}
+//---------------------------------------------------------------------------
+TVP_TEST(jpeg_parallel_decode_grayscale)
+{
+	// a grayscale JPEG, and a color JPEG loaded as grayscale
+	tTVPTestJPEGParams gray = { 523, 301, 1, 1, 1, 1, 0 };
+	TVPTestParallelMatchesSerial(gray);
+	TVPTestParallelMatchesSerial(gray, glmGrayscale);
+	tTVPTestJPEGParams color = { 523, 301, 3, 2, 2, 2, 0 };
+	TVPTestParallelMatchesSerial(color, glmGrayscale);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(jpeg_restart_not_at_mcu_rows)
+{
+	// an interval which ends in the middle of an MCU row can not be split;
+	// the image is decoded serially
+	tTVPTestJPEGParams params = { 640, 480, 3, 2, 2, 0, 7 };
+	TVPTestParallelMatchesSerial(params);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(jpeg_without_restart_markers)
+{
+	tTVPTestJPEGParams params = { 640, 480, 3, 2, 2, 0, 0 };
+	TVPTestParallelMatchesSerial(params);
+}
+//---------------------------------------------------------------------------
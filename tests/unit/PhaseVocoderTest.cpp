@@ -0,0 +1,127 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Phase vocoder DSP tests
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "TVPTest.h"
+#include "PhaseVocoderDSP.h"
+#include "DetectCPU.h"
+#include "tvpgl_ia32_intf.h"
+
+
+//---------------------------------------------------------------------------
+static void TVPTestRunPhaseVocoder(std::vector<float> & out,
+	tjs_uint32 cputype, unsigned int framesize, unsigned int oversamp,
+	float time, float pitch)
+{
+	// runs 2ch of tones and noise through the DSP with the given CPU flags;
+	// the core is chosen on each Process call by TVPCPUType
+	const unsigned int channels = 2;
+	const unsigned int samples = framesize * 24;
+	tRisaPhaseVocoderDSP dsp(framesize, 44100, channels);
+	dsp.SetOverSampling(oversamp);
+	dsp.SetTimeScale(time);
+	dsp.SetFrequencyScale(pitch);
+
+	tjs_uint32 orgtype = TVPCPUType;
+	TVPCPUType = cputype;
+	try
+	{
+		tjs_uint32 r = 1;
+		unsigned int pos = 0;
+		out.clear();
+		for(;;)
+		{
+			tRisaPhaseVocoderDSP::tStatus status = dsp.Process();
+			if(status == tRisaPhaseVocoderDSP::psInputNotEnough)
+			{
+				if(pos >= samples) break;
+				float *p1, *p2;
+				size_t p1len, p2len;
+				dsp.GetInputBuffer(dsp.GetInputHopSize(), p1, p1len, p2, p2len);
+				for(size_t i = 0; i < p1len + p2len; i++, pos++)
+				{
+					float * d = i < p1len ? p1 + i * channels :
+						p2 + (i - p1len) * channels;
+					r = r * 1103515245 + 12345;
+					float noise = (float)((r >> 16) & 0x7fff) / 32768.0f - 0.5f;
+					d[0] = 0.5f * (float)sin(pos * 0.031) + 0.1f * noise;
+					d[1] = 0.3f * (float)sin(pos * 0.173) - 0.1f * noise;
+				}
+			}
+			size_t ready = dsp.GetOutputReadySize();
+			if(ready)
+			{
+				const float *p1, *p2;
+				size_t p1len, p2len;
+				dsp.GetOutputBuffer(ready, p1, p1len, p2, p2len);
+				out.insert(out.end(), p1, p1 + p1len * channels);
+				if(p2) out.insert(out.end(), p2, p2 + p2len * channels);
+			}
+		}
+	}
+	catch(...)
+	{
+		TVPCPUType = orgtype;
+		throw;
+	}
+	TVPCPUType = orgtype;
+}
+//---------------------------------------------------------------------------
+TVP_TEST(avx2_core_matches_sse_core)
+{
+	// the AVX2 core is the SSE core eight bands at a time; the output must
+	// be the same to the bit, at the voice and the music frame sizes
+	if(!(TVPCPUType & TVP_CPU_HAS_AVX2))
+	{
+		printf("avx2_core_matches_sse_core: no AVX2; skipped\n");
+		return;
+	}
+
+	static const unsigned int framesizes[] = { 256, 4096 };
+	static const unsigned int oversamps[] = { 2, 4, 8, 16 };
+	static const struct { float Time; float Pitch; } scales[] =
+	{
+		{ 1.0f, 1.0f },
+		{ 0.5f, 1.0f },
+		{ 1.0f, 1.5f },
+		{ 1.3f, 0.8f },
+	};
+
+	tjs_uint32 sse = TVPCPUType & ~TVP_CPU_HAS_AVX2;
+	for(tjs_uint f = 0; f < sizeof(framesizes) / sizeof(framesizes[0]); f++)
+	{
+		for(tjs_uint o = 0; o < sizeof(oversamps) / sizeof(oversamps[0]); o++)
+		{
+			for(tjs_uint s = 0; s < sizeof(scales) / sizeof(scales[0]); s++)
+			{
+				std::vector<float> ref, avx2;
+				TVPTestRunPhaseVocoder(ref, sse, framesizes[f], oversamps[o],
+					scales[s].Time, scales[s].Pitch);
+				TVPTestRunPhaseVocoder(avx2, TVPCPUType, framesizes[f],
+					oversamps[o], scales[s].Time, scales[s].Pitch);
+				TVP_CHECK(!ref.empty());
+				TVP_CHECK(ref.size() == avx2.size());
+				bool same = ref.size() == avx2.size() &&
+					!memcmp(&ref[0], &avx2[0], ref.size() * sizeof(float));
+				if(!same)
+					fprintf(stderr, "framesize %u, overlap %u, time %g, "
+						"pitch %g: AVX2 output differs\n", framesizes[f],
+						oversamps[o], scales[s].Time, scales[s].Pitch);
+				TVP_CHECK(same);
+			}
+		}
+	}
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,156 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Pixel format conversion tests ( PNG byte order to 32bit ARGB )
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "TVPTest.h"
+#include "DetectCPU.h"
+#include "tvpgl.h"
+#include "tvpgl_ia32_intf.h"
+
+extern "C"
+{
+TVP_GL_FUNC_EXTERN_DECL(void, TVPConvertRGB24BitTo32Bit_c, (tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len));
+TVP_GL_FUNC_EXTERN_DECL(void, TVPConvertRGBA32BitTo32Bit_c, (tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len));
+}
+extern void TVPConvertRGB24BitTo32Bit_sse2_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len);
+extern void TVPConvertRGB24BitTo32Bit_ssse3_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len);
+extern void TVPConvertRGBA32BitTo32Bit_sse2_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len);
+extern void TVPConvertRGBA32BitTo32Bit_ssse3_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len);
+
+
+//---------------------------------------------------------------------------
+typedef void (*tTVPTestConvertFunc)(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len);
+static const tjs_int TVPTestMaxLen = 67; // four 16 pixel blocks and a tail
+static const tjs_uint32 TVPTestGuard = 0x5a5a5a5a;
+//---------------------------------------------------------------------------
+static void TVPTestFillBytes(tjs_uint8 * p, tjs_int n, tjs_uint32 seed)
+{
+	tjs_uint32 r = seed;
+	for(tjs_int i = 0; i < n; i++)
+	{
+		r = r * 1103515245 + 12345;
+		p[i] = (tjs_uint8)(r >> 16);
+	}
+}
+//---------------------------------------------------------------------------
+static bool TVPTestSameLine(const char * name, const char * kind,
+	tjs_int len, tjs_int srcofs, tjs_int destofs,
+	const tjs_uint32 * dest, const tjs_uint32 * expected)
+{
+	// dest[-1] and dest[len] must be left as the guard
+	bool ok = dest[-1] == TVPTestGuard && dest[len] == TVPTestGuard;
+	for(tjs_int i = 0; ok && i < len; i++)
+		if(dest[i] != expected[i])
+		{
+			fprintf(stderr, "%s (%s, len %d, src +%d, dest +%d): "
+				"pixel %d is %08x, expected %08x\n", name, kind, (int)len,
+				(int)srcofs, (int)destofs, (int)i, dest[i], expected[i]);
+			return false;
+		}
+	if(!ok)
+		fprintf(stderr, "%s (%s, len %d, src +%d, dest +%d): "
+			"wrote outside the line\n", name, kind, (int)len, (int)srcofs,
+			(int)destofs);
+	return ok;
+}
+//---------------------------------------------------------------------------
+static void TVPTestConvert(const char * name, tTVPTestConvertFunc func,
+	tTVPTestConvertFunc ref, tjs_int srcbytes, tjs_uint32 cpuflag)
+{
+	// "func" must give the same pixels as the C version "ref" for every
+	// length, with the source and the destination at any alignment, and in
+	// place as LoadPNG uses it
+	if((TVPCPUType & cpuflag) != cpuflag)
+	{
+		printf("%s: not supported by the CPU; skipped\n", name);
+		return;
+	}
+
+	// room for the offsets below and a guard pixel at each end
+	std::vector<tjs_uint32> destbuf(TVPTestMaxLen + 4 + 2);
+	std::vector<tjs_uint32> expected(TVPTestMaxLen);
+	std::vector<tjs_uint8> srcbuf(TVPTestMaxLen * srcbytes + 16);
+
+	for(tjs_int len = 0; len <= TVPTestMaxLen; len++)
+	{
+		// separate buffers; the destination is offset by whole pixels, so that
+		// the 16 byte blocks fall at every alignment
+		for(tjs_int srcofs = 0; srcofs < 16; srcofs++)
+		{
+			for(tjs_int destofs = 0; destofs < 4; destofs++)
+			{
+				tjs_uint8 * src = &srcbuf[srcofs];
+				TVPTestFillBytes(&srcbuf[0], (tjs_int)srcbuf.size(),
+					len * 64 + srcofs * 4 + destofs);
+				if(len) ref(&expected[0], src, len);
+
+				tjs_uint32 * dest = &destbuf[1 + destofs];
+				for(size_t i = 0; i < destbuf.size(); i++)
+					destbuf[i] = TVPTestGuard;
+				func(dest, src, len);
+				TVP_CHECK(TVPTestSameLine(name, "separate", len, srcofs,
+					destofs, dest, &expected[0]));
+			}
+		}
+
+		// in place; RGBA is converted on itself, and RGB is read from the
+		// last 3/4 of the line and expanded forward
+		for(tjs_int destofs = 0; destofs < 4; destofs++)
+		{
+			tjs_uint32 * dest = &destbuf[1 + destofs];
+			for(size_t i = 0; i < destbuf.size(); i++)
+				destbuf[i] = TVPTestGuard;
+			tjs_uint8 * src = (tjs_uint8 *)dest + (srcbytes == 4 ? 0 : len);
+			TVPTestFillBytes(src, len * srcbytes, len * 4 + destofs);
+			if(len) ref(&expected[0], src, len);
+			func(dest, src, len);
+			TVP_CHECK(TVPTestSameLine(name, "in place", len, 0, destofs,
+				dest, &expected[0]));
+		}
+	}
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(rgb24_sse2)
+{
+	TVPTestConvert("TVPConvertRGB24BitTo32Bit_sse2_c",
+		TVPConvertRGB24BitTo32Bit_sse2_c, TVPConvertRGB24BitTo32Bit_c, 3,
+		TVP_CPU_HAS_SSE2);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(rgb24_ssse3)
+{
+	TVPTestConvert("TVPConvertRGB24BitTo32Bit_ssse3_c",
+		TVPConvertRGB24BitTo32Bit_ssse3_c, TVPConvertRGB24BitTo32Bit_c, 3,
+		TVP_CPU_HAS_SSE2|TVP_CPU_HAS_SSSE3);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(rgba32_sse2)
+{
+	TVPTestConvert("TVPConvertRGBA32BitTo32Bit_sse2_c",
+		TVPConvertRGBA32BitTo32Bit_sse2_c, TVPConvertRGBA32BitTo32Bit_c, 4,
+		TVP_CPU_HAS_SSE2);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(rgba32_ssse3)
+{
+	TVPTestConvert("TVPConvertRGBA32BitTo32Bit_ssse3_c",
+		TVPConvertRGBA32BitTo32Bit_ssse3_c, TVPConvertRGBA32BitTo32Bit_c, 4,
+		TVP_CPU_HAS_SSE2|TVP_CPU_HAS_SSSE3);
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,292 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Software mixer tests ( sample rate conversion, pan and limiter )
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "TVPTest.h"
+#include "SoftwareMixer.h"
+
+
+//---------------------------------------------------------------------------
+// tTVPTestFloatSource : float PCM from a table, which ends at the table end
+//---------------------------------------------------------------------------
+class tTVPTestFloatSource : public tTVPSampleAndLabelSource
+{
+	tTVPWaveFormat Format;
+	std::vector<float> Samples;
+	tjs_uint Position; // in sample granules
+
+public:
+	tTVPTestFloatSource(tjs_uint frequency, tjs_uint channels)
+	{
+		memset(&Format, 0, sizeof(Format));
+		Format.SamplesPerSec = frequency;
+		Format.Channels = channels;
+		Format.BitsPerSample = 32;
+		Format.BytesPerSample = 4;
+		Format.IsFloat = true;
+		Position = 0;
+	}
+
+	std::vector<float> & GetSamples() { return Samples; }
+
+	void Decode(void *dest, tjs_uint samples, tjs_uint &written,
+		tTVPWaveSegmentQueue &segments)
+	{
+		tjs_uint total = (tjs_uint)Samples.size() / Format.Channels;
+		written = total - Position < samples ? total - Position : samples;
+		if(written)
+			memcpy(dest, &Samples[Position * Format.Channels],
+				written * Format.Channels * sizeof(float));
+		Position += written;
+		segments.Clear();
+	}
+
+	const tTVPWaveFormat & GetFormat() const { return Format; }
+};
+//---------------------------------------------------------------------------
+// tTVPTestCaptureOutput : keeps everything the mixer writes
+//---------------------------------------------------------------------------
+class tTVPTestCaptureOutput : public iTVPSoftwareMixerOutput
+{
+public:
+	std::vector<float> Samples;
+
+	void Write(const float *samples, tjs_uint frames)
+	{
+		Samples.insert(Samples.end(), samples, samples + frames * 2);
+	}
+};
+//---------------------------------------------------------------------------
+static void TVPTestRenderInPieces(tTVPSoftwareMixer & mixer, tjs_uint frames,
+	bool onebyone)
+{
+	// odd piece sizes, so that the resampler carries its phase across the
+	// calls and across the mixing blocks; or one sample granule at a time,
+	// so that the source ends at every phase
+	static const tjs_uint pieces[] = { 1, 777, 2500, 3, 64 };
+	for(tjs_uint i = 0; frames; i++)
+	{
+		tjs_uint n = onebyone ? 1 :
+			pieces[i % (sizeof(pieces) / sizeof(pieces[0]))];
+		if(n > frames) n = frames;
+		mixer.Render(n);
+		frames -= n;
+	}
+}
+//---------------------------------------------------------------------------
+static bool TVPTestNear(const char * what, tjs_uint frame, float value,
+	float expected, float tolerance)
+{
+	if(fabs(value - expected) <= tolerance) return true;
+	fprintf(stderr, "%s: frame %u is %.8f, expected %.8f\n", what, frame,
+		value, expected);
+	return false;
+}
+//---------------------------------------------------------------------------
+static void TVPTestResample(tjs_uint srcfreq, tjs_uint dstfreq, bool onebyone)
+{
+	// a stereo ramp (left rising, right falling) is resampled; linear
+	// interpolation gives the ramp itself at the output positions
+	const tjs_uint srcframes = 5000;
+	const float slope = 1.0f / 16384.0f;
+	tTVPTestFloatSource source(srcfreq, 2);
+	for(tjs_uint i = 0; i < srcframes; i++)
+	{
+		source.GetSamples().push_back(slope * i);
+		source.GetSamples().push_back(-slope * i);
+	}
+
+	tTVPTestCaptureOutput output;
+	tTVPSoftwareMixer mixer(dstfreq, &output);
+	tTVPSoftwareMixerVoice * voice = mixer.AddVoice(&source);
+	voice->Play();
+
+	// render until well after the end
+	tjs_uint dstframes = (tjs_uint)((tjs_uint64)srcframes * dstfreq / srcfreq);
+	TVPTestRenderInPieces(mixer, dstframes + 3000, onebyone);
+	TVP_CHECK(!voice->GetPlaying());
+
+	char what[64];
+	sprintf(what, "%u to %u%s", srcfreq, dstfreq,
+		onebyone ? ", one by one" : "");
+	double ratio = (double)srcfreq / dstfreq;
+	for(tjs_uint i = 0; i < dstframes + 3000; i++)
+	{
+		double pos = i * ratio;
+		if(pos <= srcframes - 1)
+		{
+			// inside the source
+			float expected = (float)(pos * slope);
+			if(!TVPTestNear(what, i, output.Samples[i*2], expected, 1e-5f) ||
+				!TVPTestNear(what, i, output.Samples[i*2+1], -expected, 1e-5f))
+			{
+				TVP_CHECK(!"resampled ramp");
+				return;
+			}
+		}
+		else if(pos >= srcframes + 1)
+		{
+			// after the end; the output position is in 32.32 fixed point,
+			// so the one at the end of the source may fall just before it
+			if(output.Samples[i*2] != 0.0f || output.Samples[i*2+1] != 0.0f)
+			{
+				fprintf(stderr, "%s: frame %u is not silent\n", what, i);
+				TVP_CHECK(!"silence after the end");
+				return;
+			}
+		}
+	}
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(mixer_resamples_at_any_ratio)
+{
+	static const struct { tjs_uint Source; tjs_uint Output; } ratios[] =
+	{
+		{ 44100, 44100 },
+		{ 22050, 44100 },
+		{ 11025, 44100 },
+		{ 48000, 44100 },
+		{ 32000, 48000 },
+		{ 96000, 44100 },
+		{ 44100, 8000 },
+		{ 44100, 11025 },
+		{ 48000, 8000 },
+	};
+	for(tjs_uint i = 0; i < sizeof(ratios) / sizeof(ratios[0]); i++)
+	{
+		TVPTestResample(ratios[i].Source, ratios[i].Output, false);
+		TVPTestResample(ratios[i].Source, ratios[i].Output, true);
+	}
+}
+//---------------------------------------------------------------------------
+TVP_TEST(mixer_folds_channels_into_stereo)
+{
+	// mono goes to both sides; with more channels, the even ones go to the
+	// left and the odd ones to the right, averaged
+	tTVPTestFloatSource mono(44100, 1), quad(44100, 4);
+	for(tjs_uint i = 0; i < 100; i++)
+	{
+		mono.GetSamples().push_back(0.25f);
+		static const float q[4] = { 0.5f, 0.25f, 0.1f, -0.75f };
+		quad.GetSamples().insert(quad.GetSamples().end(), q, q + 4);
+	}
+	tTVPTestCaptureOutput output;
+	tTVPSoftwareMixer mixer(44100, &output);
+	mixer.AddVoice(&mono)->Play();
+	tTVPSoftwareMixerVoice * voice = mixer.AddVoice(&quad);
+	voice->Play();
+	mixer.Render(100);
+	TVP_CHECK(TVPTestNear("left", 50, output.Samples[100], 0.25f + 0.3f, 1e-6f));
+	TVP_CHECK(TVPTestNear("right", 50, output.Samples[101], 0.25f - 0.25f, 1e-6f));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(mixer_pan_attenuates_the_other_side)
+{
+	static const struct { float Pan; float Left; float Right; } cases[] =
+	{
+		{ -1.0f, 1.0f, 0.0f },
+		{ -0.5f, 1.0f, 0.5f },
+		{ 0.0f, 1.0f, 1.0f },
+		{ 0.25f, 0.75f, 1.0f },
+		{ 1.0f, 0.0f, 1.0f },
+		{ 3.0f, 0.0f, 1.0f }, // clamped
+	};
+	for(tjs_uint c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+	{
+		tTVPTestFloatSource source(44100, 2);
+		source.GetSamples().assign(200, 0.5f);
+		tTVPTestCaptureOutput output;
+		tTVPSoftwareMixer mixer(44100, &output);
+		tTVPSoftwareMixerVoice * voice = mixer.AddVoice(&source);
+		voice->SetVolume(0.8f);
+		voice->SetPan(cases[c].Pan);
+		voice->Play();
+		mixer.Render(100);
+
+		TVP_CHECK(voice->GetPan() >= -1.0f && voice->GetPan() <= 1.0f);
+		TVP_CHECK(TVPTestNear("pan left", 50, output.Samples[100],
+			0.4f * cases[c].Left, 1e-6f));
+		TVP_CHECK(TVPTestNear("pan right", 50, output.Samples[101],
+			0.4f * cases[c].Right, 1e-6f));
+	}
+
+	// negative volume is silence
+	tTVPTestFloatSource source(44100, 2);
+	source.GetSamples().assign(200, 0.5f);
+	tTVPTestCaptureOutput output;
+	tTVPSoftwareMixer mixer(44100, &output);
+	tTVPSoftwareMixerVoice * voice = mixer.AddVoice(&source);
+	voice->SetVolume(-1.0f);
+	TVP_CHECK(voice->GetVolume() == 0.0f);
+	voice->Play();
+	mixer.Render(100);
+	TVP_CHECK(output.Samples[100] == 0.0f && output.Samples[101] == 0.0f);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(mixer_limiter_holds_the_peak_and_recovers)
+{
+	// two voices of 0.75 sum to 1.5, over the threshold of 1.0; the gain
+	// drops at once to 1/1.5, and after the loud voice stops it recovers as
+	// 1 - (1 - 1/1.5) * exp(-t / release)
+	const tjs_uint frequency = 44100;
+	const tjs_uint releasems = 10;
+	const float release = releasems * frequency / 1000.0f; // in frames
+
+	tTVPTestFloatSource loud(frequency, 2), quiet(frequency, 2);
+	loud.GetSamples().assign(2000 * 2, 0.75f);
+	quiet.GetSamples().assign(6000 * 2, 0.75f);
+	tTVPTestCaptureOutput output;
+	tTVPSoftwareMixer mixer(frequency, &output);
+	mixer.SetLimiter(1.0f, releasems);
+	tTVPSoftwareMixerVoice * loudvoice = mixer.AddVoice(&loud);
+	mixer.AddVoice(&quiet)->Play();
+	loudvoice->Play();
+
+	mixer.Render(1000);
+	for(tjs_uint i = 0; i < 1000; i++)
+	{
+		if(!TVPTestNear("limited", i, output.Samples[i*2], 1.0f, 1e-6f))
+		{
+			TVP_CHECK(!"limited peak");
+			break;
+		}
+	}
+
+	loudvoice->Stop();
+	mixer.Render(4000);
+	float gain = 1.0f / 1.5f;
+	for(tjs_uint i = 1000; i < 5000; i++)
+	{
+		float t = (float)(i - 1000 + 1);
+		float expected = 0.75f * (1.0f - (1.0f - gain) * (float)exp(-t / release));
+		if(!TVPTestNear("recovering", i, output.Samples[i*2], expected, 1e-4f))
+		{
+			TVP_CHECK(!"limiter release");
+			break;
+		}
+	}
+	TVP_CHECK(TVPTestNear("recovered", 4999, output.Samples[4999*2], 0.75f, 1e-4f));
+
+	// a lower threshold
+	mixer.SetLimiter(0.5f, releasems);
+	mixer.Render(10);
+	TVP_CHECK(TVPTestNear("threshold", 5009, output.Samples[5009*2], 0.5f, 1e-6f));
+}
+//---------------------------------------------------------------------------
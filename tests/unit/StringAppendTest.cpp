@@ -0,0 +1,237 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Tests of the in-place append of "v = v + ..." (GenAppendSubstitution)
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include "TVPTest.h"
+#include "ScriptMgnIntf.h"
+
+
+//---------------------------------------------------------------------------
+static void TVPTestExec(const tjs_char * script)
+{
+	TVPGetScriptEngine()->ExecScript(ttstr(script));
+}
+//---------------------------------------------------------------------------
+static bool TVPTestEvalIs(const tjs_char * expression,
+	const tjs_char * expected)
+{
+	// compares the result of the expression with "expected" as strings,
+	// and also the type, given as "type:value"
+	tTJSVariant result;
+	TVPGetScriptEngine()->EvalExpression(ttstr(expression), &result);
+	ttstr type;
+	switch(result.Type())
+	{
+	case tvtVoid:		type = TJS_W("void"); break;
+	case tvtObject:		type = TJS_W("object"); break;
+	case tvtString:		type = TJS_W("string"); break;
+	case tvtOctet:		type = TJS_W("octet"); break;
+	case tvtInteger:	type = TJS_W("int"); break;
+	case tvtReal:		type = TJS_W("real"); break;
+	}
+	ttstr value = type + TJS_W(":") + ttstr(result);
+	if(value == expected) return true;
+	fprintf(stderr, "%s is %s, expected %s\n",
+		ttstr(expression).AsNarrowStdString().c_str(),
+		value.AsNarrowStdString().c_str(),
+		ttstr(expected).AsNarrowStdString().c_str());
+	return false;
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(append_keeps_other_holders_of_the_string)
+{
+	TVPTestExec(TJS_W(
+		"function sa_shared()"
+		"{"
+		"	var a = 'abc';"
+		"	var b = a;"
+		"	global.sa_g = a;"
+		"	a = a + 'd';"
+		"	a = a + 'e' + 1;"
+		"	return [a, b, sa_g];"
+		"}"
+		"function sa_const()"
+		"{"
+		"	var a = 'const';"
+		"	a = a + '!';"
+		"	return a;"
+		"}"
+		"function sa_arg(s)"
+		"{"
+		"	s = s + 'x';"
+		"	return s;"
+		"}"));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_shared()[0]"), TJS_W("string:abcde1")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_shared()[1]"), TJS_W("string:abc")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_shared()[2]"), TJS_W("string:abc")));
+
+	// the constant in the code is not modified
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_const()"), TJS_W("string:const!")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_const()"), TJS_W("string:const!")));
+
+	// neither is the caller's string
+	TVPTestExec(TJS_W("global.sa_s = 'arg'; global.sa_r = sa_arg(sa_s);"));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_s"), TJS_W("string:arg")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_r"), TJS_W("string:argx")));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(append_to_numbers_and_void_adds)
+{
+	TVPTestExec(TJS_W(
+		"function sa_num1() { var v = 1; v = v + 2; return v; }"
+		"function sa_num2() { var v = 1.5; v = v + 2; return v; }"
+		"function sa_num3() { var v = 1; v = v + 'a' + 2; return v; }"
+		"function sa_num4() { var v = 1; var x = 2; v = v + x + 'a' + x; return v; }"
+		"function sa_num5() { var v = 1; v = v + 2 + 3; return v; }"
+		"function sa_void1() { var v; v = v + 'a'; return v; }"
+		"function sa_void2() { var v; v = v + 3; return v; }"
+		"function sa_void3() { var v; v = v + 'a' + 3; return v; }"
+		"function sa_loop()"
+		"{"
+		"	var v = 0;"
+		"	for(var i = 0; i < 10; i++) v = v + i;"
+		"	return v;"
+		"}"));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_num1()"), TJS_W("int:3")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_num2()"), TJS_W("real:3.5")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_num3()"), TJS_W("string:1a2")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_num4()"), TJS_W("string:3a2")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_num5()"), TJS_W("int:6")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_void1()"), TJS_W("string:a")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_void2()"), TJS_W("int:3")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_void3()"), TJS_W("string:a3")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_loop()"), TJS_W("int:45")));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(append_leaves_target_on_exception)
+{
+	TVPTestExec(TJS_W(
+		"function sa_throw() { throw new Exception('sa'); }"
+		"function sa_catch(kind)"
+		"{"
+		"	var v = 'base';"
+		"	var x = 'x';"
+		"	try"
+		"	{"
+		"		switch(kind)"
+		"		{"
+		"		case 0: v = v + sa_throw(); break;"
+		"		case 1: v = v + 'a' + sa_throw(); break;"
+		"		case 2: v = v + 'a' + x + sa_throw(); break;"
+		"		case 3: v = v + sa_throw() + 'b' + x; break;"
+		"		case 4: v = v + x + 'b' + sa_throw(); break;"
+		"		}"
+		"	}"
+		"	catch(e)"
+		"	{"
+		"		return v;"
+		"	}"
+		"	return 'not thrown';"
+		"}"
+		"function sa_catch_num()"
+		"{"
+		"	var v = 1.5;"
+		"	try { v = v + %[]; } catch(e) { return v; }"
+		"	return 'not thrown';"
+		"}"));
+	for(tjs_int kind = 0; kind <= 4; kind++)
+	{
+		tjs_char expr[32];
+		TJS_strcpy(expr, TJS_W("sa_catch(0)"));
+		expr[9] = (tjs_char)(TJS_W('0') + kind);
+		TVP_CHECK(TVPTestEvalIs(expr, TJS_W("string:base")));
+	}
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_catch_num()"), TJS_W("real:1.5")));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(append_keeps_evaluation_order)
+{
+	TVPTestExec(TJS_W(
+		"global.sa_log = '';"
+		"function sa_f(s) { sa_log += s; return s; }"
+		"function sa_order()"
+		"{"
+		"	var v = 'v';"
+		"	v = v + 'a' + sa_f('f') + sa_f('g') + 'b';"
+		"	return v;"
+		"}"
+		"function sa_order2()"
+		"{"
+		"	var v = 'v';"
+		"	var x = 'x';"
+		"	v = v + sa_f('f') + '-' + x + 1;"
+		"	return v;"
+		"}"
+		"global.sa_v = 'global';"
+		"function sa_set_v() { sa_v = 'changed'; return 'i'; }"
+		"function sa_shadow()"
+		"{"
+		"	var sa_v = 'v';"
+		"	sa_v = sa_v + 'a' + sa_set_v();"
+		"	return sa_v;"
+		"}"));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_order()"), TJS_W("string:vafgb")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_log"), TJS_W("string:fg")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_order2()"), TJS_W("string:vf-x1")));
+	// an operand can not modify the local variable, only the global one of
+	// the same name
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_shadow()"), TJS_W("string:vai")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_v"), TJS_W("string:changed")));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(append_to_member_is_not_rewritten)
+{
+	// "o.v = o.v + x" calls the getter, evaluates the operands and calls the
+	// setter, in this order, and the operands see the old value
+	TVPTestExec(TJS_W(
+		"class SAProp"
+		"{"
+		"	var log = '';"
+		"	var value = 'p';"
+		"	property v"
+		"	{"
+		"		getter { log += 'get,'; return value; }"
+		"		setter(x) { log += 'set(' + x + '),'; value = x; }"
+		"	}"
+		"	function f(s) { log += s + ','; value = 'changed'; return s; }"
+		"}"
+		"function sa_prop()"
+		"{"
+		"	var o = new SAProp();"
+		"	o.v = o.v + 'a' + o.f('f');"
+		"	return o.log + o.value;"
+		"}"
+		"function sa_member()" // the object is looked up after the operands
+		"{"
+		"	var o = %[ m : 'm' ];"
+		"	var p = o;"
+		"	o.m = o.m + (o = %[ m : 'other' ], 'a');"
+		"	return p.m + ',' + o.m;"
+		"}"
+		"function sa_member_throw()"
+		"{"
+		"	var o = %[ m : 'm' ];"
+		"	try { o.m = o.m + 'a' + sa_throw2(); } catch(e) { return o.m; }"
+		"	return 'not thrown';"
+		"}"
+		"function sa_throw2() { throw new Exception('sa'); }"));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_prop()"),
+		TJS_W("string:get,f,set(paf),paf")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_member()"), TJS_W("string:m,ma")));
+	TVP_CHECK(TVPTestEvalIs(TJS_W("sa_member_throw()"), TJS_W("string:m")));
+}
+//---------------------------------------------------------------------------
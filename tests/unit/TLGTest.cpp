@@ -0,0 +1,194 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// TLG5/6 loader and saver tests
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <string.h>
+#include "TVPTest.h"
+#include "GraphicsLoaderIntf.h"
+#include "LayerBitmapIntf.h"
+#include "UtilStreams.h"
+
+
+//---------------------------------------------------------------------------
+static void TVPTestFillImage(tTVPBaseBitmap & bmp, tjs_uint32 seed)
+{
+	// gradients with noise and a varying alpha; not too easy to compress
+	tjs_uint32 r = seed;
+	for(tjs_uint y = 0; y < bmp.GetHeight(); y++)
+	{
+		tjs_uint32 * line = (tjs_uint32 *)bmp.GetScanLineForWrite(y);
+		for(tjs_uint x = 0; x < bmp.GetWidth(); x++)
+		{
+			r = r * 1103515245 + 12345;
+			tjs_uint32 noise = (r >> 16) & 0x0f;
+			tjs_uint32 b = (x + noise) & 0xff;
+			tjs_uint32 g = (y * 2 + noise) & 0xff;
+			tjs_uint32 rr = ((x ^ y) + noise) & 0xff;
+			tjs_uint32 a = ((x + y) / 4) & 0xff;
+			line[x] = b + (g << 8) + (rr << 16) + (a << 24);
+		}
+	}
+}
+//---------------------------------------------------------------------------
+static void TVPTestSizeCallback(void *callbackdata,
+	tjs_uint w, tjs_uint h)
+{
+	tTVPBaseBitmap ** bmp = (tTVPBaseBitmap **)callbackdata;
+	*bmp = new tTVPBaseBitmap(w, h, 32);
+}
+//---------------------------------------------------------------------------
+static void * TVPTestScanLineCallback(void *callbackdata,
+	tjs_int y)
+{
+	if(y < 0) return NULL;
+	tTVPBaseBitmap ** bmp = (tTVPBaseBitmap **)callbackdata;
+	return (*bmp)->GetScanLineForWrite(y);
+}
+//---------------------------------------------------------------------------
+static tTVPBaseBitmap * TVPTestLoadTLG(tTVPMemoryStream & stream)
+{
+	tTVPBaseBitmap * bmp = NULL;
+	stream.SetPosition(0);
+	try
+	{
+		TVPLoadTLG(NULL, &bmp, TVPTestSizeCallback, TVPTestScanLineCallback,
+			NULL, &stream, -1, glmNormal);
+	}
+	catch(...)
+	{
+		delete bmp;
+		throw;
+	}
+	return bmp;
+}
+//---------------------------------------------------------------------------
+static bool TVPTestSameImage(const tTVPBaseBitmap & a, const tTVPBaseBitmap & b,
+	tjs_uint32 mask = 0xffffffff)
+{
+	// compares the pixels of a and b, only the bits in mask
+	if(a.GetWidth() != b.GetWidth() || a.GetHeight() != b.GetHeight())
+		return false;
+	for(tjs_uint y = 0; y < a.GetHeight(); y++)
+	{
+		const tjs_uint32 * la = (const tjs_uint32 *)a.GetScanLine(y);
+		const tjs_uint32 * lb = (const tjs_uint32 *)b.GetScanLine(y);
+		for(tjs_uint x = 0; x < a.GetWidth(); x++)
+			if((la[x] ^ lb[x]) & mask) return false;
+	}
+	return true;
+}
+//---------------------------------------------------------------------------
+static void TVPTestSaveTLG(tTVPMemoryStream & stream, const tTVPBaseBitmap & bmp,
+	const tjs_char * mode, tjs_int drawthreads)
+{
+	tjs_int org = TVPDrawThreadNum;
+	TVPDrawThreadNum = drawthreads;
+	try
+	{
+		TVPSaveAsTLG(NULL, &stream, &bmp, mode, NULL);
+	}
+	catch(...)
+	{
+		TVPDrawThreadNum = org;
+		throw;
+	}
+	TVPDrawThreadNum = org;
+}
+//---------------------------------------------------------------------------
+static void TVPTestRoundTrip(const tjs_char * mode, tjs_uint32 mask)
+{
+	// the decoded image of the encoded image must be the source image
+	tTVPBaseBitmap src(300, 300, 32);
+	TVPTestFillImage(src, 2);
+	tTVPMemoryStream stream;
+	TVPTestSaveTLG(stream, src, mode, 1);
+	tTVPBaseBitmap * dest = TVPTestLoadTLG(stream);
+	TVP_CHECK(TVPTestSameImage(*dest, src, mask));
+	if(mask != 0xffffffff)
+	{
+		// the alpha of 24bit images is opaque
+		tTVPBaseBitmap opaque(300, 300, 32);
+		for(tjs_uint y = 0; y < 300; y++)
+			for(tjs_uint x = 0; x < 300; x++)
+				((tjs_uint32 *)opaque.GetScanLineForWrite(y))[x] = ~mask;
+		TVP_CHECK(TVPTestSameImage(*dest, opaque, ~mask));
+	}
+	delete dest;
+}
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(tlg6_parallel_decode_matches_serial)
+{
+	// the width is not a multiple of the block size, and the block rows are
+	// more than the workers, so every path of the parallel decoder runs
+	tTVPBaseBitmap src(517, 389, 32);
+	TVPTestFillImage(src, 1);
+	tTVPMemoryStream stream;
+	TVPSaveAsTLG(NULL, &stream, &src, TJS_W("tlg6"), NULL);
+
+	tjs_int drawthreads = TVPDrawThreadNum;
+	bool parallel = TVPTLG6ParallelDecode;
+	tTVPBaseBitmap * serial = NULL;
+	tTVPBaseBitmap * threaded = NULL;
+	try
+	{
+		TVPDrawThreadNum = 1;
+		serial = TVPTestLoadTLG(stream);
+		TVPDrawThreadNum = 4;
+		TVPTLG6ParallelDecode = true;
+		threaded = TVPTestLoadTLG(stream);
+
+		TVP_CHECK(TVPTestSameImage(*serial, src));
+		TVP_CHECK(TVPTestSameImage(*threaded, *serial));
+	}
+	catch(...)
+	{
+		TVPDrawThreadNum = drawthreads;
+		TVPTLG6ParallelDecode = parallel;
+		delete serial;
+		delete threaded;
+		throw;
+	}
+	TVPDrawThreadNum = drawthreads;
+	TVPTLG6ParallelDecode = parallel;
+	delete serial;
+	delete threaded;
+}
+//---------------------------------------------------------------------------
+TVP_TEST(tlg6_parallel_encode_matches_serial)
+{
+	// the block rows compressed on the draw threads are concatenated in
+	// order; the output must be byte-identical to the single threaded one
+	tTVPBaseBitmap src(517, 389, 32);
+	TVPTestFillImage(src, 3);
+	tTVPMemoryStream serial, threaded;
+	TVPTestSaveTLG(serial, src, TJS_W("tlg6"), 1);
+	TVPTestSaveTLG(threaded, src, TJS_W("tlg6"), 4);
+	TVP_CHECK(serial.GetSize() == threaded.GetSize());
+	TVP_CHECK(!memcmp(serial.GetInternalBuffer(), threaded.GetInternalBuffer(),
+		(size_t)serial.GetSize()));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(tlg6_round_trip)
+{
+	TVPTestRoundTrip(TJS_W("tlg6"), 0xffffffff);
+	TVPTestRoundTrip(TJS_W("tlg624"), 0x00ffffff);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(tlg5_round_trip)
+{
+	TVPTestRoundTrip(TJS_W("tlg5"), 0xffffffff);
+	TVPTestRoundTrip(TJS_W("tlg524"), 0x00ffffff);
+}
+//---------------------------------------------------------------------------
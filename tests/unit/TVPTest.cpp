@@ -0,0 +1,77 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Unit test driver for the headless build
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "tjsError.h"
+#include "TVPTest.h"
+#include "HeadlessHost.h"
+
+
+//---------------------------------------------------------------------------
+static tTVPTestCase * TVPTestCases = NULL;
+static tTVPTestCase * TVPTestCasesLast = NULL;
+static const char * TVPTestCurrentCase = "";
+static int TVPTestFailures = 0;
+//---------------------------------------------------------------------------
+tTVPTestCase::tTVPTestCase(const char * name, tTVPTestProc proc)
+{
+	// keep the order of the registration (in the order in the file)
+	Name = name;
+	Proc = proc;
+	Next = NULL;
+	if(TVPTestCasesLast) TVPTestCasesLast->Next = this;
+	else TVPTestCases = this;
+	TVPTestCasesLast = this;
+}
+//---------------------------------------------------------------------------
+void TVPTestFail(const char * file, int line, const char * expr)
+{
+	fprintf(stderr, "%s:%d: %s: check failed: %s\n", file, line,
+		TVPTestCurrentCase, expr);
+	TVPTestFailures++;
+}
+//---------------------------------------------------------------------------
+int main(int argc, char ** argv)
+{
+	TVPInitHeadlessHost();
+	TVPHeadlessLogQuiet = true;
+
+	int cases = 0;
+	for(tTVPTestCase * c = TVPTestCases; c; c = c->Next)
+	{
+		if(argc > 1 && strcmp(argv[1], c->Name)) continue;
+		TVPTestCurrentCase = c->Name;
+		cases++;
+		try
+		{
+			c->Proc();
+		}
+		catch(const eTJS & e)
+		{
+			fprintf(stderr, "%s: %s\n", c->Name,
+				e.GetMessage().AsNarrowStdString().c_str());
+			TVPTestFailures++;
+		}
+		catch(...)
+		{
+			fprintf(stderr, "%s: unknown exception\n", c->Name);
+			TVPTestFailures++;
+		}
+	}
+
+	TVPUninitHeadlessHost();
+
+	printf("%d case(s), %d failure(s)\n", cases, TVPTestFailures);
+	return TVPTestFailures ? 1 : 0;
+}
+//---------------------------------------------------------------------------
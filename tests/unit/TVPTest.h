@@ -0,0 +1,42 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Unit test driver for the headless build
+//---------------------------------------------------------------------------
+/*
+	Each test file is built into its own executable with TVPTest.cpp, and
+	registered to ctest. Test cases are functions registered by TVP_TEST;
+	TVP_CHECK records a failure and continues the case, and the executable
+	returns non-zero if any check has failed or any case has thrown.
+*/
+#ifndef TVPTestH
+#define TVPTestH
+
+#include "tjsTypes.h"
+
+//---------------------------------------------------------------------------
+typedef void (*tTVPTestProc)();
+struct tTVPTestCase
+{
+	const char * Name;
+	tTVPTestProc Proc;
+	tTVPTestCase * Next;
+
+	tTVPTestCase(const char * name, tTVPTestProc proc);
+};
+#define TVP_TEST(name) \
+	static void TVPTestCase_##name(); \
+	static tTVPTestCase TVPTestCaseRegister_##name(#name, TVPTestCase_##name); \
+	static void TVPTestCase_##name()
+//---------------------------------------------------------------------------
+extern void TVPTestFail(const char * file, int line, const char * expr);
+#define TVP_CHECK(cond) \
+	do { if(!(cond)) TVPTestFail(__FILE__, __LINE__, #cond); } while(0)
+//---------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,482 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Typed array tests
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "TVPTest.h"
+#include "ScriptMgnIntf.h"
+#include "tjsDictionary.h"
+#include "tjsTypedArray.h"
+
+
+//---------------------------------------------------------------------------
+struct tTVPTestTypedArrayClass
+{
+	const tjs_char * Name;
+	tjs_int Size; // bytes per element
+};
+static const tTVPTestTypedArrayClass TVPTestTypedArrayClasses[] =
+{
+	{ TJS_W("Int8Array"), 1 },
+	{ TJS_W("Uint8Array"), 1 },
+	{ TJS_W("Uint8ClampedArray"), 1 },
+	{ TJS_W("Int16Array"), 2 },
+	{ TJS_W("Uint16Array"), 2 },
+	{ TJS_W("Int32Array"), 4 },
+	{ TJS_W("Uint32Array"), 4 },
+	{ TJS_W("Float32Array"), 4 },
+	{ TJS_W("Float64Array"), 8 },
+};
+#define TVP_TEST_TYPEDARRAY_CLASSES \
+	(sizeof(TVPTestTypedArrayClasses) / sizeof(TVPTestTypedArrayClasses[0]))
+//---------------------------------------------------------------------------
+static ttstr TVPTestScript(const tjs_char * script, const tjs_char * name)
+{
+	// replaces '$' in the script with the class name
+	ttstr result;
+	for(const tjs_char *p = script; *p; p++)
+	{
+		if(*p == TJS_W('$'))
+			result += name;
+		else
+			result += *p;
+	}
+	return result;
+}
+//---------------------------------------------------------------------------
+static void TVPTestExec(const tjs_char * script,
+	const tjs_char * name = TJS_W(""))
+{
+	TVPGetScriptEngine()->ExecScript(TVPTestScript(script, name));
+}
+//---------------------------------------------------------------------------
+static tTVReal TVPTestEvalReal(const tjs_char * expression,
+	const tjs_char * name = TJS_W(""))
+{
+	tTJSVariant result;
+	TVPGetScriptEngine()->EvalExpression(TVPTestScript(expression, name),
+		&result);
+	return result.AsReal();
+}
+//---------------------------------------------------------------------------
+static bool TVPTestThrows(const tjs_char * script,
+	const tjs_char * name = TJS_W(""))
+{
+	try
+	{
+		TVPTestExec(script, name);
+	}
+	catch(eTJS &)
+	{
+		return true;
+	}
+	fprintf(stderr, "%s: did not throw: %s\n",
+		ttstr(name).AsNarrowStdString().c_str(),
+		ttstr(script).AsNarrowStdString().c_str());
+	return false;
+}
+//---------------------------------------------------------------------------
+static bool TVPTestEquals(const tjs_char * expression, tTVReal expected,
+	const tjs_char * name = TJS_W(""))
+{
+	tTVReal value = TVPTestEvalReal(expression, name);
+	if(value == expected || (value != value && expected != expected))
+		return true;
+	fprintf(stderr, "%s: %s is %.17g, expected %.17g\n",
+		ttstr(name).AsNarrowStdString().c_str(),
+		ttstr(expression).AsNarrowStdString().c_str(), value, expected);
+	return false;
+}
+//---------------------------------------------------------------------------
+// tTVPTestImageSource : an image of rows, as Layer and Bitmap give
+//---------------------------------------------------------------------------
+class tTVPTestImageSource : public iTJSTypedArrayBufferSource
+{
+	std::vector<tjs_uint8> Pixels;
+
+public:
+	iTJSDispatch2 * Object; // the object which has this image
+	tjs_int RowBytes;
+	tjs_int Pitch;
+	tjs_int Rows;
+	bool HasBuffer;
+	tjs_int WriteRequests;
+
+	tTVPTestImageSource()
+	{
+		Object = TJSCreateDictionaryObject();
+		RowBytes = Pitch = Rows = 0;
+		HasBuffer = true;
+		WriteRequests = 0;
+		tTJSVariant val(Object, Object);
+		TVPGetScriptEngine()->GetGlobalNoAddRef()->PropSet(TJS_MEMBERENSURE,
+			TJS_W("ta_image"), NULL, &val, NULL);
+		TJSAddTypedArrayBufferSource(this);
+	}
+
+	~tTVPTestImageSource()
+	{
+		TJSRemoveTypedArrayBufferSource(this);
+		TVPGetScriptEngine()->GetGlobalNoAddRef()->DeleteMember(0,
+			TJS_W("ta_image"), NULL, NULL);
+		Object->Release();
+	}
+
+	void Resize(tjs_int rowbytes, tjs_int pitch, tjs_int rows)
+	{
+		// a negative pitch makes the image bottom-up, as DIBs are
+		RowBytes = rowbytes;
+		Pitch = pitch;
+		Rows = rows;
+		Pixels.assign((pitch < 0 ? -pitch : pitch) * rows, 0);
+	}
+
+	tjs_uint8 * GetRow(tjs_int row)
+	{
+		tjs_uint8 *first = &Pixels[0];
+		if(Pitch < 0) first += (Rows - 1) * -Pitch;
+		return first + row * Pitch;
+	}
+
+	tjs_int GetRefCount()
+	{
+		tjs_int count = Object->AddRef();
+		Object->Release();
+		return count - 1;
+	}
+
+	bool GetBuffer(iTJSDispatch2 *obj, bool forwrite,
+		tTJSTypedArrayBuffer &buffer)
+	{
+		if(obj != Object) return false;
+		if(forwrite) WriteRequests++;
+		buffer.Data = HasBuffer ? GetRow(0) : NULL;
+		buffer.RowBytes = RowBytes;
+		buffer.Pitch = Pitch;
+		buffer.Rows = Rows;
+		return true;
+	}
+};
+//---------------------------------------------------------------------------
+static bool TVPTestOctetMatches(const tjs_char * expression,
+	const tjs_uint8 * expected, tjs_int bytes)
+{
+	tTJSVariant result;
+	TVPGetScriptEngine()->EvalExpression(ttstr(expression), &result);
+	tTJSVariantOctet *oct = result.AsOctetNoAddRef();
+	if(!oct) return bytes == 0;
+	return (tjs_int)oct->GetLength() == bytes &&
+		!memcmp(oct->GetData(), expected, bytes);
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(typedarray_get_set)
+{
+	for(tjs_uint i = 0; i < TVP_TEST_TYPEDARRAY_CLASSES; i++)
+	{
+		const tjs_char *name = TVPTestTypedArrayClasses[i].Name;
+		TVPTestExec(TJS_W("global.ta_a = new $(4);"), name);
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a.count"), 4, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a.bytesPerElement"),
+			TVPTestTypedArrayClasses[i].Size, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[0] + ta_a[3]"), 0, name));
+
+		TVPTestExec(TJS_W("ta_a[0] = 1; ta_a[3] = 100; ta_a[-2] = 7;"));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[0]"), 1, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[1]"), 0, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[2]"), 7, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[-1]"), 100, name));
+		TVPTestExec(TJS_W("ta_a[2] += 3; ta_a[0]++;"));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[2]"), 10, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[0]"), 2, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a.sum()"), 112, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a.find(100)"), 3, name));
+
+		// the count keeps the elements and fills the new ones with zero
+		TVPTestExec(TJS_W("ta_a.count = 2; ta_a.count = 3;"));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[0]"), 2, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[2]"), 0, name));
+	}
+}
+//---------------------------------------------------------------------------
+TVP_TEST(typedarray_out_of_range)
+{
+	for(tjs_uint i = 0; i < TVP_TEST_TYPEDARRAY_CLASSES; i++)
+	{
+		const tjs_char *name = TVPTestTypedArrayClasses[i].Name;
+		TVPTestExec(TJS_W("global.ta_a = new $(4);"), name);
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a[4];"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a[-5];"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a[4] = 1;"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a[4] += 1;"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a.fill(1, 2, 3);"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a.sum(5);"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a.toOctet(1, 4);"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a.copy([1, 2], 3);"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a.count = -1;"), name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a.count"), 4, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a.sum()"), 0, name));
+	}
+}
+//---------------------------------------------------------------------------
+TVP_TEST(typedarray_wrap_and_clamp)
+{
+	static const struct
+	{
+		const tjs_char * Class;
+		const tjs_char * Value;
+		tTVReal Expected;
+	} cases[] =
+	{
+		// integers wrap around, and reals are truncated
+		{ TJS_W("Int8Array"), TJS_W("127"), 127 },
+		{ TJS_W("Int8Array"), TJS_W("128"), -128 },
+		{ TJS_W("Int8Array"), TJS_W("-129"), 127 },
+		{ TJS_W("Int8Array"), TJS_W("-1.9"), -1 },
+		{ TJS_W("Uint8Array"), TJS_W("256"), 0 },
+		{ TJS_W("Uint8Array"), TJS_W("-1"), 255 },
+		{ TJS_W("Uint8Array"), TJS_W("255.9"), 255 },
+		{ TJS_W("Int16Array"), TJS_W("32768"), -32768 },
+		{ TJS_W("Int16Array"), TJS_W("-32769"), 32767 },
+		{ TJS_W("Int16Array"), TJS_W("65537"), 1 },
+		{ TJS_W("Uint16Array"), TJS_W("65536"), 0 },
+		{ TJS_W("Uint16Array"), TJS_W("-1"), 65535 },
+		{ TJS_W("Int32Array"), TJS_W("2147483648"), -2147483648.0 },
+		{ TJS_W("Int32Array"), TJS_W("4294967297"), 1 },
+		{ TJS_W("Int32Array"), TJS_W("-2.5"), -2 },
+		{ TJS_W("Uint32Array"), TJS_W("-1"), 4294967295.0 },
+		{ TJS_W("Uint32Array"), TJS_W("4294967296"), 0 },
+		// Uint8ClampedArray clamps, and rounds to the nearest even on ties
+		{ TJS_W("Uint8ClampedArray"), TJS_W("256"), 255 },
+		{ TJS_W("Uint8ClampedArray"), TJS_W("100000"), 255 },
+		{ TJS_W("Uint8ClampedArray"), TJS_W("-1"), 0 },
+		{ TJS_W("Uint8ClampedArray"), TJS_W("-0.4"), 0 },
+		{ TJS_W("Uint8ClampedArray"), TJS_W("0.5"), 0 },
+		{ TJS_W("Uint8ClampedArray"), TJS_W("1.5"), 2 },
+		{ TJS_W("Uint8ClampedArray"), TJS_W("2.5"), 2 },
+		{ TJS_W("Uint8ClampedArray"), TJS_W("2.51"), 3 },
+		{ TJS_W("Uint8ClampedArray"), TJS_W("254.6"), 255 },
+		{ TJS_W("Uint8ClampedArray"), TJS_W("'3.5'"), 4 },
+		{ TJS_W("Uint8ClampedArray"), TJS_W("NaN"), 0 },
+		// reals are rounded to the precision of the element
+		{ TJS_W("Float32Array"), TJS_W("0.1"), (float)0.1 },
+		{ TJS_W("Float32Array"), TJS_W("16777217"), 16777216 },
+		{ TJS_W("Float32Array"), TJS_W("1e40"), HUGE_VAL },
+		{ TJS_W("Float32Array"), TJS_W("NaN"), NAN },
+		{ TJS_W("Float64Array"), TJS_W("0.1"), 0.1 },
+		{ TJS_W("Float64Array"), TJS_W("9007199254740993"), 9007199254740992.0 },
+		{ TJS_W("Float64Array"), TJS_W("-Infinity"), -HUGE_VAL },
+	};
+
+	for(tjs_uint i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		const tjs_char *name = cases[i].Class;
+		ttstr script = TJS_W("global.ta_a = new $(2); ta_a[1] = ");
+		script += cases[i].Value;
+		script += TJS_W("; ta_a.fill(");
+		script += cases[i].Value;
+		script += TJS_W(", 0, 1);");
+		TVPTestExec(script.c_str(), name);
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[1]"), cases[i].Expected, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[0]"), cases[i].Expected, name));
+
+		// the conversion from an Array is the same
+		script = TJS_W("global.ta_a = new $([");
+		script += cases[i].Value;
+		script += TJS_W("]);");
+		TVPTestExec(script.c_str(), name);
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[0]"), cases[i].Expected, name));
+	}
+
+	// a conversion between typed arrays clamps as well
+	TVPTestExec(TJS_W(
+		"global.ta_a = new Uint8ClampedArray(new Float64Array([-3, 127.5, 1000]));"));
+	TVP_CHECK(TVPTestEquals(TJS_W("ta_a[0]"), 0));
+	TVP_CHECK(TVPTestEquals(TJS_W("ta_a[1]"), 128));
+	TVP_CHECK(TVPTestEquals(TJS_W("ta_a[2]"), 255));
+	TVPTestExec(TJS_W("ta_a.copy(new Int16Array([-1, 300]), 1);"));
+	TVP_CHECK(TVPTestEquals(TJS_W("ta_a[1]"), 0));
+	TVP_CHECK(TVPTestEquals(TJS_W("ta_a[2]"), 255));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(typedarray_subarray)
+{
+	for(tjs_uint i = 0; i < TVP_TEST_TYPEDARRAY_CLASSES; i++)
+	{
+		const tjs_char *name = TVPTestTypedArrayClasses[i].Name;
+		TVPTestExec(TJS_W(
+			"global.ta_a = new $([1, 2, 3, 4]);"
+			"global.ta_s = ta_a.subarray(1, 2);"), name);
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s.count"), 2, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s.attached"), 1, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s instanceof '$'"), 1, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s[0]"), 2, name));
+
+		// the view shares the elements
+		TVPTestExec(TJS_W("ta_s[0] = 5; ta_a[2] = 9;"));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[1]"), 5, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s[1]"), 9, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s.sum()"), 14, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s.subarray(1)[0]"), 9, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a.subarray(4).count"), 0, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a.subarray(-1)[0]"), 4, name));
+
+		// overlapping copies behave as memmove
+		TVPTestExec(TJS_W("ta_a.copy(ta_a.subarray(0, 3), 1);"));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_a[1] * 100 + ta_a[2] * 10 + ta_a[3]"),
+			159, name));
+
+		// the range of a view is fixed
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_s[2];"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_s[2] = 1;"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_s.count = 3;"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_s.assign([1]);"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a.subarray(3, 2);"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a.subarray(5);"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a.subarray(0, 5);"), name));
+
+		// an array can not be a view of itself
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a.attach(ta_a);"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a.attach(ta_s);"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_s.attach(ta_s.subarray());"), name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s[1]"), 5, name));
+	}
+}
+//---------------------------------------------------------------------------
+TVP_TEST(typedarray_view_follows_the_target)
+{
+	for(tjs_uint i = 0; i < TVP_TEST_TYPEDARRAY_CLASSES; i++)
+	{
+		const tjs_char *name = TVPTestTypedArrayClasses[i].Name;
+		TVPTestExec(TJS_W(
+			"global.ta_a = new $([1, 2, 3, 4]);"
+			"global.ta_s = ta_a.subarray(1, 2);"), name);
+
+		// the view checks every access against the current elements of the
+		// target
+		TVPTestExec(TJS_W("ta_a.count = 2;"));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_s[0];"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_s[1] = 1;"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_s.sum();"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_s.toArray();"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_s.sort();"), name));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_a.copy(ta_s);"), name));
+		TVPTestExec(TJS_W("ta_a.count = 4;"));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s[0]"), 2, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s[1]"), 0, name));
+
+		// ... and fails after the target is invalidated
+		TVPTestExec(TJS_W("invalidate ta_a;"));
+		TVP_CHECK(TVPTestThrows(TJS_W("ta_s[0];"), name));
+
+		// the view holds the target
+		TVPTestExec(TJS_W(
+			"global.ta_s = (new $([1, 2, 3])).subarray(1);"
+			"ta_s[1] = 7;"), name);
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s[0] + ta_s[1]"), 9, name));
+
+		// detach leaves an empty array which owns its elements again
+		TVPTestExec(TJS_W("ta_s.detach(); ta_s.count = 2;"));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s.attached"), 0, name));
+		TVP_CHECK(TVPTestEquals(TJS_W("ta_s.count"), 2, name));
+	}
+}
+//---------------------------------------------------------------------------
+TVP_TEST(typedarray_attach_image_rows)
+{
+	tTVPTestImageSource image;
+	for(tjs_uint i = 0; i < TVP_TEST_TYPEDARRAY_CLASSES; i++)
+	{
+		const tjs_char *name = TVPTestTypedArrayClasses[i].Name;
+		tjs_int size = TVPTestTypedArrayClasses[i].Size;
+
+		for(tjs_int bottomup = 0; bottomup < 2; bottomup++)
+		{
+			// rows of 16 bytes, with padding
+			image.Resize(16, bottomup ? -24 : 24, 3);
+			image.HasBuffer = true;
+			tjs_int refs = image.GetRefCount();
+
+			TVPTestExec(TJS_W("global.ta_v = new $(); ta_v.attach(ta_image, 1);"),
+				name);
+			TVP_CHECK(TVPTestEquals(TJS_W("ta_v.count"), 16 / size, name));
+			TVP_CHECK(image.GetRefCount() == refs + 1);
+
+			// the view reads and writes the row
+			for(tjs_int b = 0; b < 16; b++) image.GetRow(1)[b] = (tjs_uint8)(b * 3);
+			TVP_CHECK(TVPTestOctetMatches(TJS_W("ta_v.toOctet()"),
+				image.GetRow(1), 16));
+			tjs_int writes = image.WriteRequests;
+			TVP_CHECK(TVPTestEquals(TJS_W("ta_v.sum() - ta_v.sum()"), 0, name));
+			TVP_CHECK(image.WriteRequests == writes); // reading is not writing
+			TVPTestExec(TJS_W("ta_v.fill(0); ta_v[-1] = 1;"));
+			TVP_CHECK(image.WriteRequests > writes);
+			static const tjs_uint8 zero[24] = { 0 };
+			TVP_CHECK(!memcmp(image.GetRow(0), zero, 16));
+			TVP_CHECK(!memcmp(image.GetRow(1), zero, 16 - size));
+			TVP_CHECK(memcmp(image.GetRow(1) + 16 - size, zero, size) != 0);
+			TVP_CHECK(!memcmp(image.GetRow(2), zero, 16));
+
+			// a range of a row
+			TVPTestExec(TJS_W("ta_v.attach(ta_image, 2, 1, 1); ta_v[0] = 1;"));
+			TVP_CHECK(TVPTestEquals(TJS_W("ta_v.count"), 1, name));
+			TVP_CHECK(memcmp(image.GetRow(2) + size, zero, size) != 0);
+			TVP_CHECK(!memcmp(image.GetRow(2), zero, size));
+			TVP_CHECK(!memcmp(image.GetRow(2) + size * 2, zero, 16 - size * 2));
+			TVP_CHECK(TVPTestThrows(TJS_W("ta_v[1];"), name));
+
+			// a range which is not in the image
+			TVP_CHECK(TVPTestThrows(TJS_W("ta_v.attach(ta_image, 3);"), name));
+			TVP_CHECK(TVPTestThrows(TJS_W("ta_v.attach(ta_image, -1);"), name));
+			TVP_CHECK(TVPTestThrows(TJS_W("ta_v.attach(ta_image, 0, -1);"), name));
+			TVP_CHECK(TVPTestThrows(TJS_W("ta_v.attach(ta_image, 0, 0, 17);"),
+				name));
+			TVP_CHECK(TVPTestThrows(TJS_W("ta_v.attach(%[]);"), name));
+			TVP_CHECK(TVPTestEquals(TJS_W("ta_v.count"), 1, name));
+
+			// every access is checked against the current image
+			TVPTestExec(TJS_W("ta_v.attach(ta_image, 1);"));
+			image.Resize(8, bottomup ? -24 : 24, 3);
+			TVP_CHECK(TVPTestThrows(TJS_W("ta_v[0];"), name));
+			image.Resize(16, bottomup ? -16 : 16, 1);
+			TVP_CHECK(TVPTestThrows(TJS_W("ta_v[0] = 1;"), name));
+			image.Resize(16, bottomup ? -16 : 16, 2);
+			TVP_CHECK(TVPTestEquals(TJS_W("ta_v[0]"), 0, name));
+			image.HasBuffer = false;
+			TVP_CHECK(TVPTestThrows(TJS_W("ta_v.toArray();"), name));
+			image.HasBuffer = true;
+			TVP_CHECK(TVPTestEquals(TJS_W("ta_v.sum()"), 0, name));
+
+			if(size > 1)
+			{
+				// rows which are not aligned to the element
+				image.Resize(16, bottomup ? -17 : 17, 3);
+				TVP_CHECK(TVPTestThrows(TJS_W("ta_v[0];"), name));
+				TVP_CHECK(TVPTestThrows(TJS_W("ta_v.attach(ta_image, 1);"),
+					name));
+				image.Resize(16, bottomup ? -24 : 24, 3);
+			}
+
+			TVPTestExec(TJS_W("ta_v.detach();"));
+			TVP_CHECK(image.GetRefCount() == refs);
+			TVPTestExec(TJS_W("ta_v.attach(ta_image); invalidate ta_v;"));
+			TVP_CHECK(image.GetRefCount() == refs);
+		}
+	}
+}
+//---------------------------------------------------------------------------
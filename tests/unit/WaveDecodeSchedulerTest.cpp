@@ -0,0 +1,197 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Wave decoding scheduler tests
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <string>
+#include <thread>
+#include <chrono>
+#include "TVPTest.h"
+#include "WaveDecodeScheduler.h"
+
+
+//---------------------------------------------------------------------------
+// tTVPTestDecodeTarget : a buffer which only counts its units
+//---------------------------------------------------------------------------
+static volatile bool TVPTestDecodeHold = false;
+	// while true, every target reports that its buffer is full
+static tTJSCriticalSection TVPTestDecodeLogCS;
+static std::string TVPTestDecodeLog;
+	// names of the targets, in the order of decoding
+//---------------------------------------------------------------------------
+class tTVPTestDecodeTarget : public iTVPWaveDecodeTarget
+{
+	char Name;
+	tjs_int Units;
+	tjs_int DecodeTime; // in ms
+
+public:
+	volatile tjs_int Remain;
+	volatile tjs_int Decoded;
+	volatile bool InDecode;
+
+	tTVPTestDecodeTarget(char name, tjs_int remain, tjs_int units,
+		tjs_int decodetime = 0)
+	{
+		Name = name;
+		Units = units;
+		DecodeTime = decodetime;
+		Remain = remain;
+		Decoded = 0;
+		InDecode = false;
+	}
+
+	void GetDecodeStatus(tjs_int &remain, tjs_int &units)
+	{
+		remain = TVPTestDecodeHold ? Units : Remain;
+		units = Units;
+	}
+
+	bool DecodeUnit()
+	{
+		if(Remain >= Units) return false;
+		InDecode = true;
+		if(DecodeTime)
+			std::this_thread::sleep_for(std::chrono::milliseconds(DecodeTime));
+		{
+			tTJSCriticalSectionHolder holder(TVPTestDecodeLogCS);
+			TVPTestDecodeLog += Name;
+		}
+		Remain = Remain + 1;
+		Decoded = Decoded + 1;
+		InDecode = false;
+		return true;
+	}
+
+	bool IsFull() const { return Remain >= Units; }
+};
+//---------------------------------------------------------------------------
+static void TVPTestResetDecodeThreads(tjs_int num)
+{
+	// the decoding threads are created again with the new count on demand
+	TVPShutdownWaveDecodeThreads();
+	TVPWaveDecodeThreadNum = num;
+	TVPTestDecodeHold = false;
+	TVPTestDecodeLog.clear();
+}
+//---------------------------------------------------------------------------
+static void TVPTestSleep(tjs_int ms)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(wave_decode_nearest_to_underrun_first)
+{
+	TVPTestResetDecodeThreads(1);
+
+	tTVPTestDecodeTarget a('a', 3, 4), b('b', 1, 4), c('c', 2, 4);
+	tTVPWaveDecodeTask ta(&a), tb(&b), tc(&c);
+
+	// start all tasks at once, so that the only thread sees all of them
+	TVPTestDecodeHold = true;
+	ta.Continue();
+	tb.Continue();
+	tc.Continue();
+	TVPTestDecodeHold = false;
+	ta.Continue(); // wake the thread
+
+	for(tjs_int i = 0; i < 500 && !(a.IsFull() && b.IsFull() && c.IsFull()); i++)
+		TVPTestSleep(10);
+
+	ta.Interrupt();
+	tb.Interrupt();
+	tc.Interrupt();
+
+	// b(1) b(2, before c(2)) c(2) a(3) b(3) c(3)
+	TVP_CHECK(TVPTestDecodeLog == "bbcabc");
+}
+//---------------------------------------------------------------------------
+TVP_TEST(wave_decode_interrupt_stops_decoding)
+{
+	TVPTestResetDecodeThreads(2);
+
+	tTVPTestDecodeTarget target('a', 0, 1000, 5);
+	tTVPWaveDecodeTask task(&target);
+	task.Continue();
+
+	for(tjs_int i = 0; i < 500 && target.Decoded < 3; i++)
+		TVPTestSleep(10);
+	TVP_CHECK(target.Decoded >= 3);
+
+	task.Interrupt();
+	TVP_CHECK(!task.GetRunning());
+	TVP_CHECK(!target.InDecode); // Interrupt waits for the current unit
+
+	tjs_int decoded = target.Decoded;
+	TVPTestSleep(100);
+	TVP_CHECK(target.Decoded == decoded);
+
+	// and it can be continued
+	task.Continue();
+	for(tjs_int i = 0; i < 500 && target.Decoded == decoded; i++)
+		TVPTestSleep(10);
+	TVP_CHECK(target.Decoded > decoded);
+	task.Interrupt();
+}
+//---------------------------------------------------------------------------
+TVP_TEST(wave_decode_destructor_waits_for_worker)
+{
+	TVPTestResetDecodeThreads(1);
+
+	tTVPTestDecodeTarget target('a', 0, 1000, 100);
+	tTVPWaveDecodeTask * task = new tTVPWaveDecodeTask(&target);
+	task->Continue();
+
+	for(tjs_int i = 0; i < 500 && !target.InDecode; i++)
+		TVPTestSleep(1);
+	TVP_CHECK(target.InDecode);
+
+	delete task;
+	TVP_CHECK(!target.InDecode);
+
+	tjs_int decoded = target.Decoded;
+	TVPTestSleep(200);
+	TVP_CHECK(target.Decoded == decoded); // no longer picked
+}
+//---------------------------------------------------------------------------
+TVP_TEST(wave_decode_priority_belongs_to_task)
+{
+	TVPTestResetDecodeThreads(1);
+
+	tTVPTestDecodeTarget a('a', 0, 2), b('b', 0, 2);
+	tTVPWaveDecodeTask ta(&a), tb(&b);
+
+	TVPTestDecodeHold = true;
+	ta.Continue();
+	tb.Continue();
+	TVP_CHECK(ta.GetPriority() == TVPWaveDecodeThreadHighPriority);
+
+	// a boost requested while no thread is decoding the task is kept by the
+	// task, and does not affect the other task
+	ta.SetPriority(ttpHighest);
+	TVP_CHECK(ta.GetPriority() == ttpHighest);
+	TVP_CHECK(tb.GetPriority() == TVPWaveDecodeThreadHighPriority);
+
+	// decoding a unit consumes the boost
+	TVPTestDecodeHold = false;
+	ta.Continue();
+	for(tjs_int i = 0; i < 500 && !(a.IsFull() && b.IsFull()); i++)
+		TVPTestSleep(10);
+	ta.Interrupt();
+	tb.Interrupt();
+	TVP_CHECK(a.IsFull() && b.IsFull());
+	TVP_CHECK(ta.GetPriority() == TVPWaveDecodeThreadLowPriority);
+	TVP_CHECK(tb.GetPriority() == TVPWaveDecodeThreadLowPriority);
+}
+//---------------------------------------------------------------------------
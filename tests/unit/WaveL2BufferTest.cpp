@@ -0,0 +1,357 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Wave L2 buffer tests
+//---------------------------------------------------------------------------
+/*
+	RIFF wave files are played through the decoder, the loop manager and the
+	L2 buffer filled by the decoding threads, as tTJSNI_WaveSoundBuffer does.
+	The L1 buffer is read by the test instead of a sound device.
+*/
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include "TVPTest.h"
+#include "HeadlessHost.h"
+#include "MsgIntf.h"
+#include "WaveIntf.h"
+#include "WaveLoopManager.h"
+#include "WaveL2Buffer.h"
+#include "WaveDecodeScheduler.h"
+
+
+//---------------------------------------------------------------------------
+#define TVP_TEST_WAVE_FREQ 44100
+#define TVP_TEST_ACCESS_FREQ 8 // TVP_WSB_ACCESS_FREQ of the win32 buffer
+#define TVP_TEST_UNIT_SAMPLES (TVP_TEST_WAVE_FREQ / TVP_TEST_ACCESS_FREQ)
+//---------------------------------------------------------------------------
+static tjs_int16 TVPTestWaveSample(tjs_uint seed, tjs_uint pos, tjs_uint channel)
+{
+	tjs_uint32 v = (pos + seed * 7919u) * 2654435761u + channel * 40503u;
+	return (tjs_int16)(v >> 16);
+}
+//---------------------------------------------------------------------------
+static void TVPTestPutLE(std::vector<tjs_uint8> & out, tjs_uint32 v, tjs_int bytes)
+{
+	for(tjs_int i = 0; i < bytes; i++) out.push_back((tjs_uint8)(v >> (i * 8)));
+}
+//---------------------------------------------------------------------------
+static ttstr TVPTestWriteWave(const char * name, tjs_uint seed, tjs_uint samples)
+{
+	// 16bit stereo PCM
+	tjs_uint datasize = samples * 4;
+	std::vector<tjs_uint8> out;
+	out.insert(out.end(), "RIFF", "RIFF" + 4);
+	TVPTestPutLE(out, 36 + datasize, 4);
+	out.insert(out.end(), "WAVEfmt ", "WAVEfmt " + 8);
+	TVPTestPutLE(out, 16, 4);
+	TVPTestPutLE(out, 1, 2); // WAVE_FORMAT_PCM
+	TVPTestPutLE(out, 2, 2);
+	TVPTestPutLE(out, TVP_TEST_WAVE_FREQ, 4);
+	TVPTestPutLE(out, TVP_TEST_WAVE_FREQ * 4, 4);
+	TVPTestPutLE(out, 4, 2);
+	TVPTestPutLE(out, 16, 2);
+	out.insert(out.end(), "data", "data" + 4);
+	TVPTestPutLE(out, datasize, 4);
+	for(tjs_uint s = 0; s < samples; s++)
+	{
+		TVPTestPutLE(out, (tjs_uint16)TVPTestWaveSample(seed, s, 0), 2);
+		TVPTestPutLE(out, (tjs_uint16)TVPTestWaveSample(seed, s, 1), 2);
+	}
+
+	std::string path = TVPHeadlessTempPath(name);
+	FILE * f = fopen(path.c_str(), "wb");
+	if(!f) TVPThrowExceptionMessage(TJS_W("cannot write a wave file"));
+	fwrite(&out[0], 1, out.size(), f);
+	fclose(f);
+	return ttstr(path.c_str());
+}
+//---------------------------------------------------------------------------
+static bool TVPTestSameAsWave(const std::vector<tjs_int16> & played,
+	tjs_uint seed, tjs_uint samples)
+{
+	if(played.size() != samples * 2) return false;
+	for(tjs_uint s = 0; s < samples; s++)
+	{
+		if(played[s * 2 + 0] != TVPTestWaveSample(seed, s, 0)) return false;
+		if(played[s * 2 + 1] != TVPTestWaveSample(seed, s, 1)) return false;
+	}
+	return true;
+}
+//---------------------------------------------------------------------------
+static void TVPTestSleep(tjs_int ms)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+//---------------------------------------------------------------------------
+static tTJSCriticalSection TVPTestDecodeLogCS;
+static std::string TVPTestDecodeLog;
+	// names of the players, in the order of decoding on the decoding threads
+//---------------------------------------------------------------------------
+static void TVPTestResetDecodeThreads(tjs_int num)
+{
+	TVPShutdownWaveDecodeThreads();
+	TVPWaveDecodeThreadNum = num;
+	TVPTestDecodeLog.clear();
+}
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// tTVPTestWavePlayer : the playing part of tTJSNI_WaveSoundBuffer
+//---------------------------------------------------------------------------
+class tTVPTestWavePlayer : public iTVPWaveL2Source
+{
+	char Name;
+	tjs_int DecodeTime; // in ms; makes the decoder slow
+	tTVPWaveDecoder * Decoder;
+	tTVPWaveLoopManager * LoopManager;
+	tTVPWaveL2Buffer * L2Buffer;
+	tTVPWaveDecodeTask * DecodeTask;
+
+public:
+	std::vector<tjs_int16> Played; // decoded samples read from L2
+	tjs_int Underruns; // units played as silence
+	tjs_int DryUnits; // units the playing thread had to decode by itself
+	bool Ended;
+
+	tTVPTestWavePlayer(char name, const ttstr & storage, tjs_int units,
+		tjs_int decodetime = 0)
+	{
+		Name = name;
+		DecodeTime = decodetime;
+		Underruns = 0;
+		DryUnits = 0;
+		Ended = false;
+
+		// the PCM cache would serve short clips without the RIFF decoder
+		Decoder = TVPCreateWaveDecoderFromCreators(storage);
+		LoopManager = new tTVPWaveLoopManager();
+		LoopManager->SetDecoder(Decoder);
+		const tTVPWaveFormat & format = LoopManager->GetFormat();
+		L2Buffer = new tTVPWaveL2Buffer(this);
+		L2Buffer->Allocate(units, TVP_TEST_UNIT_SAMPLES,
+			TVP_TEST_UNIT_SAMPLES * format.BytesPerSample * format.Channels);
+		DecodeTask = new tTVPWaveDecodeTask(L2Buffer);
+	}
+
+	~tTVPTestWavePlayer()
+	{
+		delete DecodeTask;
+		delete L2Buffer;
+		delete LoopManager;
+		delete Decoder;
+	}
+
+	tjs_uint DecodeL2Unit(void *buffer, tjs_uint bufsamplelen,
+		tTVPWaveSegmentQueue & segments)
+	{
+		if(DecodeTask->GetRunning())
+		{
+			tTJSCriticalSectionHolder holder(TVPTestDecodeLogCS);
+			TVPTestDecodeLog += Name;
+		}
+		if(DecodeTime) TVPTestSleep(DecodeTime);
+		tjs_uint written = 0;
+		LoopManager->Decode(buffer, bufsamplelen, written, segments);
+		return written;
+	}
+
+	void Start(tjs_int prefill)
+	{
+		// as StartPlay: the first units are decoded on the playing thread,
+		// then the decoding threads take over
+		L2Buffer->Fill(true);
+		for(tjs_int i = 1; i < prefill; i++) L2Buffer->Fill(false);
+		DecodeTask->Continue();
+	}
+
+	void Stop() { DecodeTask->Interrupt(); }
+
+	void PlayUnit(bool fillwhenempty = true)
+	{
+		// as FillBuffer and ReadL2Buffer: an empty L2 buffer is filled by
+		// the playing thread, unless the test simulates that the decoder
+		// could not keep up
+		if(Ended) return;
+		if(L2Buffer->GetReadableUnits() == 0)
+		{
+			DryUnits++;
+			if(fillwhenempty) L2Buffer->Fill(false);
+		}
+
+		tjs_uint decoded;
+		tTVPWaveSegmentQueue segments;
+		const tjs_uint8 * unit = L2Buffer->BeginRead(decoded, segments);
+		if(!unit)
+		{
+			Underruns++; // silence is played; this is not the end
+			return;
+		}
+		const tjs_int16 * p = (const tjs_int16 *)unit;
+		Played.insert(Played.end(), p, p + decoded * 2);
+		if(decoded < TVP_TEST_UNIT_SAMPLES) Ended = true;
+		L2Buffer->EndRead();
+	}
+
+	bool IsFull()
+	{
+		tjs_int remain, units;
+		L2Buffer->GetDecodeStatus(remain, units);
+		return remain >= units;
+	}
+};
+//---------------------------------------------------------------------------
+// tTVPTestBusyTarget : keeps a decoding thread busy for a while
+//---------------------------------------------------------------------------
+class tTVPTestBusyTarget : public iTVPWaveDecodeTarget
+{
+public:
+	volatile bool Done;
+	tTVPTestBusyTarget() { Done = false; }
+	void GetDecodeStatus(tjs_int &remain, tjs_int &units)
+		{ remain = Done ? 1 : 0; units = 1; }
+	bool DecodeUnit()
+	{
+		if(Done) return false;
+		TVPTestSleep(200);
+		Done = true;
+		return true;
+	}
+};
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(wave_l2_plays_riff_waves_without_loss)
+{
+	// three streams of different length on two decoding threads; the L1
+	// side reads a unit of each stream in turn, a little faster than real
+	// time
+	TVPTestResetDecodeThreads(2);
+
+	static const tjs_uint lengths[] =
+		{ TVP_TEST_WAVE_FREQ * 3, TVP_TEST_WAVE_FREQ * 2 + 1234,
+			TVP_TEST_UNIT_SAMPLES * 9 };
+	static const char * names[] = { "l2a.wav", "l2b.wav", "l2c.wav" };
+	tTVPTestWavePlayer * players[3];
+	for(tjs_int i = 0; i < 3; i++)
+		players[i] = new tTVPTestWavePlayer('a' + i,
+			TVPTestWriteWave(names[i], i, lengths[i]), 8);
+
+	for(tjs_int i = 0; i < 3; i++) players[i]->Start(4);
+	for(tjs_int loop = 0; loop < 100; loop++)
+	{
+		bool ended = true;
+		for(tjs_int i = 0; i < 3; i++)
+		{
+			players[i]->PlayUnit();
+			ended = ended && players[i]->Ended;
+		}
+		if(ended) break;
+		TVPTestSleep(1000 / TVP_TEST_ACCESS_FREQ / 4);
+	}
+
+	for(tjs_int i = 0; i < 3; i++)
+	{
+		players[i]->Stop();
+		TVP_CHECK(players[i]->Ended);
+		TVP_CHECK(players[i]->Underruns == 0);
+		TVP_CHECK(TVPTestSameAsWave(players[i]->Played, i, lengths[i]));
+		delete players[i];
+	}
+
+	// both the playing thread (at start) and the decoding threads decoded
+	TVP_CHECK(TVPTestDecodeLog.size() > 0);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(wave_l2_fills_nearest_to_underrun_first)
+{
+	TVPTestResetDecodeThreads(1);
+
+	tTVPTestWavePlayer a('a', TVPTestWriteWave("l2a.wav", 0, TVP_TEST_WAVE_FREQ * 2), 4);
+	tTVPTestWavePlayer b('b', TVPTestWriteWave("l2b.wav", 1, TVP_TEST_WAVE_FREQ * 2), 4);
+	tTVPTestWavePlayer c('c', TVPTestWriteWave("l2c.wav", 2, TVP_TEST_WAVE_FREQ * 2), 4);
+
+	// the only thread is busy while the players start, so that it sees all
+	// of them at once
+	tTVPTestBusyTarget busy;
+	tTVPWaveDecodeTask busytask(&busy);
+	busytask.Continue();
+	TVPTestSleep(50);
+
+	a.Start(3);
+	b.Start(1);
+	c.Start(2);
+
+	for(tjs_int i = 0; i < 500 && !(a.IsFull() && b.IsFull() && c.IsFull()); i++)
+		TVPTestSleep(10);
+	busytask.Interrupt();
+	a.Stop();
+	b.Stop();
+	c.Stop();
+
+	// b(1) b(2, before c(2)) c(2) a(3) b(3) c(3)
+	TVP_CHECK(TVPTestDecodeLog == "bbcabc");
+
+	// and the streams are intact
+	while(!a.Ended) a.PlayUnit();
+	while(!b.Ended) b.PlayUnit();
+	while(!c.Ended) c.PlayUnit();
+	TVP_CHECK(TVPTestSameAsWave(a.Played, 0, TVP_TEST_WAVE_FREQ * 2));
+	TVP_CHECK(TVPTestSameAsWave(b.Played, 1, TVP_TEST_WAVE_FREQ * 2));
+	TVP_CHECK(TVPTestSameAsWave(c.Played, 2, TVP_TEST_WAVE_FREQ * 2));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(wave_l2_underrun_plays_silence_and_goes_on)
+{
+	// the decoder takes 30ms for a unit of 125ms, and the L1 side reads
+	// without waiting, so the L2 buffer runs dry
+	TVPTestResetDecodeThreads(1);
+
+	const tjs_uint length = TVP_TEST_WAVE_FREQ * 2 + 100;
+	tTVPTestWavePlayer player('a', TVPTestWriteWave("l2a.wav", 3, length), 4, 30);
+	player.Start(1);
+	for(tjs_int loop = 0; loop < 2000 && !player.Ended; loop++)
+	{
+		player.PlayUnit(false);
+		TVPTestSleep(5);
+	}
+	player.Stop();
+
+	// underruns do not end the stream, and lose or repeat no sample
+	TVP_CHECK(player.Underruns > 0);
+	TVP_CHECK(player.Ended);
+	TVP_CHECK(TVPTestSameAsWave(player.Played, 3, length));
+}
+//---------------------------------------------------------------------------
+TVP_TEST(wave_l2_playing_thread_fills_dry_buffer)
+{
+	// when the L2 buffer is found empty, the playing thread decodes the
+	// unit by itself instead of playing silence
+	TVPTestResetDecodeThreads(1);
+
+	const tjs_uint length = TVP_TEST_WAVE_FREQ * 2 + 100;
+	tTVPTestWavePlayer player('a', TVPTestWriteWave("l2a.wav", 4, length), 4, 30);
+	player.Start(1);
+	for(tjs_int loop = 0; loop < 2000 && !player.Ended; loop++)
+		player.PlayUnit();
+	player.Stop();
+
+	TVP_CHECK(player.DryUnits > 0);
+	TVP_CHECK(player.Underruns == 0);
+	TVP_CHECK(player.Ended);
+	TVP_CHECK(TVPTestSameAsWave(player.Played, 4, length));
+}
+//---------------------------------------------------------------------------
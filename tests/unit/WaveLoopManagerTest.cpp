@@ -0,0 +1,289 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Wave loop manager tests
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include "TVPTest.h"
+#include "WaveIntf.h"
+#include "WaveLoopManager.h"
+
+
+//---------------------------------------------------------------------------
+// tTVPTestWaveDecoder : 16bit stereo samples computed from the position
+//---------------------------------------------------------------------------
+#define TVP_TEST_WAVE_FREQ 44100
+#define TVP_TEST_WAVE_SAMPLES 200000
+//---------------------------------------------------------------------------
+static tjs_int16 TVPTestWaveSample(tjs_uint64 pos, tjs_uint channel)
+{
+	// every position gives other values, so that a jump to a wrong position
+	// changes the output
+	tjs_uint32 v = (tjs_uint32)pos * 2654435761u + channel * 40503u;
+	return (tjs_int16)(v >> 16);
+}
+//---------------------------------------------------------------------------
+class tTVPTestWaveDecoder : public tTVPWaveDecoder
+{
+	tjs_uint64 Position;
+
+public:
+	tTVPTestWaveDecoder() { Position = 0; }
+
+	void GetFormat(tTVPWaveFormat & format)
+	{
+		format.SamplesPerSec = TVP_TEST_WAVE_FREQ;
+		format.Channels = 2;
+		format.BitsPerSample = 16;
+		format.BytesPerSample = 2;
+		format.TotalSamples = TVP_TEST_WAVE_SAMPLES;
+		format.TotalTime = (tjs_uint64)TVP_TEST_WAVE_SAMPLES * 1000 /
+			TVP_TEST_WAVE_FREQ;
+		format.SpeakerConfig = 0;
+		format.IsFloat = false;
+		format.Seekable = true;
+	}
+
+	bool Render(void *buf, tjs_uint bufsamplelen, tjs_uint& rendered)
+	{
+		tjs_int16 * dest = (tjs_int16 *)buf;
+		tjs_uint64 remain = TVP_TEST_WAVE_SAMPLES - Position;
+		rendered = bufsamplelen < remain ? bufsamplelen : (tjs_uint)remain;
+		for(tjs_uint i = 0; i < rendered; i++, Position++)
+		{
+			*(dest++) = TVPTestWaveSample(Position, 0);
+			*(dest++) = TVPTestWaveSample(Position, 1);
+		}
+		return Position < TVP_TEST_WAVE_SAMPLES;
+	}
+
+	bool SetPosition(tjs_uint64 samplepos)
+	{
+		if(samplepos > TVP_TEST_WAVE_SAMPLES) return false;
+		Position = samplepos;
+		return true;
+	}
+};
+//---------------------------------------------------------------------------
+// tTVPTestWaveDecoderCreator : creates tTVPTestWaveDecoder for ".stub"
+//---------------------------------------------------------------------------
+class tTVPTestWaveDecoderCreator : public tTVPWaveDecoderCreator
+{
+public:
+	volatile tjs_int Created;
+
+	tTVPTestWaveDecoderCreator() { Created = 0; }
+
+	tTVPWaveDecoder * Create(const ttstr & storagename,
+		const ttstr &extension)
+	{
+		if(extension != TJS_W(".stub")) return NULL;
+		Created = Created + 1; // called on a decoding thread
+		return new tTVPTestWaveDecoder();
+	}
+};
+//---------------------------------------------------------------------------
+struct tTVPTestLinkParam
+{
+	tjs_int64 From;
+	tjs_int64 To;
+	bool Smooth;
+};
+//---------------------------------------------------------------------------
+static void TVPTestSetLinks(tTVPWaveLoopManager & manager,
+	const tTVPTestLinkParam * params, tjs_int count)
+{
+	std::vector<tTVPWaveLoopLink> links;
+	for(tjs_int i = 0; i < count; i++)
+	{
+		tTVPWaveLoopLink link;
+		link.From = params[i].From;
+		link.To = params[i].To;
+		link.Smooth = params[i].Smooth;
+		links.push_back(link);
+	}
+	manager.SetLinks(links);
+}
+//---------------------------------------------------------------------------
+static void TVPTestDecode(std::vector<tjs_int16> & out,
+	tTVPWaveLoopManager & manager, tjs_uint total, tjs_uint chunk, bool wait)
+{
+	// decodes 'total' samples in 'chunk' sample pieces. with 'wait', gives
+	// the decoding threads some time after each piece, as the sound buffer
+	// does while the decoded samples are played.
+	out.assign(total * 2, 0);
+	tjs_uint done = 0;
+	while(done < total)
+	{
+		tjs_uint n = total - done < chunk ? total - done : chunk;
+		tjs_uint written = 0;
+		tTVPWaveSegmentQueue segments;
+		manager.Decode(&out[done * 2], n, written, segments);
+		if(written == 0) break;
+		done += written;
+		if(wait) std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+	out.resize(done * 2);
+}
+//---------------------------------------------------------------------------
+static void TVPTestPrefetchMatches(const tTVPTestLinkParam * links,
+	tjs_int count, bool looping, bool expect_prefetch)
+{
+	// the output with prefetching must be the same as the one without it,
+	// whether the prefetch is ready at the jump or not
+	static const tjs_uint chunks[] = { 64, 256, 1000, 4096 };
+	const tjs_uint total = TVP_TEST_WAVE_SAMPLES * 4;
+
+	tTVPTestWaveDecoderCreator creator;
+	TVPRegisterWaveDecoderCreator(&creator);
+	try
+	{
+		for(tjs_uint c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+		{
+			std::vector<tjs_int16> reference, prefetched;
+
+			tTVPTestWaveDecoder refdecoder;
+			{
+				tTVPWaveLoopManager manager;
+				manager.SetDecoder(&refdecoder);
+				manager.SetLooping(looping);
+				TVPTestSetLinks(manager, links, count);
+				TVPTestDecode(reference, manager, total, chunks[c], false);
+			}
+
+			tTVPTestWaveDecoder decoder;
+			tjs_int jumps;
+			{
+				tTVPWaveLoopManager manager;
+				manager.SetDecoder(&decoder);
+				manager.SetLooping(looping);
+				TVPTestSetLinks(manager, links, count);
+				manager.SetPrefetchStorage(TJS_W("test.stub"));
+				TVPTestDecode(prefetched, manager, total, chunks[c], true);
+				jumps = manager.GetPrefetchedJumpCount();
+			}
+
+			bool same = reference == prefetched;
+			if(!same)
+				fprintf(stderr, "chunk %u: the outputs differ\n", chunks[c]);
+			TVP_CHECK(same);
+			if(expect_prefetch) TVP_CHECK(jumps > 0);
+		}
+	}
+	catch(...)
+	{
+		TVPUnregisterWaveDecoderCreator(&creator);
+		throw;
+	}
+	TVPUnregisterWaveDecoderCreator(&creator);
+
+	// the spare decoder is opened only for the streams which jump
+	TVP_CHECK((creator.Created > 0) == expect_prefetch);
+}
+//---------------------------------------------------------------------------
+static void TVPTestSleep(tjs_int ms)
+{
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(wave_loop_prefetch_plain_link)
+{
+	static const tTVPTestLinkParam links[] = { { 150000, 30000, false } };
+	TVPTestPrefetchMatches(links, 1, false, true);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(wave_loop_prefetch_whole_file)
+{
+	// looping without links rewinds at the end of the stream
+	TVPTestPrefetchMatches(NULL, 0, true, true);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(wave_loop_prefetch_chained_links)
+{
+	// the target of each link is close to the next link, so that the
+	// prefetched region is cut at the next event
+	static const tTVPTestLinkParam links[] =
+	{
+		{ 60000, 120000, false },
+		{ 125000, 10000, false },
+		{ 12000, 180000, false },
+		{ 190000, 50000, false },
+	};
+	TVPTestPrefetchMatches(links, 4, false, true);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(wave_loop_prefetch_smooth_links)
+{
+	// smooth links crossfade by themselves; a smooth link just after a
+	// prefetched target leaves no room to prefetch (50000 -> 51000), one a
+	// little later leaves some (25000 -> 30000)
+	static const tTVPTestLinkParam links[] =
+	{
+		{ 30000, 100000, true },
+		{ 120000, 50000, false },
+		{ 51000, 140000, true },
+		{ 160000, 25000, false },
+	};
+	TVPTestPrefetchMatches(links, 4, false, true);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(wave_loop_prefetch_without_jumps)
+{
+	// a stream which does not jump never opens the spare decoder
+	TVPTestPrefetchMatches(NULL, 0, false, false);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(wave_loop_prefetch_opens_decoder_when_link_is_close)
+{
+	tTVPTestWaveDecoderCreator creator;
+	TVPRegisterWaveDecoderCreator(&creator);
+	try
+	{
+		tTVPTestWaveDecoder decoder;
+		tTVPWaveLoopManager manager;
+		manager.SetDecoder(&decoder);
+		static const tTVPTestLinkParam links[] = { { 150000, 30000, false } };
+		TVPTestSetLinks(manager, links, 1);
+		manager.SetPrefetchStorage(TJS_W("test.stub"));
+
+		// the link is farther than TVP_WL_PREFETCH_LEAD_TIME
+		std::vector<tjs_int16> out;
+		TVPTestDecode(out, manager, 50000, 1000, false);
+		TVPTestSleep(100);
+		TVP_CHECK(creator.Created == 0);
+
+		// and then close
+		TVPTestDecode(out, manager, 60000, 1000, false);
+		for(tjs_int i = 0; i < 500 && creator.Created == 0; i++)
+			TVPTestSleep(10);
+		TVP_CHECK(creator.Created == 1);
+
+		// the jump is served from the prefetched samples
+		TVPTestSleep(100);
+		TVPTestDecode(out, manager, 50000, 1000, false);
+		TVP_CHECK(manager.GetPrefetchedJumpCount() == 1);
+		TVP_CHECK(creator.Created == 1);
+	}
+	catch(...)
+	{
+		TVPUnregisterWaveDecoderCreator(&creator);
+		throw;
+	}
+	TVPUnregisterWaveDecoderCreator(&creator);
+}
+//---------------------------------------------------------------------------
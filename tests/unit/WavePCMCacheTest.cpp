@@ -0,0 +1,326 @@
+//---------------------------------------------------------------------------
+/*
+	TVP2 ( T Visual Presenter 2 )  A script authoring tool
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Decoded PCM cache tests
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "TVPTest.h"
+#include "HeadlessHost.h"
+#include "WaveIntf.h"
+
+
+//---------------------------------------------------------------------------
+// tTVPTestPCMDecoder : 16bit samples computed from the position, in the
+// format of TVPTestPCMParam at its creation
+//---------------------------------------------------------------------------
+struct tTVPTestPCMParam
+{
+	tjs_uint Frequency;
+	tjs_uint Channels;
+	tjs_uint Samples; // TotalSamples the decoder reports
+	tjs_uint Extra; // samples the decoder gives beyond TotalSamples
+};
+static tTVPTestPCMParam TVPTestPCMParam;
+static tjs_int TVPTestPCMCreated; // decoders created
+static tjs_uint64 TVPTestPCMRendered; // samples rendered by the decoders
+//---------------------------------------------------------------------------
+static tjs_int16 TVPTestPCMSample(tjs_uint64 pos, tjs_uint channel,
+	tjs_uint channels)
+{
+	// the format is in the value too, so that the PCM of another format
+	// does not match
+	tjs_uint32 v = (tjs_uint32)pos * 2654435761u + channel * 40503u +
+		channels * 7919u;
+	return (tjs_int16)(v >> 16);
+}
+//---------------------------------------------------------------------------
+class tTVPTestPCMDecoder : public tTVPWaveDecoder
+{
+	tTVPTestPCMParam Param;
+	tjs_uint64 Position;
+
+public:
+	tTVPTestPCMDecoder() { Param = TVPTestPCMParam; Position = 0; }
+
+	void GetFormat(tTVPWaveFormat & format)
+	{
+		memset(&format, 0, sizeof(format));
+		format.SamplesPerSec = Param.Frequency;
+		format.Channels = Param.Channels;
+		format.BitsPerSample = 16;
+		format.BytesPerSample = 2;
+		format.TotalSamples = Param.Samples;
+		format.TotalTime = (tjs_uint64)Param.Samples * 1000 / Param.Frequency;
+		format.IsFloat = false;
+		format.Seekable = true;
+	}
+
+	bool Render(void *buf, tjs_uint bufsamplelen, tjs_uint& rendered)
+	{
+		tjs_int16 * dest = (tjs_int16 *)buf;
+		tjs_uint64 remain = Param.Samples + Param.Extra - Position;
+		rendered = bufsamplelen < remain ? bufsamplelen : (tjs_uint)remain;
+		for(tjs_uint i = 0; i < rendered; i++, Position++)
+			for(tjs_uint ch = 0; ch < Param.Channels; ch++)
+				*(dest++) = TVPTestPCMSample(Position, ch, Param.Channels);
+		TVPTestPCMRendered += rendered;
+		return Position < Param.Samples + Param.Extra;
+	}
+
+	bool SetPosition(tjs_uint64 samplepos)
+	{
+		if(samplepos > Param.Samples) return false;
+		Position = samplepos;
+		return true;
+	}
+};
+//---------------------------------------------------------------------------
+// tTVPTestPCMDecoderCreator : creates tTVPTestPCMDecoder for ".pcmtest"
+//---------------------------------------------------------------------------
+class tTVPTestPCMDecoderCreator : public tTVPWaveDecoderCreator
+{
+public:
+	tTVPTestPCMDecoderCreator() { TVPRegisterWaveDecoderCreator(this); }
+	~tTVPTestPCMDecoderCreator() { TVPUnregisterWaveDecoderCreator(this); }
+
+	tTVPWaveDecoder * Create(const ttstr & storagename,
+		const ttstr &extension)
+	{
+		if(extension != TJS_W(".pcmtest")) return NULL;
+		TVPTestPCMCreated++;
+		return new tTVPTestPCMDecoder();
+	}
+};
+//---------------------------------------------------------------------------
+static void TVPTestResetPCMCache(tjs_uint64 limit)
+{
+	// empty cache of "limit" bytes; 16bit stereo clips of 1000 samples
+	TVPClearWavePCMCache();
+	TVPSetWavePCMCacheLimit(limit, 2000);
+	TVPTestPCMParam.Frequency = 44100;
+	TVPTestPCMParam.Channels = 2;
+	TVPTestPCMParam.Samples = 1000;
+	TVPTestPCMParam.Extra = 0;
+}
+//---------------------------------------------------------------------------
+static ttstr TVPTestPCMStorage(const char * name)
+{
+	// the file does not have to exist; only the creator sees the name
+	return ttstr(TVPHeadlessTempPath(name).c_str());
+}
+//---------------------------------------------------------------------------
+static tjs_uint64 TVPTestOpenCost(const char * name)
+{
+	// opens the storage and returns the samples decoded by the open
+	tjs_uint64 before = TVPTestPCMRendered;
+	tTVPWaveDecoder * decoder = TVPCreateWaveDecoder(TVPTestPCMStorage(name));
+	delete decoder;
+	return TVPTestPCMRendered - before;
+}
+//---------------------------------------------------------------------------
+static bool TVPTestDecoderGives(tTVPWaveDecoder * decoder, tjs_uint64 from,
+	tjs_uint channels, tjs_uint samples)
+{
+	// reads the decoder to the end, and compares with the test samples from
+	// "from"
+	tTVPWaveFormat format;
+	decoder->GetFormat(format);
+	if(format.Channels != channels || format.BitsPerSample != 16)
+	{
+		fprintf(stderr, "format is %u channels, %u bits\n", format.Channels,
+			format.BitsPerSample);
+		return false;
+	}
+
+	std::vector<tjs_int16> buf(300 * channels);
+	tjs_uint64 pos = from;
+	for(;;)
+	{
+		tjs_uint rendered = 0;
+		bool cont = decoder->Render(&buf[0], 300, rendered);
+		for(tjs_uint i = 0; i < rendered; i++, pos++)
+			for(tjs_uint ch = 0; ch < channels; ch++)
+				if(buf[i * channels + ch] != TVPTestPCMSample(pos, ch, channels))
+				{
+					fprintf(stderr, "sample %u of channel %u differs\n",
+						(unsigned int)pos, ch);
+					return false;
+				}
+		if(!cont || rendered == 0) break;
+	}
+	if(pos != samples)
+	{
+		fprintf(stderr, "%u samples, expected %u\n", (unsigned int)pos,
+			samples);
+		return false;
+	}
+	return true;
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+TVP_TEST(pcm_cache_hit_serves_the_same_pcm)
+{
+	tTVPTestPCMDecoderCreator creator;
+	TVPTestResetPCMCache(1024*1024);
+
+	// the first open decodes the whole clip
+	tjs_int created = TVPTestPCMCreated;
+	tjs_uint64 rendered = TVPTestPCMRendered;
+	tTVPWaveDecoder * first = TVPCreateWaveDecoder(TVPTestPCMStorage("hit.pcmtest"));
+	TVP_CHECK(TVPTestPCMCreated == created + 1);
+	TVP_CHECK(TVPTestPCMRendered == rendered + 1000);
+
+	// the second one only reads the format
+	tTVPWaveDecoder * second = TVPCreateWaveDecoder(TVPTestPCMStorage("hit.pcmtest"));
+	TVP_CHECK(TVPTestPCMCreated == created + 2);
+	TVP_CHECK(TVPTestPCMRendered == rendered + 1000);
+
+	// both read the same PCM, each at its own position
+	TVP_CHECK(TVPTestDecoderGives(first, 0, 2, 1000));
+	TVP_CHECK(second->SetPosition(600));
+	TVP_CHECK(TVPTestDecoderGives(second, 600, 2, 1000));
+	TVP_CHECK(!second->SetPosition(1000));
+	TVP_CHECK(second->SetPosition(0));
+	TVP_CHECK(TVPTestDecoderGives(second, 0, 2, 1000));
+	delete first;
+	delete second;
+
+	// the PCM outlives the cache while a decoder uses it
+	tTVPWaveDecoder * third = TVPCreateWaveDecoder(TVPTestPCMStorage("hit.pcmtest"));
+	TVPClearWavePCMCache();
+	TVP_CHECK(TVPTestDecoderGives(third, 0, 2, 1000));
+	delete third;
+	TVP_CHECK(TVPTestOpenCost("hit.pcmtest") == 1000);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(pcm_cache_evicts_least_recently_used)
+{
+	// room for three clips of 4000 bytes
+	tTVPTestPCMDecoderCreator creator;
+	TVPTestResetPCMCache(12000);
+
+	TVP_CHECK(TVPTestOpenCost("a.pcmtest") == 1000);
+	TVP_CHECK(TVPTestOpenCost("b.pcmtest") == 1000);
+	TVP_CHECK(TVPTestOpenCost("c.pcmtest") == 1000);
+	TVP_CHECK(TVPTestOpenCost("a.pcmtest") == 0); // a is now newer than b
+
+	// d pushes out b, the least recently used
+	TVP_CHECK(TVPTestOpenCost("d.pcmtest") == 1000);
+	TVP_CHECK(TVPTestOpenCost("d.pcmtest") == 0);
+	TVP_CHECK(TVPTestOpenCost("a.pcmtest") == 0);
+	TVP_CHECK(TVPTestOpenCost("c.pcmtest") == 0);
+	TVP_CHECK(TVPTestOpenCost("b.pcmtest") == 1000);
+
+	// and b pushes out d, which is now the oldest
+	TVP_CHECK(TVPTestOpenCost("c.pcmtest") == 0);
+	TVP_CHECK(TVPTestOpenCost("a.pcmtest") == 0);
+	TVP_CHECK(TVPTestOpenCost("d.pcmtest") == 1000);
+
+	// a lower limit evicts at once
+	TVPSetWavePCMCacheLimit(4000, 2000);
+	TVP_CHECK(TVPTestOpenCost("d.pcmtest") == 0);
+	TVP_CHECK(TVPTestOpenCost("a.pcmtest") == 1000);
+
+	// a clip over the limit is not cached
+	TVPTestPCMParam.Samples = 1001;
+	TVP_CHECK(TVPTestOpenCost("large.pcmtest") == 0);
+	TVP_CHECK(TVPTestOpenCost("d.pcmtest") == 0); // d of 1001 samples
+	TVP_CHECK(TVPTestOpenCost("a.pcmtest") == 0);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(pcm_cache_remembers_uncacheable_clips)
+{
+	// a decoder which gives more samples than it reports is found out by
+	// decoding the whole clip once; the storage is then remembered
+	tTVPTestPCMDecoderCreator creator;
+	TVPTestResetPCMCache(1024*1024);
+	TVPTestPCMParam.Extra = 10;
+
+	tjs_uint64 rendered = TVPTestPCMRendered;
+	tTVPWaveDecoder * decoder =
+		TVPCreateWaveDecoder(TVPTestPCMStorage("bad.pcmtest"));
+	TVP_CHECK(TVPTestPCMRendered == rendered + 1001);
+	TVP_CHECK(TVPTestDecoderGives(decoder, 0, 2, 1010)); // rewound
+	delete decoder;
+
+	TVP_CHECK(TVPTestOpenCost("bad.pcmtest") == 0);
+	TVP_CHECK(TVPTestOpenCost("bad.pcmtest") == 0);
+
+	// the entries expire when the limits change, when the cache is cleared,
+	// and when 256 other storages have been rejected since
+	TVPSetWavePCMCacheLimit(1024*1024, 2000);
+	TVP_CHECK(TVPTestOpenCost("bad.pcmtest") == 1001);
+	TVP_CHECK(TVPTestOpenCost("bad.pcmtest") == 0);
+	TVPClearWavePCMCache();
+	TVP_CHECK(TVPTestOpenCost("bad.pcmtest") == 1001);
+	TVP_CHECK(TVPTestOpenCost("bad.pcmtest") == 0);
+	for(tjs_int i = 0; i < 255; i++)
+	{
+		char name[32];
+		sprintf(name, "bad%d.pcmtest", (int)i);
+		TVP_CHECK(TVPTestOpenCost(name) == 1001);
+	}
+	TVP_CHECK(TVPTestOpenCost("bad.pcmtest") == 0); // touched, now the newest
+	for(tjs_int i = 255; i < 511; i++)
+	{
+		char name[32];
+		sprintf(name, "bad%d.pcmtest", (int)i);
+		TVP_CHECK(TVPTestOpenCost(name) == 1001);
+	}
+	TVP_CHECK(TVPTestOpenCost("bad.pcmtest") == 1001);
+
+	// a clip which fits is cached as usual
+	TVPTestPCMParam.Extra = 0;
+	TVP_CHECK(TVPTestOpenCost("good.pcmtest") == 1000);
+	TVP_CHECK(TVPTestOpenCost("good.pcmtest") == 0);
+}
+//---------------------------------------------------------------------------
+TVP_TEST(pcm_cache_key_includes_the_format)
+{
+	// the same storage giving another format is decoded again, and each
+	// format is served its own PCM
+	tTVPTestPCMDecoderCreator creator;
+	TVPTestResetPCMCache(1024*1024);
+
+	TVP_CHECK(TVPTestOpenCost("format.pcmtest") == 1000);
+
+	TVPTestPCMParam.Channels = 1;
+	TVP_CHECK(TVPTestOpenCost("format.pcmtest") == 1000);
+	tTVPWaveDecoder * decoder =
+		TVPCreateWaveDecoder(TVPTestPCMStorage("format.pcmtest"));
+	TVP_CHECK(TVPTestDecoderGives(decoder, 0, 1, 1000));
+	delete decoder;
+
+	TVPTestPCMParam.Samples = 800;
+	TVP_CHECK(TVPTestOpenCost("format.pcmtest") == 800);
+
+	TVPTestPCMParam.Channels = 2;
+	TVPTestPCMParam.Samples = 1000;
+	TVP_CHECK(TVPTestOpenCost("format.pcmtest") == 0);
+	decoder = TVPCreateWaveDecoder(TVPTestPCMStorage("format.pcmtest"));
+	TVP_CHECK(TVPTestDecoderGives(decoder, 0, 2, 1000));
+	delete decoder;
+
+	// the uncacheable mark is for the format too
+	TVPTestPCMParam.Frequency = 22050;
+	TVPTestPCMParam.Extra = 1;
+	TVP_CHECK(TVPTestOpenCost("format.pcmtest") == 1001);
+	TVP_CHECK(TVPTestOpenCost("format.pcmtest") == 0);
+	TVPTestPCMParam.Frequency = 44100;
+	TVPTestPCMParam.Extra = 0;
+	TVP_CHECK(TVPTestOpenCost("format.pcmtest") == 0);
+}
+//---------------------------------------------------------------------------
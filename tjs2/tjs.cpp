@@ -29,7 +29,10 @@
 #include "tjsDebug.h"
 #include "tjsByteCodeLoader.h"
 #include "tjsBinarySerializer.h"
+#include "tjsBinaryLog.h"
 #include "tjsRegExp.h"
+#include "tjsTypedArray.h"
+#include "tjsCycleCollector.h"
 
 namespace TJS
 {
@@ -193,6 +196,9 @@ tTJS::tTJS()
 		dsp->Release();
 		Global->PropSet(TJS_MEMBERENSURE, TJS_W("RegExp"), NULL, &val, Global);
 #endif
+
+		// Int8Array, Uint8Array, ... Float64Array
+		TJSRegisterTypedArrayClasses(Global);
 	}
 	catch(...)
 	{
@@ -222,7 +228,17 @@ void tTJS::Cleanup()
 
 	TJSReleaseGlobalStringMap();
 
+#ifndef TJS_NO_REGEXP
 	TJSReleaseRegex();
+#endif
+
+	TJSReleaseBinaryLogWriters();
+
+	TJSStopCycleCollector();
+
+	TJSShutdownProfiler();
+
+	TJSShutdownVMCounters();
 
 	if(TJSEnableDebugMode)
 	{
@@ -575,9 +591,11 @@ bool tTJS::LoadBinaryDictionayArray( class tTJSBinaryStream* stream, tTJSVariant
 		if( streamlen >= tTJSBinarySerializer::HEADER_LENGTH ) {
 			tjs_uint8 header[tTJSBinarySerializer::HEADER_LENGTH];
 			stream->Read( header, tTJSBinarySerializer::HEADER_LENGTH );
-			if( tTJSBinarySerializer::IsBinary( header ) ) {
+			bool islog = tTJSBinaryLog::IsLog( header );
+			if( islog || tTJSBinarySerializer::IsBinary( header ) ) {
 				tTJSBinarySerializer binload;
-				tTJSVariant* var = binload.Read( stream );
+				tTJSVariant* var = islog ?
+					tTJSBinaryLog::Read( stream, binload ) : binload.Read( stream );
 				if( var ) {
 					*result = *var;
 					delete var;
@@ -655,6 +673,7 @@ tTJSBinaryStream * (*TJSCreateBinaryStreamForRead)(const tTJSString &name,
 tTJSBinaryStream * (*TJSCreateBinaryStreamForWrite)(const tTJSString &name,
 	const tTJSString &mode) =
 	TJSDefCreateBinaryStreamForWrite;
+bool (*TJSRenameStorage)(const tTJSString &from, const tTJSString &to) = NULL;
 //---------------------------------------------------------------------------
 
 
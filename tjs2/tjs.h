@@ -202,6 +202,9 @@ extern class tTJSBinaryStream * (*TJSCreateBinaryStreamForRead)(const tTJSString
 	const tTJSString &modestr);
 extern class tTJSBinaryStream * (*TJSCreateBinaryStreamForWrite)(const tTJSString &name,
 	const tTJSString &modestr);
+extern bool (*TJSRenameStorage)(const tTJSString &from, const tTJSString &to);
+	// replaces the storage "to" with the storage "from"; returns false on
+	// failure. NULL if the host can not rename storages.
 //---------------------------------------------------------------------------
 
 
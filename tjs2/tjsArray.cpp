@@ -18,6 +18,7 @@
 #include "tjsDictionary.h"
 #include "tjsUtils.h"
 #include "tjsBinarySerializer.h"
+#include "tjsBinaryLog.h"
 #include "tjsOctPack.h"
 
 #ifndef TJS_NO_REGEXP
@@ -99,25 +100,20 @@ tTJSStringAppender::~tTJSStringAppender()
 //---------------------------------------------------------------------------
 void tTJSStringAppender::Append(const tjs_char *string, tjs_int len)
 {
+	// TJSVS_malloc and TJSVS_realloc take the size in characters, and
+	// TJSVS_realloc grows the buffer geometrically
+	if(len <= 0) return;
 	if(!Data)
 	{
-		if(len > 0)
-		{
-			Data = TJSVS_malloc(DataCapacity = len * sizeof(tjs_char));
-			memcpy(Data, string, DataCapacity);
-			DataLen = len;
-		}
+		Data = TJSVS_malloc(DataCapacity = len + TJS_STRINGAPPENDER_DATA_INC);
 	}
-	else
+	else if(DataLen + len > DataCapacity)
 	{
-		if(DataLen + len > DataCapacity)
-		{
-			DataCapacity = DataLen + len + TJS_STRINGAPPENDER_DATA_INC;
-			Data = TJSVS_realloc(Data, DataCapacity * sizeof(tjs_char));
-		}
-		memcpy(Data + DataLen, string, len * sizeof(tjs_char));
-		DataLen += len;
+		DataCapacity = DataLen + len;
+		Data = TJSVS_realloc(Data, DataCapacity);
 	}
+	memcpy(Data + DataLen, string, len * sizeof(tjs_char));
+	DataLen += len;
 }
 //---------------------------------------------------------------------------
 
@@ -230,6 +226,445 @@ public:
 	}
 };
 //---------------------------------------------------------------------------
+// keyed sort
+//---------------------------------------------------------------------------
+/*
+	When all the items are of types whose order the sort method decides
+	without calling back into the script, the sort key of each item is
+	extracted once and the keys are sorted instead of the items; this avoids
+	per-comparison type dispatch and tTJSVariant copying (reference
+	counting) while the items are moved around.
+
+	Keys carry the original item index and equal keys are ordered by the
+	index, so keyed sorts are always stable. Results are the same as with
+	the comparators above; item sets for which the comparators are not
+	consistent (NaNs, strings mixed with numbers in normal order, integers
+	which can not be exactly represented as real mixed with reals) are left
+	to the comparators.
+*/
+#define TJS_ARRAY_RADIX_SORT_MIN 64
+	/* all-integer arrays shorter than this are sorted by std::sort */
+#define TJS_ARRAY_PARALLEL_SORT_MIN 65536
+	/* key arrays this size or longer are sorted by multiple threads */
+#define TJS_ARRAY_PARALLEL_SORT_MAX_THREADS 8
+//---------------------------------------------------------------------------
+struct tTJSArrayRealSortKey
+{
+	tjs_real Key;
+	tjs_uint Index;
+};
+struct tTJSArrayIntegerSortKey
+{
+	tjs_int64 Key;
+	tjs_uint Index;
+};
+struct tTJSArrayStringSortKey
+{
+	tjs_uint64 Prefix; // first two characters, to skip most TJS_strcmp calls
+	const tjs_char *Key;
+	tjs_uint Index;
+};
+//---------------------------------------------------------------------------
+template <typename T>
+struct tTJSArrayKeyAscending
+{
+	bool operator () (const T &lhs, const T &rhs) const
+	{
+		if(lhs.Key < rhs.Key) return true;
+		if(rhs.Key < lhs.Key) return false;
+		return lhs.Index < rhs.Index;
+	}
+};
+template <typename T>
+struct tTJSArrayKeyDescending
+{
+	bool operator () (const T &lhs, const T &rhs) const
+	{
+		if(lhs.Key > rhs.Key) return true;
+		if(rhs.Key > lhs.Key) return false;
+		return lhs.Index < rhs.Index;
+	}
+};
+//---------------------------------------------------------------------------
+static inline tjs_int TJSArrayCompareStringKey(const tTJSArrayStringSortKey &lhs,
+	const tTJSArrayStringSortKey &rhs)
+{
+	if(lhs.Prefix != rhs.Prefix) return lhs.Prefix < rhs.Prefix ? -1 : 1;
+	// the prefixes are the same; the strings end within the prefix if the
+	// second character is zero
+	if(!(lhs.Prefix & 0xffffffff)) return 0;
+	return TJS_strcmp(lhs.Key + 2, rhs.Key + 2);
+}
+struct tTJSArrayStringKeyAscending
+{
+	bool operator () (const tTJSArrayStringSortKey &lhs,
+		const tTJSArrayStringSortKey &rhs) const
+	{
+		tjs_int c = TJSArrayCompareStringKey(lhs, rhs);
+		return c ? c < 0 : lhs.Index < rhs.Index;
+	}
+};
+struct tTJSArrayStringKeyDescending
+{
+	bool operator () (const tTJSArrayStringSortKey &lhs,
+		const tTJSArrayStringSortKey &rhs) const
+	{
+		tjs_int c = TJSArrayCompareStringKey(lhs, rhs);
+		return c ? c > 0 : lhs.Index < rhs.Index;
+	}
+};
+//---------------------------------------------------------------------------
+static void TJSArrayMakeStringKey(tTJSArrayStringSortKey &key,
+	const tjs_char *str, tjs_uint index)
+{
+	if(!str) str = TJS_W("");
+	key.Key = str;
+	key.Index = index;
+	tjs_uint64 c0 = (tjs_uint32)str[0];
+	tjs_uint64 c1 = c0 ? (tjs_uint32)str[1] : 0;
+	key.Prefix = (c0 << 32) | c1;
+}
+//---------------------------------------------------------------------------
+tjs_int (*TJSGetParallelTaskNum)() = NULL;
+bool (*TJSExecParallelTasks)(tjs_int num, tTJSParallelTaskFunc func,
+	void * const *params) = NULL;
+//---------------------------------------------------------------------------
+template <typename T, typename COMP>
+struct tTJSArrayParallelSortTask
+{
+	T *Begin;
+	T *End;
+	COMP Comp;
+};
+template <typename T, typename COMP>
+static void TJS_USERENTRY TJSArrayParallelSortProc(void *param)
+{
+	tTJSArrayParallelSortTask<T, COMP> *task =
+		(tTJSArrayParallelSortTask<T, COMP> *)param;
+	std::sort(task->Begin, task->End, task->Comp);
+}
+//---------------------------------------------------------------------------
+static tjs_int TJSArrayGetSortThreadCount()
+{
+	if(!TJSGetParallelTaskNum || !TJSExecParallelTasks) return 1;
+	tjs_int count = TJSGetParallelTaskNum();
+	if(count < 1) count = 1;
+	if(count > TJS_ARRAY_PARALLEL_SORT_MAX_THREADS)
+		count = TJS_ARRAY_PARALLEL_SORT_MAX_THREADS;
+	return count;
+}
+//---------------------------------------------------------------------------
+template <typename T, typename COMP>
+static void TJSArraySortKeys(std::vector<T> &keys, COMP comp)
+{
+	// the keys are plain data and the comparators do not touch any TJS
+	// object, so large key arrays can be sorted on the thread pool: each
+	// task sorts one run, and the runs are merged afterwards.
+	tjs_int threads = TJSArrayGetSortThreadCount();
+	if(keys.size() < TJS_ARRAY_PARALLEL_SORT_MIN || threads < 2)
+	{
+		std::sort(keys.begin(), keys.end(), comp);
+		return;
+	}
+
+	tjs_uint count = (tjs_uint)keys.size();
+	std::vector<tjs_uint> bounds(threads + 1);
+	for(tjs_int i = 0; i <= threads; i++)
+		bounds[i] = (tjs_uint)((tjs_uint64)count * i / threads);
+
+	tTJSArrayParallelSortTask<T, COMP> tasks[TJS_ARRAY_PARALLEL_SORT_MAX_THREADS];
+	void *params[TJS_ARRAY_PARALLEL_SORT_MAX_THREADS];
+	for(tjs_int i = 0; i < threads; i++)
+	{
+		tasks[i].Begin = &keys[0] + bounds[i];
+		tasks[i].End = &keys[0] + bounds[i+1];
+		tasks[i].Comp = comp;
+		params[i] = tasks + i;
+	}
+	if(!TJSExecParallelTasks(threads, TJSArrayParallelSortProc<T, COMP>, params))
+	{
+		// the pool is used by another thread
+		std::sort(keys.begin(), keys.end(), comp);
+		return;
+	}
+
+	// merge the runs, doubling the run length on each pass
+	std::vector<T> buf(count);
+	std::vector<T> *src = &keys, *dest = &buf;
+	for(tjs_int width = 1; width < threads; width *= 2)
+	{
+		for(tjs_int i = 0; i < threads; i += width * 2)
+		{
+			tjs_uint b = bounds[i];
+			tjs_uint m = bounds[std::min(i + width, threads)];
+			tjs_uint e = bounds[std::min(i + width * 2, threads)];
+			std::merge(src->begin() + b, src->begin() + m,
+				src->begin() + m, src->begin() + e, dest->begin() + b, comp);
+		}
+		std::swap(src, dest);
+	}
+	if(src != &keys) keys.swap(buf);
+}
+//---------------------------------------------------------------------------
+template <typename T>
+static void TJSArrayPermute(std::vector<tTJSVariant> &items,
+	const std::vector<T> &keys)
+{
+	// rearrange the items in the order of the sorted keys
+	std::vector<tTJSVariant> sorted;
+	sorted.reserve(items.size());
+	for(typename std::vector<T>::const_iterator i = keys.begin();
+		i != keys.end(); i++)
+		sorted.push_back(items[i->Index]);
+	items.swap(sorted);
+}
+//---------------------------------------------------------------------------
+static void TJSArrayRadixSort(std::vector<tjs_int64> &keys)
+{
+	// LSD radix sort by 8 bits, skipping the digits which all keys share
+	tjs_uint count = (tjs_uint)keys.size();
+	std::vector<tjs_uint64> buf1(count), buf2(count);
+	const tjs_uint64 signbit = TJS_UI64_VAL(0x8000000000000000);
+	for(tjs_uint i = 0; i < count; i++)
+		buf1[i] = (tjs_uint64)keys[i] ^ signbit; // make it order as unsigned
+
+	tjs_uint64 *src = &buf1[0], *dest = &buf2[0];
+	for(tjs_int shift = 0; shift < 64; shift += 8)
+	{
+		tjs_uint hist[256];
+		memset(hist, 0, sizeof(hist));
+		for(tjs_uint i = 0; i < count; i++) hist[(src[i] >> shift) & 0xff]++;
+		if(hist[(src[0] >> shift) & 0xff] == count) continue;
+
+		tjs_uint pos = 0;
+		for(tjs_int d = 0; d < 256; d++)
+		{
+			tjs_uint n = hist[d];
+			hist[d] = pos;
+			pos += n;
+		}
+		for(tjs_uint i = 0; i < count; i++)
+			dest[hist[(src[i] >> shift) & 0xff]++] = src[i];
+		std::swap(src, dest);
+	}
+
+	for(tjs_uint i = 0; i < count; i++)
+		keys[i] = (tjs_int64)(src[i] ^ signbit);
+}
+//---------------------------------------------------------------------------
+static bool TJSArraySortIntegers(std::vector<tTJSVariant> &items,
+	bool descending)
+{
+	// all items are integer; the items have no identity other than the
+	// value, so the sorted values are simply written back.
+	tjs_uint count = (tjs_uint)items.size();
+	std::vector<tjs_int64> keys(count);
+	for(tjs_uint i = 0; i < count; i++) keys[i] = items[i].AsInteger();
+
+	if(count < TJS_ARRAY_RADIX_SORT_MIN)
+		std::sort(keys.begin(), keys.end());
+	else
+		TJSArrayRadixSort(keys);
+
+	if(descending) std::reverse(keys.begin(), keys.end());
+	for(tjs_uint i = 0; i < count; i++) items[i] = (tTVInteger)keys[i];
+	return true;
+}
+//---------------------------------------------------------------------------
+static bool TJSArraySortNumbers(std::vector<tTJSVariant> &items,
+	const std::vector<tTJSVariant> &numbers, bool descending)
+{
+	// numbers[i] is the numeric value of items[i] (integer or real).
+	// comparators compare two integers as integer, otherwise as real.
+	tjs_uint count = (tjs_uint)items.size();
+	bool allint = true;
+	for(tjs_uint i = 0; i < count; i++)
+	{
+		if(numbers[i].Type() != tvtInteger) { allint = false; break; }
+	}
+
+	if(allint)
+	{
+		std::vector<tTJSArrayIntegerSortKey> keys(count);
+		for(tjs_uint i = 0; i < count; i++)
+			keys[i].Key = numbers[i].AsInteger(), keys[i].Index = i;
+		if(descending)
+			TJSArraySortKeys(keys, tTJSArrayKeyDescending<tTJSArrayIntegerSortKey>());
+		else
+			TJSArraySortKeys(keys, tTJSArrayKeyAscending<tTJSArrayIntegerSortKey>());
+		TJSArrayPermute(items, keys);
+		return true;
+	}
+
+	// mixed: all must be comparable as real
+	const tjs_int64 maxexact = TJS_I64_VAL(0x20000000000000); // 2^53
+	std::vector<tTJSArrayRealSortKey> keys(count);
+	for(tjs_uint i = 0; i < count; i++)
+	{
+		const tTJSVariant &v = numbers[i];
+		if(v.Type() == tvtInteger)
+		{
+			tjs_int64 n = v.AsInteger();
+			if(n > maxexact || n < -maxexact) return false;
+			keys[i].Key = (tjs_real)n;
+		}
+		else
+		{
+			keys[i].Key = v.AsReal();
+			if(keys[i].Key != keys[i].Key) return false; // NaN
+		}
+		keys[i].Index = i;
+	}
+	if(descending)
+		TJSArraySortKeys(keys, tTJSArrayKeyDescending<tTJSArrayRealSortKey>());
+	else
+		TJSArraySortKeys(keys, tTJSArrayKeyAscending<tTJSArrayRealSortKey>());
+	TJSArrayPermute(items, keys);
+	return true;
+}
+//---------------------------------------------------------------------------
+static void TJSArraySortStrings(std::vector<tTJSVariant> &items,
+	const tjs_char * const * strings, bool descending)
+{
+	tjs_uint count = (tjs_uint)items.size();
+	std::vector<tTJSArrayStringSortKey> keys(count);
+	for(tjs_uint i = 0; i < count; i++)
+		TJSArrayMakeStringKey(keys[i], strings[i], i);
+	if(descending)
+		TJSArraySortKeys(keys, tTJSArrayStringKeyDescending());
+	else
+		TJSArraySortKeys(keys, tTJSArrayStringKeyAscending());
+	TJSArrayPermute(items, keys);
+}
+//---------------------------------------------------------------------------
+static bool TJSArraySortByKeys(std::vector<tTJSVariant> &items,
+	tjs_nchar method)
+{
+	// sorts items by the method ('+', '-', '0', '9', 'a' or 'z') using the
+	// keyed sort. returns false if the items must be sorted by the
+	// comparators.
+	tjs_uint count = (tjs_uint)items.size();
+	if(count < 2) return true;
+
+	bool descending =
+		method == TJS_N('-') || method == TJS_N('9') || method == TJS_N('z');
+
+	// count item types
+	tjs_uint ints = 0, reals = 0, strings = 0, others = 0;
+	for(tjs_uint i = 0; i < count; i++)
+	{
+		switch(items[i].Type())
+		{
+		case tvtInteger:	ints++;		break;
+		case tvtReal:		reals++;	break;
+		case tvtString:		strings++;	break;
+		case tvtVoid:		if(method == TJS_N('a') || method == TJS_N('z'))
+								{ strings++; break; } // converts to ""
+							others++;	break;
+		default:			others++;	break;
+		}
+	}
+	if(others) return false;
+
+	switch(method)
+	{
+	case TJS_N('+'):
+	case TJS_N('-'):
+		if(ints == count) return TJSArraySortIntegers(items, descending);
+		if(strings == count)
+		{
+			std::vector<const tjs_char *> strs(count);
+			for(tjs_uint i = 0; i < count; i++)
+				strs[i] = *items[i].AsStringNoAddRef();
+			TJSArraySortStrings(items, &strs[0], descending);
+			return true;
+		}
+		if(strings) return false; // strings mixed with numbers
+		return TJSArraySortNumbers(items, items, descending);
+
+	case TJS_N('0'):
+	case TJS_N('9'):
+	  {
+		if(ints == count) return TJSArraySortIntegers(items, descending);
+		if(!strings) return TJSArraySortNumbers(items, items, descending);
+		if(strings != count) return false;
+			// strings mixed with numbers are compared as real
+
+		// convert the strings to numbers once
+		std::vector<tTJSVariant> numbers(items);
+		for(tjs_uint i = 0; i < count; i++) numbers[i].tonumber();
+		return TJSArraySortNumbers(items, numbers, descending);
+	  }
+
+	case TJS_N('a'):
+	case TJS_N('z'):
+	  {
+		std::vector<ttstr> conv; // string forms of non-string items
+		conv.reserve(count - strings);
+		std::vector<const tjs_char *> strs(count);
+		for(tjs_uint i = 0; i < count; i++)
+		{
+			if(items[i].Type() == tvtString)
+			{
+				strs[i] = *items[i].AsStringNoAddRef();
+			}
+			else
+			{
+				conv.push_back((ttstr)items[i]);
+				strs[i] = conv.back().c_str();
+			}
+		}
+		TJSArraySortStrings(items, &strs[0], descending);
+		return true;
+	  }
+	}
+
+	return false;
+}
+//---------------------------------------------------------------------------
+class tTJSArraySortCompare_FunctionalRef
+{
+	// compares items through pointers; sorting pointers instead of
+	// tTJSVariant avoids reference counting on each move of the items
+	tTJSArraySortCompare_Functional Compare;
+public:
+	tTJSArraySortCompare_FunctionalRef(const tTJSVariantClosure &clo) :
+		Compare(clo)
+	{
+	}
+
+	bool operator () (const tTJSVariant *lhs, const tTJSVariant *rhs) const
+	{
+		return Compare(*lhs, *rhs);
+	}
+};
+//---------------------------------------------------------------------------
+static void TJSArraySortFunctional(std::vector<tTJSVariant> &items,
+	const tTJSVariantClosure &closure, bool stable)
+{
+	tjs_uint count = (tjs_uint)items.size();
+	if(count < 2) return;
+
+	// the comparison function may modify or resize the array, which would
+	// free the items the pointers refer to; so the pointers refer to a copy
+	// of the items, and the sorted copy replaces the array at the end.
+	std::vector<tTJSVariant> copy(items);
+	std::vector<tTJSVariant *> ptrs(count);
+	for(tjs_uint i = 0; i < count; i++) ptrs[i] = &copy[i];
+
+	if(stable)
+		std::stable_sort(ptrs.begin(), ptrs.end(),
+			tTJSArraySortCompare_FunctionalRef(closure));
+	else
+		std::sort(ptrs.begin(), ptrs.end(),
+			tTJSArraySortCompare_FunctionalRef(closure));
+
+	std::vector<tTJSVariant> sorted;
+	sorted.reserve(count);
+	for(tjs_uint i = 0; i < count; i++) sorted.push_back(*ptrs[i]);
+	items.swap(sorted);
+}
+//---------------------------------------------------------------------------
 
 
 
@@ -382,9 +817,11 @@ TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/loadStruct)
 		if( streamlen >= tTJSBinarySerializer::HEADER_LENGTH ) {
 			tjs_uint8 header[tTJSBinarySerializer::HEADER_LENGTH];
 			stream->Read( header, tTJSBinarySerializer::HEADER_LENGTH );
-			if( tTJSBinarySerializer::IsBinary( header ) ) {
+			bool islog = tTJSBinaryLog::IsLog( header );
+			if( islog || tTJSBinarySerializer::IsBinary( header ) ) {
 				tTJSBinarySerializer binload((tTJSArrayObject*)objthis);
-				tTJSVariant* var = binload.Read( stream );
+				tTJSVariant* var = islog ?
+					tTJSBinaryLog::Read( stream, binload ) : binload.Read( stream );
 				if( var ) {
 					if( result ) *result = *var;
 					delete var;
@@ -460,13 +897,20 @@ TJS_BEGIN_NATIVE_METHOD_DECL(/* func. name */saveStruct)
 	ttstr mode;
 	if(numparams >= 2 && param[1]->Type() != tvtVoid) mode = *param[1];
 
-	if( TJS_strchr(mode.c_str(), TJS_W('b')) != NULL ) {
+	if( TJS_strchr(mode.c_str(), TJS_W('i')) != NULL ) {
+		// incremental binary; only the changed objects are appended
+		tTJSBinaryLog::Write(name, objthis);
+	} else if( TJS_strchr(mode.c_str(), TJS_W('b')) != NULL ) {
+		// 's' : v2 format with the shared string table
+		tTJSBinaryStringTable strings( TJS_strchr(mode.c_str(), TJS_W('s')) != NULL );
 		tTJSBinaryStream* stream = TJSCreateBinaryStreamForWrite(name, mode);
 		try {
-			stream->Write( tTJSBinarySerializer::HEADER, tTJSBinarySerializer::HEADER_LENGTH );
+			stream->Write( strings.GetEnabled() ?
+				tTJSBinarySerializer::HEADER_V2 : tTJSBinarySerializer::HEADER,
+				tTJSBinarySerializer::HEADER_LENGTH );
 			std::vector<iTJSDispatch2 *> stack;
 			stack.push_back(objthis);
-			ni->SaveStructuredBinary(stack, *stream);
+			ni->SaveStructuredBinary(stack, *stream, strings);
 		} catch(...) {
 			delete stream;
 			throw;
@@ -667,6 +1111,15 @@ TJS_BEGIN_NATIVE_METHOD_DECL(/* func.name */sort)
 
 
 	// sort
+	if(method == 0)
+	{
+		TJSArraySortFunctional(ni->Items, closure, do_stable_sort);
+		return TJS_S_OK;
+	}
+
+	if(TJSArraySortByKeys(ni->Items, method))
+		return TJS_S_OK; // sorted by the keys (always stable)
+
 	switch(method)
 	{
 	case TJS_N('+'):
@@ -1206,7 +1659,8 @@ void tTJSArrayNI::SaveStructuredDataForObject(iTJSDispatch2 *dsp,
 	}
 }
 //---------------------------------------------------------------------------
-void tTJSArrayNI::SaveStructuredBinary(std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream )
+void tTJSArrayNI::SaveStructuredBinary(std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream,
+	tTJSBinaryStringTable &strings )
 {
 	tjs_uint count = (tjs_uint)Items.size();
 	tTJSBinarySerializer::PutStartArray( &stream, count );
@@ -1217,15 +1671,16 @@ void tTJSArrayNI::SaveStructuredBinary(std::vector<iTJSDispatch2 *> &stack, tTJS
 		if( type == tvtObject ){
 			// object
 			tTJSVariantClosure clo = i->AsObjectClosureNoAddRef();
-			SaveStructuredBinaryForObject( clo.SelectObjectNoAddRef(), stack, stream );
+			SaveStructuredBinaryForObject( clo.SelectObjectNoAddRef(), stack, stream, strings );
 		} else {
-			tTJSBinarySerializer::PutVariant( &stream, *i );
+			tTJSBinarySerializer::PutVariant( &stream, *i, &strings );
 		}
 	}
 }
 //---------------------------------------------------------------------------
 void tTJSArrayNI::SaveStructuredBinaryForObject(iTJSDispatch2 *dsp,
-		std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream )
+		std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream,
+		tTJSBinaryStringTable &strings )
 {
 	// check object recursion
 	std::vector<iTJSDispatch2 *>::iterator i;
@@ -1244,13 +1699,13 @@ void tTJSArrayNI::SaveStructuredBinaryForObject(iTJSDispatch2 *dsp,
 		TJSGetDictionaryClassID(), (iTJSNativeInstance**)&dicni)) ) {
 		// dictionary
 		stack.push_back(dsp);
-		dicni->SaveStructuredBinary( stack, stream );
+		dicni->SaveStructuredBinary( stack, stream, strings );
 		stack.pop_back();
 	} else if(dsp && TJS_SUCCEEDED(dsp->NativeInstanceSupport(TJS_NIS_GETINSTANCE,
 		ClassID_Array, (iTJSNativeInstance**)&arrayni)) ) {
 		// array
 		stack.push_back(dsp);
-		arrayni->SaveStructuredBinary( stack, stream );
+		arrayni->SaveStructuredBinary( stack, stream, strings );
 		stack.pop_back();
 	} else if(dsp != NULL) {
 		// other objects
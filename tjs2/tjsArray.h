@@ -21,6 +21,7 @@
 
 namespace TJS
 {
+class tTJSBinaryStringTable;
 //---------------------------------------------------------------------------
 // tTJSStringAppender
 //---------------------------------------------------------------------------
@@ -54,7 +55,8 @@ struct tTJSSaveStructuredDataCallback
 	virtual void SaveStructuredData(std::vector<iTJSDispatch2 *> &stack,
                                         iTJSTextWriteStream &stream, const ttstr&indentstr) = 0;
 
-	virtual void SaveStructuredBinary(std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream ) = 0;
+	virtual void SaveStructuredBinary(std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream,
+		tTJSBinaryStringTable &strings ) = 0;
 
 };
 //---------------------------------------------------------------------------
@@ -110,12 +112,14 @@ private:
 public:
 	void SaveStructuredData(std::vector<iTJSDispatch2 *> &stack,
 		iTJSTextWriteStream &stream, const ttstr&indentstr);
-	void SaveStructuredBinary(std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream );
+	void SaveStructuredBinary(std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream,
+		tTJSBinaryStringTable &strings );
 		// method from tTJSSaveStructuredDataCallback
 	static void SaveStructuredDataForObject(iTJSDispatch2 *dsp,
 		std::vector<iTJSDispatch2 *> &stack, iTJSTextWriteStream &stream, const ttstr&indentstr);
 	static void SaveStructuredBinaryForObject(iTJSDispatch2 *dsp,
-		std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream );
+		std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream,
+		tTJSBinaryStringTable &strings );
 
 	void AssignStructure(iTJSDispatch2 * dsp, std::vector<iTJSDispatch2 *> &stack);
 //---------------------------------------------------------------------------
@@ -285,6 +289,22 @@ TJS_EXP_FUNC_DEF(iTJSDispatch2 *, TJSCreateArrayObject, (iTJSDispatch2 **classou
 
 
 
+//---------------------------------------------------------------------------
+// parallel sort
+//---------------------------------------------------------------------------
+typedef void (TJS_USERENTRY *tTJSParallelTaskFunc)(void *param);
+extern tjs_int (*TJSGetParallelTaskNum)();
+	// returns the number of threads which may run tasks at once.
+extern bool (*TJSExecParallelTasks)(tjs_int num, tTJSParallelTaskFunc func,
+	void * const *params);
+	// runs func(params[i]) for each i < num on the application's thread
+	// pool, and returns after all have finished; returns false without
+	// running any when the pool is busy. large arrays are sorted by these
+	// if the application sets both, otherwise on the calling thread.
+//---------------------------------------------------------------------------
+
+
+
 //---------------------------------------------------------------------------
 // Utility functions
 //---------------------------------------------------------------------------
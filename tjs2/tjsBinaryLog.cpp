@@ -0,0 +1,586 @@
+//---------------------------------------------------------------------------
+/*
+	TJS2 Script Engine
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Incremental binary structured data ( saveStruct with "i" mode )
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include <map>
+#include "tjs.h"
+#include "tjsBinaryLog.h"
+#include "tjsDictionary.h"
+#include "tjsArray.h"
+
+namespace TJS
+{
+//---------------------------------------------------------------------------
+const tjs_uint8 tTJSBinaryLog::HEADER[tTJSBinarySerializer::HEADER_LENGTH] = {
+	'K','B','A','L', '1','0','0', 0
+};
+bool tTJSBinaryLog::IsLog( const tjs_uint8 header[tTJSBinarySerializer::HEADER_LENGTH] ) {
+	return memcmp( HEADER, header, tTJSBinarySerializer::HEADER_LENGTH ) == 0;
+}
+//---------------------------------------------------------------------------
+static const tjs_uint TJS_BINARY_LOG_RECORD_HEADER = 9; // LOG_RECORD, ID, 長さ
+static const tjs_uint64 TJS_BINARY_LOG_COMPACT_RATIO = 2;
+static const tjs_uint64 TJS_BINARY_LOG_COMPACT_MIN = 65536;
+static const tjs_uint TJS_BINARY_LOG_MAX_WRITERS = 16;
+//---------------------------------------------------------------------------
+/**
+ * レコードを組み立てるためのメモリ上のストリーム
+ */
+class tTJSBinaryLogBuffer : public tTJSBinaryStream {
+	std::vector<tjs_uint8> Data;
+	tjs_uint Position;
+
+public:
+	tTJSBinaryLogBuffer() : Position(0) {}
+
+	tjs_uint64 TJS_INTF_METHOD Seek( tjs_int64 offset, tjs_int whence ) {
+		tjs_int64 newpos;
+		switch( whence ) {
+		case TJS_BS_SEEK_SET: newpos = offset; break;
+		case TJS_BS_SEEK_CUR: newpos = (tjs_int64)Position + offset; break;
+		case TJS_BS_SEEK_END: newpos = (tjs_int64)Data.size() + offset; break;
+		default: return Position;
+		}
+		if( newpos >= 0 && newpos <= (tjs_int64)Data.size() ) Position = (tjs_uint)newpos;
+		return Position;
+	}
+	tjs_uint TJS_INTF_METHOD Read( void *buffer, tjs_uint read_size ) {
+		tjs_uint remain = (tjs_uint)Data.size() - Position;
+		if( read_size > remain ) read_size = remain;
+		if( read_size ) memcpy( buffer, &Data[Position], read_size );
+		Position += read_size;
+		return read_size;
+	}
+	tjs_uint TJS_INTF_METHOD Write( const void *buffer, tjs_uint write_size ) {
+		if( write_size == 0 ) return 0;
+		if( Position + write_size > Data.size() ) Data.resize( Position + write_size );
+		memcpy( &Data[Position], buffer, write_size );
+		Position += write_size;
+		return write_size;
+	}
+	tjs_uint64 TJS_INTF_METHOD GetSize() { return Data.size(); }
+
+	const tjs_uint8* GetData() const { return Data.empty() ? NULL : &Data[0]; }
+	tjs_uint GetLength() const { return (tjs_uint)Data.size(); }
+	void Clear() { std::vector<tjs_uint8>().swap( Data ); Position = 0; }
+};
+//---------------------------------------------------------------------------
+static void TJSBinaryLogPut32( tTJSBinaryStream* stream, tjs_uint8 type, tjs_uint32 v )
+{
+	tjs_uint8 tmp[5];
+	tmp[0] = type;
+	tmp[1] = (tjs_uint8)( v&0xff );
+	tmp[2] = (tjs_uint8)( (v>>8)&0xff );
+	tmp[3] = (tjs_uint8)( (v>>16)&0xff );
+	tmp[4] = (tjs_uint8)( (v>>24)&0xff );
+	stream->Write( tmp, sizeof(tmp) );
+}
+//---------------------------------------------------------------------------
+static tjs_uint64 TJSBinaryLogHash( const tjs_uint8* data, tjs_uint len )
+{
+	// FNV-1a
+	tjs_uint64 hash = TJS_UI64_VAL(0xcbf29ce484222325);
+	for( tjs_uint i = 0; i < len; i++ ) {
+		hash ^= data[i];
+		hash *= TJS_UI64_VAL(0x100000001b3);
+	}
+	return hash;
+}
+//---------------------------------------------------------------------------
+// 書き出し側
+//---------------------------------------------------------------------------
+/**
+ * ストレージひとつ分の書き出し状態
+ * オブジェクトごとに前回書き出したレコードの ID と中身を覚えておき、
+ * 内容が同じならレコードを書き出さない (ハッシュは比較を早く打ち切るためだけに
+ * 使い、ハッシュが一致した場合は中身を比較する)
+ * オブジェクトは参照を持たずにポインタだけで覚えているので、解放された
+ * オブジェクトのアドレスが再利用されても、内容が変わっていれば書き直される
+ */
+class tTJSBinaryLogWriter {
+	struct tEntry {
+		tjs_uint32 ID;
+		tjs_uint32 Generation; // 最後に辿った書き出しの世代
+		tjs_uint32 Length;
+		tjs_uint64 Hash;
+		std::vector<tjs_uint8> Body; // 前回書き出したレコードの中身
+		tEntry() : ID(0), Generation(0), Length(0), Hash(0) {}
+	};
+	typedef std::map<iTJSDispatch2*, tEntry> tEntryMap;
+
+	ttstr Name;
+	tjs_uint64 FileSize; // 0 の場合はまだ書き出していない
+	tjs_uint64 LiveSize; // 生きているレコードの合計
+	tjs_uint32 NextID;
+	tjs_uint32 Generation;
+	tEntryMap Entries;
+	std::vector<iTJSDispatch2*> Stack; // 再帰の検出用
+	tTJSBinaryLogBuffer Output; // 今回書き出すレコード
+
+public:
+	tTJSBinaryLogWriter( const ttstr& name ) : Name(name), FileSize(0),
+		LiveSize(0), NextID(1), Generation(0) {}
+
+	const ttstr& GetName() const { return Name; }
+
+	void Write( iTJSDispatch2* root );
+	void PutValue( tTJSBinaryStream* body, const tTJSVariant& v );
+
+private:
+	void Reset();
+	tjs_uint32 Snapshot( iTJSDispatch2* root );
+	tjs_uint32 PutObject( iTJSDispatch2* dsp );
+};
+//---------------------------------------------------------------------------
+struct tTJSBinaryLogDictionaryCallback : public tTJSDispatch {
+	tTJSBinaryLogWriter* Writer;
+	tTJSBinaryStream* Body;
+	tjs_uint Count;
+
+	tTJSBinaryLogDictionaryCallback() : Count(0) {}
+
+	tjs_error TJS_INTF_METHOD
+	FuncCall(tjs_uint32 flag, const tjs_char * membername,
+		tjs_uint32 *hint, tTJSVariant *result, tjs_int numparams,
+		tTJSVariant **param, iTJSDispatch2 *objthis)
+	{
+		if(numparams < 3) return TJS_E_BADPARAMCOUNT;
+
+		// hidden members are not processed
+		tjs_uint32 flags = (tjs_int)*param[1];
+		if( (flags & TJS_HIDDENMEMBER) == 0 ) {
+			tTJSBinarySerializer::PutString( Body, param[0]->AsStringNoAddRef() );
+			Writer->PutValue( Body, *param[2] );
+			Count++;
+		}
+		if(result) *result = (tjs_int)1;
+		return TJS_S_OK;
+	}
+};
+//---------------------------------------------------------------------------
+void tTJSBinaryLogWriter::Reset()
+{
+	FileSize = 0;
+	LiveSize = 0;
+	NextID = 1;
+	Entries.clear();
+	Stack.clear();
+	Output.Clear();
+}
+//---------------------------------------------------------------------------
+void tTJSBinaryLogWriter::PutValue( tTJSBinaryStream* body, const tTJSVariant& v )
+{
+	if( v.Type() == tvtObject ) {
+		tTJSVariantClosure clo = v.AsObjectClosureNoAddRef();
+		tjs_uint32 id = PutObject( clo.SelectObjectNoAddRef() );
+		if( id ) {
+			TJSBinaryLogPut32( body, tTJSBinaryLog::TYPE_OBJECT_REF, id );
+		} else {
+			tTJSBinarySerializer::PutNull( body );
+		}
+	} else {
+		tTJSBinarySerializer::PutVariant( body, const_cast<tTJSVariant&>(v) );
+	}
+}
+//---------------------------------------------------------------------------
+/**
+ * dsp のレコードを作って ID を返す
+ * 前回と内容が変わっていればレコードを Output に追加する
+ * 辞書/配列以外のオブジェクトと、再帰している場合は 0 (null として書き出す)
+ */
+tjs_uint32 tTJSBinaryLogWriter::PutObject( iTJSDispatch2* dsp )
+{
+	if( !dsp ) return 0;
+
+	tTJSDictionaryNI *dicni = NULL;
+	tTJSArrayNI *arrayni = NULL;
+	if( TJS_FAILED(dsp->NativeInstanceSupport(TJS_NIS_GETINSTANCE,
+		TJSGetDictionaryClassID(), (iTJSNativeInstance**)&dicni)) &&
+		TJS_FAILED(dsp->NativeInstanceSupport(TJS_NIS_GETINSTANCE,
+		TJSGetArrayClassID(), (iTJSNativeInstance**)&arrayni)) ) {
+		return 0;
+	}
+
+	// check object recursion
+	std::vector<iTJSDispatch2 *>::iterator si;
+	for( si = Stack.begin(); si != Stack.end(); si++ ) {
+		if( *si == dsp ) return 0;
+	}
+
+	// 今回すでに辿ったオブジェクト (複数から参照されている)
+	tEntryMap::iterator it = Entries.find( dsp );
+	if( it != Entries.end() && it->second.Generation == Generation ) return it->second.ID;
+
+	tTJSBinaryLogBuffer body;
+	Stack.push_back( dsp );
+	try {
+		if( dicni ) {
+			tTJSBinaryLogBuffer members;
+			tTJSBinaryLogDictionaryCallback callback;
+			callback.Writer = this;
+			callback.Body = &members;
+			tTJSVariantClosure clo( &callback, NULL );
+			dsp->EnumMembers( TJS_IGNOREPROP, &clo, dsp );
+			tTJSBinarySerializer::PutStartMap( &body, callback.Count );
+			body.Write( members.GetData(), members.GetLength() );
+		} else {
+			tTJSBinarySerializer::PutStartArray( &body, (tjs_uint)arrayni->Items.size() );
+			tTJSArrayNI::tArrayItemIterator i;
+			for( i = arrayni->Items.begin(); i != arrayni->Items.end(); i++ ) {
+				PutValue( &body, *i );
+			}
+		}
+	} catch(...) {
+		Stack.pop_back();
+		throw;
+	}
+	Stack.pop_back();
+
+	tjs_uint len = body.GetLength();
+	tjs_uint64 hash = TJSBinaryLogHash( body.GetData(), len );
+
+	it = Entries.find( dsp );
+	if( it != Entries.end() ) {
+		if( it->second.Length == len && it->second.Hash == hash &&
+			( len == 0 || !memcmp( &it->second.Body[0], body.GetData(), len ) ) ) {
+			// 変わっていない
+			it->second.Generation = Generation;
+			return it->second.ID;
+		}
+		LiveSize -= it->second.Length + TJS_BINARY_LOG_RECORD_HEADER;
+	} else {
+		tEntry entry;
+		entry.ID = NextID++;
+		it = Entries.insert( tEntryMap::value_type( dsp, entry ) ).first;
+	}
+	tEntry& entry = it->second;
+	entry.Generation = Generation;
+	entry.Length = len;
+	entry.Hash = hash;
+	entry.Body.assign( body.GetData(), body.GetData() + len );
+	LiveSize += len + TJS_BINARY_LOG_RECORD_HEADER;
+
+	TJSBinaryLogPut32( &Output, tTJSBinaryLog::LOG_RECORD, entry.ID );
+	tjs_uint8 tmp[4];
+	tmp[0] = (tjs_uint8)( len&0xff );
+	tmp[1] = (tjs_uint8)( (len>>8)&0xff );
+	tmp[2] = (tjs_uint8)( (len>>16)&0xff );
+	tmp[3] = (tjs_uint8)( (len>>24)&0xff );
+	Output.Write( tmp, sizeof(tmp) );
+	Output.Write( body.GetData(), len );
+	return entry.ID;
+}
+//---------------------------------------------------------------------------
+/**
+ * root から辿れるオブジェクトのうち、変わったものを Output に書き出す
+ * 辿れなくなったオブジェクトは忘れる
+ */
+tjs_uint32 tTJSBinaryLogWriter::Snapshot( iTJSDispatch2* root )
+{
+	Generation++;
+	Output.Clear();
+	Stack.clear();
+	tjs_uint32 rootid = PutObject( root );
+	if( rootid == 0 ) TJS_eTJSError( TJSSpecifyDicOrArray );
+
+	tEntryMap::iterator it = Entries.begin();
+	while( it != Entries.end() ) {
+		if( it->second.Generation != Generation ) {
+			LiveSize -= it->second.Length + TJS_BINARY_LOG_RECORD_HEADER;
+			Entries.erase( it++ );
+		} else {
+			it++;
+		}
+	}
+	return rootid;
+}
+//---------------------------------------------------------------------------
+void tTJSBinaryLogWriter::Write( iTJSDispatch2* root )
+{
+	tTJSBinaryStream* stream = NULL;
+	try {
+		tjs_uint32 rootid = Snapshot( root );
+
+		// 追記するとファイルが大きくなりすぎる場合は全体を書き直す
+		bool compact = FileSize == 0 ||
+			FileSize + Output.GetLength() > LiveSize * TJS_BINARY_LOG_COMPACT_RATIO + TJS_BINARY_LOG_COMPACT_MIN;
+		if( !compact ) {
+			tjs_char mode[32];
+			mode[0] = TJS_W('o');
+			TJS_tTVInt_to_str( (tjs_int64)FileSize, mode + 1 );
+			stream = TJSCreateBinaryStreamForWrite( Name, mode );
+			if( stream->GetSize() != FileSize ) {
+				// 他で書き換えられている
+				delete stream;
+				stream = NULL;
+				compact = true;
+			}
+		}
+		if( compact ) {
+			Reset();
+			rootid = Snapshot( root );
+		}
+		TJSBinaryLogPut32( &Output, tTJSBinaryLog::LOG_COMMIT, rootid );
+
+		if( compact ) {
+			// 書き直しの途中で中断されても前のファイルが残るように、
+			// 別のストレージに書いてから置き換える
+			// (置き換えられないホストでは直接書き直す)
+			ttstr target = TJSRenameStorage ? Name + TJS_W(".tmp") : Name;
+			stream = TJSCreateBinaryStreamForWrite( target, TJS_W("") );
+			stream->WriteBuffer( tTJSBinaryLog::HEADER, tTJSBinarySerializer::HEADER_LENGTH );
+			stream->WriteBuffer( Output.GetData(), Output.GetLength() );
+			delete stream;
+			stream = NULL;
+			if( TJSRenameStorage && !TJSRenameStorage( target, Name ) )
+				TJS_eTJSError( TJSWriteError );
+			FileSize = tTJSBinarySerializer::HEADER_LENGTH;
+		} else {
+			stream->WriteBuffer( Output.GetData(), Output.GetLength() );
+		}
+		FileSize += Output.GetLength();
+		Output.Clear();
+	} catch(...) {
+		// 次回は全体を書き直す
+		if( stream ) delete stream;
+		Reset();
+		throw;
+	}
+	delete stream;
+}
+//---------------------------------------------------------------------------
+static std::vector<tTJSBinaryLogWriter*> * TJSBinaryLogWriters = NULL;
+//---------------------------------------------------------------------------
+void tTJSBinaryLog::Write( const ttstr& name, iTJSDispatch2* root )
+{
+	if( !TJSBinaryLogWriters ) TJSBinaryLogWriters = new std::vector<tTJSBinaryLogWriter*>();
+	std::vector<tTJSBinaryLogWriter*> &writers = *TJSBinaryLogWriters;
+
+	// 最近使ったものを先頭に置き、多すぎる場合は最後のものを捨てる
+	tTJSBinaryLogWriter* writer = NULL;
+	for( tjs_uint i = 0; i < writers.size(); i++ ) {
+		if( writers[i]->GetName() == name ) {
+			writer = writers[i];
+			writers.erase( writers.begin() + i );
+			break;
+		}
+	}
+	if( !writer ) {
+		if( writers.size() >= TJS_BINARY_LOG_MAX_WRITERS ) {
+			delete writers.back();
+			writers.pop_back();
+		}
+		writer = new tTJSBinaryLogWriter( name );
+	}
+	writers.insert( writers.begin(), writer );
+
+	writer->Write( root );
+}
+//---------------------------------------------------------------------------
+void TJSReleaseBinaryLogWriters()
+{
+	if( !TJSBinaryLogWriters ) return;
+	for( tjs_uint i = 0; i < TJSBinaryLogWriters->size(); i++ ) {
+		delete (*TJSBinaryLogWriters)[i];
+	}
+	delete TJSBinaryLogWriters;
+	TJSBinaryLogWriters = NULL;
+}
+//---------------------------------------------------------------------------
+// 読み込み側
+//---------------------------------------------------------------------------
+/**
+ * ルートのレコードから参照を辿って、v1 形式の本体に展開する
+ */
+class tTJSBinaryLogExpander {
+public:
+	struct tRecord {
+		tjs_uint Offset;
+		tjs_uint Length;
+	};
+	typedef std::map<tjs_uint32, tRecord> tRecordMap;
+
+private:
+	const tjs_uint8* Buff;
+	const tRecordMap& Records;
+	std::vector<tjs_uint32> Expanding; // 循環参照の検出用
+	tTJSBinaryLogBuffer& Out;
+
+public:
+	tTJSBinaryLogExpander( const tjs_uint8* buff, const tRecordMap& records, tTJSBinaryLogBuffer& out )
+		: Buff(buff), Records(records), Out(out) {}
+
+	void ExpandRecord( tjs_uint32 id );
+
+private:
+	void CopyValue( const tjs_uint end, tjs_uint& index );
+};
+//---------------------------------------------------------------------------
+void tTJSBinaryLogExpander::ExpandRecord( tjs_uint32 id )
+{
+	tRecordMap::const_iterator it = Records.find( id );
+	if( it == Records.end() ) TJS_eTJSError( TJSReadError );
+	for( tjs_uint i = 0; i < Expanding.size(); i++ ) {
+		if( Expanding[i] == id ) TJS_eTJSError( TJSReadError );
+	}
+	Expanding.push_back( id );
+	tjs_uint index = it->second.Offset;
+	tjs_uint end = it->second.Offset + it->second.Length;
+	CopyValue( end, index );
+	if( index != end ) TJS_eTJSError( TJSReadError );
+	Expanding.pop_back();
+}
+//---------------------------------------------------------------------------
+/**
+ * 値をひとつ Out へコピーする、参照はそのレコードの中身に置き換える
+ */
+void tTJSBinaryLogExpander::CopyValue( const tjs_uint end, tjs_uint& index )
+{
+	typedef tTJSBinarySerializer s;
+	if( index >= end ) TJS_eTJSError( TJSReadError );
+	tjs_uint start = index;
+	tjs_uint8 type = Buff[index];
+	index++;
+
+	tjs_uint datalen = 0; // 続くデータのバイト数
+	tjs_uint head = 0; // 長さ/要素数のバイト数
+	tjs_uint count = 0; // 続く値の数
+	if( type <= s::TYPE_POSITIVE_FIX_NUM_MAX || type >= s::TYPE_NEGATIVE_FIX_NUM_MIN ) {
+	} else if( type >= s::TYPE_FIX_MAP_MIN && type <= s::TYPE_FIX_MAP_MAX ) {
+		count = ( type - s::TYPE_FIX_MAP_MIN ) * 2;
+	} else if( type >= s::TYPE_FIX_ARRAY_MIN && type <= s::TYPE_FIX_ARRAY_MAX ) {
+		count = type - s::TYPE_FIX_ARRAY_MIN;
+	} else if( type >= s::TYPE_FIX_STRING_MIN && type <= s::TYPE_FIX_STRING_MAX ) {
+		datalen = ( type - s::TYPE_FIX_STRING_MIN ) * s::CHAR_SIZE;
+	} else if( type >= s::TYPE_FIX_RAW_MIN && type <= s::TYPE_FIX_RAW_MAX ) {
+		datalen = type - s::TYPE_FIX_RAW_MIN;
+	} else {
+		switch( type ) {
+		case s::TYPE_NIL:
+		case s::TYPE_VOID:
+		case s::TYPE_TRUE:
+		case s::TYPE_FALSE:
+			break;
+		case s::TYPE_UINT8: case s::TYPE_INT8: datalen = 1; break;
+		case s::TYPE_UINT16: case s::TYPE_INT16: datalen = 2; break;
+		case s::TYPE_UINT32: case s::TYPE_INT32: case s::TYPE_FLOAT: datalen = 4; break;
+		case s::TYPE_UINT64: case s::TYPE_INT64: case s::TYPE_DOUBLE: datalen = 8; break;
+		case s::TYPE_STRING8:
+		case s::TYPE_STRING16:
+		case s::TYPE_STRING32:
+		case s::TYPE_RAW16:
+		case s::TYPE_RAW32:
+		case s::TYPE_ARRAY16:
+		case s::TYPE_ARRAY32:
+		case s::TYPE_MAP16:
+		case s::TYPE_MAP32: {
+			tjs_uint len;
+			if( type == s::TYPE_STRING8 ) head = 1;
+			else if( type == s::TYPE_STRING16 || type == s::TYPE_RAW16 ||
+				type == s::TYPE_ARRAY16 || type == s::TYPE_MAP16 ) head = 2;
+			else head = 4;
+			if( index + head > end ) TJS_eTJSError( TJSReadError );
+			if( head == 1 ) len = Buff[index], index++;
+			else if( head == 2 ) len = s::Read16( Buff, index );
+			else len = s::Read32( Buff, index );
+
+			if( type == s::TYPE_STRING8 || type == s::TYPE_STRING16 || type == s::TYPE_STRING32 ) {
+				if( len > ( end - index ) / s::CHAR_SIZE ) TJS_eTJSError( TJSReadError );
+				datalen = len * s::CHAR_SIZE;
+			} else if( type == s::TYPE_RAW16 || type == s::TYPE_RAW32 ) {
+				datalen = len;
+			} else if( type == s::TYPE_MAP16 || type == s::TYPE_MAP32 ) {
+				if( len > end - index ) TJS_eTJSError( TJSReadError );
+				count = len * 2;
+			} else {
+				if( len > end - index ) TJS_eTJSError( TJSReadError );
+				count = len;
+			}
+			break;
+		}
+		case tTJSBinaryLog::TYPE_OBJECT_REF: {
+			if( index + sizeof(tjs_uint32) > end ) TJS_eTJSError( TJSReadError );
+			tjs_uint32 id = s::Read32( Buff, index );
+			ExpandRecord( id );
+			return;
+		}
+		default:
+			TJS_eTJSError( TJSReadError );
+		}
+	}
+	if( datalen > end - index ) TJS_eTJSError( TJSReadError );
+	index += datalen;
+	Out.Write( &Buff[start], index - start );
+
+	for( tjs_uint i = 0; i < count; i++ ) {
+		CopyValue( end, index );
+	}
+}
+//---------------------------------------------------------------------------
+tTJSVariant* tTJSBinaryLog::Read( tTJSBinaryStream* stream, tTJSBinarySerializer& loader )
+{
+	tjs_uint64 pos = stream->GetPosition();
+	tjs_uint size = (tjs_uint)( stream->GetSize() - pos );
+	tjs_uint8* buff = new tjs_uint8[size > 0 ? size : 1];
+	tTJSVariant* ret = NULL;
+	try {
+		if( size != stream->Read( buff, size ) ) {
+			TJS_eTJSError( TJSReadError );
+		}
+
+		// 最後のコミットまでのレコードを集める、途中で切れている部分は無視する
+		tTJSBinaryLogExpander::tRecordMap records;
+		std::vector<std::pair<tjs_uint32, tTJSBinaryLogExpander::tRecord> > pending;
+		tjs_uint32 root = 0;
+		bool committed = false;
+		tjs_uint index = 0;
+		while( index < size ) {
+			tjs_uint8 type = buff[index];
+			if( type == LOG_RECORD ) {
+				if( size - index < TJS_BINARY_LOG_RECORD_HEADER ) break;
+				index++;
+				tjs_uint32 id = tTJSBinarySerializer::Read32( buff, index );
+				tjs_uint32 len = tTJSBinarySerializer::Read32( buff, index );
+				if( len > size - index ) break;
+				tTJSBinaryLogExpander::tRecord rec;
+				rec.Offset = index;
+				rec.Length = len;
+				pending.push_back( std::make_pair( id, rec ) );
+				index += len;
+			} else if( type == LOG_COMMIT ) {
+				if( size - index < 1 + sizeof(tjs_uint32) ) break;
+				index++;
+				root = tTJSBinarySerializer::Read32( buff, index );
+				for( tjs_uint i = 0; i < pending.size(); i++ ) {
+					records[pending[i].first] = pending[i].second;
+				}
+				pending.clear();
+				committed = true;
+			} else {
+				break;
+			}
+		}
+
+		if( committed ) {
+			tTJSBinaryLogBuffer body;
+			tTJSBinaryLogExpander expander( buff, records, body );
+			expander.ExpandRecord( root );
+			ret = loader.Read( body.GetData(), body.GetLength() );
+		}
+	} catch(...) {
+		delete[] buff;
+		throw;
+	}
+	delete[] buff;
+	return ret;
+}
+//---------------------------------------------------------------------------
+} // namespace TJS
@@ -0,0 +1,68 @@
+//---------------------------------------------------------------------------
+/*
+	TJS2 Script Engine
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Incremental binary structured data ( saveStruct with "i" mode )
+//---------------------------------------------------------------------------
+
+#ifndef tjsBinaryLogH
+#define tjsBinaryLogH
+
+#include "tjsBinarySerializer.h"
+
+namespace TJS
+{
+/**
+ * 差分書き出し形式 (追記ログ) のバイナリ構造化データ
+ *
+ * 辞書/配列ひとつをひとつのレコードとして書き出す。
+ * レコードの中身は v1 形式と同じだが、子の辞書/配列は
+ * TYPE_OBJECT_REF と 32bit のレコード ID で参照する。
+ * 2 回目以降の書き出しでは、前回と内容の変わったレコードだけを
+ * ファイルの末尾に追記し、最後にルートの ID を持つコミットを置く。
+ * 読み込み時は最後のコミットまでを読み、ID ごとに最後のレコードを使う。
+ * 途中で書き込みが中断されても、直前のコミットまでは読める。
+ *
+ * ファイルが生きているレコードの合計の COMPACT_RATIO 倍を超えたら、
+ * 次の書き出しでファイル全体を書き直す (コンパクション)。
+ * 書き直しは name + ".tmp" に書いてから TJSRenameStorage で置き換える。
+ *
+ * ファイル形式
+ *  ヘッダー "KBAL100\0"
+ *  LOG_RECORD, ID (32bit), 長さ (32bit), 中身
+ *  LOG_COMMIT, ルートの ID (32bit)
+ *  ... (以下くり返し)
+ */
+class tTJSBinaryLog {
+public:
+	enum {
+		LOG_RECORD = 0x01,
+		LOG_COMMIT = 0x02,
+		// レコード中では文字列表を使わないので、空いている TYPE_STRING_REF32 を使う
+		TYPE_OBJECT_REF = tTJSBinarySerializer::TYPE_STRING_REF32,
+	};
+	static const tjs_uint8 HEADER[tTJSBinarySerializer::HEADER_LENGTH];
+	static bool IsLog( const tjs_uint8 header[tTJSBinarySerializer::HEADER_LENGTH] );
+
+	/**
+	 * ストレージ name に root を書き出す
+	 * 書き出し側の状態はストレージ名ごとに保持され、同じ名前への
+	 * 2 回目以降の書き出しは差分の追記になる
+	 */
+	static void Write( const ttstr& name, iTJSDispatch2* root );
+
+	/**
+	 * ヘッダーの後ろから読み、レコードを展開して loader で読み込む
+	 * コミットがひとつもない場合は NULL を返す
+	 */
+	static tTJSVariant* Read( tTJSBinaryStream* stream, tTJSBinarySerializer& loader );
+};
+//---------------------------------------------------------------------------
+extern void TJSReleaseBinaryLogWriters();
+//---------------------------------------------------------------------------
+} // namespace TJS
+#endif // tjsBinaryLogH
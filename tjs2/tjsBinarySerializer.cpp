@@ -19,13 +19,18 @@ namespace TJS
 const tjs_uint8 tTJSBinarySerializer::HEADER[tTJSBinarySerializer::HEADER_LENGTH] = {
 	'K','B','A','D', '1','0','0', 0
 };
+const tjs_uint8 tTJSBinarySerializer::HEADER_V2[tTJSBinarySerializer::HEADER_LENGTH] = {
+	'K','B','A','D', '2','0','0', 0
+};
 bool tTJSBinarySerializer::IsBinary( const tjs_uint8 header[tTJSBinarySerializer::HEADER_LENGTH] ) {
-	return memcmp( HEADER, header, tTJSBinarySerializer::HEADER_LENGTH) == 0;
+	// v1 と v2 は同じ読み込み処理で読める
+	return memcmp( HEADER, header, tTJSBinarySerializer::HEADER_LENGTH) == 0 ||
+		memcmp( HEADER_V2, header, tTJSBinarySerializer::HEADER_LENGTH) == 0;
 }
 /**
  * バイアント値を格納する
  */
-void tTJSBinarySerializer::PutVariant( tTJSBinaryStream* stream, tTJSVariant& v )
+void tTJSBinarySerializer::PutVariant( tTJSBinaryStream* stream, tTJSVariant& v, tTJSBinaryStringTable* strings )
 {
 	tTJSVariantType type = v.Type();
 	switch( type ) {
@@ -50,7 +55,11 @@ void tTJSBinarySerializer::PutVariant( tTJSBinaryStream* stream, tTJSVariant& v
 	}
 */
 	case tvtString:
-		PutString( stream, v.AsStringNoAddRef() );
+		if( strings ) {
+			strings->PutString( stream, v.AsStringNoAddRef() );
+		} else {
+			PutString( stream, v.AsStringNoAddRef() );
+		}
 		break;
 	case tvtOctet:
 		PutOctet( stream, v.AsOctetNoAddRef() );
@@ -75,6 +84,9 @@ tTJSBinarySerializer::tTJSBinarySerializer( class tTJSArrayObject* root ) : DicC
 tTJSBinarySerializer::~tTJSBinarySerializer() {
 	if( DicClass ) DicClass->Release();
 	DicClass = NULL;
+	for( std::vector<tTJSVariantString*>::iterator i = Strings.begin(); i != Strings.end(); i++ ) {
+		if( *i ) (*i)->Release();
+	}
 }
 
 tTJSDictionaryObject* tTJSBinarySerializer::CreateDictionary( tjs_uint count ) {
@@ -111,238 +123,377 @@ tTJSArrayObject* tTJSBinarySerializer::CreateArray( tjs_uint count ) {
 	tTJSArrayObject* array = (tTJSArrayObject*)TJSCreateArrayObject();
 	return array;
 }
-void tTJSBinarySerializer::AddDictionary( tTJSDictionaryObject* dic, tTJSVariantString* name, tTJSVariant* value ) {
-	if( name == NULL || value == NULL ) TJS_eTJSError( TJSReadError );
-	dic->PropSetByVS( TJS_MEMBERENSURE, name, value, dic );
+void tTJSBinarySerializer::AddDictionary( tTJSDictionaryObject* dic, tTJSVariantString* name, const tTJSVariant& value ) {
+	if( name == NULL ) TJS_eTJSError( TJSReadError );
+	dic->PropSetByVS( TJS_MEMBERENSURE, name, &value, dic );
 }
-void tTJSBinarySerializer::InsertArray( tTJSArrayObject* array, tjs_uint index, tTJSVariant* value ) {
-	if( value == NULL ) TJS_eTJSError( TJSReadError );
-	tTJSArrayNI* ni = NULL;
-	tjs_error hr = array->NativeInstanceSupport(TJS_NIS_GETINSTANCE, TJSGetArrayClassID(), (iTJSNativeInstance**)&ni );
-	if( TJS_SUCCEEDED(hr) ) {
-		// array->Insert( ni, *value, index );
-		array->Add( ni, *value );
+/**
+ * 文字列型の値を読む (型の値から)
+ * 空文字列の場合は NULL を返す、返り値は呼び出し側で Release すること
+ */
+tTJSVariantString* tTJSBinarySerializer::ReadStringItem( const tjs_uint8* buff, const tjs_uint size, tjs_uint& index ) {
+	if( index >= size ) TJS_eTJSError( TJSReadError );
+	tjs_uint8 type = buff[index];
+	index++;
+	tjs_uint len;
+	switch( type ) {
+	case TYPE_STRING8:
+		if( (index+sizeof(tjs_uint8)) > size ) TJS_eTJSError( TJSReadError );
+		len = buff[index]; index++;
+		break;
+	case TYPE_STRING16:
+		if( (index+sizeof(tjs_uint16)) > size ) TJS_eTJSError( TJSReadError );
+		len = Read16( buff, index );
+		break;
+	case TYPE_STRING32:
+		if( (index+sizeof(tjs_uint32)) > size ) TJS_eTJSError( TJSReadError );
+		len = Read32( buff, index );
+		break;
+	default:
+		if( type >= TYPE_FIX_STRING_MIN && type <= TYPE_FIX_STRING_MAX ) {
+			len = type - TYPE_FIX_STRING_MIN;
+		} else {
+			TJS_eTJSError( TJSReadError );
+			return NULL;
+		}
+		break;
+	}
+	if( (index+(len*CHAR_SIZE)) > size ) TJS_eTJSError( TJSReadError );
+	return ReadString( buff, len, index );
+}
+/**
+ * 文字列表の定義/参照を読む (型の値の後ろから)
+ * 返り値は表が持っているので Release しないこと、空文字列の場合は NULL
+ */
+tTJSVariantString* tTJSBinarySerializer::ReadStringTable( const tjs_uint8* buff, const tjs_uint size, tjs_uint8 type, tjs_uint& index ) {
+	switch( type ) {
+	case TYPE_STRING_DEF: {
+		tTJSVariantString* str = ReadStringItem( buff, size, index );
+		if( str ) {
+			// グローバル文字列マップのものに置き換えて共有する
+			ttstr mapped = TJSMapGlobalStringMap( ttstr(str) );
+			str->Release();
+			str = mapped.AsVariantStringNoAddRef();
+			if( str ) str->AddRef();
+		}
+		Strings.push_back( str );
+		return str;
+	}
+	case TYPE_STRING_REF16: {
+		if( (index+sizeof(tjs_uint16)) > size ) TJS_eTJSError( TJSReadError );
+		tjs_uint16 n = Read16( buff, index );
+		if( n >= Strings.size() ) TJS_eTJSError( TJSReadError );
+		return Strings[n];
+	}
+	case TYPE_STRING_REF32: {
+		if( (index+sizeof(tjs_uint32)) > size ) TJS_eTJSError( TJSReadError );
+		tjs_uint32 n = Read32( buff, index );
+		if( n >= Strings.size() ) TJS_eTJSError( TJSReadError );
+		return Strings[n];
+	}
+	default:
+		TJS_eTJSError( TJSReadError );
+		return NULL;
 	}
 }
-tTJSVariant* tTJSBinarySerializer::ReadBasicType( const tjs_uint8* buff, const tjs_uint size, tjs_uint& index ) {
-	if( index > size ) return NULL;
+void tTJSBinarySerializer::ReadBasicType( const tjs_uint8* buff, const tjs_uint size, tjs_uint& index, tTJSVariant& dest ) {
+	if( index >= size ) TJS_eTJSError( TJSReadError );
 	tjs_uint8 type = buff[index];
 	index++;
 	switch( type  ) {
 	case TYPE_NIL:
-		return new tTJSVariant((iTJSDispatch2*)NULL);
+		dest = tTJSVariant((iTJSDispatch2*)NULL);
+		return;
 	case TYPE_VOID:
-		return new tTJSVariant();
+		dest = tTJSVariant();
+		return;
 	case TYPE_TRUE:
-		return new tTJSVariant((tjs_int)1);
+		dest = (tjs_int)1;
+		return;
 	case TYPE_FALSE:
-		return new tTJSVariant((tjs_int)0);
-	case TYPE_STRING8: {
-		if( (index+sizeof(tjs_uint8)) > size ) TJS_eTJSError( TJSReadError );
-		tjs_uint8 len = buff[index]; index++;
-		if( (index+(len*sizeof(tjs_char))) > size ) TJS_eTJSError( TJSReadError );
-		return ReadStringVarint( buff, len, index );
-	}
-	case TYPE_STRING16: {
-		if( (index+sizeof(tjs_uint16)) > size ) TJS_eTJSError( TJSReadError );
-		tjs_uint16 len = Read16( buff, index );
-		if( (index+(len*sizeof(tjs_char))) > size ) TJS_eTJSError( TJSReadError );
-		return ReadStringVarint( buff, len, index );
-	}
+		dest = (tjs_int)0;
+		return;
+	case TYPE_STRING8:
+	case TYPE_STRING16:
 	case TYPE_STRING32: {
-		if( (index+sizeof(tjs_uint32)) > size ) TJS_eTJSError( TJSReadError );
-		tjs_uint32 len = Read32( buff, index );
-		if( (index+(len*sizeof(tjs_char))) > size ) TJS_eTJSError( TJSReadError );
-		return ReadStringVarint( buff, len, index );
+		index--;
+		tTJSVariantString* str = ReadStringItem( buff, size, index );
+		if( str ) {
+			dest = TJSMapGlobalStringMap( ttstr(str) );
+			str->Release();
+		} else {
+			dest = TJSMapGlobalStringMap( ttstr() );
+		}
+		return;
 	}
+	case TYPE_STRING_DEF:
+	case TYPE_STRING_REF16:
+	case TYPE_STRING_REF32:
+		dest = ttstr( ReadStringTable( buff, size, type, index ) );
+		return;
 	case TYPE_FLOAT: {
 			if( (index+sizeof(float)) > size ) TJS_eTJSError( TJSReadError );
 			tjs_uint32 t = Read32( buff, index );
-			return new tTJSVariant(*(float*)&t);
+			dest = (tjs_real)*(float*)&t;
+			return;
 		}
 	case TYPE_DOUBLE: {
 			if( (index+sizeof(double)) > size ) TJS_eTJSError( TJSReadError );
 			tjs_uint64 t = Read64( buff, index );
-			return new tTJSVariant(*(double*)&t);
+			dest = *(double*)&t;
+			return;
 		}
 	case TYPE_UINT8: {
 			if( (index+sizeof(tjs_uint8)) > size ) TJS_eTJSError( TJSReadError );
 			tjs_uint8 t = buff[index]; index++;
-			return new tTJSVariant( t );
+			dest = (tjs_int)t;
+			return;
 		}
 	case TYPE_UINT16: {
 			if( (index+sizeof(tjs_uint16)) > size ) TJS_eTJSError( TJSReadError );
 			tjs_uint16 t = Read16( buff, index );
-			return new tTJSVariant( t );
+			dest = (tjs_int)t;
+			return;
 		}
 	case TYPE_UINT32: {
 			if( (index+sizeof(tjs_uint32)) > size ) TJS_eTJSError( TJSReadError );
 			tjs_uint32 t = Read32( buff, index );
-			return new tTJSVariant( (tjs_int64)t );
+			dest = (tjs_int64)t;
+			return;
 		}
 	case TYPE_UINT64: {
 			if( (index+sizeof(tjs_uint64)) > size ) TJS_eTJSError( TJSReadError );
 			tjs_uint64 t = Read64( buff, index );
-			return new tTJSVariant( (tjs_int64)t );
+			dest = (tjs_int64)t;
+			return;
 		}
 	case TYPE_INT8: {
 			if( (index+sizeof(tjs_uint8)) > size ) TJS_eTJSError( TJSReadError );
 			tjs_uint8 t = buff[index]; index++;
-			return new tTJSVariant( (tjs_int8)t );
+			dest = (tjs_int)(tjs_int8)t;
+			return;
 		}
 	case TYPE_INT16: {
 			if( (index+sizeof(tjs_uint16)) > size ) TJS_eTJSError( TJSReadError );
 			tjs_uint16 t = Read16( buff, index );
-			return new tTJSVariant( (tjs_int16)t );
+			dest = (tjs_int)(tjs_int16)t;
+			return;
 		}
 	case TYPE_INT32: {
 			if( (index+sizeof(tjs_uint32)) > size ) TJS_eTJSError( TJSReadError );
 			tjs_uint32 t = Read32( buff, index );
-			return new tTJSVariant( (tjs_int32)t );
+			dest = (tjs_int32)t;
+			return;
 		}
 	case TYPE_INT64: {
 			if( (index+sizeof(tjs_uint64)) > size ) TJS_eTJSError( TJSReadError );
 			tjs_uint64 t = Read64( buff, index );
-			return new tTJSVariant( (tjs_int64)t );
+			dest = (tjs_int64)t;
+			return;
 		}
 	case TYPE_RAW16: {
 		if( (index+sizeof(tjs_uint16)) > size ) TJS_eTJSError( TJSReadError );
 		tjs_uint16 len = Read16( buff, index );
 		if( (index+len) > size ) TJS_eTJSError( TJSReadError );
-		return ReadOctetVarint( buff, len, index );
+		dest = tTJSVariant( &buff[index], len );
+		index += len;
+		return;
 	}
 	case TYPE_RAW32: {
 		if( (index+sizeof(tjs_uint32)) > size ) TJS_eTJSError( TJSReadError );
 		tjs_uint32 len = Read32( buff, index );
 		if( (index+len) > size ) TJS_eTJSError( TJSReadError );
-		return ReadOctetVarint( buff, len, index );
+		dest = tTJSVariant( &buff[index], len );
+		index += len;
+		return;
 	}
 	case TYPE_ARRAY16: {
 		if( (index+sizeof(tjs_uint16)) > size ) TJS_eTJSError( TJSReadError );
 		tjs_uint16 count = Read16( buff, index );
-		return ReadArray( buff, size, count, index );
+		ReadArray( buff, size, count, index, dest );
+		return;
 	}
 	case TYPE_ARRAY32: {
 		if( (index+sizeof(tjs_uint32)) > size ) TJS_eTJSError( TJSReadError );
 		tjs_uint32 count = Read32( buff, index );
-		return ReadArray( buff, size, count, index );
+		ReadArray( buff, size, count, index, dest );
+		return;
 	}
 	case TYPE_MAP16: {
 		if( (index+sizeof(tjs_uint16)) > size ) TJS_eTJSError( TJSReadError );
 		tjs_uint16 count = Read16( buff, index );
-		return ReadDictionary( buff, size, count, index );
+		ReadDictionary( buff, size, count, index, dest );
+		return;
 	}
 	case TYPE_MAP32: {
 		if( (index+sizeof(tjs_uint32)) > size ) TJS_eTJSError( TJSReadError );
 		tjs_uint32 count = Read32( buff, index );
-		return ReadDictionary( buff, size, count, index );
+		ReadDictionary( buff, size, count, index, dest );
+		return;
 	}
 	default: {
 		if( type >= TYPE_POSITIVE_FIX_NUM_MIN && type <= TYPE_POSITIVE_FIX_NUM_MAX ) {
 			tjs_int value = type;
-			return new tTJSVariant(value);
+			dest = value;
 		} else if( type >= TYPE_NEGATIVE_FIX_NUM_MIN && type <= TYPE_NEGATIVE_FIX_NUM_MAX ) {
 			tjs_int value = type;
-			return new tTJSVariant(value);
+			dest = value;
 		} else if( type >= TYPE_FIX_RAW_MIN && type <= TYPE_FIX_RAW_MAX ) { // octet
 			tjs_int len = type - TYPE_FIX_RAW_MIN;
 			if( (len*sizeof(tjs_uint8)+index) > size ) TJS_eTJSError( TJSReadError );
-			return ReadOctetVarint( buff, len, index );
+			dest = tTJSVariant( &buff[index], len );
+			index += len;
 		} else if( type >= TYPE_FIX_STRING_MIN && type <= TYPE_FIX_STRING_MAX ) {
-			tjs_int len = type - TYPE_FIX_STRING_MIN;
-			if( (len*sizeof(tjs_char)+index) > size ) TJS_eTJSError( TJSReadError );
-			return ReadStringVarint( buff, len, index );
+			index--;
+			tTJSVariantString* str = ReadStringItem( buff, size, index );
+			if( str ) {
+				dest = TJSMapGlobalStringMap( ttstr(str) );
+				str->Release();
+			} else {
+				dest = TJSMapGlobalStringMap( ttstr() );
+			}
 		} else if( type >= TYPE_FIX_ARRAY_MIN && type <= TYPE_FIX_ARRAY_MAX ) {
 			tjs_int count = type - TYPE_FIX_ARRAY_MIN;
-			return ReadArray( buff, size, count, index );
+			ReadArray( buff, size, count, index, dest );
 		} else if( type >= TYPE_FIX_MAP_MIN && type <= TYPE_FIX_MAP_MAX ) {
 			tjs_int count = type - TYPE_FIX_MAP_MIN;
-			return ReadDictionary( buff, size, count, index );
+			ReadDictionary( buff, size, count, index, dest );
 		} else {
 			TJS_eTJSError( TJSReadError );
-			return NULL;
 		}
+		return;
 	}
 	}
 }
-tTJSVariant* tTJSBinarySerializer::ReadArray( const tjs_uint8* buff, const tjs_uint size, const tjs_uint count, tjs_uint& index ) {
-	if( index > size ) return NULL;
+void tTJSBinarySerializer::ReadArray( const tjs_uint8* buff, const tjs_uint size, const tjs_uint count, tjs_uint& index, tTJSVariant& dest ) {
+	if( index > size ) TJS_eTJSError( TJSReadError );
+	// 要素は最低 1 byte あるので、残りより多い要素数は壊れている
+	if( count > size - index ) TJS_eTJSError( TJSReadError );
 
 	tTJSArrayObject* array = CreateArray( count );
-	for( tjs_uint i = 0; i < count; i++ ) {
-		tTJSVariant* value = ReadBasicType( buff, size, index );
-		InsertArray( array, i, value );
-		delete value;
+	try {
+		tTJSArrayNI* ni = NULL;
+		tjs_error hr = array->NativeInstanceSupport(TJS_NIS_GETINSTANCE, TJSGetArrayClassID(), (iTJSNativeInstance**)&ni );
+		if( TJS_FAILED(hr) ) TJS_eTJSError( TJSNativeClassCrash );
+
+		// 要素数分先に確保しておく
+		ni->Items.reserve( ni->Items.size() + count );
+		tTJSVariant value;
+		for( tjs_uint i = 0; i < count; i++ ) {
+			ReadBasicType( buff, size, index, value );
+			array->Add( ni, value );
+		}
+	} catch(...) {
+		array->Release();
+		throw;
 	}
-	tTJSVariant* ret = new tTJSVariant( array, array );
+	dest = tTJSVariant( array, array );
 	array->Release();
-	return ret;
 }
-tTJSVariant* tTJSBinarySerializer::ReadDictionary( const tjs_uint8* buff, const tjs_uint size, const tjs_uint count, tjs_uint& index ) {
-	if( index > size ) return NULL;
+void tTJSBinarySerializer::ReadDictionary( const tjs_uint8* buff, const tjs_uint size, const tjs_uint count, tjs_uint& index, tTJSVariant& dest ) {
+	if( index > size ) TJS_eTJSError( TJSReadError );
+	// 要素は最低 2 byte あるので、残りより多い要素数は壊れている
+	if( count > (size - index) / 2 ) TJS_eTJSError( TJSReadError );
 
 	tTJSDictionaryObject* dic = CreateDictionary( count );
-	for( tjs_uint i = 0; i < count; i++ ) {
-		tjs_uint8 type = buff[index];
-		index++;
-		// 最初に文字を読む
-		tTJSVariantString* name = NULL;
-		switch( type ) {
-		case TYPE_STRING8: {
-			if( (index+sizeof(tjs_uint8)) > size ) TJS_eTJSError( TJSReadError );
-			tjs_uint8 len = buff[index]; index++;
-			if( (index+(len*sizeof(tjs_char))) > size ) TJS_eTJSError( TJSReadError );
-			name = ReadString( buff, len, index );
-			break;
-		}
-		case TYPE_STRING16: {
-			if( (index+sizeof(tjs_uint16)) > size ) TJS_eTJSError( TJSReadError );
-			tjs_uint16 len = Read16( buff, index );
-			if( (index+(len*sizeof(tjs_char))) > size ) TJS_eTJSError( TJSReadError );
-			name = ReadString( buff, len, index );
-			break;
-		}
-		case TYPE_STRING32: {
-			if( (index+sizeof(tjs_uint32)) > size ) TJS_eTJSError( TJSReadError );
-			tjs_uint32 len = Read32( buff, index );
-			if( (index+(len*sizeof(tjs_char))) > size ) TJS_eTJSError( TJSReadError );
-			name = ReadString( buff, len, index );
-			break;
-		}
-		default:
-			if( type >= TYPE_FIX_STRING_MIN && type <= TYPE_FIX_STRING_MAX ) {
-				tjs_int len = type - TYPE_FIX_STRING_MIN;
-				if( (len*sizeof(tjs_char)+index) > size ) TJS_eTJSError( TJSReadError );
-				name = ReadString( buff, len, index );
+	try {
+		tTJSVariant value;
+		for( tjs_uint i = 0; i < count; i++ ) {
+			if( index >= size ) TJS_eTJSError( TJSReadError );
+			tjs_uint8 type = buff[index];
+			// 最初に文字を読む
+			if( type == TYPE_STRING_DEF || type == TYPE_STRING_REF16 || type == TYPE_STRING_REF32 ) {
+				index++;
+				tTJSVariantString* name = ReadStringTable( buff, size, type, index );
+				// 次に要素を読む
+				ReadBasicType( buff, size, index, value );
+				AddDictionary( dic, name, value );
 			} else { // Dictionary形式の場合、最初に文字列がこないといけない
-				 TJS_eTJSError( TJSReadError );
+				tTJSVariantString* name = ReadStringItem( buff, size, index );
+				try {
+					// 次に要素を読む
+					ReadBasicType( buff, size, index, value );
+					AddDictionary( dic, name, value );
+				} catch(...) {
+					if( name ) name->Release();
+					throw;
+				}
+				if( name ) name->Release();
 			}
-			break;
 		}
-		// 次に要素を読む
-		tTJSVariant* value = ReadBasicType( buff, size, index );
-		AddDictionary( dic, name, value );
-		delete value;
-		if( name ) name->Release();
+	} catch(...) {
+		dic->Release();
+		throw;
 	}
-	tTJSVariant* ret = new tTJSVariant( dic, dic );
+	dest = tTJSVariant( dic, dic );
 	dic->Release();
-	return ret;
 }
 tTJSVariant* tTJSBinarySerializer::Read( tTJSBinaryStream* stream )
 {
 	tjs_uint64 pos = stream->GetPosition();
 	tjs_uint size = (tjs_uint)( stream->GetSize() - pos );
 	tjs_uint8* buffstart = new tjs_uint8[size];
-	if( size != stream->Read( buffstart, size ) ) {
-		TJS_eTJSError( TJSReadError );
+	tTJSVariant* ret = NULL;
+	try {
+		if( size != stream->Read( buffstart, size ) ) {
+			TJS_eTJSError( TJSReadError );
+		}
+		ret = Read( buffstart, size );
+	} catch(...) {
+		delete[] buffstart;
+		throw;
 	}
-	tjs_uint index = 0;
-	tTJSVariant* ret = ReadBasicType( buffstart, size, index );
 	delete[] buffstart;
 	return ret;
 }
+tTJSVariant* tTJSBinarySerializer::Read( const tjs_uint8* buff, tjs_uint size )
+{
+	tjs_uint index = 0;
+	tTJSVariant* ret = new tTJSVariant();
+	try {
+		ReadBasicType( buff, size, index, *ret );
+	} catch(...) {
+		delete ret;
+		throw;
+	}
+	return ret;
+}
+//---------------------------------------------------------------------------
+void tTJSBinaryStringTable::PutString( tTJSBinaryStream* stream, const tTJSVariantString* val )
+{
+	tjs_int len = val ? val->GetLength() : 0;
+	if( !Enabled || len == 0 || len > MAX_LENGTH ) {
+		tTJSBinarySerializer::PutString( stream, val );
+		return;
+	}
 
-} // namespace
+	ttstr key( const_cast<tTJSVariantString*>(val) );
+	tjs_uint32 *n = Indices.Find( key );
+	if( n ) {
+		if( *n <= USHRT_MAX ) {
+			tjs_uint8 tmp[3];
+			tmp[0] = tTJSBinarySerializer::TYPE_STRING_REF16;
+			tmp[1] = (tjs_uint8)( *n&0xff );
+			tmp[2] = (tjs_uint8)( (*n>>8)&0xff );
+			stream->Write( tmp, sizeof(tmp) );
+		} else {
+			tjs_uint8 tmp[5];
+			tmp[0] = tTJSBinarySerializer::TYPE_STRING_REF32;
+			tmp[1] = (tjs_uint8)( *n&0xff );
+			tmp[2] = (tjs_uint8)( (*n>>8)&0xff );
+			tmp[3] = (tjs_uint8)( (*n>>16)&0xff );
+			tmp[4] = (tjs_uint8)( (*n>>24)&0xff );
+			stream->Write( tmp, sizeof(tmp) );
+		}
+		return;
+	}
 
+	Indices.Add( key, Count );
+	Count++;
+	tjs_uint8 tmp[1];
+	tmp[0] = tTJSBinarySerializer::TYPE_STRING_DEF;
+	stream->Write( tmp, sizeof(tmp) );
+	tTJSBinarySerializer::PutString( stream, val );
+}
 
+} // namespace
@@ -14,11 +14,13 @@
 #include "tjsVariant.h"
 #include "tjsError.h"
 #include "tjsGlobalStringMap.h"
+#include "tjsHashSearch.h"
 #include <vector>
 #include <limits.h>
 
 namespace TJS
 {
+class tTJSBinaryStringTable;
 /**
  * バイナリ形式でデータをストリーム書き出しするためのクラス
  * 形式は、MessagePack に近いもので細部TJS2用に調整している
@@ -42,6 +44,13 @@ public:
 		TYPE_STRING16 = 0xC5,
 		TYPE_STRING32 = 0xC6,
 
+		// v2 形式のみ
+		// 文字列表への追加、続けて文字列型の値が来る
+		TYPE_STRING_DEF = 0xC7,
+		// 文字列表の参照、続けてインデックス
+		TYPE_STRING_REF16 = 0xC8,
+		TYPE_STRING_REF32 = 0xC9,
+
 		TYPE_FLOAT = 0xCA,
 		TYPE_DOUBLE = 0xCB,
 
@@ -77,6 +86,15 @@ public:
 	};
 	static const tjs_int HEADER_LENGTH = 8;
 	static const tjs_uint8 HEADER[HEADER_LENGTH];
+	// 文字列は UTF-16 で格納するので、1 文字は常に 2 byte (tjs_char の大きさによらない)
+	static const tjs_uint CHAR_SIZE = 2;
+	/**
+	 * v2 形式のヘッダー
+	 * v1 に文字列表 (TYPE_STRING_DEF/TYPE_STRING_REF*) を加えたもの
+	 * 書き出しは既定では v1 で、saveStruct のモードに 's' を含む時のみ v2
+	 * (v2 は古い版では読めないため)
+	 */
+	static const tjs_uint8 HEADER_V2[HEADER_LENGTH];
 	static bool IsBinary( const tjs_uint8 header[HEADER_LENGTH] );
 
 	/*
@@ -226,22 +244,22 @@ public:
 		} else {
 			TJS_eTJSError(TJSWriteError);
 		}
-#if TJS_HOST_IS_LITTLE_ENDIAN
-		if( len ) {
-			stream->Write( val, sizeof(tjs_char)*len );
-		}
-#else
 		if( len ) {
+#if TJS_HOST_IS_LITTLE_ENDIAN
+			if( sizeof(tjs_char) == CHAR_SIZE ) {
+				stream->Write( val, CHAR_SIZE*len );
+				return;
+			}
+#endif
 			std::vector<tjs_uint8> tmp;
-			tmp.reserve( sizeof(tjs_char)*len );
+			tmp.reserve( CHAR_SIZE*len );
 			for( tjs_uint i = 0; i < len; i++ ) {
 				tjs_char c = val[i];
 				tmp.push_back( c&0xff );
 				tmp.push_back( (c>>8)&0xff );
 			}
-			stream->Write( &(tmp[0]), sizeof(tjs_char)*len );
+			stream->Write( &(tmp[0]), CHAR_SIZE*len );
 		}
-#endif
 	}
 	/**
 	 * 浮動小数点値を格納する
@@ -406,6 +424,14 @@ public:
 	}
 	static inline tTJSVariantString* ReadString( const tjs_uint8* buff, tjs_uint len, tjs_uint& index ) {
 		tTJSVariantString* ret = NULL;
+#if TJS_HOST_IS_LITTLE_ENDIAN
+		if( len > 0 && sizeof(tjs_char) == CHAR_SIZE ) {
+			// バッファから直接文字列を作る
+			ret = TJSAllocVariantString( (const tjs_char*)&buff[index], len );
+			index += len*CHAR_SIZE;
+			return ret;
+		}
+#endif
 		if( len > 0 ) {
 			tjs_char* str = new tjs_char[len];
 			for( tjs_uint i = 0; i < len; i++ ) {
@@ -443,27 +469,54 @@ public:
 	/**
 	 * バイアント値を格納する
 	 * オブジェクト型は無視している
+	 * strings が指定されている場合、文字列は文字列表を使って格納する (v2)
 	 */
-	static void PutVariant( tTJSBinaryStream* stream, tTJSVariant& v );
+	static void PutVariant( tTJSBinaryStream* stream, tTJSVariant& v, tTJSBinaryStringTable* strings = NULL );
 	
 	tTJSBinarySerializer();
 	tTJSBinarySerializer( class tTJSDictionaryObject* root );
 	tTJSBinarySerializer( class tTJSArrayObject* root );
 	~tTJSBinarySerializer();
 	tTJSVariant* Read( tTJSBinaryStream* stream );
+	/**
+	 * メモリ上のデータ (ヘッダーの後ろから) を直接読む
+	 * ストレージのメモリイメージを持っている場合はコピーせずにこちらを使う
+	 */
+	tTJSVariant* Read( const tjs_uint8* buff, tjs_uint size );
 
 private:
 	iTJSDispatch2* DicClass;
 	class tTJSDictionaryObject* RootDictionary;
 	class tTJSArrayObject* RootArray;
+	std::vector<tTJSVariantString*> Strings; // 読み込んだ文字列表 (グローバル文字列マップで共有される)
 
 	class tTJSDictionaryObject* CreateDictionary( tjs_uint count );
 	class tTJSArrayObject* CreateArray( tjs_uint count );
-	void AddDictionary( class tTJSDictionaryObject* dic, tTJSVariantString* name, tTJSVariant* value );
-	void InsertArray( class tTJSArrayObject* array, tjs_uint index, tTJSVariant* value );
-	tTJSVariant* ReadBasicType( const tjs_uint8* buff, const tjs_uint size, tjs_uint& index );
-	tTJSVariant* ReadArray( const tjs_uint8* buff, const tjs_uint size, const tjs_uint count, tjs_uint& index );
-	tTJSVariant* ReadDictionary( const tjs_uint8* buff, const tjs_uint size, const tjs_uint count, tjs_uint& index );
+	void AddDictionary( class tTJSDictionaryObject* dic, tTJSVariantString* name, const tTJSVariant& value );
+	void ReadBasicType( const tjs_uint8* buff, const tjs_uint size, tjs_uint& index, tTJSVariant& dest );
+	void ReadArray( const tjs_uint8* buff, const tjs_uint size, const tjs_uint count, tjs_uint& index, tTJSVariant& dest );
+	void ReadDictionary( const tjs_uint8* buff, const tjs_uint size, const tjs_uint count, tjs_uint& index, tTJSVariant& dest );
+	tTJSVariantString* ReadStringItem( const tjs_uint8* buff, const tjs_uint size, tjs_uint& index );
+	tTJSVariantString* ReadStringTable( const tjs_uint8* buff, const tjs_uint size, tjs_uint8 type, tjs_uint& index );
+};
+/**
+ * v2 形式の書き出しで使う文字列表
+ * 最初に出てきた文字列は TYPE_STRING_DEF を付けて書き出して表に追加し、
+ * 2 回目以降は表のインデックスだけを書き出す
+ * 読み込み側は順に表を作るので、全体を先に走査する必要はない
+ */
+class tTJSBinaryStringTable {
+	static const tjs_int MAX_LENGTH = 256; // これより長い文字列は表に入れない
+
+	tTJSHashTable<ttstr, tjs_uint32> Indices;
+	tjs_uint32 Count;
+	bool Enabled; // false の時は表を使わず v1 の形式で書き出す
+
+public:
+	tTJSBinaryStringTable( bool enabled = true ) : Count(0), Enabled(enabled) {}
+	bool GetEnabled() const { return Enabled; }
+
+	void PutString( tTJSBinaryStream* stream, const tTJSVariantString* val );
 };
 
 } // namespace
@@ -41,6 +41,7 @@ namespace TJS
 // #define TJS_JP_LOCALIZED
 // #define TJS_TEXT_OUT_CRLF
 // #define TJS_WITH_IS_NOT_RESERVED_WORD
+// #define TJS_VM_COUNTERS // VM execution counters; they count only while enabled
 
 TJS_EXP_FUNC_DEF(tjs_int, TJS_atoi, (const tjs_char *s));
 TJS_EXP_FUNC_DEF(tjs_char *, TJS_int_to_str, (tjs_int value, tjs_char *string));
@@ -85,7 +86,11 @@ extern int TJS_wctomb(tjs_nchar *s, tjs_char wc);
 	#define TJS_vsnprintf		vswprintf
 	extern tjs_int TJS_sprintf(tjs_char *s, const tjs_char *format, ...);
 	#define TJS_timezone timezone
+#ifdef __WIN32__
 	#define TJS_snprintf wsnprintf
+#else
+	#define TJS_snprintf swprintf
+#endif
 #elif __WIN32__
 	#define TJS_cdecl __cdecl
 #ifdef _MSC_VER
@@ -0,0 +1,404 @@
+//---------------------------------------------------------------------------
+/*
+	TJS2 Script Engine
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Cycle collector for reference-counted objects
+//---------------------------------------------------------------------------
+#include "tjsCommHead.h"
+
+#include "tjsCycleCollector.h"
+#include "tjsObject.h"
+#include "tjsArray.h"
+#include "tjsHashSearch.h"
+
+namespace TJS
+{
+//---------------------------------------------------------------------------
+#define TJS_CC_HASH_SIZE 16384
+//---------------------------------------------------------------------------
+// tTJSCycleCollector
+//---------------------------------------------------------------------------
+class tTJSCycleCollector
+{
+	enum tColor
+	{
+		ccBlack, // alive, or not visited yet
+		ccGray, // internal references are subtracted from Count
+		ccWhite // garbage candidate
+	};
+
+	struct tEntry
+	{
+		tTJSCustomObject *Object;
+		tjs_uint Index; // index in Objects
+		tjs_uint Step; // Count and Color are valid if this equals to the current step
+		tjs_int Count; // reference count minus the internal references
+		tColor Color;
+	};
+
+	typedef tTJSHashTable<void *, tEntry, tTJSHashFunc<void *>, TJS_CC_HASH_SIZE> tHash;
+	tHash Hash;
+	std::vector<tTJSCustomObject *> Objects;
+	tjs_uint Cursor; // next candidate in Objects
+	tjs_uint Step;
+
+	// work area for a step; tEntry pointers are valid while no object is
+	// added or removed
+	std::vector<tEntry *> Children;
+	std::vector<tEntry *> Stack;
+	std::vector<tEntry *> Roots;
+	tjs_uint Visited;
+
+public:
+	tTJSCycleCollector() : Cursor(0), Step(0), Visited(0) {}
+
+	void Add(tTJSCustomObject *object)
+	{
+		tEntry entry;
+		entry.Object = object;
+		entry.Index = (tjs_uint)Objects.size();
+		entry.Step = 0;
+		entry.Count = 0;
+		entry.Color = ccBlack;
+		Hash.Add(object, entry);
+		Objects.push_back(object);
+	}
+
+	void Remove(tTJSCustomObject *object)
+	{
+		tEntry *entry = Hash.Find(object);
+		if(!entry) return; // created before the collector started
+
+		// move the last object to the removed position
+		tjs_uint index = entry->Index;
+		tTJSCustomObject *last = Objects.back();
+		Objects[index] = last;
+		Objects.pop_back();
+		if(last != object) Hash.Find(last)->Index = index;
+		Hash.Delete(object);
+	}
+
+	void Collect(tjs_uint candidates, tjs_uint maxnodes,
+		tTJSCycleCollectorResult &result);
+
+private:
+	void Touch(tEntry *entry);
+	void AddChild(tTJSCustomObject *owner, const tTJSVariant &value);
+	void GetChildren(tEntry *entry);
+	bool MarkGray(tEntry *root, tjs_uint maxnodes);
+	void Scan(tEntry *root);
+	void ScanBlack(tEntry *root);
+	void CollectWhite(tEntry *root, std::vector<tTJSCustomObject *> &garbage);
+	static tjs_uint64 GetObjectSize(tTJSCustomObject *object);
+};
+//---------------------------------------------------------------------------
+void tTJSCycleCollector::Touch(tEntry *entry)
+{
+	// initialize the entry for the current step
+	if(entry->Step == Step) return;
+	entry->Step = Step;
+	entry->Count = (tjs_int)entry->Object->GetRefCount();
+	entry->Color = ccBlack;
+}
+//---------------------------------------------------------------------------
+void tTJSCycleCollector::AddChild(tTJSCustomObject *owner, const tTJSVariant &value)
+{
+	// every object closure holds references of both Object and ObjThis,
+	// except for ObjThis referring to the owner (the owner releases it;
+	// see CheckObjectClosureAdd).
+	if(value.Type() != tvtObject) return;
+	tTJSVariantClosure clo = value.AsObjectClosureNoAddRef();
+	tEntry *entry;
+	if(clo.Object && (entry = Hash.Find(clo.Object)) != NULL)
+		Children.push_back(entry);
+	if(clo.ObjThis && clo.ObjThis != (iTJSDispatch2*)owner &&
+		(entry = Hash.Find(clo.ObjThis)) != NULL)
+		Children.push_back(entry);
+}
+//---------------------------------------------------------------------------
+void tTJSCycleCollector::GetChildren(tEntry *entry)
+{
+	// list tracked objects referred by the object's members and
+	// Array's elements into Children; an object appears as many times as
+	// it is referred.
+	Children.clear();
+	tTJSCustomObject *object = entry->Object;
+
+	const tTJSCustomObject::tTJSSymbolData * lv1 = object->Symbols;
+	const tTJSCustomObject::tTJSSymbolData * lv1lim = lv1 + object->HashSize;
+	for(; lv1 < lv1lim; lv1++)
+	{
+		const tTJSCustomObject::tTJSSymbolData * d = lv1;
+		if(!(d->SymFlags & TJS_SYMBOL_USING)) d = d->Next;
+		while(d)
+		{
+			if(d->SymFlags & TJS_SYMBOL_USING)
+				AddChild(object, *(const tTJSVariant*)(&d->Value));
+			d = d->Next;
+		}
+	}
+
+	tjs_int32 arrayclassid = TJSGetArrayClassID();
+	for(tjs_int i = 0; i < TJS_MAX_NATIVE_CLASS; i++)
+	{
+		if(object->ClassIDs[i] == arrayclassid && arrayclassid != -1 && object->ClassInstances[i])
+		{
+			tTJSArrayNI *ni = (tTJSArrayNI*)object->ClassInstances[i];
+			tTJSArrayNI::tArrayItemIterator it;
+			for(it = ni->Items.begin(); it != ni->Items.end(); it++)
+				AddChild(object, *it);
+		}
+	}
+}
+//---------------------------------------------------------------------------
+bool tTJSCycleCollector::MarkGray(tEntry *root, tjs_uint maxnodes)
+{
+	// subtract internal references from the counts of all objects
+	// reachable from root. returns false if too many objects are visited.
+	Touch(root);
+	if(root->Color == ccGray) return true;
+	root->Color = ccGray;
+	Visited++;
+	Stack.clear();
+	Stack.push_back(root);
+	while(!Stack.empty())
+	{
+		tEntry *entry = Stack.back();
+		Stack.pop_back();
+		GetChildren(entry);
+		for(tjs_uint i = 0; i < Children.size(); i++)
+		{
+			tEntry *child = Children[i];
+			Touch(child);
+			child->Count--;
+			if(child->Color != ccGray)
+			{
+				child->Color = ccGray;
+				if(++Visited > maxnodes) return false;
+				Stack.push_back(child);
+			}
+		}
+	}
+	return true;
+}
+//---------------------------------------------------------------------------
+void tTJSCycleCollector::Scan(tEntry *root)
+{
+	// objects still referred from outside are alive, and so are all objects
+	// reachable from them. others become white.
+	std::vector<tEntry *> stack;
+	stack.push_back(root);
+	while(!stack.empty())
+	{
+		tEntry *entry = stack.back();
+		stack.pop_back();
+		if(entry->Color != ccGray) continue;
+		if(entry->Count > 0)
+		{
+			ScanBlack(entry);
+		}
+		else
+		{
+			entry->Color = ccWhite;
+			GetChildren(entry);
+			stack.insert(stack.end(), Children.begin(), Children.end());
+		}
+	}
+}
+//---------------------------------------------------------------------------
+void tTJSCycleCollector::ScanBlack(tEntry *root)
+{
+	// restore the counts subtracted by MarkGray
+	root->Color = ccBlack;
+	Stack.clear();
+	Stack.push_back(root);
+	while(!Stack.empty())
+	{
+		tEntry *entry = Stack.back();
+		Stack.pop_back();
+		GetChildren(entry);
+		for(tjs_uint i = 0; i < Children.size(); i++)
+		{
+			tEntry *child = Children[i];
+			child->Count++;
+			if(child->Color != ccBlack)
+			{
+				child->Color = ccBlack;
+				Stack.push_back(child);
+			}
+		}
+	}
+}
+//---------------------------------------------------------------------------
+void tTJSCycleCollector::CollectWhite(tEntry *root,
+	std::vector<tTJSCustomObject *> &garbage)
+{
+	if(root->Color != ccWhite) return;
+	root->Color = ccBlack;
+	garbage.push_back(root->Object);
+	Stack.clear();
+	Stack.push_back(root);
+	while(!Stack.empty())
+	{
+		tEntry *entry = Stack.back();
+		Stack.pop_back();
+		GetChildren(entry);
+		for(tjs_uint i = 0; i < Children.size(); i++)
+		{
+			tEntry *child = Children[i];
+			if(child->Color == ccWhite)
+			{
+				child->Color = ccBlack;
+				garbage.push_back(child->Object);
+				Stack.push_back(child);
+			}
+		}
+	}
+}
+//---------------------------------------------------------------------------
+tjs_uint64 tTJSCycleCollector::GetObjectSize(tTJSCustomObject *object)
+{
+	// approximate memory size of the object; derived classes' own members
+	// are not counted
+	tjs_uint64 size = sizeof(tTJSCustomObject);
+	size += (tjs_uint64)object->HashSize * sizeof(tTJSCustomObject::tTJSSymbolData);
+	if(object->Count > object->HashSize)
+		size += (tjs_uint64)(object->Count - object->HashSize) *
+			sizeof(tTJSCustomObject::tTJSSymbolData);
+
+	tjs_int32 arrayclassid = TJSGetArrayClassID();
+	for(tjs_int i = 0; i < TJS_MAX_NATIVE_CLASS; i++)
+	{
+		if(object->ClassIDs[i] == arrayclassid && arrayclassid != -1 && object->ClassInstances[i])
+		{
+			tTJSArrayNI *ni = (tTJSArrayNI*)object->ClassInstances[i];
+			size += sizeof(tTJSArrayNI) + ni->Items.capacity() * sizeof(tTJSVariant);
+		}
+	}
+	return size;
+}
+//---------------------------------------------------------------------------
+void tTJSCycleCollector::Collect(tjs_uint candidates, tjs_uint maxnodes,
+	tTJSCycleCollectorResult &result)
+{
+	result.Tracked = (tjs_uint)Objects.size();
+	result.Scanned = 0;
+	result.Collected = 0;
+	result.CollectedBytes = 0;
+	result.Aborted = false;
+	if(Objects.empty()) return;
+
+	Step++;
+	if(Step == 0) Step = 1; // 0 is used for "not touched yet"
+	Visited = 0;
+
+	// take candidates in round-robin order
+	if(candidates > Objects.size()) candidates = (tjs_uint)Objects.size();
+	Roots.clear();
+	for(tjs_uint i = 0; i < candidates; i++)
+	{
+		if(Cursor >= Objects.size()) Cursor = 0;
+		Roots.push_back(Hash.Find(Objects[Cursor]));
+		Cursor++;
+	}
+
+	// trial deletion
+	for(tjs_uint i = 0; i < Roots.size(); i++)
+	{
+		if(MarkGray(Roots[i], maxnodes)) continue;
+
+		// too many objects are reachable from the candidate. the candidates
+		// before it are fully marked, but the aborted marking may have
+		// subtracted references from their objects; mark them again
+		// without it. the next call starts from the aborted candidate,
+		// or from the one after it if it was the first one; it can never
+		// be finished with this "maxnodes".
+		result.Scanned = Visited;
+		result.Aborted = true;
+		Cursor = Roots[i]->Index;
+		if(i == 0) { Cursor++; return; }
+		Roots.resize(i);
+		Step++;
+		if(Step == 0) Step = 1;
+		for(tjs_uint j = 0; j < Roots.size(); j++)
+			MarkGray(Roots[j], (tjs_uint)-1);
+		break;
+	}
+	if(!result.Aborted) result.Scanned = Visited;
+	for(tjs_uint i = 0; i < Roots.size(); i++) Scan(Roots[i]);
+
+	std::vector<tTJSCustomObject *> garbage;
+	for(tjs_uint i = 0; i < Roots.size(); i++) CollectWhite(Roots[i], garbage);
+	if(garbage.empty()) return;
+
+	for(tjs_uint i = 0; i < garbage.size(); i++)
+	{
+		// an object being invalidated (or being deleted) must not be
+		// touched; leave the cycle for the next time
+		if(garbage[i]->IsInvalidating) return;
+	}
+
+	// invalidate the garbage. finalizers may release other objects, so
+	// all objects are held until every object has been invalidated.
+	// entries must not be used from here.
+	for(tjs_uint i = 0; i < garbage.size(); i++)
+	{
+		result.CollectedBytes += GetObjectSize(garbage[i]);
+		garbage[i]->AddRef();
+	}
+	result.Collected = (tjs_uint)garbage.size();
+
+	try
+	{
+		for(tjs_uint i = 0; i < garbage.size(); i++)
+		{
+			if(!garbage[i]->IsInvalidated)
+				garbage[i]->Invalidate(0, NULL, NULL, garbage[i]);
+		}
+	}
+	catch(...)
+	{
+		for(tjs_uint i = 0; i < garbage.size(); i++) garbage[i]->Release();
+		throw;
+	}
+	for(tjs_uint i = 0; i < garbage.size(); i++) garbage[i]->Release();
+}
+//---------------------------------------------------------------------------
+tTJSCycleCollector * TJSCycleCollector = NULL;
+//---------------------------------------------------------------------------
+void TJSStartCycleCollector()
+{
+	if(!TJSCycleCollector) TJSCycleCollector = new tTJSCycleCollector();
+}
+//---------------------------------------------------------------------------
+void TJSStopCycleCollector()
+{
+	if(TJSCycleCollector) delete TJSCycleCollector, TJSCycleCollector = NULL;
+}
+//---------------------------------------------------------------------------
+void TJSAddCycleCollectorObject(tTJSCustomObject *object)
+{
+	if(TJSCycleCollector) TJSCycleCollector->Add(object);
+}
+//---------------------------------------------------------------------------
+void TJSRemoveCycleCollectorObject(tTJSCustomObject *object)
+{
+	if(TJSCycleCollector) TJSCycleCollector->Remove(object);
+}
+//---------------------------------------------------------------------------
+void TJSCollectCycles(tjs_uint candidates, tjs_uint maxnodes,
+	tTJSCycleCollectorResult &result)
+{
+	if(!TJSCycleCollector)
+	{
+		memset(&result, 0, sizeof(result));
+		return;
+	}
+	TJSCycleCollector->Collect(candidates, maxnodes, result);
+}
+//---------------------------------------------------------------------------
+} // namespace TJS
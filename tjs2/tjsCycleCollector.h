@@ -0,0 +1,65 @@
+//---------------------------------------------------------------------------
+/*
+	TJS2 Script Engine
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Cycle collector for reference-counted objects
+//---------------------------------------------------------------------------
+/*
+	Reference cycles (closures capturing "this", parent/child dictionaries
+	and so on) are never freed by reference counting alone. The cycle
+	collector finds such cycles with trial deletion (the synchronous
+	algorithm of Bacon and Rajan) and invalidates the objects in them, as
+	if the script had called "invalidate" for each of them.
+
+	Only tTJSCustomObject based objects created after the collector is
+	started are tracked. References held by native instances (other than
+	Array's elements) are not visible to the collector; objects referred
+	from them are always considered alive, so the collector never frees
+	anything which is still in use, but it may miss some cycles.
+
+	TJSCollectCycles processes a part of the tracked objects at a time, so
+	it can be called repeatedly at idle time.
+*/
+#ifndef tjsCycleCollectorH
+#define tjsCycleCollectorH
+
+#include "tjsTypes.h"
+
+namespace TJS
+{
+//---------------------------------------------------------------------------
+class tTJSCustomObject;
+class tTJSCycleCollector;
+extern tTJSCycleCollector * TJSCycleCollector;
+static inline bool TJSCycleCollectorEnabled() { return 0!=TJSCycleCollector; }
+extern void TJSStartCycleCollector();
+extern void TJSStopCycleCollector();
+extern void TJSAddCycleCollectorObject(tTJSCustomObject *object);
+extern void TJSRemoveCycleCollectorObject(tTJSCustomObject *object);
+//---------------------------------------------------------------------------
+struct tTJSCycleCollectorResult
+{
+	tjs_uint Tracked; // number of tracked objects
+	tjs_uint Scanned; // number of objects visited by the trial deletion
+	tjs_uint Collected; // number of invalidated objects
+	tjs_uint64 CollectedBytes; // approximate memory size of them
+	bool Aborted;
+		// the scan exceeded "maxnodes"; only the candidates before the one
+		// which exceeded it were examined, and the next call starts from
+		// that candidate (or the one after it, if it was the first).
+};
+extern void TJSCollectCycles(tjs_uint candidates, tjs_uint maxnodes,
+	tTJSCycleCollectorResult &result);
+	/*
+		"candidates" is the number of tracked objects to start the trial
+		deletion from; the next call continues from the next object.
+		"maxnodes" limits the number of objects visited.
+	*/
+//---------------------------------------------------------------------------
+} // namespace TJS
+
+#endif
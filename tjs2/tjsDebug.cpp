@@ -11,7 +11,12 @@
 #include "tjsCommHead.h"
 
 #include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "tjs.h"
 #include "tjsDebug.h"
+#include "tjsDictionary.h"
 #include "tjsHashSearch.h"
 #include "tjsInterCodeGen.h"
 #include "tjsGlobalStringMap.h"
@@ -58,7 +63,7 @@ static T TJSRestoreLog()
 }
 //---------------------------------------------------------------------------
 template <>
-static void TJSStoreLog<ttstr>(const ttstr & which)
+void TJSStoreLog<ttstr>(const ttstr & which)
 {
 	// store a string into log stream
 	tjs_int length = which.GetLen();
@@ -68,7 +73,7 @@ static void TJSStoreLog<ttstr>(const ttstr & which)
 }
 //---------------------------------------------------------------------------
 template <>
-static ttstr TJSRestoreLog<ttstr>()
+ttstr TJSRestoreLog<ttstr>()
 {
 	// restore a string from log stream
 	tjs_int length;
@@ -82,7 +87,7 @@ static ttstr TJSRestoreLog<ttstr>()
 }
 //---------------------------------------------------------------------------
 template <>
-static void TJSStoreLog<tTJSObjectHashMapLogItemId>(const tTJSObjectHashMapLogItemId & id)
+void TJSStoreLog<tTJSObjectHashMapLogItemId>(const tTJSObjectHashMapLogItemId & id)
 {
 	// log item id
 	char cid = id;
@@ -90,7 +95,7 @@ static void TJSStoreLog<tTJSObjectHashMapLogItemId>(const tTJSObjectHashMapLogIt
 }
 //---------------------------------------------------------------------------
 template <>
-static tTJSObjectHashMapLogItemId TJSRestoreLog<tTJSObjectHashMapLogItemId>()
+tTJSObjectHashMapLogItemId TJSRestoreLog<tTJSObjectHashMapLogItemId>()
 {
 	// restore item id
 	char cid;
@@ -567,13 +572,17 @@ struct tTJSStackRecord
 	tTJSInterCodeContext * Context;
 	const tjs_int * CodeBase;
 	tjs_int * const * CodePtr;
+	tjs_int CodeOffset; // the last position after the execution exits
 	bool InTry;
+	tjs_int NativeDepth; // native functions called from this frame and running
 
 	tTJSStackRecord(tTJSInterCodeContext * context, bool in_try)
 	{
 		CodeBase = NULL;
 		CodePtr = NULL;
+		CodeOffset = 0;
 		InTry = in_try;
+		NativeDepth = 0;
 		Context = context;
 		if(Context) Context->AddRef();
 	}
@@ -599,7 +608,9 @@ struct tTJSStackRecord
 		}
 		CodeBase = rhs.CodeBase;
 		CodePtr = rhs.CodePtr;
+		CodeOffset = rhs.CodeOffset;
 		InTry = rhs.InTry;
+		NativeDepth = rhs.NativeDepth;
 	}
 };
 
@@ -644,12 +655,39 @@ public:
 
 	void Push(tTJSInterCodeContext *context, bool in_try)
 	{
+		// safe point of the profiler; ticks elapsed since the caller's last
+		// safe point were spent in the caller, or in the native function
+		// which calls this function if the caller is running one
+		if(TJSProfilerTicks != TJSProfilerTicksTaken)
+		{
+			if(Stack.empty())
+				TJSProfilerTicksTaken = TJSProfilerTicks; // was idle
+			else
+				TJSProfilerTakeSample(Stack.back().NativeDepth != 0);
+		}
 		Stack.push_back(tTJSStackRecord(context, in_try));
 	}
 
+	void EnterNative()
+	{
+		// the top frame calls a native function
+		TJSProfilerSafePoint(false);
+		if(!Stack.empty()) Stack.back().NativeDepth++;
+	}
+
+	void LeaveNative()
+	{
+		TJSProfilerSafePoint(true);
+		if(!Stack.empty() && Stack.back().NativeDepth)
+			Stack.back().NativeDepth--;
+	}
+
 	void Pop()
 	{
-		Stack.pop_back();
+		TJSProfilerSafePoint(false);
+		// the stack may lack frames pushed before the tracer is created
+		// (the profiler creates the tracer on the fly)
+		if(!Stack.empty()) Stack.pop_back();
 	}
 
 	void SetCodePointer(const tjs_int32 * codebase, tjs_int32 * const * codeptr)
@@ -661,6 +699,17 @@ public:
 		Stack[top].CodePtr = codeptr;
 	}
 
+	void LeaveCode()
+	{
+		// the code pointer will be invalid; keep the last position
+		tjs_uint size = (tjs_uint)Stack.size();
+		if(size < 1) return;
+		tTJSStackRecord & rec = Stack[size - 1];
+		if(rec.CodeBase && rec.CodePtr)
+			rec.CodeOffset = (tjs_int)(*rec.CodePtr - rec.CodeBase);
+		rec.CodePtr = NULL;
+	}
+
 	ttstr GetTraceString(tjs_int limit, const tjs_char * delimiter)
 	{
 		// get stack trace string
@@ -672,19 +721,7 @@ public:
 		{
 			if(!ret.IsEmpty()) ret += delimiter;
 
-			const tTJSStackRecord & rec = Stack[top];
-			ttstr str;
-			if(rec.CodeBase && rec.CodePtr)
-			{
-				str = rec.Context->GetPositionDescriptionString(
-					(tjs_int)(*rec.CodePtr - rec.CodeBase));
-			}
-			else
-			{
-				str = rec.Context->GetPositionDescriptionString(0);
-			}
-
-			ret += str;
+			ret += GetPositionString(Stack[top]);
 
 			// skip try block stack.
 			// 'try { } catch' blocks are implemented as sub-functions
@@ -703,6 +740,32 @@ public:
 
 		return ret;
 	}
+
+	void GetFrames(std::vector<ttstr> & frames)
+	{
+		// get position strings of each function, from the bottom.
+		// try blocks are merged into the function which contains them.
+		tjs_int size = (tjs_int)Stack.size();
+		for(tjs_int i = 0; i < size; i++)
+		{
+			if(i + 1 < size && Stack[i + 1].InTry) continue;
+			frames.push_back(GetPositionString(Stack[i]));
+		}
+	}
+
+private:
+	static ttstr GetPositionString(const tTJSStackRecord & rec)
+	{
+		if(rec.CodeBase && rec.CodePtr)
+		{
+			return rec.Context->GetPositionDescriptionString(
+				(tjs_int)(*rec.CodePtr - rec.CodeBase));
+		}
+		else
+		{
+			return rec.Context->GetPositionDescriptionString(rec.CodeOffset);
+		}
+	}
 };
 //---------------------------------------------------------------------------
 void TJSAddRefStackTracer()
@@ -734,6 +797,24 @@ void TJSStackTracerPop()
 		TJSStackTracer->Pop();
 }
 //---------------------------------------------------------------------------
+void TJSStackTracerLeaveCode()
+{
+	if(TJSStackTracer)
+		TJSStackTracer->LeaveCode();
+}
+//---------------------------------------------------------------------------
+void TJSStackTracerEnterNative()
+{
+	if(TJSStackTracer)
+		TJSStackTracer->EnterNative();
+}
+//---------------------------------------------------------------------------
+void TJSStackTracerLeaveNative()
+{
+	if(TJSStackTracer)
+		TJSStackTracer->LeaveNative();
+}
+//---------------------------------------------------------------------------
 ttstr TJSGetStackTraceString(tjs_int limit, const tjs_char *delimiter)
 {
 	if(TJSStackTracer)
@@ -743,6 +824,851 @@ ttstr TJSGetStackTraceString(tjs_int limit, const tjs_char *delimiter)
 }
 //---------------------------------------------------------------------------
 
+
+
+//---------------------------------------------------------------------------
+// Profiler : sampling profiler for scripts
+//---------------------------------------------------------------------------
+/*
+	The sampling thread only counts up TJSProfilerTicks at each interval.
+	The interpreter checks the counter at safe points (taken jumps, function
+	calls and returns) and takes a sample of the stack tracer's stack when
+	there are pending ticks; the sample is weighted by the number of the
+	pending ticks. Ticks elapsed in a native function called from a script
+	are attributed to a "(native)" frame under the calling position; native
+	functions of the TJS2 native class framework mark the calling frame
+	while they run (tTJSStackTracerNativeHolder), and the time in other
+	native functions (e.g. plugins) is detected at the safe point just
+	after the call.
+
+	Samples are aggregated into a calling context tree, and also recorded in
+	order, up to TJS_PROFILER_MAX_TIMELINE samples, for the trace export.
+*/
+#define TJS_PROFILER_MAX_TIMELINE 1048576
+volatile tjs_uint32 TJSProfilerTicks = 0;
+tjs_uint32 TJSProfilerTicksTaken = 0;
+//---------------------------------------------------------------------------
+class tTJSProfiler;
+static tTJSProfiler * TJSProfiler = NULL;
+//---------------------------------------------------------------------------
+class tTJSProfiler
+{
+	typedef std::basic_string<tjs_char> tBuffer;
+
+	struct tNode
+	{
+		tjs_int Parent;
+		ttstr Name;
+		tjs_uint64 Self; // ticks sampled with this node on the top
+
+		tNode(tjs_int parent, const ttstr & name) :
+			Parent(parent), Name(name), Self(0) {;}
+	};
+	std::vector<tNode> Nodes; // calling context tree; Nodes[0] is the root
+	std::map<std::pair<tjs_int, ttstr>, tjs_int> Children;
+
+	struct tSample
+	{
+		tjs_uint64 Time; // in us
+		tjs_int Node;
+		tjs_uint32 Weight;
+	};
+	std::vector<tSample> Timeline;
+
+	std::vector<ttstr> Frames; // work area
+
+	tTJSIntervalThread * Thread; // the sampling thread
+	tjs_uint Interval; // in ms
+	tjs_uint64 Origin; // time origin of the timeline, in TJSGetPerformanceCounter unit
+
+public:
+	tTJSProfiler()
+	{
+		Thread = NULL;
+		Interval = 1;
+		Clear();
+	}
+
+	~tTJSProfiler()
+	{
+		Stop();
+	}
+
+	bool GetRunning() const { return Thread != NULL; }
+
+	void Start(tjs_uint interval)
+	{
+		if(Thread) return;
+
+		TJSAddRefStackTracer();
+		TJSProfilerTicksTaken = TJSProfilerTicks;
+
+		Interval = interval ? interval : 1;
+		try
+		{
+			Thread = new tTJSIntervalThread(Interval, TickProc, NULL);
+		}
+		catch(...)
+		{
+			TJSReleaseStackTracer();
+			throw;
+		}
+	}
+
+	void Stop()
+	{
+		if(!Thread) return;
+
+		delete Thread, Thread = NULL;
+
+		TJSProfilerTicksTaken = TJSProfilerTicks;
+		TJSReleaseStackTracer();
+	}
+
+	void Clear()
+	{
+		Nodes.clear();
+		Children.clear();
+		Timeline.clear();
+		Nodes.push_back(tNode(-1, ttstr()));
+		Origin = TJSGetPerformanceCounter();
+	}
+
+	void AddSample(tjs_uint32 weight, bool native)
+	{
+		if(!TJSStackTracer) return;
+		Frames.clear();
+		TJSStackTracer->GetFrames(Frames);
+		if(Frames.empty()) return;
+		if(native) Frames.push_back(TJS_W("(native)"));
+
+		// walk down the calling context tree
+		tjs_int node = 0;
+		for(std::vector<ttstr>::iterator i = Frames.begin(); i != Frames.end(); i++)
+		{
+			std::pair<tjs_int, ttstr> key(node, *i);
+			std::map<std::pair<tjs_int, ttstr>, tjs_int>::iterator c =
+				Children.find(key);
+			if(c != Children.end())
+			{
+				node = c->second;
+			}
+			else
+			{
+				Nodes.push_back(tNode(node, *i));
+				node = (tjs_int)Nodes.size() - 1;
+				Children.insert(std::make_pair(key, node));
+			}
+		}
+		Nodes[node].Self += weight;
+
+		if(Timeline.size() < TJS_PROFILER_MAX_TIMELINE)
+		{
+			tjs_uint64 elapsed = TJSGetPerformanceCounter() - Origin;
+			tjs_uint64 frequency = TJSGetPerformanceFrequency();
+			tSample sample;
+			sample.Time = elapsed / frequency * 1000000 +
+				elapsed % frequency * 1000000 / frequency;
+			sample.Node = node;
+			sample.Weight = weight;
+			Timeline.push_back(sample);
+		}
+	}
+
+	ttstr GetCollapsedStacks() const
+	{
+		// "frame;frame;frame ticks" per line, as the input of flamegraph.pl
+		// and compatible tools
+		tBuffer out;
+		std::vector<tjs_int> path;
+		for(tjs_int n = 1; n < (tjs_int)Nodes.size(); n++)
+		{
+			if(!Nodes[n].Self) continue;
+			GetPath(n, path);
+			for(std::vector<tjs_int>::iterator i = path.begin(); i != path.end(); i++)
+			{
+				if(i != path.begin()) out += TJS_W(';');
+				AppendCollapsedName(out, Nodes[*i].Name);
+			}
+			tjs_char buf[32];
+			TJS_snprintf(buf, sizeof(buf)/sizeof(tjs_char), TJS_W(" %llu\n"),
+				(unsigned long long)Nodes[n].Self);
+			out += buf;
+		}
+		return ttstr(out.c_str());
+	}
+
+	ttstr GetChromeTrace() const
+	{
+		// Trace Event Format (as chrome://tracing and Perfetto read) of
+		// duration events. a sample with weight w covers w intervals
+		// before its time.
+		tBuffer out;
+		out += TJS_W("{\"traceEvents\":[\n");
+		out += TJS_W("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,")
+			TJS_W("\"args\":{\"name\":\"TJS\"}}");
+
+		std::vector<tjs_int> open; // currently open frames, from the bottom
+		std::vector<tjs_int> path;
+		tjs_uint64 end = 0;
+		for(std::vector<tSample>::const_iterator s = Timeline.begin();
+			s != Timeline.end(); s++)
+		{
+			tjs_uint64 span = (tjs_uint64)s->Weight * Interval * 1000;
+			tjs_uint64 start = s->Time > span ? s->Time - span : 0;
+			if(start < end) start = end;
+
+			// close all frames if there is a gap
+			if(start > end) CloseFrames(out, open, 0, end);
+
+			GetPath(s->Node, path);
+			size_t common = 0;
+			while(common < open.size() && common < path.size() &&
+				open[common] == path[common]) common++;
+			CloseFrames(out, open, common, start);
+			for(size_t i = common; i < path.size(); i++)
+			{
+				AppendTraceEvent(out, Nodes[path[i]].Name, TJS_W('B'), start);
+				open.push_back(path[i]);
+			}
+			end = s->Time > start ? s->Time : start;
+		}
+		CloseFrames(out, open, 0, end);
+
+		out += TJS_W("\n]}\n");
+		return ttstr(out.c_str());
+	}
+
+private:
+	static void TickProc(void *)
+	{
+		TJSProfilerTicks = TJSProfilerTicks + 1;
+	}
+
+	void GetPath(tjs_int node, std::vector<tjs_int> & path) const
+	{
+		// nodes from the bottom (excluding the root) to "node"
+		path.clear();
+		for(; node > 0; node = Nodes[node].Parent) path.push_back(node);
+		std::reverse(path.begin(), path.end());
+	}
+
+	void CloseFrames(tBuffer & out, std::vector<tjs_int> & open, size_t keep,
+		tjs_uint64 time) const
+	{
+		while(open.size() > keep)
+		{
+			AppendTraceEvent(out, Nodes[open.back()].Name, TJS_W('E'), time);
+			open.pop_back();
+		}
+	}
+
+	static void AppendCollapsedName(tBuffer & out, const ttstr & name)
+	{
+		// ';' separates frames and line breaks separate stacks
+		for(const tjs_char *p = name.c_str(); *p; p++)
+		{
+			if(*p == TJS_W(';')) out += TJS_W(',');
+			else if(*p == TJS_W('\n') || *p == TJS_W('\r')) out += TJS_W(' ');
+			else out += *p;
+		}
+	}
+
+	static void AppendTraceEvent(tBuffer & out, const ttstr & name,
+		tjs_char phase, tjs_uint64 time)
+	{
+		out += TJS_W(",\n{\"name\":\"");
+		for(const tjs_char *p = name.c_str(); *p; p++)
+		{
+			if(*p == TJS_W('"') || *p == TJS_W('\\'))
+			{
+				out += TJS_W('\\');
+				out += *p;
+			}
+			else if(*p < 0x20)
+			{
+				tjs_char buf[8];
+				TJS_snprintf(buf, sizeof(buf)/sizeof(tjs_char), TJS_W("\\u%04x"), (int)*p);
+				out += buf;
+			}
+			else
+			{
+				out += *p;
+			}
+		}
+		tjs_char buf[96];
+		TJS_snprintf(buf, sizeof(buf)/sizeof(tjs_char),
+			TJS_W("\",\"cat\":\"tjs\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":1}"),
+			(int)phase, (unsigned long long)time);
+		out += buf;
+	}
+};
+//---------------------------------------------------------------------------
+void TJSStartProfiler(tjs_uint interval)
+{
+	if(!TJSProfiler) TJSProfiler = new tTJSProfiler();
+	TJSProfiler->Start(interval);
+}
+//---------------------------------------------------------------------------
+void TJSStopProfiler()
+{
+	if(TJSProfiler) TJSProfiler->Stop();
+}
+//---------------------------------------------------------------------------
+bool TJSIsProfilerRunning()
+{
+	return TJSProfiler && TJSProfiler->GetRunning();
+}
+//---------------------------------------------------------------------------
+void TJSClearProfile()
+{
+	if(TJSProfiler) TJSProfiler->Clear();
+}
+//---------------------------------------------------------------------------
+void TJSShutdownProfiler()
+{
+	if(TJSProfiler) delete TJSProfiler, TJSProfiler = NULL;
+}
+//---------------------------------------------------------------------------
+void TJSProfilerTakeSample(bool native)
+{
+	tjs_uint32 ticks = TJSProfilerTicks;
+	tjs_uint32 weight = ticks - TJSProfilerTicksTaken;
+	TJSProfilerTicksTaken = ticks;
+
+	// this may be called while unwinding the stack by an exception
+	try
+	{
+		if(TJSProfiler) TJSProfiler->AddSample(weight, native);
+	}
+	catch(...)
+	{
+	}
+}
+//---------------------------------------------------------------------------
+ttstr TJSGetProfileCollapsedStacks()
+{
+	if(TJSProfiler) return TJSProfiler->GetCollapsedStacks();
+	return ttstr();
+}
+//---------------------------------------------------------------------------
+ttstr TJSGetProfileChromeTrace()
+{
+	if(TJSProfiler) return TJSProfiler->GetChromeTrace();
+	return TJS_W("{\"traceEvents\":[]}\n");
+}
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// VMCounters : execution counters of the VM
+//---------------------------------------------------------------------------
+/*
+	Counting is compiled in by TJS_VM_COUNTERS, and the counters count only
+	while TJSVMCountersEnabled is true; the interpreter checks the flag once
+	per ExecuteCode call, so turning counters on takes effect from the next
+	function call.
+
+	Native methods are named for the counters at their registration, only
+	while the counters are enabled; enable them before the script engine is
+	created (the host's "-vmcounters=yes") to name the built-in classes too.
+	Calls of unnamed native methods are counted as "(unknown)".
+
+	Property "misses" are lookups which did not find the member (TJS has no
+	inline cache to miss; a failed lookup is the nearest equivalent, and it
+	is what walks the whole hash chain and the class chain).
+*/
+#ifdef TJS_VM_COUNTERS
+//---------------------------------------------------------------------------
+bool TJSVMCountersEnabled = false;
+tjs_uint64 TJSVMOpcodeCounts[__VM_LAST];
+//---------------------------------------------------------------------------
+#define TJS_VM_OP_NAMES(x) TJS_W(x), TJS_W(x "pd"), TJS_W(x "pi"), TJS_W(x "p")
+static const tjs_char * const TJSVMOpcodeNames[] =
+{
+	TJS_W("nop"), TJS_W("const"), TJS_W("cp"), TJS_W("cl"), TJS_W("ccl"),
+	TJS_W("tt"), TJS_W("tf"), TJS_W("ceq"), TJS_W("cdeq"), TJS_W("clt"),
+	TJS_W("cgt"), TJS_W("setf"), TJS_W("setnf"), TJS_W("lnot"), TJS_W("nf"),
+	TJS_W("jf"), TJS_W("jnf"), TJS_W("jmp"),
+
+	TJS_VM_OP_NAMES("inc"),
+	TJS_VM_OP_NAMES("dec"),
+	TJS_VM_OP_NAMES("lor"),
+	TJS_VM_OP_NAMES("land"),
+	TJS_VM_OP_NAMES("bor"),
+	TJS_VM_OP_NAMES("bxor"),
+	TJS_VM_OP_NAMES("band"),
+	TJS_VM_OP_NAMES("sar"),
+	TJS_VM_OP_NAMES("sal"),
+	TJS_VM_OP_NAMES("sr"),
+	TJS_VM_OP_NAMES("add"),
+	TJS_VM_OP_NAMES("sub"),
+	TJS_VM_OP_NAMES("mod"),
+	TJS_VM_OP_NAMES("div"),
+	TJS_VM_OP_NAMES("idiv"),
+	TJS_VM_OP_NAMES("mul"),
+
+	TJS_W("bnot"), TJS_W("typeof"), TJS_W("typeofd"), TJS_W("typeofi"),
+	TJS_W("eval"), TJS_W("eexp"), TJS_W("chkins"),
+	TJS_W("asc"), TJS_W("chr"), TJS_W("num"), TJS_W("chs"), TJS_W("inv"),
+	TJS_W("chkinv"),
+	TJS_W("int"), TJS_W("real"), TJS_W("str"), TJS_W("octet"),
+	TJS_W("call"), TJS_W("calld"), TJS_W("calli"), TJS_W("new"),
+	TJS_W("gpd"), TJS_W("spd"), TJS_W("spde"), TJS_W("spdeh"), TJS_W("gpi"),
+	TJS_W("spi"), TJS_W("spie"),
+	TJS_W("gpds"), TJS_W("spds"), TJS_W("gpis"), TJS_W("spis"), TJS_W("setp"),
+	TJS_W("getp"),
+	TJS_W("deld"), TJS_W("deli"), TJS_W("srv"), TJS_W("ret"), TJS_W("entry"),
+	TJS_W("extry"), TJS_W("throw"),
+	TJS_W("chgthis"), TJS_W("global"), TJS_W("addci"), TJS_W("regmember"),
+	TJS_W("debugger"),
+};
+#undef TJS_VM_OP_NAMES
+// the table must follow tTJSVMCodes
+typedef char tTJSVMOpcodeNamesCheck[
+	sizeof(TJSVMOpcodeNames) / sizeof(TJSVMOpcodeNames[0]) == __VM_LAST ? 1 : -1];
+//---------------------------------------------------------------------------
+class tTJSVMCounters
+{
+public:
+	struct tPropertyCounter
+	{
+		tjs_uint64 Gets;
+		tjs_uint64 Sets;
+		tjs_uint64 Misses;
+	};
+
+	struct tNativeCounter
+	{
+		ttstr ClassName;
+		ttstr Name;
+		tjs_uint64 Calls;
+	};
+
+	// function counters; live ones are also referred from their contexts
+	std::vector<tTJSVMFunctionCounter *> Functions;
+
+	std::map<ttstr, tPropertyCounter> Properties;
+
+	// native methods which are alive, and counts of deleted ones by name
+	std::map<iTJSDispatch2 *, tNativeCounter> NativeMethods;
+	std::map<ttstr, tNativeCounter> RetiredNativeMethods;
+	tjs_uint64 UnknownNativeCalls;
+
+	tTJSVMCounters() : UnknownNativeCalls(0) {}
+
+	~tTJSVMCounters()
+	{
+		// live function counters are deleted by their contexts
+		for(std::vector<tTJSVMFunctionCounter *>::iterator i = Functions.begin();
+			i != Functions.end(); i++)
+			if((*i)->Orphan) delete *i;
+	}
+
+	void Reset()
+	{
+		memset(TJSVMOpcodeCounts, 0, sizeof(TJSVMOpcodeCounts));
+
+		std::vector<tTJSVMFunctionCounter *>::iterator d = Functions.begin();
+		for(std::vector<tTJSVMFunctionCounter *>::iterator i = Functions.begin();
+			i != Functions.end(); i++)
+		{
+			if((*i)->Orphan)
+			{
+				delete *i;
+			}
+			else
+			{
+				(*i)->Calls = (*i)->Ops = 0;
+				*(d++) = *i;
+			}
+		}
+		Functions.erase(d, Functions.end());
+
+		Properties.clear();
+
+		for(std::map<iTJSDispatch2 *, tNativeCounter>::iterator i =
+			NativeMethods.begin(); i != NativeMethods.end(); i++)
+			i->second.Calls = 0;
+		RetiredNativeMethods.clear();
+		UnknownNativeCalls = 0;
+	}
+
+	static ttstr GetNativeName(const tNativeCounter & c)
+	{
+		return c.ClassName + TJS_W(".") + c.Name;
+	}
+};
+//---------------------------------------------------------------------------
+static tTJSVMCounters * TJSVMCounters = NULL;
+//---------------------------------------------------------------------------
+static tTJSVMCounters * TJSVMGetCounters()
+{
+	if(!TJSVMCounters) TJSVMCounters = new tTJSVMCounters();
+	return TJSVMCounters;
+}
+//---------------------------------------------------------------------------
+tTJSVMFunctionCounter * TJSVMCreateFunctionCounter(tTJSInterCodeContext *context)
+{
+	tTJSVMFunctionCounter *counter = new tTJSVMFunctionCounter();
+	counter->Name = context->GetPositionDescriptionString(0);
+	counter->Calls = 0;
+	counter->Ops = 0;
+	counter->Orphan = false;
+	TJSVMGetCounters()->Functions.push_back(counter);
+	return counter;
+}
+//---------------------------------------------------------------------------
+void TJSVMReleaseFunctionCounter(tTJSVMFunctionCounter *counter)
+{
+	// the counts are kept until reset, for functions which are already
+	// deleted (such as of a script block which has been executed)
+	if(TJSVMCounters)
+		counter->Orphan = true;
+	else
+		delete counter; // counters have been shut down
+}
+//---------------------------------------------------------------------------
+void TJSVMCountPropertyAccess(const tjs_char *name, bool set, bool miss)
+{
+	tTJSVMCounters::tPropertyCounter & c =
+		TJSVMGetCounters()->Properties[name ? ttstr(name) : ttstr()];
+	if(set) c.Sets++; else c.Gets++;
+	if(miss) c.Misses++;
+}
+//---------------------------------------------------------------------------
+void TJSVMRegisterNativeMethod(iTJSDispatch2 *method,
+	const tjs_char *classname, const tjs_char *name)
+{
+	tTJSVMCounters::tNativeCounter & c = TJSVMGetCounters()->NativeMethods[method];
+	c.ClassName = classname;
+	c.Name = name;
+	c.Calls = 0;
+}
+//---------------------------------------------------------------------------
+void TJSVMUnregisterNativeMethod(iTJSDispatch2 *method)
+{
+	if(!TJSVMCounters) return;
+	std::map<iTJSDispatch2 *, tTJSVMCounters::tNativeCounter>::iterator i =
+		TJSVMCounters->NativeMethods.find(method);
+	if(i == TJSVMCounters->NativeMethods.end()) return;
+
+	if(i->second.Calls)
+	{
+		tTJSVMCounters::tNativeCounter & r = TJSVMCounters->RetiredNativeMethods[
+			tTJSVMCounters::GetNativeName(i->second)];
+		if(r.Name.IsEmpty())
+		{
+			r.ClassName = i->second.ClassName;
+			r.Name = i->second.Name;
+			r.Calls = 0;
+		}
+		r.Calls += i->second.Calls;
+	}
+	TJSVMCounters->NativeMethods.erase(i);
+}
+//---------------------------------------------------------------------------
+void TJSVMCountNativeCall(iTJSDispatch2 *method)
+{
+	tTJSVMCounters *counters = TJSVMGetCounters();
+	std::map<iTJSDispatch2 *, tTJSVMCounters::tNativeCounter>::iterator i =
+		counters->NativeMethods.find(method);
+	if(i != counters->NativeMethods.end())
+		i->second.Calls++;
+	else
+		counters->UnknownNativeCalls++; // not registered via RegisterNCM
+}
+//---------------------------------------------------------------------------
+// gathering results
+//---------------------------------------------------------------------------
+struct tTJSVMCounterEntry
+{
+	ttstr Name;
+	tjs_uint64 Count; // sort key
+	tjs_uint64 Values[3];
+};
+//---------------------------------------------------------------------------
+static bool TJSVMCounterEntryGreater(const tTJSVMCounterEntry & a,
+	const tTJSVMCounterEntry & b)
+{
+	if(a.Count != b.Count) return a.Count > b.Count;
+	return a.Name < b.Name;
+}
+//---------------------------------------------------------------------------
+enum tTJSVMCounterKind
+{
+	vckOpcodes,			// Values: count
+	vckFunctions,		// Values: ops, calls
+	vckProperties,		// Values: gets, sets, misses
+	vckNativeMethods,	// Values: calls
+	vckNativeClasses,	// Values: calls
+	vckNumKinds
+};
+//---------------------------------------------------------------------------
+static void TJSVMGatherCounters(tTJSVMCounterKind kind,
+	std::vector<tTJSVMCounterEntry> & out)
+{
+	// entries with the same name (such as functions of a script which has
+	// been loaded more than once) are summed up
+	out.clear();
+	std::map<ttstr, tTJSVMCounterEntry> sum;
+	tTJSVMCounters *counters = TJSVMGetCounters();
+
+	struct tAdder
+	{
+		std::map<ttstr, tTJSVMCounterEntry> & Sum;
+		tAdder(std::map<ttstr, tTJSVMCounterEntry> & sum) : Sum(sum) {}
+		void operator () (const ttstr & name, tjs_uint64 v0, tjs_uint64 v1 = 0,
+			tjs_uint64 v2 = 0)
+		{
+			std::map<ttstr, tTJSVMCounterEntry>::iterator i = Sum.find(name);
+			if(i == Sum.end())
+			{
+				tTJSVMCounterEntry e;
+				e.Name = name;
+				e.Count = 0;
+				e.Values[0] = e.Values[1] = e.Values[2] = 0;
+				i = Sum.insert(std::pair<ttstr, tTJSVMCounterEntry>(name, e)).first;
+			}
+			i->second.Values[0] += v0;
+			i->second.Values[1] += v1;
+			i->second.Values[2] += v2;
+		}
+	} add(sum);
+
+	switch(kind)
+	{
+	case vckOpcodes:
+		for(tjs_int i = 0; i < __VM_LAST; i++)
+			if(TJSVMOpcodeCounts[i]) add(TJSVMOpcodeNames[i], TJSVMOpcodeCounts[i]);
+		break;
+
+	case vckFunctions:
+		for(std::vector<tTJSVMFunctionCounter *>::iterator i =
+			counters->Functions.begin(); i != counters->Functions.end(); i++)
+			if((*i)->Calls || (*i)->Ops) add((*i)->Name, (*i)->Ops, (*i)->Calls);
+		break;
+
+	case vckProperties:
+		for(std::map<ttstr, tTJSVMCounters::tPropertyCounter>::iterator i =
+			counters->Properties.begin(); i != counters->Properties.end(); i++)
+			add(i->first, i->second.Gets, i->second.Sets, i->second.Misses);
+		break;
+
+	case vckNativeMethods:
+	case vckNativeClasses:
+	  {
+		bool byclass = kind == vckNativeClasses;
+		for(std::map<iTJSDispatch2 *, tTJSVMCounters::tNativeCounter>::iterator i =
+			counters->NativeMethods.begin(); i != counters->NativeMethods.end(); i++)
+			if(i->second.Calls)
+				add(byclass ? i->second.ClassName :
+					tTJSVMCounters::GetNativeName(i->second), i->second.Calls);
+		for(std::map<ttstr, tTJSVMCounters::tNativeCounter>::iterator i =
+			counters->RetiredNativeMethods.begin();
+			i != counters->RetiredNativeMethods.end(); i++)
+			add(byclass ? i->second.ClassName : i->first, i->second.Calls);
+		if(counters->UnknownNativeCalls)
+			add(TJS_W("(unknown)"), counters->UnknownNativeCalls);
+		break;
+	  }
+
+	default:
+		break;
+	}
+
+	out.reserve(sum.size());
+	for(std::map<ttstr, tTJSVMCounterEntry>::iterator i = sum.begin();
+		i != sum.end(); i++)
+	{
+		tTJSVMCounterEntry & e = i->second;
+		e.Count = kind == vckProperties ? e.Values[0] + e.Values[1] : e.Values[0];
+		out.push_back(e);
+	}
+	std::sort(out.begin(), out.end(), TJSVMCounterEntryGreater);
+}
+//---------------------------------------------------------------------------
+#endif // #ifdef TJS_VM_COUNTERS
+//---------------------------------------------------------------------------
+void TJSSetVMCountersEnabled(bool b)
+{
+#ifdef TJS_VM_COUNTERS
+	TJSVMCountersEnabled = b;
+#endif
+}
+//---------------------------------------------------------------------------
+bool TJSGetVMCountersEnabled()
+{
+#ifdef TJS_VM_COUNTERS
+	return TJSVMCountersEnabled;
+#else
+	return false;
+#endif
+}
+//---------------------------------------------------------------------------
+void TJSResetVMCounters()
+{
+#ifdef TJS_VM_COUNTERS
+	TJSVMGetCounters()->Reset();
+#endif
+}
+//---------------------------------------------------------------------------
+void TJSDumpVMCounters(iTJSConsoleOutput *output, tjs_int limit)
+{
+	// print top "limit" entries of each kind; all entries if limit <= 0
+	if(!output) return;
+#ifdef TJS_VM_COUNTERS
+	static const tjs_char * const titles[vckNumKinds] =
+	{
+		TJS_W("opcodes (count, %)"),
+		TJS_W("functions (ops, calls)"),
+		TJS_W("property lookups (gets, sets, misses)"),
+		TJS_W("native methods (calls)"),
+		TJS_W("native classes (calls)"),
+	};
+
+	tjs_uint64 totalops = 0;
+	for(tjs_int i = 0; i < __VM_LAST; i++) totalops += TJSVMOpcodeCounts[i];
+
+	output->Print(TJS_W("========== VM counters =========="));
+	std::vector<tTJSVMCounterEntry> entries;
+	for(tjs_int kind = 0; kind < vckNumKinds; kind++)
+	{
+		TJSVMGatherCounters((tTJSVMCounterKind)kind, entries);
+		output->Print((ttstr(TJS_W("---------- ")) + titles[kind]).c_str());
+
+		size_t count = entries.size();
+		if(limit > 0 && count > (size_t)limit) count = limit;
+		for(size_t i = 0; i < count; i++)
+		{
+			const tTJSVMCounterEntry & e = entries[i];
+			tjs_char buf[128];
+			switch(kind)
+			{
+			case vckOpcodes:
+				TJS_snprintf(buf, sizeof(buf)/sizeof(tjs_char),
+					TJS_W("%15llu %6.2f%% "), (unsigned long long)e.Values[0],
+					totalops ? (double)e.Values[0] * 100.0 / totalops : 0.0);
+				break;
+			case vckFunctions:
+				TJS_snprintf(buf, sizeof(buf)/sizeof(tjs_char),
+					TJS_W("%15llu %10llu "), (unsigned long long)e.Values[0],
+					(unsigned long long)e.Values[1]);
+				break;
+			case vckProperties:
+				TJS_snprintf(buf, sizeof(buf)/sizeof(tjs_char),
+					TJS_W("%12llu %12llu %12llu "), (unsigned long long)e.Values[0],
+					(unsigned long long)e.Values[1], (unsigned long long)e.Values[2]);
+				break;
+			default:
+				TJS_snprintf(buf, sizeof(buf)/sizeof(tjs_char),
+					TJS_W("%15llu "), (unsigned long long)e.Values[0]);
+				break;
+			}
+			output->Print((ttstr(buf) + e.Name).c_str());
+		}
+		if(count < entries.size())
+		{
+			tjs_char buf[64];
+			TJS_snprintf(buf, sizeof(buf)/sizeof(tjs_char),
+				TJS_W("(%d more)"), (int)(entries.size() - count));
+			output->Print(buf);
+		}
+	}
+	output->Print(TJS_W("================================="));
+#else
+	output->Print(TJS_W("VM counters are not available in this build"));
+#endif
+}
+//---------------------------------------------------------------------------
+iTJSDispatch2 * TJSGetVMCounters()
+{
+	// returns a dictionary of dictionaries; values are integers for opcodes
+	// and native calls, and arrays for functions [ops, calls] and for
+	// properties [gets, sets, misses]
+	iTJSDispatch2 *dic = TJSCreateDictionaryObject();
+#ifdef TJS_VM_COUNTERS
+	static const tjs_char * const names[vckNumKinds] =
+	{
+		TJS_W("opcodes"),
+		TJS_W("functions"),
+		TJS_W("properties"),
+		TJS_W("natives"),
+		TJS_W("nativeClasses"),
+	};
+
+	try
+	{
+		std::vector<tTJSVMCounterEntry> entries;
+		for(tjs_int kind = 0; kind < vckNumKinds; kind++)
+		{
+			TJSVMGatherCounters((tTJSVMCounterKind)kind, entries);
+
+			iTJSDispatch2 *sub = TJSCreateDictionaryObject();
+			try
+			{
+				tjs_int numvalues = kind == vckFunctions ? 2 :
+					kind == vckProperties ? 3 : 1;
+				for(std::vector<tTJSVMCounterEntry>::iterator i = entries.begin();
+					i != entries.end(); i++)
+				{
+					tTJSVariant val;
+					if(numvalues == 1)
+					{
+						val = (tjs_int64)i->Values[0];
+					}
+					else
+					{
+						iTJSDispatch2 *array = TJSCreateArrayObject();
+						try
+						{
+							for(tjs_int n = 0; n < numvalues; n++)
+							{
+								tTJSVariant v((tjs_int64)i->Values[n]);
+								array->PropSetByNum(TJS_MEMBERENSURE, n, &v, array);
+							}
+							val = tTJSVariant(array, array);
+						}
+						catch(...)
+						{
+							array->Release();
+							throw;
+						}
+						array->Release();
+					}
+					sub->PropSet(TJS_MEMBERENSURE, i->Name.c_str(), NULL, &val, sub);
+				}
+
+				tTJSVariant val(sub, sub);
+				dic->PropSet(TJS_MEMBERENSURE, names[kind], NULL, &val, dic);
+			}
+			catch(...)
+			{
+				sub->Release();
+				throw;
+			}
+			sub->Release();
+		}
+	}
+	catch(...)
+	{
+		dic->Release();
+		throw;
+	}
+#endif
+	return dic;
+}
+//---------------------------------------------------------------------------
+void TJSShutdownVMCounters()
+{
+#ifdef TJS_VM_COUNTERS
+	TJSVMCountersEnabled = false;
+	if(TJSVMCounters) delete TJSVMCounters, TJSVMCounters = NULL;
+#endif
+}
+//---------------------------------------------------------------------------
+
 #ifdef ENABLE_DEBUGGER
 
 class DebuggerMessage : public COPYDATASTRUCT
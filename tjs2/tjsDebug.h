@@ -112,9 +112,90 @@ extern void TJSReleaseStackTracer();
 extern void TJSStackTracerPush(tTJSInterCodeContext *context, bool in_try);
 extern void TJSStackTracerSetCodePointer(const tjs_int32 * codebase, tjs_int32 * const * codeptr);
 extern void TJSStackTracerPop();
+extern void TJSStackTracerLeaveCode();
+extern void TJSStackTracerEnterNative();
+extern void TJSStackTracerLeaveNative();
 extern ttstr TJSGetStackTraceString(tjs_int limit = 0, const tjs_char *delimiter = NULL);
 static inline bool TJSStackTracerEnabled() { return 0!=TJSStackTracer; }
 //---------------------------------------------------------------------------
+class tTJSStackTracerCodePointerHolder
+{
+	// sets the code pointer of the top frame, and fixes the last position
+	// when the VM code execution (which owns the code pointer) exits
+	bool Set;
+public:
+	tTJSStackTracerCodePointerHolder() : Set(false) {}
+	~tTJSStackTracerCodePointerHolder()
+		{ if(Set && TJSStackTracerEnabled()) TJSStackTracerLeaveCode(); }
+	void SetCodePointer(const tjs_int32 * codebase, tjs_int32 * const * codeptr)
+	{
+		if(!TJSStackTracerEnabled()) return;
+		TJSStackTracerSetCodePointer(codebase, codeptr);
+		Set = true;
+	}
+};
+//---------------------------------------------------------------------------
+class tTJSStackTracerNativeHolder
+{
+	// marks the top frame as running a native function, so that the
+	// profiler attributes the time until the native function returns (or
+	// calls back a script) to the "(native)" frame
+	bool Entered;
+public:
+	tTJSStackTracerNativeHolder() : Entered(TJSStackTracerEnabled())
+		{ if(Entered) TJSStackTracerEnterNative(); }
+	~tTJSStackTracerNativeHolder()
+		{ if(Entered && TJSStackTracerEnabled()) TJSStackTracerLeaveNative(); }
+};
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Profiler : sampling profiler for scripts
+//---------------------------------------------------------------------------
+extern volatile tjs_uint32 TJSProfilerTicks; // counted up by the sampling thread
+extern tjs_uint32 TJSProfilerTicksTaken; // ticks already attributed to samples
+extern void TJSStartProfiler(tjs_uint interval);
+extern void TJSStopProfiler();
+extern bool TJSIsProfilerRunning();
+extern void TJSClearProfile();
+extern void TJSShutdownProfiler();
+extern void TJSProfilerTakeSample(bool native);
+extern ttstr TJSGetProfileCollapsedStacks();
+extern ttstr TJSGetProfileChromeTrace();
+static inline void TJSProfilerSafePoint(bool native)
+	{ if(TJSProfilerTicks != TJSProfilerTicksTaken) TJSProfilerTakeSample(native); }
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// VMCounters : execution counters of the VM
+//---------------------------------------------------------------------------
+class iTJSConsoleOutput;
+#ifdef TJS_VM_COUNTERS
+struct tTJSVMFunctionCounter
+{
+	ttstr Name; // position description of the function
+	tjs_uint64 Calls;
+	tjs_uint64 Ops; // executed VM instructions
+	bool Orphan; // the function has been deleted
+};
+extern bool TJSVMCountersEnabled;
+extern tjs_uint64 TJSVMOpcodeCounts[];
+extern tTJSVMFunctionCounter * TJSVMCreateFunctionCounter(tTJSInterCodeContext *context);
+extern void TJSVMReleaseFunctionCounter(tTJSVMFunctionCounter *counter);
+extern void TJSVMCountPropertyAccess(const tjs_char *name, bool set, bool miss);
+extern void TJSVMRegisterNativeMethod(iTJSDispatch2 *method,
+	const tjs_char *classname, const tjs_char *name);
+extern void TJSVMUnregisterNativeMethod(iTJSDispatch2 *method);
+extern void TJSVMCountNativeCall(iTJSDispatch2 *method);
+#endif
+// following functions are available (and do nothing) without TJS_VM_COUNTERS
+extern void TJSSetVMCountersEnabled(bool b);
+extern bool TJSGetVMCountersEnabled();
+extern void TJSResetVMCounters();
+extern void TJSDumpVMCounters(iTJSConsoleOutput *output, tjs_int limit);
+extern iTJSDispatch2 * TJSGetVMCounters();
+extern void TJSShutdownVMCounters();
+//---------------------------------------------------------------------------
 
 #ifdef ENABLE_DEBUGGER
 extern void TJSDebuggerHook( tjs_int evtype, const tjs_char *filename, tjs_int lineno, tTJSInterCodeContext* ctx = NULL );
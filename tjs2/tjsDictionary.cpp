@@ -14,6 +14,7 @@
 #include "tjsDictionary.h"
 #include "tjsArray.h"
 #include "tjsBinarySerializer.h"
+#include "tjsBinaryLog.h"
 #include "tjsDebug.h"
 
 namespace TJS
@@ -79,10 +80,12 @@ TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/loadStruct)
 			if( streamlen >= tTJSBinarySerializer::HEADER_LENGTH ) {
 				tjs_uint8 header[tTJSBinarySerializer::HEADER_LENGTH];
 				stream->Read( header, tTJSBinarySerializer::HEADER_LENGTH );
-				if( tTJSBinarySerializer::IsBinary( header ) ) {
+				bool islog = tTJSBinaryLog::IsLog( header );
+				if( islog || tTJSBinarySerializer::IsBinary( header ) ) {
 					if( !dic ) dic = (tTJSDictionaryObject*)TJSCreateDictionaryObject();
 					tTJSBinarySerializer binload(dic);
-					tTJSVariant* var = binload.Read( stream );
+					tTJSVariant* var = islog ?
+						tTJSBinaryLog::Read( stream, binload ) : binload.Read( stream );
 					if( var ) {
 						if( result ) *result = *var;
 						delete var;
@@ -144,13 +147,20 @@ TJS_BEGIN_NATIVE_METHOD_DECL(/*func.name*/saveStruct)
 	ttstr mode;
 	if(numparams >= 2 && param[1]->Type() != tvtVoid) mode = *param[1];
 
-	if( TJS_strchr(mode.c_str(), TJS_W('b')) != NULL ) {
+	if( TJS_strchr(mode.c_str(), TJS_W('i')) != NULL ) {
+		// incremental binary; only the changed objects are appended
+		tTJSBinaryLog::Write(name, objthis);
+	} else if( TJS_strchr(mode.c_str(), TJS_W('b')) != NULL ) {
+		// 's' : v2 format with the shared string table
+		tTJSBinaryStringTable strings( TJS_strchr(mode.c_str(), TJS_W('s')) != NULL );
 		tTJSBinaryStream* stream = TJSCreateBinaryStreamForWrite(name, mode);
 		try {
-			stream->Write( tTJSBinarySerializer::HEADER, tTJSBinarySerializer::HEADER_LENGTH );
+			stream->Write( strings.GetEnabled() ?
+				tTJSBinarySerializer::HEADER_V2 : tTJSBinarySerializer::HEADER,
+				tTJSBinarySerializer::HEADER_LENGTH );
 			std::vector<iTJSDispatch2 *> stack;
 			stack.push_back(objthis);
-			ni->SaveStructuredBinary(stack, *stream);
+			ni->SaveStructuredBinary(stack, *stream, strings);
 		} catch(...) {
 			delete stream;
 			throw;
@@ -479,7 +489,8 @@ tjs_error TJS_INTF_METHOD tTJSDictionaryNI::tSaveStructCallback::FuncCall(
 	return TJS_S_OK;
 }
 //---------------------------------------------------------------------------
-void tTJSDictionaryNI::SaveStructuredBinary(std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream )
+void tTJSDictionaryNI::SaveStructuredBinary(std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream,
+	tTJSBinaryStringTable &strings )
 {
 	tSaveMemberCountCallback countCallback;
 	Owner->EnumMembers(TJS_IGNOREPROP, &tTJSVariantClosure(&countCallback, NULL), Owner);
@@ -490,6 +501,7 @@ void tTJSDictionaryNI::SaveStructuredBinary(std::vector<iTJSDispatch2 *> &stack,
 	tSaveStructBinayCallback callback;
 	callback.Stack = &stack;
 	callback.Stream = &stream;
+	callback.Strings = &strings;
 	Owner->EnumMembers(TJS_IGNOREPROP, &tTJSVariantClosure(&callback, NULL), Owner);
 }
 //---------------------------------------------------------------------------
@@ -508,15 +520,15 @@ tjs_error TJS_INTF_METHOD tTJSDictionaryNI::tSaveStructBinayCallback::FuncCall(
 		return TJS_S_OK;
 	}
 
-	tTJSBinarySerializer::PutString( Stream, param[0]->AsStringNoAddRef() );
+	Strings->PutString( Stream, param[0]->AsStringNoAddRef() );
 
 	tTJSVariantType type = param[2]->Type();
 	if( type == tvtObject ) {
 		// object
 		tTJSVariantClosure clo = param[2]->AsObjectClosureNoAddRef();
-		tTJSArrayNI::SaveStructuredBinaryForObject( clo.SelectObjectNoAddRef(), *Stack, *Stream );
+		tTJSArrayNI::SaveStructuredBinaryForObject( clo.SelectObjectNoAddRef(), *Stack, *Stream, *Strings );
 	} else {
-		tTJSBinarySerializer::PutVariant( Stream, *param[2] );
+		tTJSBinarySerializer::PutVariant( Stream, *param[2], Strings );
 	}
 
 	if(result) *result = (tjs_int)1;
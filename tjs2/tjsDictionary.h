@@ -86,7 +86,8 @@ private:
 public:
 	void SaveStructuredData(std::vector<iTJSDispatch2 *> &stack,
                                 iTJSTextWriteStream & stream, const ttstr&indentstr);
-	void SaveStructuredBinary(std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream );
+	void SaveStructuredBinary(std::vector<iTJSDispatch2 *> &stack, tTJSBinaryStream &stream,
+		tTJSBinaryStringTable &strings );
 		// method from tTJSSaveStructuredDataCallback
 private:
 	struct tSaveStructCallback : public tTJSDispatch
@@ -106,6 +107,7 @@ private:
 	struct tSaveStructBinayCallback : public tTJSDispatch {
 		std::vector<iTJSDispatch2 *> * Stack;
 		tTJSBinaryStream *Stream;
+		tTJSBinaryStringTable *Strings;
 
 		tjs_error TJS_INTF_METHOD
 		FuncCall(tjs_uint32 flag, const tjs_char * membername,
@@ -605,6 +605,8 @@ template <typename KeyT, typename ValueT, typename HashFuncT = tTJSHashFunc<KeyT
 class tTJSHashCache : public tTJSHashTable<KeyT, ValueT, HashFuncT, HashSize>
 {
 	typedef tTJSHashTable<KeyT, ValueT, HashFuncT, HashSize> inherited;
+	using inherited::GetCount;
+	using inherited::ChopLast;
 
 	tjs_uint MaxCount;
 
@@ -825,6 +825,10 @@ void tTJSInterCodeContext::ExecuteAsFunction(iTJSDispatch2 *objthis,
 */
 		if(TJSStackTracerEnabled()) TJSStackTracerPush(this, false);
 
+#ifdef TJS_VM_COUNTERS
+		if(TJSVMCountersEnabled) GetVMCounter()->Calls++;
+#endif
+
 		// check whether the objthis is deleting
 		if(TJSWarnOnExecutionOnDeletingObject && TJSObjectFlagEnabled() &&
 			Block->GetTJS()->GetConsoleOutput())
@@ -1021,11 +1025,12 @@ tjs_int tTJSInterCodeContext::ExecuteCode(tTJSVariant *ra_org, tjs_int startip,
 {
 	// execute VM codes
 	tjs_int32 *codesave;
+	tTJSStackTracerCodePointerHolder codeptrholder;
 	try
 	{
 		tjs_int32 *code = codesave = CodeArea + startip;
 
-		if(TJSStackTracerEnabled()) TJSStackTracerSetCodePointer(CodeArea, &codesave);
+		codeptrholder.SetCodePointer(CodeArea, &codesave);
 #ifdef ENABLE_DEBUGGER
 		bool is_enable_debugger = false;
 		if( TJSEnableDebugMode && ::IsDebuggerPresent() ) {
@@ -1041,8 +1046,19 @@ tjs_int tTJSInterCodeContext::ExecuteCode(tTJSVariant *ra_org, tjs_int startip,
 #ifdef ENABLE_DEBUGGER
 		tjs_int cur_line_no = -1;
 #endif	// ENABLE_DEBUGGER
+#ifdef TJS_VM_COUNTERS
+		tTJSVMFunctionCounter *vmcounter =
+			TJSVMCountersEnabled ? GetVMCounter() : NULL;
+#endif
 		while(true)
 		{
+#ifdef TJS_VM_COUNTERS
+			if(vmcounter)
+			{
+				if((tjs_uint32)*code < __VM_LAST) TJSVMOpcodeCounts[*code]++;
+				vmcounter->Ops++;
+			}
+#endif
 #ifdef ENABLE_DEBUGGER
 			if( is_enable_debugger ) {
 				tjs_int next_line_no = Block->SrcPosToLine( CodePosToSrcPos(code-CodeArea) );
@@ -1135,20 +1151,27 @@ tjs_int tTJSInterCodeContext::ExecuteCode(tTJSVariant *ra_org, tjs_int startip,
 
 			case VM_JF:
 				if(flag)
+				{
 					TJS_ADD_VM_CODE_ADDR(code, code[1]);
+					TJSProfilerSafePoint(false);
+				}
 				else
 					code += 2;
 				break;
 
 			case VM_JNF:
 				if(!flag)
+				{
 					TJS_ADD_VM_CODE_ADDR(code, code[1]);
+					TJSProfilerSafePoint(false);
+				}
 				else
 					code += 2;
 				break;
 
 			case VM_JMP:
 				TJS_ADD_VM_CODE_ADDR(code, code[1]);
+				TJSProfilerSafePoint(false);
 				break;
 
 			case VM_INC:
@@ -1324,15 +1347,21 @@ tjs_int tTJSInterCodeContext::ExecuteCode(tTJSVariant *ra_org, tjs_int startip,
 
 			case VM_CALL:
 			case VM_NEW:
+				// ticks still pending after the call were spent in a native
+				// function which does not mark the frame (e.g. in a plugin);
+				// script callees and marked native functions took theirs
 				code += CallFunction(ra, code, args, numargs);
+				TJSProfilerSafePoint(true);
 				break;
 
 			case VM_CALLD:
 				code += CallFunctionDirect(ra, code, args, numargs);
+				TJSProfilerSafePoint(true);
 				break;
 
 			case VM_CALLI:
 				code += CallFunctionIndirect(ra, code, args, numargs);
+				TJSProfilerSafePoint(true);
 				break;
 
 			case VM_GPD:
@@ -1617,6 +1646,10 @@ void tTJSInterCodeContext::GetPropertyDirect(tTJSVariant *ra,
 	hr = clo.PropGet(flags,
 		name->GetString(), name->GetHint(), TJS_GET_VM_REG_ADDR(ra, code[1]),
 			clo.ObjThis?clo.ObjThis:ra[-1].AsObjectNoAddRef());
+#ifdef TJS_VM_COUNTERS
+	if(TJSVMCountersEnabled)
+		TJSVMCountPropertyAccess(name->GetString(), false, TJS_FAILED(hr));
+#endif
 	if(TJS_FAILED(hr))
 		TJSThrowFrom_tjs_error(hr, TJS_GET_VM_REG(DataArea, code[3]).GetString());
 }
@@ -1651,6 +1684,10 @@ void tTJSInterCodeContext::SetPropertyDirect(tTJSVariant *ra,
 		hr = clo.PropSet(flags,
 			name->GetString(), name->GetHint(), TJS_GET_VM_REG_ADDR(ra, code[3]),
 				clo.ObjThis?clo.ObjThis:ra[-1].AsObjectNoAddRef());
+#ifdef TJS_VM_COUNTERS
+	if(TJSVMCountersEnabled)
+		TJSVMCountPropertyAccess(name->GetString(), true, TJS_FAILED(hr));
+#endif
 	if(TJS_FAILED(hr))
 		TJSThrowFrom_tjs_error(hr, TJS_GET_VM_REG(DataArea, code[2]).GetString());
 }
@@ -1712,6 +1749,10 @@ void tTJSInterCodeContext::GetPropertyIndirect(tTJSVariant *ra,
 			// TODO: verify here needs hint holding
 			hr = clo.PropGet(flags, *str, NULL, TJS_GET_VM_REG_ADDR(ra, code[1]),
 				clo.ObjThis?clo.ObjThis:ra[-1].AsObjectNoAddRef());
+#ifdef TJS_VM_COUNTERS
+			if(TJSVMCountersEnabled)
+				TJSVMCountPropertyAccess(*str, false, TJS_FAILED(hr));
+#endif
 			if(TJS_FAILED(hr)) TJSThrowFrom_tjs_error(hr, *str);
 		}
 		catch(...)
@@ -1775,6 +1816,10 @@ void tTJSInterCodeContext::SetPropertyIndirect(tTJSVariant *ra,
 				hr = clo.PropSet(flags,
 					*str, NULL, TJS_GET_VM_REG_ADDR(ra, code[3]),
 						clo.ObjThis?clo.ObjThis:ra[-1].AsObjectNoAddRef());
+#ifdef TJS_VM_COUNTERS
+			if(TJSVMCountersEnabled)
+				TJSVMCountPropertyAccess(*str, true, TJS_FAILED(hr));
+#endif
 			if(TJS_FAILED(hr)) TJSThrowFrom_tjs_error(hr, *str);
 		}
 		catch(...)
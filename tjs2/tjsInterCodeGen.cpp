@@ -237,6 +237,10 @@ tTJSInterCodeContext::tTJSInterCodeContext(tTJSInterCodeContext *parent,
 	if( Parent ) Parent->AddRef();
 #endif	// ENABLE_DEBUGGER
 
+#ifdef TJS_VM_COUNTERS
+	VMCounter = NULL;
+#endif
+
 	if(name)
 	{
 		Name = new tjs_char[TJS_strlen(name)+1];
@@ -358,6 +362,10 @@ tTJSInterCodeContext::tTJSInterCodeContext( tTJSScriptBlock *block, const tjs_ch
 	DebuggerRegisterArea = NULL;
 #endif	// ENABLE_DEBUGGER
 
+#ifdef TJS_VM_COUNTERS
+	VMCounter = NULL;
+#endif
+
 	if( name ) {
 		Name = new tjs_char[TJS_strlen(name)+1];
 		TJS_strcpy(Name, name);
@@ -379,6 +387,9 @@ tTJSInterCodeContext::~tTJSInterCodeContext()
 {
 	if(Name) delete [] Name;
 	Name = NULL;
+#ifdef TJS_VM_COUNTERS
+	if(VMCounter) TJSVMReleaseFunctionCounter(VMCounter);
+#endif
 }
 //---------------------------------------------------------------------------
 void tTJSInterCodeContext::Finalize(void)
@@ -1266,6 +1277,9 @@ tjs_int tTJSInterCodeContext::GenNodeCode(tjs_int & frame, tTJSExprNode *node,
 			OutputWarning(TJSSubstitutionInBooleanContext, node_pos);
 		}
 
+		if(GenAppendSubstitution(frame, node, restype, resaddr))
+			return resaddr;
+
 		resaddr = _GenNodeCode(frame, (*node)[1], TJS_RT_NEEDED, 0, param);
 
 		tSubParam param2;
@@ -2539,6 +2553,133 @@ tjs_int tTJSInterCodeContext::_GenNodeCode(tjs_int & frame, tTJSExprNode *node,
 	return res;
 }
 //---------------------------------------------------------------------------
+static bool TJSNodeRefersSymbol(tTJSExprNode *node, const tjs_char *name)
+{
+	// whether the node tree contains the symbol "name"
+	if(!node) return false;
+	if(node->GetOpecode() == T_SYMBOL)
+	{
+		tTJSVariantString *str = node->GetValue().AsStringNoAddRef();
+		if(str && !TJS_strcmp(*str, name)) return true;
+	}
+	tjs_int size = node->GetSize();
+	for(tjs_int i = 0; i < size; i++)
+		if(TJSNodeRefersSymbol((*node)[i], name)) return true;
+	return false;
+}
+//---------------------------------------------------------------------------
+static bool TJSIsStringConstNode(tTJSExprNode *node)
+{
+	return node->GetOpecode() == T_CONSTVAL &&
+		node->GetValue().Type() == tvtString;
+}
+//---------------------------------------------------------------------------
+bool tTJSInterCodeContext::GenAppendSubstitution(tjs_int & frame,
+	tTJSExprNode *node, tjs_uint32 restype, tjs_int & resaddr)
+{
+	// generate "v = v + e1 + e2 ..." (v is a local variable) as appending
+	// to v, instead of building the result from a copy of v, which makes
+	// the cost of repeated string concatenation quadratic.
+	// the result must be the same as the normal code, including the case
+	// where an exception occurs; so this is done only when:
+	//  - e1 .. en do not refer v (local variables can be modified only by
+	//    the function itself)
+	//  - n == 1,
+	//  - or e1 is a string constant; then v + (e1 + e2 ...) is the same
+	//    string, and v is modified only after all operands are evaluated,
+	//  - or e2 is a string constant and e3 .. en are constants or local
+	//    variables; no operand evaluation nor string concatenation can
+	//    throw after v is modified.
+	// "o.m = o.m + e" is not rewritten: o.m may be a property, whose getter
+	// and setter must be called in this order, and the operands may modify
+	// or replace o. write "o.m += e" instead; it already appends to the
+	// member in place (see tTJSCustomObject::Operation).
+	// returns false if the node is not applicable (no code is generated).
+	if(AsGlobalContextMode) return false;
+
+	tTJSExprNode *lhs = (*node)[0];
+	if(lhs->GetOpecode() != T_SYMBOL) return false;
+	tTJSVariantString *name = lhs->GetValue().AsStringNoAddRef();
+	if(!name) return false;
+	tjs_int n = Namespace.Find(*name);
+	if(n == -1) return false;
+
+	std::vector<tTJSExprNode *> operands; // e1 .. en
+	tTJSExprNode *p = (*node)[1];
+	while(p->GetOpecode() == T_PLUS)
+	{
+		operands.push_back((*p)[1]);
+		p = (*p)[0];
+	}
+	if(operands.empty()) return false;
+	if(p->GetOpecode() != T_SYMBOL) return false;
+	tTJSVariantString *leftname = p->GetValue().AsStringNoAddRef();
+	if(!leftname || TJS_strcmp(*leftname, *name)) return false;
+	std::reverse(operands.begin(), operands.end());
+
+	for(std::vector<tTJSExprNode *>::iterator i = operands.begin();
+		i != operands.end(); i++)
+		if(TJSNodeRefersSymbol(*i, *name)) return false;
+
+	bool chain = operands.size() == 1 || TJSIsStringConstNode(operands[0]);
+	if(!chain)
+	{
+		if(!TJSIsStringConstNode(operands[1])) return false;
+		for(std::vector<tTJSExprNode *>::size_type i = 2; i < operands.size(); i++)
+		{
+			tTJSExprNode *e = operands[i];
+			if(e->GetOpecode() == T_CONSTVAL) continue;
+			if(e->GetOpecode() != T_SYMBOL) return false;
+			tTJSVariantString *ename = e->GetValue().AsStringNoAddRef();
+			if(!ename || Namespace.Find(*ename) == -1) return false;
+		}
+	}
+
+	tjs_int node_pos = NODE_POS;
+	tjs_int var = -n-VariableReserveCount-1;
+	if(chain)
+	{
+		// var += (e1 + e2 + ...)
+		tjs_int resaddr1 = _GenNodeCode(frame, operands[0], TJS_RT_NEEDED, 0,
+			tSubParam());
+		if(operands.size() > 1 && !TJSIsFrame(resaddr1))
+		{
+			PutCode(VM_CP, node_pos);
+			PutCode(TJS_TO_VM_REG_ADDR(frame), node_pos);
+			PutCode(TJS_TO_VM_REG_ADDR(resaddr1), node_pos);
+			resaddr1 = frame;
+			frame++;
+		}
+		for(std::vector<tTJSExprNode *>::size_type i = 1; i < operands.size(); i++)
+		{
+			tjs_int resaddr2 = _GenNodeCode(frame, operands[i], TJS_RT_NEEDED, 0,
+				tSubParam());
+			PutCode(VM_ADD, node_pos);
+			PutCode(TJS_TO_VM_REG_ADDR(resaddr1), node_pos);
+			PutCode(TJS_TO_VM_REG_ADDR(resaddr2), node_pos);
+		}
+		PutCode(VM_ADD, node_pos);
+		PutCode(TJS_TO_VM_REG_ADDR(var), node_pos);
+		PutCode(TJS_TO_VM_REG_ADDR(resaddr1), node_pos);
+	}
+	else
+	{
+		// var += e1; var += e2; ...
+		for(std::vector<tTJSExprNode *>::iterator i = operands.begin();
+			i != operands.end(); i++)
+		{
+			tjs_int resaddr2 = _GenNodeCode(frame, *i, TJS_RT_NEEDED, 0,
+				tSubParam());
+			PutCode(VM_ADD, node_pos);
+			PutCode(TJS_TO_VM_REG_ADDR(var), node_pos);
+			PutCode(TJS_TO_VM_REG_ADDR(resaddr2), node_pos);
+		}
+	}
+
+	resaddr = (restype & TJS_RT_NEEDED) ? var : 0;
+	return true;
+}
+//---------------------------------------------------------------------------
 void tTJSInterCodeContext::StartFuncArg()
 {
 	// notify the start of function arguments
@@ -21,9 +21,9 @@
 #include "tjsError.h"
 #include "tjsObject.h"
 
-#ifdef ENABLE_DEBUGGER
+#if defined(ENABLE_DEBUGGER) || defined(TJS_VM_COUNTERS)
 #include "tjsDebug.h"
-#endif // ENABLE_DEBUGGER
+#endif
 
 
 namespace TJS
@@ -351,6 +351,15 @@ private:
 	tTJSVariant*	DebuggerRegisterArea;	//!< for exec
 #endif	// ENABLE_DEBUGGER
 
+#ifdef TJS_VM_COUNTERS
+	tTJSVMFunctionCounter * VMCounter; // created when first counted
+	tTJSVMFunctionCounter * GetVMCounter()
+	{
+		if(!VMCounter) VMCounter = TJSVMCreateFunctionCounter(this);
+		return VMCounter;
+	}
+#endif
+
 public:
 	tTJSContextType GetContextType() const { return ContextType; }
 	const tjs_char *GetContextTypeName() const;
@@ -386,6 +395,8 @@ private:
 		tjs_int reqresaddr, const tSubParam & param);
 	tjs_int GenNodeCode(tjs_int & frame, tTJSExprNode *node, tjs_uint32 restype,
 		tjs_int reqresaddr, const tSubParam & param);
+	bool GenAppendSubstitution(tjs_int & frame, tTJSExprNode *node,
+		tjs_uint32 restype, tjs_int & resaddr);
 
 	// restypes
 	#define TJS_RT_NEEDED 0x0001   // result needed
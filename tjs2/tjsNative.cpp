@@ -67,6 +67,9 @@ tTJSNativeClassMethod::tTJSNativeClassMethod(tTJSNativeClassMethodCallback proce
 tTJSNativeClassMethod::~tTJSNativeClassMethod()
 {
 	if(TJSObjectHashMapEnabled()) TJSRemoveObjectHashRecord(this);
+#ifdef TJS_VM_COUNTERS
+	TJSVMUnregisterNativeMethod(this);
+#endif
 }
 //---------------------------------------------------------------------------
 tjs_error TJS_INTF_METHOD
@@ -91,8 +94,13 @@ tjs_error TJS_INTF_METHOD
 		result, numparams, param, objthis);
 	if(!objthis) return TJS_E_NATIVECLASSCRASH;
 
+#ifdef TJS_VM_COUNTERS
+	if(TJSVMCountersEnabled) TJSVMCountNativeCall(this);
+#endif
+
 	if(result) result->Clear();
 	tjs_error er;
+	tTJSStackTracerNativeHolder nativeholder;
 	try
 	{
 		er = Process(result, numparams, param, objthis);
@@ -126,6 +134,7 @@ tjs_error  TJS_INTF_METHOD
 		result, numparams, param, objthis);
 	if(result) result->Clear();
 	tjs_error er;
+	tTJSStackTracerNativeHolder nativeholder;
 	try
 	{
 		er = Process(result, numparams, param, objthis);
@@ -187,6 +196,7 @@ tTJSNativeClassProperty::PropGet(tjs_uint32 flag, const tjs_char * membername,
 	if(!result) return TJS_E_FAIL;
 
 	tjs_error er;
+	tTJSStackTracerNativeHolder nativeholder;
 	try
 	{
 		er = Get(result, objthis);
@@ -210,6 +220,7 @@ tTJSNativeClassProperty::PropSet(tjs_uint32 flag, const tjs_char *membername,
 	if(!param) return TJS_E_FAIL;
 
 	tjs_error er;
+	tTJSStackTracerNativeHolder nativeholder;
 	try
 	{
 		er = Set(param, objthis);
@@ -276,6 +287,13 @@ void tTJSNativeClass::RegisterNCM(const tjs_char *name, iTJSDispatch2 *dsp,
 		}
 	}
 
+#ifdef TJS_VM_COUNTERS
+	// name the method for the VM counters; not while they are disabled,
+	// which would fill the map with every method of every class
+	if(type == nitMethod && TJSVMCountersEnabled)
+		TJSVMRegisterNativeMethod(dsp, classname, name);
+#endif
+
 	// add to this
 	tTJSVariant val;
 	val = dsp;
@@ -473,6 +491,7 @@ tjs_error TJS_INTF_METHOD tTJSNativeFunction::FuncCall(
 		return inherited::FuncCall(flag, membername, hint, result,
 			numparams, param, objthis);
 	}
+	tTJSStackTracerNativeHolder nativeholder;
 	return Process(result, numparams, param, objthis);
 }
 //---------------------------------------------------------------------------
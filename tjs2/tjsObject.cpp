@@ -16,6 +16,7 @@
 #include "tjsHashSearch.h"
 #include "tjsGlobalStringMap.h"
 #include "tjsDebug.h"
+#include "tjsCycleCollector.h"
 
 
 namespace TJS
@@ -390,6 +391,7 @@ void tTJSCustomObject::tTJSSymbolData::ReShare()
 tTJSCustomObject::tTJSCustomObject(tjs_int hashbits)
 {
 	if(TJSObjectHashMapEnabled()) TJSAddObjectHashRecord(this);
+	if(TJSCycleCollectorEnabled()) TJSAddCycleCollectorObject(this);
 	Count = 0;
 	RebuildHashMagic = TJSGlobalRebuildHashMagic;
 	if(hashbits > TJSObjectHashBitsLimit) hashbits = TJSObjectHashBitsLimit;
@@ -425,6 +427,7 @@ tTJSCustomObject::~tTJSCustomObject()
 	}
 	delete [] Symbols;
 	if(TJSObjectHashMapEnabled()) TJSRemoveObjectHashRecord(this);
+	if(TJSCycleCollectorEnabled()) TJSRemoveCycleCollectorObject(this);
 }
 //---------------------------------------------------------------------------
 void tTJSCustomObject::_Finalize(void)
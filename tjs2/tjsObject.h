@@ -391,6 +391,7 @@ extern tjs_int TJSObjectHashBitsLimit;
 class tTJSCustomObject : public tTJSDispatch
 {
 	typedef tTJSDispatch inherited;
+	friend class tTJSCycleCollector;
 
 	// tTJSSymbolData -----------------------------------------------------
 public:
@@ -13,6 +13,8 @@
 
 #include "tjsRegExp.h"
 #include "tjsArray.h"
+#include "tjsHashSearch.h"
+#include "tjsUtils.h"
 
 #include <functional>
 
@@ -66,6 +68,118 @@ static tjs_uint32 TJSGetRegExpFlagsFromString(const tjs_char *string)
 	return flag;
 }
 //---------------------------------------------------------------------------
+// regular expression cache
+//---------------------------------------------------------------------------
+#define TJS_REGEXP_CACHE_SIZE 128
+//---------------------------------------------------------------------------
+struct tTJSRegExpCacheKey
+{
+	ttstr Expr;
+	tjs_uint32 Options; // onig options; TJS flags are not included
+
+	bool operator ==(const tTJSRegExpCacheKey &rhs) const
+	{
+		return Options == rhs.Options && Expr == rhs.Expr;
+	}
+};
+//---------------------------------------------------------------------------
+class tTJSRegExpCacheHashFunc
+{
+public:
+	static tjs_uint32 Make(const tTJSRegExpCacheKey &val)
+	{
+		return tTJSHashFunc<ttstr>::Make(val.Expr) ^ val.Options;
+	}
+};
+//---------------------------------------------------------------------------
+typedef tTJSRefHolder<tTJSRegExpPattern> tTJSRegExpPatternHolder;
+typedef tTJSHashCache<tTJSRegExpCacheKey, tTJSRegExpPatternHolder,
+	tTJSRegExpCacheHashFunc> tTJSRegExpCache;
+static tTJSRegExpCache *TJSRegExpCache = NULL;
+//---------------------------------------------------------------------------
+static bool TJSIsLiteralRegExp(const ttstr &expr, tjs_uint32 options)
+{
+	// returns whether the expression matches only the string itself
+
+	if(expr.IsEmpty()) return false;
+	if(options & ONIG_OPTION_IGNORECASE) return false;
+
+	const tjs_char *p = expr.c_str();
+	while(*p)
+	{
+		if(TJS_strchr(TJS_W("\\^$.|?*+()[]{}"), *p)) return false;
+		if(*p >= 0xd800 && *p <= 0xdfff) return false; // surrogate
+		p++;
+	}
+	return true;
+}
+//---------------------------------------------------------------------------
+tTJSRegExpPattern * tTJSRegExpPattern::Compile(const ttstr &expr, tjs_uint32 flags)
+{
+	tTJSRegExpCacheKey key;
+	key.Expr = expr;
+	key.Options = flags&((ONIG_OPTION_MAXBIT<<1)-1);
+
+	if(!TJSRegExpCache) TJSRegExpCache = new tTJSRegExpCache(TJS_REGEXP_CACHE_SIZE);
+
+	tjs_uint32 hash = tTJSRegExpCacheHashFunc::Make(key);
+	tTJSRegExpPatternHolder *holder = TJSRegExpCache->FindAndTouchWithHash(key, hash);
+	if(holder) return holder->GetObject();
+
+	tTJSRegExpPattern *pattern = new tTJSRegExpPattern();
+	OnigErrorInfo einfo;
+	int r = onig_new( &(pattern->RegEx), (UChar*)expr.c_str(), (UChar*)(expr.c_str()+expr.length()),
+		key.Options, ONIG_ENCODING_UTF16_LE, ONIG_SYNTAX_PERL, &einfo );
+	if( r ) {
+		pattern->Release();
+		char s[ONIG_MAX_ERROR_MESSAGE_LEN];
+		onig_error_code_to_str( (UChar* )s, r, &einfo );
+		TJS_eTJSError( s );
+	}
+	if(TJSIsLiteralRegExp(expr, key.Options)) pattern->Literal = expr;
+
+	TJSRegExpCache->AddWithHash(key, hash, tTJSRegExpPatternHolder(pattern));
+	return pattern; // the reference from new is given to the caller
+}
+//---------------------------------------------------------------------------
+int tTJSRegExpPattern::Search(const tjs_char *str, const tjs_char *end, OnigRegion* region) const
+{
+	if(Literal.IsEmpty())
+		return onig_search( RegEx, (UChar*)str, (UChar*)end, (UChar*)str, (UChar*)end, region, ONIG_OPTION_NONE );
+
+	// plain string; find the first character then compare the rest
+	const tjs_char *lit = Literal.c_str();
+	tjs_int len = Literal.GetLen();
+	if(end - str < len) return ONIG_MISMATCH;
+	const tjs_char *last = end - len;
+	tjs_char first = lit[0];
+	for(const tjs_char *p = str; p <= last; p++)
+	{
+		if(*p != first) continue;
+		if(len == 1 || !memcmp(p + 1, lit + 1, (len - 1) * sizeof(tjs_char)))
+		{
+			if(onig_region_resize(region, 1)) return ONIGERR_MEMORY;
+			region->beg[0] = (int)((p - str) * sizeof(tjs_char));
+			region->end[0] = region->beg[0] + (int)(len * sizeof(tjs_char));
+			return region->beg[0];
+		}
+	}
+	return ONIG_MISMATCH;
+}
+//---------------------------------------------------------------------------
+class tTJSRegExpRegionHolder
+{
+	tTJSNI_RegExp *Owner;
+	OnigRegion *Region;
+
+public:
+	tTJSRegExpRegionHolder(tTJSNI_RegExp *owner) : Owner(owner)
+		{ Region = owner->AcquireRegion(); }
+	~tTJSRegExpRegionHolder() { Owner->ReleaseRegion(Region); }
+
+	OnigRegion * Get() const { return Region; }
+};
+//---------------------------------------------------------------------------
 void replace_regex( tTJSVariant **param, tjs_int numparams, tTJSNI_RegExp *_this, iTJSDispatch2 *objthis, ttstr &res ) {
 	ttstr to;
 	tTJSVariantClosure funcval;
@@ -84,10 +198,11 @@ void replace_regex( tTJSVariant **param, tjs_int numparams, tTJSNI_RegExp *_this
 	}
 	// grep thru target string
 	bool isreplaceall = (_this->Flags & globalsearch) != 0;
-	OnigRegion* region = onig_region_new();
+	tTJSRegExpRegionHolder holder(_this);
+	OnigRegion* region = holder.Get();
 	const tjs_char* s = target.c_str();
 	const tjs_char* send = s + target.GetLen();
-	int r = onig_search( _this->RegEx, (UChar*)s, (UChar*)send, (UChar*)s, (UChar*)send, region, ONIG_OPTION_NONE );
+	int r = _this->Pattern->Search( s, send, region );
 	int offset = 0;
 	if( r >= 0 ) { // match
 		do {
@@ -107,31 +222,27 @@ void replace_regex( tTJSVariant **param, tjs_int numparams, tTJSNI_RegExp *_this
 				tTJSVariant *param = &arrayval;
 				array->Release();
 				hr = funcval.FuncCall(0, NULL, NULL, &result, 1, &param, NULL);
-				if( TJS_FAILED(hr) ) {
-					onig_region_free( region, 1  );
-					return;
-				}
+				if( TJS_FAILED(hr) ) return;
 				result.ToString();
 				res += result.GetString();
 			}
 			s += end;
-			onig_region_free( region, 0  );
-		} while( isreplaceall && s < send && onig_search( _this->RegEx, (UChar*)s, (UChar*)send, (UChar*)s, (UChar*)send, region, ONIG_OPTION_NONE ) >= 0 );
+		} while( isreplaceall && s < send && _this->Pattern->Search( s, send, region ) >= 0 );
 		if( s < send ) {
 			res += ttstr(s,(int)(send-s));
 		}
 	} else {
 		res += ttstr(s,(int)(send-s));
 	}
-	onig_region_free( region, 1  );
 }
 //---------------------------------------------------------------------------
 iTJSDispatch2* split_regex( const ttstr &target, iTJSDispatch2 * array, tTJSNI_RegExp *_this, bool purgeempty ) {
 	tjs_uint targlen = target.GetLen();
-	OnigRegion* region = onig_region_new();
+	tTJSRegExpRegionHolder holder(_this);
+	OnigRegion* region = holder.Get();
 	const tjs_char* s = target.c_str();
 	const tjs_char* send = s + targlen;
-	int r = onig_search( _this->RegEx, (UChar*)s, (UChar*)send, (UChar*)s, (UChar*)send, region, ONIG_OPTION_NONE );
+	int r = _this->Pattern->Search( s, send, region );
 	int storecount = 0;
 	if( r >= 0 ) { // match
 		do {
@@ -141,8 +252,7 @@ iTJSDispatch2* split_regex( const ttstr &target, iTJSDispatch2 * array, tTJSNI_R
 				array->PropSetByNum(TJS_MEMBERENSURE, storecount++, &val, array);
 			}
 			s += region->end[0] / sizeof(tjs_char);
-			onig_region_clear( region );
-		} while( onig_search( _this->RegEx, (UChar*)s, (UChar*)send, (UChar*)s, (UChar*)send, region, ONIG_OPTION_NONE ) >= 0 );
+		} while( _this->Pattern->Search( s, send, region ) >= 0 );
 		if( !purgeempty || s < send ) {
 			tTJSVariant val = ttstr( s, (int)(send-s) );
 			array->PropSetByNum(TJS_MEMBERENSURE, storecount++, &val, array);
@@ -151,13 +261,12 @@ iTJSDispatch2* split_regex( const ttstr &target, iTJSDispatch2 * array, tTJSNI_R
 		tTJSVariant val = ttstr( s, (int)(send-s) );
 		array->PropSetByNum(TJS_MEMBERENSURE, storecount++, &val, array);
 	}
-	onig_region_clear( region );
-	onig_region_free( region, 1  );
 	return array;
 }
 //---------------------------------------------------------------------------
 void TJSReleaseRegex()
 {
+	if(TJSRegExpCache) delete TJSRegExpCache, TJSRegExpCache = NULL;
 	onig_end();
 }
 //---------------------------------------------------------------------------
@@ -165,7 +274,7 @@ void TJSReleaseRegex()
 //---------------------------------------------------------------------------
 // tTJSNI_RegExp : TJS Native Instance : RegExp
 //---------------------------------------------------------------------------
-tTJSNI_RegExp::tTJSNI_RegExp() : RegEx(NULL)
+tTJSNI_RegExp::tTJSNI_RegExp() : Pattern(NULL), Region(NULL), RegionInUse(false)
 {
 	// C++constructor
 	Flags = TJSRegExpFlagToValue(0, 0);
@@ -175,9 +284,13 @@ tTJSNI_RegExp::tTJSNI_RegExp() : RegEx(NULL)
 }
 //---------------------------------------------------------------------------
 tTJSNI_RegExp::~tTJSNI_RegExp() {
-	if( RegEx ) {
-		onig_free(RegEx);
-		RegEx = NULL;
+	if( Pattern ) {
+		Pattern->Release();
+		Pattern = NULL;
+	}
+	if( Region ) {
+		onig_region_free( Region, 1 );
+		Region = NULL;
 	}
 }
 //---------------------------------------------------------------------------
@@ -194,6 +307,24 @@ void tTJSNI_RegExp::Split(iTJSDispatch2 ** array, const ttstr &target, bool purg
 	}
 }
 //---------------------------------------------------------------------------
+OnigRegion* tTJSNI_RegExp::AcquireRegion()
+{
+	if( RegionInUse ) return onig_region_new();
+	if( !Region ) Region = onig_region_new();
+	RegionInUse = true;
+	return Region;
+}
+//---------------------------------------------------------------------------
+void tTJSNI_RegExp::ReleaseRegion(OnigRegion* region)
+{
+	if( region == Region ) {
+		onig_region_clear( Region );
+		RegionInUse = false;
+	} else {
+		onig_region_free( region, 1 );
+	}
+}
+//---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
 // tTJSNC_RegExp : TJS Native Class : RegExp
@@ -272,18 +403,10 @@ TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/_compile)
 
 	try
 	{
-		if( _this->RegEx ) {
-			onig_free( _this->RegEx );
-			_this->RegEx = NULL;
-		}
-		OnigErrorInfo einfo;
-		int r = onig_new( &(_this->RegEx), (UChar*)exprstart, (UChar*)(expr.c_str()+expr.length()),
-			flags&((ONIG_OPTION_MAXBIT<<1)-1), ONIG_ENCODING_UTF16_LE, ONIG_SYNTAX_PERL, &einfo );
-		if( r ) {
-			char s[ONIG_MAX_ERROR_MESSAGE_LEN];
-			onig_error_code_to_str( (UChar* )s, r, &einfo );
-			TJS_eTJSError( s );
-		}
+		tTJSRegExpPattern *pattern = tTJSRegExpPattern::Compile(
+			ttstr(exprstart, (int)(expr.c_str()+expr.length()-exprstart)), flags );
+		if( _this->Pattern ) _this->Pattern->Release();
+		_this->Pattern = pattern;
 	}
 	catch(std::exception &e)
 	{
@@ -309,9 +432,8 @@ TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/test)
 	if(numparams < 1) return TJS_E_BADPARAMCOUNT;
 
 	ttstr target(*param[0]);
-	OnigRegion* region = onig_region_new();
-	bool matched = tTJSNC_RegExp::Exec( region, target, _this );
-	onig_region_free(region, 1  );
+	tTJSRegExpRegionHolder holder(_this);
+	bool matched = tTJSNC_RegExp::Exec( holder.Get(), target, _this );
 
 	tTJSNC_RegExp::LastRegExp = tTJSVariant(objthis, objthis);
 
@@ -342,10 +464,9 @@ TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/match)
 	if(result)
 	{
 		ttstr target(*param[0]);
-		OnigRegion* region = onig_region_new();
-		bool matched = tTJSNC_RegExp::Match( region, target, _this );
-		iTJSDispatch2 *array = tTJSNC_RegExp::GetResultArray(matched, target, _this, region);
-		onig_region_free(region, 1  );
+		tTJSRegExpRegionHolder holder(_this);
+		bool matched = tTJSNC_RegExp::Match( holder.Get(), target, _this );
+		iTJSDispatch2 *array = tTJSNC_RegExp::GetResultArray(matched, target, _this, holder.Get());
 		*result = tTJSVariant(array, array);
 		array->Release();
 	}
@@ -371,9 +492,10 @@ TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/exec)
 	if(numparams < 1) return TJS_E_BADPARAMCOUNT;
 
 	ttstr target(*param[0]);
-	OnigRegion* region = onig_region_new();
-	tTJSNC_RegExp::Exec(region, target, _this);
-	onig_region_free(region, 1  );
+	{
+		tTJSRegExpRegionHolder holder(_this);
+		tTJSNC_RegExp::Exec(holder.Get(), target, _this);
+	}
 
 	tTJSNC_RegExp::LastRegExp = tTJSVariant(objthis, objthis);
 
@@ -624,18 +746,9 @@ void tTJSNC_RegExp::Compile(tjs_int numparams, tTJSVariant **param, tTJSNI_RegEx
 
 	if(expr.IsEmpty()) expr = TJS_W("(?:)"); // generate empty regular expression
 
-	if( _this->RegEx ) {
-		onig_free( _this->RegEx );
-		_this->RegEx = NULL;
-	}
-	OnigErrorInfo einfo;
-	int r = onig_new( &(_this->RegEx), (UChar*)expr.c_str(), (UChar*)(expr.c_str()+expr.length()),
-		flags&((ONIG_OPTION_MAXBIT<<1)-1), ONIG_ENCODING_UTF16_LE, ONIG_SYNTAX_PERL, &einfo );
-	if( r ) {
-		char s[ONIG_MAX_ERROR_MESSAGE_LEN];
-		onig_error_code_to_str( (UChar* )s, r, &einfo );
-		TJS_eTJSError( s );
-	}
+	tTJSRegExpPattern *pattern = tTJSRegExpPattern::Compile(expr, flags);
+	if( _this->Pattern ) _this->Pattern->Release();
+	_this->Pattern = pattern;
 	_this->Flags = flags;
 }
 //---------------------------------------------------------------------------
@@ -651,9 +764,7 @@ bool tTJSNC_RegExp::Match(OnigRegion* region, const ttstr &target, tTJSNI_RegExp
 		return false;
 	}
 	searchstart = _this->Start;
-	int r = onig_search( _this->RegEx, (UChar* )(target.c_str()+searchstart), (UChar* )(target.c_str()+targlen),
-		  (UChar* )(target.c_str()+searchstart), (UChar* )(target.c_str()+targlen),
-		  region, ONIG_OPTION_NONE );
+	int r = _this->Pattern->Search( target.c_str()+searchstart, target.c_str()+targlen, region );
 	return r >= 0;
 }
 //---------------------------------------------------------------------------
@@ -19,14 +19,47 @@
 namespace TJS
 {
 
+//---------------------------------------------------------------------------
+// tTJSRegExpPattern : compiled regular expression
+//---------------------------------------------------------------------------
+/*
+	patterns are shared by RegExp objects through the cache, so the same
+	expression is compiled only once even if it is constructed in a loop.
+*/
+class tTJSRegExpPattern
+{
+	tjs_int RefCount;
+
+public:
+	regex_t* RegEx;
+	ttstr Literal; // not empty if the expression is a plain string
+
+	tTJSRegExpPattern() : RefCount(1), RegEx(NULL) {}
+	~tTJSRegExpPattern() { if( RegEx ) onig_free( RegEx ); }
+
+	void AddRef() { RefCount++; }
+	void Release() { if(RefCount == 1) delete this; else RefCount--; }
+
+	static tTJSRegExpPattern * Compile(const ttstr &expr, tjs_uint32 flags);
+		// returns the pattern with a new reference. raises an exception
+		// if the expression is invalid.
+
+	int Search(const tjs_char *str, const tjs_char *end, OnigRegion* region) const;
+		// same as onig_search from str to end. plain string expressions
+		// are searched without the regex engine.
+};
+//---------------------------------------------------------------------------
+
+
 //---------------------------------------------------------------------------
 // tTJSNI_RegExp
 //---------------------------------------------------------------------------
 class tTJSNI_RegExp : public tTJSNativeInstance
 {
 public:
-	regex_t* RegEx;
-	//OnigRegion* Region;
+	tTJSRegExpPattern* Pattern;
+	OnigRegion* Region; // reused by searches
+	bool RegionInUse;
 	tjs_uint32 Flags;
 	tjs_uint Start;
 	tTJSVariant Array;
@@ -43,6 +76,11 @@ public:
 	tTJSNI_RegExp();
 	~tTJSNI_RegExp();
 	void Split(iTJSDispatch2 ** array, const ttstr &target, bool purgeempty);
+
+	OnigRegion* AcquireRegion();
+	void ReleaseRegion(OnigRegion* region);
+		// Region is used if it is not in use (replace's callback function
+		// may use the same object recursively), otherwise a new region.
 };
 //---------------------------------------------------------------------------
 
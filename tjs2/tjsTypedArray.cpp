@@ -0,0 +1,1065 @@
+//---------------------------------------------------------------------------
+/*
+	TJS2 Script Engine
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Typed array classes ( Int8Array, Uint8Array, ... Float64Array )
+//---------------------------------------------------------------------------
+
+
+#include "tjsCommHead.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include "tjsTypedArray.h"
+#include "tjsArray.h"
+#include "tjsError.h"
+
+#define TJS_TYPEDARRAY_BASE_HASH_BITS 3
+	/* hash bits for base "Object" hash */
+
+
+namespace TJS
+{
+//---------------------------------------------------------------------------
+// element type helpers
+//---------------------------------------------------------------------------
+enum tTJSUint8Clamped : tjs_uint8 {};
+	// the element of Uint8ClampedArray; a distinct type, so that the
+	// templates below can tell it from tjs_uint8
+//---------------------------------------------------------------------------
+template <typename T> struct tTJSTypedArrayElement
+{
+	// integer elements are converted through 64bit integer, so that reals
+	// are truncated and integers wrap around as C casts do
+	enum { IsFloat = 0, IsClamped = 0 };
+	static T FromInteger(tjs_int64 v) { return (T)v; }
+	static T FromReal(tTVReal v) { return (T)(tjs_int64)v; }
+};
+template <typename T> struct tTJSTypedArrayFloatElement
+{
+	enum { IsFloat = 1, IsClamped = 0 };
+	static T FromInteger(tjs_int64 v) { return (T)v; }
+	static T FromReal(tTVReal v) { return (T)v; }
+};
+template <> struct tTJSTypedArrayElement<float> :
+	tTJSTypedArrayFloatElement<float> {};
+template <> struct tTJSTypedArrayElement<double> :
+	tTJSTypedArrayFloatElement<double> {};
+template <> struct tTJSTypedArrayElement<tTJSUint8Clamped>
+{
+	enum { IsFloat = 0, IsClamped = 1 };
+	static tTJSUint8Clamped FromInteger(tjs_int64 v)
+	{
+		return (tTJSUint8Clamped)(v < 0 ? 0 : v > 255 ? 255 : v);
+	}
+	static tTJSUint8Clamped FromReal(tTVReal v)
+	{
+		// rounds to the nearest, and to even on ties. NaN is 0.
+		if(!(v > 0)) return (tTJSUint8Clamped)0;
+		if(v >= 255) return (tTJSUint8Clamped)255;
+		tjs_int i = (tjs_int)v;
+		tTVReal frac = v - i;
+		if(frac > 0.5 || (frac == 0.5 && (i & 1))) i++;
+		return (tTJSUint8Clamped)i;
+	}
+};
+//---------------------------------------------------------------------------
+template <typename D, typename S>
+static inline D TJSTypedArrayConvert(S s)
+{
+	if(tTJSTypedArrayElement<S>::IsFloat)
+		return tTJSTypedArrayElement<D>::FromReal((tTVReal)s);
+	return tTJSTypedArrayElement<D>::FromInteger((tjs_int64)s);
+}
+//---------------------------------------------------------------------------
+template <typename T>
+static inline T TJSTypedArrayFromVariant(const tTJSVariant &v)
+{
+	// Uint8ClampedArray rounds anything but integers as reals
+	typedef tTJSTypedArrayElement<T> E;
+	if(E::IsFloat || (E::IsClamped && v.Type() != tvtInteger))
+		return E::FromReal(v.AsReal());
+	return E::FromInteger(v.AsInteger());
+}
+//---------------------------------------------------------------------------
+template <typename T>
+static inline void TJSTypedArrayToVariant(T v, tTJSVariant &dest)
+{
+	if(tTJSTypedArrayElement<T>::IsFloat)
+		dest = (tTVReal)v;
+	else
+		dest = (tTVInteger)v;
+}
+//---------------------------------------------------------------------------
+// TJS_TYPEDARRAY_DISPATCH calls func<T> args, where T is the C type of
+// the elements of "type"
+#define TJS_TYPEDARRAY_DISPATCH(type, func, args) \
+	switch(type) \
+	{ \
+	case tatInt8:		func<tjs_int8> args; break; \
+	case tatUint8:		func<tjs_uint8> args; break; \
+	case tatUint8Clamped: func<tTJSUint8Clamped> args; break; \
+	case tatInt16:		func<tjs_int16> args; break; \
+	case tatUint16:		func<tjs_uint16> args; break; \
+	case tatInt32:		func<tjs_int32> args; break; \
+	case tatUint32:		func<tjs_uint32> args; break; \
+	case tatFloat32:	func<float> args; break; \
+	case tatFloat64:	func<double> args; break; \
+	default:			break; \
+	}
+//---------------------------------------------------------------------------
+template <typename T>
+static void TJSTypedArrayGet(const void *data, tjs_int index, tTJSVariant &dest)
+{
+	TJSTypedArrayToVariant(((const T*)data)[index], dest);
+}
+//---------------------------------------------------------------------------
+template <typename T>
+static void TJSTypedArraySet(void *data, tjs_int index, const tTJSVariant &value)
+{
+	((T*)data)[index] = TJSTypedArrayFromVariant<T>(value);
+}
+//---------------------------------------------------------------------------
+template <typename T>
+static void TJSTypedArrayFill(void *data, tjs_int start, tjs_int count,
+	const tTJSVariant &value)
+{
+	T v = TJSTypedArrayFromVariant<T>(value);
+	std::fill((T*)data + start, (T*)data + start + count, v);
+}
+//---------------------------------------------------------------------------
+template <typename D, typename S>
+static void TJSTypedArrayConvertElements(D *dest, const void *src,
+	tjs_int count)
+{
+	const S *s = (const S *)src;
+	for(tjs_int i = 0; i < count; i++)
+		dest[i] = TJSTypedArrayConvert<D>(s[i]);
+}
+//---------------------------------------------------------------------------
+template <typename D>
+static void TJSTypedArrayConvertFrom(void *dest, const void *src,
+	tTJSTypedArrayType srctype, tjs_int count)
+{
+	D *d = (D*)dest;
+	switch(srctype)
+	{
+	case tatInt8:
+		TJSTypedArrayConvertElements<D, tjs_int8>(d, src, count); break;
+	case tatUint8:
+		TJSTypedArrayConvertElements<D, tjs_uint8>(d, src, count); break;
+	case tatUint8Clamped:
+		TJSTypedArrayConvertElements<D, tTJSUint8Clamped>(d, src, count);
+		break;
+	case tatInt16:
+		TJSTypedArrayConvertElements<D, tjs_int16>(d, src, count); break;
+	case tatUint16:
+		TJSTypedArrayConvertElements<D, tjs_uint16>(d, src, count); break;
+	case tatInt32:
+		TJSTypedArrayConvertElements<D, tjs_int32>(d, src, count); break;
+	case tatUint32:
+		TJSTypedArrayConvertElements<D, tjs_uint32>(d, src, count); break;
+	case tatFloat32:
+		TJSTypedArrayConvertElements<D, float>(d, src, count); break;
+	case tatFloat64:
+		TJSTypedArrayConvertElements<D, double>(d, src, count); break;
+	default:
+		break;
+	}
+}
+//---------------------------------------------------------------------------
+template <typename T>
+static void TJSTypedArrayAssignVariants(void *dest, const tTJSVariant *src,
+	tjs_int count)
+{
+	T *d = (T*)dest;
+	for(tjs_int i = 0; i < count; i++)
+		d[i] = TJSTypedArrayFromVariant<T>(src[i]);
+}
+//---------------------------------------------------------------------------
+template <typename T>
+static bool TJSTypedArrayIsNotNaN(T v) { return v == v; }
+//---------------------------------------------------------------------------
+template <typename T>
+static void TJSTypedArraySort(void *data, tjs_int count, bool descending)
+{
+	T *begin = (T*)data;
+	T *end = begin + count;
+
+	// NaNs break strict weak ordering; move them to the tail and leave them
+	if(tTJSTypedArrayElement<T>::IsFloat)
+		end = std::partition(begin, end, TJSTypedArrayIsNotNaN<T>);
+
+	if(descending)
+		std::sort(begin, end, std::greater<T>());
+	else
+		std::sort(begin, end);
+}
+//---------------------------------------------------------------------------
+template <typename T>
+static void TJSTypedArraySum(const void *data, tjs_int start, tjs_int count,
+	tTJSVariant &dest)
+{
+	const T *p = (const T*)data + start;
+	if(tTJSTypedArrayElement<T>::IsFloat)
+	{
+		tTVReal sum = 0;
+		for(tjs_int i = 0; i < count; i++) sum += p[i];
+		dest = sum;
+	}
+	else
+	{
+		tTVInteger sum = 0;
+		for(tjs_int i = 0; i < count; i++) sum += (tTVInteger)p[i];
+		dest = sum;
+	}
+}
+//---------------------------------------------------------------------------
+template <typename T>
+static void TJSTypedArrayFind(const void *data, tjs_int start, tjs_int count,
+	const tTJSVariant &value, tjs_int &result)
+{
+	result = -1;
+	tTVReal r = value.AsReal();
+	if(r != r) return; // NaN never matches
+	T v = TJSTypedArrayConvert<T>(r);
+	if(!tTJSTypedArrayElement<T>::IsFloat && (tTVReal)v != r)
+		return; // not representable as an element
+	const T *p = (const T*)data;
+	const T *f = std::find(p + start, p + start + count, v);
+	if(f != p + start + count) result = (tjs_int)(f - p);
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// buffer sources
+//---------------------------------------------------------------------------
+static std::vector<iTJSTypedArrayBufferSource *> TJSTypedArrayBufferSources;
+//---------------------------------------------------------------------------
+void TJSAddTypedArrayBufferSource(iTJSTypedArrayBufferSource *source)
+{
+	std::vector<iTJSTypedArrayBufferSource *> &sources =
+		TJSTypedArrayBufferSources;
+	if(std::find(sources.begin(), sources.end(), source) == sources.end())
+		sources.push_back(source);
+}
+//---------------------------------------------------------------------------
+void TJSRemoveTypedArrayBufferSource(iTJSTypedArrayBufferSource *source)
+{
+	std::vector<iTJSTypedArrayBufferSource *> &sources =
+		TJSTypedArrayBufferSources;
+	std::vector<iTJSTypedArrayBufferSource *>::iterator i =
+		std::find(sources.begin(), sources.end(), source);
+	if(i != sources.end()) sources.erase(i);
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// tTJSTypedArrayNI
+//---------------------------------------------------------------------------
+tTJSTypedArrayNI::tTJSTypedArrayNI(tTJSTypedArrayType type)
+{
+	Type = type;
+	Data = NULL;
+	Length = 0;
+	Target = NULL;
+	TargetRow = 0;
+	TargetStart = 0;
+}
+//---------------------------------------------------------------------------
+tTJSTypedArrayNI::~tTJSTypedArrayNI()
+{
+	if(Target) Target->Release();
+	delete [] Data;
+}
+//---------------------------------------------------------------------------
+tjs_int tTJSTypedArrayNI::GetElementSize(tTJSTypedArrayType type)
+{
+	switch(type)
+	{
+	case tatInt8:
+	case tatUint8:
+	case tatUint8Clamped:	return 1;
+	case tatInt16:
+	case tatUint16:		return 2;
+	case tatInt32:
+	case tatUint32:
+	case tatFloat32:	return 4;
+	case tatFloat64:	return 8;
+	default:			return 1;
+	}
+}
+//---------------------------------------------------------------------------
+tjs_error TJS_INTF_METHOD
+	tTJSTypedArrayNI::Construct(tjs_int numparams, tTJSVariant **param,
+		iTJSDispatch2 *tjsobj)
+{
+	// new XxxArray(count) creates zero-filled array.
+	// new XxxArray(array or typed array) copies the elements with conversion.
+	// new XxxArray(octet) copies the octet as binary image of the elements.
+	if(numparams >= 1 && param[0]->Type() != tvtVoid)
+	{
+		if(param[0]->Type() == tvtObject || param[0]->Type() == tvtOctet)
+			Assign(*param[0]);
+		else
+			SetLength((tjs_int)*param[0]);
+	}
+
+	return TJS_S_OK;
+}
+//---------------------------------------------------------------------------
+void TJS_INTF_METHOD tTJSTypedArrayNI::Invalidate()
+{
+	Detach();
+	if(Data) delete [] Data, Data = NULL;
+	Length = 0;
+	inherited::Invalidate();
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::SetLength(tjs_int length)
+{
+	if(Target) TJS_eTJSError(TJSAccessDenyed);
+	if(length < 0 || length > 0x7fffffff / 8) TJS_eTJSError(TJSRangeError);
+	if(length == Length) return;
+
+	tjs_int elmsize = GetElementSize();
+	tjs_uint8 * newdata = NULL;
+	if(length)
+	{
+		newdata = new tjs_uint8[length * elmsize];
+		tjs_int keep = std::min(length, Length);
+		if(keep) memcpy(newdata, Data, keep * elmsize);
+		memset(newdata + keep * elmsize, 0, (length - keep) * elmsize);
+	}
+	delete [] Data;
+	Data = newdata;
+	Length = length;
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::GetTargetBuffer(iTJSDispatch2 *target, bool forwrite,
+	tTJSTypedArrayBuffer &buffer)
+{
+	// a typed array is a buffer of one row
+	tTJSTypedArrayNI *ta = FromObject(target);
+	if(ta)
+	{
+		buffer.Data = ta->GetElements(forwrite);
+		buffer.RowBytes = ta->Length * ta->GetElementSize();
+		buffer.Pitch = buffer.RowBytes;
+		buffer.Rows = 1;
+		return;
+	}
+
+	std::vector<iTJSTypedArrayBufferSource *> &sources =
+		TJSTypedArrayBufferSources;
+	for(tjs_uint i = 0; i < sources.size(); i++)
+	{
+		if(sources[i]->GetBuffer(target, forwrite, buffer))
+		{
+			if(!buffer.Data) buffer.Rows = 0;
+			return;
+		}
+	}
+	TJS_eTJSError(TJSInvalidParam); // not an object which has a buffer
+}
+//---------------------------------------------------------------------------
+tjs_uint8 * tTJSTypedArrayNI::GetViewElements(
+	const tTJSTypedArrayBuffer &buffer, tjs_int row, tjs_int start,
+	tjs_int count) const
+{
+	tjs_int elmsize = GetElementSize();
+	if(row < 0 || row >= buffer.Rows || start < 0 || count < 0 ||
+		((tjs_int64)start + count) * elmsize > buffer.RowBytes)
+		TJS_eTJSError(TJSRangeError);
+	if(!buffer.Data) return NULL; // an empty typed array
+	tjs_uint8 *p = (tjs_uint8 *)buffer.Data +
+		(tjs_intptr_t)row * buffer.Pitch + start * elmsize;
+	if(reinterpret_cast<tjs_uintptr_t>(p) % elmsize)
+		TJS_eTJSError(TJSInvalidParam);
+	return p;
+}
+//---------------------------------------------------------------------------
+tjs_uint8 * tTJSTypedArrayNI::GetElements(bool forwrite) const
+{
+	if(!Target) return Data;
+	tTJSTypedArrayBuffer buffer;
+	GetTargetBuffer(Target, forwrite, buffer);
+	return GetViewElements(buffer, TargetRow, TargetStart, Length);
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::Attach(iTJSDispatch2 *target, tjs_int row,
+	tjs_int start, tjs_int count)
+{
+	// make this array a view of "count" elements from "start" of the row
+	// "row" of the target
+	if(!target) TJS_eTJSError(TJSNullAccess);
+	for(tTJSTypedArrayNI *ta = FromObject(target); ta;
+		ta = FromObject(ta->Target))
+	{
+		if(ta == this) TJS_eTJSError(TJSInvalidParam); // a view of itself
+	}
+
+	tTJSTypedArrayBuffer buffer;
+	GetTargetBuffer(target, false, buffer);
+	if(count < 0) count = buffer.RowBytes / GetElementSize() - start;
+	GetViewElements(buffer, row, start, count);
+
+	target->AddRef();
+	Detach();
+	delete [] Data, Data = NULL;
+	Target = target;
+	TargetRow = row;
+	TargetStart = start;
+	Length = count;
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::Detach()
+{
+	if(!Target) return;
+	iTJSDispatch2 *target = Target;
+	Target = NULL;
+	Length = 0;
+	target->Release();
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::Get(tjs_int index, tTJSVariant &dest) const
+{
+	if(index < 0 || index >= Length) TJS_eTJSError(TJSRangeError);
+	TJS_TYPEDARRAY_DISPATCH(Type, TJSTypedArrayGet,
+		(GetElements(false), index, dest));
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::Set(tjs_int index, const tTJSVariant &value)
+{
+	if(index < 0 || index >= Length) TJS_eTJSError(TJSRangeError);
+	TJS_TYPEDARRAY_DISPATCH(Type, TJSTypedArraySet,
+		(GetElements(true), index, value));
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::CheckRange(tjs_int &start, tjs_int &count) const
+{
+	// count < 0 means "to the end"
+	if(start < 0) start += Length;
+	if(start < 0 || start > Length) TJS_eTJSError(TJSRangeError);
+	if(count < 0) count = Length - start;
+	if(count > Length - start) TJS_eTJSError(TJSRangeError);
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::CopyElements(tjs_uint8 *dest, const void *src,
+	tTJSTypedArrayType srctype, tjs_int count)
+{
+	if(!count) return;
+	if(srctype == Type)
+	{
+		memmove(dest, src, count * GetElementSize());
+		return;
+	}
+
+	// views of different types may share the memory; convert from a copy
+	// when the regions overlap
+	const tjs_uint8 *s = (const tjs_uint8 *)src;
+	tjs_int srcbytes = count * GetElementSize(srctype);
+	std::vector<tjs_uint8> temp;
+	if(s < dest + count * GetElementSize() && dest < s + srcbytes)
+	{
+		temp.assign(s, s + srcbytes);
+		s = &temp[0];
+	}
+	TJS_TYPEDARRAY_DISPATCH(Type, TJSTypedArrayConvertFrom,
+		(dest, s, srctype, count));
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::Assign(const tTJSVariant &src)
+{
+	if(Target) TJS_eTJSError(TJSAccessDenyed);
+
+	if(src.Type() == tvtOctet)
+	{
+		tTJSVariantOctet *oct = src.AsOctetNoAddRef();
+		tjs_int bytes = oct ? (tjs_int)oct->GetLength() : 0;
+		SetLength(bytes / GetElementSize());
+		if(Length) memcpy(Data, oct->GetData(), Length * GetElementSize());
+		return;
+	}
+
+	tTJSVariantClosure clo = src.AsObjectClosureNoAddRef();
+	iTJSDispatch2 *dsp = clo.ObjThis ? clo.ObjThis : clo.Object;
+	if(!dsp) TJS_eTJSError(TJSNullAccess);
+
+	tTJSTypedArrayNI *ta = FromObject(dsp);
+	if(ta)
+	{
+		if(ta == this) return;
+		const tjs_uint8 *srcdata = ta->GetElements(false);
+		tjs_int srclength = ta->Length;
+		if(srclength != Length)
+		{
+			// the source may be a view of this array; SetLength would free
+			// the elements
+			std::vector<tjs_uint8> temp(srcdata,
+				srcdata + srclength * ta->GetElementSize());
+			SetLength(srclength);
+			if(Length) CopyElements(Data, &temp[0], ta->Type, Length);
+		}
+		else
+		{
+			CopyElements(Data, srcdata, ta->Type, Length);
+		}
+		return;
+	}
+
+	tTJSArrayNI *arrayni = NULL;
+	if(TJS_FAILED(dsp->NativeInstanceSupport(TJS_NIS_GETINSTANCE,
+		TJSGetArrayClassID(), (iTJSNativeInstance**)&arrayni)))
+		TJS_eTJSError(TJSSpecifyArray);
+	SetLength((tjs_int)arrayni->Items.size());
+	if(Length)
+		TJS_TYPEDARRAY_DISPATCH(Type, TJSTypedArrayAssignVariants,
+			(Data, &arrayni->Items[0], Length));
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::Fill(const tTJSVariant &value, tjs_int start,
+	tjs_int count)
+{
+	CheckRange(start, count);
+	TJS_TYPEDARRAY_DISPATCH(Type, TJSTypedArrayFill,
+		(GetElements(true), start, count, value));
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::Copy(const tTJSVariant &src, tjs_int deststart,
+	tjs_int srcstart, tjs_int count)
+{
+	// copies "count" elements from src[srcstart] to this[deststart].
+	// src may be a typed array, an Array or an octet (the binary image of the
+	// elements of this type). count < 0 copies to the end of src.
+	const void *srcdata;
+	tTJSTypedArrayType srctype = Type;
+	const tTJSVariant *srcitems = NULL;
+	tjs_int srclength;
+
+	// the elements for writing are taken first; taking them may move the
+	// buffer of the target which the source shares (copy-on-write images)
+	tjs_uint8 *dest = GetElements(true);
+
+	if(src.Type() == tvtOctet)
+	{
+		tTJSVariantOctet *oct = src.AsOctetNoAddRef();
+		srcdata = oct ? oct->GetData() : NULL;
+		srclength = oct ? (tjs_int)oct->GetLength() / GetElementSize() : 0;
+	}
+	else
+	{
+		tTJSVariantClosure clo = src.AsObjectClosureNoAddRef();
+		iTJSDispatch2 *dsp = clo.ObjThis ? clo.ObjThis : clo.Object;
+		if(!dsp) TJS_eTJSError(TJSNullAccess);
+
+		tTJSTypedArrayNI *ta = FromObject(dsp);
+		if(ta)
+		{
+			srcdata = ta->GetElements(false);
+			srctype = ta->Type;
+			srclength = ta->Length;
+		}
+		else
+		{
+			tTJSArrayNI *arrayni = NULL;
+			if(TJS_FAILED(dsp->NativeInstanceSupport(TJS_NIS_GETINSTANCE,
+				TJSGetArrayClassID(), (iTJSNativeInstance**)&arrayni)))
+				TJS_eTJSError(TJSSpecifyArray);
+			srcdata = NULL;
+			srclength = (tjs_int)arrayni->Items.size();
+			if(srclength) srcitems = &arrayni->Items[0];
+		}
+	}
+
+	if(srcstart < 0) srcstart += srclength;
+	if(srcstart < 0 || srcstart > srclength) TJS_eTJSError(TJSRangeError);
+	if(count < 0) count = srclength - srcstart;
+	if(count > srclength - srcstart) TJS_eTJSError(TJSRangeError);
+	CheckRange(deststart, count);
+	if(!count) return;
+
+	if(srcitems)
+	{
+		TJS_TYPEDARRAY_DISPATCH(Type, TJSTypedArrayAssignVariants,
+			(dest + deststart * GetElementSize(), srcitems + srcstart, count));
+	}
+	else
+	{
+		CopyElements(dest + deststart * GetElementSize(),
+			(const tjs_uint8 *)srcdata + srcstart * GetElementSize(srctype),
+			srctype, count);
+	}
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::Sort(bool descending)
+{
+	TJS_TYPEDARRAY_DISPATCH(Type, TJSTypedArraySort,
+		(GetElements(true), Length, descending));
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::Sum(tjs_int start, tjs_int count, tTJSVariant &dest) const
+{
+	CheckRange(start, count);
+	TJS_TYPEDARRAY_DISPATCH(Type, TJSTypedArraySum,
+		(GetElements(false), start, count, dest));
+}
+//---------------------------------------------------------------------------
+tjs_int tTJSTypedArrayNI::Find(const tTJSVariant &value, tjs_int start) const
+{
+	tjs_int count = -1;
+	CheckRange(start, count);
+	tjs_int result = -1;
+	TJS_TYPEDARRAY_DISPATCH(Type, TJSTypedArrayFind,
+		(GetElements(false), start, count, value, result));
+	return result;
+}
+//---------------------------------------------------------------------------
+iTJSDispatch2 * tTJSTypedArrayNI::ToArray() const
+{
+	iTJSDispatch2 *dsp = TJSCreateArrayObject();
+	try
+	{
+		tTJSArrayNI *arrayni = NULL;
+		if(TJS_FAILED(dsp->NativeInstanceSupport(TJS_NIS_GETINSTANCE,
+			TJSGetArrayClassID(), (iTJSNativeInstance**)&arrayni)))
+			TJS_eTJSError(TJSSpecifyArray);
+		const tjs_uint8 *data = GetElements(false);
+		arrayni->Items.resize(Length);
+		for(tjs_int i = 0; i < Length; i++)
+			TJS_TYPEDARRAY_DISPATCH(Type, TJSTypedArrayGet,
+				(data, i, arrayni->Items[i]));
+	}
+	catch(...)
+	{
+		dsp->Release();
+		throw;
+	}
+	return dsp;
+}
+//---------------------------------------------------------------------------
+void tTJSTypedArrayNI::ToOctet(tjs_int start, tjs_int count,
+	tTJSVariant &dest) const
+{
+	CheckRange(start, count);
+	tjs_int elmsize = GetElementSize();
+	dest = tTJSVariant(GetElements(false) + start * elmsize,
+		(tjs_uint)(count * elmsize));
+}
+//---------------------------------------------------------------------------
+tTJSTypedArrayNI * tTJSTypedArrayNI::FromObject(iTJSDispatch2 *dsp)
+{
+	tTJSTypedArrayNI *ni = NULL;
+	if(!dsp || tTJSNC_TypedArray::ClassID == (tjs_uint32)-1) return NULL;
+	if(TJS_FAILED(dsp->NativeInstanceSupport(TJS_NIS_GETINSTANCE,
+		tTJSNC_TypedArray::ClassID, (iTJSNativeInstance**)&ni)))
+		return NULL;
+	return ni;
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// tTJSTypedArrayObject
+//---------------------------------------------------------------------------
+#define TYPEDARRAY_GET_NI \
+	tTJSTypedArrayNI *ni; \
+	if(TJS_FAILED(objthis->NativeInstanceSupport(TJS_NIS_GETINSTANCE, \
+		tTJSNC_TypedArray::ClassID, (iTJSNativeInstance**)&ni))) \
+			return TJS_E_NATIVECLASSCRASH; \
+	if(num < 0) num += ni->GetLength(); \
+	if(num < 0 || num >= ni->GetLength()) return TJS_E_MEMBERNOTFOUND;
+//---------------------------------------------------------------------------
+tTJSTypedArrayObject::tTJSTypedArrayObject() :
+	tTJSCustomObject(TJS_TYPEDARRAY_BASE_HASH_BITS)
+{
+	CallFinalize = false;
+}
+//---------------------------------------------------------------------------
+tjs_error TJS_INTF_METHOD
+	tTJSTypedArrayObject::PropGetByNum(tjs_uint32 flag, tjs_int num,
+		tTJSVariant *result, iTJSDispatch2 *objthis)
+{
+	if(!GetValidity())
+		return TJS_E_INVALIDOBJECT;
+
+	TYPEDARRAY_GET_NI;
+	if(result) ni->Get(num, *result);
+	return TJS_S_OK;
+}
+//---------------------------------------------------------------------------
+tjs_error TJS_INTF_METHOD
+	tTJSTypedArrayObject::PropSetByNum(tjs_uint32 flag, tjs_int num,
+		const tTJSVariant *param, iTJSDispatch2 *objthis)
+{
+	if(!GetValidity())
+		return TJS_E_INVALIDOBJECT;
+
+	TYPEDARRAY_GET_NI;
+	ni->Set(num, *param);
+	return TJS_S_OK;
+}
+//---------------------------------------------------------------------------
+tjs_error TJS_INTF_METHOD
+	tTJSTypedArrayObject::OperationByNum(tjs_uint32 flag, tjs_int num,
+		tTJSVariant *result, const tTJSVariant *param, iTJSDispatch2 *objthis)
+{
+	if(!GetValidity())
+		return TJS_E_INVALIDOBJECT;
+
+	TYPEDARRAY_GET_NI;
+	tTJSVariant val;
+	ni->Get(num, val);
+	tjs_error hr = TJSDefaultOperation(flag, val, result, param, objthis);
+	if(TJS_SUCCEEDED(hr)) ni->Set(num, val);
+	return hr;
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// tTJSNC_TypedArray
+//---------------------------------------------------------------------------
+tjs_uint32 tTJSNC_TypedArray::ClassID = (tjs_uint32)-1;
+tTJSNC_TypedArray::tTJSNC_TypedArray(const tjs_char *name,
+	tTJSTypedArrayType type) :
+	tTJSNativeClass(name)
+{
+	// class constructor
+
+	Type = type;
+
+	// all typed array classes share the native class ID and the members;
+	// only the constructor name differs.
+	TJS_BEGIN_NATIVE_MEMBERS(/* TJS class name */TypedArray)
+//---------------------------------------------------------------------------
+TJS_BEGIN_NATIVE_CONSTRUCTOR_DECL(/* var. name */_this,
+	/* var. type */tTJSTypedArrayNI, /* TJS class name */TypedArray)
+{
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL_INT
+	TJSNativeClassRegisterNCM(this, ClassName.c_str(),
+		TJSCreateNativeClassConstructor(NCM_TypedArray::Process), __classname,
+		nitMethod);
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/* func.name */assign)
+{
+	TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+
+	if(numparams < 1) return TJS_E_BADPARAMCOUNT;
+
+	ni->Assign(*param[0]);
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL(/* func.name */assign)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/* func.name */fill)
+{
+	// fill(value, start = 0, count = to the end)
+	TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+
+	if(numparams < 1) return TJS_E_BADPARAMCOUNT;
+
+	tjs_int start = TJS_PARAM_EXIST(1) ? (tjs_int)*param[1] : 0;
+	tjs_int count = TJS_PARAM_EXIST(2) ? (tjs_int)*param[2] : -1;
+	ni->Fill(*param[0], start, count);
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL(/* func.name */fill)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/* func.name */copy)
+{
+	// copy(src, deststart = 0, srcstart = 0, count = to the end of src)
+	TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+
+	if(numparams < 1) return TJS_E_BADPARAMCOUNT;
+
+	tjs_int deststart = TJS_PARAM_EXIST(1) ? (tjs_int)*param[1] : 0;
+	tjs_int srcstart = TJS_PARAM_EXIST(2) ? (tjs_int)*param[2] : 0;
+	tjs_int count = TJS_PARAM_EXIST(3) ? (tjs_int)*param[3] : -1;
+	ni->Copy(*param[0], deststart, srcstart, count);
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL(/* func.name */copy)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/* func.name */sort)
+{
+	// sort(descending = false); NaNs are placed at the end
+	TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+
+	bool descending = TJS_PARAM_EXIST(0) ? (bool)*param[0] : false;
+	ni->Sort(descending);
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL(/* func.name */sort)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/* func.name */sum)
+{
+	// sum(start = 0, count = to the end); integer arrays sum in 64bit integer
+	TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+
+	tjs_int start = TJS_PARAM_EXIST(0) ? (tjs_int)*param[0] : 0;
+	tjs_int count = TJS_PARAM_EXIST(1) ? (tjs_int)*param[1] : -1;
+	tTJSVariant sum;
+	ni->Sum(start, count, sum);
+	if(result) *result = sum;
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL(/* func.name */sum)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/* func.name */find)
+{
+	// find(value, start = 0); returns the index or -1
+	TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+
+	if(numparams < 1) return TJS_E_BADPARAMCOUNT;
+
+	tjs_int start = TJS_PARAM_EXIST(1) ? (tjs_int)*param[1] : 0;
+	tjs_int index = ni->Find(*param[0], start);
+	if(result) *result = index;
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL(/* func.name */find)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/* func.name */toArray)
+{
+	TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+
+	iTJSDispatch2 *dsp = ni->ToArray();
+	if(result) *result = tTJSVariant(dsp, dsp);
+	dsp->Release();
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL(/* func.name */toArray)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/* func.name */toOctet)
+{
+	// toOctet(start = 0, count = to the end)
+	TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+
+	tjs_int start = TJS_PARAM_EXIST(0) ? (tjs_int)*param[0] : 0;
+	tjs_int count = TJS_PARAM_EXIST(1) ? (tjs_int)*param[1] : -1;
+	tTJSVariant octet;
+	ni->ToOctet(start, count, octet);
+	if(result) *result = octet;
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL(/* func.name */toOctet)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/* func.name */attach)
+{
+	// attach(object, row = 0, start = 0, count = to the end of the row)
+	// makes this array a view of "count" elements from "start" of the row
+	// "row" of the object, without copying. the object is a Layer (its main
+	// image), a Bitmap, or a typed array (which has one row).
+	// the view holds the object; every access fails with a range error if
+	// the range no longer lies in the buffer of the object. writing to a
+	// layer through a view does not update the layer on the screen; call
+	// update() of the layer.
+	TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+
+	if(numparams < 1) return TJS_E_BADPARAMCOUNT;
+
+	tTJSVariantClosure clo = param[0]->AsObjectClosureNoAddRef();
+	tjs_int row = TJS_PARAM_EXIST(1) ? (tjs_int)*param[1] : 0;
+	tjs_int start = TJS_PARAM_EXIST(2) ? (tjs_int)*param[2] : 0;
+	tjs_int count = TJS_PARAM_EXIST(3) ? (tjs_int)*param[3] : -1;
+	ni->Attach(clo.ObjThis ? clo.ObjThis : clo.Object, row, start, count);
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL(/* func.name */attach)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/* func.name */subarray)
+{
+	// subarray(start = 0, count = to the end)
+	// returns a new array of the same type which is a view of the elements
+	// of this array; as attach(this, 0, start, count) does, except that a
+	// negative start counts from the end.
+	TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+
+	tjs_int start = TJS_PARAM_EXIST(0) ? (tjs_int)*param[0] : 0;
+	tjs_int count = TJS_PARAM_EXIST(1) ? (tjs_int)*param[1] : -1;
+	if(start < 0) start += ni->GetLength();
+
+	iTJSDispatch2 *dsp = TJSCreateTypedArrayObject(ni->GetType());
+	try
+	{
+		tTJSTypedArrayNI *subni = tTJSTypedArrayNI::FromObject(dsp);
+		subni->Attach(objthis, 0, start, count);
+	}
+	catch(...)
+	{
+		dsp->Release();
+		throw;
+	}
+	if(result) *result = tTJSVariant(dsp, dsp);
+	dsp->Release();
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL(/* func.name */subarray)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/* func.name */detach)
+{
+	TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+
+	ni->Detach();
+
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL(/* func.name */detach)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_PROP_DECL(count)
+{
+	TJS_BEGIN_NATIVE_PROP_GETTER
+	{
+		TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+		if(result) *result = (tTVInteger)ni->GetLength();
+		return TJS_S_OK;
+	}
+	TJS_END_NATIVE_PROP_GETTER
+
+	TJS_BEGIN_NATIVE_PROP_SETTER
+	{
+		TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+		ni->SetLength((tjs_int)*param);
+		return TJS_S_OK;
+	}
+	TJS_END_NATIVE_PROP_SETTER
+}
+TJS_END_NATIVE_PROP_DECL(count)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_PROP_DECL(bytesPerElement)
+{
+	TJS_BEGIN_NATIVE_PROP_GETTER
+	{
+		TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+		if(result) *result = (tTVInteger)ni->GetElementSize();
+		return TJS_S_OK;
+	}
+	TJS_END_NATIVE_PROP_GETTER
+
+	TJS_DENY_NATIVE_PROP_SETTER
+}
+TJS_END_NATIVE_PROP_DECL(bytesPerElement)
+//----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_PROP_DECL(attached)
+{
+	TJS_BEGIN_NATIVE_PROP_GETTER
+	{
+		TJS_GET_NATIVE_INSTANCE(/* var. name */ni, /* var. type */tTJSTypedArrayNI);
+		if(result) *result = ni->IsView();
+		return TJS_S_OK;
+	}
+	TJS_END_NATIVE_PROP_GETTER
+
+	TJS_DENY_NATIVE_PROP_SETTER
+}
+TJS_END_NATIVE_PROP_DECL(attached)
+//----------------------------------------------------------------------
+	TJS_END_NATIVE_MEMBERS
+}
+//---------------------------------------------------------------------------
+tTJSNativeInstance *tTJSNC_TypedArray::CreateNativeInstance()
+{
+	return new tTJSTypedArrayNI(Type);
+}
+//---------------------------------------------------------------------------
+iTJSDispatch2 *tTJSNC_TypedArray::CreateBaseTJSObject()
+{
+	return new tTJSTypedArrayObject();
+}
+//---------------------------------------------------------------------------
+
+
+
+
+//---------------------------------------------------------------------------
+// TJSCreateTypedArrayObject
+//---------------------------------------------------------------------------
+static const struct
+{
+	const tjs_char *Name;
+	tTJSTypedArrayType Type;
+} TJSTypedArrayClasses[] =
+{
+	{ TJS_W("Int8Array"),			tatInt8 },
+	{ TJS_W("Uint8Array"),			tatUint8 },
+	{ TJS_W("Uint8ClampedArray"),	tatUint8Clamped },
+	{ TJS_W("Int16Array"),			tatInt16 },
+	{ TJS_W("Uint16Array"),			tatUint16 },
+	{ TJS_W("Int32Array"),			tatInt32 },
+	{ TJS_W("Uint32Array"),			tatUint32 },
+	{ TJS_W("Float32Array"),		tatFloat32 },
+	{ TJS_W("Float64Array"),		tatFloat64 },
+};
+//---------------------------------------------------------------------------
+iTJSDispatch2 * TJSCreateTypedArrayObject(tTJSTypedArrayType type)
+{
+	// create a typed array object of "type"
+	struct tHolder
+	{
+		iTJSDispatch2 * Obj[tatNumTypes];
+		tHolder()
+		{
+			for(tjs_int i = 0; i < tatNumTypes; i++)
+			{
+				tTJSTypedArrayType t = TJSTypedArrayClasses[i].Type;
+				Obj[t] = new tTJSNC_TypedArray(TJSTypedArrayClasses[i].Name, t);
+			}
+		}
+		~tHolder()
+		{
+			for(tjs_int i = 0; i < tatNumTypes; i++) Obj[i]->Release();
+		}
+	} static classes;
+
+	iTJSDispatch2 *obj;
+	classes.Obj[type]->CreateNew(0, NULL, NULL, &obj, 0, NULL,
+		classes.Obj[type]);
+	return obj;
+}
+//---------------------------------------------------------------------------
+//---------------------------------------------------------------------------
+// TJSRegisterTypedArrayClasses
+//---------------------------------------------------------------------------
+void TJSRegisterTypedArrayClasses(iTJSDispatch2 *global)
+{
+	for(tjs_int i = 0; i < tatNumTypes; i++)
+	{
+		const tjs_char *name = TJSTypedArrayClasses[i].Name;
+		iTJSDispatch2 *dsp = new tTJSNC_TypedArray(name,
+			TJSTypedArrayClasses[i].Type);
+		tTJSVariant val(dsp, NULL);
+		dsp->Release();
+		global->PropSet(TJS_MEMBERENSURE, name, NULL, &val, global);
+	}
+}
+//---------------------------------------------------------------------------
+} // namespace TJS
+
@@ -0,0 +1,181 @@
+//---------------------------------------------------------------------------
+/*
+	TJS2 Script Engine
+	Copyright (C) 2000 W.Dee <dee@kikyou.info> and contributors
+
+	See details of license at "license.txt"
+*/
+//---------------------------------------------------------------------------
+// Typed array classes ( Int8Array, Uint8Array, ... Float64Array )
+//---------------------------------------------------------------------------
+/*
+	Typed arrays hold numbers of one type in a contiguous native buffer,
+	instead of tTJSVariant per element as Array does. Elements are accessed
+	with integer indices (a[i]); integer elements wrap around on overflow
+	as C casts do, except Uint8ClampedArray, which clamps values to 0..255
+	and rounds reals to the nearest (to even on ties).
+
+	A typed array may also be a view of the memory of another object
+	(attach and subarray methods): a range of a row of an object which a
+	buffer source knows, such as Layer and Bitmap, or a range of another
+	typed array. The view keeps a reference to the object, and finds the
+	buffer of the object again on every access; an access to a range which
+	is no longer in the buffer (the image was resized, the array was
+	shortened, ...) fails with a range error instead of touching the
+	memory.
+*/
+#ifndef tjsTypedArrayH
+#define tjsTypedArrayH
+
+#include "tjsNative.h"
+
+namespace TJS
+{
+//---------------------------------------------------------------------------
+enum tTJSTypedArrayType
+{
+	tatInt8,
+	tatUint8,
+	tatUint8Clamped,
+	tatInt16,
+	tatUint16,
+	tatInt32,
+	tatUint32,
+	tatFloat32,
+	tatFloat64,
+	tatNumTypes
+};
+//---------------------------------------------------------------------------
+// iTJSTypedArrayBufferSource : gives typed arrays the memory of host objects
+//---------------------------------------------------------------------------
+struct tTJSTypedArrayBuffer
+{
+	void * Data; // the first row; NULL if the object has no buffer now
+	tjs_int RowBytes; // bytes in a row which views may cover
+	tjs_int Pitch; // bytes from a row to the next; may be negative
+	tjs_int Rows;
+};
+//---------------------------------------------------------------------------
+class iTJSTypedArrayBufferSource
+{
+public:
+	virtual bool GetBuffer(iTJSDispatch2 *obj, bool forwrite,
+		tTJSTypedArrayBuffer &buffer) = 0;
+		// returns false if "obj" is not an object of this source. the
+		// buffer is used only until the typed array returns to the script.
+};
+//---------------------------------------------------------------------------
+extern void TJSAddTypedArrayBufferSource(iTJSTypedArrayBufferSource *source);
+extern void TJSRemoveTypedArrayBufferSource(
+	iTJSTypedArrayBufferSource *source);
+//---------------------------------------------------------------------------
+// tTJSTypedArrayNI : native instance of typed arrays
+//---------------------------------------------------------------------------
+class tTJSTypedArrayNI : public tTJSNativeInstance
+{
+	typedef tTJSNativeInstance inherited;
+
+	tTJSTypedArrayType Type;
+	tjs_uint8 * Data; // own elements; NULL for a view
+	tjs_int Length; // in elements
+	iTJSDispatch2 * Target; // the object this array is a view of, or NULL
+	tjs_int TargetRow;
+	tjs_int TargetStart; // in elements of this array
+
+public:
+	tTJSTypedArrayNI(tTJSTypedArrayType type);
+	~tTJSTypedArrayNI();
+
+	tjs_error TJS_INTF_METHOD Construct(tjs_int numparams, tTJSVariant **param,
+		iTJSDispatch2 *tjsobj);
+	void TJS_INTF_METHOD Invalidate();
+
+	tTJSTypedArrayType GetType() const { return Type; }
+	tjs_int GetElementSize() const { return GetElementSize(Type); }
+	static tjs_int GetElementSize(tTJSTypedArrayType type);
+	bool IsFloat() const { return Type == tatFloat32 || Type == tatFloat64; }
+
+	tjs_int GetLength() const { return Length; }
+	void SetLength(tjs_int length);
+	bool IsView() const { return Target != NULL; }
+
+	void Attach(iTJSDispatch2 *target, tjs_int row, tjs_int start,
+		tjs_int count);
+		// count < 0 means "to the end of the row"
+	void Detach();
+
+	void Get(tjs_int index, tTJSVariant &dest) const;
+	void Set(tjs_int index, const tTJSVariant &value);
+
+	void Assign(const tTJSVariant &src);
+	void Fill(const tTJSVariant &value, tjs_int start, tjs_int count);
+	void Copy(const tTJSVariant &src, tjs_int deststart, tjs_int srcstart,
+		tjs_int count);
+	void Sort(bool descending);
+	void Sum(tjs_int start, tjs_int count, tTJSVariant &dest) const;
+	tjs_int Find(const tTJSVariant &value, tjs_int start) const;
+	iTJSDispatch2 * ToArray() const;
+	void ToOctet(tjs_int start, tjs_int count, tTJSVariant &dest) const;
+
+	static tTJSTypedArrayNI * FromObject(iTJSDispatch2 *dsp);
+		// returns NULL if dsp is not a typed array
+
+private:
+	tjs_uint8 * GetElements(bool forwrite) const;
+		// the first element; checks that a view still lies in the buffer of
+		// the target
+	static void GetTargetBuffer(iTJSDispatch2 *target, bool forwrite,
+		tTJSTypedArrayBuffer &buffer);
+	tjs_uint8 * GetViewElements(const tTJSTypedArrayBuffer &buffer,
+		tjs_int row, tjs_int start, tjs_int count) const;
+	void CheckRange(tjs_int &start, tjs_int &count) const;
+	void CopyElements(tjs_uint8 *dest, const void *src,
+		tTJSTypedArrayType srctype, tjs_int count);
+};
+//---------------------------------------------------------------------------
+// tTJSTypedArrayObject : the object which supports integer indices
+//---------------------------------------------------------------------------
+class tTJSTypedArrayObject : public tTJSCustomObject
+{
+	typedef tTJSCustomObject inherited;
+
+public:
+	tTJSTypedArrayObject();
+
+	tjs_error TJS_INTF_METHOD
+	PropGetByNum(tjs_uint32 flag, tjs_int num, tTJSVariant *result,
+		iTJSDispatch2 *objthis);
+
+	tjs_error TJS_INTF_METHOD
+	PropSetByNum(tjs_uint32 flag, tjs_int num, const tTJSVariant *param,
+		iTJSDispatch2 *objthis);
+
+	tjs_error TJS_INTF_METHOD
+	OperationByNum(tjs_uint32 flag, tjs_int num, tTJSVariant *result,
+		const tTJSVariant *param, iTJSDispatch2 *objthis);
+};
+//---------------------------------------------------------------------------
+// tTJSNC_TypedArray : TJS native class of typed arrays
+//---------------------------------------------------------------------------
+class tTJSNC_TypedArray : public tTJSNativeClass
+{
+	typedef tTJSNativeClass inherited;
+
+	tTJSTypedArrayType Type;
+
+public:
+	tTJSNC_TypedArray(const tjs_char *name, tTJSTypedArrayType type);
+
+	static tjs_uint32 ClassID; // shared by all typed array classes
+
+protected:
+	tTJSNativeInstance *CreateNativeInstance();
+	iTJSDispatch2 *CreateBaseTJSObject();
+};
+//---------------------------------------------------------------------------
+extern iTJSDispatch2 * TJSCreateTypedArrayObject(tTJSTypedArrayType type);
+extern void TJSRegisterTypedArrayClasses(iTJSDispatch2 *global);
+//---------------------------------------------------------------------------
+} // namespace TJS
+
+#endif
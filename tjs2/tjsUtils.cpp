@@ -11,12 +11,124 @@
 #include "tjsCommHead.h"
 
 #include "tjsUtils.h"
+#include "tjsError.h"
+#ifndef __WIN32__
+#include <chrono>
+#endif
 
 namespace TJS
 {
 //---------------------------------------------------------------------------
 iTJSDispatch2 * TJSObjectTraceTarget;
 //---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// high resolution counter
+//---------------------------------------------------------------------------
+#ifdef __WIN32__
+tjs_uint64 TJSGetPerformanceCounter()
+{
+	LARGE_INTEGER c;
+	QueryPerformanceCounter(&c);
+	return c.QuadPart;
+}
+//---------------------------------------------------------------------------
+tjs_uint64 TJSGetPerformanceFrequency()
+{
+	static tjs_uint64 frequency = 0;
+	if(!frequency)
+	{
+		LARGE_INTEGER f;
+		QueryPerformanceFrequency(&f);
+		frequency = f.QuadPart;
+	}
+	return frequency;
+}
+#else
+tjs_uint64 TJSGetPerformanceCounter()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+//---------------------------------------------------------------------------
+tjs_uint64 TJSGetPerformanceFrequency()
+{
+	return 1000000000;
+}
+#endif
+//---------------------------------------------------------------------------
+
+
+
+//---------------------------------------------------------------------------
+// tTJSIntervalThread
+//---------------------------------------------------------------------------
+#ifdef __WIN32__
+tTJSIntervalThread::tTJSIntervalThread(tjs_uint interval, tProc proc, void *data)
+{
+	Proc = proc;
+	Data = data;
+	Interval = interval;
+	StopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if(!StopEvent) TJS_eTJSError(TJSInternalError);
+
+	DWORD tid;
+	Thread = CreateThread(NULL, 0, ThreadProc, this, 0, &tid);
+	if(!Thread)
+	{
+		CloseHandle(StopEvent);
+		TJS_eTJSError(TJSInternalError);
+	}
+	SetThreadPriority(Thread, THREAD_PRIORITY_TIME_CRITICAL);
+}
+//---------------------------------------------------------------------------
+tTJSIntervalThread::~tTJSIntervalThread()
+{
+	SetEvent(StopEvent);
+	WaitForSingleObject(Thread, INFINITE);
+	CloseHandle(Thread);
+	CloseHandle(StopEvent);
+}
+//---------------------------------------------------------------------------
+DWORD WINAPI tTJSIntervalThread::ThreadProc(LPVOID param)
+{
+	tTJSIntervalThread * _this = (tTJSIntervalThread *)param;
+	while(WaitForSingleObject(_this->StopEvent, _this->Interval) == WAIT_TIMEOUT)
+		_this->Proc(_this->Data);
+	return 0;
+}
+#else
+tTJSIntervalThread::tTJSIntervalThread(tjs_uint interval, tProc proc, void *data)
+{
+	Proc = proc;
+	Data = data;
+	Interval = interval;
+	Stopping = false;
+	Thread = std::thread(ThreadProc, this);
+}
+//---------------------------------------------------------------------------
+tTJSIntervalThread::~tTJSIntervalThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(StopMutex);
+		Stopping = true;
+	}
+	StopCond.notify_all();
+	Thread.join();
+}
+//---------------------------------------------------------------------------
+void tTJSIntervalThread::ThreadProc(tTJSIntervalThread *_this)
+{
+	std::unique_lock<std::mutex> lock(_this->StopMutex);
+	while(!_this->StopCond.wait_for(lock,
+		std::chrono::milliseconds(_this->Interval),
+		[_this]{ return _this->Stopping; }))
+		_this->Proc(_this->Data);
+}
+#endif
+//---------------------------------------------------------------------------
 static void TJSTrimStringLength(tTJSString &str, tjs_int len)
 {
 	if(str.GetLen() > len)
@@ -13,6 +13,11 @@
 
 #include "tjsVariant.h"
 #include "tjsString.h"
+#ifndef __WIN32__
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#endif
 
 namespace TJS
 {
@@ -34,12 +39,13 @@ public:
 #else
 class tTJSCriticalSection
 {
+	std::recursive_mutex CS;
 public:
 	tTJSCriticalSection() { ; }
 	~tTJSCriticalSection() { ; }
 
-	void Enter() { ; }
-	void Leave() { ; }
+	void Enter() { CS.lock(); }
+	void Leave() { CS.unlock(); }
 };
 #endif
 //---------------------------------------------------------------------------
@@ -84,6 +90,43 @@ public:
 typedef tTJSCriticalSectionHolder tTJSCSH;
 //---------------------------------------------------------------------------
 
+//---------------------------------------------------------------------------
+// high resolution counter ( implement on each platform )
+//---------------------------------------------------------------------------
+extern tjs_uint64 TJSGetPerformanceCounter();
+extern tjs_uint64 TJSGetPerformanceFrequency(); // counts per second
+//---------------------------------------------------------------------------
+// tTJSIntervalThread : calls a function at each interval on its own thread
+// ( implement on each platform )
+//---------------------------------------------------------------------------
+class tTJSIntervalThread
+{
+public:
+	typedef void (*tProc)(void *data);
+
+private:
+	tProc Proc;
+	void *Data;
+	tjs_uint Interval; // in ms
+#ifdef __WIN32__
+	HANDLE Thread;
+	HANDLE StopEvent;
+	static DWORD WINAPI ThreadProc(LPVOID param);
+#else
+	std::thread Thread;
+	std::mutex StopMutex;
+	std::condition_variable StopCond;
+	bool Stopping;
+	static void ThreadProc(tTJSIntervalThread *_this);
+#endif
+
+public:
+	tTJSIntervalThread(tjs_uint interval, tProc proc, void *data);
+		// the thread runs at THREAD_PRIORITY_TIME_CRITICAL on Win32.
+	~tTJSIntervalThread(); // stops the thread and waits for it
+};
+//---------------------------------------------------------------------------
+
 //---------------------------------------------------------------------------
 // tTJSAtExit / tTJSAtStart
 //---------------------------------------------------------------------------
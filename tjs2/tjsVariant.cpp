@@ -1103,10 +1103,11 @@ void tTJSVariant::operator +=(const tTJSVariant &rhs)
 			// independ string
 			if(String && String->GetRefCount() != 0)
 			{
-				// sever dependency
+				// sever dependency; copy and append at once
 				tTJSVariantString *orgstr = String;
-				String = TJSAllocVariantString(String->operator const tjs_char*());
+				String = TJSAllocVariantString(*orgstr, *rhs.String);
 				orgstr->Release();
+				return;
 			}
 
 			// append
@@ -1173,9 +1174,10 @@ void tTJSVariant::operator +=(const tTJSVariant &rhs)
 
 	TJSSetFPUE();
 	tTVReal l=AsReal();
+	tTVReal r=rhs.AsReal(); // this may throw; keep this intact until here
 	ReleaseContent();
 	vt=tvtReal;
-	Real=l+rhs.AsReal();
+	Real=l+r;
 }
 //---------------------------------------------------------------------------
 bool tTJSVariant::IsInstanceOf(const tjs_char * classname) const
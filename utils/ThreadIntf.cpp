@@ -15,5 +15,13 @@
 
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
-
-
+bool TVPTryExecThreadTasks(tjs_int num, TVP_THREAD_TASK_FUNC func,
+	TVP_THREAD_PARAM const *params)
+{
+	if(!TVPTryBeginThreadTask(num)) return false;
+	for(tjs_int i = 0; i < num; i++)
+		TVPExecThreadTask(func, params[i]);
+	TVPEndThreadTask();
+	return true;
+}
+//---------------------------------------------------------------------------
@@ -37,4 +37,14 @@ TJS_EXP_FUNC_DEF(void, TVPBeginThreadTask, (tjs_int num));
 TJS_EXP_FUNC_DEF(void, TVPExecThreadTask, (TVP_THREAD_TASK_FUNC func, TVP_THREAD_PARAM param));
 TJS_EXP_FUNC_DEF(void, TVPEndThreadTask, ());
 
+extern bool TVPTryBeginThreadTask(tjs_int num);
+	// same as TVPBeginThreadTask but returns false instead of waiting when
+	// the thread pool is used by another thread. TVPEndThreadTask must be
+	// called only when this returns true.
+
+extern bool TVPTryExecThreadTasks(tjs_int num, TVP_THREAD_TASK_FUNC func,
+	TVP_THREAD_PARAM const *params);
+	// runs func(params[i]) for each i < num on the thread pool and waits
+	// for them; returns false without running any when the pool is busy.
+
 #endif
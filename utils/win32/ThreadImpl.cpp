@@ -155,6 +155,18 @@ static std::vector<tjs_int> TVPProcesserIdList;
 static LONG TVPRunningThreadCount = 0;
 static tjs_int TVPThreadTaskNum, TVPThreadTaskCount;
 
+//---------------------------------------------------------------------------
+// the thread pool is shared by the whole process. it is owned by one thread
+// from TVPBeginThreadTask to TVPEndThreadTask, so that image decoders running
+// on the asynchronous loading thread never disturb tasks of the main thread.
+static struct tTVPThreadTaskLock
+{
+  CRITICAL_SECTION CS;
+  bool Busy;
+  tTVPThreadTaskLock() : Busy(false) { InitializeCriticalSection(&CS); }
+  ~tTVPThreadTaskLock() { DeleteCriticalSection(&CS); }
+} TVPThreadTaskLock;
+
 //---------------------------------------------------------------------------
 static tjs_int GetProcesserNum(void)
 {
@@ -197,7 +209,7 @@ static DWORD WINAPI ThreadLoop(LPVOID p)
   return TRUE;
 }
 //---------------------------------------------------------------------------
-void TVPBeginThreadTask(tjs_int taskNum)
+static void TVPInternalBeginThreadTask(tjs_int taskNum)
 {
   TVPThreadTaskNum = taskNum;
   TVPThreadTaskCount = 0;
@@ -240,6 +252,28 @@ void TVPBeginThreadTask(tjs_int taskNum)
     TVPThreadList.pop_back();
   }
 }
+//---------------------------------------------------------------------------
+void TVPBeginThreadTask(tjs_int taskNum)
+{
+  EnterCriticalSection(&TVPThreadTaskLock.CS);
+  TVPThreadTaskLock.Busy = true;
+  TVPInternalBeginThreadTask(taskNum);
+}
+//---------------------------------------------------------------------------
+bool TVPTryBeginThreadTask(tjs_int taskNum)
+{
+  // returns false if the pool is in use by another thread, or if the
+  // calling thread is already inside a task (the pool is not reentrant).
+  if (!TryEnterCriticalSection(&TVPThreadTaskLock.CS))
+    return false;
+  if (TVPThreadTaskLock.Busy) {
+    LeaveCriticalSection(&TVPThreadTaskLock.CS);
+    return false;
+  }
+  TVPThreadTaskLock.Busy = true;
+  TVPInternalBeginThreadTask(taskNum);
+  return true;
+}
 
 //---------------------------------------------------------------------------
 void TVPExecThreadTask(TVP_THREAD_TASK_FUNC func, TVP_THREAD_PARAM param)
@@ -261,6 +295,8 @@ void TVPEndThreadTask(void)
 {
   while ((LONG)InterlockedCompareExchange(&TVPRunningThreadCount, 0, 0) != 0)
     Sleep(0);
+  TVPThreadTaskLock.Busy = false;
+  LeaveCriticalSection(&TVPThreadTaskLock.CS);
 }
 
 //---------------------------------------------------------------------------
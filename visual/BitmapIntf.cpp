@@ -7,6 +7,7 @@
 #include "TVPColor.h"
 #include "LayerIntf.h"
 #include "Application.h"
+#include "tjsTypedArray.h"
 
 tTJSNI_Bitmap::tTJSNI_Bitmap() : Owner(NULL), Bitmap(NULL), Loading(false) {
 	TVPTempBitmapHolderAddRef();
@@ -93,6 +94,16 @@ iTJSDispatch2 * tTJSNI_Bitmap::Load(const ttstr &name, tjs_uint32 colorkey) {
 	return metainfo;
 }
 //----------------------------------------------------------------------
+iTJSDispatch2 * tTJSNI_Bitmap::LoadRegion(const ttstr &name, const tTVPRect *srcrect,
+	tjs_uint dstw, tjs_uint dsth, tjs_uint32 colorkey) {
+	if( Loading ) TVPThrowExceptionMessage(TVPCurrentlyAsyncLoadBitmap);
+	if( !Bitmap ) Bitmap = new tTVPBaseBitmap( TVPGetInitialBitmap() );
+
+	iTJSDispatch2* metainfo = NULL;
+	TVPLoadGraphicRegion( Bitmap, name, colorkey, srcrect, dstw, dsth, &metainfo);
+	return metainfo;
+}
+//----------------------------------------------------------------------
 void tTJSNI_Bitmap::LoadAsync( const ttstr &name) {
 	if( Loading ) TVPThrowExceptionMessage(TVPCurrentlyAsyncLoadBitmap);
 	Loading = true;
@@ -184,6 +195,28 @@ void tTJSNI_Bitmap::CopyFrom( const  tTVPBaseBitmap* src ) {
 	Bitmap->Assign(*src);
 }
 //----------------------------------------------------------------------
+// tTVPBitmapTypedArraySource : lets typed arrays view the image of bitmaps
+//----------------------------------------------------------------------
+class tTVPBitmapTypedArraySource : public iTJSTypedArrayBufferSource {
+public:
+	bool GetBuffer(iTJSDispatch2 *obj, bool forwrite, tTJSTypedArrayBuffer &buffer) {
+		tTJSNI_Bitmap *bmp = NULL;
+		if(TJS_FAILED(obj->NativeInstanceSupport(TJS_NIS_GETINSTANCE,
+			tTJSNC_Bitmap::ClassID, (iTJSNativeInstance**)&bmp))) return false;
+		// the loading thread writes the image of a bitmap being loaded
+		tTVPBaseBitmap *image = bmp->GetBitmap();
+		if(!image || bmp->IsLoading()) {
+			buffer.Data = NULL;
+			return true;
+		}
+		buffer.Data = forwrite ? image->GetScanLineForWrite(0) : const_cast<void*>(image->GetScanLine(0));
+		buffer.RowBytes = image->GetWidth() * (image->GetBPP() / 8);
+		buffer.Pitch = image->GetPitchBytes();
+		buffer.Rows = image->GetHeight();
+		return true;
+	}
+} static TVPBitmapTypedArraySource;
+//----------------------------------------------------------------------
 tjs_uint32 tTJSNC_Bitmap::ClassID = -1;
 
 //----------------------------------------------------------------------
@@ -314,6 +347,42 @@ TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/load)
 }
 TJS_END_NATIVE_METHOD_DECL(/*func. name*/load)
 //----------------------------------------------------------------------
+TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/loadRegion)
+{
+	// loadRegion(storage, left, top, width, height, dstw=0, dsth=0, colorkey=clNone)
+	// a width or height of zero or less loads the whole image ( left/top
+	// are then ignored ). the region is clipped to the image, and a region
+	// without any pixel in the image is an error. dstw/dsth of zero or
+	// larger than the region keep the region size.
+	TJS_GET_NATIVE_INSTANCE(/*var. name*/_this, /*var. type*/tTJSNI_Bitmap);
+	if(numparams < 5) return TJS_E_BADPARAMCOUNT;
+	ttstr name(*param[0]);
+	tjs_int left = *param[1];
+	tjs_int top = *param[2];
+	tjs_int width = *param[3];
+	tjs_int height = *param[4];
+	tjs_uint dstw = 0, dsth = 0;
+	if(numparams >= 6 && param[5]->Type() != tvtVoid)
+		dstw = (tjs_uint)(tjs_int)*param[5];
+	if(numparams >= 7 && param[6]->Type() != tvtVoid)
+		dsth = (tjs_uint)(tjs_int)*param[6];
+	tjs_uint32 key = clNone;
+	if(numparams >= 8 && param[7]->Type() != tvtVoid)
+		key = (tjs_uint32)param[7]->AsInteger();
+	tTVPRect rect(left, top, left + width, top + height);
+	iTJSDispatch2 * metainfo = _this->LoadRegion(name,
+		(width > 0 && height > 0) ? &rect : NULL, dstw, dsth, key);
+	try {
+		if(result) *result = metainfo;
+	} catch(...) {
+		if(metainfo) metainfo->Release();
+		throw;
+	}
+	if(metainfo) metainfo->Release();
+	return TJS_S_OK;
+}
+TJS_END_NATIVE_METHOD_DECL(/*func. name*/loadRegion)
+//----------------------------------------------------------------------
 TJS_BEGIN_NATIVE_METHOD_DECL(/*func. name*/loadAsync)
 {
 	TJS_GET_NATIVE_INSTANCE(/*var. name*/_this, /*var. type*/tTJSNI_Bitmap);
@@ -499,6 +568,8 @@ TJS_END_NATIVE_PROP_DECL(loading)
 //----------------------------------------------------------------------
 
 	TJS_END_NATIVE_MEMBERS
+
+	TJSAddTypedArrayBufferSource(&TVPBitmapTypedArraySource);
 }
 
 //---------------------------------------------------------------------------
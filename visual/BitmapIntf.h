@@ -6,6 +6,7 @@
 #include "tjsNative.h"
 
 class tTVPBaseBitmap;
+struct tTVPRect;
 class tTJSNI_Bitmap : public tTJSNativeInstance
 {
 	typedef tTJSNativeInstance inherited;
@@ -36,6 +37,8 @@ public:
 	void Independ(bool copy = true);
 
 	iTJSDispatch2* Load(const ttstr &name, tjs_uint32 colorkey);
+	iTJSDispatch2* LoadRegion(const ttstr &name, const tTVPRect *srcrect,
+		tjs_uint dstw, tjs_uint dsth, tjs_uint32 colorkey);
 	void LoadAsync(const ttstr &name);
 	void Save(const ttstr &name, const ttstr &type, iTJSDispatch2* meta = NULL);
 
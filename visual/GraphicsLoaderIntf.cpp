@@ -1449,32 +1449,12 @@ bool TVPHasImageCache( const ttstr& nname, tTVPGraphicLoadMode mode, tjs_uint dw
 	return false;
 }
 //---------------------------------------------------------------------------
-static bool TVPInternalLoadGraphic(tTVPBaseBitmap *dest, const ttstr &_name,
-	tjs_uint32 keyidx, tjs_uint desw, tjs_int desh, std::vector<tTVPGraphicMetaInfoPair> * * MetaInfo,
-		tTVPGraphicLoadMode mode, ttstr *provincename)
+static tTVPGraphicHandlerType * TVPSearchGraphicHandler(ttstr &name)
 {
-	// name must be normalized.
-	// if "provincename" is non-null, this function set it to province storage
-	// name ( with _p suffix ) for convinience.
-	// desw and desh are desired size. if the actual picture is smaller than
-	// the given size, the graphic is to be tiled. give 0,0 to obtain default
-	// size graphic.
-
-
-	// graphic compact initialization
-	if(!TVPClearGraphicCacheCallbackInit)
-	{
-		TVPAddCompactEventHook(&TVPClearGraphicCacheCallback);
-		TVPClearGraphicCacheCallbackInit = true;
-	}
-
-
-	// search according with its extension
-	tjs_int namelen = _name.GetLen();
-	ttstr name(_name);
-
+	// search the loading handler according with the extension of "name".
+	// if the extension is missing, registered extensions are tried and
+	// "name" is set to the storage name found.
 	ttstr ext = TVPExtractStorageExt(name);
-	int extlen = ext.GetLen();
 	tTVPGraphicHandlerType * handler;
 
 	if(ext == TJS_W(""))
@@ -1508,6 +1488,37 @@ static bool TVPInternalLoadGraphic(tTVPBaseBitmap *dest, const ttstr &_name,
 
 	if(!handler) TVPThrowExceptionMessage(TVPUnknownGraphicFormat, name);
 
+	return handler;
+}
+//---------------------------------------------------------------------------
+static bool TVPInternalLoadGraphic(tTVPBaseBitmap *dest, const ttstr &_name,
+	tjs_uint32 keyidx, tjs_uint desw, tjs_int desh, std::vector<tTVPGraphicMetaInfoPair> * * MetaInfo,
+		tTVPGraphicLoadMode mode, ttstr *provincename)
+{
+	// name must be normalized.
+	// if "provincename" is non-null, this function set it to province storage
+	// name ( with _p suffix ) for convinience.
+	// desw and desh are desired size. if the actual picture is smaller than
+	// the given size, the graphic is to be tiled. give 0,0 to obtain default
+	// size graphic.
+
+
+	// graphic compact initialization
+	if(!TVPClearGraphicCacheCallbackInit)
+	{
+		TVPAddCompactEventHook(&TVPClearGraphicCacheCallback);
+		TVPClearGraphicCacheCallbackInit = true;
+	}
+
+
+	// search according with its extension
+	tjs_int namelen = _name.GetLen();
+	ttstr name(_name);
+
+	ttstr ext = TVPExtractStorageExt(name);
+	int extlen = ext.GetLen();
+	tTVPGraphicHandlerType * handler = TVPSearchGraphicHandler(name);
+
 
 	tTVPStreamHolder holder(name); // open a storage named "name"
 
@@ -1751,6 +1762,244 @@ void TVPLoadGraphic(tTVPBaseBitmap *dest, const ttstr &name, tjs_int32 keyidx,
 
 
 
+//---------------------------------------------------------------------------
+// TVPLoadGraphicRegion
+//---------------------------------------------------------------------------
+struct tTVPLoadGraphicRegionData
+{
+	tTVPBaseBitmap *Dest;
+	tjs_int ColorKey;
+	const tTVPRect *SrcRect; // in the original size; NULL for whole image
+	tjs_int ScaleNum; // reduction done by the loading handler
+	tjs_int ScaleDenom;
+	tjs_uint DstW;
+	tjs_uint DstH;
+	tjs_int Left; // region in the decoded size
+	tjs_int Top;
+	tjs_int Right;
+	tjs_int Bottom;
+	tjs_int ScanLineNum;
+	tjs_int RemainingRows; // region lines not yet received
+	tjs_uint DstY; // destination line being accumulated
+	tjs_int AccumRows;
+	std::vector<tjs_uint32> Lines[2]; // alternately used for decoding
+	std::vector<tjs_uint64> Accum; // B, G, R, A sums per destination pixel
+	std::vector<tjs_int> Columns; // source column boundaries
+	std::vector<tTVPGraphicMetaInfoPair> * MetaInfo;
+};
+//---------------------------------------------------------------------------
+static void TVPLoadGraphicRegion_SizeCallback(void *callbackdata, tjs_uint w,
+	tjs_uint h)
+{
+	tTVPLoadGraphicRegionData * data = (tTVPLoadGraphicRegionData *)callbackdata;
+
+	// map the region to the decoded size and clip it
+	tjs_int64 num = data->ScaleNum, denom = data->ScaleDenom;
+	tjs_int64 l = 0, t = 0, r = w, b = h;
+	if(data->SrcRect)
+	{
+		l = data->SrcRect->left * num / denom;
+		t = data->SrcRect->top * num / denom;
+		r = (data->SrcRect->right * num + denom - 1) / denom;
+		b = (data->SrcRect->bottom * num + denom - 1) / denom;
+		if(l < 0) l = 0;
+		if(t < 0) t = 0;
+		if(r > (tjs_int64)w) r = w;
+		if(b > (tjs_int64)h) b = h;
+	}
+	if(l >= r || t >= b) TVPThrowExceptionMessage(TVPSrcRectOutOfBitmap);
+	data->Left = (tjs_int)l;
+	data->Top = (tjs_int)t;
+	data->Right = (tjs_int)r;
+	data->Bottom = (tjs_int)b;
+
+	// only reduction is supported
+	tjs_uint rw = data->Right - data->Left;
+	tjs_uint rh = data->Bottom - data->Top;
+	if(!data->DstW || data->DstW > rw) data->DstW = rw;
+	if(!data->DstH || data->DstH > rh) data->DstH = rh;
+
+	data->Dest->Recreate(data->DstW, data->DstH, 32);
+
+	// prepare buffers
+	data->Lines[0].resize(w);
+	data->Lines[1].resize(w);
+	data->Accum.assign(data->DstW * 4, 0);
+	data->Columns.resize(data->DstW + 1);
+	for(tjs_uint x = 0; x <= data->DstW; x++)
+		data->Columns[x] = data->Left + (tjs_int)((tjs_uint64)x * rw / data->DstW);
+	data->RemainingRows = rh;
+	data->DstY = 0;
+	data->AccumRows = 0;
+}
+//---------------------------------------------------------------------------
+static void TVPLoadGraphicRegion_FlushRow(tTVPLoadGraphicRegionData * data)
+{
+	// write averaged pixels of the accumulated source rows
+	tjs_uint32 * dest = (tjs_uint32*)data->Dest->GetScanLineForWrite(data->DstY);
+	tjs_uint64 * acc = &data->Accum[0];
+	for(tjs_uint x = 0; x < data->DstW; x++, acc += 4)
+	{
+		tjs_uint64 n = (tjs_uint64)(data->Columns[x+1] - data->Columns[x]) *
+			data->AccumRows;
+		tjs_uint64 half = n >> 1;
+		dest[x] =
+			 (tjs_uint32)((acc[0] + half) / n) +
+			((tjs_uint32)((acc[1] + half) / n) << 8) +
+			((tjs_uint32)((acc[2] + half) / n) << 16) +
+			((tjs_uint32)((acc[3] + half) / n) << 24);
+		acc[0] = acc[1] = acc[2] = acc[3] = 0;
+	}
+	data->AccumRows = 0;
+}
+//---------------------------------------------------------------------------
+static void * TVPLoadGraphicRegion_ScanLineCallback(void *callbackdata, tjs_int y)
+{
+	tTVPLoadGraphicRegionData * data = (tTVPLoadGraphicRegionData *)callbackdata;
+
+	if(y >= 0)
+	{
+		// query of line buffer.
+		// once all lines of the region are received, stop the decoding.
+		// two buffers are used alternately since some decoders refer to
+		// the previous line.
+		if(data->RemainingRows == 0) return NULL;
+		data->ScanLineNum = y;
+		return &data->Lines[y & 1][0];
+	}
+
+	// y==-1 indicates the buffer previously returned was written
+	y = data->ScanLineNum;
+	if(y < data->Top || y >= data->Bottom) return NULL;
+	data->RemainingRows --;
+
+	tjs_uint32 * sl = &data->Lines[y & 1][0] + data->Left;
+	tjs_uint rw = data->Right - data->Left;
+	tjs_uint rh = data->Bottom - data->Top;
+	if((data->ColorKey & 0xff000000) == 0x00000000)
+	{
+		// make alpha from color key
+		TVPMakeAlphaFromKey(sl, rw, data->ColorKey);
+	}
+
+	if(data->DstW == rw && data->DstH == rh)
+	{
+		// not reduced
+		memcpy(data->Dest->GetScanLineForWrite(y - data->Top), sl,
+			rw * sizeof(tjs_uint32));
+		return NULL;
+	}
+
+	// lines are given from the top or from the bottom ( BMP ); the
+	// destination line is computed from y to accept both order.
+	tjs_uint yy = y - data->Top;
+	tjs_uint dy = (tjs_uint)(((tjs_uint64)(yy + 1) * data->DstH + rh - 1) / rh) - 1;
+	if(data->AccumRows && dy != data->DstY)
+		TVPLoadGraphicRegion_FlushRow(data); // should not happen
+	data->DstY = dy;
+
+	// accumulate the line
+	const tjs_uint8 * src = (const tjs_uint8 *)&data->Lines[y & 1][0];
+	tjs_uint64 * acc = &data->Accum[0];
+	for(tjs_uint x = 0; x < data->DstW; x++, acc += 4)
+	{
+		for(tjs_int sx = data->Columns[x]; sx < data->Columns[x+1]; sx++)
+		{
+			const tjs_uint8 * p = src + sx * 4;
+			acc[0] += p[0];
+			acc[1] += p[1];
+			acc[2] += p[2];
+			acc[3] += p[3];
+		}
+	}
+	data->AccumRows ++;
+
+	// flush when all source lines of the destination line are accumulated
+	tjs_int first = (tjs_int)((tjs_uint64)dy * rh / data->DstH);
+	tjs_int next = (tjs_int)((tjs_uint64)(dy + 1) * rh / data->DstH);
+	if(data->AccumRows == next - first)
+		TVPLoadGraphicRegion_FlushRow(data);
+
+	return NULL;
+}
+//---------------------------------------------------------------------------
+static void TVPLoadGraphicRegion_MetaInfoPushCallback(void *callbackdata,
+	const ttstr & name, const ttstr & value)
+{
+	tTVPLoadGraphicRegionData * data = (tTVPLoadGraphicRegionData *)callbackdata;
+
+	if(!data->MetaInfo) data->MetaInfo = new std::vector<tTVPGraphicMetaInfoPair>();
+	data->MetaInfo->push_back(tTVPGraphicMetaInfoPair(name, value));
+}
+//---------------------------------------------------------------------------
+void TVPLoadGraphicRegion(tTVPBaseBitmap *dest, const ttstr &name,
+	tjs_int keyidx, const tTVPRect *srcrect, tjs_uint dstw, tjs_uint dsth,
+	iTJSDispatch2 ** metainfo)
+{
+	// loading a part of the image, or a reduced image, without decoding
+	// the whole image into a full size bitmap. ( e.g. thumbnails )
+	ttstr nname = TVPNormalizeStorageName(name);
+	tTVPGraphicHandlerType * handler = TVPSearchGraphicHandler(nname);
+
+	tTVPStreamHolder holder(nname); // open a storage named "nname"
+
+	tTVPLoadGraphicRegionData data;
+	data.Dest = dest;
+	data.ColorKey = keyidx;
+	data.SrcRect = srcrect;
+	data.ScaleNum = 1;
+	data.ScaleDenom = 1;
+	data.DstW = dstw;
+	data.DstH = dsth;
+	data.ScanLineNum = 0;
+	data.MetaInfo = NULL;
+
+	bool keyadapt = (keyidx == TVP_clAdapt);
+	bool doalphacolormat = TVP_Is_clAlphaMat(keyidx);
+	tjs_uint32 alphamatcolor = TVP_get_clAlphaMat(keyidx);
+
+	if(TVP_Is_clPalIdx(keyidx))
+		keyidx = TVP_get_clPalIdx(keyidx);
+	else
+		keyidx = -1;
+
+	try
+	{
+		if(!handler->IsPlugin && handler->LoadHandler == TVPLoadJPEG)
+		{
+			// JPEG can be reduced in its IDCT
+			tjs_uint regw = srcrect ? srcrect->right - srcrect->left : 0;
+			tjs_uint regh = srcrect ? srcrect->bottom - srcrect->top : 0;
+			TVPLoadJPEGReduced((void*)&data, TVPLoadGraphicRegion_SizeCallback,
+				TVPLoadGraphicRegion_ScanLineCallback, holder.Get(), glmNormal,
+				regw, regh, dstw, dsth, &data.ScaleNum, &data.ScaleDenom);
+		}
+		else
+		{
+			handler->Load(handler->FormatData, (void*)&data,
+				TVPLoadGraphicRegion_SizeCallback,
+				TVPLoadGraphicRegion_ScanLineCallback,
+				TVPLoadGraphicRegion_MetaInfoPushCallback,
+				holder.Get(), keyidx, glmNormal);
+		}
+
+		if(keyadapt) TVPMakeAlphaFromAdaptiveColor(dest);
+		if(doalphacolormat) TVPDoAlphaColorMat(dest, alphamatcolor);
+
+		if(metainfo) *metainfo = TVPMetaInfoPairsToDictionary(data.MetaInfo);
+	}
+	catch(...)
+	{
+		if(data.MetaInfo) delete data.MetaInfo;
+		throw;
+	}
+
+	if(data.MetaInfo) delete data.MetaInfo;
+}
+//---------------------------------------------------------------------------
+
+
+
 //---------------------------------------------------------------------------
 // TVPTouchImages
 //---------------------------------------------------------------------------
@@ -16,6 +16,7 @@
 #include "drawable.h"
 
 class tTVPBaseBitmap;
+struct tTVPRect;
 class TJS::tTJSBinaryStream;
 
 
@@ -221,6 +222,27 @@ enum tTVPJPEGLoadPrecision
 };
 
 extern tTVPJPEGLoadPrecision TVPJPEGLoadPrecision;
+extern bool TVPJPEGParallelDecode;
+	// decode JPEG with restart markers in bands on the draw threads.
+	// effective only when TVPGetThreadNum() > 1.
+
+extern void TVPLoadJPEGReduced(void *callbackdata, tTVPGraphicSizeCallback sizecallback,
+	tTVPGraphicScanLineCallback scanlinecallback, tTJSBinaryStream *src,
+	tTVPGraphicLoadMode mode, tjs_uint regw, tjs_uint regh, tjs_uint dstw, tjs_uint dsth,
+	tjs_int *scalenum, tjs_int *scaledenom);
+	// load JPEG reduced by the IDCT so that a regw x regh region of the
+	// original image still covers dstw x dsth. the chosen factor is stored
+	// to scalenum/scaledenom before sizecallback is called with the reduced
+	// size. give zero to load in the original size.
+//---------------------------------------------------------------------------
+
+
+//---------------------------------------------------------------------------
+// TLG loading handler
+//---------------------------------------------------------------------------
+extern bool TVPTLG6ParallelDecode;
+	// decode TLG6 golomb values on the draw threads while the lines are
+	// being reconstructed. effective only when TVPGetThreadNum() > 1.
 //---------------------------------------------------------------------------
 
 
@@ -262,6 +284,16 @@ extern void TVPLoadGraphic(tTVPBaseBitmap *dest, const ttstr &name, tjs_int keyi
 	tjs_uint desw, tjs_uint desh,
 	tTVPGraphicLoadMode mode, ttstr *provincename = NULL, iTJSDispatch2 ** metainfo = NULL);
 	// throws exception when this function can not handle the file
+
+extern void TVPLoadGraphicRegion(tTVPBaseBitmap *dest, const ttstr &name,
+	tjs_int keyidx, const tTVPRect *srcrect, tjs_uint dstw, tjs_uint dsth,
+	iTJSDispatch2 ** metainfo = NULL);
+	// load only the region "srcrect" of the image ( whole image if NULL ),
+	// clipped to the image edges; throws when no pixel remains. reduced to
+	// dstw x dsth by box filtering. zero for dstw/dsth means the region
+	// size; only reduction is supported. decoding stops after the last line
+	// of the region, and JPEG is reduced in its IDCT.
+	// the graphic cache and the mask ( _m ) image are not used.
 //---------------------------------------------------------------------------
 
 
@@ -277,9 +309,7 @@ extern void TVPLoadGraphic(tTVPBaseBitmap *dest, const ttstr &name, tjs_int keyi
 	#define BI_BITFIELDS	3
 #endif
 
-#ifdef __WIN32__
-#pragma pack(push, 1)
-#endif
+#pragma pack(push, 1) // the BMP saver writes the sizes of these
 struct TVP_WIN_BITMAPFILEHEADER
 {
 	tjs_uint16	bfType;
@@ -302,9 +332,7 @@ struct TVP_WIN_BITMAPINFOHEADER
 	tjs_uint32	biClrUsed;
 	tjs_uint32	biClrImportant;
 };
-#ifdef __WIN32__
 #pragma pack(pop)
-#endif
 
 enum tTVPBMPAlphaType
 {
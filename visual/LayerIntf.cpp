@@ -34,6 +34,7 @@
 #include "RectItf.h"
 #include "FontSystem.h"
 #include "tjsDictionary.h"
+#include "tjsTypedArray.h"
 
 extern void TVPSetFontRasterizer( tjs_int index );
 extern tjs_int TVPGetFontRasterizer();
@@ -6703,6 +6704,33 @@ tjs_uint64 tTJSNI_BaseLayer::GetTransTick()
 
 
 
+//---------------------------------------------------------------------------
+// tTVPLayerTypedArraySource : lets typed arrays view the main image of layers
+//---------------------------------------------------------------------------
+class tTVPLayerTypedArraySource : public iTJSTypedArrayBufferSource
+{
+public:
+	bool GetBuffer(iTJSDispatch2 *obj, bool forwrite,
+		tTJSTypedArrayBuffer &buffer)
+	{
+		tTJSNI_Layer *lay = NULL;
+		if(TJS_FAILED(obj->NativeInstanceSupport(TJS_NIS_GETINSTANCE,
+			tTJSNC_Layer::ClassID, (iTJSNativeInstance**)&lay)))
+			return false;
+		buffer.Data = forwrite ? lay->GetMainImagePixelBufferForWrite() :
+			const_cast<void*>(lay->GetMainImagePixelBuffer());
+		if(!buffer.Data) return true; // the layer has no image
+		buffer.RowBytes = lay->GetImageWidth() * sizeof(tjs_uint32);
+		buffer.Pitch = lay->GetMainImagePixelBufferPitch();
+		buffer.Rows = lay->GetImageHeight();
+		return true;
+	}
+} static TVPLayerTypedArraySource;
+//---------------------------------------------------------------------------
+
+
+
+
 //---------------------------------------------------------------------------
 // tTJSNC_Layer : TJS Layer class
 //---------------------------------------------------------------------------
@@ -9596,6 +9624,7 @@ TJS_END_NATIVE_PROP_DECL(provinceImageBufferPitch)
 //----------------------------------------------------------------------
 	TJS_END_NATIVE_MEMBERS
 
+	TJSAddTypedArrayBufferSource(&TVPLayerTypedArraySource);
 
 }
 //---------------------------------------------------------------------------
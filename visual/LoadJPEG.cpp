@@ -9,6 +9,9 @@
 
 #include "tjsDictionary.h"
 #include "ScriptMgnIntf.h"
+#include "ThreadIntf.h"
+
+#include <vector>
 
 bool TVPAcceptSaveAsJPG(void* formatdata, const ttstr & type, class iTJSDispatch2** dic )
 {
@@ -51,6 +54,7 @@ extern "C"
 // JPEG loading handler
 //---------------------------------------------------------------------------
 tTVPJPEGLoadPrecision TVPJPEGLoadPrecision = jlpMedium;
+bool TVPJPEGParallelDecode = true;
 //---------------------------------------------------------------------------
 struct my_error_mgr
 {
@@ -180,9 +184,284 @@ jpeg_TStream_src (j_decompress_ptr cinfo, tTJSBinaryStream * infile)
   src->pub.next_input_byte = NULL; /* until buffer loaded */
 }
 //---------------------------------------------------------------------------
-void TVPLoadJPEG(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback sizecallback,
-	tTVPGraphicScanLineCallback scanlinecallback, tTVPMetaInfoPushCallback metainfopushcallback,
-	tTJSBinaryStream *src, tjs_int keyidx,  tTVPGraphicLoadMode mode)
+#ifdef TVP_USE_TURBO_JPEG_API
+static void TVPChooseJPEGScalingFactor(tjs_uint regw, tjs_uint regh,
+	tjs_uint dstw, tjs_uint dsth, tjs_int *scalenum, tjs_int *scaledenom)
+{
+	// choose the smallest scaling factor of the IDCT which still keeps the
+	// region (regw x regh, in the original size) not smaller than
+	// dstw x dsth. the rest of the reduction is done by the caller.
+	*scalenum = 1;
+	*scaledenom = 1;
+	if(!dstw || !dsth || !regw || !regh) return;
+
+	int count = 0;
+	tjscalingfactor *factors = tjGetScalingFactors(&count);
+	if(!factors) return;
+	for(int i = 0; i < count; i++)
+	{
+		tjs_int num = factors[i].num;
+		tjs_int denom = factors[i].denom;
+		if(num > denom) continue; // enlargement
+		if((tjs_uint64)regw * num < (tjs_uint64)dstw * denom) continue;
+		if((tjs_uint64)regh * num < (tjs_uint64)dsth * denom) continue;
+		if((tjs_uint64)num * *scaledenom < (tjs_uint64)*scalenum * denom)
+		{
+			*scalenum = num;
+			*scaledenom = denom;
+		}
+	}
+}
+//---------------------------------------------------------------------------
+// parallel decoding of JPEG with restart markers
+//---------------------------------------------------------------------------
+// a baseline JPEG whose restart interval is a multiple of the MCU row can be
+// split into bands at restart markers; each band is rebuilt as an
+// independent JPEG ( the original header with patched height, the entropy
+// data of the band's intervals with renumbered RST markers, and EOI ) and
+// decoded by its own TurboJPEG instance on the draw threads.
+// each band is decoded with one extra interval above and below, so that the
+// upsampling near the band boundary sees the same context as the whole
+// image decoding; the extra lines are discarded.
+struct tTVPJPEGRestartLayout
+{
+	tjs_uint HeaderSize; // up to the end of SOS segment
+	tjs_uint SOFHeightPos; // position of the image height in SOF
+	tjs_int IntervalLines; // pixel lines per restart interval
+	std::vector<tjs_uint> IntervalStart; // entropy data of each interval
+	std::vector<tjs_uint> IntervalEnd;
+};
+//---------------------------------------------------------------------------
+static bool TVPParseJPEGRestartLayout(const tjs_uint8 *buf, tjs_uint size,
+	tTVPJPEGRestartLayout &layout)
+{
+	// returns false if the JPEG can not be split
+	if(size < 4 || buf[0] != 0xff || buf[1] != 0xd8) return false;
+
+	tjs_uint pos = 2;
+	tjs_int width = 0, height = 0, components = 0;
+	tjs_int mcuw = 0, mcuh = 0;
+	tjs_int restart = 0;
+	bool sof = false;
+	for(;;)
+	{
+		if(pos + 4 > size || buf[pos] != 0xff) return false;
+		tjs_uint8 marker = buf[pos + 1];
+		if(marker == 0xff) { pos++; continue; } // fill byte
+		if(marker == 0x01 || (marker >= 0xd0 && marker <= 0xd8)) { pos += 2; continue; }
+
+		tjs_uint len = (buf[pos + 2] << 8) + buf[pos + 3];
+		if(len < 2 || pos + 2 + len > size) return false;
+		const tjs_uint8 *seg = buf + pos + 4;
+		tjs_uint seglen = len - 2;
+
+		if(marker == 0xc0 || marker == 0xc1)
+		{
+			// baseline or extended sequential, huffman
+			if(seglen < 6) return false;
+			height = (seg[1] << 8) + seg[2];
+			width = (seg[3] << 8) + seg[4];
+			components = seg[5];
+			if(!width || !height || !components) return false; // DNL is not supported
+			if(seglen < 6 + (tjs_uint)components * 3) return false;
+			tjs_int maxh = 1, maxv = 1;
+			for(tjs_int c = 0; c < components; c++)
+			{
+				tjs_int h = seg[6 + c*3 + 1] >> 4;
+				tjs_int v = seg[6 + c*3 + 1] & 0x0f;
+				if(h > maxh) maxh = h;
+				if(v > maxv) maxv = v;
+			}
+			mcuw = maxh * 8;
+			mcuh = maxv * 8;
+			layout.SOFHeightPos = pos + 5;
+			sof = true;
+		}
+		else if(marker >= 0xc2 && marker <= 0xcf &&
+			marker != 0xc4 && marker != 0xc8 && marker != 0xcc)
+		{
+			return false; // progressive, lossless or arithmetic coding
+		}
+		else if(marker == 0xdd)
+		{
+			// DRI
+			if(seglen < 2) return false;
+			restart = (seg[0] << 8) + seg[1];
+		}
+		else if(marker == 0xda)
+		{
+			// SOS; only one interleaved scan is supported
+			if(!sof || !restart || seglen < 1 || seg[0] != components) return false;
+			pos += 2 + len;
+			break;
+		}
+		else if(marker == 0xd9)
+		{
+			return false;
+		}
+		pos += 2 + len;
+	}
+	layout.HeaderSize = pos;
+
+	tjs_int mcus_per_row = (width + mcuw - 1) / mcuw;
+	if(restart % mcus_per_row) return false;
+	layout.IntervalLines = restart / mcus_per_row * mcuh;
+
+	// find RST markers in the entropy coded data
+	tjs_uint start = pos;
+	bool ended = false;
+	while(pos + 1 < size)
+	{
+		if(buf[pos] != 0xff) { pos++; continue; }
+		tjs_uint8 marker = buf[pos + 1];
+		if(marker == 0x00) { pos += 2; continue; } // stuffed zero
+		if(marker == 0xff) { pos++; continue; } // fill byte
+		layout.IntervalStart.push_back(start);
+		layout.IntervalEnd.push_back(pos);
+		if(marker >= 0xd0 && marker <= 0xd7)
+		{
+			pos += 2;
+			start = pos;
+			continue;
+		}
+		if(marker != 0xd9) return false; // another scan or DNL
+		ended = true;
+		break;
+	}
+	if(!ended) return false;
+
+	tjs_int intervals = (height + layout.IntervalLines - 1) / layout.IntervalLines;
+	return intervals == (tjs_int)layout.IntervalStart.size();
+}
+//---------------------------------------------------------------------------
+struct tTVPJPEGBandTask
+{
+	const tjs_uint8 *JPEG;
+	const tTVPJPEGRestartLayout *Layout;
+	tjs_int Width;
+	tjs_int Height;
+	tjs_int First; // first interval of the band
+	tjs_int Last; // last interval of the band + 1
+	int PixelFormat;
+	tjs_int NumColor;
+	int Flags;
+	tjs_uint8 *Dest; // output buffer of the whole image
+	bool Failed;
+};
+//---------------------------------------------------------------------------
+static void TVPDecodeJPEGBand(tTVPJPEGBandTask &task)
+{
+	const tTVPJPEGRestartLayout &layout = *task.Layout;
+	tjs_int count = (tjs_int)layout.IntervalStart.size();
+
+	// intervals to decode, with one extra interval at each side
+	tjs_int first = task.First > 0 ? task.First - 1 : 0;
+	tjs_int last = task.Last < count ? task.Last + 1 : count;
+	tjs_int top = first * layout.IntervalLines;
+	tjs_int bottom = last * layout.IntervalLines;
+	if(bottom > task.Height) bottom = task.Height;
+	tjs_int keeptop = task.First * layout.IntervalLines;
+	tjs_int keepbottom = task.Last * layout.IntervalLines;
+	if(keepbottom > task.Height) keepbottom = task.Height;
+
+	// rebuild the band as a JPEG
+	std::vector<tjs_uint8> band(task.JPEG, task.JPEG + layout.HeaderSize);
+	band[layout.SOFHeightPos] = (tjs_uint8)((bottom - top) >> 8);
+	band[layout.SOFHeightPos + 1] = (tjs_uint8)(bottom - top);
+	for(tjs_int i = first; i < last; i++)
+	{
+		if(i != first)
+		{
+			band.push_back(0xff);
+			band.push_back((tjs_uint8)(0xd0 + ((i - first - 1) & 7)));
+		}
+		band.insert(band.end(), task.JPEG + layout.IntervalStart[i],
+			task.JPEG + layout.IntervalEnd[i]);
+	}
+	band.push_back(0xff);
+	band.push_back(0xd9);
+
+	// decode and copy the lines of the band
+	tjs_int pitch = task.Width * task.NumColor;
+	tjhandle handle = tjInitDecompress();
+	if(!handle) { task.Failed = true; return; }
+	unsigned char *buffer = tjAlloc(pitch * (bottom - top));
+	if(buffer && tjDecompress2(handle, &band[0], (unsigned long)band.size(), buffer,
+		task.Width, pitch, bottom - top, task.PixelFormat, task.Flags) == 0)
+	{
+		memcpy(task.Dest + keeptop * pitch, buffer + (keeptop - top) * pitch,
+			(keepbottom - keeptop) * pitch);
+	}
+	else
+	{
+		task.Failed = true;
+	}
+	if(buffer) tjFree(buffer);
+	tjDestroy(handle);
+}
+//---------------------------------------------------------------------------
+static void TJS_USERENTRY TVPJPEGBandTaskEntry(void *v)
+{
+	tTVPJPEGBandTask *task = (tTVPJPEGBandTask *)v;
+	try
+	{
+		TVPDecodeJPEGBand(*task);
+	}
+	catch(...)
+	{
+		task->Failed = true;
+	}
+}
+//---------------------------------------------------------------------------
+static bool TVPDecodeJPEGParallel(const tjs_uint8 *jpeg, tjs_uint size,
+	tjs_uint8 *dest, tjs_int width, tjs_int height, int pixelformat,
+	tjs_int numcolor, int flags)
+{
+	// returns false if the image is not decoded; the caller decodes it
+	// in the normal way.
+	tjs_int threads = TVPGetThreadNum();
+	if(!TVPJPEGParallelDecode || threads < 2 || width * height < 256 * 256)
+		return false;
+
+	tTVPJPEGRestartLayout layout;
+	if(!TVPParseJPEGRestartLayout(jpeg, size, layout)) return false;
+
+	tjs_int count = (tjs_int)layout.IntervalStart.size();
+	tjs_int bands = threads < count ? threads : count;
+	if(bands < 2) return false;
+
+	std::vector<tTVPJPEGBandTask> tasks(bands);
+	for(tjs_int i = 0; i < bands; i++)
+	{
+		tTVPJPEGBandTask &task = tasks[i];
+		task.JPEG = jpeg;
+		task.Layout = &layout;
+		task.Width = width;
+		task.Height = height;
+		task.First = count * i / bands;
+		task.Last = count * (i + 1) / bands;
+		task.PixelFormat = pixelformat;
+		task.NumColor = numcolor;
+		task.Flags = flags;
+		task.Dest = dest;
+		task.Failed = false;
+	}
+
+	if(!TVPTryBeginThreadTask(bands)) return false; // the thread pool is busy
+	for(tjs_int i = 0; i < bands; i++)
+		TVPExecThreadTask(&TVPJPEGBandTaskEntry, TVP_THREAD_PARAM(&tasks[i]));
+	TVPEndThreadTask();
+
+	for(tjs_int i = 0; i < bands; i++)
+		if(tasks[i].Failed) return false;
+	return true;
+}
+//---------------------------------------------------------------------------
+#endif
+void TVPLoadJPEGReduced(void *callbackdata, tTVPGraphicSizeCallback sizecallback,
+	tTVPGraphicScanLineCallback scanlinecallback, tTJSBinaryStream *src,
+	tTVPGraphicLoadMode mode, tjs_uint regw, tjs_uint regh, tjs_uint dstw, tjs_uint dsth,
+	tjs_int *scalenum, tjs_int *scaledenom)
 {
 #ifdef TVP_USE_TURBO_JPEG_API
 	// JPEG does not support palettized image
@@ -201,6 +480,17 @@ void TVPLoadJPEG(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback s
 	int jpegSubsamp, width, height;
 	tjhandle jpegDecompressor = tjInitDecompress();
 	tjDecompressHeader2( jpegDecompressor, jpegBuf, jpegSize, &width, &height, &jpegSubsamp );
+
+	// reduce in the IDCT when a smaller image is requested
+	if(!regw) regw = width;
+	if(!regh) regh = height;
+	TVPChooseJPEGScalingFactor(regw, regh, dstw, dsth, scalenum, scaledenom);
+	tjscalingfactor factor;
+	factor.num = *scalenum;
+	factor.denom = *scaledenom;
+	width = TJSCALED(width, factor);
+	height = TJSCALED(height, factor);
+
 	sizecallback(callbackdata, width, height);
 
 	// decompress option
@@ -228,7 +518,11 @@ void TVPLoadJPEG(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback s
 	unsigned char *buffer = NULL;
 	try {
 		buffer = tjAlloc(width*height*numcolor);
-		tjDecompress2( jpegDecompressor, jpegBuf, jpegSize, buffer, width, width*numcolor, height, pixelFormat, flags );
+		// decode bands on the draw threads if possible
+		if(factor.num != factor.denom ||
+			!TVPDecodeJPEGParallel(jpegBuf, jpegSize, buffer, width, height,
+				pixelFormat, numcolor, flags))
+			tjDecompress2( jpegDecompressor, jpegBuf, jpegSize, buffer, width, width*numcolor, height, pixelFormat, flags );
 		if(mode == glmGrayscale) {
 			for( int y = 0; y < height; y++ ) {
 				void *scanline = scanlinecallback(callbackdata, y);
@@ -258,6 +552,9 @@ void TVPLoadJPEG(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback s
 	tjDestroy( jpegDecompressor );
 #else
 	// JPEG loading handler
+	// ( no reduction in this path )
+	*scalenum = 1;
+	*scaledenom = 1;
 
 	// JPEG does not support palettized image
 	if(mode == glmPalettized)
@@ -389,6 +686,15 @@ void TVPLoadJPEG(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback s
 #endif
 }
 //---------------------------------------------------------------------------
+void TVPLoadJPEG(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback sizecallback,
+	tTVPGraphicScanLineCallback scanlinecallback, tTVPMetaInfoPushCallback metainfopushcallback,
+	tTJSBinaryStream *src, tjs_int keyidx,  tTVPGraphicLoadMode mode)
+{
+	tjs_int scalenum, scaledenom;
+	TVPLoadJPEGReduced(callbackdata, sizecallback, scanlinecallback, src, mode,
+		0, 0, 0, 0, &scalenum, &scaledenom);
+}
+//---------------------------------------------------------------------------
 struct stream_destination_mgr {
 	struct jpeg_destination_mgr	pub;		/* public fields */
 	tTJSBinaryStream*			stream;
@@ -474,7 +780,7 @@ void TVPSaveAsJPG(void* formatdata, tTJSBinaryStream* dst, const tTVPBaseBitmap*
 		if( opt.quality > 100 ) opt.quality = 100;
 	}
 
-	{
+	if( meta ) {
 		// EnumCallback を使ってプロパティを設定する
 		struct MetaDictionaryEnumCallback : public tTJSDispatch {
 			tTVPJPGOption *opt_;
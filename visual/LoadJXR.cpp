@@ -111,6 +111,7 @@ void TVPLoadJXR(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback si
 				int offset = 0;
 				for( UINT i = 0; i < height; i++) {
 					void *scanline = scanlinecallback(callbackdata, i);
+					if(!scanline) break;
 					memcpy( scanline, &buff[offset], width*sizeof(tjs_uint32));
 					offset += stride;
 					scanlinecallback(callbackdata, -1);
@@ -540,6 +541,7 @@ void TVPLoadJXR(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback si
 				pDecoder->Copy( pDecoder, &rect, (U8*)&buff[0], stride );
 				for( int i = 0; i < height; i++) {
 					void *scanline = scanlinecallback(callbackdata, i);
+					if(!scanline) break;
 					tjs_uint8* d = (tjs_uint8*)scanline;
 					tjs_uint8* s = (tjs_uint8*)&buff[offset];
 					for( int x = 0; x < width; x++ ) {
@@ -567,6 +569,7 @@ void TVPLoadJXR(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback si
 			pDecoder->Copy( pDecoder, &rect, (U8*)&buff[0], stride );
 			for( int i = 0; i < height; i++) {
 				void *scanline = scanlinecallback(callbackdata, i);
+				if(!scanline) break;
 				memcpy( scanline, &buff[offset], width*sizeof(tjs_uint32));
 				offset += stride;
 				scanlinecallback(callbackdata, -1);
@@ -251,6 +251,10 @@ void TVPLoadPNG(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback si
 
 
 		bool do_convert_rgb_gray = false;
+		tjs_int convert_rgb_bits = 0;
+			// 24 or 32 when the rows are read in PNG's RGB(A) byte order and
+			// converted to ARGB by TVPConvertRGB(A)xxBitTo32Bit afterwards.
+			// this is faster than libpng's bgr/filler transformations.
 
 		if(mode == glmPalettized)
 		{
@@ -334,11 +338,10 @@ void TVPLoadPNG(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback si
 				png_set_filler(png_ptr, 0xff, PNG_FILLER_AFTER);
 				break;
 			case PNG_COLOR_TYPE_RGB_ALPHA:
-				png_set_bgr(png_ptr);
+				convert_rgb_bits = 32;
 				break;
 			case PNG_COLOR_TYPE_RGB:
-				png_set_bgr(png_ptr);
-				png_set_filler(png_ptr, 0xff, PNG_FILLER_AFTER);
+				convert_rgb_bits = 24;
 				break;
 			default:
 				TVPThrowExceptionMessage(
@@ -371,46 +374,48 @@ void TVPLoadPNG(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback si
 				png_size_t rowbytes = png_get_rowbytes(png_ptr, info_ptr);
 				image = new tjs_uint8[rowbytes];
 			}
-#if 1
-			if( !do_convert_rgb_gray ) {
+			if( convert_rgb_bits == 32 ) {
+				// read directly into the scanline and swizzle in place
 				for(i=0; i<height; i++) {
 					void *scanline = scanlinecallback(callbackdata, i);
 					if(!scanline) break;
 					png_read_row(png_ptr, (png_bytep)scanline, NULL);
+					TVPConvertRGBA32BitTo32Bit((tjs_uint32*)scanline,
+						(const tjs_uint8*)scanline, width);
 					scanlinecallback(callbackdata, -1);
 				}
-			} else {
+			} else if( convert_rgb_bits == 24 ) {
+				// read into the last 3/4 of the scanline and expand forward
 				for(i=0; i<height; i++) {
 					void *scanline = scanlinecallback(callbackdata, i);
 					if(!scanline) break;
-					png_read_row(png_ptr, (png_bytep)image, NULL);
-					TVPBLConvert24BitTo8Bit(
-						(tjs_uint8*)scanline,
-						(tjs_uint8*)image, width);
+					png_read_row(png_ptr, (png_bytep)scanline + width, NULL);
+					TVPConvertRGB24BitTo32Bit((tjs_uint32*)scanline,
+						(const tjs_uint8*)scanline + width, width);
 					scanlinecallback(callbackdata, -1);
 				}
-			}
-#else
-			for(i=0; i<height; i++)
-			{
-				void *scanline = scanlinecallback(callbackdata, i);
-				if(!scanline) break;
-				if(!do_convert_rgb_gray)
-				{
+			} else if( !do_convert_rgb_gray ) {
+				for(i=0; i<height; i++) {
+					void *scanline = scanlinecallback(callbackdata, i);
+					if(!scanline) break;
 					png_read_row(png_ptr, (png_bytep)scanline, NULL);
+					scanlinecallback(callbackdata, -1);
 				}
-				else
-				{
+			} else {
+				for(i=0; i<height; i++) {
+					void *scanline = scanlinecallback(callbackdata, i);
+					if(!scanline) break;
 					png_read_row(png_ptr, (png_bytep)image, NULL);
 					TVPBLConvert24BitTo8Bit(
 						(tjs_uint8*)scanline,
 						(tjs_uint8*)image, width);
+					scanlinecallback(callbackdata, -1);
 				}
-				scanlinecallback(callbackdata, -1);
 			}
-#endif
 			// finish loading
-			png_read_end(png_ptr,info_ptr);
+			// ( skipped when the callback stopped the processing; the rest
+			// of the image data is left unread )
+			if(i == height) png_read_end(png_ptr,info_ptr);
 		}
 		else
 		{
@@ -436,7 +441,17 @@ void TVPLoadPNG(void* formatdata, void *callbackdata, tTVPGraphicSizeCallback si
 			{
 				void *scanline = scanlinecallback(callbackdata, i);
 				if(!scanline) break;
-				if(!do_convert_rgb_gray)
+				if(convert_rgb_bits == 32)
+				{
+					TVPConvertRGBA32BitTo32Bit((tjs_uint32*)scanline,
+						(const tjs_uint8*)row_pointers[i], width);
+				}
+				else if(convert_rgb_bits == 24)
+				{
+					TVPConvertRGB24BitTo32Bit((tjs_uint32*)scanline,
+						(const tjs_uint8*)row_pointers[i], width);
+				}
+				else if(!do_convert_rgb_gray)
 				{
 					memcpy(scanline, row_pointers[i], rowbytes);
 				}
@@ -15,6 +15,7 @@
 #include "tjsUtils.h"
 #include "tvpgl.h"
 #include "tjsDictionary.h"
+#include "ThreadIntf.h"
 
 #include <stdlib.h>
 
@@ -87,7 +88,8 @@ void TVPLoadTLG5(void* formatdata, void *callbackdata,
 			outbuf[i] = (tjs_uint8*)TJSAlignedAlloc(blockheight * width + 10+16, 4);
 
 		tjs_uint8 *prevline = NULL;
-		for(tjs_int y_blk = 0; y_blk < height; y_blk += blockheight)
+		bool stopped = false;
+		for(tjs_int y_blk = 0; y_blk < height && !stopped; y_blk += blockheight)
 		{
 			// read file and decompress
 			for(tjs_int c = 0; c < colors; c++)
@@ -116,6 +118,12 @@ void TVPLoadTLG5(void* formatdata, void *callbackdata,
 			for(tjs_int y = y_blk; y < y_lim; y++)
 			{
 				tjs_uint8 *current = (tjs_uint8*)scanlinecallback(callbackdata, y);
+				if(!current)
+				{
+					// the callback requested to stop the processing
+					stopped = true;
+					break;
+				}
 				tjs_uint8 *current_org = current;
 				if(prevline)
 				{
@@ -200,6 +208,257 @@ void TVPLoadTLG5(void* formatdata, void *callbackdata,
 //---------------------------------------------------------------------------
 
 
+//---------------------------------------------------------------------------
+// TLG6 decoding helpers
+//---------------------------------------------------------------------------
+bool TVPTLG6ParallelDecode = true;
+//---------------------------------------------------------------------------
+struct tTVPTLG6DecodeContext
+{
+	void *CallbackData;
+	tTVPGraphicScanLineCallback ScanLineCallback;
+	tjs_int Width;
+	tjs_int Height;
+	tjs_int Colors;
+	tjs_int XBlockCount;
+	tjs_int MainCount;
+	tjs_int Fraction;
+	tjs_uint8 *FilterTypes;
+	tjs_uint32 *PrevLine;
+};
+//---------------------------------------------------------------------------
+static void TVPTLG6DecodeGolombBlockRow(tjs_int colors, tjs_uint32 *pixelbuf,
+	tjs_int pixel_count, tjs_uint8 **bit_pools)
+{
+	// decode golomb values of all color components of one block row.
+	// this does not depend on any other block row.
+	for(tjs_int c = 0; c < colors; c++)
+	{
+		if(c == 0 && colors != 1)
+			TVPTLG6DecodeGolombValuesForFirst((tjs_int8*)pixelbuf,
+				pixel_count, bit_pools[c]);
+		else
+			TVPTLG6DecodeGolombValues((tjs_int8*)pixelbuf + c,
+				pixel_count, bit_pools[c]);
+	}
+}
+//---------------------------------------------------------------------------
+static bool TVPTLG6ComposeBlockRow(tTVPTLG6DecodeContext &ctx, tjs_int y,
+	tjs_uint32 *pixelbuf)
+{
+	// reconstruct the lines of the block row which begins at y, from the
+	// golomb-decoded values in pixelbuf. each line depends on the previous
+	// line, so block rows must be processed in order.
+	// returns false if the scanline callback requested to stop the processing.
+	tjs_int width = ctx.Width;
+	tjs_int ylim = y + TVP_TLG6_H_BLOCK_SIZE;
+	if(ylim >= ctx.Height) ylim = ctx.Height;
+
+	unsigned char * ft =
+		ctx.FilterTypes + (y / TVP_TLG6_H_BLOCK_SIZE)*ctx.XBlockCount;
+	int skipbytes = (ylim-y)*TVP_TLG6_W_BLOCK_SIZE;
+	tjs_uint32 initialp = ctx.Colors==3?0xff000000:0;
+
+	for(int yy = y; yy < ylim; yy++)
+	{
+		tjs_uint32* curline = (tjs_uint32*)ctx.ScanLineCallback(ctx.CallbackData, yy);
+		if(!curline) return false;
+
+		int dir = (yy&1)^1;
+		int oddskip = ((ylim - yy -1) - (yy-y));
+		if(ctx.MainCount)
+		{
+			int start =
+				((width < TVP_TLG6_W_BLOCK_SIZE) ? width : TVP_TLG6_W_BLOCK_SIZE) *
+					(yy - y);
+			TVPTLG6DecodeLine(
+				ctx.PrevLine,
+				curline,
+				width,
+				ctx.MainCount,
+				ft,
+				skipbytes,
+				pixelbuf + start, initialp, oddskip, dir);
+		}
+
+		if(ctx.MainCount != ctx.XBlockCount)
+		{
+			int ww = ctx.Fraction;
+			if(ww > TVP_TLG6_W_BLOCK_SIZE) ww = TVP_TLG6_W_BLOCK_SIZE;
+			int start = ww * (yy - y);
+			TVPTLG6DecodeLineGeneric(
+				ctx.PrevLine,
+				curline,
+				width,
+				ctx.MainCount,
+				ctx.XBlockCount,
+				ft,
+				skipbytes,
+				pixelbuf + start, initialp, oddskip, dir);
+		}
+
+		ctx.ScanLineCallback(ctx.CallbackData, -1);
+		ctx.PrevLine = curline;
+	}
+	return true;
+}
+//---------------------------------------------------------------------------
+static void TVPTLG6ReadBlockRow(tTJSBinaryStream *src, tjs_int colors,
+	tjs_uint8 **bit_pools)
+{
+	// read compressed golomb bits of all color components of one block row.
+	for(tjs_int c = 0; c < colors; c++)
+	{
+		// read bit length
+		tjs_int bit_length = src->ReadI32LE();
+
+		// get compress method
+		int method = (bit_length >> 30)&3;
+		bit_length &= 0x3fffffff;
+
+		// only the Golomb method is supported; see TVPLoadTLG6
+		if(method != 0)
+			TVPThrowExceptionMessage(TVPTLGLoadError, (const tjs_char*)TVPUnsupportedEntropyCodingMethod );
+
+		// compute byte length
+		tjs_int byte_length = bit_length / 8;
+		if(bit_length % 8) byte_length++;
+
+		// read source from input
+		src->ReadBuffer(bit_pools[c], byte_length);
+	}
+}
+//---------------------------------------------------------------------------
+struct tTVPTLG6GolombTask
+{
+	tjs_int Colors;
+	tjs_int PixelCount;
+	tjs_uint32 *PixelBuf;
+	tjs_uint8 *BitPools[4];
+};
+//---------------------------------------------------------------------------
+static void TJS_USERENTRY TVPTLG6GolombTaskEntry(void *v)
+{
+	tTVPTLG6GolombTask *task = (tTVPTLG6GolombTask *)v;
+	TVPTLG6DecodeGolombBlockRow(task->Colors, task->PixelBuf, task->PixelCount,
+		task->BitPools);
+}
+//---------------------------------------------------------------------------
+static void TVPTLG6DecodeBlockRowsParallel(tTVPTLG6DecodeContext &ctx,
+	tTJSBinaryStream *src, tjs_int max_bit_length, tjs_int workers)
+{
+	// parallel decoding of TLG6 pixel data.
+	// block rows are processed in batches of "workers" rows. while the
+	// worker threads decode golomb values of batch n, the calling thread
+	// reconstructs the lines of batch n-1 (decoded in the previous round).
+	// reconstruction and the scanline callback always run on the calling
+	// thread, in order, so the output is identical to the serial decoder.
+	tjs_int width = ctx.Width;
+	tjs_int height = ctx.Height;
+	tjs_int colors = ctx.Colors;
+	tjs_int y_block_count = (tjs_int)((height - 1)/ TVP_TLG6_H_BLOCK_SIZE) + 1;
+	tjs_int batch_count = (y_block_count - 1) / workers + 1;
+	tjs_int pool_size = max_bit_length / 8 + 5;
+
+	std::vector<tjs_uint8 *> bit_pools(workers * colors, (tjs_uint8*)NULL);
+	std::vector<tjs_uint32 *> pixelbufs(workers * 2, (tjs_uint32*)NULL);
+	std::vector<tTVPTLG6GolombTask> tasks(workers);
+
+	try
+	{
+		for(tjs_int i = 0; i < workers * colors; i++)
+			bit_pools[i] = (tjs_uint8 *)TJSAlignedAlloc(pool_size, 4);
+		for(tjs_int i = 0; i < workers * 2; i++)
+			pixelbufs[i] = (tjs_uint32 *)TJSAlignedAlloc(
+				sizeof(tjs_uint32) * width * TVP_TLG6_H_BLOCK_SIZE + 1, 4);
+
+		tjs_int prev_rows = 0;
+		for(tjs_int batch = 0; batch <= batch_count; batch++)
+		{
+			// read compressed data of this batch; stream access stays on
+			// the calling thread.
+			tjs_int rows = 0;
+			if(batch < batch_count)
+			{
+				tjs_int row = batch * workers;
+				rows = y_block_count - row;
+				if(rows > workers) rows = workers;
+				for(tjs_int i = 0; i < rows; i++)
+				{
+					tjs_int y = (row + i) * TVP_TLG6_H_BLOCK_SIZE;
+					tjs_int ylim = y + TVP_TLG6_H_BLOCK_SIZE;
+					if(ylim >= height) ylim = height;
+
+					tTVPTLG6GolombTask &task = tasks[i];
+					task.Colors = colors;
+					task.PixelCount = (ylim - y) * width;
+					task.PixelBuf = pixelbufs[(batch & 1) * workers + i];
+					for(tjs_int c = 0; c < colors; c++)
+						task.BitPools[c] = bit_pools[i * colors + c];
+					TVPTLG6ReadBlockRow(src, colors, task.BitPools);
+				}
+			}
+
+			// decode golomb values of this batch on the worker threads
+			bool threaded = rows > 0 && TVPTryBeginThreadTask(workers + 1);
+			if(threaded)
+			{
+				for(tjs_int i = 0; i < rows; i++)
+					TVPExecThreadTask(&TVPTLG6GolombTaskEntry, TVP_THREAD_PARAM(&tasks[i]));
+			}
+
+			// reconstruct the previous batch meanwhile
+			bool stopped = false;
+			try
+			{
+				tjs_int row = (batch - 1) * workers;
+				for(tjs_int i = 0; i < prev_rows; i++)
+				{
+					if(!TVPTLG6ComposeBlockRow(ctx, (row + i) * TVP_TLG6_H_BLOCK_SIZE,
+						pixelbufs[((batch - 1) & 1) * workers + i]))
+					{
+						stopped = true;
+						break;
+					}
+				}
+			}
+			catch(...)
+			{
+				if(threaded) TVPEndThreadTask();
+				throw;
+			}
+
+			if(threaded)
+			{
+				TVPEndThreadTask();
+			}
+			else if(!stopped)
+			{
+				// the thread pool is busy; decode on this thread
+				for(tjs_int i = 0; i < rows; i++)
+					TVPTLG6GolombTaskEntry(&tasks[i]);
+			}
+
+			if(stopped) break;
+			prev_rows = rows;
+		}
+	}
+	catch(...)
+	{
+		for(tjs_uint i = 0; i < bit_pools.size(); i++)
+			if(bit_pools[i]) TJSAlignedDealloc(bit_pools[i]);
+		for(tjs_uint i = 0; i < pixelbufs.size(); i++)
+			if(pixelbufs[i]) TJSAlignedDealloc(pixelbufs[i]);
+		throw;
+	}
+	for(tjs_uint i = 0; i < bit_pools.size(); i++)
+		if(bit_pools[i]) TJSAlignedDealloc(bit_pools[i]);
+	for(tjs_uint i = 0; i < pixelbufs.size(); i++)
+		if(pixelbufs[i]) TJSAlignedDealloc(pixelbufs[i]);
+}
+//---------------------------------------------------------------------------
+
+
 //---------------------------------------------------------------------------
 // TLG6 loading handler
 //---------------------------------------------------------------------------
@@ -305,101 +564,79 @@ void TVPLoadTLG6(void* formatdata, void *callbackdata,
 			TJSAlignedDealloc(inbuf);
 		}
 
-		// for each horizontal block group ...
-		tjs_uint32 *prevline = zeroline;
-		for(tjs_int y = 0; y < height; y += TVP_TLG6_H_BLOCK_SIZE)
+		tTVPTLG6DecodeContext ctx;
+		ctx.CallbackData = callbackdata;
+		ctx.ScanLineCallback = scanlinecallback;
+		ctx.Width = width;
+		ctx.Height = height;
+		ctx.Colors = colors;
+		ctx.XBlockCount = x_block_count;
+		ctx.MainCount = main_count;
+		ctx.Fraction = fraction;
+		ctx.FilterTypes = filter_types;
+		ctx.PrevLine = zeroline;
+
+		// use the parallel decoder for large images when the draw threads
+		// are available (see -drawthread and -tlg6dec options)
+		tjs_int threads = TVPGetThreadNum();
+		if(TVPTLG6ParallelDecode && threads > 1 &&
+			y_block_count >= threads && width * height >= 256 * 256)
 		{
-			tjs_int ylim = y + TVP_TLG6_H_BLOCK_SIZE;
-			if(ylim >= height) ylim = height;
-
-			tjs_int pixel_count = (ylim - y) * width;
-
-			// decode values
-			for(tjs_int c = 0; c < colors; c++)
+			TVPTLG6DecodeBlockRowsParallel(ctx, src, max_bit_length, threads - 1);
+		}
+		else
+		{
+			// for each horizontal block group ...
+			for(tjs_int y = 0; y < height; y += TVP_TLG6_H_BLOCK_SIZE)
 			{
-				// read bit length
-				tjs_int bit_length = src->ReadI32LE();
-
-				// get compress method
-				int method = (bit_length >> 30)&3;
-				bit_length &= 0x3fffffff;
-
-				// compute byte length
-				tjs_int byte_length = bit_length / 8;
-				if(bit_length % 8) byte_length++;
+				tjs_int ylim = y + TVP_TLG6_H_BLOCK_SIZE;
+				if(ylim >= height) ylim = height;
 
-				// read source from input
-				src->ReadBuffer(bit_pool, byte_length);
+				tjs_int pixel_count = (ylim - y) * width;
 
 				// decode values
-				// two most significant bits of bitlength are
-				// entropy coding method;
-				// 00 means Golomb method,
-				// 01 means Gamma method (not yet suppoted),
-				// 10 means modified LZSS method (not yet supported),
-				// 11 means raw (uncompressed) data (not yet supported).
-
-				switch(method)
+				for(tjs_int c = 0; c < colors; c++)
 				{
-				case 0:
-					if(c == 0 && colors != 1)
-						TVPTLG6DecodeGolombValuesForFirst((tjs_int8*)pixelbuf,
-							pixel_count, bit_pool);
-					else
-						TVPTLG6DecodeGolombValues((tjs_int8*)pixelbuf + c,
-							pixel_count, bit_pool);
-					break;
-				default:
-					TVPThrowExceptionMessage(TVPTLGLoadError, (const tjs_char*)TVPUnsupportedEntropyCodingMethod );
-				}
-			}
+					// read bit length
+					tjs_int bit_length = src->ReadI32LE();
 
-			// for each line
-			unsigned char * ft =
-				filter_types + (y / TVP_TLG6_H_BLOCK_SIZE)*x_block_count;
-			int skipbytes = (ylim-y)*TVP_TLG6_W_BLOCK_SIZE;
+					// get compress method
+					int method = (bit_length >> 30)&3;
+					bit_length &= 0x3fffffff;
 
-			for(int yy = y; yy < ylim; yy++)
-			{
-				tjs_uint32* curline = (tjs_uint32*)scanlinecallback(callbackdata, yy);
+					// compute byte length
+					tjs_int byte_length = bit_length / 8;
+					if(bit_length % 8) byte_length++;
 
-				int dir = (yy&1)^1;
-				int oddskip = ((ylim - yy -1) - (yy-y));
-				if(main_count)
-				{
-					int start =
-						((width < TVP_TLG6_W_BLOCK_SIZE) ? width : TVP_TLG6_W_BLOCK_SIZE) *
-							(yy - y);
-					TVPTLG6DecodeLine(
-						prevline,
-						curline,
-						width,
-						main_count,
-						ft,
-						skipbytes,
-						pixelbuf + start, colors==3?0xff000000:0, oddskip, dir);
-				}
+					// read source from input
+					src->ReadBuffer(bit_pool, byte_length);
 
-				if(main_count != x_block_count)
-				{
-					int ww = fraction;
-					if(ww > TVP_TLG6_W_BLOCK_SIZE) ww = TVP_TLG6_W_BLOCK_SIZE;
-					int start = ww * (yy - y);
-					TVPTLG6DecodeLineGeneric(
-						prevline,
-						curline,
-						width,
-						main_count,
-						x_block_count,
-						ft,
-						skipbytes,
-						pixelbuf + start, colors==3?0xff000000:0, oddskip, dir);
+					// decode values
+					// two most significant bits of bitlength are
+					// entropy coding method;
+					// 00 means Golomb method,
+					// 01 means Gamma method (not yet suppoted),
+					// 10 means modified LZSS method (not yet supported),
+					// 11 means raw (uncompressed) data (not yet supported).
+
+					switch(method)
+					{
+					case 0:
+						if(c == 0 && colors != 1)
+							TVPTLG6DecodeGolombValuesForFirst((tjs_int8*)pixelbuf,
+								pixel_count, bit_pool);
+						else
+							TVPTLG6DecodeGolombValues((tjs_int8*)pixelbuf + c,
+								pixel_count, bit_pool);
+						break;
+					default:
+						TVPThrowExceptionMessage(TVPTLGLoadError, (const tjs_char*)TVPUnsupportedEntropyCodingMethod );
+					}
 				}
 
-				scanlinecallback(callbackdata, -1);
-				prevline = curline;
+				// for each line
+				if(!TVPTLG6ComposeBlockRow(ctx, y, pixelbuf)) break;
 			}
-
 		}
 	}
 	catch(...)
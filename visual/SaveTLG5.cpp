@@ -194,30 +194,20 @@ void SlideCompressor::Encode(const unsigned char *in, long inlen,
 //---------------------------------------------------------------------------
 void SlideCompressor::Store()
 {
+	// this is called for every color component of every block, so the
+	// dictionary (about 300KB) is copied in bulk.
 	S2 = S;
-	int i;
-	for(i = 0; i < SLIDE_N + SLIDE_M - 1; i++)
-		Text2[i] = Text[i];
-
-	for(i = 0; i < 256*256; i++)
-		Map2[i] = Map[i];
-
-	for(i = 0; i < SLIDE_N; i++)
-		Chains2[i] = Chains[i];
+	memcpy(Text2, Text, sizeof(Text));
+	memcpy(Map2, Map, sizeof(Map));
+	memcpy(Chains2, Chains, sizeof(Chains));
 }
 //---------------------------------------------------------------------------
 void SlideCompressor::Restore()
 {
 	S = S2;
-	int i;
-	for(i = 0; i < SLIDE_N + SLIDE_M - 1; i++)
-		Text[i] = Text2[i];
-
-	for(i = 0; i < 256*256; i++)
-		Map[i] = Map2[i];
-
-	for(i = 0; i < SLIDE_N; i++)
-		Chains[i] = Chains2[i];
+	memcpy(Text, Text2, sizeof(Text));
+	memcpy(Map, Map2, sizeof(Map));
+	memcpy(Chains, Chains2, sizeof(Chains));
 }
 //---------------------------------------------------------------------------
 
@@ -8,6 +8,7 @@
 #include "StorageIntf.h"
 #include "SaveTLG.h"
 #include "UtilStreams.h"
+#include "ThreadIntf.h"
 
 #include <stdlib.h>
 #include <memory.h>
@@ -63,7 +64,7 @@ bool TVPAcceptSaveAsTLG(void* formatdata, const ttstr & type, class iTJSDispatch
 
 // golomb bit length table is compressed, so we need to
 // decompress it.
-char TVPTLG6GolombBitLengthTable[TVP_TLG6_GOLOMB_N_COUNT*2*128][TVP_TLG6_GOLOMB_N_COUNT];
+static char TVPTLG6GolombBitLengthTable[TVP_TLG6_GOLOMB_N_COUNT*2*128][TVP_TLG6_GOLOMB_N_COUNT];
 static bool TVPTLG6GolombTableInit = false;
 static short int TVPTLG6GolombCompressed[TVP_TLG6_GOLOMB_N_COUNT][9] = {
 		{3,7,15,27,63,108,223,448,130,},
@@ -281,7 +282,6 @@ public:
 
 //------------------------------ FOR DEBUG
 //#define FILTER_TEST
-//#define WRITE_ENTROPY_VALUES
 //#define WRITE_VSTXT
 //------------------------------
 
@@ -1031,17 +1031,273 @@ static void TLG6InitializeColorFilterCompressor(SlideCompressor &c)
 	c.Encode(code, 4096, dum, dumlen);
 }
 //---------------------------------------------------------------------------
-// int ftfreq[256] = {0};
+//---------------------------------------------------------------------------
+struct TLG6BlockRowContext
+{
+	// input / output of TLG6CompressBlockRow; one per worker
+	const tTVPBaseBitmap *Bitmap;
+	int Colors;
+	int Stride;
+	int Y; // top line of the block row
+	unsigned char *FilterTypes; // filter types of the blocks in this row
+	tTVPMemoryStream *Stream; // receives bit length and golomb bits per component
+	long MaxBitLength;
+	bool Failed;
+
+	unsigned char *Buf[MAX_COLOR_COMPONENTS];
+	char *BlockBuf[MAX_COLOR_COMPONENTS];
+
+	TLG6BlockRowContext() : Bitmap(NULL), Colors(0), Stride(0), Y(0),
+		FilterTypes(NULL), Stream(NULL), MaxBitLength(0), Failed(false)
+	{
+		for(int i = 0; i < MAX_COLOR_COMPONENTS; i++) Buf[i] = NULL, BlockBuf[i] = NULL;
+	}
+	~TLG6BlockRowContext()
+	{
+		for(int i = 0; i < MAX_COLOR_COMPONENTS; i++)
+		{
+			if(Buf[i]) delete [] Buf[i];
+			if(BlockBuf[i]) delete [] BlockBuf[i];
+		}
+	}
+	void Allocate(int colors, int width)
+	{
+		for(int c = 0; c < colors; c++)
+		{
+			Buf[c] = new unsigned char [W_BLOCK_SIZE * H_BLOCK_SIZE * 3];
+			BlockBuf[c] = new char [H_BLOCK_SIZE * width];
+		}
+	}
+};
+//---------------------------------------------------------------------------
+static void TLG6CompressBlockRow(TLG6BlockRowContext &ctx)
+{
+	// compress one block row (H_BLOCK_SIZE lines) of the image.
+	// a block row depends only on the source bitmap, so the rows can be
+	// compressed independently and concatenated afterwards.
+	const tTVPBaseBitmap *bmp = ctx.Bitmap;
+	int colors = ctx.Colors;
+	int stride = ctx.Stride;
+	int y = ctx.Y;
+	unsigned char **buf = ctx.Buf;
+	char **block_buf = ctx.BlockBuf;
+
+	TLG6BitStream bs(ctx.Stream);
+
+	int fc = 0;
+	int ylim = y + H_BLOCK_SIZE;
+	if(ylim > (int)bmp->GetHeight()) ylim = bmp->GetHeight();
+	int gwp = 0;
+	int xp = 0;
+	for(int x = 0; x < (int)bmp->GetWidth(); x += W_BLOCK_SIZE, xp++)
+	{
+		int xlim = x + W_BLOCK_SIZE;
+		if(xlim > (int)bmp->GetWidth()) xlim = bmp->GetWidth();
+		int bw = xlim - x;
+
+		int p0size; // size of MED method (p=0)
+		int minp = 0; // most efficient method (0:MED, 1:AVG)
+		int ft; // filter type
+		int wp; // write point
+		for(int p = 0; p < 2; p++)
+		{
+			int dbofs = (p+1) * (H_BLOCK_SIZE * W_BLOCK_SIZE);
+
+			// do med(when p=0) or take average of upper and left pixel(p=1)
+			for(int c = 0; c < colors; c++)
+			{
+				int wp = 0;
+				for(int yy = y; yy < ylim; yy++)
+				{
+					const unsigned char * sl = x*stride +
+						c + (const unsigned char *)bmp->GetScanLine(yy);
+					const unsigned char * usl;
+					if(yy >= 1)
+						usl = x*stride + c + (const unsigned char *)bmp->GetScanLine(yy-1);
+					else
+						usl = NULL;
+					for(int xx = x; xx < xlim; xx++)
+					{
+						unsigned char pa = xx > 0 ? sl[-stride] : 0;
+						unsigned char pb = usl ? *usl : 0;
+						unsigned char px = *sl;
+
+						unsigned char py;
+
+//						py = 0;
+						if(p == 0)
+						{
+							unsigned char pc = (xx > 0 && usl) ? usl[-stride] : 0;
+							unsigned char min_a_b = pa>pb?pb:pa;
+							unsigned char max_a_b = pa<pb?pb:pa;
+
+							if(pc >= max_a_b)
+								py = min_a_b;
+							else if(pc < min_a_b)
+								py = max_a_b;
+							else
+								py = pa + pb - pc;
+						}
+						else
+						{
+							py = (pa+pb+1)>>1;
+						}
+
+						buf[c][wp] = (unsigned char)(px - py);
+
+						wp++;
+						sl += stride;
+						if(usl) usl += stride;
+					}
+				}
+			}
+
+			// reordering
+			// Transfer the data into block_buf (block buffer).
+			// Even lines are stored forward (left to right),
+			// Odd lines are stored backward (right to left).
+
+			wp = 0;
+			for(int yy = y; yy < ylim; yy++)
+			{
+				int ofs;
+				if(!(xp&1))
+					ofs = (yy - y)*bw;
+				else
+					ofs = (ylim - yy - 1) * bw;
+				bool dir; // false for forward, true for backward
+				if(!((ylim-y)&1))
+				{
+					// vertical line count per block is even
+					dir = ((yy&1) ^ (xp&1)) ? true : false;
+				}
+				else
+				{
+					// otherwise;
+					if(xp & 1)
+					{
+						dir = (yy&1);
+					}
+					else
+					{
+						dir = ((yy&1) ^ (xp&1)) ? true : false;
+					}
+				}
+
+				if(!dir)
+				{
+					// forward
+					for(int xx = 0; xx < bw; xx++)
+					{
+						for(int c = 0; c < colors; c++)
+							buf[c][wp + dbofs] =
+							buf[c][ofs + xx];
+						wp++;
+					}
+				}
+				else
+				{
+					// backward
+					for(int xx = bw - 1; xx >= 0; xx--)
+					{
+						for(int c = 0; c < colors; c++)
+							buf[c][wp + dbofs] =
+							buf[c][ofs + xx];
+						wp++;
+					}
+				}
+			}
+		}
+
+
+		for(int p = 0; p < 2; p++)
+		{
+			int dbofs = (p+1) * (H_BLOCK_SIZE * W_BLOCK_SIZE);
+			// detect color filter
+			int size = 0;
+			int ft_;
+			if(colors >= 3)
+				ft_ = DetectColorFilter(
+					reinterpret_cast<char*>(buf[0] + dbofs),
+					reinterpret_cast<char*>(buf[1] + dbofs),
+					reinterpret_cast<char*>(buf[2] + dbofs), wp, size);
+			else
+				ft_ = 0;
+
+			// select efficient mode of p (MED or average)
+			if(p == 0)
+			{
+				p0size = size;
+				ft = ft_;
+			}
+			else
+			{
+				if(p0size >= size)
+					minp = 1, ft = ft_;
+			}
+		}
+
+		// Apply most efficient color filter / prediction method
+		wp = 0;
+		int dbofs = (minp + 1)  * (H_BLOCK_SIZE * W_BLOCK_SIZE);
+		for(int yy = y; yy < ylim; yy++)
+		{
+			for(int xx = 0; xx < bw; xx++)
+			{
+				for(int c = 0; c < colors; c++)
+					block_buf[c][gwp + wp] = buf[c][wp + dbofs];
+				wp++;
+			}
+		}
+
+		ApplyColorFilter(block_buf[0] + gwp,
+			block_buf[1] + gwp, block_buf[2] + gwp, wp, ft);
+
+		ctx.FilterTypes[fc++] = (ft<<1) + minp;
+		gwp += wp;
+	}
+
+	// compress values (entropy coding)
+	for(int c = 0; c < colors; c++)
+	{
+		int method;
+		CompressValuesGolomb(bs, block_buf[c], gwp);
+		method = 0;
+		long bitlength = bs.GetBitLength();
+		if(bitlength & 0xc0000000)
+			TVPThrowExceptionMessage( TVPTlgTooLargeBitLength );
+		// two most significant bits of bitlength are
+		// entropy coding method;
+		// 00 means Golomb method,
+		// 01 means Gamma method (implemented but not used),
+		// 10 means modified LZSS method (not yet implemented),
+		// 11 means raw (uncompressed) data (not yet implemented).
+		if(ctx.MaxBitLength < bitlength) ctx.MaxBitLength = bitlength;
+		bitlength |= (method << 30);
+		WriteInt32(bitlength, ctx.Stream);
+		bs.Flush();
+	}
+}
+//---------------------------------------------------------------------------
+static void TJS_USERENTRY TLG6CompressBlockRowEntry(void *v)
+{
+	// runs on a worker thread; errors are reported back through Failed and
+	// the row is compressed again on the calling thread to raise them there.
+	TLG6BlockRowContext *ctx = (TLG6BlockRowContext *)v;
+	try
+	{
+		TLG6CompressBlockRow(*ctx);
+	}
+	catch(...)
+	{
+		ctx->Failed = true;
+	}
+}
+//---------------------------------------------------------------------------
 void SaveTLG6( tTJSBinaryStream* stream, const tTVPBaseBitmap* bmp, bool is24 )
 {
 	tTJSBinaryStream *out = stream;
 
-	// DWORD medstart, medend;
-	tjs_uint reordertick;
-#ifdef WRITE_ENTROPY_VALUES
-	FILE *vs = fopen("vs.bin", "wb");
-#endif
-
 	int colors;
 
 	TVPTLG6InitGolombTable();
@@ -1073,235 +1329,88 @@ void SaveTLG6( tTJSBinaryStream* stream, const tTVPBaseBitmap* bmp, bool is24 )
 	// compress
 	long max_bit_length = 0;
 
-	unsigned char *buf[MAX_COLOR_COMPONENTS];
-	for(int i = 0; i < MAX_COLOR_COMPONENTS; i++) buf[i] = NULL;
-	char *block_buf[MAX_COLOR_COMPONENTS];
-	for(int i = 0; i < MAX_COLOR_COMPONENTS; i++) block_buf[i] = NULL;
+	int width = bmp->GetWidth();
+	int height = bmp->GetHeight();
+	int w_block_count = (int)((width - 1) / W_BLOCK_SIZE) + 1;
+	int h_block_count = (int)((height - 1) / H_BLOCK_SIZE) + 1;
+	int fc = w_block_count * h_block_count;
+
+	// block rows are compressed in batches of "tasks" rows; each worker
+	// writes into its own memory stream, which are concatenated in order.
+	// the output is byte-identical to the single threaded encoder.
+	int tasks = TVPGetThreadNum();
+	if(tasks > h_block_count) tasks = h_block_count;
+	if(width * height < 256 * 256) tasks = 1;
+
 	unsigned char *filtertypes = NULL;
 	tTVPMemoryStream *memstream = NULL;
+	TLG6BlockRowContext *contexts = NULL;
+	tTVPMemoryStream *rowstreams = NULL;
 
 	try
 	{
 		memstream = new tTVPMemoryStream();
+		filtertypes = new unsigned char [fc];
+		contexts = new TLG6BlockRowContext[tasks];
+		if(tasks > 1) rowstreams = new tTVPMemoryStream[tasks];
 
-		TLG6BitStream bs(memstream);
-
-//		int buf_size = bmp->Width * bmp->Height;
-
-		// allocate buffer
-		for(int c = 0; c < colors; c++)
+		for(int i = 0; i < tasks; i++)
 		{
-			buf[c] = new unsigned char [W_BLOCK_SIZE * H_BLOCK_SIZE * 3];
-			block_buf[c] = new char [H_BLOCK_SIZE * bmp->GetWidth()];
+			TLG6BlockRowContext &ctx = contexts[i];
+			ctx.Bitmap = bmp;
+			ctx.Colors = colors;
+			ctx.Stride = stride;
+			ctx.Stream = tasks > 1 ? rowstreams + i : memstream;
+			ctx.Allocate(colors, width);
 		}
-		int w_block_count = (int)((bmp->GetWidth() - 1) / W_BLOCK_SIZE) + 1;
-		int h_block_count = (int)((bmp->GetHeight() - 1) / H_BLOCK_SIZE) + 1;
-		filtertypes = new unsigned char [w_block_count * h_block_count];
 
-		int fc = 0;
-		for(int y = 0; y < (int)bmp->GetHeight(); y += H_BLOCK_SIZE)
+		for(int row = 0; row < h_block_count; row += tasks)
 		{
-			int ylim = y + H_BLOCK_SIZE;
-			if(ylim > (int)bmp->GetHeight()) ylim = bmp->GetHeight();
-			int gwp = 0;
-			int xp = 0;
-			for(int x = 0; x < (int)bmp->GetWidth(); x += W_BLOCK_SIZE, xp++)
-			{
-				int xlim = x + W_BLOCK_SIZE;
-				if(xlim > (int)bmp->GetWidth()) xlim = bmp->GetWidth();
-				int bw = xlim - x;
-
-				int p0size; // size of MED method (p=0)
-				int minp = 0; // most efficient method (0:MED, 1:AVG)
-				int ft; // filter type
-				int wp; // write point
-				for(int p = 0; p < 2; p++)
-				{
-					int dbofs = (p+1) * (H_BLOCK_SIZE * W_BLOCK_SIZE);
+			int rows = h_block_count - row;
+			if(rows > tasks) rows = tasks;
 
-					// do med(when p=0) or take average of upper and left pixel(p=1)
-					for(int c = 0; c < colors; c++)
-					{
-						int wp = 0;
-						for(int yy = y; yy < ylim; yy++)
-						{
-							const unsigned char * sl = x*stride +
-								c + (const unsigned char *)bmp->GetScanLine(yy);
-							const unsigned char * usl;
-							if(yy >= 1)
-								usl = x*stride + c + (const unsigned char *)bmp->GetScanLine(yy-1);
-							else
-								usl = NULL;
-							for(int xx = x; xx < xlim; xx++)
-							{
-								unsigned char pa = xx > 0 ? sl[-stride] : 0;
-								unsigned char pb = usl ? *usl : 0;
-								unsigned char px = *sl;
-
-								unsigned char py;
-
-//								py = 0;
-								if(p == 0)
-								{
-									unsigned char pc = (xx > 0 && usl) ? usl[-stride] : 0;
-									unsigned char min_a_b = pa>pb?pb:pa;
-									unsigned char max_a_b = pa<pb?pb:pa;
-
-									if(pc >= max_a_b)
-										py = min_a_b;
-									else if(pc < min_a_b)
-										py = max_a_b;
-									else
-										py = pa + pb - pc;
-								}
-								else
-								{
-									py = (pa+pb+1)>>1;
-								}
-								
-								buf[c][wp] = (unsigned char)(px - py);
-
-								wp++;
-								sl += stride;
-								if(usl) usl += stride;
-							}
-						}
-					}
-
-					// reordering
-					// Transfer the data into block_buf (block buffer).
-					// Even lines are stored forward (left to right),
-					// Odd lines are stored backward (right to left).
-
-					wp = 0;
-					DWORD reorderstart = GetTickCount();
-					for(int yy = y; yy < ylim; yy++)
-					{
-						int ofs;
-						if(!(xp&1))
-							ofs = (yy - y)*bw;
-						else
-							ofs = (ylim - yy - 1) * bw;
-						bool dir; // false for forward, true for backward
-						if(!((ylim-y)&1))
-						{
-							// vertical line count per block is even
-							dir = ((yy&1) ^ (xp&1)) ? true : false;
-						}
-						else
-						{
-							// otherwise;
-							if(xp & 1)
-							{
-								dir = (yy&1);
-							}
-							else
-							{
-								dir = ((yy&1) ^ (xp&1)) ? true : false;
-							}
-						}
-
-						if(!dir)
-						{
-							// forward
-							for(int xx = 0; xx < bw; xx++)
-							{
-								for(int c = 0; c < colors; c++)
-									buf[c][wp + dbofs] =
-									buf[c][ofs + xx];
-								wp++;
-							}
-						}
-						else
-						{
-							// backward
-							for(int xx = bw - 1; xx >= 0; xx--)
-							{
-								for(int c = 0; c < colors; c++)
-									buf[c][wp + dbofs] =
-									buf[c][ofs + xx];
-								wp++;
-							}
-						}
-					}
-					reordertick += GetTickCount() - reorderstart;
-				}
-
-
-				for(int p = 0; p < 2; p++)
-				{
-					int dbofs = (p+1) * (H_BLOCK_SIZE * W_BLOCK_SIZE);
-					// detect color filter
-					int size = 0;
-					int ft_;
-					if(colors >= 3)
-						ft_ = DetectColorFilter(
-							reinterpret_cast<char*>(buf[0] + dbofs),
-							reinterpret_cast<char*>(buf[1] + dbofs),
-							reinterpret_cast<char*>(buf[2] + dbofs), wp, size);
-					else
-						ft_ = 0;
+			for(int i = 0; i < rows; i++)
+			{
+				TLG6BlockRowContext &ctx = contexts[i];
+				ctx.Y = (row + i) * H_BLOCK_SIZE;
+				ctx.FilterTypes = filtertypes + (row + i) * w_block_count;
+				ctx.Failed = false;
+			}
 
-					// select efficient mode of p (MED or average)
-					if(p == 0)
-					{
-						p0size = size;
-						ft = ft_;
-					}
-					else
-					{
-						if(p0size >= size)
-							minp = 1, ft = ft_;
-					}
-				}
+			if(rows > 1 && TVPTryBeginThreadTask(rows))
+			{
+				for(int i = 0; i < rows; i++)
+					TVPExecThreadTask(&TLG6CompressBlockRowEntry,
+						TVP_THREAD_PARAM(contexts + i));
+				TVPEndThreadTask();
+			}
+			else
+			{
+				for(int i = 0; i < rows; i++)
+					TLG6CompressBlockRow(contexts[i]);
+			}
 
-				// Apply most efficient color filter / prediction method
-				wp = 0;
-				int dbofs = (minp + 1)  * (H_BLOCK_SIZE * W_BLOCK_SIZE);
-				for(int yy = y; yy < ylim; yy++)
+			if(tasks > 1)
+			{
+				for(int i = 0; i < rows; i++)
 				{
-					for(int xx = 0; xx < bw; xx++)
+					TLG6BlockRowContext &ctx = contexts[i];
+					if(ctx.Failed)
 					{
-						for(int c = 0; c < colors; c++)
-							block_buf[c][gwp + wp] = buf[c][wp + dbofs];
-						wp++;
+						// raise the error on this thread
+						ctx.Stream->Clear();
+						TLG6CompressBlockRow(ctx);
 					}
+					memstream->WriteBuffer(ctx.Stream->GetInternalBuffer(),
+						(tjs_uint)ctx.Stream->GetSize());
+					ctx.Stream->Clear();
 				}
-
-				ApplyColorFilter(block_buf[0] + gwp,
-					block_buf[1] + gwp, block_buf[2] + gwp, wp, ft);
-
-				filtertypes[fc++] = (ft<<1) + minp;
-//				ftfreq[ft]++;
-				gwp += wp;
 			}
-
-			// compress values (entropy coding)
-			for(int c = 0; c < colors; c++)
-			{
-				int method;
-				CompressValuesGolomb(bs, block_buf[c], gwp);
-				method = 0;
-#ifdef WRITE_ENTROPY_VALUES
-				fwrite(block_buf[c], 1, gwp, vs);
-#endif
-				long bitlength = bs.GetBitLength();
-				if(bitlength & 0xc0000000)
-					TVPThrowExceptionMessage( TVPTlgTooLargeBitLength );
-				// two most significant bits of bitlength are
-				// entropy coding method;
-				// 00 means Golomb method,
-				// 01 means Gamma method (implemented but not used),
-				// 10 means modified LZSS method (not yet implemented),
-				// 11 means raw (uncompressed) data (not yet implemented).
-				if(max_bit_length < bitlength) max_bit_length = bitlength;
-				bitlength |= (method << 30);
-				WriteInt32(bitlength, memstream);
-				bs.Flush();
-			}
-
 		}
 
+		for(int i = 0; i < tasks; i++)
+			if(max_bit_length < contexts[i].MaxBitLength)
+				max_bit_length = contexts[i].MaxBitLength;
 
 		// write max bit length
 		WriteInt32(max_bit_length, out);
@@ -1332,27 +1441,17 @@ void SaveTLG6( tTJSBinaryStream* stream, const tTVPBaseBitmap* bmp, bool is24 )
 	}
 	catch(...)
 	{
-		for(int i = 0; i < MAX_COLOR_COMPONENTS; i++)
-		{
-			if(buf[i]) delete [] (buf[i]);
-			if(block_buf[i]) delete [] (block_buf[i]);
-		}
+		if(contexts) delete [] contexts;
+		if(rowstreams) delete [] rowstreams;
 		if(filtertypes) delete [] filtertypes;
 		if(memstream) delete memstream;
 		throw;
 	}
 
-	for(int i = 0; i < MAX_COLOR_COMPONENTS; i++)
-	{
-		if(buf[i]) delete [] (buf[i]);
-		if(block_buf) delete [] (block_buf[i]);
-	}
+	if(contexts) delete [] contexts;
+	if(rowstreams) delete [] rowstreams;
 	if(filtertypes) delete [] filtertypes;
 	if(memstream) delete memstream;
-
-#ifdef WRITE_ENTROPY_VALUES
-	fclose(vs);
-#endif
 }
 //---------------------------------------------------------------------------
 extern void SaveTLG5( tTJSBinaryStream* stream, const tTVPBaseBitmap* image, bool is24 );
@@ -1198,6 +1198,10 @@ extern void TVPApplyColorMap_ao_sse2_c(tjs_uint32 *dest, const tjs_uint8 *src, t
 
 extern void TVPConvert24BitTo32Bit_sse2_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len);
 extern void TVPConvert24BitTo32Bit_ssse3_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len);
+extern void TVPConvertRGB24BitTo32Bit_sse2_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len);
+extern void TVPConvertRGB24BitTo32Bit_ssse3_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len);
+extern void TVPConvertRGBA32BitTo32Bit_sse2_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len);
+extern void TVPConvertRGBA32BitTo32Bit_ssse3_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len);
 
 //extern tjs_int TVPTLG5DecompressSlide_test( tjs_uint8 *out, const tjs_uint8 *in, tjs_int insize, tjs_uint8 *text, tjs_int initialr );
 //extern void TVPTLG5ComposeColors3To4_test(tjs_uint8 *outp, const tjs_uint8 *upper, tjs_uint8 * const * buf, tjs_int width);
@@ -1552,9 +1556,13 @@ void TVPGL_SSE2_Init() {
 		if( TVPCPUType & TVP_CPU_HAS_SSSE3 ) {
 			TVPConvert24BitTo32Bit = TVPConvert24BitTo32Bit_ssse3_c;
 			TVPBLConvert24BitTo32Bit = TVPConvert24BitTo32Bit_ssse3_c;
+			TVPConvertRGB24BitTo32Bit = TVPConvertRGB24BitTo32Bit_ssse3_c;
+			TVPConvertRGBA32BitTo32Bit = TVPConvertRGBA32BitTo32Bit_ssse3_c;
 		} else {
 			TVPConvert24BitTo32Bit = TVPConvert24BitTo32Bit_sse2_c;
 			TVPBLConvert24BitTo32Bit = TVPConvert24BitTo32Bit_sse2_c;
+			TVPConvertRGB24BitTo32Bit = TVPConvertRGB24BitTo32Bit_sse2_c;
+			TVPConvertRGBA32BitTo32Bit = TVPConvertRGBA32BitTo32Bit_sse2_c;
 		}
 		//色変換は使用頻度少ない 以下はMMX版もないのでSSE2版もなくていいかも
 		//TVPBLExpand1BitTo8BitPal	// BMP読み込み、1bit文字の変換で使われる
@@ -105,23 +105,7 @@ void TVPConvert24BitTo32Bit_sse2_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_i
 // SSSE3
 void TVPConvert24BitTo32Bit_ssse3_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len) {
 	const __m128i alphamask( _mm_set1_epi32( 0xff000000 ) );
-	__m128i mask;
-	mask.m128i_u8[0] = 0x00;
-	mask.m128i_u8[1] = 0x01;
-	mask.m128i_u8[2] = 0x02;
-	mask.m128i_u8[3] = 0x80;
-	mask.m128i_u8[4] = 0x03;
-	mask.m128i_u8[5] = 0x04;
-	mask.m128i_u8[6] = 0x05;
-	mask.m128i_u8[7] = 0x80;
-	mask.m128i_u8[8] = 0x06;
-	mask.m128i_u8[9] = 0x07;
-	mask.m128i_u8[10] = 0x08;
-	mask.m128i_u8[11] = 0x80;
-	mask.m128i_u8[12] = 0x09;
-	mask.m128i_u8[13] = 0x0A;
-	mask.m128i_u8[14] = 0x0B;
-	mask.m128i_u8[15] = 0x80;
+	const __m128i mask( _mm_set_epi8( -128, 11, 10, 9, -128, 8, 7, 6, -128, 5, 4, 3, -128, 2, 1, 0 ) );
 
 	// 16単位
 	tjs_uint32 rem = (len>>4)<<4;
@@ -164,3 +148,91 @@ void TVPConvert24BitTo32Bit_ssse3_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_
 	}
 }
 
+// R, G, B, A byte order ( PNG ) to ARGB; swap R and B
+void TVPConvertRGBA32BitTo32Bit_sse2_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len) {
+	const __m128i agmask( _mm_set1_epi32( 0xff00ff00 ) );
+	const __m128i rbmask( _mm_set1_epi32( 0x00ff00ff ) );
+
+	tjs_uint32 rem = (len>>2)<<2;
+	tjs_uint32* limit = dest + rem;
+	while( dest < limit ) {
+		__m128i md = _mm_loadu_si128((__m128i const*)buf);	// A B G R
+		__m128i ag = _mm_and_si128( md, agmask );	// A 0 G 0
+		md = _mm_and_si128( md, rbmask );			// 0 B 0 R
+		md = _mm_or_si128( _mm_slli_epi32( md, 16 ), _mm_srli_epi32( md, 16 ) );	// 0 R 0 B
+		md = _mm_or_si128( md, ag );
+		_mm_storeu_si128((__m128i *)dest, md );
+		buf += 16; dest += 4;
+	}
+	limit += (len-rem);
+	while( dest < limit ) {
+		*dest = (buf[3]<<24) | (buf[0]<<16) | (buf[1]<<8) | buf[2];
+		buf+=4; dest++;
+	}
+}
+
+void TVPConvertRGB24BitTo32Bit_sse2_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len) {
+	// expand and swap R and B in the next pass; the line is still in the cache
+	TVPConvert24BitTo32Bit_sse2_c( dest, buf, len );
+	TVPConvertRGBA32BitTo32Bit_sse2_c( dest, (const tjs_uint8*)dest, len );
+}
+
+// SSSE3
+void TVPConvertRGBA32BitTo32Bit_ssse3_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len) {
+	const __m128i mask( _mm_set_epi8( 15, 12, 13, 14, 11, 8, 9, 10, 7, 4, 5, 6, 3, 0, 1, 2 ) );
+
+	tjs_uint32 rem = (len>>2)<<2;
+	tjs_uint32* limit = dest + rem;
+	while( dest < limit ) {
+		__m128i md = _mm_loadu_si128((__m128i const*)buf);
+		md = _mm_shuffle_epi8( md, mask );
+		_mm_storeu_si128((__m128i *)dest, md );
+		buf += 16; dest += 4;
+	}
+	limit += (len-rem);
+	while( dest < limit ) {
+		*dest = (buf[3]<<24) | (buf[0]<<16) | (buf[1]<<8) | buf[2];
+		buf+=4; dest++;
+	}
+}
+
+void TVPConvertRGB24BitTo32Bit_ssse3_c(tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len) {
+	const __m128i alphamask( _mm_set1_epi32( 0xff000000 ) );
+	// same as TVPConvert24BitTo32Bit_ssse3_c but R and B are swapped
+	const __m128i mask( _mm_set_epi8( -128, 9, 10, 11, -128, 6, 7, 8, -128, 3, 4, 5, -128, 0, 1, 2 ) );
+
+	// 16単位
+	tjs_uint32 rem = (len>>4)<<4;
+	tjs_uint32* limit = dest + rem;
+	while( dest < limit ) {
+		__m128i m0 = _mm_loadu_si128((__m128i const*)(buf+0));
+		__m128i m1 = _mm_loadu_si128((__m128i const*)(buf+16));
+		__m128i m2 = _mm_loadu_si128((__m128i const*)(buf+32));
+		__m128i md0 = _mm_shuffle_epi8( m0, mask );
+		md0 = _mm_or_si128( md0, alphamask );
+		_mm_storeu_si128((__m128i *)&dest[0], md0 );	// 0 - 3
+		m0 = _mm_srli_si128( m0, 12 );	// >> 12*8
+		__m128i md1 = _mm_slli_si128( m1, 4 );	// << 4*8
+		md1 = _mm_or_si128( md1, m0 );
+		md1 = _mm_shuffle_epi8( md1, mask );
+		md1 = _mm_or_si128( md1, alphamask );
+		_mm_storeu_si128((__m128i *)&dest[4], md1 );	// 4 - 7
+		m1 = _mm_srli_si128( m1, 8 );	// >> 8*8
+		__m128i md2 = _mm_slli_si128( m2, 8 );	// << 8*8
+		md2 = _mm_or_si128( md2, m1 );
+		md2 = _mm_shuffle_epi8( md2, mask );
+		md2 = _mm_or_si128( md2, alphamask );
+		_mm_storeu_si128((__m128i *)&dest[8], md2 );	// 8 - B
+		m2 = _mm_srli_si128( m2, 4 );	// >> 4*8
+		m2 = _mm_shuffle_epi8( m2, mask );
+		m2 = _mm_or_si128( m2, alphamask );
+		_mm_storeu_si128((__m128i *)&dest[12], m2 );	// C - F
+		buf += 48; dest += 16;
+	}
+	limit += (len-rem);
+	while( dest < limit ) {
+		*dest = 0xff000000 | (buf[0]<<16) | (buf[1]<<8) | buf[2];
+		buf+=3; dest++;
+	}
+}
+
@@ -358,6 +358,12 @@ typedef struct
 #define TVP_GL_FUNC_PTR_DECL(rettype, funcname, arg) rettype (__cdecl * funcname) arg
 #define TVP_GL_FUNC_PTR_EXTERN_DECL_(rettype, funcname, arg) extern rettype (__cdecl * funcname) arg
 #define TVP_GL_FUNC_PTR_EXTERN_DECL TVP_GL_FUNC_PTR_EXTERN_DECL_
+#else
+#define TVP_GL_FUNC_DECL(rettype, funcname, arg)  rettype funcname arg
+#define TVP_GL_FUNC_EXTERN_DECL(rettype, funcname, arg)  extern rettype funcname arg
+#define TVP_GL_FUNC_PTR_DECL(rettype, funcname, arg) rettype (* funcname) arg
+#define TVP_GL_FUNC_PTR_EXTERN_DECL_(rettype, funcname, arg) extern rettype (* funcname) arg
+#define TVP_GL_FUNC_PTR_EXTERN_DECL TVP_GL_FUNC_PTR_EXTERN_DECL_
 #endif
 
 extern unsigned char TVPDivTable[256*256];
@@ -6614,6 +6620,34 @@ EOF
 
 ;#-----------------------------------------------------------------
 
+print FC <<EOF;
+/*export*/
+TVP_GL_FUNC_DECL(void, TVPConvertRGB24BitTo32Bit_c, (tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len))
+{
+	/* R, G, B byte order ( as PNG ) to opaque 32bit ARGB.
+	   buf can be placed at (tjs_uint8*)dest + len, to convert in place */
+	tjs_uint32 *slimglim = dest + len;
+	while(dest < slimglim)
+	{
+		*(dest++) = 0xff000000 + (buf[0]<<16) + (buf[1]<<8) + buf[2];
+		buf += 3;
+	}
+}
+/*export*/
+TVP_GL_FUNC_DECL(void, TVPConvertRGBA32BitTo32Bit_c, (tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len))
+{
+	/* R, G, B, A byte order ( as PNG ) to 32bit ARGB. buf can be the same as dest */
+	tjs_uint32 *slimglim = dest + len;
+	while(dest < slimglim)
+	{
+		*(dest++) = (buf[3]<<24) + (buf[0]<<16) + (buf[1]<<8) + buf[2];
+		buf += 4;
+	}
+}
+EOF
+
+;#-----------------------------------------------------------------
+
 print FC <<EOF;
 /*export*/
 TVP_GL_FUNC_DECL(void, TVPBLConvert32BitTo8Bit_c, (tjs_uint8 *dest, const tjs_uint32 *buf, tjs_int len))
@@ -5294,6 +5294,29 @@ TVP_GL_FUNC_DECL(void, TVPConvert24BitTo32Bit_c, (tjs_uint32 *dest, const tjs_ui
 	}
 }
 /*export*/
+TVP_GL_FUNC_DECL(void, TVPConvertRGB24BitTo32Bit_c, (tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len))
+{
+	/* R, G, B byte order ( as PNG ) to opaque 32bit ARGB.
+	   buf can be placed at (tjs_uint8*)dest + len, to convert in place */
+	tjs_uint32 *slimglim = dest + len;
+	while(dest < slimglim)
+	{
+		*(dest++) = 0xff000000 + (buf[0]<<16) + (buf[1]<<8) + buf[2];
+		buf += 3;
+	}
+}
+/*export*/
+TVP_GL_FUNC_DECL(void, TVPConvertRGBA32BitTo32Bit_c, (tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len))
+{
+	/* R, G, B, A byte order ( as PNG ) to 32bit ARGB. buf can be the same as dest */
+	tjs_uint32 *slimglim = dest + len;
+	while(dest < slimglim)
+	{
+		*(dest++) = (buf[3]<<24) + (buf[0]<<16) + (buf[1]<<8) + buf[2];
+		buf += 4;
+	}
+}
+/*export*/
 TVP_GL_FUNC_DECL(void, TVPBLConvert32BitTo8Bit_c, (tjs_uint8 *dest, const tjs_uint32 *buf, tjs_int len))
 {
 	{
@@ -6459,6 +6482,8 @@ TVP_GL_FUNC_PTR_DECL(void, TVPBLConvert15BitTo32Bit,  (tjs_uint32 *dest, const t
 TVP_GL_FUNC_PTR_DECL(void, TVPBLConvert24BitTo8Bit,  (tjs_uint8 *dest, const tjs_uint8 *buf, tjs_int len));
 TVP_GL_FUNC_PTR_DECL(void, TVPBLConvert24BitTo32Bit,  (tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len));
 TVP_GL_FUNC_PTR_DECL(void, TVPConvert24BitTo32Bit,  (tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len));
+TVP_GL_FUNC_PTR_DECL(void, TVPConvertRGB24BitTo32Bit,  (tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len));
+TVP_GL_FUNC_PTR_DECL(void, TVPConvertRGBA32BitTo32Bit,  (tjs_uint32 *dest, const tjs_uint8 *buf, tjs_int len));
 TVP_GL_FUNC_PTR_DECL(void, TVPBLConvert32BitTo8Bit,  (tjs_uint8 *dest, const tjs_uint32 *buf, tjs_int len));
 TVP_GL_FUNC_PTR_DECL(void, TVPBLConvert32BitTo32Bit_NoneAlpha,  (tjs_uint32 *dest, const tjs_uint32 *buf, tjs_int len));
 TVP_GL_FUNC_PTR_DECL(void, TVPBLConvert32BitTo32Bit_MulAddAlpha,  (tjs_uint32 *dest, const tjs_uint32 *buf, tjs_int len));
@@ -6631,6 +6656,8 @@ TVP_GL_FUNC_DECL(void, TVPInitTVPGL, ())
 	TVPBLConvert24BitTo8Bit = TVPBLConvert24BitTo8Bit_c;
 	TVPBLConvert24BitTo32Bit = TVPBLConvert24BitTo32Bit_c;
 	TVPConvert24BitTo32Bit = TVPConvert24BitTo32Bit_c;
+	TVPConvertRGB24BitTo32Bit = TVPConvertRGB24BitTo32Bit_c;
+	TVPConvertRGBA32BitTo32Bit = TVPConvertRGBA32BitTo32Bit_c;
 	TVPBLConvert32BitTo8Bit = TVPBLConvert32BitTo8Bit_c;
 	TVPBLConvert32BitTo32Bit_NoneAlpha = TVPBLConvert32BitTo32Bit_NoneAlpha_c;
 	TVPBLConvert32BitTo32Bit_MulAddAlpha = TVPBLConvert32BitTo32Bit_MulAddAlpha_c;